@@ -0,0 +1,479 @@
+#include "../Source/Processing/Analysis/AlarmEngine.h"
+#include "../Source/Processing/Analysis/AnalyzerPipeline.h"
+#include "../Source/Processing/Analysis/ChannelAnalyzer.h"
+#include "../Source/Processing/Analysis/LoudnessAnalyzer.h"
+#include "../Source/Processing/Analysis/PolyphaseDecimator.h"
+#include "../Source/Processing/Analysis/TruePeakMeter.h"
+#include "../Source/Processing/Analysis/WaveformPyramid.h"
+#include "../Source/Processing/Metering/LevelHistory.h"
+#include "../Source/Processing/Metering/PPMMeterCalculator.h"
+#include "../Source/Processing/Metering/VUMeterCalculator.h"
+#include "BenchmarkRunner.h"
+
+namespace mcam::bench {
+
+namespace {
+constexpr double SAMPLE_RATE = 48000.0;
+
+std::vector<float> makeNoise(int numSamples) {
+  std::vector<float> samples((size_t)numSamples);
+  juce::Random random(2);
+
+  for (auto &sample : samples)
+    sample = 0.1f * (random.nextFloat() * 2.0f - 1.0f);
+
+  return samples;
+}
+
+/** The per-block level kernels BufferProcessor runs for every slot */
+void benchmarkMetering(Runner &runner) {
+  for (int blockSize : {32, 256, 1024, 4096}) {
+    const auto input = makeNoise(blockSize);
+    const juce::NamedValueSet params{{"block", blockSize}};
+
+    runner.measure("metering/peak", params, blockSize / SAMPLE_RATE, [&] {
+      const auto range =
+          juce::FloatVectorOperations::findMinAndMax(input.data(), blockSize);
+      doNotOptimise(range);
+    });
+
+    juce::AudioBuffer<float> buffer(1, blockSize);
+    buffer.copyFrom(0, 0, input.data(), blockSize);
+
+    runner.measure("metering/rms", params, blockSize / SAMPLE_RATE, [&] {
+      const float rms = buffer.getRMSLevel(0, 0, blockSize);
+      doNotOptimise(rms);
+    });
+
+    // The same levels, and every block statistic, as one fused pass
+    const auto &registry = AnalyzerPipelineRegistry::getInstance();
+
+    for (const auto &[name, stages] :
+         {std::make_pair("levels", AnalyzerStage::peak | AnalyzerStage::rms),
+          std::make_pair("all", AnalyzerStage::all)}) {
+      const juce::NamedValueSet pipelineParams{{"block", blockSize},
+                                               {"stages", name}};
+      const auto analyze = registry.find(stages);
+
+      runner.measure("metering/pipeline", pipelineParams,
+                     blockSize / SAMPLE_RATE, [&] {
+                       BlockStatistics statistics;
+                       analyze(buffer.getReadPointer(0), blockSize,
+                               statistics);
+                       doNotOptimise(statistics.rms);
+                     });
+    }
+  }
+}
+
+/** VU and PPM ballistics over many channels, as for a full slot bank */
+void benchmarkBallistics(Runner &runner) {
+  for (int numChannels : {4, 256}) {
+    for (int blockSize : {32, 256, 1024}) {
+      const juce::NamedValueSet params{{"channels", numChannels},
+                                       {"block", blockSize}};
+      const auto input = makeNoise(blockSize);
+      std::vector<const float *> channels((size_t)numChannels, input.data());
+
+      if (runner.shouldRun("metering/vu", params)) {
+        VUMeterCalculator meter;
+        meter.prepare(SAMPLE_RATE, numChannels);
+
+        runner.measure("metering/vu", params, blockSize / SAMPLE_RATE, [&] {
+          meter.process(channels.data(), numChannels, blockSize);
+        });
+
+        doNotOptimise(meter.getLevel(0));
+      }
+
+      if (runner.shouldRun("metering/ppm", params)) {
+        PPMMeterCalculator meter;
+        meter.prepare(SAMPLE_RATE, numChannels);
+
+        runner.measure("metering/ppm", params, blockSize / SAMPLE_RATE, [&] {
+          meter.process(channels.data(), numChannels, blockSize);
+        });
+
+        doNotOptimise(meter.getLevel(0));
+      }
+    }
+  }
+}
+
+/**
+ * Level history of every input channel: the per-block RMS folded into
+ * each channel's rings, as BufferProcessor does after computing it
+ */
+void benchmarkLevelHistory(Runner &runner) {
+  constexpr int numChannels = 128;
+
+  for (int blockSize : {32, 256, 1024}) {
+    const juce::NamedValueSet params{{"channels", numChannels},
+                                     {"block", blockSize}};
+
+    if (!runner.shouldRun("metering/history", params))
+      continue;
+
+    std::vector<std::unique_ptr<LevelHistory>> histories;
+    for (int channel = 0; channel < numChannels; ++channel) {
+      histories.push_back(std::make_unique<LevelHistory>());
+      histories.back()->prepare(SAMPLE_RATE);
+    }
+
+    float level = 0.0f;
+
+    runner.measure("metering/history", params, blockSize / SAMPLE_RATE, [&] {
+      level = level >= 1.0f ? 0.0f : level + 0.001f;
+
+      for (auto &history : histories)
+        history->push(level, blockSize);
+    });
+
+    doNotOptimise(histories[0]->getNumEntries(0));
+  }
+}
+
+/**
+ * Alarms of every input channel, with the default settings and with every
+ * alarm disabled; the two should cost the same
+ */
+void benchmarkAlarms(Runner &runner) {
+  for (int numChannels : {64, 128}) {
+    for (int blockSize : {32, 256, 1024}) {
+      const auto input = makeNoise(blockSize);
+      std::vector<const float *> channels((size_t)numChannels, input.data());
+
+      for (bool enabled : {true, false}) {
+        const juce::NamedValueSet params{
+            {"channels", numChannels},
+            {"block", blockSize},
+            {"alarms", enabled ? "defaults" : "disabled"}};
+
+        if (!runner.shouldRun("analysis/alarms", params))
+          continue;
+
+        AlarmEngine engine(numChannels);
+        engine.prepare(SAMPLE_RATE);
+
+        for (int type = 0; type < AlarmEngine::NUM_TYPES; ++type) {
+          auto settings = engine.getSettings((AlarmEngine::Type)type);
+          settings.enabled = enabled;
+          engine.setSettings((AlarmEngine::Type)type, settings);
+        }
+
+        runner.measure("analysis/alarms", params, blockSize / SAMPLE_RATE,
+                       [&] {
+                         engine.process(channels.data(), numChannels,
+                                        blockSize);
+                       });
+
+        doNotOptimise(engine.getNumActive());
+      }
+    }
+  }
+}
+
+/** Windowed magnitude spectrum, as used by the spectral analysis */
+void benchmarkFft(Runner &runner) {
+  for (int order : {10, 11, 12, 13}) {
+    const int fftSize = 1 << order;
+    const juce::NamedValueSet params{{"size", fftSize}};
+
+    if (!runner.shouldRun("analysis/fft", params))
+      continue;
+
+    juce::dsp::FFT fft(order);
+    juce::dsp::WindowingFunction<float> window(
+        (size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+
+    const auto input = makeNoise(fftSize);
+    std::vector<float> buffer((size_t)fftSize * 2);
+
+    // Non-overlapping frames: one frame of audio per iteration
+    runner.measure("analysis/fft", params, fftSize / SAMPLE_RATE, [&] {
+      std::copy(input.begin(), input.end(), buffer.begin());
+      window.multiplyWithWindowingTable(buffer.data(), (size_t)fftSize);
+      fft.performFrequencyOnlyForwardTransform(buffer.data(), true);
+      doNotOptimise(buffer[1]);
+    });
+  }
+}
+
+/** Full per-channel summary: level, K-weighted loudness and spectrum */
+void benchmarkChannelAnalyzer(Runner &runner) {
+  for (int blockSize : {256, 4096}) {
+    const juce::NamedValueSet params{{"block", blockSize}};
+
+    if (!runner.shouldRun("analysis/channel_analyzer", params))
+      continue;
+
+    const auto input = makeNoise(blockSize);
+    ChannelAnalyzer analyzer;
+    analyzer.prepare(SAMPLE_RATE);
+
+    runner.measure("analysis/channel_analyzer", params,
+                   blockSize / SAMPLE_RATE,
+                   [&] { analyzer.process(input.data(), blockSize); });
+
+    doNotOptimise(analyzer.getSummary().rms);
+  }
+}
+
+/**
+ * The same half-band cascade as PolyphaseDecimator, as a plain FIR that
+ * filters every input sample with the full impulse response, zeros
+ * included, and then drops every other output. The reference the
+ * polyphase form is compared with.
+ */
+class DirectFormDecimator {
+public:
+  DirectFormDecimator(double sampleRate, int factor) {
+    for (int f = 1; f < factor; f *= 2, sampleRate /= 2.0) {
+      const auto sideTaps = PolyphaseDecimator::designHalfBand(sampleRate);
+      Stage stage;
+      stage.taps.assign(sideTaps.size() * 2 - 1, 0.0f);
+
+      for (size_t j = 0; j < sideTaps.size(); ++j)
+        stage.taps[2 * j] = sideTaps[j];
+      stage.taps[sideTaps.size() - 1] = 0.5f;
+
+      stage.history.assign(stage.taps.size() * 2, 0.0f);
+      stages.push_back(std::move(stage));
+    }
+  }
+
+  int process(const float *input, int numSamples, float *output) {
+    for (auto &stage : stages) {
+      const int length = (int)stage.taps.size();
+      int numOutput = 0;
+
+      for (int i = 0; i < numSamples; ++i) {
+        // Mirrored history, so each window is contiguous
+        stage.history[(size_t)stage.position] = input[i];
+        stage.history[(size_t)(stage.position + length)] = input[i];
+        stage.position = (stage.position + 1) % length;
+
+        float sum = 0.0f;
+        const float *window = stage.history.data() + stage.position;
+        for (int n = 0; n < length; ++n)
+          sum += stage.taps[(size_t)(length - 1 - n)] * window[n];
+
+        if ((stage.phase ^= 1) == 1)
+          output[numOutput++] = sum;
+      }
+
+      input = output;
+      numSamples = numOutput;
+    }
+
+    return numSamples;
+  }
+
+private:
+  struct Stage {
+    std::vector<float> taps, history;
+    int position = 0;
+    int phase = 0;
+  };
+
+  std::vector<Stage> stages;
+};
+
+/**
+ * Cost of the decimation stage alone, polyphase against the plain FIR it
+ * replaces, and of the channel summary at high sample rates with and
+ * without it. Compare decimate=0 with decimate=1 at each rate for the
+ * saving.
+ */
+void benchmarkDecimation(Runner &runner) {
+  constexpr int blockSize = 4096;
+  const auto input = makeNoise(blockSize);
+
+  for (double rate : {96000.0, 192000.0}) {
+    const int factor = PolyphaseDecimator::getFactorForSampleRate(rate);
+    std::vector<float> output((size_t)blockSize);
+
+    const juce::NamedValueSet polyphaseParams{{"rate", rate},
+                                              {"impl", "polyphase"}};
+
+    if (runner.shouldRun("analysis/decimator", polyphaseParams)) {
+      PolyphaseDecimator decimator;
+      decimator.prepare(rate, factor);
+
+      runner.measure("analysis/decimator", polyphaseParams, blockSize / rate,
+                     [&] {
+                       const int count = decimator.process(
+                           input.data(), blockSize, output.data());
+                       doNotOptimise(count);
+                     });
+    }
+
+    const juce::NamedValueSet directParams{{"rate", rate}, {"impl", "direct"}};
+
+    if (runner.shouldRun("analysis/decimator", directParams)) {
+      DirectFormDecimator decimator(rate, factor);
+
+      runner.measure("analysis/decimator", directParams, blockSize / rate,
+                     [&] {
+                       const int count = decimator.process(
+                           input.data(), blockSize, output.data());
+                       doNotOptimise(count);
+                     });
+    }
+  }
+
+  for (double rate : {48000.0, 96000.0, 192000.0}) {
+    for (bool decimate : {false, true}) {
+      const juce::NamedValueSet params{{"rate", rate},
+                                       {"decimate", decimate ? 1 : 0}};
+
+      if (!runner.shouldRun("analysis/channel_analyzer_rate", params))
+        continue;
+
+      ChannelAnalyzer analyzer;
+      analyzer.prepare(rate, decimate);
+
+      runner.measure("analysis/channel_analyzer_rate", params,
+                     blockSize / rate,
+                     [&] { analyzer.process(input.data(), blockSize); });
+
+      doNotOptimise(analyzer.getSummary().rms);
+    }
+  }
+}
+
+/**
+ * R128 loudness of the four slots plus one group of the given width. All
+ * channels share one K-weighting pass, so cost grows with lanes rather
+ * than per channel.
+ */
+void benchmarkLoudness(Runner &runner) {
+  constexpr int numSlots = 4;
+
+  for (int groupChannels : {0, 6, 16}) {
+    for (int blockSize : {32, 256, 1024}) {
+      const juce::NamedValueSet params{{"group", groupChannels},
+                                       {"block", blockSize}};
+
+      if (!runner.shouldRun("analysis/loudness", params))
+        continue;
+
+      const auto input = makeNoise(blockSize);
+      std::vector<const float *> channels(
+          (size_t)juce::jmax(numSlots, groupChannels), input.data());
+
+      LoudnessAnalyzer analyzer(numSlots);
+      analyzer.prepare(SAMPLE_RATE);
+
+      std::vector<int> group;
+      for (int ch = 0; ch < groupChannels; ++ch)
+        group.push_back(ch);
+      analyzer.setGroup(0, group);
+
+      runner.measure("analysis/loudness", params, blockSize / SAMPLE_RATE,
+                     [&] {
+                       analyzer.process(channels.data(), channels.data(),
+                                        (int)channels.size(), blockSize);
+                     });
+
+      doNotOptimise(analyzer.getSlotReading(0).integrated);
+    }
+  }
+}
+
+/**
+ * 4x true peak of every input channel. The budget is 64 channels at 48 kHz
+ * in under 1% of a core, i.e. a realtime multiple above 100.
+ */
+void benchmarkTruePeak(Runner &runner) {
+  for (int numChannels : {2, 64}) {
+    for (int blockSize : {32, 256, 1024}) {
+      const juce::NamedValueSet params{{"channels", numChannels},
+                                       {"block", blockSize}};
+
+      if (!runner.shouldRun("analysis/true_peak", params))
+        continue;
+
+      const auto input = makeNoise(blockSize);
+      std::vector<const float *> channels((size_t)numChannels, input.data());
+
+      TruePeakMeter meter;
+      meter.prepare(SAMPLE_RATE, numChannels);
+
+      runner.measure("analysis/true_peak", params, blockSize / SAMPLE_RATE,
+                     [&] {
+                       meter.process(channels.data(), numChannels, blockSize);
+                     });
+
+      doNotOptimise(meter.getPeak(0));
+    }
+  }
+}
+
+/**
+ * Oscilloscope history: extending the pyramid per block, and reducing a
+ * window to 1000 columns. Render time should be flat across windows.
+ */
+void benchmarkScope(Runner &runner) {
+  constexpr double maxWindowSeconds = 60.0;
+  constexpr int numColumns = 1000;
+
+  for (int blockSize : {32, 256, 1024}) {
+    const juce::NamedValueSet params{{"block", blockSize}};
+
+    if (!runner.shouldRun("scope/push", params))
+      continue;
+
+    const auto input = makeNoise(blockSize);
+
+    WaveformPyramid pyramid;
+    pyramid.prepare(SAMPLE_RATE, maxWindowSeconds, numColumns);
+
+    runner.measure("scope/push", params, blockSize / SAMPLE_RATE,
+                   [&] { pyramid.push(input.data(), blockSize); });
+
+    doNotOptimise(pyramid.getNumSamplesPushed());
+  }
+
+  WaveformPyramid pyramid;
+  pyramid.prepare(SAMPLE_RATE, maxWindowSeconds, numColumns);
+  const auto input = makeNoise((int)SAMPLE_RATE);
+
+  for (int second = 0; second < (int)maxWindowSeconds; ++second)
+    pyramid.push(input.data(), (int)input.size());
+
+  std::vector<WaveformPyramid::Column> columns((size_t)numColumns);
+
+  for (double windowSeconds : {0.01, 0.1, 1.0, 10.0, 60.0}) {
+    for (bool triggered : {false, true}) {
+      const juce::NamedValueSet params{{"window", windowSeconds},
+                                       {"triggered", triggered}};
+
+      if (!runner.shouldRun("scope/render", params))
+        continue;
+
+      runner.measure("scope/render", params, 0.0, [&] {
+        pyramid.render(windowSeconds, triggered, 0.0f, columns.data(),
+                       numColumns);
+      });
+
+      doNotOptimise(columns.front().max);
+    }
+  }
+}
+} // namespace
+
+void runAnalysisBenchmarks(Runner &runner) {
+  benchmarkMetering(runner);
+  benchmarkBallistics(runner);
+  benchmarkLevelHistory(runner);
+  benchmarkAlarms(runner);
+  benchmarkFft(runner);
+  benchmarkChannelAnalyzer(runner);
+  benchmarkDecimation(runner);
+  benchmarkLoudness(runner);
+  benchmarkTruePeak(runner);
+  benchmarkScope(runner);
+}
+
+} // namespace mcam::bench
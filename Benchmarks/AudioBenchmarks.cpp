@@ -0,0 +1,208 @@
+#include "../Source/Audio/Devices/AudioDeviceManager.h"
+#include "../Source/Audio/Processing/BufferProcessor.h"
+#include "../Source/Audio/Processing/ChannelMatrixMixer.h"
+#include "BenchmarkRunner.h"
+
+#include <iostream>
+
+namespace mcam::bench {
+
+namespace {
+constexpr double SAMPLE_RATE = 48000.0;
+
+/** Input block filled with low-level noise */
+juce::AudioBuffer<float> makeNoise(int numChannels, int numSamples) {
+  juce::AudioBuffer<float> buffer(numChannels, numSamples);
+  juce::Random random(1);
+
+  for (int ch = 0; ch < numChannels; ++ch) {
+    auto *data = buffer.getWritePointer(ch);
+    for (int i = 0; i < numSamples; ++i)
+      data[i] = 0.1f * (random.nextFloat() * 2.0f - 1.0f);
+  }
+
+  return buffer;
+}
+
+/** Callback that only counts the blocks it receives */
+class CountingCallback : public juce::AudioIODeviceCallback {
+public:
+  void audioDeviceIOCallbackWithContext(
+      const float *const *, int, float *const *, int, int,
+      const juce::AudioIODeviceCallbackContext &) override {
+    blocks.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void audioDeviceAboutToStart(juce::AudioIODevice *) override {}
+  void audioDeviceStopped() override {}
+
+  std::atomic<juce::int64> blocks{0};
+};
+
+void benchmarkBufferProcessor(Runner &runner) {
+  for (int numChannels : {2, 32, 128}) {
+    for (int numSlots : {1, BufferProcessor::NUM_MONITOR_SLOTS}) {
+      for (int blockSize : {32, 256, 1024}) {
+        const juce::NamedValueSet params{{"channels", numChannels},
+                                         {"slots", numSlots},
+                                         {"block", blockSize}};
+
+        if (!runner.shouldRun("buffer_processor/process", params))
+          continue;
+
+        const auto input = makeNoise(numChannels, blockSize);
+
+        BufferProcessor processor;
+        processor.prepareOffline(SAMPLE_RATE, blockSize);
+
+        // Spread the routed channels across the device
+        for (int slot = 0; slot < numSlots; ++slot)
+          processor.setMonitorChannel(slot, slot * numChannels / numSlots);
+
+        runner.measure("buffer_processor/process", params,
+                       blockSize / SAMPLE_RATE, [&] {
+                         processor.processOffline(
+                             input.getArrayOfReadPointers(), numChannels,
+                             blockSize);
+                       });
+
+        processor.releaseOffline();
+      }
+    }
+  }
+}
+
+/**
+ * Times the derived channels of a 7.1 bed: stereo and mono downmixes plus
+ * M/S of the front pair, each read by two consumers as slots would.
+ */
+void benchmarkChannelMatrix(Runner &runner) {
+  using Mixer = ChannelMatrixMixer;
+
+  for (int blockSize : {32, 256, 1024}) {
+    const juce::NamedValueSet params{{"block", blockSize}};
+
+    if (!runner.shouldRun("channel_matrix/mix", params))
+      continue;
+
+    const auto input = makeNoise(8, blockSize);
+    const auto bed = Mixer::BedLayout::surround71;
+
+    Mixer mixer;
+    mixer.prepare(blockSize);
+    mixer.setOutput(0, Mixer::downmix(bed, 0, Mixer::DownmixOutput::left));
+    mixer.setOutput(1, Mixer::downmix(bed, 0, Mixer::DownmixOutput::right));
+    mixer.setOutput(2, Mixer::downmix(bed, 0, Mixer::DownmixOutput::mono));
+    mixer.setOutput(3, Mixer::mid(0, 1));
+    mixer.setOutput(4, Mixer::side(0, 1));
+
+    runner.measure("channel_matrix/mix", params, blockSize / SAMPLE_RATE,
+                   [&] {
+                     mixer.beginBlock(input.getArrayOfReadPointers(), 8,
+                                      blockSize);
+
+                     for (int read = 0; read < 2; ++read)
+                       for (int output = 0; output < 5; ++output)
+                         doNotOptimise(mixer.getOutput(output));
+                   });
+  }
+}
+
+/**
+ * Times the whole device callback path: a free-running virtual device
+ * delivering silence through juce::AudioDeviceManager and our dispatcher
+ * to a number of trivial callbacks.
+ */
+void benchmarkDeviceDispatch(Runner &runner) {
+  std::unique_ptr<AudioDeviceManager> manager;
+
+  for (int numChannels : {2, 32, 128}) {
+    for (int blockSize : {64, 256}) {
+      bool deviceReady = false;
+
+      for (int numCallbacks : {1, 8}) {
+        const juce::NamedValueSet params{{"channels", numChannels},
+                                         {"block", blockSize},
+                                         {"callbacks", numCallbacks}};
+
+        if (!runner.shouldRun("device/dispatch", params))
+          continue;
+
+        if (manager == nullptr) {
+          manager = std::make_unique<AudioDeviceManager>();
+
+          // Bench devices must not end up in the user's device cache
+          manager->setDeviceCacheFile({});
+
+          if (!manager->initialize()) {
+            std::cerr << "device/dispatch: no audio device, skipped"
+                      << std::endl;
+            return;
+          }
+        }
+
+        if (!deviceReady) {
+          const auto name = "Bench Silence " + juce::String(numChannels) +
+                            "ch (free run)";
+          auto *type = manager->getVirtualDeviceType();
+          type->addDevice({name, VirtualAudioIODeviceType::Source::Silence,
+                           numChannels, {},
+                           VirtualAudioIODeviceType::Pacing::FreeRun});
+          manager->refreshDeviceList();
+
+          if (!manager->setAudioDevice(name, SAMPLE_RATE, blockSize)) {
+            std::cerr << "device/dispatch: cannot open " << name
+                      << std::endl;
+            continue;
+          }
+
+          deviceReady = true;
+        }
+
+        std::vector<std::unique_ptr<CountingCallback>> callbacks;
+        for (int i = 0; i < numCallbacks; ++i) {
+          callbacks.push_back(std::make_unique<CountingCallback>());
+          manager->addAudioCallback(callbacks.back().get());
+        }
+
+        // Let the device thread settle, then time a window of blocks
+        juce::Thread::sleep(50);
+
+        auto &counter = callbacks.front()->blocks;
+        const auto startBlocks = counter.load();
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        juce::Thread::sleep(
+            juce::roundToInt(runner.getOptions().minSeconds * 1000.0));
+
+        const auto blocks = counter.load() - startBlocks;
+        const double elapsed = juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - startTicks);
+
+        for (auto &callback : callbacks)
+          manager->removeAudioCallback(callback.get());
+
+        if (blocks <= 0)
+          continue;
+
+        Result result;
+        result.name = "device/dispatch";
+        result.params = params;
+        result.iterations = blocks;
+        result.nsPerIteration = elapsed * 1.0e9 / (double)blocks;
+        result.nsPerIterationMin = result.nsPerIteration;
+        result.audioSecondsPerIteration = blockSize / SAMPLE_RATE;
+        runner.addResult(result);
+      }
+    }
+  }
+}
+} // namespace
+
+void runAudioBenchmarks(Runner &runner) {
+  benchmarkBufferProcessor(runner);
+  benchmarkChannelMatrix(runner);
+  benchmarkDeviceDispatch(runner);
+}
+
+} // namespace mcam::bench
@@ -0,0 +1,109 @@
+#include "../Source/Core/Logger.h"
+#include "BenchmarkRunner.h"
+
+#include <iostream>
+
+// MCAMBench: times the audio, analysis and UI hot paths.
+//
+//   MCAMBench [--filter <text>] [--min-time <seconds>] [--output <file>]
+//             [--baseline <file>] [--threshold <percent>] [--list]
+//
+// Results are written as JSON to stdout or --output. With --baseline the
+// run is compared with an earlier result file and the exit code is 1 if
+// any case is slower than the threshold (default 10%).
+
+namespace {
+constexpr double DEFAULT_THRESHOLD_PERCENT = 10.0;
+
+void printUsage() {
+  std::cerr << "Usage: MCAMBench [--filter <text>] [--min-time <seconds>] "
+               "[--output <file>] [--baseline <file>] "
+               "[--threshold <percent>] [--list]"
+            << std::endl;
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  juce::ArgumentList args(argc, argv);
+
+  if (args.removeOptionIfFound("--help|-h")) {
+    printUsage();
+    return 0;
+  }
+
+  mcam::bench::Runner::Options options;
+  options.filter = args.removeValueForOption("--filter");
+  options.listOnly = args.removeOptionIfFound("--list");
+
+  const auto minTime = args.removeValueForOption("--min-time");
+  if (minTime.isNotEmpty())
+    options.minSeconds = juce::jmax(0.01, minTime.getDoubleValue());
+
+  const auto outputPath = args.removeValueForOption("--output|-o");
+  const auto baselinePath = args.removeValueForOption("--baseline");
+  const auto threshold = args.removeValueForOption("--threshold");
+  const double thresholdPercent = threshold.isNotEmpty()
+                                      ? threshold.getDoubleValue()
+                                      : DEFAULT_THRESHOLD_PERCENT;
+
+  if (!args.arguments.isEmpty()) {
+    std::cerr << "Unknown argument: " << args.arguments[0].text << std::endl;
+    printUsage();
+    return 2;
+  }
+
+  // Load the baseline first so a bad path fails before a long run
+  juce::var baseline;
+  if (baselinePath.isNotEmpty()) {
+    const auto file =
+        juce::File::getCurrentWorkingDirectory().getChildFile(baselinePath);
+    baseline = juce::JSON::parse(file.loadFileAsString());
+
+    if (!baseline.isObject()) {
+      std::cerr << "Cannot read baseline " << file.getFullPathName()
+                << std::endl;
+      return 2;
+    }
+  }
+
+  // Components and devices need the message manager
+  juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+  // Keep engine logging out of the measurements
+  Logger::getInstance().setMinLevel(Logger::Level::Warning);
+
+  mcam::bench::Runner runner(options);
+  mcam::bench::runAudioBenchmarks(runner);
+  mcam::bench::runAnalysisBenchmarks(runner);
+  mcam::bench::runUIBenchmarks(runner);
+
+  if (options.listOnly)
+    return 0;
+
+  const auto json = runner.toJson();
+
+  if (outputPath.isNotEmpty()) {
+    const auto file =
+        juce::File::getCurrentWorkingDirectory().getChildFile(outputPath);
+
+    if (!file.replaceWithText(json)) {
+      std::cerr << "Cannot write " << file.getFullPathName() << std::endl;
+      return 2;
+    }
+  } else {
+    std::cout << json << std::endl;
+  }
+
+  if (baseline.isObject()) {
+    const auto comparison = runner.compareWith(baseline, thresholdPercent);
+
+    std::cerr << comparison.text << comparison.numRegressions
+              << " regression(s) over " << thresholdPercent << "% in "
+              << comparison.numCompared << " compared case(s)" << std::endl;
+
+    if (comparison.numRegressions > 0)
+      return 1;
+  }
+
+  return 0;
+}
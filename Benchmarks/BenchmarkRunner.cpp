@@ -0,0 +1,211 @@
+#include "BenchmarkRunner.h"
+
+#include <iostream>
+
+namespace mcam::bench {
+
+namespace {
+// Version of the JSON layout written by toJson()
+constexpr int FORMAT_VERSION = 1;
+
+double timeIterations(const std::function<void()> &body,
+                      juce::int64 iterations) {
+  const auto startTicks = juce::Time::getHighResolutionTicks();
+
+  for (juce::int64 i = 0; i < iterations; ++i)
+    body();
+
+  return juce::Time::highResolutionTicksToSeconds(
+      juce::Time::getHighResolutionTicks() - startTicks);
+}
+
+double median(std::vector<double> values) {
+  if (values.empty())
+    return 0.0;
+
+  std::sort(values.begin(), values.end());
+  const size_t mid = values.size() / 2;
+  return values.size() % 2 != 0 ? values[mid]
+                                : 0.5 * (values[mid - 1] + values[mid]);
+}
+} // namespace
+
+//==============================================================================
+juce::String Result::getKey() const {
+  juce::StringArray parts;
+
+  for (const auto &param : params)
+    parts.add(param.name.toString() + "=" + param.value.toString());
+
+  return parts.isEmpty() ? name : name + "[" + parts.joinIntoString(",") + "]";
+}
+
+double Result::getRealtimeMultiple() const {
+  if (audioSecondsPerIteration <= 0.0 || nsPerIteration <= 0.0)
+    return 0.0;
+
+  return audioSecondsPerIteration / (nsPerIteration * 1.0e-9);
+}
+
+//==============================================================================
+Runner::Runner(const Options &runnerOptions) : options(runnerOptions) {
+  options.numBatches = juce::jmax(1, options.numBatches);
+}
+
+bool Runner::shouldRun(const juce::String &name,
+                       const juce::NamedValueSet &params) {
+  Result probe;
+  probe.name = name;
+  probe.params = params;
+  const auto key = probe.getKey();
+
+  if (options.filter.isNotEmpty() && !key.contains(options.filter))
+    return false;
+
+  if (options.listOnly) {
+    std::cout << key << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+void Runner::measure(const juce::String &name,
+                     const juce::NamedValueSet &params,
+                     double audioSecondsPerIteration,
+                     const std::function<void()> &body) {
+  if (!shouldRun(name, params))
+    return;
+
+  // Warm up while finding how many iterations fill one batch
+  const double batchSeconds = options.minSeconds / options.numBatches;
+  juce::int64 perBatch = 1;
+
+  for (;;) {
+    const double elapsed = timeIterations(body, perBatch);
+
+    if (elapsed >= batchSeconds * 0.25 || perBatch >= (1 << 30)) {
+      const double scale = batchSeconds / juce::jmax(elapsed, 1.0e-9);
+      perBatch = juce::jmax((juce::int64)1, (juce::int64)(perBatch * scale));
+      break;
+    }
+
+    perBatch *= 2;
+  }
+
+  std::vector<double> batchNs;
+
+  for (int batch = 0; batch < options.numBatches; ++batch) {
+    const double elapsed = timeIterations(body, perBatch);
+    batchNs.push_back(elapsed * 1.0e9 / (double)perBatch);
+  }
+
+  Result result;
+  result.name = name;
+  result.params = params;
+  result.iterations = perBatch * options.numBatches;
+  result.nsPerIteration = median(batchNs);
+  result.nsPerIterationMin = *std::min_element(batchNs.begin(), batchNs.end());
+  result.audioSecondsPerIteration = audioSecondsPerIteration;
+
+  addResult(result);
+}
+
+void Runner::addResult(const Result &result) {
+  juce::String line;
+  line << result.getKey() << ": " << juce::String(result.nsPerIteration, 1)
+       << " ns";
+
+  if (result.audioSecondsPerIteration > 0.0)
+    line << " (" << juce::String(result.getRealtimeMultiple(), 1)
+         << "x real time)";
+
+  std::cerr << line << std::endl;
+  results.push_back(result);
+}
+
+const Runner::Options &Runner::getOptions() const { return options; }
+
+const std::vector<Result> &Runner::getResults() const { return results; }
+
+juce::String Runner::toJson() const {
+  auto *host = new juce::DynamicObject();
+  host->setProperty("os", juce::SystemStats::getOperatingSystemName());
+  host->setProperty("cpu", juce::SystemStats::getCpuModel());
+  host->setProperty("cores", juce::SystemStats::getNumCpus());
+  host->setProperty("juce", juce::SystemStats::getJUCEVersion());
+
+  juce::Array<juce::var> resultList;
+
+  for (const auto &result : results) {
+    auto *object = new juce::DynamicObject();
+    object->setProperty("key", result.getKey());
+    object->setProperty("name", result.name);
+
+    auto *params = new juce::DynamicObject();
+    for (const auto &param : result.params)
+      params->setProperty(param.name, param.value);
+    object->setProperty("params", juce::var(params));
+
+    object->setProperty("iterations", result.iterations);
+    object->setProperty("ns_per_iteration", result.nsPerIteration);
+    object->setProperty("ns_per_iteration_min", result.nsPerIterationMin);
+
+    if (result.audioSecondsPerIteration > 0.0)
+      object->setProperty("realtime_multiple", result.getRealtimeMultiple());
+
+    resultList.add(juce::var(object));
+  }
+
+  auto *root = new juce::DynamicObject();
+  root->setProperty("format", FORMAT_VERSION);
+  root->setProperty("timestamp",
+                    juce::Time::getCurrentTime().toISO8601(true));
+  root->setProperty("host", juce::var(host));
+  root->setProperty("results", resultList);
+
+  return juce::JSON::toString(juce::var(root));
+}
+
+Runner::Comparison Runner::compareWith(const juce::var &baselineJson,
+                                       double thresholdPercent) const {
+  Comparison comparison;
+
+  std::map<juce::String, double> baseline;
+  if (auto *list = baselineJson["results"].getArray()) {
+    for (const auto &entry : *list)
+      baseline[entry["key"].toString()] = (double)entry["ns_per_iteration"];
+  }
+
+  for (const auto &result : results) {
+    const auto key = result.getKey();
+    const auto found = baseline.find(key);
+
+    if (found == baseline.end() || found->second <= 0.0) {
+      comparison.text << key << ": new\n";
+      continue;
+    }
+
+    const double change =
+        (result.nsPerIteration - found->second) / found->second * 100.0;
+    ++comparison.numCompared;
+
+    comparison.text << key << ": " << juce::String(found->second, 1)
+                    << " -> " << juce::String(result.nsPerIteration, 1)
+                    << " ns (" << (change >= 0.0 ? "+" : "")
+                    << juce::String(change, 1) << "%)";
+
+    if (change > thresholdPercent) {
+      comparison.text << " REGRESSION";
+      ++comparison.numRegressions;
+    } else if (change < -thresholdPercent) {
+      comparison.text << " improved";
+    }
+
+    comparison.text << "\n";
+  }
+
+  return comparison;
+}
+
+} // namespace mcam::bench
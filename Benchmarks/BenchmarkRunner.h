@@ -0,0 +1,142 @@
+#pragma once
+
+#include "../Source/JuceHeader.h"
+
+namespace mcam::bench {
+/** One measured case */
+struct Result {
+  /** Benchmark name, e.g. "buffer_processor/process" */
+  juce::String name;
+
+  /** Case parameters, e.g. channels=64 */
+  juce::NamedValueSet params;
+
+  /** Total iterations timed */
+  juce::int64 iterations = 0;
+
+  /** Median and fastest batch, in nanoseconds per iteration */
+  double nsPerIteration = 0.0;
+  double nsPerIterationMin = 0.0;
+
+  /** Audio processed per iteration (0 for non-audio benchmarks) */
+  double audioSecondsPerIteration = 0.0;
+
+  /** @return Unique key: the name followed by the parameters */
+  juce::String getKey() const;
+
+  /** @return Audio seconds processed per wall-clock second, or 0 */
+  double getRealtimeMultiple() const;
+};
+
+/**
+ * Runner times benchmark bodies and collects the results.
+ *
+ * Each case is calibrated so one batch takes a fixed share of the minimum
+ * time, then timed over several batches. The median batch is reported,
+ * which keeps single scheduler hiccups out of the comparison with a
+ * baseline.
+ */
+class Runner {
+public:
+  struct Options {
+    /** Minimum timed duration per case */
+    double minSeconds = 0.5;
+
+    /** Number of batches the timed duration is split into */
+    int numBatches = 10;
+
+    /** Only cases whose key contains this are run (empty = all) */
+    juce::String filter;
+
+    /** Print keys instead of running */
+    bool listOnly = false;
+  };
+
+  /** Comparison of the current results with a baseline */
+  struct Comparison {
+    /** Human-readable table, one line per case */
+    juce::String text;
+
+    /** Cases slower than the threshold */
+    int numRegressions = 0;
+
+    /** Cases present in both runs */
+    int numCompared = 0;
+  };
+
+  /** Constructor */
+  explicit Runner(const Options &options);
+
+  /**
+   * Checks the filter; benchmarks should skip expensive setup when false
+   * @param name Benchmark name
+   * @param params Case parameters
+   * @return true if the case should run
+   */
+  bool shouldRun(const juce::String &name, const juce::NamedValueSet &params);
+
+  /**
+   * Calibrates, times and records one case
+   * @param name Benchmark name
+   * @param params Case parameters
+   * @param audioSecondsPerIteration Audio processed per call of body
+   * @param body Code under measurement
+   */
+  void measure(const juce::String &name, const juce::NamedValueSet &params,
+               double audioSecondsPerIteration,
+               const std::function<void()> &body);
+
+  /**
+   * Records a case timed by the benchmark itself
+   * @param result Completed result
+   */
+  void addResult(const Result &result);
+
+  /** @return Options in use */
+  const Options &getOptions() const;
+
+  /** @return Results in the order they were measured */
+  const std::vector<Result> &getResults() const;
+
+  /** @return Results and host description as a JSON document */
+  juce::String toJson() const;
+
+  /**
+   * Compares the results with a previous toJson() document
+   * @param baselineJson Baseline document
+   * @param thresholdPercent Slowdown that counts as a regression
+   * @return The comparison
+   */
+  Comparison compareWith(const juce::var &baselineJson,
+                         double thresholdPercent) const;
+
+private:
+  Options options;
+  std::vector<Result> results;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Runner)
+};
+
+/** Runs the audio pipeline benchmarks */
+void runAudioBenchmarks(Runner &runner);
+
+/** Runs the metering and FFT analysis benchmarks */
+void runAnalysisBenchmarks(Runner &runner);
+
+/** Runs the component painting benchmarks */
+void runUIBenchmarks(Runner &runner);
+
+/**
+ * Keeps a value alive so the optimiser cannot remove the code producing it
+ * @param value Value to consume
+ */
+template <typename T> inline void doNotOptimise(const T &value) {
+#if JUCE_MSVC
+  static volatile char sink;
+  sink = *reinterpret_cast<const volatile char *>(&value);
+#else
+  asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+} // namespace mcam::bench
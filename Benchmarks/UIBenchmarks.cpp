@@ -0,0 +1,114 @@
+#include "../Source/UI/Meters/MeterComponent.h"
+#include "../Source/UI/Meters/TrendComponent.h"
+#include "../Source/UI/MonitoringSlotComponent.h"
+#include "../Source/UI/RTA/RTAComponent.h"
+#include "../Source/UI/Scope/ScopeComponent.h"
+#include "BenchmarkRunner.h"
+
+namespace mcam::bench {
+
+namespace {
+/**
+ * Times one full software-rendered paint of a component and its children
+ * into an offscreen image. The image is not cleared between iterations,
+ * which matches an opaque repaint.
+ */
+void measurePaint(Runner &runner, const juce::String &name,
+                  juce::Component &component, int width, int height,
+                  const std::function<void()> &update) {
+  const juce::NamedValueSet params{
+      {"size", juce::String(width) + "x" + juce::String(height)}};
+
+  if (!runner.shouldRun(name, params))
+    return;
+
+  component.setSize(width, height);
+  juce::Image image(juce::Image::ARGB, width, height, true,
+                    juce::SoftwareImageType());
+
+  runner.measure(name, params, 0.0, [&] {
+    if (update)
+      update();
+
+    juce::Graphics g(image);
+    component.paintEntireComponent(g, false);
+  });
+}
+} // namespace
+
+void runUIBenchmarks(Runner &runner) {
+  // Meter level changes every frame, as it does while audio is running
+  float level = 0.0f;
+  const auto nextLevel = [&level] {
+    level = level >= 1.0f ? 0.0f : level + 0.01f;
+    return level;
+  };
+
+  {
+    MeterComponent meter;
+    meter.setTitle("Level");
+
+    for (auto [width, height] : {std::pair{60, 300}, std::pair{120, 600}}) {
+      measurePaint(runner, "ui/meter_paint", meter, width, height,
+                   [&] { meter.setLevel(nextLevel()); });
+    }
+  }
+
+  {
+    // An hour of history at a width that reads the 1 s entries
+    LevelHistory history;
+    for (int block = 0; block < 3600 * 100; ++block)
+      history.push((float)(block % 1000) / 1000.0f, 480);
+
+    TrendComponent trend;
+    trend.stopTimer();
+    trend.setHistory(&history);
+
+    for (auto [width, height] : {std::pair{400, 200}, std::pair{800, 400}}) {
+      measurePaint(runner, "ui/trend_paint", trend, width, height, {});
+    }
+  }
+
+  {
+    RTAComponent rta;
+    rta.stopTimer();
+
+    for (auto [width, height] : {std::pair{400, 200}, std::pair{800, 400}}) {
+      measurePaint(runner, "ui/rta_paint", rta, width, height,
+                   [&] { rta.updateMockData(); });
+    }
+  }
+
+  {
+    // The longest window over a full history; paint cost should match the
+    // shortest
+    ScopeComponent scope;
+    scope.stopTimer();
+    scope.setWindowSeconds(ScopeComponent::MAX_WINDOW_SECONDS);
+
+    std::vector<float> second(48000);
+    for (size_t i = 0; i < second.size(); ++i)
+      second[i] = (float)std::sin(0.1 * (double)i);
+
+    for (int i = 0; i < (int)ScopeComponent::MAX_WINDOW_SECONDS; ++i) {
+      scope.pushSamples(second.data(), (int)second.size());
+      scope.timerCallback();
+    }
+
+    for (auto [width, height] : {std::pair{400, 200}, std::pair{800, 400}}) {
+      measurePaint(runner, "ui/scope_paint", scope, width, height, {});
+    }
+  }
+
+  {
+    MonitoringSlotComponent slot(0);
+    slot.stopTimer();
+
+    for (auto [width, height] : {std::pair{300, 400}, std::pair{600, 800}}) {
+      measurePaint(runner, "ui/slot_paint", slot, width, height,
+                   [&] { slot.setLevel(nextLevel()); });
+    }
+  }
+}
+
+} // namespace mcam::bench
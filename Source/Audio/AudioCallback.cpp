@@ -2,7 +2,10 @@
 
 namespace mcam {
 
-AudioCallback::AudioCallback() { LOG_DEBUG("AudioCallback initialized"); }
+AudioCallback::AudioCallback()
+    : latencyTracker(LatencyTracker::getInstance()) {
+  LOG_DEBUG("AudioCallback initialized");
+}
 
 AudioCallback::~AudioCallback() { LOG_DEBUG("AudioCallback destroyed"); }
 
@@ -12,8 +15,28 @@ void AudioCallback::audioDeviceAboutToStart(juce::AudioIODevice *device) {
     return;
   }
 
-  currentSampleRate = device->getCurrentSampleRate();
-  currentBufferSize = device->getCurrentBufferSizeSamples();
+  prepareForFormat(device->getCurrentSampleRate(),
+                   device->getCurrentBufferSizeSamples(),
+                   device->getActiveInputChannels().countNumberOfSetBits());
+}
+
+void AudioCallback::prepareForFormat(double sampleRate, int bufferSize,
+                                     int numInputs) {
+  // After a device switch to the same format, keep the analysis state
+  if (isProcessingActive && sampleRate == currentSampleRate &&
+      bufferSize == currentBufferSize &&
+      numInputs == currentNumInputChannels) {
+    LOG_DEBUG("Audio device starting with unchanged format");
+    return;
+  }
+
+  // Switching format without a stop in between: release the old one first
+  if (isProcessingActive)
+    releaseResources();
+
+  currentSampleRate = sampleRate;
+  currentBufferSize = bufferSize;
+  currentNumInputChannels = numInputs;
   isProcessingActive = true;
 
   LOG_DEBUG("Audio device starting: " + juce::String(currentSampleRate) +
@@ -25,6 +48,7 @@ void AudioCallback::audioDeviceAboutToStart(juce::AudioIODevice *device) {
 void AudioCallback::audioDeviceStopped() {
   LOG_DEBUG("Audio device stopped");
   isProcessingActive = false;
+  currentNumInputChannels = 0;
   releaseResources();
 }
 
@@ -36,6 +60,8 @@ void AudioCallback::audioDeviceIOCallbackWithContext(
     const float *const *inputChannelData, int numInputChannels,
     float *const *outputChannelData, int numOutputChannels, int numSamples,
     const juce::AudioIODeviceCallbackContext &context) {
+  const RealtimeGuard::ScopedRealtime realtime;
+
   // Clear output buffers first (silence)
   for (int channel = 0; channel < numOutputChannels; ++channel) {
     if (outputChannelData[channel] != nullptr) {
@@ -46,10 +72,37 @@ void AudioCallback::audioDeviceIOCallbackWithContext(
 
   // Process audio data through our callback chain
   if (isProcessingActive && inputChannelData != nullptr) {
+    blockStamp = latencyTracker.isEnabled()
+                     ? LatencyTracker::stampBlock(context, numSamples,
+                                                  currentSampleRate)
+                     : LatencyTracker::Stamp();
+
     processAudio(inputChannelData, numInputChannels, numSamples);
   }
 }
 
+void AudioCallback::prepareOffline(double sampleRate, int blockSize) {
+  currentSampleRate = sampleRate;
+  currentBufferSize = blockSize;
+  isProcessingActive = true;
+
+  prepareToPlay(sampleRate, blockSize);
+}
+
+void AudioCallback::processOffline(const float *const *inputChannelData,
+                                   int numInputChannels, int numSamples) {
+  if (isProcessingActive && inputChannelData != nullptr) {
+    // Offline blocks have no capture time
+    blockStamp = {};
+    processAudio(inputChannelData, numInputChannels, numSamples);
+  }
+}
+
+void AudioCallback::releaseOffline() {
+  isProcessingActive = false;
+  releaseResources();
+}
+
 void AudioCallback::processAudio(const float *const *inputChannelData,
                                  int numInputChannels, int numSamples) {
   // Base implementation does nothing - derived classes should override this
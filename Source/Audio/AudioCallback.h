@@ -1,6 +1,8 @@
 #pragma once
 
+#include "../Core/LatencyTracker.h"
 #include "../Core/Logger.h"
+#include "../Core/RealtimeGuard.h"
 #include "../JuceHeader.h"
 
 namespace mcam {
@@ -19,10 +21,23 @@ public:
 
   /**
    * Called when an audio device is about to start playback. Base implementation
-   * prepares internal buffers based on device specs.
+   * prepares internal buffers based on device specs. If the callback is still
+   * prepared for the same sample rate, buffer size and input count (a device
+   * switch without a stop), preparation is skipped and state is kept.
    */
   void audioDeviceAboutToStart(juce::AudioIODevice *device) override;
 
+  /**
+   * Prepares for a format before the device running it starts, e.g. while a
+   * device switch is under way. audioDeviceAboutToStart() then finds the
+   * format unchanged and keeps the prepared state. Must not run while the
+   * callback is being fed.
+   * @param sampleRate Sample rate in Hz
+   * @param bufferSize Buffer size in samples
+   * @param numInputs Number of active input channels
+   */
+  void prepareForFormat(double sampleRate, int bufferSize, int numInputs);
+
   /**
    * Called when an audio device has stopped. Base implementation
    * clears internal buffers.
@@ -44,6 +59,26 @@ public:
       float *const *outputChannelData, int numOutputChannels, int numSamples,
       const juce::AudioIODeviceCallbackContext &context) override;
 
+  /**
+   * Prepares the callback for offline processing, without a device. Runs
+   * the same prepareToPlay() path as audioDeviceAboutToStart().
+   * @param sampleRate Sample rate of the material in Hz
+   * @param blockSize Largest block that will be passed to processOffline()
+   */
+  void prepareOffline(double sampleRate, int blockSize);
+
+  /**
+   * Processes one block offline through processAudio()
+   * @param inputChannelData Array of input channel data
+   * @param numInputChannels Number of input channels
+   * @param numSamples Number of samples (at most the prepared block size)
+   */
+  void processOffline(const float *const *inputChannelData,
+                      int numInputChannels, int numSamples);
+
+  /** Ends offline processing through releaseResources() */
+  void releaseOffline();
+
 protected:
   /**
    * Override this method to process audio data in derived classes.
@@ -72,9 +107,17 @@ protected:
   // Current audio specs
   double currentSampleRate = 0.0;
   int currentBufferSize = 0;
+  int currentNumInputChannels = 0;
   bool isProcessingActive = false;
 
+  // Latency stamp of the block being processed; only set in instrumented
+  // mode and only valid during processAudio()
+  LatencyTracker::Stamp blockStamp;
+
 private:
+  // Created before the first callback, which must not construct it
+  LatencyTracker &latencyTracker;
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioCallback)
 };
 
@@ -2,19 +2,36 @@
 
 namespace mcam {
 
+// Every port a JACK source can be connected to can be analysed
+static_assert(JackAudioIODevice::NUM_INPUT_PORTS ==
+                  BufferProcessor::MAX_CHANNELS,
+              "JACK inputs and processor channels differ");
+
 AudioEngine::AudioEngine() {
   LOG_INFO("Creating AudioEngine");
 
   // Create audio device manager
   audioDeviceManager = std::make_unique<AudioDeviceManager>();
 
+  // Create device switcher
+  deviceSwitcher = std::make_unique<DeviceSwitcher>(*audioDeviceManager);
+
   // Create buffer processor
   bufferProcessor = std::make_unique<BufferProcessor>();
+
+  // Create disk recorder
+  diskRecorder = std::make_unique<DiskRecorder>();
+
+  // Create retroactive capture
+  retroactiveCapture = std::make_unique<RetroactiveCapture>();
 }
 
 AudioEngine::~AudioEngine() {
   LOG_INFO("Destroying AudioEngine");
 
+  // Wait for a background initialization to finish
+  startupPool.removeAllJobs(false, 30000);
+
   // Shutdown if still running
   if (isInitialized) {
     shutdown();
@@ -24,6 +41,8 @@ AudioEngine::~AudioEngine() {
 bool AudioEngine::initialize() {
   LOG_INFO("Initializing AudioEngine");
 
+  const juce::ScopedLock sl(initLock);
+
   if (isInitialized) {
     LOG_WARNING("AudioEngine already initialized");
     return true;
@@ -37,6 +56,8 @@ bool AudioEngine::initialize() {
 
   // Register buffer processor with device manager
   audioDeviceManager->addAudioCallback(bufferProcessor.get());
+  audioDeviceManager->addAudioCallback(diskRecorder.get());
+  audioDeviceManager->addAudioCallback(retroactiveCapture.get());
 
   isInitialized = true;
   LOG_INFO("AudioEngine initialized successfully");
@@ -44,29 +65,75 @@ bool AudioEngine::initialize() {
   return true;
 }
 
+void AudioEngine::initializeAsync(std::function<void(bool)> onComplete) {
+  startupPool.addJob([this, onComplete] {
+    ThreadTuning::getInstance().applyToCurrentThread(
+        ThreadTuning::ThreadClass::background);
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const bool ok = initialize();
+    const double elapsed = MetricsRegistry::ticksToSeconds(
+        juce::Time::getHighResolutionTicks() - startTicks);
+
+    LOG_INFO("Background audio initialization took " +
+             juce::String(elapsed * 1000.0, 0) + " ms");
+
+    if (onComplete != nullptr)
+      juce::MessageManager::callAsync([onComplete, ok] { onComplete(ok); });
+  });
+}
+
 void AudioEngine::shutdown() {
   LOG_INFO("Shutting down AudioEngine");
 
+  const juce::ScopedLock sl(initLock);
+
   if (!isInitialized) {
     LOG_WARNING("AudioEngine not initialized");
     return;
   }
 
+  // Let a device switch in progress finish first
+  if (deviceSwitcher && !deviceSwitcher->waitUntilIdle(30000)) {
+    LOG_WARNING("Device switch still running at shutdown");
+  }
+
+  // Finish any recording before the device goes away
+  if (diskRecorder) {
+    diskRecorder->stopRecording();
+  }
+
   // Remove callbacks
   if (audioDeviceManager && bufferProcessor) {
     audioDeviceManager->removeAudioCallback(bufferProcessor.get());
   }
 
+  if (audioDeviceManager && diskRecorder) {
+    audioDeviceManager->removeAudioCallback(diskRecorder.get());
+  }
+
+  if (audioDeviceManager && retroactiveCapture) {
+    audioDeviceManager->removeAudioCallback(retroactiveCapture.get());
+  }
+
   isInitialized = false;
   LOG_INFO("AudioEngine shut down successfully");
 }
 
+bool AudioEngine::isAudioInitialized() const { return isInitialized; }
+
 AudioDeviceManager &AudioEngine::getAudioDeviceManager() {
   return *audioDeviceManager;
 }
 
 BufferProcessor &AudioEngine::getBufferProcessor() { return *bufferProcessor; }
 
+DiskRecorder &AudioEngine::getDiskRecorder() { return *diskRecorder; }
+
+RetroactiveCapture &AudioEngine::getRetroactiveCapture() {
+  return *retroactiveCapture;
+}
+
 juce::StringArray AudioEngine::getAvailableDeviceNames() const {
   return audioDeviceManager->getAvailableDeviceNames();
 }
@@ -75,6 +142,45 @@ bool AudioEngine::setAudioDevice(const juce::String &deviceName) {
   return audioDeviceManager->setAudioDevice(deviceName);
 }
 
+void AudioEngine::setAudioDeviceAsync(const juce::String &deviceName) {
+  deviceSwitcher->requestSwitch(deviceName);
+}
+
+DeviceSwitcher &AudioEngine::getDeviceSwitcher() { return *deviceSwitcher; }
+
+juce::StringArray AudioEngine::getJackSourcePorts() const {
+  if (auto *jackDevice = dynamic_cast<JackAudioIODevice *>(
+          audioDeviceManager->getCurrentAudioDevice()))
+    return jackDevice->getSourcePorts();
+
+  return {};
+}
+
+bool AudioEngine::connectJackPortToSlot(const juce::String &sourcePort,
+                                        int slotIndex) {
+  auto *jackDevice = dynamic_cast<JackAudioIODevice *>(
+      audioDeviceManager->getCurrentAudioDevice());
+
+  if (jackDevice == nullptr) {
+    LOG_WARNING("JACK port routing needs the JACK device to be open");
+    return false;
+  }
+
+  // The processor numbers the active ports only; map between the two
+  const auto activeInputs = jackDevice->getActiveInputChannels();
+
+  int input = JackAudioIODevice::channelToInput(
+      activeInputs, bufferProcessor->getMonitorChannel(slotIndex));
+  if (input < 0)
+    input = jackDevice->findUnconnectedInput();
+
+  if (input < 0 || !jackDevice->connectInput(sourcePort, input))
+    return false;
+
+  return bufferProcessor->postMonitorChannel(
+      slotIndex, JackAudioIODevice::inputToChannel(activeInputs, input));
+}
+
 juce::String AudioEngine::getCurrentDeviceName() const {
   return audioDeviceManager->getCurrentDeviceName();
 }
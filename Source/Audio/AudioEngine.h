@@ -3,7 +3,10 @@
 #include "../Core/Logger.h"
 #include "../JuceHeader.h"
 #include "Devices/AudioDeviceManager.h"
+#include "Devices/DeviceSwitcher.h"
 #include "Processing/BufferProcessor.h"
+#include "Recording/DiskRecorder.h"
+#include "Recording/RetroactiveCapture.h"
 
 namespace mcam {
 /**
@@ -24,11 +27,24 @@ public:
    */
   bool initialize();
 
+  /**
+   * Initializes the audio system on a background thread and returns
+   * immediately, so the window can show while the driver opens
+   * @param onComplete Called on the message thread with the result
+   */
+  void initializeAsync(std::function<void(bool)> onComplete);
+
   /**
    * Shuts down the audio system
    */
   void shutdown();
 
+  /**
+   * Checks whether initialize() has completed successfully
+   * @return true if the audio system is initialized
+   */
+  bool isAudioInitialized() const;
+
   /**
    * Gets the audio device manager
    * @return Reference to the audio device manager
@@ -41,6 +57,18 @@ public:
    */
   BufferProcessor &getBufferProcessor();
 
+  /**
+   * Gets the disk recorder
+   * @return Reference to the disk recorder
+   */
+  DiskRecorder &getDiskRecorder();
+
+  /**
+   * Gets the retroactive capture history
+   * @return Reference to the retroactive capture
+   */
+  RetroactiveCapture &getRetroactiveCapture();
+
   /**
    * Gets a list of available audio devices
    * @return StringArray of device names
@@ -48,12 +76,41 @@ public:
   juce::StringArray getAvailableDeviceNames() const;
 
   /**
-   * Sets the current audio device
+   * Sets the current audio device, blocking until the driver has reopened
    * @param deviceName Name of the device to set active
    * @return true if device was set successfully
    */
   bool setAudioDevice(const juce::String &deviceName);
 
+  /**
+   * Switches the audio device on the background control thread and returns
+   * immediately. Progress is reported through getDeviceSwitcher().
+   * @param deviceName Name of the device to set active
+   */
+  void setAudioDeviceAsync(const juce::String &deviceName);
+
+  /**
+   * Gets the background device switcher
+   * @return Reference to the device switcher
+   */
+  DeviceSwitcher &getDeviceSwitcher();
+
+  /**
+   * Lists the JACK ports that can be connected to a slot
+   * @return Full port names; empty unless the JACK device is open
+   */
+  juce::StringArray getJackSourcePorts() const;
+
+  /**
+   * Connects a JACK port to a monitoring slot without reopening the device.
+   * The slot's input is rewired if it has one (affecting other slots on the
+   * same input); otherwise the first unconnected active input is used.
+   * @param sourcePort Full JACK port name, e.g. "system:capture_3"
+   * @param slotIndex Monitoring slot index
+   * @return true if connected; false if the JACK device is not open
+   */
+  bool connectJackPortToSlot(const juce::String &sourcePort, int slotIndex);
+
   /**
    * Gets the current audio device name
    * @return name of current device, or empty string if none
@@ -70,11 +127,24 @@ private:
   // Audio device manager
   std::unique_ptr<AudioDeviceManager> audioDeviceManager;
 
+  // Background device switching (destroyed before the device manager)
+  std::unique_ptr<DeviceSwitcher> deviceSwitcher;
+
   // Buffer processor
   std::unique_ptr<BufferProcessor> bufferProcessor;
 
-  // Initialization state
-  bool isInitialized = false;
+  // Disk recorder
+  std::unique_ptr<DiskRecorder> diskRecorder;
+
+  // Rolling in-memory history of all inputs
+  std::unique_ptr<RetroactiveCapture> retroactiveCapture;
+
+  // Initialization state, guarded by initLock
+  juce::CriticalSection initLock;
+  std::atomic<bool> isInitialized{false};
+
+  // Runs initializeAsync() (destroyed first, waiting for the job)
+  juce::ThreadPool startupPool{1};
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioEngine)
 };
@@ -0,0 +1,680 @@
+#include "AggregateAudioIODeviceType.h"
+
+namespace mcam {
+
+namespace {
+// FIFO fill aimed for, on top of one block of each side
+constexpr double TARGET_MARGIN_SECONDS = 0.002;
+
+// FIFO capacity in multiples of the target fill
+constexpr int FIFO_CAPACITY_TARGETS = 4;
+
+// Fill error in seconds is corrected over this many seconds
+constexpr double SERVO_SECONDS = 10.0;
+
+// Largest ratio trim the fill servo applies (1000 ppm)
+constexpr double MAX_SERVO_TRIM = 0.001;
+
+// Largest ratio accepted from the clock estimates (1%)
+constexpr double MAX_RATIO_DEVIATION = 0.01;
+
+// Time constant of the smoothed FIFO fill
+constexpr double FILL_SMOOTHING_SECONDS = 0.5;
+
+// Callbacks each clock must have seen before its estimate is used
+constexpr int MIN_CLOCK_UPDATES = 16;
+
+juce::String escapeLabelValue(const juce::String &value) {
+  return value.replace("\\", "\\\\").replace("\"", "\\\"");
+}
+} // namespace
+
+//==============================================================================
+AggregateAudioIODeviceType::AggregateAudioIODeviceType(
+    juce::AudioDeviceManager &manager)
+    : juce::AudioIODeviceType(TYPE_NAME), deviceManager(manager) {}
+
+AggregateAudioIODeviceType::~AggregateAudioIODeviceType() = default;
+
+juce::String
+AggregateAudioIODeviceType::addAggregate(const juce::StringArray &memberNames) {
+  juce::StringArray unique(memberNames);
+  unique.removeEmptyStrings();
+  unique.removeDuplicates(false);
+
+  if (unique.size() < 2) {
+    LOG_WARNING("An aggregate device needs at least two member devices");
+    return {};
+  }
+
+  const auto name = "Aggregate: " + unique.joinIntoString(" + ");
+  LOG_INFO("Adding aggregate device: " + name);
+
+  {
+    const juce::ScopedLock sl(aggregatesLock);
+
+    auto existing =
+        std::find_if(aggregates.begin(), aggregates.end(),
+                     [&name](const auto &a) { return a.first == name; });
+
+    if (existing != aggregates.end())
+      existing->second = unique;
+    else
+      aggregates.emplace_back(name, unique);
+  }
+
+  callDeviceChangeListeners();
+  return name;
+}
+
+void AggregateAudioIODeviceType::removeAggregate(const juce::String &name) {
+  {
+    const juce::ScopedLock sl(aggregatesLock);
+    aggregates.erase(
+        std::remove_if(aggregates.begin(), aggregates.end(),
+                       [&name](const auto &a) { return a.first == name; }),
+        aggregates.end());
+  }
+
+  callDeviceChangeListeners();
+}
+
+juce::StringArray
+AggregateAudioIODeviceType::getMemberNames(const juce::String &name) const {
+  const juce::ScopedLock sl(aggregatesLock);
+
+  for (const auto &aggregate : aggregates)
+    if (aggregate.first == name)
+      return aggregate.second;
+
+  return {};
+}
+
+void AggregateAudioIODeviceType::scanForDevices() {
+  // Aggregates are defined by addAggregate(); members are scanned by their
+  // own types
+}
+
+juce::StringArray
+AggregateAudioIODeviceType::getDeviceNames(bool wantInputNames) const {
+  juce::ignoreUnused(wantInputNames);
+
+  const juce::ScopedLock sl(aggregatesLock);
+
+  juce::StringArray names;
+  for (const auto &aggregate : aggregates)
+    names.add(aggregate.first);
+  return names;
+}
+
+int AggregateAudioIODeviceType::getDefaultDeviceIndex(bool forInput) const {
+  juce::ignoreUnused(forInput);
+
+  // Never chosen as the default device
+  return -1;
+}
+
+int AggregateAudioIODeviceType::getIndexOfDevice(juce::AudioIODevice *device,
+                                                 bool asInput) const {
+  juce::ignoreUnused(asInput);
+
+  if (device == nullptr)
+    return -1;
+
+  return getDeviceNames(true).indexOf(device->getName());
+}
+
+bool AggregateAudioIODeviceType::hasSeparateInputsAndOutputs() const {
+  return false;
+}
+
+juce::AudioIODevice *
+AggregateAudioIODeviceType::createDevice(const juce::String &outputDeviceName,
+                                         const juce::String &inputDeviceName) {
+  const auto name =
+      inputDeviceName.isNotEmpty() ? inputDeviceName : outputDeviceName;
+  const auto memberNames = getMemberNames(name);
+
+  if (memberNames.size() < 2)
+    return nullptr;
+
+  std::vector<std::unique_ptr<juce::AudioIODevice>> memberDevices;
+
+  for (const auto &memberName : memberNames) {
+    auto device = createMemberDevice(memberName);
+
+    if (device == nullptr) {
+      LOG_WARNING("Aggregate member not available: " + memberName);
+      return nullptr;
+    }
+
+    memberDevices.push_back(std::move(device));
+  }
+
+  return new AggregateAudioIODevice(name, std::move(memberDevices));
+}
+
+std::unique_ptr<juce::AudioIODevice>
+AggregateAudioIODeviceType::createMemberDevice(const juce::String &name) {
+  for (auto *type : deviceManager.getAvailableDeviceTypes()) {
+    if (type == this || !type->getDeviceNames(true).contains(name))
+      continue;
+
+    const auto outputName =
+        type->getDeviceNames(false).contains(name) ? name : "";
+    return std::unique_ptr<juce::AudioIODevice>(
+        type->createDevice(outputName, name));
+  }
+
+  return nullptr;
+}
+
+//==============================================================================
+struct AggregateAudioIODevice::Member {
+  juce::String name;
+  std::unique_ptr<juce::AudioIODevice> device;
+  std::unique_ptr<MemberCallback> callback;
+  bool isClockMaster = false;
+
+  // Range of aggregate input channels
+  int firstChannel = 0;
+  int numChannels = 0;
+
+  // Updated from the member's own callback
+  ClockDriftEstimator clock;
+
+  // Written by the member's callback, read by the master's
+  juce::AudioBuffer<float> fifoBuffer;
+  std::unique_ptr<juce::AbstractFifo> fifo;
+  int targetFill = 0;
+  std::atomic<bool> priming{true};
+
+  // Read side, owned by the master's callback
+  juce::AudioBuffer<float> readBuffer;
+  std::vector<juce::CatmullRomInterpolator> resamplers;
+  double smoothedFill = 0.0;
+
+  // Published for getMemberStatus()
+  std::atomic<double> driftPpm{0.0};
+  std::atomic<double> delaySeconds{0.0};
+  std::atomic<int> resyncs{0};
+  metrics::Gauge *driftGauge = nullptr;
+  metrics::Gauge *delayGauge = nullptr;
+};
+
+/** Forwards one member device's callbacks to the aggregate */
+class AggregateAudioIODevice::MemberCallback
+    : public juce::AudioIODeviceCallback {
+public:
+  MemberCallback(AggregateAudioIODevice &aggregate, Member &m)
+      : owner(aggregate), member(m) {}
+
+  void audioDeviceIOCallbackWithContext(
+      const float *const *inputChannelData, int numInputChannels,
+      float *const *outputChannelData, int numOutputChannels, int numSamples,
+      const juce::AudioIODeviceCallbackContext &context) override {
+    member.clock.update(ClockDriftEstimator::now(), numSamples);
+
+    for (int i = 0; i < numOutputChannels; ++i)
+      if (outputChannelData[i] != nullptr)
+        juce::FloatVectorOperations::clear(outputChannelData[i], numSamples);
+
+    if (member.isClockMaster)
+      owner.processMaster(inputChannelData, numInputChannels, numSamples,
+                          context);
+    else
+      owner.processFollower(member, inputChannelData, numInputChannels,
+                            numSamples);
+  }
+
+  void audioDeviceAboutToStart(juce::AudioIODevice *) override {}
+
+  void audioDeviceStopped() override {}
+
+  void audioDeviceError(const juce::String &errorMessage) override {
+    owner.memberError(member.name + ": " + errorMessage);
+  }
+
+private:
+  AggregateAudioIODevice &owner;
+  Member &member;
+};
+
+//==============================================================================
+AggregateAudioIODevice::AggregateAudioIODevice(
+    const juce::String &name,
+    std::vector<std::unique_ptr<juce::AudioIODevice>> memberDevices)
+    : juce::AudioIODevice(name, AggregateAudioIODeviceType::TYPE_NAME) {
+  for (auto &device : memberDevices) {
+    auto member = std::make_unique<Member>();
+    member->name = device->getName();
+    member->device = std::move(device);
+    member->isClockMaster = members.empty();
+    member->callback = std::make_unique<MemberCallback>(*this, *member);
+    members.push_back(std::move(member));
+  }
+}
+
+AggregateAudioIODevice::~AggregateAudioIODevice() { close(); }
+
+juce::StringArray AggregateAudioIODevice::getOutputChannelNames() {
+  return {};
+}
+
+juce::StringArray AggregateAudioIODevice::getInputChannelNames() {
+  juce::StringArray names;
+
+  for (auto &member : members)
+    for (const auto &channel : member->device->getInputChannelNames())
+      names.add(member->name + ": " + channel);
+
+  return names;
+}
+
+juce::Array<double> AggregateAudioIODevice::getAvailableSampleRates() {
+  auto rates = members.front()->device->getAvailableSampleRates();
+
+  for (size_t i = 1; i < members.size(); ++i) {
+    const auto memberRates = members[i]->device->getAvailableSampleRates();
+
+    rates.removeIf([&memberRates](double rate) {
+      for (auto memberRate : memberRates)
+        if (std::abs(memberRate - rate) < 1.0)
+          return false;
+      return true;
+    });
+  }
+
+  return rates;
+}
+
+juce::Array<int> AggregateAudioIODevice::getAvailableBufferSizes() {
+  return members.front()->device->getAvailableBufferSizes();
+}
+
+int AggregateAudioIODevice::getDefaultBufferSize() {
+  return members.front()->device->getDefaultBufferSize();
+}
+
+juce::String AggregateAudioIODevice::open(
+    const juce::BigInteger &inputChannels,
+    const juce::BigInteger &outputChannels, double sampleRate,
+    int bufferSizeSamples) {
+  juce::ignoreUnused(outputChannels);
+  close();
+
+  lastError.clear();
+  activeInputs.clear();
+
+  if (sampleRate <= 0.0)
+    sampleRate = getAvailableSampleRates()[0];
+
+  int deviceChannel = 0;
+  int activeChannel = 0;
+
+  for (auto &member : members) {
+    auto &device = *member->device;
+    const int numDeviceChannels = device.getInputChannelNames().size();
+
+    juce::BigInteger memberInputs;
+    for (int c = 0; c < numDeviceChannels; ++c)
+      memberInputs.setBit(c, inputChannels[deviceChannel + c]);
+
+    // Followers keep their own block size if they can't match the master's
+    int blockSize =
+        member->isClockMaster ? bufferSizeSamples : currentBufferSize;
+    if (!member->isClockMaster &&
+        !device.getAvailableBufferSizes().contains(blockSize))
+      blockSize = device.getDefaultBufferSize();
+
+    auto error = device.open(memberInputs, {}, sampleRate, blockSize);
+
+    if (error.isEmpty() &&
+        std::abs(device.getCurrentSampleRate() - sampleRate) >= 1.0)
+      error = "runs at " + juce::String(device.getCurrentSampleRate()) +
+              " Hz instead of " + juce::String(sampleRate) + " Hz";
+
+    if (error.isNotEmpty()) {
+      lastError = member->name + ": " + error;
+      LOG_ERROR("Cannot open aggregate member " + lastError);
+      close();
+      return lastError;
+    }
+
+    if (member->isClockMaster) {
+      currentSampleRate = device.getCurrentSampleRate();
+      currentBufferSize = device.getCurrentBufferSizeSamples();
+    }
+
+    const auto memberActive = device.getActiveInputChannels();
+    for (int c = 0; c < numDeviceChannels; ++c)
+      if (memberActive[c])
+        activeInputs.setBit(deviceChannel + c);
+
+    member->firstChannel = activeChannel;
+    member->numChannels = memberActive.countNumberOfSetBits();
+    activeChannel += member->numChannels;
+    deviceChannel += numDeviceChannels;
+  }
+
+  // Size the followers' FIFOs and resamplers
+  const int masterChannels = members.front()->numChannels;
+  const int maxReadSamples =
+      (int)std::ceil(currentBufferSize * (1.0 + MAX_RATIO_DEVIATION)) + 2;
+  auto &registry = MetricsRegistry::getInstance();
+
+  for (auto &member : members) {
+    const auto labels =
+        "device=\"" + escapeLabelValue(member->name) + "\"";
+    member->driftGauge = &registry.gauge(
+        "mcam_aggregate_drift_ppm",
+        "Clock drift of an aggregate member relative to the clock master",
+        labels);
+    member->delayGauge = &registry.gauge(
+        "mcam_aggregate_delay_seconds",
+        "Delay added to an aggregate member's channels to align them",
+        labels);
+
+    if (member->isClockMaster)
+      continue;
+
+    const int memberBlock = member->device->getCurrentBufferSizeSamples();
+    member->targetFill =
+        memberBlock + currentBufferSize +
+        juce::roundToInt(currentSampleRate * TARGET_MARGIN_SECONDS);
+
+    const int capacity = member->targetFill * FIFO_CAPACITY_TARGETS;
+    member->fifoBuffer.setSize(member->numChannels, capacity);
+    member->fifo = std::make_unique<juce::AbstractFifo>(capacity);
+    member->readBuffer.setSize(member->numChannels, maxReadSamples);
+    member->resamplers =
+        std::vector<juce::CatmullRomInterpolator>((size_t)member->numChannels);
+
+    LOG_INFO("Aggregate member " + member->name + ": " +
+             juce::String(member->numChannels) + " inputs, block " +
+             juce::String(memberBlock) + ", target delay " +
+             juce::String(1000.0 * member->targetFill / currentSampleRate, 1) +
+             " ms");
+  }
+
+  // One extra, silent channel stands in for missing master inputs
+  followerOutput.setSize(activeChannel - masterChannels + 1,
+                         juce::jmax(1, currentBufferSize));
+  followerOutput.clear();
+  inputPointers.assign((size_t)activeChannel, nullptr);
+
+  deviceOpen = true;
+  return {};
+}
+
+void AggregateAudioIODevice::close() {
+  stop();
+
+  for (auto &member : members)
+    member->device->close();
+
+  deviceOpen = false;
+}
+
+bool AggregateAudioIODevice::isOpen() { return deviceOpen; }
+
+void AggregateAudioIODevice::start(juce::AudioIODeviceCallback *newCallback) {
+  if (!deviceOpen || newCallback == nullptr)
+    return;
+
+  stop();
+  newCallback->audioDeviceAboutToStart(this);
+
+  for (auto &member : members) {
+    member->clock.reset(currentSampleRate);
+    member->priming = true;
+    member->smoothedFill = 0.0;
+
+    if (member->fifo != nullptr)
+      member->fifo->reset();
+  }
+
+  callback = newCallback;
+
+  // Followers first, so their FIFOs are filling when the master starts
+  for (auto it = members.rbegin(); it != members.rend(); ++it)
+    (*it)->device->start((*it)->callback.get());
+
+  playing = true;
+}
+
+void AggregateAudioIODevice::stop() {
+  if (!playing)
+    return;
+
+  // Stopping a device waits for its callback to return, so once the master
+  // has stopped the client is not called again
+  auto *oldCallback = callback.exchange(nullptr);
+
+  for (auto &member : members)
+    member->device->stop();
+
+  playing = false;
+
+  if (oldCallback != nullptr)
+    oldCallback->audioDeviceStopped();
+}
+
+bool AggregateAudioIODevice::isPlaying() { return playing; }
+
+juce::String AggregateAudioIODevice::getLastError() { return lastError; }
+
+int AggregateAudioIODevice::getCurrentBufferSizeSamples() {
+  return currentBufferSize;
+}
+
+double AggregateAudioIODevice::getCurrentSampleRate() {
+  return currentSampleRate;
+}
+
+int AggregateAudioIODevice::getCurrentBitDepth() {
+  return members.front()->device->getCurrentBitDepth();
+}
+
+juce::BigInteger AggregateAudioIODevice::getActiveOutputChannels() const {
+  return {};
+}
+
+juce::BigInteger AggregateAudioIODevice::getActiveInputChannels() const {
+  return activeInputs;
+}
+
+int AggregateAudioIODevice::getOutputLatencyInSamples() { return 0; }
+
+int AggregateAudioIODevice::getInputLatencyInSamples() {
+  return members.front()->device->getInputLatencyInSamples();
+}
+
+int AggregateAudioIODevice::getXRunCount() const noexcept {
+  int xruns = 0;
+
+  for (auto &member : members)
+    xruns += juce::jmax(0, member->device->getXRunCount()) +
+             member->resyncs.load(std::memory_order_relaxed);
+
+  return xruns;
+}
+
+std::vector<AggregateAudioIODevice::MemberStatus>
+AggregateAudioIODevice::getMemberStatus() const {
+  std::vector<MemberStatus> status;
+
+  for (auto &member : members) {
+    MemberStatus s;
+    s.name = member->name;
+    s.firstChannel = member->firstChannel;
+    s.numChannels = member->numChannels;
+    s.isClockMaster = member->isClockMaster;
+    s.measuredSampleRate = member->clock.getSampleRate();
+    s.driftPpm = member->driftPpm;
+    s.delaySeconds = member->delaySeconds;
+    s.resyncs = member->resyncs;
+    status.push_back(s);
+  }
+
+  return status;
+}
+
+void AggregateAudioIODevice::processMaster(
+    const float *const *inputChannelData, int numInputChannels,
+    int numSamples, const juce::AudioIODeviceCallbackContext &context) {
+  auto *client = callback.load(std::memory_order_acquire);
+  if (client == nullptr)
+    return;
+
+  const int masterChannels = members.front()->numChannels;
+  const int maxBlock = followerOutput.getNumSamples();
+  const float *silence = followerOutput.getReadPointer(
+      followerOutput.getNumChannels() - 1);
+
+  // A master block longer than it was opened with is passed on in pieces
+  for (int pos = 0; pos < numSamples; pos += maxBlock) {
+    const int blockSize = juce::jmin(maxBlock, numSamples - pos);
+
+    for (int c = 0; c < masterChannels; ++c)
+      inputPointers[(size_t)c] =
+          c < numInputChannels && inputChannelData[c] != nullptr
+              ? inputChannelData[c] + pos
+              : silence;
+
+    for (size_t i = 1; i < members.size(); ++i)
+      pullFollower(*members[i], blockSize);
+
+    client->audioDeviceIOCallbackWithContext(
+        inputPointers.data(), (int)inputPointers.size(), nullptr, 0,
+        blockSize, context);
+  }
+}
+
+void AggregateAudioIODevice::processFollower(
+    Member &member, const float *const *inputChannelData,
+    int numInputChannels, int numSamples) {
+  auto &fifo = *member.fifo;
+
+  int start1, size1, start2, size2;
+  fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+  for (int c = 0; c < member.fifoBuffer.getNumChannels(); ++c) {
+    if (c < numInputChannels && inputChannelData[c] != nullptr) {
+      if (size1 > 0)
+        member.fifoBuffer.copyFrom(c, start1, inputChannelData[c], size1);
+      if (size2 > 0)
+        member.fifoBuffer.copyFrom(c, start2, inputChannelData[c] + size1,
+                                   size2);
+    } else {
+      if (size1 > 0)
+        member.fifoBuffer.clear(c, start1, size1);
+      if (size2 > 0)
+        member.fifoBuffer.clear(c, start2, size2);
+    }
+  }
+
+  fifo.finishedWrite(size1 + size2);
+
+  // Full: the master stopped reading, or this clock is far off
+  if (size1 + size2 < numSamples && !member.priming)
+    ++member.resyncs;
+}
+
+void AggregateAudioIODevice::pullFollower(Member &member, int numSamples) {
+  auto &fifo = *member.fifo;
+  const auto &master = *members.front();
+  const int outputChannel = member.firstChannel - master.numChannels;
+  int available = fifo.getNumReady();
+
+  const auto outputSilence = [&] {
+    for (int c = 0; c < member.numChannels; ++c) {
+      followerOutput.clear(outputChannel + c, 0, numSamples);
+      inputPointers[(size_t)(member.firstChannel + c)] =
+          followerOutput.getReadPointer(outputChannel + c);
+    }
+  };
+
+  if (member.priming) {
+    if (available < member.targetFill) {
+      outputSilence();
+      return;
+    }
+
+    // Start reading at the target fill
+    fifo.finishedRead(available - member.targetFill);
+    available = member.targetFill;
+
+    for (auto &resampler : member.resamplers)
+      resampler.reset();
+
+    member.smoothedFill = member.targetFill;
+    member.priming = false;
+  }
+
+  // Relative drift from the callback timestamps, trimmed to hold the fill
+  double drift = 1.0;
+  if (member.clock.getNumUpdates() >= MIN_CLOCK_UPDATES &&
+      master.clock.getNumUpdates() >= MIN_CLOCK_UPDATES)
+    drift = member.clock.getSampleRate() / master.clock.getSampleRate();
+
+  const double fillError =
+      (member.smoothedFill - member.targetFill) / currentSampleRate;
+  const double trim = juce::jlimit(-MAX_SERVO_TRIM, MAX_SERVO_TRIM,
+                                   fillError / SERVO_SECONDS);
+  const double ratio =
+      juce::jlimit(1.0 - MAX_RATIO_DEVIATION, 1.0 + MAX_RATIO_DEVIATION,
+                   drift * (1.0 + trim));
+
+  const int needed = juce::jmin((int)std::ceil(numSamples * ratio) + 2,
+                                member.readBuffer.getNumSamples());
+
+  if (available < needed) {
+    // Ran dry: output silence and refill to the target
+    ++member.resyncs;
+    member.priming = true;
+    outputSilence();
+    return;
+  }
+
+  int start1, size1, start2, size2;
+  fifo.prepareToRead(needed, start1, size1, start2, size2);
+
+  int consumed = 0;
+
+  for (int c = 0; c < member.numChannels; ++c) {
+    member.readBuffer.copyFrom(c, 0, member.fifoBuffer, c, start1, size1);
+    if (size2 > 0)
+      member.readBuffer.copyFrom(c, size1, member.fifoBuffer, c, start2,
+                                 size2);
+
+    consumed = member.resamplers[(size_t)c].process(
+        ratio, member.readBuffer.getReadPointer(c),
+        followerOutput.getWritePointer(outputChannel + c), numSamples,
+        size1 + size2, 0);
+
+    inputPointers[(size_t)(member.firstChannel + c)] =
+        followerOutput.getReadPointer(outputChannel + c);
+  }
+
+  fifo.finishedRead(consumed);
+
+  // Publish the drift and the delay the FIFO adds
+  const double alpha = 1.0 - std::exp(-numSamples / (currentSampleRate *
+                                                     FILL_SMOOTHING_SECONDS));
+  member.smoothedFill += alpha * ((available - consumed) - member.smoothedFill);
+
+  const double delay = member.smoothedFill / currentSampleRate;
+  const double ppm = (drift - 1.0) * 1.0e6;
+  member.driftPpm.store(ppm, std::memory_order_relaxed);
+  member.delaySeconds.store(delay, std::memory_order_relaxed);
+  member.driftGauge->set(ppm);
+  member.delayGauge->set(delay);
+}
+
+void AggregateAudioIODevice::memberError(const juce::String &errorMessage) {
+  if (auto *client = callback.load(std::memory_order_acquire))
+    client->audioDeviceError(errorMessage);
+}
+
+} // namespace mcam
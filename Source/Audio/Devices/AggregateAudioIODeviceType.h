@@ -0,0 +1,203 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../Core/Metrics.h"
+#include "../../JuceHeader.h"
+#include "ClockDriftEstimator.h"
+
+namespace mcam {
+/**
+ * AggregateAudioIODeviceType provides devices that combine several other
+ * devices (e.g. a MADI card and a USB interface) into one channel space.
+ *
+ * Aggregates are defined by the names of their member devices, which may
+ * belong to any other device type. The aggregate's inputs are the members'
+ * inputs in order. Selecting an aggregate opens every member.
+ */
+class AggregateAudioIODeviceType : public juce::AudioIODeviceType {
+public:
+  /** Name of the device type as shown in the device manager */
+  static constexpr const char *TYPE_NAME = "MCAM Aggregate";
+
+  /**
+   * Constructor
+   * @param deviceManager Manager whose other device types provide the members
+   */
+  explicit AggregateAudioIODeviceType(juce::AudioDeviceManager &deviceManager);
+
+  /** Destructor */
+  ~AggregateAudioIODeviceType() override;
+
+  /**
+   * Defines an aggregate, or replaces the one with the same members
+   * @param memberNames Member device names; the first is the clock master
+   * @return The aggregate's device name, or an empty string if fewer than
+   * two distinct members were given
+   */
+  juce::String addAggregate(const juce::StringArray &memberNames);
+
+  /**
+   * Removes an aggregate definition; an open aggregate keeps running
+   * @param name The aggregate's device name
+   */
+  void removeAggregate(const juce::String &name);
+
+  /**
+   * @param name The aggregate's device name
+   * @return Member device names, or an empty array if unknown
+   */
+  juce::StringArray getMemberNames(const juce::String &name) const;
+
+  /** juce::AudioIODeviceType implementation */
+  void scanForDevices() override;
+  juce::StringArray getDeviceNames(bool wantInputNames) const override;
+  int getDefaultDeviceIndex(bool forInput) const override;
+  int getIndexOfDevice(juce::AudioIODevice *device,
+                       bool asInput) const override;
+  bool hasSeparateInputsAndOutputs() const override;
+  juce::AudioIODevice *
+  createDevice(const juce::String &outputDeviceName,
+               const juce::String &inputDeviceName) override;
+
+private:
+  /**
+   * Creates a member device through whichever type lists it
+   * @return The device, or nullptr if no type lists it
+   */
+  std::unique_ptr<juce::AudioIODevice>
+  createMemberDevice(const juce::String &name);
+
+  juce::AudioDeviceManager &deviceManager;
+
+  // Aggregate name -> member names, guarded by aggregatesLock as the device
+  // catalog reads it from its thread
+  std::vector<std::pair<juce::String, juce::StringArray>> aggregates;
+  mutable juce::CriticalSection aggregatesLock;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AggregateAudioIODeviceType)
+};
+
+/**
+ * AggregateAudioIODevice runs several devices as one.
+ *
+ * Each member keeps its own driver and callback thread. The first member is
+ * the clock master: the aggregate's callback runs on its thread at its block
+ * size. Every other member writes into a lock-free FIFO from its own
+ * callback, and the master's callback reads each FIFO through an adaptive
+ * resampler. The resampling ratio is the members' relative drift, estimated
+ * from callback timestamps, trimmed so the FIFO stays at its target fill.
+ * The FIFO is the delay a member's channels gain relative to the master's,
+ * and it is reported per member.
+ *
+ * Members must run at the same nominal sample rate. No locks are taken in
+ * any member's callback.
+ */
+class AggregateAudioIODevice : public juce::AudioIODevice {
+public:
+  /** State of one member, for display and logging */
+  struct MemberStatus {
+    juce::String name;
+
+    /** First aggregate input channel and number of active inputs */
+    int firstChannel = 0;
+    int numChannels = 0;
+
+    /** The member whose clock the aggregate follows */
+    bool isClockMaster = false;
+
+    /** Sample rate measured against the system clock */
+    double measuredSampleRate = 0.0;
+
+    /** Clock drift relative to the master in ppm */
+    double driftPpm = 0.0;
+
+    /** Delay added to this member's channels to align them, in seconds */
+    double delaySeconds = 0.0;
+
+    /** Times the FIFO ran empty or full and had to be refilled */
+    int resyncs = 0;
+  };
+
+  /**
+   * Constructor
+   * @param name Aggregate device name
+   * @param memberDevices Member devices, clock master first
+   */
+  AggregateAudioIODevice(
+      const juce::String &name,
+      std::vector<std::unique_ptr<juce::AudioIODevice>> memberDevices);
+
+  /** Destructor */
+  ~AggregateAudioIODevice() override;
+
+  /** juce::AudioIODevice implementation */
+  juce::StringArray getOutputChannelNames() override;
+  juce::StringArray getInputChannelNames() override;
+  juce::Array<double> getAvailableSampleRates() override;
+  juce::Array<int> getAvailableBufferSizes() override;
+  int getDefaultBufferSize() override;
+  juce::String open(const juce::BigInteger &inputChannels,
+                    const juce::BigInteger &outputChannels, double sampleRate,
+                    int bufferSizeSamples) override;
+  void close() override;
+  bool isOpen() override;
+  void start(juce::AudioIODeviceCallback *callback) override;
+  void stop() override;
+  bool isPlaying() override;
+  juce::String getLastError() override;
+  int getCurrentBufferSizeSamples() override;
+  double getCurrentSampleRate() override;
+  int getCurrentBitDepth() override;
+  juce::BigInteger getActiveOutputChannels() const override;
+  juce::BigInteger getActiveInputChannels() const override;
+  int getOutputLatencyInSamples() override;
+  int getInputLatencyInSamples() override;
+
+  /** Xruns reported by the members plus FIFO resyncs */
+  int getXRunCount() const noexcept override;
+
+  /** @return The state of each member, clock master first */
+  std::vector<MemberStatus> getMemberStatus() const;
+
+private:
+  struct Member;
+  class MemberCallback;
+
+  /** Master callback: pulls every follower and runs the client callback */
+  void processMaster(const float *const *inputChannelData,
+                     int numInputChannels, int numSamples,
+                     const juce::AudioIODeviceCallbackContext &context);
+
+  /** Follower callback: pushes the block into the member's FIFO */
+  void processFollower(Member &member, const float *const *inputChannelData,
+                       int numInputChannels, int numSamples);
+
+  /** Resamples numSamples from a follower's FIFO into its output channels */
+  void pullFollower(Member &member, int numSamples);
+
+  /** Passes a member's error on to the client */
+  void memberError(const juce::String &errorMessage);
+
+  std::vector<std::unique_ptr<Member>> members;
+
+  // Open state
+  bool deviceOpen = false;
+  juce::String lastError;
+  double currentSampleRate = 0.0;
+  int currentBufferSize = 0;
+  juce::BigInteger activeInputs;
+
+  // Channel pointers handed to the client, master channels first
+  std::vector<const float *> inputPointers;
+
+  // Resampled follower channels for the current block
+  juce::AudioBuffer<float> followerOutput;
+
+  // Client callback; swapped without a lock, see stop()
+  std::atomic<juce::AudioIODeviceCallback *> callback{nullptr};
+  bool playing = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AggregateAudioIODevice)
+};
+
+} // namespace mcam
@@ -2,43 +2,87 @@
 
 namespace mcam {
 
-AudioDeviceManager::AudioDeviceManager() {
+namespace {
+// Inputs a hardware device opens with when the user selected none
+constexpr int DEFAULT_INPUT_CHANNELS = 2;
+} // namespace
+
+AudioDeviceManager::AudioDeviceManager()
+    : threadTuning(ThreadTuning::getInstance()) {
   LOG_INFO("Initializing AudioDeviceManager");
+  registerMetrics();
 }
 
 AudioDeviceManager::~AudioDeviceManager() {
   LOG_INFO("Shutting down AudioDeviceManager");
 
+  // Stop scanning before the device types go away
+  catalog = nullptr;
+
   // Ensure we cleanup the device manager
   deviceManager.removeAudioCallback(this);
   deviceManager.closeAudioDevice();
+
+  // Detach scrape-time providers that reference this object
+  auto &registry = MetricsRegistry::getInstance();
+  registry.gauge("mcam_device_sample_rate_hz", {}).setProvider(nullptr);
+  registry.gauge("mcam_device_buffer_size_samples", {}).setProvider(nullptr);
+  registry.gauge("mcam_device_input_channels", {}).setProvider(nullptr);
 }
 
 bool AudioDeviceManager::initialize() {
   LOG_INFO("Initializing audio device system");
 
+  // Create the platform types first so they keep their default priority,
+  // then add the native JACK client, the virtual devices and aggregates of
+  // any of them after them
+  deviceManager.getAvailableDeviceTypes();
+
+  deviceManager.addAudioDeviceType(std::make_unique<JackAudioIODeviceType>());
+
+  auto virtualType = std::make_unique<VirtualAudioIODeviceType>();
+  virtualDeviceType = virtualType.get();
+  deviceManager.addAudioDeviceType(std::move(virtualType));
+
+  auto aggregateType =
+      std::make_unique<AggregateAudioIODeviceType>(deviceManager);
+  aggregateDeviceType = aggregateType.get();
+  deviceManager.addAudioDeviceType(std::move(aggregateType));
+
+  // Cached devices are listed straight away; scanning starts once the
+  // default device is open
+  catalog = std::make_unique<DeviceCatalog>(deviceManager, driverLock,
+                                            deviceCacheFile);
+
   // Initialize the device manager with default device
-  juce::String err = deviceManager.initialiseWithDefaultDevices(2, 2);
+  juce::String err;
+  {
+    const juce::ScopedLock dl(driverLock);
+    err = deviceManager.initialiseWithDefaultDevices(DEFAULT_INPUT_CHANNELS, 2);
+  }
 
-  if (err.isNotEmpty()) {
-    LOG_ERROR("Failed to initialize audio device: " + err);
-    return false;
+  if (err.isNotEmpty() || deviceManager.getCurrentAudioDevice() == nullptr) {
+    // No usable hardware (e.g. a CI machine): fall back to a virtual device
+    LOG_WARNING("No hardware audio device available" +
+                (err.isNotEmpty() ? ": " + err : juce::String()) +
+                "; using a virtual device");
+
+    const auto names = virtualDeviceType->getDeviceNames(true);
+
+    if (names.isEmpty() || !setAudioDevice(names[0])) {
+      LOG_ERROR("Failed to initialize audio device: " + err);
+      return false;
+    }
   }
 
+  catalog->start();
+
   // Add ourselves as an audio callback
   deviceManager.addAudioCallback(this);
 
   // Store current device info
   if (auto *device = deviceManager.getCurrentAudioDevice()) {
-    currentDeviceName = device->getName();
-    numInputChannels = device->getActiveInputChannels().countNumberOfSetBits();
-    sampleRate = device->getCurrentSampleRate();
-    bufferSize = device->getCurrentBufferSizeSamples();
-
-    LOG_INFO("Audio device initialized: " + currentDeviceName +
-             " (Inputs: " + juce::String(numInputChannels) +
-             ", Sample Rate: " + juce::String(sampleRate) +
-             ", Buffer Size: " + juce::String(bufferSize) + ")");
+    updateDeviceInfo(device, "initialized");
   } else {
     LOG_WARNING("No audio device available after initialization");
   }
@@ -46,58 +90,232 @@ bool AudioDeviceManager::initialize() {
   return true;
 }
 
+void AudioDeviceManager::setDeviceCacheFile(const juce::File &file) {
+  jassert(catalog == nullptr);
+  deviceCacheFile = file;
+}
+
 juce::StringArray AudioDeviceManager::getAvailableDeviceNames() const {
-  // For const-correctness, we need to cache this information at initialization
-  // time since JUCE's deviceManager.getAvailableDeviceTypes() isn't a const
-  // method
-  juce::StringArray deviceNames;
+  return catalog != nullptr ? catalog->getDeviceNames() : juce::StringArray();
+}
+
+DeviceCatalog *AudioDeviceManager::getDeviceCatalog() { return catalog.get(); }
+
+VirtualAudioIODeviceType *AudioDeviceManager::getVirtualDeviceType() {
+  return virtualDeviceType;
+}
+
+juce::String AudioDeviceManager::createAggregateDevice(
+    const juce::StringArray &memberNames) {
+  if (aggregateDeviceType == nullptr) {
+    LOG_ERROR("Audio device system not initialized");
+    return {};
+  }
+
+  juce::String name;
+  {
+    const juce::ScopedLock dl(driverLock);
+    name = aggregateDeviceType->addAggregate(memberNames);
+  }
+
+  if (name.isNotEmpty())
+    refreshDeviceList();
+
+  return name;
+}
+
+std::vector<AggregateAudioIODevice::MemberStatus>
+AudioDeviceManager::getAggregateStatus() const {
+  if (auto *aggregate = dynamic_cast<AggregateAudioIODevice *>(
+          deviceManager.getCurrentAudioDevice()))
+    return aggregate->getMemberStatus();
 
-  // In a real implementation, this would use cached device names
-  // For now, just return any current device and an empty list otherwise
-  if (currentDeviceName.isNotEmpty())
-    deviceNames.add(currentDeviceName);
+  return {};
+}
+
+void AudioDeviceManager::refreshDeviceList() {
+  if (catalog != nullptr)
+    catalog->refresh();
+}
+
+bool AudioDeviceManager::setAudioDevice(const juce::String &deviceName,
+                                        double newSampleRate,
+                                        int newBufferSize) {
+  PreparedSwitch prepared;
 
-  return deviceNames;
+  if (!prepareSwitch(deviceName, newSampleRate, newBufferSize, prepared))
+    return false;
+
+  return completeSwitch(prepared);
 }
 
-bool AudioDeviceManager::setAudioDevice(const juce::String &deviceName) {
+bool AudioDeviceManager::prepareSwitch(const juce::String &deviceName,
+                                       double newSampleRate,
+                                       int newBufferSize,
+                                       PreparedSwitch &prepared) {
   LOG_INFO("Setting audio device: " + deviceName);
 
-  // Create a device setup with this name
+  if (catalog == nullptr) {
+    LOG_ERROR("Audio device system not initialized");
+    return false;
+  }
+
+  DeviceCatalog::DeviceInfo info;
+  if (!catalog->getDeviceInfo(deviceName, info)) {
+    // The device may have been plugged in since the last scan
+    catalog->scanNow();
+
+    if (!catalog->getDeviceInfo(deviceName, info)) {
+      LOG_ERROR("Unknown audio device: " + deviceName);
+      return false;
+    }
+  }
+
+  prepared = {};
+  prepared.deviceName = deviceName;
+  prepared.typeName = info.typeName;
+
+  {
+    const juce::ScopedLock dl(driverLock);
+
+    juce::AudioDeviceManager::AudioDeviceSetup setup;
+    deviceManager.getAudioDeviceSetup(setup);
+
+    prepared.sampleRate =
+        newSampleRate > 0.0 ? newSampleRate : setup.sampleRate;
+    prepared.bufferSize =
+        newBufferSize > 0 ? newBufferSize : setup.bufferSize;
+
+    // The inputs completeSwitch() will open
+    if (opensAllInputs(info.typeName)) {
+      prepared.numInputChannels = juce::jmin(
+          info.numInputChannels, VirtualAudioIODeviceType::MAX_CHANNELS);
+    } else {
+      const bool fromAllInputs =
+          opensAllInputs(deviceManager.getCurrentAudioDeviceType());
+      const bool useDefault = fromAllInputs
+                                  ? hardwareUsesDefaultInputs
+                                  : setup.useDefaultInputChannels;
+      auto inputs =
+          fromAllInputs ? hardwareInputChannels : setup.inputChannels;
+      inputs.setRange(info.numInputChannels,
+                      juce::jmax(0, inputs.getHighestBit() + 1 -
+                                        info.numInputChannels),
+                      false);
+
+      prepared.numInputChannels =
+          useDefault ? juce::jmin(DEFAULT_INPUT_CHANNELS, info.numInputChannels)
+                     : inputs.countNumberOfSetBits();
+    }
+  }
+
+  const juce::ScopedLock sl(callbackLock);
+
+  // Keep callbacks prepared while the old device closes, so their state
+  // survives if the new device runs the same format
+  switchInProgress = true;
+  switchTarget = deviceName;
+
+  // The old device keeps running without consumers until it closes, so
+  // the callbacks can be prepared while nothing feeds them
+  publishCallbacks(false);
+
+  if (prepared.sampleRate > 0.0 && prepared.bufferSize > 0 &&
+      prepared.numInputChannels > 0) {
+    for (auto *callback : audioCallbacks)
+      if (auto *audioCallback = dynamic_cast<AudioCallback *>(callback))
+        audioCallback->prepareForFormat(prepared.sampleRate,
+                                        prepared.bufferSize,
+                                        prepared.numInputChannels);
+  }
+
+  return true;
+}
+
+bool AudioDeviceManager::completeSwitch(const PreparedSwitch &prepared) {
+  const juce::ScopedLock dl(driverLock);
+
+  // Remember the user's input selection while a hardware device is open
   juce::AudioDeviceManager::AudioDeviceSetup setup;
   deviceManager.getAudioDeviceSetup(setup);
+  const bool wasOpeningAllInputs =
+      opensAllInputs(deviceManager.getCurrentAudioDeviceType());
+
+  if (deviceManager.getCurrentAudioDevice() != nullptr &&
+      !wasOpeningAllInputs) {
+    hardwareInputChannels = setup.inputChannels;
+    hardwareUsesDefaultInputs = setup.useDefaultInputChannels;
+  }
 
-  setup.inputDeviceName = deviceName;
-  setup.outputDeviceName = deviceName;
+  // Switch type first if the device belongs to a different one
+  if (prepared.typeName.isNotEmpty() &&
+      prepared.typeName != deviceManager.getCurrentAudioDeviceType()) {
+    deviceManager.setCurrentAudioDeviceType(prepared.typeName, true);
+    deviceManager.getAudioDeviceSetup(setup);
+  }
+
+  setup.inputDeviceName = prepared.deviceName;
+  setup.outputDeviceName = prepared.deviceName;
+
+  // The format the callbacks were prepared for, also across a type switch
+  if (prepared.sampleRate > 0.0)
+    setup.sampleRate = prepared.sampleRate;
+
+  if (prepared.bufferSize > 0)
+    setup.bufferSize = prepared.bufferSize;
+
+  if (opensAllInputs(deviceManager.getCurrentAudioDeviceType())) {
+    // Monitor every channel the virtual or aggregate device has
+    setup.useDefaultInputChannels = false;
+    setup.inputChannels.clear();
+    setup.inputChannels.setRange(0, VirtualAudioIODeviceType::MAX_CHANNELS,
+                                 true);
+  } else if (wasOpeningAllInputs) {
+    // Hardware keeps the user's selection rather than the forced one
+    setup.inputChannels = hardwareInputChannels;
+    setup.useDefaultInputChannels = hardwareUsesDefaultInputs;
+  }
 
-  // Try to set up the device
   juce::String error = deviceManager.setAudioDeviceSetup(setup, true);
 
-  if (error.isNotEmpty()) {
+  {
+    const juce::ScopedLock sl(callbackLock);
+    switchInProgress = false;
+    switchTarget.clear();
+  }
+
+  auto *device = deviceManager.getCurrentAudioDevice();
+
+  if (error.isNotEmpty() || device == nullptr ||
+      device->getName() != prepared.deviceName) {
+    if (device == nullptr) {
+      // Nothing is running now: let the callbacks release
+      audioDeviceStopped();
+    } else {
+      // Another device is left running: hand it the callbacks again
+      audioDeviceAboutToStart(device);
+    }
+
     LOG_ERROR("Failed to set audio device: " + error);
     return false;
   }
 
   // Update device properties
-  if (auto *device = deviceManager.getCurrentAudioDevice()) {
-    currentDeviceName = device->getName();
-    numInputChannels = device->getActiveInputChannels().countNumberOfSetBits();
-    sampleRate = device->getCurrentSampleRate();
-    bufferSize = device->getCurrentBufferSizeSamples();
-
-    LOG_INFO("Audio device changed: " + currentDeviceName +
-             " (Inputs: " + juce::String(numInputChannels) +
-             ", Sample Rate: " + juce::String(sampleRate) +
-             ", Buffer Size: " + juce::String(bufferSize) + ")");
+  updateDeviceInfo(device, "changed");
+  return true;
+}
 
-    return true;
-  }
+bool AudioDeviceManager::opensAllInputs(const juce::String &typeName) {
+  return typeName == VirtualAudioIODeviceType::TYPE_NAME ||
+         typeName == AggregateAudioIODeviceType::TYPE_NAME;
+}
 
-  LOG_ERROR("Failed to change audio device");
-  return false;
+juce::AudioIODevice *AudioDeviceManager::getCurrentAudioDevice() const {
+  return deviceManager.getCurrentAudioDevice();
 }
 
 juce::String AudioDeviceManager::getCurrentDeviceName() const {
+  const juce::ScopedLock sl(deviceInfoLock);
   return currentDeviceName;
 }
 
@@ -117,9 +335,13 @@ void AudioDeviceManager::addAudioCallback(
       LOG_INFO("Adding audio callback");
       audioCallbacks.add(callback);
 
-      // If audio is running, notify the new callback
-      if (auto *device = deviceManager.getCurrentAudioDevice()) {
-        callback->audioDeviceAboutToStart(device);
+      // If audio is running, prepare the new callback and start feeding it;
+      // during a switch the new device's start does both
+      if (auto *device = activeDevice.load()) {
+        if (!switchInProgress) {
+          callback->audioDeviceAboutToStart(device);
+          publishCallbacks(true);
+        }
       }
     }
   }
@@ -134,16 +356,42 @@ void AudioDeviceManager::removeAudioCallback(
 
     // Notify callback that audio is stopped (if it was running)
     if (audioCallbacks.contains(callback)) {
-      callback->audioDeviceStopped();
       audioCallbacks.removeFirstMatchingValue(callback);
+
+      // Once this returns the audio thread no longer runs the callback
+      if (liveCallbacks.load() != nullptr)
+        publishCallbacks(true);
+
+      callback->audioDeviceStopped();
     }
   }
 }
 
+void AudioDeviceManager::publishCallbacks(bool attach) {
+  std::unique_ptr<CallbackList> next;
+
+  if (attach)
+    next = std::make_unique<CallbackList>(audioCallbacks);
+
+  liveCallbacks.store(next.get());
+
+  // The audio thread may still be running the old set for one block
+  while (audioThreadsInCallbacks.load() > 0)
+    juce::Thread::yield();
+
+  liveCallbacksStorage = std::move(next);
+}
+
 void AudioDeviceManager::audioDeviceIOCallbackWithContext(
     const float *const *inputChannelData, int numInputChannels,
     float *const *outputChannelData, int numOutputChannels, int numSamples,
     const juce::AudioIODeviceCallbackContext &context) {
+  const RealtimeGuard::ScopedRealtime realtime;
+  const auto startTicks = juce::Time::getHighResolutionTicks();
+
+  // Whichever thread the driver calls from takes the audio settings
+  threadTuning.applyToCurrentThread(ThreadTuning::ThreadClass::audio);
+
   // First, clear output buffers
   for (int i = 0; i < numOutputChannels; ++i) {
     if (outputChannelData[i] != nullptr) {
@@ -151,44 +399,77 @@ void AudioDeviceManager::audioDeviceIOCallbackWithContext(
     }
   }
 
-  // Forward callback to registered listeners
-  const juce::ScopedLock sl(callbackLock);
+  // Forward callback to the published listeners; publishCallbacks() waits
+  // for the count to drop before freeing a set
+  audioThreadsInCallbacks.fetch_add(1);
 
-  for (auto *callback : audioCallbacks) {
-    callback->audioDeviceIOCallbackWithContext(
-        inputChannelData, numInputChannels, outputChannelData,
-        numOutputChannels, numSamples, context);
+  if (const auto *callbacks = liveCallbacks.load()) {
+    for (auto *callback : *callbacks) {
+      callback->audioDeviceIOCallbackWithContext(
+          inputChannelData, numInputChannels, outputChannelData,
+          numOutputChannels, numSamples, context);
+    }
   }
+
+  audioThreadsInCallbacks.fetch_sub(1);
+
+  // Instrumentation: wait-free per-thread counters only
+  const double elapsed = MetricsRegistry::ticksToSeconds(
+      juce::Time::getHighResolutionTicks() - startTicks);
+
+  callbacksProcessed->add();
+  callbackTime->observe(elapsed);
+
+  const double rate = sampleRate.load(std::memory_order_relaxed);
+  if (rate > 0.0 && elapsed > numSamples / rate)
+    callbackOverruns->add();
+
+  if (auto *device = activeDevice.load(std::memory_order_relaxed))
+    deviceXRuns->set((double)juce::jmax(0, device->getXRunCount()));
 }
 
 void AudioDeviceManager::audioDeviceAboutToStart(juce::AudioIODevice *device) {
+  activeDevice = device;
+
   if (device != nullptr) {
-    // Update device properties
-    currentDeviceName = device->getName();
-    numInputChannels = device->getActiveInputChannels().countNumberOfSetBits();
-    sampleRate = device->getCurrentSampleRate();
-    bufferSize = device->getCurrentBufferSizeSamples();
+    const juce::ScopedLock sl(callbackLock);
 
-    LOG_INFO("Audio device starting: " + currentDeviceName +
-             " (Inputs: " + juce::String(numInputChannels) +
-             ", Sample Rate: " + juce::String(sampleRate) +
-             ", Buffer Size: " + juce::String(bufferSize) + ")");
+    // A type switch opens the new type's default device first; the
+    // callbacks are kept for the device being switched to
+    if (switchInProgress && device->getName() != switchTarget) {
+      LOG_INFO("Skipping " + device->getName() + " during a device switch");
+      return;
+    }
 
-    // Forward to callbacks
-    const juce::ScopedLock sl(callbackLock);
+    // Update device properties
+    updateDeviceInfo(device, "starting");
 
+    // Callbacks prepared by prepareSwitch() keep their state here
     for (auto *callback : audioCallbacks) {
       callback->audioDeviceAboutToStart(device);
     }
+
+    publishCallbacks(true);
+
+    // The callbacks' buffers are allocated now
+    threadTuning.lockMemory();
   }
 }
 
 void AudioDeviceManager::audioDeviceStopped() {
-  LOG_INFO("Audio device stopped");
+  activeDevice = nullptr;
 
-  // Forward to callbacks
   const juce::ScopedLock sl(callbackLock);
+  publishCallbacks(false);
+
+  if (switchInProgress) {
+    LOG_INFO("Audio device stopped for a device switch");
+    return;
+  }
 
+  LOG_INFO("Audio device stopped");
+
+  // Forward to callbacks
   for (auto *callback : audioCallbacks) {
     callback->audioDeviceStopped();
   }
@@ -205,4 +486,48 @@ void AudioDeviceManager::audioDeviceError(const juce::String &errorMessage) {
   }
 }
 
+void AudioDeviceManager::updateDeviceInfo(juce::AudioIODevice *device,
+                                          const juce::String &event) {
+  {
+    const juce::ScopedLock sl(deviceInfoLock);
+    currentDeviceName = device->getName();
+  }
+
+  numInputChannels = device->getActiveInputChannels().countNumberOfSetBits();
+  sampleRate = device->getCurrentSampleRate();
+  bufferSize = device->getCurrentBufferSizeSamples();
+
+  LOG_INFO("Audio device " + event + ": " + device->getName() +
+           " (Inputs: " + juce::String(numInputChannels.load()) +
+           ", Sample Rate: " + juce::String(sampleRate.load()) +
+           ", Buffer Size: " + juce::String(bufferSize.load()) + ")");
+}
+
+void AudioDeviceManager::registerMetrics() {
+  auto &registry = MetricsRegistry::getInstance();
+
+  callbacksProcessed =
+      &registry.counter("mcam_audio_callbacks_total",
+                        "Audio device callbacks processed");
+  callbackOverruns = &registry.counter(
+      "mcam_audio_callback_overruns_total",
+      "Callbacks that took longer than the buffer duration");
+  callbackTime = &registry.histogram(
+      "mcam_audio_callback_seconds", "Time spent in the audio callback",
+      {0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02,
+       0.05});
+  deviceXRuns = &registry.gauge("mcam_device_xruns",
+                                "Xruns reported by the current audio device");
+
+  registry.gauge("mcam_device_sample_rate_hz", "Current device sample rate")
+      .setProvider([this] { return sampleRate.load(); });
+  registry
+      .gauge("mcam_device_buffer_size_samples", "Current device buffer size")
+      .setProvider([this] { return (double)bufferSize.load(); });
+  registry
+      .gauge("mcam_device_input_channels",
+             "Active input channels on the current device")
+      .setProvider([this] { return (double)numInputChannels.load(); });
+}
+
 } // namespace mcam
@@ -1,7 +1,15 @@
 #pragma once
 
 #include "../../Core/Logger.h"
+#include "../../Core/Metrics.h"
+#include "../../Core/RealtimeGuard.h"
+#include "../../Core/ThreadTuning.h"
 #include "../../JuceHeader.h"
+#include "../AudioCallback.h"
+#include "AggregateAudioIODeviceType.h"
+#include "DeviceCatalog.h"
+#include "JackAudioIODeviceType.h"
+#include "VirtualAudioIODeviceType.h"
 
 namespace mcam {
 /**
@@ -10,6 +18,17 @@ namespace mcam {
  */
 class AudioDeviceManager : private juce::AudioIODeviceCallback {
 public:
+  /** A device switch resolved by prepareSwitch(), opened by completeSwitch() */
+  struct PreparedSwitch {
+    juce::String deviceName;
+    juce::String typeName;
+
+    /** Format the callbacks were prepared for (0 = left to the device) */
+    double sampleRate = 0.0;
+    int bufferSize = 0;
+    int numInputChannels = 0;
+  };
+
   /** Constructor */
   AudioDeviceManager();
 
@@ -17,23 +36,102 @@ public:
   ~AudioDeviceManager() override;
 
   /**
-   * Initializes the audio device system and scans for available devices
+   * Sets the file the device catalog is persisted in. Call before
+   * initialize(); an empty file disables persistence.
+   * @param file Cache file (defaults to DeviceCatalog::getDefaultCacheFile())
+   */
+  void setDeviceCacheFile(const juce::File &file);
+
+  /**
+   * Initializes the audio device system and opens the default device.
+   * Other devices are enumerated in the background.
    * @return true if initialization was successful
    */
   bool initialize();
 
   /**
-   * Gets a list of available audio devices
+   * Gets a list of available audio devices, across all device types. Does
+   * not block: returns the cached list, which may still be filling.
    * @return StringArray of device names
    */
   juce::StringArray getAvailableDeviceNames() const;
 
   /**
-   * Sets the current audio device
+   * Gets the device catalog, e.g. to look up device capabilities or listen
+   * for device list changes
+   * @return The catalog, or nullptr before initialize()
+   */
+  DeviceCatalog *getDeviceCatalog();
+
+  /**
+   * Gets the virtual device type, e.g. to add file-backed devices.
+   * Call refreshDeviceList() afterwards to make new devices selectable.
+   * @return The virtual device type, or nullptr before initialize()
+   */
+  VirtualAudioIODeviceType *getVirtualDeviceType();
+
+  /**
+   * Defines a device that runs several devices together as one channel
+   * space, e.g. a MADI card and a USB interface. Select it with
+   * setAudioDevice() like any other device.
+   * @param memberNames Member device names; the first is the clock master
+   * @return The aggregate's device name, or an empty string on failure
+   */
+  juce::String createAggregateDevice(const juce::StringArray &memberNames);
+
+  /**
+   * Gets the per-member drift and delay of the open aggregate device
+   * @return One entry per member, or an empty vector if no aggregate is open
+   */
+  std::vector<AggregateAudioIODevice::MemberStatus> getAggregateStatus() const;
+
+  /** Schedules a rescan of all device types in the background */
+  void refreshDeviceList();
+
+  /**
+   * Sets the current audio device, switching device type if needed. All
+   * input channels of virtual and aggregate devices are enabled. Blocks
+   * while the driver reopens. Runs prepareSwitch() and completeSwitch() on
+   * the calling thread; use DeviceSwitcher to switch from the message
+   * thread without blocking it.
    * @param deviceName Name of the device to set active
+   * @param newSampleRate Sample rate to open with (0 = keep current)
+   * @param newBufferSize Buffer size to open with (0 = keep current)
    * @return true if device was set successfully
    */
-  bool setAudioDevice(const juce::String &deviceName);
+  bool setAudioDevice(const juce::String &deviceName,
+                      double newSampleRate = 0.0, int newBufferSize = 0);
+
+  /**
+   * First half of a device switch, for a control thread. Looks the device
+   * up (scanning if needed), stops feeding the callbacks and prepares them
+   * for the format the device will open with, so nothing is prepared when
+   * it starts. Must be followed by completeSwitch().
+   * @param deviceName Name of the device to switch to
+   * @param newSampleRate Sample rate to open with (0 = keep current)
+   * @param newBufferSize Buffer size to open with (0 = keep current)
+   * @param prepared Receives the resolved switch
+   * @return false if the device is unknown; nothing is changed then
+   */
+  bool prepareSwitch(const juce::String &deviceName, double newSampleRate,
+                     int newBufferSize, PreparedSwitch &prepared);
+
+  /**
+   * Second half of a device switch: closes the old device and opens the new
+   * one. Call on the message thread, which JUCE expects driver calls on.
+   * The callbacks prepared by prepareSwitch() are handed to the new
+   * device's audio thread in one atomic swap when it starts; if it opens
+   * with a different format they are prepared again then.
+   * @param prepared The switch returned by prepareSwitch()
+   * @return true if the device was opened
+   */
+  bool completeSwitch(const PreparedSwitch &prepared);
+
+  /**
+   * Gets the open audio device, e.g. to use JACK port routing
+   * @return The device, or nullptr if none is open
+   */
+  juce::AudioIODevice *getCurrentAudioDevice() const;
 
   /**
    * Gets the current audio device name
@@ -82,21 +180,87 @@ private:
   void audioDeviceStopped() override;
   void audioDeviceError(const juce::String &errorMessage) override;
 
+  /**
+   * Replaces the callbacks the audio thread runs with a copy of
+   * audioCallbacks, or with none, and waits until the audio thread has
+   * left the old set (callbackLock)
+   * @param attach true to run the registered callbacks, false for none
+   */
+  void publishCallbacks(bool attach);
+
+  /** Stores and logs the properties of a device */
+  void updateDeviceInfo(juce::AudioIODevice *device, const juce::String &event);
+
+  /** Registers engine and device metrics with the MetricsRegistry */
+  void registerMetrics();
+
+  /**
+   * @return true for the virtual and aggregate types, whose devices are
+   * opened with every input so their whole channel space is monitored
+   */
+  static bool opensAllInputs(const juce::String &typeName);
+
   // The JUCE audio device manager
   juce::AudioDeviceManager deviceManager;
 
-  // Registered callbacks
-  juce::Array<juce::AudioIODeviceCallback *> audioCallbacks;
+  // Owned by deviceManager
+  VirtualAudioIODeviceType *virtualDeviceType = nullptr;
+  AggregateAudioIODeviceType *aggregateDeviceType = nullptr;
+
+  // Held around calls into device types, which the catalog makes from its
+  // own thread
+  juce::CriticalSection driverLock;
+
+  // Background device enumeration (destroyed before deviceManager)
+  juce::File deviceCacheFile = DeviceCatalog::getDefaultCacheFile();
+  std::unique_ptr<DeviceCatalog> catalog;
+
+  using CallbackList = juce::Array<juce::AudioIODeviceCallback *>;
+
+  // Registered callbacks (callbackLock)
+  CallbackList audioCallbacks;
+
+  // The callbacks the audio thread runs: an immutable copy of audioCallbacks
+  // published by publishCallbacks(), or nullptr while detached. The audio
+  // thread takes no lock; it counts itself in while running the set.
+  std::atomic<const CallbackList *> liveCallbacks{nullptr};
+  std::unique_ptr<CallbackList> liveCallbacksStorage;
+  std::atomic<int> audioThreadsInCallbacks{0};
 
-  // Current device properties
+  // Current device properties, written by whichever thread opens devices
   juce::String currentDeviceName;
-  int numInputChannels = 0;
-  double sampleRate = 0.0;
-  int bufferSize = 0;
+  mutable juce::CriticalSection deviceInfoLock;
+  std::atomic<int> numInputChannels{0};
+  std::atomic<double> sampleRate{0.0};
+  std::atomic<int> bufferSize{0};
 
-  // Mutex for thread safety when handling callbacks
+  // Set from prepareSwitch() to the end of completeSwitch(); devices other
+  // than the target opened in between (a type's default device) are not
+  // handed the callbacks
+  std::atomic<bool> switchInProgress{false};
+  juce::String switchTarget; // callbackLock
+
+  // Input selection of the last hardware device, restored when switching
+  // back from a device opened with every input (driverLock)
+  juce::BigInteger hardwareInputChannels;
+  bool hardwareUsesDefaultInputs = true;
+
+  // Serialises changes to the callbacks; never taken by the audio thread
   juce::CriticalSection callbackLock;
 
+  // Device whose callbacks are currently running (for xrun counts)
+  std::atomic<juce::AudioIODevice *> activeDevice{nullptr};
+
+  // Created before the first callback, which applies the audio thread's
+  // settings
+  ThreadTuning &threadTuning;
+
+  // Instrumentation, updated from the audio thread
+  metrics::Counter *callbacksProcessed = nullptr;
+  metrics::Counter *callbackOverruns = nullptr;
+  metrics::Histogram *callbackTime = nullptr;
+  metrics::Gauge *deviceXRuns = nullptr;
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioDeviceManager)
 };
 
@@ -0,0 +1,73 @@
+#include "ClockDriftEstimator.h"
+
+namespace mcam {
+
+namespace {
+// Bandwidth in the first second; narrows as 2 / (elapsed + 2)
+constexpr double INITIAL_BANDWIDTH_HZ = 1.0;
+
+// Keeps the loop stable for long callback periods
+constexpr double MAX_LOOP_OMEGA = 0.3;
+
+// A callback further than this from its prediction (a stall or xrun)
+// restarts the prediction without touching the period estimate
+constexpr double RESTART_ERROR_SECONDS = 0.1;
+} // namespace
+
+ClockDriftEstimator::ClockDriftEstimator() { reset(nominalRate); }
+
+void ClockDriftEstimator::reset(double nominalSampleRate) {
+  nominalRate = nominalSampleRate > 0.0 ? nominalSampleRate : 48000.0;
+  secondsPerSample = 1.0 / nominalRate;
+  predictedTime = 0.0;
+  elapsed = 0.0;
+  sampleRate = nominalRate;
+  numUpdates = 0;
+}
+
+void ClockDriftEstimator::update(double timeSeconds, int numSamples) {
+  if (numSamples <= 0)
+    return;
+
+  const double period = numSamples * secondsPerSample;
+  const int count = numUpdates.load(std::memory_order_relaxed);
+  numUpdates.store(count + 1, std::memory_order_relaxed);
+
+  if (count == 0) {
+    predictedTime = timeSeconds + period;
+    return;
+  }
+
+  const double error = timeSeconds - predictedTime;
+
+  if (std::abs(error) > RESTART_ERROR_SECONDS) {
+    predictedTime = timeSeconds + period;
+    return;
+  }
+
+  elapsed += period;
+  const double bandwidth = juce::jmax(
+      MIN_BANDWIDTH_HZ, INITIAL_BANDWIDTH_HZ * 2.0 / (elapsed + 2.0));
+  const double omega = juce::jmin(
+      MAX_LOOP_OMEGA, juce::MathConstants<double>::twoPi * bandwidth * period);
+
+  predictedTime += juce::MathConstants<double>::sqrt2 * omega * error + period;
+  secondsPerSample += omega * omega * error / numSamples;
+
+  sampleRate.store(1.0 / secondsPerSample, std::memory_order_relaxed);
+}
+
+double ClockDriftEstimator::getSampleRate() const {
+  return sampleRate.load(std::memory_order_relaxed);
+}
+
+int ClockDriftEstimator::getNumUpdates() const {
+  return numUpdates.load(std::memory_order_relaxed);
+}
+
+double ClockDriftEstimator::now() {
+  return juce::Time::highResolutionTicksToSeconds(
+      juce::Time::getHighResolutionTicks());
+}
+
+} // namespace mcam
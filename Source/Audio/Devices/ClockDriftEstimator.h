@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * ClockDriftEstimator measures the true sample rate of a device against the
+ * system clock from the times its callbacks arrive.
+ *
+ * A second-order delay-locked loop predicts when each callback is due and
+ * corrects its period estimate by the prediction error, which filters out
+ * scheduling jitter. The loop starts wide so it locks within a second or
+ * two, then narrows to resolve drift of a few ppm. Comparing the estimates
+ * of two devices gives their relative drift.
+ *
+ * update() is called from one thread (the device's callback); the estimate
+ * can be read from any thread.
+ */
+class ClockDriftEstimator {
+public:
+  /** Narrowest loop bandwidth, reached after about 40 s */
+  static constexpr double MIN_BANDWIDTH_HZ = 0.05;
+
+  /** Constructor */
+  ClockDriftEstimator();
+
+  /**
+   * Starts a new measurement
+   * @param nominalSampleRate Rate the device was opened at
+   */
+  void reset(double nominalSampleRate);
+
+  /**
+   * Feeds one callback
+   * @param timeSeconds System time the callback arrived
+   * @param numSamples Samples the callback delivered
+   */
+  void update(double timeSeconds, int numSamples);
+
+  /** @return Estimated sample rate in Hz against the system clock */
+  double getSampleRate() const;
+
+  /** @return Callbacks fed since reset() */
+  int getNumUpdates() const;
+
+  /** @return System time in seconds, as used for timeSeconds */
+  static double now();
+
+private:
+  double nominalRate = 48000.0;
+
+  // Loop state, owned by the updating thread
+  double secondsPerSample = 1.0 / 48000.0;
+  double predictedTime = 0.0;
+  double elapsed = 0.0;
+
+  // Published estimate
+  std::atomic<double> sampleRate{48000.0};
+  std::atomic<int> numUpdates{0};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ClockDriftEstimator)
+};
+
+} // namespace mcam
@@ -0,0 +1,326 @@
+#include "DeviceCatalog.h"
+
+namespace mcam {
+
+namespace {
+constexpr int CACHE_VERSION = 2;
+
+// Stands in for driver versions, which device types do not report
+juce::String getSystemKey() {
+  return juce::SystemStats::getOperatingSystemName();
+}
+
+bool sameCapabilities(const DeviceCatalog::DeviceInfo &a,
+                      const DeviceCatalog::DeviceInfo &b) {
+  return a.name == b.name && a.typeName == b.typeName &&
+         a.numInputChannels == b.numInputChannels &&
+         a.numOutputChannels == b.numOutputChannels &&
+         a.sampleRates == b.sampleRates && a.bufferSizes == b.bufferSizes &&
+         a.isPresent == b.isPresent;
+}
+} // namespace
+
+DeviceCatalog::DeviceCatalog(juce::AudioDeviceManager &manager,
+                             juce::CriticalSection &lock,
+                             const juce::File &file)
+    : juce::Thread("MCAM Device Catalog"), deviceManager(manager),
+      driverLock(lock), cacheFile(file),
+      scanTime(MetricsRegistry::getInstance().histogram(
+          "mcam_device_scan_seconds", "Time to enumerate all audio devices",
+          {0.01, 0.05, 0.1, 0.25, 0.5, 1.0, 2.0, 5.0, 10.0})),
+      devicesKnown(MetricsRegistry::getInstance().gauge(
+          "mcam_devices_known", "Audio devices in the device catalog")) {
+  loadCache();
+}
+
+DeviceCatalog::~DeviceCatalog() {
+  for (auto *type : watchedTypes)
+    type->removeListener(this);
+
+  cancelPendingUpdate();
+
+  // A driver call cannot be interrupted, so wait for it
+  signalThreadShouldExit();
+  notify();
+  stopThread(30000);
+}
+
+void DeviceCatalog::start() {
+  for (auto *type : deviceManager.getAvailableDeviceTypes()) {
+    type->addListener(this);
+    watchedTypes.add(type);
+  }
+
+  startThread(juce::Thread::Priority::low);
+}
+
+void DeviceCatalog::refresh() { notify(); }
+
+void DeviceCatalog::scanNow() { scan(); }
+
+juce::StringArray DeviceCatalog::getDeviceNames() const {
+  const juce::ScopedLock sl(devicesLock);
+
+  juce::StringArray names;
+  for (const auto &device : devices)
+    names.add(device.name);
+  return names;
+}
+
+bool DeviceCatalog::getDeviceInfo(const juce::String &name,
+                                  DeviceInfo &info) const {
+  const juce::ScopedLock sl(devicesLock);
+
+  for (const auto &device : devices) {
+    if (device.name == name) {
+      info = device;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+juce::File DeviceCatalog::getDefaultCacheFile() {
+  auto dir =
+      juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory);
+
+#if JUCE_MAC
+  dir = dir.getChildFile("Application Support");
+#endif
+
+  return dir.getChildFile("MCAM").getChildFile("DeviceCache.json");
+}
+
+void DeviceCatalog::addListener(Listener *listener) {
+  listeners.add(listener);
+}
+
+void DeviceCatalog::removeListener(Listener *listener) {
+  listeners.remove(listener);
+}
+
+void DeviceCatalog::run() {
+  auto &threadTuning = ThreadTuning::getInstance();
+
+  while (!threadShouldExit()) {
+    threadTuning.applyToCurrentThread(ThreadTuning::ThreadClass::background);
+    scan();
+    wait(RESCAN_INTERVAL_MS);
+  }
+}
+
+void DeviceCatalog::handleAsyncUpdate() {
+  listeners.call([](Listener &listener) { listener.deviceListChanged(); });
+}
+
+void DeviceCatalog::audioDeviceListChanged() {
+  LOG_DEBUG("Audio device list changed; rescanning");
+  refresh();
+}
+
+bool DeviceCatalog::scan() {
+  const juce::ScopedLock scanSl(scanLock);
+  const auto startTicks = juce::Time::getHighResolutionTicks();
+
+  std::vector<DeviceInfo> found;
+  juce::StringArray foundNames;
+  int numProbed = 0;
+  bool refreshedAged = false;
+
+  for (auto *type : deviceManager.getAvailableDeviceTypes()) {
+    juce::StringArray names;
+    {
+      const juce::ScopedLock dl(driverLock);
+      type->scanForDevices();
+      names = type->getDeviceNames(true);
+    }
+
+    for (const auto &name : names) {
+      if (foundNames.contains(name))
+        continue;
+
+      // Devices already probed (this session or a previous one) keep their
+      // cached capabilities
+      DeviceInfo info;
+      const bool cached = getDeviceInfo(name, info) &&
+                          info.typeName == type->getTypeName();
+
+      if (!cached || needsProbe(info)) {
+        // Fresh probe times of aged entries must reach the cache even if
+        // the capabilities are unchanged
+        if (cached && !info.sampleRates.isEmpty())
+          refreshedAged = true;
+
+        info = {};
+        info.name = name;
+        info.typeName = type->getTypeName();
+        probe(*type, info);
+        ++numProbed;
+      }
+
+      info.isPresent = true;
+      found.push_back(info);
+      foundNames.add(name);
+    }
+  }
+
+  bool changed = false;
+  {
+    const juce::ScopedLock sl(devicesLock);
+
+    changed = refreshedAged || found.size() != devices.size();
+    for (size_t i = 0; !changed && i < found.size(); ++i)
+      changed = !sameCapabilities(found[i], devices[i]);
+
+    devices = std::move(found);
+  }
+
+  const double elapsed = MetricsRegistry::ticksToSeconds(
+      juce::Time::getHighResolutionTicks() - startTicks);
+  scanTime.observe(elapsed);
+  devicesKnown.set((double)foundNames.size());
+  ++scanCount;
+
+  if (changed) {
+    LOG_INFO("Found " + juce::String(foundNames.size()) +
+             " audio device(s), probed " + juce::String(numProbed) + " in " +
+             juce::String(elapsed * 1000.0, 0) + " ms");
+    saveCache();
+    triggerAsyncUpdate();
+  }
+
+  return changed;
+}
+
+bool DeviceCatalog::needsProbe(const DeviceInfo &info) {
+  const auto maxAge = juce::RelativeTime::days(CACHE_MAX_AGE_DAYS);
+  const auto age = juce::Time::getCurrentTime() - juce::Time(info.probeTimeMs);
+
+  return info.sampleRates.isEmpty() || age > maxAge ||
+         age < juce::RelativeTime();
+}
+
+void DeviceCatalog::probe(juce::AudioIODeviceType &type, DeviceInfo &info) {
+  const juce::ScopedLock dl(driverLock);
+  info.probeTimeMs = juce::Time::currentTimeMillis();
+
+  // Don't open a second instance of the running device
+  if (auto *current = deviceManager.getCurrentAudioDevice()) {
+    if (current->getName() == info.name &&
+        current->getTypeName() == info.typeName) {
+      info.numInputChannels = current->getInputChannelNames().size();
+      info.numOutputChannels = current->getOutputChannelNames().size();
+      info.sampleRates = current->getAvailableSampleRates();
+      info.bufferSizes = current->getAvailableBufferSizes();
+      return;
+    }
+  }
+
+  const auto outputName =
+      type.getDeviceNames(false).contains(info.name) ? info.name : "";
+  std::unique_ptr<juce::AudioIODevice> device(
+      type.createDevice(outputName, info.name));
+
+  if (device == nullptr) {
+    LOG_WARNING("Could not probe audio device: " + info.name);
+    return;
+  }
+
+  info.numInputChannels = device->getInputChannelNames().size();
+  info.numOutputChannels = device->getOutputChannelNames().size();
+  info.sampleRates = device->getAvailableSampleRates();
+  info.bufferSizes = device->getAvailableBufferSizes();
+}
+
+void DeviceCatalog::loadCache() {
+  if (cacheFile == juce::File() || !cacheFile.existsAsFile())
+    return;
+
+  const auto root = juce::JSON::parse(cacheFile);
+
+  if ((int)root.getProperty("version", 0) != CACHE_VERSION) {
+    LOG_WARNING("Ignoring device cache with unknown version: " +
+                cacheFile.getFullPathName());
+    return;
+  }
+
+  if (root.getProperty("system", {}).toString() != getSystemKey()) {
+    LOG_INFO("Ignoring device cache written on another system version");
+    return;
+  }
+
+  std::vector<DeviceInfo> loaded;
+
+  if (auto *entries = root["devices"].getArray()) {
+    for (const auto &entry : *entries) {
+      DeviceInfo info;
+      info.name = entry["name"].toString();
+      info.typeName = entry["type"].toString();
+      info.numInputChannels = entry["inputs"];
+      info.numOutputChannels = entry["outputs"];
+      info.probeTimeMs = (juce::int64)entry["probeTime"];
+
+      if (auto *rates = entry["sampleRates"].getArray())
+        for (const auto &rate : *rates)
+          info.sampleRates.add((double)rate);
+
+      if (auto *sizes = entry["bufferSizes"].getArray())
+        for (const auto &size : *sizes)
+          info.bufferSizes.add((int)size);
+
+      if (info.name.isNotEmpty())
+        loaded.push_back(info);
+    }
+  }
+
+  LOG_INFO("Loaded " + juce::String((int)loaded.size()) +
+           " cached audio device(s)");
+
+  const juce::ScopedLock sl(devicesLock);
+  devices = std::move(loaded);
+}
+
+void DeviceCatalog::saveCache() const {
+  if (cacheFile == juce::File())
+    return;
+
+  juce::Array<juce::var> entries;
+  {
+    const juce::ScopedLock sl(devicesLock);
+
+    for (const auto &device : devices) {
+      auto *entry = new juce::DynamicObject();
+      entry->setProperty("name", device.name);
+      entry->setProperty("type", device.typeName);
+      entry->setProperty("inputs", device.numInputChannels);
+      entry->setProperty("outputs", device.numOutputChannels);
+      entry->setProperty("probeTime", device.probeTimeMs);
+
+      juce::Array<juce::var> rates;
+      for (auto rate : device.sampleRates)
+        rates.add(rate);
+      entry->setProperty("sampleRates", rates);
+
+      juce::Array<juce::var> sizes;
+      for (auto size : device.bufferSizes)
+        sizes.add(size);
+      entry->setProperty("bufferSizes", sizes);
+
+      entries.add(juce::var(entry));
+    }
+  }
+
+  auto *root = new juce::DynamicObject();
+  root->setProperty("version", CACHE_VERSION);
+  root->setProperty("system", getSystemKey());
+  root->setProperty("devices", entries);
+
+  cacheFile.getParentDirectory().createDirectory();
+
+  if (!cacheFile.replaceWithText(juce::JSON::toString(juce::var(root))))
+    LOG_WARNING("Could not write device cache: " +
+                cacheFile.getFullPathName());
+}
+
+} // namespace mcam
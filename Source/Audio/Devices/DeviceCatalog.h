@@ -0,0 +1,160 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../Core/Metrics.h"
+#include "../../Core/ThreadTuning.h"
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * DeviceCatalog enumerates the devices of every audio device type on a
+ * background thread and caches their capabilities.
+ *
+ * The cache is loaded from disk on construction, so device names are
+ * available immediately, and is written back whenever a scan changes it.
+ * Later scans only probe devices that are new or whose cached capabilities
+ * are older than CACHE_MAX_AGE_DAYS; devices that have gone away are
+ * dropped. Drivers do not report their versions, so a cache written on
+ * another operating system version is discarded as a whole, since driver
+ * updates usually come with one. A scan runs when a device type reports a
+ * change, when
+ * refresh() is called and at a fixed interval for types that do not report
+ * changes. Listeners are told about changes on the message thread.
+ */
+class DeviceCatalog : private juce::Thread,
+                      private juce::AsyncUpdater,
+                      private juce::AudioIODeviceType::Listener {
+public:
+  /** What is known about one device */
+  struct DeviceInfo {
+    juce::String name;
+    juce::String typeName;
+    int numInputChannels = 0;
+    int numOutputChannels = 0;
+    juce::Array<double> sampleRates;
+    juce::Array<int> bufferSizes;
+
+    /** When the capabilities were probed (ms since 1970; 0 = never) */
+    juce::int64 probeTimeMs = 0;
+
+    /** true once the device has been seen in this session's scans */
+    bool isPresent = false;
+  };
+
+  /** Receives device list changes on the message thread */
+  class Listener {
+  public:
+    virtual ~Listener() = default;
+
+    /** Called after a scan added, removed or updated devices */
+    virtual void deviceListChanged() = 0;
+  };
+
+  /** Time between scans when no type reports a change */
+  static constexpr int RESCAN_INTERVAL_MS = 30000;
+
+  /** Age after which cached capabilities are probed again */
+  static constexpr int CACHE_MAX_AGE_DAYS = 7;
+
+  /**
+   * Constructor. Loads the cache; no scanning happens until start().
+   * @param deviceManager Manager owning the device types; must outlive this
+   * @param driverLock Held around every call into a device type
+   * @param cacheFile File to persist the cache in (none if empty)
+   */
+  DeviceCatalog(juce::AudioDeviceManager &deviceManager,
+                juce::CriticalSection &driverLock,
+                const juce::File &cacheFile);
+
+  /** Destructor; waits for a running scan to finish */
+  ~DeviceCatalog() override;
+
+  /**
+   * Starts watching the device types and begins the first scan in the
+   * background. Call once the device types have been created.
+   */
+  void start();
+
+  /** Schedules a scan in the background and returns immediately */
+  void refresh();
+
+  /**
+   * Scans all device types on the calling thread. Waits for a background
+   * scan that is already running.
+   */
+  void scanNow();
+
+  /** @return Names of all known devices, in device type order */
+  juce::StringArray getDeviceNames() const;
+
+  /**
+   * Looks up a device
+   * @param name Device name
+   * @param info Receives the device's details
+   * @return true if the device is known
+   */
+  bool getDeviceInfo(const juce::String &name, DeviceInfo &info) const;
+
+  /** @return Number of completed scans (for tests) */
+  int getScanCount() const { return scanCount; }
+
+  /** @return Default location of the cache file */
+  static juce::File getDefaultCacheFile();
+
+  /** Adds a listener (message thread) */
+  void addListener(Listener *listener);
+
+  /** Removes a listener (message thread) */
+  void removeListener(Listener *listener);
+
+private:
+  /** Background scanning thread */
+  void run() override;
+
+  /** Delivers a list change to listeners */
+  void handleAsyncUpdate() override;
+
+  /** juce::AudioIODeviceType::Listener implementation */
+  void audioDeviceListChanged() override;
+
+  /**
+   * Scans every device type, probing only devices not yet in the cache
+   * @return true if the cache changed
+   */
+  bool scan();
+
+  /** @return true if a cached device must be probed again */
+  static bool needsProbe(const DeviceInfo &info);
+
+  /** Fills in the capabilities of a device by creating it unopened */
+  void probe(juce::AudioIODeviceType &type, DeviceInfo &info);
+
+  /** Reads the cache file into devices */
+  void loadCache();
+
+  /** Writes devices to the cache file */
+  void saveCache() const;
+
+  juce::AudioDeviceManager &deviceManager;
+  juce::CriticalSection &driverLock;
+  const juce::File cacheFile;
+
+  // Known devices, guarded by devicesLock
+  mutable juce::CriticalSection devicesLock;
+  std::vector<DeviceInfo> devices;
+
+  // Serialises scans from the background thread and scanNow()
+  juce::CriticalSection scanLock;
+
+  std::atomic<int> scanCount{0};
+  juce::Array<juce::AudioIODeviceType *> watchedTypes;
+  juce::ListenerList<Listener> listeners;
+
+  // Instrumentation
+  metrics::Histogram &scanTime;
+  metrics::Gauge &devicesKnown;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeviceCatalog)
+};
+
+} // namespace mcam
@@ -0,0 +1,187 @@
+#include "DeviceSwitcher.h"
+
+namespace mcam {
+
+DeviceSwitcher::DeviceSwitcher(AudioDeviceManager &manager)
+    : juce::Thread("MCAM Device Switcher"), deviceManager(manager),
+      switchesCompleted(MetricsRegistry::getInstance().counter(
+          "mcam_device_switches_total", "Audio device switches",
+          "result=\"completed\"")),
+      switchesFailed(MetricsRegistry::getInstance().counter(
+          "mcam_device_switches_total", "Audio device switches",
+          "result=\"failed\"")),
+      switchTime(MetricsRegistry::getInstance().histogram(
+          "mcam_device_switch_seconds", "Time to close and reopen a device",
+          {0.05, 0.1, 0.25, 0.5, 1.0, 2.0, 5.0, 10.0})) {
+  startThread(juce::Thread::Priority::normal);
+}
+
+DeviceSwitcher::~DeviceSwitcher() {
+  signalThreadShouldExit();
+  notify();
+
+  // A driver call cannot be interrupted, so wait for it, carrying out a
+  // driver step the control thread is waiting for here
+  while (isThreadRunning()) {
+    if (juce::MessageManager::existsAndIsCurrentThread())
+      runPendingDriverStep();
+
+    juce::Thread::sleep(5);
+  }
+
+  cancelPendingUpdate();
+}
+
+void DeviceSwitcher::requestSwitch(const juce::String &deviceName,
+                                   double sampleRate, int bufferSize) {
+  LOG_INFO("Device switch requested: " + deviceName);
+
+  {
+    const juce::ScopedLock sl(requestLock);
+    pendingRequest.reset(new Request{deviceName, sampleRate, bufferSize});
+    busy = true;
+  }
+
+  notify();
+}
+
+bool DeviceSwitcher::isSwitching() const { return busy; }
+
+DeviceSwitcher::Status DeviceSwitcher::getStatus() const {
+  const juce::ScopedLock sl(statusLock);
+  return status;
+}
+
+bool DeviceSwitcher::waitUntilIdle(int timeoutMs) {
+  const auto deadline =
+      juce::Time::getMillisecondCounter() + (juce::uint32)timeoutMs;
+
+  while (busy) {
+    if (juce::Time::getMillisecondCounter() >= deadline)
+      return false;
+
+    // The switch would otherwise wait for this thread
+    if (juce::MessageManager::existsAndIsCurrentThread())
+      runPendingDriverStep();
+
+    juce::Thread::sleep(5);
+  }
+
+  return true;
+}
+
+void DeviceSwitcher::addListener(Listener *listener) {
+  listeners.add(listener);
+}
+
+void DeviceSwitcher::removeListener(Listener *listener) {
+  listeners.remove(listener);
+}
+
+void DeviceSwitcher::run() {
+  auto &threadTuning = ThreadTuning::getInstance();
+
+  while (!threadShouldExit()) {
+    threadTuning.applyToCurrentThread(ThreadTuning::ThreadClass::background);
+
+    std::unique_ptr<Request> request;
+
+    {
+      const juce::ScopedLock sl(requestLock);
+      request = std::move(pendingRequest);
+
+      if (request == nullptr)
+        busy = false;
+    }
+
+    if (request == nullptr) {
+      wait(-1);
+      continue;
+    }
+
+    Status switching;
+    switching.state = State::Switching;
+    switching.deviceName = request->deviceName;
+    setStatus(switching);
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    AudioDeviceManager::PreparedSwitch prepared;
+    const bool ok =
+        deviceManager.prepareSwitch(request->deviceName, request->sampleRate,
+                                    request->bufferSize, prepared) &&
+        completeOnMessageThread(prepared);
+    const double elapsed = MetricsRegistry::ticksToSeconds(
+        juce::Time::getHighResolutionTicks() - startTicks);
+
+    Status result;
+    result.elapsedSeconds = elapsed;
+    switchTime.observe(elapsed);
+
+    if (ok) {
+      result.state = State::Completed;
+      result.deviceName = deviceManager.getCurrentDeviceName();
+      result.numInputChannels = deviceManager.getNumInputChannels();
+      switchesCompleted.add();
+
+      LOG_INFO("Device switch to " + result.deviceName + " took " +
+               juce::String(elapsed * 1000.0, 0) + " ms");
+    } else {
+      result.state = State::Failed;
+      result.deviceName = request->deviceName;
+      result.error = "Could not open " + request->deviceName;
+      switchesFailed.add();
+    }
+
+    setStatus(result);
+  }
+}
+
+bool DeviceSwitcher::completeOnMessageThread(
+    const AudioDeviceManager::PreparedSwitch &prepared) {
+  // Headless there is no message loop to wait for
+  if (juce::MessageManager::getInstanceWithoutCreating() == nullptr)
+    return deviceManager.completeSwitch(prepared);
+
+  {
+    const juce::ScopedLock sl(driverStepLock);
+    pendingDriverStep = &prepared;
+    driverStepDone.reset();
+  }
+
+  triggerAsyncUpdate();
+  driverStepDone.wait(-1);
+
+  const juce::ScopedLock sl(driverStepLock);
+  return driverStepResult;
+}
+
+void DeviceSwitcher::runPendingDriverStep() {
+  const juce::ScopedLock sl(driverStepLock);
+
+  if (pendingDriverStep == nullptr)
+    return;
+
+  driverStepResult = deviceManager.completeSwitch(*pendingDriverStep);
+  pendingDriverStep = nullptr;
+  driverStepDone.signal();
+}
+
+void DeviceSwitcher::setStatus(const Status &newStatus) {
+  {
+    const juce::ScopedLock sl(statusLock);
+    status = newStatus;
+  }
+
+  triggerAsyncUpdate();
+}
+
+void DeviceSwitcher::handleAsyncUpdate() {
+  runPendingDriverStep();
+
+  const auto current = getStatus();
+  listeners.call([&current](Listener &listener) {
+    listener.deviceSwitchStatusChanged(current);
+  });
+}
+
+} // namespace mcam
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../Core/Metrics.h"
+#include "../../Core/ThreadTuning.h"
+#include "../../JuceHeader.h"
+#include "AudioDeviceManager.h"
+
+namespace mcam {
+/**
+ * DeviceSwitcher changes the audio device without the message thread
+ * waiting for device lookups, scans or callback preparation.
+ *
+ * A background control thread resolves the device and prepares the
+ * callbacks for the new format (AudioDeviceManager::prepareSwitch()). Only
+ * the driver calls that close the old device and open the new one run on
+ * the message thread, as JUCE requires (AudioDeviceManager::
+ * completeSwitch()); without a MessageManager, e.g. in tests and headless
+ * tools, they run on the control thread.
+ *
+ * Requests are coalesced: if several arrive while a switch is running, only
+ * the latest is carried out afterwards. Status changes are delivered to
+ * listeners on the message thread.
+ */
+class DeviceSwitcher : private juce::Thread, private juce::AsyncUpdater {
+public:
+  /** Progress of the current or last switch */
+  enum class State { Idle, Switching, Completed, Failed };
+
+  /** Snapshot of the switcher's progress */
+  struct Status {
+    State state = State::Idle;
+
+    /** Device being switched to, or the device switched to */
+    juce::String deviceName;
+
+    /** Error from the device manager (Failed only) */
+    juce::String error;
+
+    /** Duration of the switch (Completed and Failed only) */
+    double elapsedSeconds = 0.0;
+
+    /** Inputs of the new device (Completed only) */
+    int numInputChannels = 0;
+  };
+
+  /** Receives status changes on the message thread */
+  class Listener {
+  public:
+    virtual ~Listener() = default;
+
+    /** Called when a switch starts, completes or fails */
+    virtual void deviceSwitchStatusChanged(const Status &status) = 0;
+  };
+
+  /**
+   * Constructor
+   * @param deviceManager Device manager to switch; must outlive this object
+   */
+  explicit DeviceSwitcher(AudioDeviceManager &deviceManager);
+
+  /** Destructor; waits for a running switch to finish */
+  ~DeviceSwitcher() override;
+
+  /**
+   * Queues a device switch and returns immediately
+   * @param deviceName Name of the device to open
+   * @param sampleRate Sample rate to open with (0 = keep current)
+   * @param bufferSize Buffer size to open with (0 = keep current)
+   */
+  void requestSwitch(const juce::String &deviceName, double sampleRate = 0.0,
+                     int bufferSize = 0);
+
+  /** @return true while a switch is queued or running */
+  bool isSwitching() const;
+
+  /** @return The current status */
+  Status getStatus() const;
+
+  /**
+   * Blocks until no switch is queued or running. On the message thread the
+   * driver step of a running switch is carried out while waiting.
+   * @param timeoutMs Maximum wait in milliseconds
+   * @return true if idle, false on timeout
+   */
+  bool waitUntilIdle(int timeoutMs);
+
+  /** Adds a listener (message thread) */
+  void addListener(Listener *listener);
+
+  /** Removes a listener (message thread) */
+  void removeListener(Listener *listener);
+
+private:
+  /** A queued switch */
+  struct Request {
+    juce::String deviceName;
+    double sampleRate = 0.0;
+    int bufferSize = 0;
+  };
+
+  /** Control thread */
+  void run() override;
+
+  /** Runs a waiting driver step, then delivers the latest status */
+  void handleAsyncUpdate() override;
+
+  /**
+   * Has the message thread open the prepared device and waits for it
+   * (control thread)
+   * @return The result of AudioDeviceManager::completeSwitch()
+   */
+  bool completeOnMessageThread(
+      const AudioDeviceManager::PreparedSwitch &prepared);
+
+  /** Carries out the driver step the control thread waits for, if any */
+  void runPendingDriverStep();
+
+  /** Stores a status and schedules its delivery */
+  void setStatus(const Status &newStatus);
+
+  AudioDeviceManager &deviceManager;
+
+  // Latest request, taken by the control thread
+  juce::CriticalSection requestLock;
+  std::unique_ptr<Request> pendingRequest;
+  std::atomic<bool> busy{false};
+
+  // Driver step handed from the control thread to the message thread
+  juce::CriticalSection driverStepLock;
+  const AudioDeviceManager::PreparedSwitch *pendingDriverStep = nullptr;
+  bool driverStepResult = false;
+  juce::WaitableEvent driverStepDone;
+
+  // Status shared with the message thread
+  mutable juce::CriticalSection statusLock;
+  Status status;
+
+  juce::ListenerList<Listener> listeners;
+
+  // Instrumentation
+  metrics::Counter &switchesCompleted;
+  metrics::Counter &switchesFailed;
+  metrics::Histogram &switchTime;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeviceSwitcher)
+};
+
+} // namespace mcam
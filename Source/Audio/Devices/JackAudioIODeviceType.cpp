@@ -0,0 +1,553 @@
+#include "JackAudioIODeviceType.h"
+
+#include <cerrno>
+
+namespace mcam {
+
+namespace {
+//==============================================================================
+// The subset of the JACK C API used here. The ABI has been stable since
+// JACK 1, so it is declared locally instead of requiring the JACK headers.
+using jack_nframes_t = juce::uint32;
+using jack_time_t = juce::uint64;
+
+constexpr int JackNoStartServer = 0x01;
+constexpr unsigned long JackPortIsInput = 0x1;
+constexpr unsigned long JackPortIsOutput = 0x2;
+constexpr unsigned long JackPortIsPhysical = 0x4;
+constexpr const char *JACK_AUDIO_TYPE = "32 bit float mono audio";
+constexpr const char *CLIENT_NAME = "MCAM";
+
+using ProcessCallback = int (*)(jack_nframes_t, void *);
+using XRunCallback = int (*)(void *);
+using ShutdownCallback = void (*)(void *);
+
+/** libjack, loaded on first use */
+struct JackLibrary {
+  JackLibrary() {
+#if JUCE_LINUX || JUCE_BSD
+    const char *names[] = {"libjack.so.0", "libjack.so"};
+#elif JUCE_MAC
+    const char *names[] = {"libjack.0.dylib", "/usr/local/lib/libjack.0.dylib",
+                           "/opt/homebrew/lib/libjack.0.dylib"};
+#elif JUCE_WINDOWS
+    const char *names[] = {"libjack64.dll", "libjack.dll"};
+#else
+    const char *names[] = {"libjack"};
+#endif
+
+    for (auto *name : names) {
+      if (library.open(name))
+        break;
+    }
+
+    if (library.getNativeHandle() == nullptr)
+      return;
+
+    bind(client_open, "jack_client_open");
+    bind(client_close, "jack_client_close");
+    bind(get_client_name, "jack_get_client_name");
+    bind(activate, "jack_activate");
+    bind(deactivate, "jack_deactivate");
+    bind(get_sample_rate, "jack_get_sample_rate");
+    bind(get_buffer_size, "jack_get_buffer_size");
+    bind(port_register, "jack_port_register");
+    bind(port_get_buffer, "jack_port_get_buffer");
+    bind(port_get_connections, "jack_port_get_connections");
+    bind(get_ports, "jack_get_ports");
+    bind(connect, "jack_connect");
+    bind(disconnect, "jack_disconnect");
+    bind(free, "jack_free");
+    bind(set_process_callback, "jack_set_process_callback");
+    bind(set_buffer_size_callback, "jack_set_buffer_size_callback");
+    bind(set_xrun_callback, "jack_set_xrun_callback");
+    bind(on_shutdown, "jack_on_shutdown");
+    bind(last_frame_time, "jack_last_frame_time");
+    bind(frames_to_time, "jack_frames_to_time");
+
+    if (!complete) {
+      LOG_WARNING("libjack is missing required functions; JACK disabled");
+      library.close();
+    }
+  }
+
+  bool isLoaded() const { return library.getNativeHandle() != nullptr; }
+
+  template <typename Function> void bind(Function &fn, const char *name) {
+    fn = reinterpret_cast<Function>(library.getFunction(name));
+    complete = complete && fn != nullptr;
+  }
+
+  void *(*client_open)(const char *, int, int *, ...) = nullptr;
+  int (*client_close)(void *) = nullptr;
+  char *(*get_client_name)(void *) = nullptr;
+  int (*activate)(void *) = nullptr;
+  int (*deactivate)(void *) = nullptr;
+  jack_nframes_t (*get_sample_rate)(void *) = nullptr;
+  jack_nframes_t (*get_buffer_size)(void *) = nullptr;
+  void *(*port_register)(void *, const char *, const char *, unsigned long,
+                         unsigned long) = nullptr;
+  void *(*port_get_buffer)(void *, jack_nframes_t) = nullptr;
+  const char **(*port_get_connections)(const void *) = nullptr;
+  const char **(*get_ports)(void *, const char *, const char *,
+                            unsigned long) = nullptr;
+  int (*connect)(void *, const char *, const char *) = nullptr;
+  int (*disconnect)(void *, const char *, const char *) = nullptr;
+  void (*free)(void *) = nullptr;
+  int (*set_process_callback)(void *, ProcessCallback, void *) = nullptr;
+  int (*set_buffer_size_callback)(void *, ProcessCallback, void *) = nullptr;
+  int (*set_xrun_callback)(void *, XRunCallback, void *) = nullptr;
+  void (*on_shutdown)(void *, ShutdownCallback, void *) = nullptr;
+  jack_nframes_t (*last_frame_time)(const void *) = nullptr;
+  jack_time_t (*frames_to_time)(const void *, jack_nframes_t) = nullptr;
+
+private:
+  juce::DynamicLibrary library;
+  bool complete = true;
+};
+
+JackLibrary &jack() {
+  static JackLibrary library;
+  return library;
+}
+
+/** Converts a NULL-terminated port list from JACK and frees it */
+juce::StringArray takePortList(const char **ports) {
+  juce::StringArray names;
+
+  if (ports != nullptr) {
+    for (int i = 0; ports[i] != nullptr; ++i)
+      names.add(juce::CharPointer_UTF8(ports[i]));
+
+    jack().free(ports);
+  }
+
+  return names;
+}
+} // namespace
+
+//==============================================================================
+JackAudioIODeviceType::JackAudioIODeviceType()
+    : juce::AudioIODeviceType(TYPE_NAME) {}
+
+JackAudioIODeviceType::~JackAudioIODeviceType() = default;
+
+bool JackAudioIODeviceType::isLibraryAvailable() { return jack().isLoaded(); }
+
+void JackAudioIODeviceType::scanForDevices() {
+  if (!isLibraryAvailable()) {
+    serverRunning = false;
+    return;
+  }
+
+  // Probe with a throwaway client; never start a server from here
+  int status = 0;
+  auto *probe = jack().client_open("MCAM probe", JackNoStartServer, &status);
+  serverRunning = probe != nullptr;
+
+  if (probe != nullptr)
+    jack().client_close(probe);
+}
+
+juce::StringArray
+JackAudioIODeviceType::getDeviceNames(bool wantInputNames) const {
+  juce::ignoreUnused(wantInputNames);
+
+  if (!serverRunning)
+    return {};
+
+  return {DEVICE_NAME};
+}
+
+int JackAudioIODeviceType::getDefaultDeviceIndex(bool forInput) const {
+  juce::ignoreUnused(forInput);
+  return serverRunning ? 0 : -1;
+}
+
+int JackAudioIODeviceType::getIndexOfDevice(juce::AudioIODevice *device,
+                                            bool asInput) const {
+  juce::ignoreUnused(asInput);
+  return dynamic_cast<JackAudioIODevice *>(device) != nullptr ? 0 : -1;
+}
+
+bool JackAudioIODeviceType::hasSeparateInputsAndOutputs() const {
+  return false;
+}
+
+juce::AudioIODevice *
+JackAudioIODeviceType::createDevice(const juce::String &outputDeviceName,
+                                    const juce::String &inputDeviceName) {
+  const auto name =
+      inputDeviceName.isNotEmpty() ? inputDeviceName : outputDeviceName;
+
+  if (name != DEVICE_NAME || !isLibraryAvailable())
+    return nullptr;
+
+  return new JackAudioIODevice();
+}
+
+//==============================================================================
+JackAudioIODevice::JackAudioIODevice()
+    : juce::AudioIODevice(JackAudioIODeviceType::DEVICE_NAME,
+                          JackAudioIODeviceType::TYPE_NAME) {}
+
+JackAudioIODevice::~JackAudioIODevice() { close(); }
+
+juce::StringArray JackAudioIODevice::getOutputChannelNames() { return {}; }
+
+juce::StringArray JackAudioIODevice::getInputChannelNames() {
+  juce::StringArray names;
+  for (int i = 0; i < NUM_INPUT_PORTS; ++i)
+    names.add("in_" + juce::String(i + 1));
+  return names;
+}
+
+juce::Array<double> JackAudioIODevice::getAvailableSampleRates() {
+  // The server's rate is the only one available
+  if (client != nullptr)
+    return {currentSampleRate.load()};
+
+  return {44100.0, 48000.0, 88200.0, 96000.0, 192000.0};
+}
+
+juce::Array<int> JackAudioIODevice::getAvailableBufferSizes() {
+  // The server's period is the only one available
+  if (client != nullptr)
+    return {currentBufferSize.load()};
+
+  return {16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+}
+
+int JackAudioIODevice::getDefaultBufferSize() {
+  return client != nullptr ? currentBufferSize.load() : 256;
+}
+
+juce::String JackAudioIODevice::open(const juce::BigInteger &inputChannels,
+                                     const juce::BigInteger &outputChannels,
+                                     double sampleRate, int bufferSizeSamples) {
+  juce::ignoreUnused(outputChannels);
+  close();
+
+  auto &lib = jack();
+  if (!lib.isLoaded()) {
+    lastError = "JACK is not installed";
+    return lastError;
+  }
+
+  int status = 0;
+  client = lib.client_open(CLIENT_NAME, JackNoStartServer, &status);
+
+  if (client == nullptr) {
+    lastError = "Cannot connect to the JACK server (status " +
+                juce::String::toHexString(status) + ")";
+    return lastError;
+  }
+
+  currentSampleRate = (double)lib.get_sample_rate(client);
+  currentBufferSize = (int)lib.get_buffer_size(client);
+
+  if ((sampleRate > 0.0 && sampleRate != currentSampleRate.load()) ||
+      (bufferSizeSamples > 0 &&
+       bufferSizeSamples != currentBufferSize.load())) {
+    LOG_INFO("JACK runs at " + juce::String(currentSampleRate.load()) +
+             " Hz, " + juce::String(currentBufferSize.load()) +
+             " samples; requested format ignored");
+  }
+
+  // Register every input so sources can be connected later without
+  // reopening; inactive ones are simply not passed on
+  inputPorts.clear();
+  for (int i = 0; i < NUM_INPUT_PORTS; ++i) {
+    auto *port =
+        lib.port_register(client, ("in_" + juce::String(i + 1)).toRawUTF8(),
+                          JACK_AUDIO_TYPE, JackPortIsInput, 0);
+
+    if (port == nullptr) {
+      lastError = "Cannot register JACK port in_" + juce::String(i + 1);
+      close();
+      return lastError;
+    }
+
+    inputPorts.push_back(port);
+  }
+
+  activeInputs = inputChannels;
+  activeInputs.setRange(NUM_INPUT_PORTS,
+                        juce::jmax(0, activeInputs.getHighestBit() + 1), false);
+
+  activeChannelIndices.clear();
+  for (int ch = 0; ch < NUM_INPUT_PORTS; ++ch) {
+    if (activeInputs[ch])
+      activeChannelIndices.push_back(ch);
+  }
+
+  inputPointers.assign(activeChannelIndices.size(), nullptr);
+  xruns = 0;
+
+  lib.set_process_callback(client, processCallback, this);
+  lib.set_buffer_size_callback(client, bufferSizeCallback, this);
+  lib.set_xrun_callback(client, xrunCallback, this);
+  lib.on_shutdown(client, shutdownCallback, this);
+
+  // Activate now so the ports can be connected before start()
+  if (lib.activate(client) != 0) {
+    lastError = "Cannot activate the JACK client";
+    close();
+    return lastError;
+  }
+
+  connectPhysicalInputs();
+
+  lastError = {};
+
+  LOG_INFO("Opened JACK client " +
+           juce::String(juce::CharPointer_UTF8(lib.get_client_name(client))) +
+           ": " + juce::String((int)activeChannelIndices.size()) +
+           " inputs, " + juce::String(currentSampleRate.load()) + " Hz, " +
+           juce::String(currentBufferSize.load()) + " samples");
+
+  return {};
+}
+
+void JackAudioIODevice::close() {
+  stop();
+
+  if (client != nullptr) {
+    jack().deactivate(client);
+    jack().client_close(client);
+    client = nullptr;
+  }
+
+  inputPorts.clear();
+}
+
+bool JackAudioIODevice::isOpen() { return client != nullptr; }
+
+void JackAudioIODevice::start(juce::AudioIODeviceCallback *newCallback) {
+  if (client == nullptr || newCallback == nullptr)
+    return;
+
+  stop();
+
+  const juce::ScopedLock sl(controlLock);
+  newCallback->audioDeviceAboutToStart(this);
+  callback = newCallback;
+}
+
+void JackAudioIODevice::stop() {
+  const juce::ScopedLock sl(controlLock);
+  auto *oldCallback = callback.exchange(nullptr);
+
+  if (oldCallback != nullptr) {
+    waitForProcess();
+    oldCallback->audioDeviceStopped();
+  }
+}
+
+bool JackAudioIODevice::isPlaying() { return callback.load() != nullptr; }
+
+juce::String JackAudioIODevice::getLastError() { return lastError; }
+
+int JackAudioIODevice::getCurrentBufferSizeSamples() {
+  return currentBufferSize;
+}
+
+double JackAudioIODevice::getCurrentSampleRate() { return currentSampleRate; }
+
+int JackAudioIODevice::getCurrentBitDepth() { return 32; }
+
+juce::BigInteger JackAudioIODevice::getActiveOutputChannels() const {
+  return {};
+}
+
+juce::BigInteger JackAudioIODevice::getActiveInputChannels() const {
+  return activeInputs;
+}
+
+int JackAudioIODevice::getOutputLatencyInSamples() { return 0; }
+
+int JackAudioIODevice::getInputLatencyInSamples() { return 0; }
+
+int JackAudioIODevice::getXRunCount() const noexcept { return xruns; }
+
+juce::StringArray JackAudioIODevice::getSourcePorts() const {
+  if (client == nullptr)
+    return {};
+
+  auto ports = takePortList(
+      jack().get_ports(client, nullptr, JACK_AUDIO_TYPE, JackPortIsOutput));
+
+  // Our own client has no outputs, but skip it in case that changes
+  const auto ownPrefix =
+      juce::String(juce::CharPointer_UTF8(jack().get_client_name(client))) +
+      ":";
+  ports.strings.removeIf([&ownPrefix](const juce::String &port) {
+    return port.startsWith(ownPrefix);
+  });
+
+  return ports;
+}
+
+juce::StringArray JackAudioIODevice::getInputConnections(int inputIndex) const {
+  if (client == nullptr || !juce::isPositiveAndBelow(inputIndex,
+                                                     (int)inputPorts.size()))
+    return {};
+
+  return takePortList(
+      jack().port_get_connections(inputPorts[(size_t)inputIndex]));
+}
+
+bool JackAudioIODevice::connectInput(const juce::String &sourcePort,
+                                     int inputIndex, bool exclusive) {
+  if (client == nullptr || !juce::isPositiveAndBelow(inputIndex,
+                                                     (int)inputPorts.size()))
+    return false;
+
+  if (exclusive)
+    disconnectInput(inputIndex);
+
+  const auto destination = getInputPortName(inputIndex);
+  const int result = jack().connect(client, sourcePort.toRawUTF8(),
+                                    destination.toRawUTF8());
+
+  // EEXIST: already connected
+  if (result != 0 && result != EEXIST) {
+    LOG_WARNING("Cannot connect JACK port " + sourcePort + " to " +
+                destination);
+    return false;
+  }
+
+  LOG_INFO("Connected JACK port " + sourcePort + " to " + destination);
+  return true;
+}
+
+void JackAudioIODevice::disconnectInput(int inputIndex) {
+  const auto destination = getInputPortName(inputIndex);
+
+  for (const auto &source : getInputConnections(inputIndex))
+    jack().disconnect(client, source.toRawUTF8(), destination.toRawUTF8());
+}
+
+int JackAudioIODevice::findUnconnectedInput() const {
+  // Inactive ports are not passed on, so a source there would not be heard
+  for (int input : activeChannelIndices) {
+    if (getInputConnections(input).isEmpty())
+      return input;
+  }
+
+  return -1;
+}
+
+int JackAudioIODevice::inputToChannel(const juce::BigInteger &activeInputs,
+                                      int inputIndex) {
+  if (!juce::isPositiveAndBelow(inputIndex, NUM_INPUT_PORTS) ||
+      !activeInputs[inputIndex])
+    return -1;
+
+  int channel = 0;
+  for (int i = 0; i < inputIndex; ++i)
+    if (activeInputs[i])
+      ++channel;
+
+  return channel;
+}
+
+int JackAudioIODevice::channelToInput(const juce::BigInteger &activeInputs,
+                                      int channel) {
+  if (channel < 0)
+    return -1;
+
+  for (int i = 0; i < NUM_INPUT_PORTS; ++i)
+    if (activeInputs[i] && channel-- == 0)
+      return i;
+
+  return -1;
+}
+
+int JackAudioIODevice::processCallback(juce::uint32 numFrames, void *arg) {
+  static_cast<JackAudioIODevice *>(arg)->process((int)numFrames);
+  return 0;
+}
+
+int JackAudioIODevice::bufferSizeCallback(juce::uint32 numFrames, void *arg) {
+  auto *device = static_cast<JackAudioIODevice *>(arg);
+  device->currentBufferSize = (int)numFrames;
+
+  LOG_INFO("JACK period changed to " + juce::String((int)numFrames) +
+           " samples");
+
+  // Called outside the process thread. The callback re-prepares here while
+  // process() skips its periods, rather than inside the process callback.
+  const juce::ScopedLock sl(device->controlLock);
+
+  if (auto *current = device->callback.load()) {
+    device->preparing = true;
+    device->waitForProcess();
+    current->audioDeviceAboutToStart(device);
+    device->preparing = false;
+  }
+
+  return 0;
+}
+
+int JackAudioIODevice::xrunCallback(void *arg) {
+  ++static_cast<JackAudioIODevice *>(arg)->xruns;
+  return 0;
+}
+
+void JackAudioIODevice::shutdownCallback(void *arg) {
+  auto *device = static_cast<JackAudioIODevice *>(arg);
+
+  const juce::ScopedLock sl(device->controlLock);
+  if (auto *current = device->callback.load())
+    current->audioDeviceError("JACK server shut down");
+}
+
+void JackAudioIODevice::process(int numFrames) {
+  auto &lib = jack();
+
+  for (size_t i = 0; i < activeChannelIndices.size(); ++i) {
+    auto *port = inputPorts[(size_t)activeChannelIndices[i]];
+    inputPointers[i] = static_cast<const float *>(
+        lib.port_get_buffer(port, (jack_nframes_t)numFrames));
+  }
+
+  // The period's first frame time is when its capture completed
+  juce::uint64 hostTimeNs =
+      lib.frames_to_time(client, lib.last_frame_time(client)) * 1000;
+  juce::AudioIODeviceCallbackContext context;
+  context.hostTimeNs = &hostTimeNs;
+
+  // stop() and re-preparation wait for this flag to drop
+  inProcess = true;
+
+  if (auto *current = callback.load(); current != nullptr && !preparing) {
+    current->audioDeviceIOCallbackWithContext(
+        inputPointers.data(), (int)inputPointers.size(), nullptr, 0, numFrames,
+        context);
+  }
+
+  inProcess = false;
+}
+
+void JackAudioIODevice::waitForProcess() const {
+  while (inProcess.load())
+    juce::Thread::yield();
+}
+
+void JackAudioIODevice::connectPhysicalInputs() {
+  const auto capturePorts =
+      takePortList(jack().get_ports(client, nullptr, JACK_AUDIO_TYPE,
+                                    JackPortIsPhysical | JackPortIsOutput));
+
+  const int numToConnect = juce::jmin(capturePorts.size(), NUM_INPUT_PORTS);
+  for (int i = 0; i < numToConnect; ++i)
+    connectInput(capturePorts[i], i, false);
+}
+
+juce::String JackAudioIODevice::getInputPortName(int inputIndex) const {
+  return juce::String(juce::CharPointer_UTF8(jack().get_client_name(client))) +
+         ":in_" + juce::String(inputIndex + 1);
+}
+
+} // namespace mcam
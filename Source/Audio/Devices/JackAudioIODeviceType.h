@@ -0,0 +1,194 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * JackAudioIODeviceType connects MCAM to a running JACK server (or
+ * PipeWire's JACK layer) as a native JACK client.
+ *
+ * MCAM registers its inputs as JACK ports and runs the engine directly in
+ * the JACK process callback, at the period size the server uses, with no
+ * intermediate buffering. Any port in the JACK graph can be connected to an
+ * MCAM input while the device is running. libjack is loaded at runtime, so
+ * the type simply lists no devices when JACK is not installed or no server
+ * is running; it never starts a server.
+ */
+class JackAudioIODeviceType : public juce::AudioIODeviceType {
+public:
+  /** Name of the device type as shown in the device manager */
+  static constexpr const char *TYPE_NAME = "MCAM JACK";
+
+  /** Name of the single device this type provides */
+  static constexpr const char *DEVICE_NAME = "JACK (MCAM client)";
+
+  /** Constructor */
+  JackAudioIODeviceType();
+
+  /** Destructor */
+  ~JackAudioIODeviceType() override;
+
+  /** @return true if libjack could be loaded */
+  static bool isLibraryAvailable();
+
+  /** juce::AudioIODeviceType implementation */
+  void scanForDevices() override;
+  juce::StringArray getDeviceNames(bool wantInputNames) const override;
+  int getDefaultDeviceIndex(bool forInput) const override;
+  int getIndexOfDevice(juce::AudioIODevice *device,
+                       bool asInput) const override;
+  bool hasSeparateInputsAndOutputs() const override;
+  juce::AudioIODevice *
+  createDevice(const juce::String &outputDeviceName,
+               const juce::String &inputDeviceName) override;
+
+private:
+  // Set by scanForDevices() if a server answered
+  std::atomic<bool> serverRunning{false};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JackAudioIODeviceType)
+};
+
+/**
+ * JackAudioIODevice is the JACK client created by JackAudioIODeviceType.
+ * Opening the device registers the input ports and activates the client;
+ * the sample rate and period size are the server's.
+ */
+class JackAudioIODevice : public juce::AudioIODevice {
+public:
+  /**
+   * Input ports registered by the client: as many as the engine analyses
+   * (BufferProcessor::MAX_CHANNELS)
+   */
+  static constexpr int NUM_INPUT_PORTS = 128;
+
+  /** Constructor; does not contact the server */
+  JackAudioIODevice();
+
+  /** Destructor */
+  ~JackAudioIODevice() override;
+
+  /** juce::AudioIODevice implementation */
+  juce::StringArray getOutputChannelNames() override;
+  juce::StringArray getInputChannelNames() override;
+  juce::Array<double> getAvailableSampleRates() override;
+  juce::Array<int> getAvailableBufferSizes() override;
+  int getDefaultBufferSize() override;
+  juce::String open(const juce::BigInteger &inputChannels,
+                    const juce::BigInteger &outputChannels, double sampleRate,
+                    int bufferSizeSamples) override;
+  void close() override;
+  bool isOpen() override;
+  void start(juce::AudioIODeviceCallback *callback) override;
+  void stop() override;
+  bool isPlaying() override;
+  juce::String getLastError() override;
+  int getCurrentBufferSizeSamples() override;
+  double getCurrentSampleRate() override;
+  int getCurrentBitDepth() override;
+  juce::BigInteger getActiveOutputChannels() const override;
+  juce::BigInteger getActiveInputChannels() const override;
+  int getOutputLatencyInSamples() override;
+  int getInputLatencyInSamples() override;
+
+  /** Xruns reported by the server since open() */
+  int getXRunCount() const noexcept override;
+
+  /**
+   * Lists the ports in the JACK graph that can feed an input: capture
+   * ports and other clients' outputs
+   * @return Full port names, e.g. "system:capture_1"
+   */
+  juce::StringArray getSourcePorts() const;
+
+  /**
+   * Lists the ports connected to one of MCAM's inputs
+   * @param inputIndex Input channel index
+   * @return Full port names
+   */
+  juce::StringArray getInputConnections(int inputIndex) const;
+
+  /**
+   * Connects a port in the graph to one of MCAM's inputs. Takes effect from
+   * the next JACK period; the device keeps running.
+   * @param sourcePort Full name of the source port
+   * @param inputIndex Input channel index
+   * @param exclusive Disconnect the input's other sources first
+   * @return true if connected
+   */
+  bool connectInput(const juce::String &sourcePort, int inputIndex,
+                    bool exclusive = true);
+
+  /**
+   * Disconnects every source from one of MCAM's inputs
+   * @param inputIndex Input channel index
+   */
+  void disconnectInput(int inputIndex);
+
+  /** @return Index of the first active input with no connections, or -1 */
+  int findUnconnectedInput() const;
+
+  /**
+   * Maps an input port to the channel the engine sees it as. Only active
+   * inputs are passed on, so channels are the active ports renumbered.
+   * @param activeInputs Active input ports
+   * @param inputIndex Input port index
+   * @return Channel index, or -1 if the port is not active
+   */
+  static int inputToChannel(const juce::BigInteger &activeInputs,
+                            int inputIndex);
+
+  /**
+   * Maps a channel the engine sees to its input port
+   * @param activeInputs Active input ports
+   * @param channel Channel index
+   * @return Input port index, or -1 if there is no such channel
+   */
+  static int channelToInput(const juce::BigInteger &activeInputs,
+                            int channel);
+
+private:
+  /** JACK callbacks (C linkage trampolines) */
+  static int processCallback(juce::uint32 numFrames, void *arg);
+  static int bufferSizeCallback(juce::uint32 numFrames, void *arg);
+  static int xrunCallback(void *arg);
+  static void shutdownCallback(void *arg);
+
+  /** Runs the engine for one JACK period */
+  void process(int numFrames);
+
+  /** Waits until process() has left the callback (not the process thread) */
+  void waitForProcess() const;
+
+  /** Connects the physical capture ports to the first inputs */
+  void connectPhysicalInputs();
+
+  /** @return The full JACK name of one of our input ports */
+  juce::String getInputPortName(int inputIndex) const;
+
+  // JACK client state
+  void *client = nullptr;
+  std::vector<void *> inputPorts;
+  juce::String lastError;
+  std::atomic<double> currentSampleRate{0.0};
+  std::atomic<int> currentBufferSize{0};
+  juce::BigInteger activeInputs;
+
+  // Port buffers for the current period, one per active input
+  std::vector<const float *> inputPointers;
+  std::vector<int> activeChannelIndices;
+
+  // Running state. process() takes no lock: it reads the callback
+  // atomically and skips the period while the callback is re-prepared.
+  // controlLock serialises start(), stop() and the server's notifications.
+  juce::CriticalSection controlLock;
+  std::atomic<juce::AudioIODeviceCallback *> callback{nullptr};
+  std::atomic<bool> preparing{false};
+  mutable std::atomic<bool> inProcess{false};
+  std::atomic<int> xruns{0};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JackAudioIODevice)
+};
+
+} // namespace mcam
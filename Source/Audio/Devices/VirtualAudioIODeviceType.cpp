@@ -0,0 +1,441 @@
+#include "VirtualAudioIODeviceType.h"
+
+namespace mcam {
+
+namespace {
+juce::String describeSource(VirtualAudioIODeviceType::Source source) {
+  switch (source) {
+  case VirtualAudioIODeviceType::Source::Sine:
+    return "Sine";
+  case VirtualAudioIODeviceType::Source::Noise:
+    return "Noise";
+  case VirtualAudioIODeviceType::Source::Silence:
+    return "Silence";
+  case VirtualAudioIODeviceType::Source::File:
+    return "File";
+  }
+
+  return {};
+}
+
+std::unique_ptr<juce::AudioFormatReader> openFile(const juce::File &file) {
+  juce::AudioFormatManager formatManager;
+  formatManager.registerBasicFormats();
+  return std::unique_ptr<juce::AudioFormatReader>(
+      formatManager.createReaderFor(file));
+}
+} // namespace
+
+//==============================================================================
+VirtualAudioIODeviceType::VirtualAudioIODeviceType()
+    : juce::AudioIODeviceType(TYPE_NAME) {
+  LOG_INFO("Creating VirtualAudioIODeviceType");
+
+  // A spread of typical and worst-case loads
+  addDevice({"Virtual Sine 2ch", Source::Sine, 2});
+  addDevice({"Virtual Sine 32ch", Source::Sine, 32});
+  addDevice({"Virtual Noise 64ch", Source::Noise, 64});
+  addDevice({"Virtual Noise 128ch", Source::Noise, 128});
+  addDevice({"Virtual Noise 128ch (free run)", Source::Noise, 128, {},
+             Pacing::FreeRun});
+}
+
+VirtualAudioIODeviceType::~VirtualAudioIODeviceType() = default;
+
+void VirtualAudioIODeviceType::addDevice(DeviceConfig config) {
+  config.numChannels = juce::jlimit(1, MAX_CHANNELS, config.numChannels);
+
+  LOG_INFO("Adding virtual device: " + config.name + " (" +
+           describeSource(config.source) + ", " +
+           juce::String(config.numChannels) + " channels)");
+
+  {
+    const juce::ScopedLock sl(devicesLock);
+
+    auto existing = std::find_if(
+        devices.begin(), devices.end(),
+        [&config](const DeviceConfig &d) { return d.name == config.name; });
+
+    if (existing != devices.end())
+      *existing = config;
+    else
+      devices.push_back(config);
+  }
+
+  callDeviceChangeListeners();
+}
+
+juce::String VirtualAudioIODeviceType::addFileDevice(const juce::File &file,
+                                                     Pacing pacing) {
+  auto reader = openFile(file);
+
+  if (reader == nullptr) {
+    LOG_ERROR("Cannot open " + file.getFullPathName() +
+              " for a virtual device");
+    return {};
+  }
+
+  DeviceConfig config;
+  config.name = "Virtual File: " + file.getFileNameWithoutExtension();
+  config.source = Source::File;
+  config.numChannels = (int)reader->numChannels;
+  config.file = file;
+  config.pacing = pacing;
+
+  if (pacing == Pacing::FreeRun)
+    config.name << " (free run)";
+
+  addDevice(config);
+  return config.name;
+}
+
+void VirtualAudioIODeviceType::scanForDevices() {
+  // The device list is static
+}
+
+juce::StringArray
+VirtualAudioIODeviceType::getDeviceNames(bool wantInputNames) const {
+  juce::ignoreUnused(wantInputNames);
+
+  const juce::ScopedLock sl(devicesLock);
+
+  juce::StringArray names;
+  for (const auto &device : devices)
+    names.add(device.name);
+  return names;
+}
+
+int VirtualAudioIODeviceType::getDefaultDeviceIndex(bool forInput) const {
+  juce::ignoreUnused(forInput);
+  return 0;
+}
+
+int VirtualAudioIODeviceType::getIndexOfDevice(juce::AudioIODevice *device,
+                                               bool asInput) const {
+  juce::ignoreUnused(asInput);
+
+  if (device == nullptr)
+    return -1;
+
+  return getDeviceNames(true).indexOf(device->getName());
+}
+
+bool VirtualAudioIODeviceType::hasSeparateInputsAndOutputs() const {
+  return false;
+}
+
+juce::AudioIODevice *
+VirtualAudioIODeviceType::createDevice(const juce::String &outputDeviceName,
+                                       const juce::String &inputDeviceName) {
+  const auto name =
+      inputDeviceName.isNotEmpty() ? inputDeviceName : outputDeviceName;
+
+  const juce::ScopedLock sl(devicesLock);
+
+  for (const auto &device : devices) {
+    if (device.name == name)
+      return new VirtualAudioIODevice(device);
+  }
+
+  return nullptr;
+}
+
+//==============================================================================
+VirtualAudioIODevice::VirtualAudioIODevice(
+    const VirtualAudioIODeviceType::DeviceConfig &deviceConfig)
+    : juce::AudioIODevice(deviceConfig.name,
+                          VirtualAudioIODeviceType::TYPE_NAME),
+      juce::Thread("MCAM Virtual Device"), config(deviceConfig) {}
+
+VirtualAudioIODevice::~VirtualAudioIODevice() { close(); }
+
+juce::StringArray VirtualAudioIODevice::getOutputChannelNames() { return {}; }
+
+juce::StringArray VirtualAudioIODevice::getInputChannelNames() {
+  juce::StringArray names;
+  for (int i = 0; i < config.numChannels; ++i)
+    names.add("Input " + juce::String(i + 1));
+  return names;
+}
+
+juce::Array<double> VirtualAudioIODevice::getAvailableSampleRates() {
+  return {44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0};
+}
+
+juce::Array<int> VirtualAudioIODevice::getAvailableBufferSizes() {
+  return {16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192};
+}
+
+int VirtualAudioIODevice::getDefaultBufferSize() { return 512; }
+
+juce::String VirtualAudioIODevice::open(const juce::BigInteger &inputChannels,
+                                        const juce::BigInteger &outputChannels,
+                                        double sampleRate,
+                                        int bufferSizeSamples) {
+  juce::ignoreUnused(outputChannels);
+  close();
+
+  currentSampleRate = sampleRate > 0.0 ? sampleRate : 48000.0;
+  currentBufferSize =
+      bufferSizeSamples > 0 ? bufferSizeSamples : getDefaultBufferSize();
+
+  activeInputs = inputChannels;
+  activeInputs.setRange(config.numChannels,
+                        juce::jmax(0, activeInputs.getHighestBit() + 1), false);
+
+  activeChannelIndices.clear();
+  for (int ch = 0; ch < config.numChannels; ++ch) {
+    if (activeInputs[ch])
+      activeChannelIndices.push_back(ch);
+  }
+
+  inputBuffer.setSize((int)activeChannelIndices.size(), currentBufferSize);
+  inputBuffer.clear();
+
+  if (config.source == VirtualAudioIODeviceType::Source::File) {
+    fileReader = openFile(config.file);
+
+    if (fileReader == nullptr || fileReader->lengthInSamples <= 0) {
+      lastError = "Cannot open " + config.file.getFullPathName();
+      fileReader.reset();
+      return lastError;
+    }
+
+    // Inactive channels are skipped by the reader
+    fileChannelPointers.assign((size_t)fileReader->numChannels, nullptr);
+    for (size_t i = 0; i < activeChannelIndices.size(); ++i) {
+      fileChannelPointers[(size_t)activeChannelIndices[i]] =
+          inputBuffer.getWritePointer((int)i);
+    }
+
+    filePosition = 0;
+  } else {
+    buildGeneratorTable();
+  }
+
+  lastError = {};
+  deviceOpen = true;
+
+  LOG_INFO("Opened virtual device " + getName() + ": " +
+           juce::String((int)activeChannelIndices.size()) + " inputs, " +
+           juce::String(currentSampleRate) + " Hz, " +
+           juce::String(currentBufferSize) + " samples, " +
+           (config.pacing == VirtualAudioIODeviceType::Pacing::FreeRun
+                ? "free run"
+                : "wall clock"));
+
+  return {};
+}
+
+void VirtualAudioIODevice::close() {
+  stop();
+
+  fileReader.reset();
+  generatorTable.setSize(0, 0);
+  deviceOpen = false;
+}
+
+bool VirtualAudioIODevice::isOpen() { return deviceOpen; }
+
+void VirtualAudioIODevice::start(juce::AudioIODeviceCallback *newCallback) {
+  if (!deviceOpen || newCallback == nullptr)
+    return;
+
+  stop();
+
+  newCallback->audioDeviceAboutToStart(this);
+
+  {
+    const juce::ScopedLock sl(callbackLock);
+    callback = newCallback;
+  }
+
+  xruns = 0;
+  blocksDelivered = 0;
+  startThread(juce::Thread::Priority::highest);
+}
+
+void VirtualAudioIODevice::stop() {
+  if (!isThreadRunning())
+    return;
+
+  stopThread(2000);
+
+  juce::AudioIODeviceCallback *oldCallback = nullptr;
+  {
+    const juce::ScopedLock sl(callbackLock);
+    std::swap(oldCallback, callback);
+  }
+
+  if (oldCallback != nullptr)
+    oldCallback->audioDeviceStopped();
+}
+
+bool VirtualAudioIODevice::isPlaying() { return isThreadRunning(); }
+
+juce::String VirtualAudioIODevice::getLastError() { return lastError; }
+
+int VirtualAudioIODevice::getCurrentBufferSizeSamples() {
+  return currentBufferSize;
+}
+
+double VirtualAudioIODevice::getCurrentSampleRate() {
+  return currentSampleRate;
+}
+
+int VirtualAudioIODevice::getCurrentBitDepth() { return 32; }
+
+juce::BigInteger VirtualAudioIODevice::getActiveOutputChannels() const {
+  return {};
+}
+
+juce::BigInteger VirtualAudioIODevice::getActiveInputChannels() const {
+  return activeInputs;
+}
+
+int VirtualAudioIODevice::getOutputLatencyInSamples() { return 0; }
+
+int VirtualAudioIODevice::getInputLatencyInSamples() { return 0; }
+
+int VirtualAudioIODevice::getXRunCount() const noexcept { return xruns; }
+
+juce::int64 VirtualAudioIODevice::getBlocksDelivered() const {
+  return blocksDelivered;
+}
+
+void VirtualAudioIODevice::buildGeneratorTable() {
+  const int numChannels = config.numChannels;
+  generatorTable.setSize(numChannels, TABLE_LENGTH);
+  generatorTable.clear();
+  tablePosition = 0;
+
+  for (int ch = 0; ch < numChannels; ++ch) {
+    auto *data = generatorTable.getWritePointer(ch);
+
+    if (config.source == VirtualAudioIODeviceType::Source::Sine) {
+      // Log-spaced 50 Hz - 10 kHz, rounded to whole cycles so the table loops
+      const double position =
+          numChannels > 1 ? (double)ch / (numChannels - 1) : 0.0;
+      const double frequency = 50.0 * std::pow(200.0, position);
+      const int cycles = juce::jmax(
+          1, juce::roundToInt(frequency * TABLE_LENGTH / currentSampleRate));
+
+      for (int i = 0; i < TABLE_LENGTH; ++i) {
+        data[i] = 0.25f * (float)std::sin(juce::MathConstants<double>::twoPi *
+                                          cycles * i / TABLE_LENGTH);
+      }
+    } else if (config.source == VirtualAudioIODeviceType::Source::Noise) {
+      juce::Random random(ch + 1);
+
+      for (int i = 0; i < TABLE_LENGTH; ++i)
+        data[i] = 0.1f * (random.nextFloat() * 2.0f - 1.0f);
+    }
+  }
+}
+
+void VirtualAudioIODevice::renderBlock() {
+  const int numSamples = currentBufferSize;
+
+  if (fileReader != nullptr) {
+    // Loop the file, reading only the active channels
+    int done = 0;
+
+    while (done < numSamples) {
+      const int chunk = (int)juce::jmin(
+          (juce::int64)(numSamples - done),
+          fileReader->lengthInSamples - filePosition);
+
+      for (size_t i = 0; i < activeChannelIndices.size(); ++i) {
+        fileChannelPointers[(size_t)activeChannelIndices[i]] =
+            inputBuffer.getWritePointer((int)i, done);
+      }
+
+      fileReader->read(fileChannelPointers.data(),
+                       (int)fileChannelPointers.size(), filePosition, chunk);
+
+      done += chunk;
+      filePosition += chunk;
+
+      if (filePosition >= fileReader->lengthInSamples)
+        filePosition = 0;
+    }
+
+    return;
+  }
+
+  if (config.source == VirtualAudioIODeviceType::Source::Silence)
+    return;
+
+  // Copy from the looped table
+  int done = 0;
+
+  while (done < numSamples) {
+    const int chunk =
+        juce::jmin(numSamples - done, TABLE_LENGTH - tablePosition);
+
+    for (size_t i = 0; i < activeChannelIndices.size(); ++i) {
+      inputBuffer.copyFrom((int)i, done, generatorTable,
+                           activeChannelIndices[i], tablePosition, chunk);
+    }
+
+    done += chunk;
+    tablePosition = (tablePosition + chunk) % TABLE_LENGTH;
+  }
+}
+
+void VirtualAudioIODevice::run() {
+  const bool wallClock =
+      config.pacing == VirtualAudioIODeviceType::Pacing::WallClock;
+  const double ticksPerBlock =
+      (double)juce::Time::getHighResolutionTicksPerSecond() *
+      currentBufferSize /
+      (currentSampleRate * (1.0 + config.clockDriftPpm * 1.0e-6));
+
+  auto startTicks = juce::Time::getHighResolutionTicks();
+  juce::int64 blockIndex = 0;
+  juce::AudioIODeviceCallbackContext context;
+
+  while (!threadShouldExit()) {
+    renderBlock();
+
+    {
+      const juce::ScopedLock sl(callbackLock);
+
+      if (callback != nullptr) {
+        callback->audioDeviceIOCallbackWithContext(
+            inputBuffer.getArrayOfReadPointers(), inputBuffer.getNumChannels(),
+            nullptr, 0, currentBufferSize, context);
+      }
+    }
+
+    ++blocksDelivered;
+    ++blockIndex;
+
+    if (!wallClock)
+      continue;
+
+    const auto due = startTicks + (juce::int64)(blockIndex * ticksPerBlock);
+    auto now = juce::Time::getHighResolutionTicks();
+
+    if (now > due + (juce::int64)ticksPerBlock) {
+      // A whole block late: count it and restart the schedule from now
+      ++xruns;
+      startTicks = now - (juce::int64)(blockIndex * ticksPerBlock);
+      continue;
+    }
+
+    while (now < due && !threadShouldExit()) {
+      const double remainingMs =
+          juce::Time::highResolutionTicksToSeconds(due - now) * 1000.0;
+
+      if (remainingMs > 2.0)
+        juce::Thread::sleep((int)remainingMs - 1);
+      else
+        juce::Thread::yield();
+
+      now = juce::Time::getHighResolutionTicks();
+    }
+  }
+}
+
+} // namespace mcam
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * VirtualAudioIODeviceType provides input-only audio devices backed by
+ * synthetic generators or multichannel audio files, so the full engine can
+ * be exercised without audio hardware.
+ *
+ * Devices are listed like hardware devices and opened through the normal
+ * juce::AudioDeviceManager path; sample rate and block size come from the
+ * device setup. Each device either paces its callbacks to the wall clock
+ * (like a real interface) or runs them back to back as fast as the
+ * callbacks allow.
+ */
+class VirtualAudioIODeviceType : public juce::AudioIODeviceType {
+public:
+  /** Name of the device type as shown in the device manager */
+  static constexpr const char *TYPE_NAME = "MCAM Virtual";
+
+  /** Maximum channels a virtual device can have */
+  static constexpr int MAX_CHANNELS = 128;
+
+  /** Where a device's audio comes from */
+  enum class Source { Sine, Noise, Silence, File };
+
+  /** How callbacks are scheduled */
+  enum class Pacing { WallClock, FreeRun };
+
+  /** Description of one virtual device */
+  struct DeviceConfig {
+    juce::String name;
+    Source source = Source::Sine;
+    int numChannels = 2;
+    juce::File file; // Source::File only; played in a loop
+    Pacing pacing = Pacing::WallClock;
+
+    // WallClock only: how far the simulated crystal is off nominal, e.g. to
+    // exercise drift compensation
+    double clockDriftPpm = 0.0;
+  };
+
+  /** Constructor; registers a default set of generator devices */
+  VirtualAudioIODeviceType();
+
+  /** Destructor */
+  ~VirtualAudioIODeviceType() override;
+
+  /**
+   * Adds a device, or replaces the device with the same name
+   * @param config Device description (channels are clamped to 1-128)
+   */
+  void addDevice(DeviceConfig config);
+
+  /**
+   * Adds a device that plays an audio file in a loop. The channel count is
+   * taken from the file; the file's sample rate is ignored in favour of the
+   * rate the device is opened with.
+   * @param file Audio file in any format JUCE can read
+   * @param pacing Callback scheduling
+   * @return The device name, or an empty string if the file is unreadable
+   */
+  juce::String addFileDevice(const juce::File &file,
+                             Pacing pacing = Pacing::WallClock);
+
+  /** juce::AudioIODeviceType implementation */
+  void scanForDevices() override;
+  juce::StringArray getDeviceNames(bool wantInputNames) const override;
+  int getDefaultDeviceIndex(bool forInput) const override;
+  int getIndexOfDevice(juce::AudioIODevice *device,
+                       bool asInput) const override;
+  bool hasSeparateInputsAndOutputs() const override;
+  juce::AudioIODevice *
+  createDevice(const juce::String &outputDeviceName,
+               const juce::String &inputDeviceName) override;
+
+private:
+  // Guarded by devicesLock, as the device catalog reads it from its thread
+  std::vector<DeviceConfig> devices;
+  mutable juce::CriticalSection devicesLock;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioIODeviceType)
+};
+
+/**
+ * VirtualAudioIODevice is the device created by VirtualAudioIODeviceType.
+ * It renders blocks on its own high-priority thread and delivers them
+ * through the standard juce::AudioIODeviceCallback interface.
+ */
+class VirtualAudioIODevice : public juce::AudioIODevice,
+                             private juce::Thread {
+public:
+  /** Constructor */
+  explicit VirtualAudioIODevice(
+      const VirtualAudioIODeviceType::DeviceConfig &config);
+
+  /** Destructor */
+  ~VirtualAudioIODevice() override;
+
+  /** juce::AudioIODevice implementation */
+  juce::StringArray getOutputChannelNames() override;
+  juce::StringArray getInputChannelNames() override;
+  juce::Array<double> getAvailableSampleRates() override;
+  juce::Array<int> getAvailableBufferSizes() override;
+  int getDefaultBufferSize() override;
+  juce::String open(const juce::BigInteger &inputChannels,
+                    const juce::BigInteger &outputChannels, double sampleRate,
+                    int bufferSizeSamples) override;
+  void close() override;
+  bool isOpen() override;
+  void start(juce::AudioIODeviceCallback *callback) override;
+  void stop() override;
+  bool isPlaying() override;
+  juce::String getLastError() override;
+  int getCurrentBufferSizeSamples() override;
+  double getCurrentSampleRate() override;
+  int getCurrentBitDepth() override;
+  juce::BigInteger getActiveOutputChannels() const override;
+  juce::BigInteger getActiveInputChannels() const override;
+  int getOutputLatencyInSamples() override;
+  int getInputLatencyInSamples() override;
+
+  /** Blocks delivered later than their wall-clock deadline */
+  int getXRunCount() const noexcept override;
+
+  /** @return Number of blocks delivered since start() */
+  juce::int64 getBlocksDelivered() const;
+
+private:
+  /** Length of the looped generator tables, per channel */
+  static constexpr int TABLE_LENGTH = 16384;
+
+  /** Callback thread */
+  void run() override;
+
+  /** Fills inputBuffer with the next block for the active channels */
+  void renderBlock();
+
+  /** Builds the generator table for the current sample rate */
+  void buildGeneratorTable();
+
+  const VirtualAudioIODeviceType::DeviceConfig config;
+
+  // Open state
+  bool deviceOpen = false;
+  juce::String lastError;
+  double currentSampleRate = 48000.0;
+  int currentBufferSize = 512;
+  juce::BigInteger activeInputs;
+  std::vector<int> activeChannelIndices;
+  juce::AudioBuffer<float> inputBuffer;
+
+  // Sources
+  juce::AudioBuffer<float> generatorTable;
+  int tablePosition = 0;
+  std::unique_ptr<juce::AudioFormatReader> fileReader;
+  juce::int64 filePosition = 0;
+  std::vector<float *> fileChannelPointers;
+
+  // Running state
+  juce::CriticalSection callbackLock;
+  juce::AudioIODeviceCallback *callback = nullptr;
+  std::atomic<int> xruns{0};
+  std::atomic<juce::int64> blocksDelivered{0};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioIODevice)
+};
+
+} // namespace mcam
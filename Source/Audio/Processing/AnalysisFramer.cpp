@@ -0,0 +1,88 @@
+#include "AnalysisFramer.h"
+
+namespace mcam {
+
+namespace {
+#if JUCE_USE_SIMD
+using FloatVector = juce::dsp::SIMDRegister<float>;
+constexpr int VECTOR_SIZE = (int)FloatVector::SIMDNumElements;
+#else
+constexpr int VECTOR_SIZE = 1;
+#endif
+
+int roundUpToVectorSize(int n) {
+  return (n + VECTOR_SIZE - 1) / VECTOR_SIZE * VECTOR_SIZE;
+}
+} // namespace
+
+AnalysisFramer::AnalysisFramer(int maxChannels)
+    : maxChannels(juce::jmax(0, maxChannels)),
+      rows((size_t)this->maxChannels, nullptr),
+      hop((size_t)this->maxChannels, nullptr),
+      pieces((size_t)this->maxChannels, nullptr) {}
+
+bool AnalysisFramer::prepare(int newHopSize, int newMaxBlockSize) {
+  if (newHopSize != 0 &&
+      (newHopSize < MIN_HOP_SIZE || newHopSize > MAX_HOP_SIZE))
+    return false;
+
+  hopSize = newHopSize;
+  maxBlockSize = hopSize != 0 ? hopSize : juce::jmax(1, newMaxBlockSize);
+  numHeld = 0;
+  heldOffset = 0;
+
+  // Rows are padded to whole vectors so each starts aligned
+  const int rowSize = roundUpToVectorSize(hopSize);
+  storage.assign((size_t)(rowSize * maxChannels + VECTOR_SIZE), 0.0f);
+  storage.shrink_to_fit();
+
+#if JUCE_USE_SIMD
+  float *start = FloatVector::getNextSIMDAlignedPtr(storage.data());
+#else
+  float *start = storage.data();
+#endif
+
+  for (int ch = 0; ch < maxChannels; ++ch) {
+    rows[(size_t)ch] = start + ch * rowSize;
+    hop[(size_t)ch] = rows[(size_t)ch];
+  }
+
+  return true;
+}
+
+void AnalysisFramer::reset() {
+  numHeld = 0;
+  heldOffset = 0;
+
+  for (int ch = 0; ch < maxChannels; ++ch)
+    hop[(size_t)ch] = rows[(size_t)ch];
+}
+
+int AnalysisFramer::getHopSize() const { return hopSize; }
+
+int AnalysisFramer::getMaxBlockSize() const { return maxBlockSize; }
+
+int AnalysisFramer::getNumHeldSamples() const { return numHeld; }
+
+void AnalysisFramer::hold(const float *const *channels, int numChannels,
+                          int start, int count) {
+  // A new hop starts with every channel present
+  if (numHeld == 0) {
+    heldOffset = start;
+
+    for (int ch = 0; ch < maxChannels; ++ch)
+      hop[(size_t)ch] = rows[(size_t)ch];
+  }
+
+  for (int ch = 0; ch < maxChannels; ++ch) {
+    if (ch >= numChannels || channels[ch] == nullptr)
+      hop[(size_t)ch] = nullptr;
+    else if (hop[(size_t)ch] != nullptr)
+      juce::FloatVectorOperations::copy(rows[(size_t)ch] + numHeld,
+                                        channels[ch] + start, count);
+  }
+
+  numHeld += count;
+}
+
+} // namespace mcam
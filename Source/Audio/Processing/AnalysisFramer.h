@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * AnalysisFramer cuts the stream of device blocks, of whatever and however
+ * varying sizes the driver delivers, into the blocks analysis runs on.
+ *
+ * With a hop size, every block passed on has exactly that many samples.
+ * Hops are assembled in storage allocated by prepare(), one SIMD-aligned
+ * row per channel, so analysis sees the same samples at the same alignment
+ * whatever the device's block size, and gives the same results. Samples
+ * that do not complete a hop are held for the next device block, so
+ * results are up to one hop late.
+ *
+ * Without a hop size, device blocks are passed on in place, split into
+ * pieces no longer than the size given to prepare().
+ *
+ * process() never allocates. The framer does no locking; the owner
+ * serialises prepare() against the audio thread.
+ */
+class AnalysisFramer {
+public:
+  /** Smallest hop size */
+  static constexpr int MIN_HOP_SIZE = 16;
+
+  /** Largest hop size */
+  static constexpr int MAX_HOP_SIZE = 8192;
+
+  /**
+   * Constructor
+   * @param maxChannels Most channels framed; others are ignored
+   */
+  explicit AnalysisFramer(int maxChannels);
+
+  /**
+   * Allocates storage and discards any held samples
+   * @param hopSize Samples per hop (MIN_HOP_SIZE to MAX_HOP_SIZE), or 0 to
+   * pass device blocks on as they come
+   * @param maxBlockSize Longest piece passed on when hopSize is 0
+   * @return false if hopSize is out of range; the framer is unchanged
+   */
+  bool prepare(int hopSize, int maxBlockSize);
+
+  /** Discards held samples, e.g. when the stream is interrupted */
+  void reset();
+
+  /** @return The hop size, or 0 if device blocks are passed on */
+  int getHopSize() const;
+
+  /** @return The most samples passed on in one block; 0 before prepare() */
+  int getMaxBlockSize() const;
+
+  /** @return Samples held towards the next hop */
+  int getNumHeldSamples() const;
+
+  /**
+   * Appends a device block and passes on every block completed
+   * @param channels One pointer per channel; a channel that is nullptr in
+   * any device block making up a hop is nullptr in that hop
+   * @param numChannels Number of channels, clamped to maxChannels
+   * @param numSamples Number of samples, any length
+   * @param onBlock Called as onBlock(const float *const *channels,
+   * int numChannels, int numSamples, int offset) for each block passed on,
+   * where offset is the position of the block's first sample in this device
+   * block; it is negative for samples held from earlier device blocks
+   */
+  template <typename BlockCallback>
+  void process(const float *const *channels, int numChannels,
+               int numSamples, BlockCallback &&onBlock) {
+    numChannels = juce::jlimit(0, maxChannels, numChannels);
+
+    if (hopSize == 0) {
+      // Before prepare() blocks are passed on whole
+      const int pieceSize = maxBlockSize > 0 ? maxBlockSize : numSamples;
+
+      for (int position = 0; position < numSamples; position += pieceSize) {
+        for (int ch = 0; ch < numChannels; ++ch)
+          pieces[(size_t)ch] =
+              channels[ch] != nullptr ? channels[ch] + position : nullptr;
+
+        onBlock(pieces.data(), numChannels,
+                juce::jmin(pieceSize, numSamples - position), position);
+      }
+
+      return;
+    }
+
+    for (int position = 0; position < numSamples;) {
+      const int count = juce::jmin(hopSize - numHeld, numSamples - position);
+      hold(channels, numChannels, position, count);
+      position += count;
+
+      if (numHeld == hopSize) {
+        numHeld = 0;
+        onBlock(hop.data(), numChannels, hopSize, heldOffset);
+      }
+    }
+
+    // Held samples are earlier than the next device block
+    heldOffset -= numSamples;
+  }
+
+private:
+  /**
+   * Copies part of a device block behind the held samples. A new hop
+   * starts at the start position.
+   */
+  void hold(const float *const *channels, int numChannels, int start,
+            int count);
+
+  const int maxChannels;
+  int hopSize = 0;
+  int maxBlockSize = 0;
+  int numHeld = 0;
+
+  // Position of the first held sample relative to the device block being
+  // processed
+  int heldOffset = 0;
+
+  // One aligned row of hopSize samples per channel, and the row pointers
+  // handed out (nullptr for channels missing from the hop)
+  std::vector<float> storage;
+  std::vector<float *> rows;
+  std::vector<const float *> hop;
+
+  // Channel pointers into the device block when passing it on
+  std::vector<const float *> pieces;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalysisFramer)
+};
+
+} // namespace mcam
@@ -2,17 +2,87 @@
 
 namespace mcam {
 
-BufferProcessor::BufferProcessor() {
+namespace {
+static_assert(BufferProcessor::MAX_DERIVED_CHANNELS <= 32,
+              "Defined derived channels are tracked in a 32-bit mask");
+
+double secondsPerTick() {
+  return 1.0 / (double)juce::Time::getHighResolutionTicksPerSecond();
+}
+} // namespace
+
+BufferProcessor::BufferProcessor()
+    : analyzerPipelines(AnalyzerPipelineRegistry::getInstance()),
+      routingQueueDepth(MetricsRegistry::getInstance().gauge(
+          "mcam_routing_queue_depth",
+          "Routing commands waiting for the audio thread")),
+      routingQueueDrops(MetricsRegistry::getInstance().counter(
+          "mcam_routing_queue_drops_total",
+          "Routing commands rejected because the queue was full")),
+      levelAnalysisTicks(MetricsRegistry::getInstance().counter(
+          "mcam_analyzer_cpu_seconds_total", "CPU time spent per analyzer",
+          "analyzer=\"slot_levels\"", secondsPerTick())),
+      ballisticsAnalysisTicks(MetricsRegistry::getInstance().counter(
+          "mcam_analyzer_cpu_seconds_total", "CPU time spent per analyzer",
+          "analyzer=\"meter_ballistics\"", secondsPerTick())),
+      loudnessAnalysisTicks(MetricsRegistry::getInstance().counter(
+          "mcam_analyzer_cpu_seconds_total", "CPU time spent per analyzer",
+          "analyzer=\"loudness\"", secondsPerTick())),
+      truePeakAnalysisTicks(MetricsRegistry::getInstance().counter(
+          "mcam_analyzer_cpu_seconds_total", "CPU time spent per analyzer",
+          "analyzer=\"true_peak\"", secondsPerTick())),
+      alarmAnalysisTicks(MetricsRegistry::getInstance().counter(
+          "mcam_analyzer_cpu_seconds_total", "CPU time spent per analyzer",
+          "analyzer=\"alarms\"", secondsPerTick())),
+      historyAnalysisTicks(MetricsRegistry::getInstance().counter(
+          "mcam_analyzer_cpu_seconds_total", "CPU time spent per analyzer",
+          "analyzer=\"level_history\"", secondsPerTick())),
+      callbackAnalysisTicks(MetricsRegistry::getInstance().counter(
+          "mcam_analyzer_cpu_seconds_total", "CPU time spent per analyzer",
+          "analyzer=\"buffer_callbacks\"", secondsPerTick())) {
   LOG_INFO("Initializing BufferProcessor");
 
   // Initialize monitor channels to -1 (no channel assigned)
   for (int i = 0; i < NUM_MONITOR_SLOTS; ++i) {
     monitorChannels[i] = -1;
+    loudnessChannels[i] = -1;
+    slotPeakLevels[i] = 0.0f;
+    slotRmsLevels[i] = 0.0f;
+    slotDcOffsets[i] = 0.0f;
+    slotClippedSamples[i] = 0;
+    slotAnalyzerStages[i] = AnalyzerStage::peak | AnalyzerStage::rms;
+    slotTruePeakLevels[i] = 0.0f;
+    slotMeterTypes[i] = MeterType::vu;
+    appliedMeterTypes[i] = MeterType::vu;
+    slotMeterLevels[i] = 0.0f;
+    slotMeterPeakHolds[i] = 0.0f;
   }
+
+  // Sample taps are left alone: their readers keep pointers to the FIFOs
+  // and their tap flags are the UI's, and a reader merely draws the old
+  // stream's last samples
+
+  for (auto &level : channelTruePeaks)
+    level = 0.0f;
+
+  for (int channel = 0; channel < MAX_CHANNELS; ++channel)
+    channelHistories.push_back(std::make_unique<LevelHistory>());
+
+  vuMeters.prepare(48000.0, NUM_MONITOR_SLOTS);
+  ppmMeters.prepare(48000.0, NUM_MONITOR_SLOTS);
+
+  inputTruePeak.prepare(48000.0, MAX_CHANNELS);
+  slotTruePeak.prepare(48000.0, NUM_MONITOR_SLOTS);
+
+  // processAudio() holds bufferLock against configuration changes from
+  // control threads; the realtime checks report it only when the audio
+  // thread has to wait for one
+  RealtimeGuard::allowLock(bufferLock, "BufferProcessor::bufferLock");
 }
 
 BufferProcessor::~BufferProcessor() {
   LOG_INFO("Shutting down BufferProcessor");
+  RealtimeGuard::disallowLock(bufferLock);
 }
 
 bool BufferProcessor::setMonitorChannel(int slotIndex, int channelIndex) {
@@ -23,7 +93,7 @@ bool BufferProcessor::setMonitorChannel(int slotIndex, int channelIndex) {
   }
 
   // Validate channel index (allow -1 to clear the slot)
-  if (channelIndex < -1 || channelIndex >= MAX_CHANNELS) {
+  if (!isSelectableChannel(channelIndex)) {
     LOG_ERROR("Invalid channel index: " + juce::String(channelIndex));
     return false;
   }
@@ -38,6 +108,98 @@ bool BufferProcessor::setMonitorChannel(int slotIndex, int channelIndex) {
   return true;
 }
 
+bool BufferProcessor::postMonitorChannel(int slotIndex, int channelIndex) {
+  // Same validation as setMonitorChannel, but without logging on failure
+  // paths that may be hit at network rates
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS ||
+      !isSelectableChannel(channelIndex)) {
+    return false;
+  }
+
+  // The FIFO has a single producer side; posting threads take turns on it
+  const juce::SpinLock::ScopedLockType sl(routingPostLock);
+  const auto scope = routingFifo.write(1);
+
+  if (scope.blockSize1 + scope.blockSize2 == 0) {
+    routingQueueDrops.add();
+    return false; // Queue full, audio thread has not drained it
+  }
+
+  const int index =
+      scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2;
+  routingCommands[(size_t)index] = {slotIndex, channelIndex};
+
+  return true;
+}
+
+bool BufferProcessor::setDerivedChannel(
+    int derivedIndex, const juce::String &name,
+    std::vector<ChannelMatrixMixer::Term> terms) {
+  if (derivedIndex < 0 || derivedIndex >= MAX_DERIVED_CHANNELS) {
+    LOG_ERROR("Invalid derived channel index: " + juce::String(derivedIndex));
+    return false;
+  }
+
+  for (const auto &term : terms) {
+    if (term.input < 0 || term.input >= MAX_CHANNELS) {
+      LOG_ERROR("Invalid input channel for derived channel " +
+                juce::String(derivedIndex) + ": " + juce::String(term.input));
+      return false;
+    }
+  }
+
+  LOG_INFO("Setting derived channel " + juce::String(derivedIndex) + " (" +
+           name + ") from " + juce::String((int)terms.size()) + " terms");
+
+  const juce::ScopedLock sl(bufferLock);
+
+  matrixMixer.setOutput(derivedIndex, std::move(terms));
+
+  const bool defined = matrixMixer.isOutputDefined(derivedIndex);
+  derivedChannelNames[(size_t)derivedIndex] = defined ? name : juce::String();
+
+  const auto bit = (juce::uint32)1 << derivedIndex;
+  if (defined)
+    definedDerivedChannels.fetch_or(bit);
+  else
+    definedDerivedChannels.fetch_and(~bit);
+
+  derivedChannelsRevision.fetch_add(1);
+  return true;
+}
+
+juce::String BufferProcessor::getDerivedChannelName(int derivedIndex) const {
+  if (derivedIndex < 0 || derivedIndex >= MAX_DERIVED_CHANNELS)
+    return {};
+
+  const juce::ScopedLock sl(bufferLock);
+  return derivedChannelNames[(size_t)derivedIndex];
+}
+
+std::vector<ChannelMatrixMixer::Term>
+BufferProcessor::getDerivedChannelTerms(int derivedIndex) const {
+  const juce::ScopedLock sl(bufferLock);
+  return matrixMixer.getTerms(derivedIndex);
+}
+
+int BufferProcessor::getDerivedChannelsRevision() const {
+  return derivedChannelsRevision.load();
+}
+
+int BufferProcessor::getDerivedChannelIndex(int derivedIndex) {
+  return MAX_CHANNELS + derivedIndex;
+}
+
+bool BufferProcessor::isSelectableChannel(int channelIndex) const {
+  if (channelIndex >= -1 && channelIndex < MAX_CHANNELS)
+    return true;
+
+  const int derivedIndex = channelIndex - MAX_CHANNELS;
+
+  return derivedIndex >= 0 && derivedIndex < MAX_DERIVED_CHANNELS &&
+         (definedDerivedChannels.load() >> derivedIndex & 1) != 0;
+}
+
 int BufferProcessor::getMonitorChannel(int slotIndex) const {
   // Validate slot index
   if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS) {
@@ -66,12 +228,228 @@ BufferProcessor::getMonitorBuffer(int slotIndex) const {
   return &monitorBuffers[slotIndex];
 }
 
-void BufferProcessor::addBufferCallback(BufferCallback callback) {
-  if (callback) {
-    const juce::ScopedLock sl(callbackLock);
-    bufferCallbacks.push_back(std::move(callback));
-    LOG_INFO("Added buffer callback");
+double BufferProcessor::getSampleRate() const {
+  return publishedSampleRate.load(std::memory_order_relaxed);
+}
+
+bool BufferProcessor::setAnalysisHopSize(int hopSize) {
+  if (hopSize != 0 && (hopSize < AnalysisFramer::MIN_HOP_SIZE ||
+                       hopSize > AnalysisFramer::MAX_HOP_SIZE)) {
+    LOG_ERROR("Invalid analysis hop size: " + juce::String(hopSize));
+    return false;
+  }
+
+  LOG_INFO("Setting analysis hop size to " + juce::String(hopSize) +
+           " samples");
+
+  const juce::ScopedLock sl(bufferLock);
+  analysisHopSize = hopSize;
+
+  if (preparedBlockSize > 0)
+    prepareFraming();
+
+  return true;
+}
+
+int BufferProcessor::getAnalysisHopSize() const {
+  const juce::ScopedLock sl(bufferLock);
+  return analysisHopSize;
+}
+
+float BufferProcessor::getSlotPeakLevel(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return 0.0f;
+
+  return slotPeakLevels[slotIndex].load(std::memory_order_relaxed);
+}
+
+float BufferProcessor::getSlotRmsLevel(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return 0.0f;
+
+  return slotRmsLevels[slotIndex].load(std::memory_order_relaxed);
+}
+
+bool BufferProcessor::setSlotAnalyzerStages(int slotIndex, int stages) {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS) {
+    LOG_ERROR("Invalid slot index: " + juce::String(slotIndex));
+    return false;
+  }
+
+  const int selected =
+      (stages & AnalyzerStage::all) | AnalyzerStage::peak | AnalyzerStage::rms;
+
+  LOG_INFO("Setting analyzer stages of slot " + juce::String(slotIndex) +
+           " to " + juce::String(selected));
+
+  slotAnalyzerStages[slotIndex].store(selected, std::memory_order_relaxed);
+  return true;
+}
+
+int BufferProcessor::getSlotAnalyzerStages(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return 0;
+
+  return slotAnalyzerStages[slotIndex].load(std::memory_order_relaxed);
+}
+
+bool BufferProcessor::setSlotSamplesTapped(int slotIndex, bool shouldTap) {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS) {
+    LOG_ERROR("Invalid slot index: " + juce::String(slotIndex));
+    return false;
+  }
+
+  slotSamplesTapped[slotIndex].store(shouldTap, std::memory_order_relaxed);
+  return true;
+}
+
+SampleFifo *BufferProcessor::getSlotSamples(int slotIndex) {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return nullptr;
+
+  return slotSamples[(size_t)slotIndex].get();
+}
+
+float BufferProcessor::getSlotDcOffset(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return 0.0f;
+
+  return slotDcOffsets[slotIndex].load(std::memory_order_relaxed);
+}
+
+int BufferProcessor::getSlotClippedSamples(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return 0;
+
+  return slotClippedSamples[slotIndex].load(std::memory_order_relaxed);
+}
+
+bool BufferProcessor::setSlotMeterType(int slotIndex, MeterType type) {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS) {
+    LOG_ERROR("Invalid slot index: " + juce::String(slotIndex));
+    return false;
+  }
+
+  LOG_INFO("Setting meter type of slot " + juce::String(slotIndex) + " to " +
+           (type == MeterType::vu ? "VU" : "PPM"));
+
+  slotMeterTypes[slotIndex].store(type, std::memory_order_relaxed);
+  return true;
+}
+
+BufferProcessor::MeterType
+BufferProcessor::getSlotMeterType(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return MeterType::vu;
+
+  return slotMeterTypes[slotIndex].load(std::memory_order_relaxed);
+}
+
+float BufferProcessor::getSlotMeterLevel(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return 0.0f;
+
+  return slotMeterLevels[slotIndex].load(std::memory_order_relaxed);
+}
+
+float BufferProcessor::getSlotMeterPeakHold(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return 0.0f;
+
+  return slotMeterPeakHolds[slotIndex].load(std::memory_order_relaxed);
+}
+
+float BufferProcessor::getSlotTruePeakLevel(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return 0.0f;
+
+  return slotTruePeakLevels[slotIndex].load(std::memory_order_relaxed);
+}
+
+float BufferProcessor::getChannelTruePeak(int channelIndex) const {
+  if (channelIndex < 0 || channelIndex >= MAX_CHANNELS)
+    return 0.0f;
+
+  return channelTruePeaks[(size_t)channelIndex].load(
+      std::memory_order_relaxed);
+}
+
+const LevelHistory *BufferProcessor::getChannelHistory(int channelIndex) const {
+  if (channelIndex < 0 || channelIndex >= MAX_CHANNELS)
+    return nullptr;
+
+  return channelHistories[(size_t)channelIndex].get();
+}
+
+AlarmEngine &BufferProcessor::getAlarmEngine() { return alarmEngine; }
+
+const AlarmEngine &BufferProcessor::getAlarmEngine() const {
+  return alarmEngine;
+}
+
+LoudnessMeter::Reading BufferProcessor::getSlotLoudness(int slotIndex) const {
+  return loudnessAnalyzer.getSlotReading(slotIndex);
+}
+
+bool BufferProcessor::setLoudnessGroup(int groupIndex,
+                                       std::vector<int> channels,
+                                       std::vector<float> weights) {
+  for (int channel : channels) {
+    if (channel < 0 || channel >= MAX_CHANNELS) {
+      LOG_ERROR("Invalid loudness group channel: " + juce::String(channel));
+      return false;
+    }
   }
+
+  const int numChannels = (int)channels.size();
+  const juce::ScopedLock sl(bufferLock);
+
+  if (!loudnessAnalyzer.setGroup(groupIndex, std::move(channels),
+                                 std::move(weights))) {
+    LOG_ERROR("Invalid loudness group " + juce::String(groupIndex));
+    return false;
+  }
+
+  LOG_INFO("Loudness group " + juce::String(groupIndex) + " set to " +
+           juce::String(numChannels) + " channels");
+  return true;
+}
+
+LoudnessMeter::Reading BufferProcessor::getGroupLoudness(int groupIndex) const {
+  return loudnessAnalyzer.getGroupReading(groupIndex);
+}
+
+void BufferProcessor::resetLoudness() {
+  LOG_INFO("Resetting loudness measurements");
+
+  const juce::ScopedLock sl(bufferLock);
+  loudnessAnalyzer.resetAll();
+}
+
+LatencyTracker::Stamp BufferProcessor::getSlotStamp(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= NUM_MONITOR_SLOTS)
+    return {};
+
+  return slotStamps[slotIndex];
+}
+
+bool BufferProcessor::addBufferCallback(BufferCallback callback) {
+  if (!callback)
+    return false;
+
+  const juce::ScopedLock sl(callbackLock);
+  const int index = numBufferCallbacks.load();
+
+  if (index == MAX_BUFFER_CALLBACKS) {
+    LOG_ERROR("Cannot add more than " + juce::String(MAX_BUFFER_CALLBACKS) +
+              " buffer callbacks");
+    return false;
+  }
+
+  bufferCallbacks[(size_t)index] = std::move(callback);
+  numBufferCallbacks.store(index + 1, std::memory_order_release);
+  LOG_INFO("Added buffer callback");
+  return true;
 }
 
 void BufferProcessor::prepareToPlay(double sampleRate, int bufferSize) {
@@ -80,11 +458,35 @@ void BufferProcessor::prepareToPlay(double sampleRate, int bufferSize) {
 
   const juce::ScopedLock sl(bufferLock);
 
-  // Prepare monitoring buffers
+  preparedBlockSize = juce::jmax(1, bufferSize);
+  prepareFraming();
+
+  publishedSampleRate.store(sampleRate, std::memory_order_relaxed);
+  loudnessAnalyzer.prepare(sampleRate);
+  vuMeters.prepare(sampleRate, NUM_MONITOR_SLOTS);
+  ppmMeters.prepare(sampleRate, NUM_MONITOR_SLOTS);
+  inputTruePeak.prepare(sampleRate, MAX_CHANNELS);
+  slotTruePeak.prepare(sampleRate, NUM_MONITOR_SLOTS);
+
+  for (auto &history : channelHistories)
+    history->prepare(sampleRate);
+
+  alarmEngine.prepare(sampleRate);
+}
+
+void BufferProcessor::prepareFraming() {
+  analysisFramer.prepare(analysisHopSize, preparedBlockSize);
+
+  // Analysis blocks never exceed this, so nothing below grows on the audio
+  // thread
+  const int maxBlockSize = analysisFramer.getMaxBlockSize();
+
   for (int i = 0; i < NUM_MONITOR_SLOTS; ++i) {
-    monitorBuffers[i].setSize(1, bufferSize);
+    monitorBuffers[i].setSize(1, maxBlockSize);
     monitorBuffers[i].clear();
   }
+
+  matrixMixer.prepare(maxBlockSize);
 }
 
 void BufferProcessor::releaseResources() {
@@ -92,10 +494,89 @@ void BufferProcessor::releaseResources() {
 
   const juce::ScopedLock sl(bufferLock);
 
+  // A partial hop must not be joined to the next stream's samples
+  analysisFramer.reset();
+
   // Clear monitoring buffers
   for (int i = 0; i < NUM_MONITOR_SLOTS; ++i) {
     monitorBuffers[i].clear();
+    slotPeakLevels[i] = 0.0f;
+    slotRmsLevels[i] = 0.0f;
+    slotDcOffsets[i] = 0.0f;
+    slotClippedSamples[i] = 0;
+    slotTruePeakLevels[i] = 0.0f;
+    slotMeterLevels[i] = 0.0f;
+    slotMeterPeakHolds[i] = 0.0f;
   }
+
+  // Sample taps are left alone: their readers keep pointers to the FIFOs
+  // and their tap flags are the UI's, and a reader merely draws the old
+  // stream's last samples
+
+  for (auto &level : channelTruePeaks)
+    level.store(0.0f, std::memory_order_relaxed);
+}
+
+void BufferProcessor::applyPendingRoutingCommands() {
+  const int numReady = routingFifo.getNumReady();
+  routingQueueDepth.set((double)numReady);
+
+  const auto scope = routingFifo.read(numReady);
+
+  for (int i = 0; i < scope.blockSize1; ++i) {
+    const auto &command = routingCommands[(size_t)(scope.startIndex1 + i)];
+    monitorChannels[command.slotIndex] = command.channelIndex;
+  }
+
+  for (int i = 0; i < scope.blockSize2; ++i) {
+    const auto &command = routingCommands[(size_t)(scope.startIndex2 + i)];
+    monitorChannels[command.slotIndex] = command.channelIndex;
+  }
+}
+
+void BufferProcessor::processMeterBallistics(const float *const *slotSources,
+                                             int numSamples) {
+  const auto startTicks = juce::Time::getHighResolutionTicks();
+
+  std::array<const float *, NUM_MONITOR_SLOTS> vuSources{}, ppmSources{};
+
+  for (int slotIndex = 0; slotIndex < NUM_MONITOR_SLOTS; ++slotIndex) {
+    const auto type = slotMeterTypes[slotIndex].load(std::memory_order_relaxed);
+
+    // A switched meter starts from rest rather than from a stale reading
+    if (type != appliedMeterTypes[slotIndex]) {
+      if (type == MeterType::vu)
+        vuMeters.resetChannel(slotIndex);
+      else
+        ppmMeters.resetChannel(slotIndex);
+
+      appliedMeterTypes[slotIndex] = type;
+    }
+
+    auto &sources = type == MeterType::vu ? vuSources : ppmSources;
+    sources[(size_t)slotIndex] = slotSources[slotIndex];
+  }
+
+  vuMeters.process(vuSources.data(), NUM_MONITOR_SLOTS, numSamples);
+  ppmMeters.process(ppmSources.data(), NUM_MONITOR_SLOTS, numSamples);
+
+  for (int slotIndex = 0; slotIndex < NUM_MONITOR_SLOTS; ++slotIndex) {
+    float level, peakHold;
+
+    if (appliedMeterTypes[slotIndex] == MeterType::vu) {
+      level = vuMeters.getLevel(slotIndex);
+      peakHold = level;
+    } else {
+      level = ppmMeters.getLevel(slotIndex);
+      peakHold = ppmMeters.getPeakHold(slotIndex);
+    }
+
+    slotMeterLevels[slotIndex].store(level, std::memory_order_relaxed);
+    slotMeterPeakHolds[slotIndex].store(peakHold, std::memory_order_relaxed);
+  }
+
+  ballisticsAnalysisTicks.add(
+      (juce::uint64)(juce::Time::getHighResolutionTicks() - startTicks));
 }
 
 void BufferProcessor::processAudio(const float *const *inputChannelData,
@@ -103,31 +584,154 @@ void BufferProcessor::processAudio(const float *const *inputChannelData,
   // Process audio for each monitoring slot
   const juce::ScopedLock sl(bufferLock);
 
+  // Device blocks of any size become analysis blocks of the hop size, or of
+  // at most the prepared size
+  analysisFramer.process(
+      inputChannelData, numInputChannels, numSamples,
+      [this](const float *const *channels, int numChannels, int count,
+             int offset) { processHop(channels, numChannels, count, offset); });
+}
+
+void BufferProcessor::processHop(const float *const *inputChannelData,
+                                 int numInputChannels, int numSamples,
+                                 int offset) {
+  // Apply routing changes queued from non-UI control paths (e.g. OSC)
+  applyPendingRoutingCommands();
+
+  // A hop is as old as its first sample, which may have been captured in an
+  // earlier device block
+  auto hopStamp = blockStamp;
+  if (hopStamp.isValid() && currentSampleRate > 0.0)
+    hopStamp.captureNs = juce::jmax(
+        (juce::int64)1,
+        hopStamp.captureNs + (juce::int64)(offset * 1.0e9 / currentSampleRate));
+
+  // Derived channels are mixed on first use below, once however many slots
+  // select them
+  matrixMixer.beginBlock(inputChannelData, numInputChannels, numSamples);
+
+  std::array<const float *, NUM_MONITOR_SLOTS> slotSources{};
+
   for (int slotIndex = 0; slotIndex < NUM_MONITOR_SLOTS; ++slotIndex) {
     int channelIndex = monitorChannels[slotIndex];
+    const float *source = nullptr;
+
+    if (channelIndex >= MAX_CHANNELS)
+      source = matrixMixer.getOutput(channelIndex - MAX_CHANNELS);
+    else if (channelIndex >= 0 && channelIndex < numInputChannels)
+      source = inputChannelData[channelIndex];
+
+    slotSources[(size_t)slotIndex] = source;
+
+    // A new source is a new programme for loudness, and its true peak must
+    // not be interpolated from the old source's samples
+    if (loudnessChannels[slotIndex] != channelIndex) {
+      loudnessAnalyzer.resetSlot(slotIndex);
+      slotTruePeak.resetChannel(slotIndex);
+      loudnessChannels[slotIndex] = channelIndex;
+    }
+  }
+
+  // Meter readings are current before the callbacks below read them
+  processMeterBallistics(slotSources.data(), numSamples);
+
+  for (int slotIndex = 0; slotIndex < NUM_MONITOR_SLOTS; ++slotIndex) {
+    const float *source = slotSources[(size_t)slotIndex];
 
     // Skip slots with no channel assigned
-    if (channelIndex < 0 || channelIndex >= numInputChannels)
+    if (source == nullptr)
       continue;
 
     // Get the buffer for this slot
     juce::AudioBuffer<float> &buffer = monitorBuffers[slotIndex];
 
-    // Ensure buffer is the right size
+    // Match the block; it is within the prepared size, so this never
+    // reallocates
     if (buffer.getNumSamples() != numSamples) {
-      buffer.setSize(1, numSamples, false, true, true);
+      buffer.setSize(1, numSamples, false, false, true);
     }
 
     // Copy the input channel data to our buffer
-    juce::FloatVectorOperations::copy(
-        buffer.getWritePointer(0), inputChannelData[channelIndex], numSamples);
+    juce::FloatVectorOperations::copy(buffer.getWritePointer(0), source,
+                                      numSamples);
+
+    // Publish block levels for telemetry readers; the slot's statistics
+    // are computed together in one pass over the aligned copy
+    const auto levelStartTicks = juce::Time::getHighResolutionTicks();
+    const auto analyze = analyzerPipelines.find(
+        slotAnalyzerStages[slotIndex].load(std::memory_order_relaxed));
+    BlockStatistics statistics;
+    analyze(buffer.getReadPointer(0), numSamples, statistics);
+    slotPeakLevels[slotIndex].store(statistics.peak,
+                                    std::memory_order_relaxed);
+    slotRmsLevels[slotIndex].store(statistics.rms, std::memory_order_relaxed);
+    slotDcOffsets[slotIndex].store(statistics.dcOffset,
+                                   std::memory_order_relaxed);
+    slotClippedSamples[slotIndex].store(statistics.clippedSamples,
+                                        std::memory_order_relaxed);
+
+    const auto callbackStartTicks = juce::Time::getHighResolutionTicks();
+    levelAnalysisTicks.add(
+        (juce::uint64)(callbackStartTicks - levelStartTicks));
+
+    // Hand the samples to the slot's reader, e.g. a scope
+    if (slotSamplesTapped[slotIndex].load(std::memory_order_relaxed))
+      slotSamples[(size_t)slotIndex]->push(buffer.getReadPointer(0),
+                                           numSamples);
+
+    // Carry the hop's latency stamp to the callbacks
+    slotStamps[slotIndex] = hopStamp;
+    if (hopStamp.isValid())
+      slotStamps[slotIndex].analysisNs = LatencyTracker::nowNs();
 
     // Notify callbacks about the new data
-    const juce::ScopedLock callbackLock(this->callbackLock);
-    for (const auto &callback : bufferCallbacks) {
-      callback(slotIndex, buffer);
-    }
+    const int numCallbacks =
+        numBufferCallbacks.load(std::memory_order_acquire);
+    for (int i = 0; i < numCallbacks; ++i)
+      bufferCallbacks[(size_t)i](slotIndex, buffer);
+
+    callbackAnalysisTicks.add((juce::uint64)(
+        juce::Time::getHighResolutionTicks() - callbackStartTicks));
+  }
+
+  const auto loudnessStartTicks = juce::Time::getHighResolutionTicks();
+  loudnessAnalyzer.process(slotSources.data(), inputChannelData,
+                           numInputChannels, numSamples);
+  const auto truePeakStartTicks = juce::Time::getHighResolutionTicks();
+  loudnessAnalysisTicks.add(
+      (juce::uint64)(truePeakStartTicks - loudnessStartTicks));
+
+  const int numTruePeakChannels = juce::jmin(numInputChannels, MAX_CHANNELS);
+  inputTruePeak.process(inputChannelData, numTruePeakChannels, numSamples);
+  slotTruePeak.process(slotSources.data(), NUM_MONITOR_SLOTS, numSamples);
+
+  for (int channel = 0; channel < MAX_CHANNELS; ++channel)
+    channelTruePeaks[(size_t)channel].store(inputTruePeak.getPeak(channel),
+                                            std::memory_order_relaxed);
+
+  for (int slotIndex = 0; slotIndex < NUM_MONITOR_SLOTS; ++slotIndex)
+    slotTruePeakLevels[slotIndex].store(slotTruePeak.getPeak(slotIndex),
+                                        std::memory_order_relaxed);
+
+  const auto alarmStartTicks = juce::Time::getHighResolutionTicks();
+  truePeakAnalysisTicks.add(
+      (juce::uint64)(alarmStartTicks - truePeakStartTicks));
+
+  alarmEngine.process(inputChannelData, numTruePeakChannels, numSamples);
+
+  const auto historyStartTicks = juce::Time::getHighResolutionTicks();
+  alarmAnalysisTicks.add((juce::uint64)(historyStartTicks - alarmStartTicks));
+
+  // Each input channel's block RMS, from the alarms' pass, feeds its level
+  // history
+  for (int channel = 0; channel < numTruePeakChannels; ++channel) {
+    if (inputChannelData[channel] != nullptr)
+      channelHistories[(size_t)channel]->push(
+          alarmEngine.getStatistics(channel).rms, numSamples);
   }
+
+  historyAnalysisTicks.add((juce::uint64)(
+      juce::Time::getHighResolutionTicks() - historyStartTicks));
 }
 
 } // namespace mcam
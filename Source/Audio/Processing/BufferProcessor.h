@@ -1,8 +1,19 @@
 #pragma once
 
 #include "../../Core/Logger.h"
+#include "../../Core/Metrics.h"
 #include "../../JuceHeader.h"
+#include "../../Processing/Analysis/AlarmEngine.h"
+#include "../../Processing/Analysis/AnalyzerPipeline.h"
+#include "../../Processing/Analysis/LoudnessAnalyzer.h"
+#include "../../Processing/Analysis/SampleFifo.h"
+#include "../../Processing/Analysis/TruePeakMeter.h"
+#include "../../Processing/Metering/LevelHistory.h"
+#include "../../Processing/Metering/PPMMeterCalculator.h"
+#include "../../Processing/Metering/VUMeterCalculator.h"
 #include "../AudioCallback.h"
+#include "AnalysisFramer.h"
+#include "ChannelMatrixMixer.h"
 
 namespace mcam {
 /**
@@ -15,7 +26,34 @@ public:
   static constexpr int NUM_MONITOR_SLOTS = 4;
 
   /** Maximum number of channels that can be processed */
-  static constexpr int MAX_CHANNELS = 32;
+  static constexpr int MAX_CHANNELS = 128;
+
+  /**
+   * Number of derived channels (sums, M/S, downmixes). Derived channel n is
+   * selected as channel index MAX_CHANNELS + n.
+   */
+  static constexpr int MAX_DERIVED_CHANNELS = ChannelMatrixMixer::MAX_OUTPUTS;
+
+  /** Number of multichannel loudness groups */
+  static constexpr int NUM_LOUDNESS_GROUPS = LoudnessAnalyzer::MAX_GROUPS;
+
+  /** Ballistics of a slot's level meter */
+  enum class MeterType { vu, ppm };
+
+  /** Capacity of the non-blocking routing command queue */
+  static constexpr int ROUTING_QUEUE_SIZE = 64;
+
+  /** Samples a slot's sample tap holds for its reader */
+  static constexpr int SLOT_SAMPLES_CAPACITY = 1 << 17;
+
+  /** Most buffer callbacks that can be added */
+  static constexpr int MAX_BUFFER_CALLBACKS = 8;
+
+  /**
+   * Analysis hop size the application uses unless configured otherwise. A
+   * new processor analyses device blocks as they come (hop size 0).
+   */
+  static constexpr int DEFAULT_ANALYSIS_HOP_SIZE = 256;
 
   /** Constructor */
   BufferProcessor();
@@ -26,11 +64,62 @@ public:
   /**
    * Sets the input channel for a specific monitoring slot
    * @param slotIndex The slot index (0-3)
-   * @param channelIndex The input channel index to route to this slot
+   * @param channelIndex The input channel index to route to this slot, or a
+   * defined derived channel (see getDerivedChannelIndex)
    * @return true if successful
    */
   bool setMonitorChannel(int slotIndex, int channelIndex);
 
+  /**
+   * Queues a routing change without taking the buffer lock. The change is
+   * applied by the audio thread at the start of the next processed block.
+   * Any thread but the audio thread may post, e.g. the OSC receiver and the
+   * message thread; posts are serialised by a short spin lock.
+   * @param slotIndex The slot index (0-3)
+   * @param channelIndex The input channel index to route, or -1 to clear
+   * @return true if the command was queued, false if invalid or queue full
+   */
+  bool postMonitorChannel(int slotIndex, int channelIndex);
+
+  /**
+   * Defines a derived channel that any slot can select. It is mixed once per
+   * block, and only while a slot selects it. Slots keep their selection
+   * when a derived channel is redefined or cleared.
+   * @param derivedIndex The derived channel (0 to MAX_DERIVED_CHANNELS - 1)
+   * @param name Display name, e.g. "Mix L+R"
+   * @param terms Input channels and gains; empty clears the derived channel.
+   * See the ChannelMatrixMixer presets for sums, M/S and downmixes.
+   * @return true if successful
+   */
+  bool setDerivedChannel(int derivedIndex, const juce::String &name,
+                         std::vector<ChannelMatrixMixer::Term> terms);
+
+  /**
+   * @param derivedIndex The derived channel (0 to MAX_DERIVED_CHANNELS - 1)
+   * @return The display name, or an empty string if it is not defined
+   */
+  juce::String getDerivedChannelName(int derivedIndex) const;
+
+  /**
+   * @param derivedIndex The derived channel (0 to MAX_DERIVED_CHANNELS - 1)
+   * @return The stored terms, or none if it is not defined
+   */
+  std::vector<ChannelMatrixMixer::Term>
+  getDerivedChannelTerms(int derivedIndex) const;
+
+  /**
+   * Counts changes to the derived channel definitions, so that views
+   * listing them can poll for changes made from other threads (e.g. OSC)
+   * @return A number that changes whenever a derived channel is set
+   */
+  int getDerivedChannelsRevision() const;
+
+  /**
+   * @param derivedIndex The derived channel (0 to MAX_DERIVED_CHANNELS - 1)
+   * @return The channel index slots use to select it
+   */
+  static int getDerivedChannelIndex(int derivedIndex);
+
   /**
    * Gets the current input channel for a specific monitoring slot
    * @param slotIndex The slot index (0-3)
@@ -45,13 +134,204 @@ public:
    */
   const juce::AudioBuffer<float> *getMonitorBuffer(int slotIndex) const;
 
+  /** @return Sample rate of the blocks passed to callbacks, in Hz */
+  double getSampleRate() const;
+
+  /**
+   * Sets the number of samples every analysis block has, whatever block
+   * sizes the device delivers. Readings, histories, alarms and buffer
+   * callbacks then see the same blocks at any device block size, up to one
+   * hop late. Takes effect at once, discarding any partial hop.
+   * @param hopSize AnalysisFramer::MIN_HOP_SIZE to
+   * AnalysisFramer::MAX_HOP_SIZE, or 0 to analyse device blocks as they
+   * come (split to the prepared block size)
+   * @return true if successful
+   */
+  bool setAnalysisHopSize(int hopSize);
+
+  /** @return The analysis hop size, or 0 if device blocks are analysed */
+  int getAnalysisHopSize() const;
+
+  /**
+   * Gets the sample peak of the last block processed for a slot
+   * @param slotIndex The slot index (0-3)
+   * @return Linear peak level, or 0 if the slot is invalid
+   */
+  float getSlotPeakLevel(int slotIndex) const;
+
+  /**
+   * Gets the RMS level of the last block processed for a slot
+   * @param slotIndex The slot index (0-3)
+   * @return Linear RMS level, or 0 if the slot is invalid
+   */
+  float getSlotRmsLevel(int slotIndex) const;
+
+  /**
+   * Selects the block statistics computed for a slot, which run as one
+   * fused pass from AnalyzerPipelineRegistry. Peak and RMS are always
+   * included, as the level getters above read them.
+   * @param slotIndex The slot index (0-3)
+   * @param stages A set of AnalyzerStage bits
+   * @return true if successful
+   */
+  bool setSlotAnalyzerStages(int slotIndex, int stages);
+
+  /**
+   * @param slotIndex The slot index (0-3)
+   * @return The slot's set of AnalyzerStage bits, or 0 if invalid
+   */
+  int getSlotAnalyzerStages(int slotIndex) const;
+
   /**
-   * Adds a listener that will be notified when new audio data is available
+   * Turns a slot's sample tap on or off. While on, the slot's samples are
+   * queued in getSlotSamples() as each block is analysed, e.g. for a scope.
+   * @param slotIndex The slot index (0-3)
+   * @param shouldTap true to queue the slot's samples
+   * @return true if successful
+   */
+  bool setSlotSamplesTapped(int slotIndex, bool shouldTap);
+
+  /**
+   * Gets the FIFO a slot's sample tap fills, for one reader to drain. The
+   * FIFO lives as long as the processor; device restarts keep it and the
+   * tap.
+   * @param slotIndex The slot index (0-3)
+   * @return The FIFO, or nullptr if the slot is invalid
+   */
+  SampleFifo *getSlotSamples(int slotIndex);
+
+  /**
+   * Gets the DC offset of the last block processed for a slot
+   * @param slotIndex The slot index (0-3)
+   * @return Mean of the block, or 0 if the slot is invalid or the stage
+   * is not selected
+   */
+  float getSlotDcOffset(int slotIndex) const;
+
+  /**
+   * Gets the number of full-scale samples in the last block processed for
+   * a slot
+   * @param slotIndex The slot index (0-3)
+   * @return Clipped samples, or 0 if the slot is invalid or the stage is
+   * not selected
+   */
+  int getSlotClippedSamples(int slotIndex) const;
+
+  /**
+   * Gets the BS.1770 true peak of the last block processed for a slot,
+   * including the inter-sample overs getSlotPeakLevel misses
+   * @param slotIndex The slot index (0-3)
+   * @return Linear true peak level, or 0 if the slot is invalid
+   */
+  float getSlotTruePeakLevel(int slotIndex) const;
+
+  /**
+   * Gets the BS.1770 true peak of an input channel over the last block
+   * @param channelIndex The input channel index
+   * @return Linear true peak level, or 0 if the channel is invalid or absent
+   */
+  float getChannelTruePeak(int channelIndex) const;
+
+  /**
+   * Gets the level history of an input channel: the RMS of every block,
+   * kept at 100 ms to 1 min resolutions. It outlives device restarts and
+   * may be read from any thread while audio runs.
+   * @param channelIndex The input channel index
+   * @return The channel's history, or nullptr if the channel is invalid
+   */
+  const LevelHistory *getChannelHistory(int channelIndex) const;
+
+  /**
+   * Gets the alarms of the input channels, evaluated every block. Its
+   * settings, active flags and events may be used from any thread.
+   */
+  AlarmEngine &getAlarmEngine();
+
+  /** @return The alarms of the input channels */
+  const AlarmEngine &getAlarmEngine() const;
+
+  /**
+   * Selects the ballistics of a slot's meter, which starts again from rest
+   * at the next block
+   * @param slotIndex The slot index (0-3)
+   * @param type VU or PPM ballistics
+   * @return true if successful
+   */
+  bool setSlotMeterType(int slotIndex, MeterType type);
+
+  /**
+   * @param slotIndex The slot index (0-3)
+   * @return The slot's meter type, or VU if the slot is invalid
+   */
+  MeterType getSlotMeterType(int slotIndex) const;
+
+  /**
+   * Gets the reading of a slot's meter at the end of the last block, with
+   * the ballistics of its meter type
+   * @param slotIndex The slot index (0-3)
+   * @return Linear level (a steady sine reads its peak), or 0 if invalid
+   */
+  float getSlotMeterLevel(int slotIndex) const;
+
+  /**
+   * Gets the peak hold of a slot's PPM; a VU meter has none and returns
+   * its reading
+   * @param slotIndex The slot index (0-3)
+   * @return Linear level, or 0 if the slot is invalid
+   */
+  float getSlotMeterPeakHold(int slotIndex) const;
+
+  /**
+   * Gets the EBU R128 loudness of a slot's source. Measurement restarts
+   * when the slot's channel changes.
+   * @param slotIndex The slot index (0-3)
+   * @return Momentary, short-term, integrated loudness and loudness range
+   */
+  LoudnessMeter::Reading getSlotLoudness(int slotIndex) const;
+
+  /**
+   * Defines a multichannel loudness group, e.g. the six channels of a 5.1
+   * bed, measured as one programme
+   * @param groupIndex The group index (0 to NUM_LOUDNESS_GROUPS - 1)
+   * @param channels Input channels in SMPTE order; empty clears the group
+   * @param weights Weight per channel; empty uses the BS.1770 weights for
+   * the channel count (see LoudnessAnalyzer::getChannelWeights)
+   * @return true if successful
+   */
+  bool setLoudnessGroup(int groupIndex, std::vector<int> channels,
+                        std::vector<float> weights = {});
+
+  /**
+   * @param groupIndex The group index (0 to NUM_LOUDNESS_GROUPS - 1)
+   * @return The group's loudness readings
+   */
+  LoudnessMeter::Reading getGroupLoudness(int groupIndex) const;
+
+  /** Restarts every loudness measurement (integrated and range) */
+  void resetLoudness();
+
+  /**
+   * Gets the latency stamp of the block being delivered to buffer callbacks.
+   * Only meaningful when called from inside a buffer callback, and only
+   * valid when LatencyTracker instrumented mode is enabled.
+   * @param slotIndex The slot index (0-3)
+   * @return Stamp with capture, callback and analysis times set
+   */
+  LatencyTracker::Stamp getSlotStamp(int slotIndex) const;
+
+  /**
+   * Adds a listener that will be notified when new audio data is available.
+   * Callbacks run on the audio thread after the slot's analysis, once per
+   * slot and block, so they should only hand results on (e.g. to the UI);
+   * analysis belongs in the processor's stages, and a slot's samples are
+   * available without a callback from its sample tap. Callbacks cannot be
+   * removed.
    * @param callback Function to call when new data is available
+   * @return false if MAX_BUFFER_CALLBACKS have already been added
    */
   using BufferCallback =
       std::function<void(int slotIndex, const juce::AudioBuffer<float> &)>;
-  void addBufferCallback(BufferCallback callback);
+  bool addBufferCallback(BufferCallback callback);
 
 protected:
   /** Overridden from AudioCallback */
@@ -61,20 +341,135 @@ protected:
                     int numSamples) override;
 
 private:
+  /**
+   * Sizes the framer and the per-block buffers for the hop size and the
+   * prepared block size. Called with bufferLock held.
+   */
+  void prepareFraming();
+
+  /**
+   * Analyses one block from the framer and notifies the buffer callbacks.
+   * Called with bufferLock held.
+   * @param offset Position of the block's first sample in the device block,
+   * negative if it was held from an earlier one
+   */
+  void processHop(const float *const *inputChannelData, int numInputChannels,
+                  int numSamples, int offset);
+
+  /** A routing change queued by postMonitorChannel */
+  struct RoutingCommand {
+    int slotIndex;
+    int channelIndex;
+  };
+
+  /** Applies queued routing commands. Called with bufferLock held. */
+  void applyPendingRoutingCommands();
+
+  /**
+   * Advances the slot meters over a block and publishes their readings.
+   * Called with bufferLock held.
+   */
+  void processMeterBallistics(const float *const *slotSources,
+                              int numSamples);
+
+  /** @return true if channelIndex is -1, an input or a defined derived one */
+  bool isSelectableChannel(int channelIndex) const;
+
   // The input channel assigned to each monitoring slot
   std::array<int, NUM_MONITOR_SLOTS> monitorChannels;
 
-  // Buffer for each monitoring slot
+  // Derived channels, defined under bufferLock. The mask mirrors which are
+  // defined for validation on the lock-free routing path.
+  ChannelMatrixMixer matrixMixer;
+  std::array<juce::String, MAX_DERIVED_CHANNELS> derivedChannelNames;
+  std::atomic<juce::uint32> definedDerivedChannels{0};
+  std::atomic<int> derivedChannelsRevision{0};
+
+  // EBU R128 loudness of the slot sources and groups, and the channel each
+  // slot was measuring (audio thread only)
+  LoudnessAnalyzer loudnessAnalyzer{NUM_MONITOR_SLOTS};
+  std::array<int, NUM_MONITOR_SLOTS> loudnessChannels;
+
+  // Fused block statistics per slot, chosen from the precompiled pipelines
+  const AnalyzerPipelineRegistry &analyzerPipelines;
+  std::array<std::atomic<int>, NUM_MONITOR_SLOTS> slotAnalyzerStages;
+
+  // Meter ballistics per slot. Only the selected type is fed; the type the
+  // audio thread last applied is kept to start a switched meter from rest.
+  VUMeterCalculator vuMeters;
+  PPMMeterCalculator ppmMeters;
+  std::array<std::atomic<MeterType>, NUM_MONITOR_SLOTS> slotMeterTypes;
+  std::array<MeterType, NUM_MONITOR_SLOTS> appliedMeterTypes;
+
+  // True peak of every input channel and of the slot sources (audio thread
+  // only; readings are published through the atomics below)
+  TruePeakMeter inputTruePeak;
+  TruePeakMeter slotTruePeak;
+
+  // Alarms of every input channel; its statistics also feed the level
+  // histories
+  AlarmEngine alarmEngine{MAX_CHANNELS};
+
+  // Cuts device blocks into analysis blocks. Block sizes are set under
+  // bufferLock; the prepared size is 0 until prepareToPlay.
+  AnalysisFramer analysisFramer{MAX_CHANNELS};
+  int analysisHopSize = 0;
+  int preparedBlockSize = 0;
+
+  // Buffer for each monitoring slot, sized for the longest analysis block
   std::array<juce::AudioBuffer<float>, NUM_MONITOR_SLOTS> monitorBuffers;
 
+  // Rate of the current stream, readable from any thread
+  std::atomic<double> publishedSampleRate{48000.0};
+
+  // Levels of the last block per slot, readable from any thread
+  std::array<std::atomic<float>, NUM_MONITOR_SLOTS> slotPeakLevels;
+  std::array<std::atomic<float>, NUM_MONITOR_SLOTS> slotRmsLevels;
+  std::array<std::atomic<float>, NUM_MONITOR_SLOTS> slotDcOffsets;
+  std::array<std::atomic<int>, NUM_MONITOR_SLOTS> slotClippedSamples;
+  std::array<std::atomic<float>, NUM_MONITOR_SLOTS> slotTruePeakLevels;
+  std::array<std::atomic<float>, NUM_MONITOR_SLOTS> slotMeterLevels;
+  std::array<std::atomic<float>, NUM_MONITOR_SLOTS> slotMeterPeakHolds;
+  std::array<std::atomic<float>, MAX_CHANNELS> channelTruePeaks;
+
+  // Level history per input channel, written by the audio thread
+  std::vector<std::unique_ptr<LevelHistory>> channelHistories;
+
+  // Latency stamps of the current analysis block, per slot (audio thread
+  // only)
+  std::array<LatencyTracker::Stamp, NUM_MONITOR_SLOTS> slotStamps;
+
+  // Non-blocking routing commands (audio thread consumer). Producers take
+  // routingPostLock, which the audio thread never does.
+  juce::AbstractFifo routingFifo{ROUTING_QUEUE_SIZE};
+  std::array<RoutingCommand, ROUTING_QUEUE_SIZE> routingCommands;
+  juce::SpinLock routingPostLock;
+
   // Lock for thread-safe buffer access
   mutable juce::CriticalSection bufferLock;
 
-  // Callbacks for new audio data
-  std::vector<BufferCallback> bufferCallbacks;
+  // Sample taps per slot, filled while tapped. Allocated once by the
+  // constructor, so readers may keep the pointers across device restarts.
+  std::array<std::unique_ptr<SampleFifo>, NUM_MONITOR_SLOTS> slotSamples;
+  std::array<std::atomic<bool>, NUM_MONITOR_SLOTS> slotSamplesTapped;
+
+  // Callbacks for new audio data. Entries are written once, under
+  // callbackLock, before the count that makes them visible is raised; the
+  // audio thread reads the count and takes no lock.
+  std::array<BufferCallback, MAX_BUFFER_CALLBACKS> bufferCallbacks;
+  std::atomic<int> numBufferCallbacks{0};
+  juce::CriticalSection callbackLock;
 
-  // Lock for callback list access
-  mutable juce::CriticalSection callbackLock;
+  // Instrumentation, updated from the audio thread without locking
+  metrics::Gauge &routingQueueDepth;
+  metrics::Counter &routingQueueDrops;
+  metrics::Counter &levelAnalysisTicks;
+  metrics::Counter &ballisticsAnalysisTicks;
+  metrics::Counter &loudnessAnalysisTicks;
+  metrics::Counter &truePeakAnalysisTicks;
+  metrics::Counter &alarmAnalysisTicks;
+  metrics::Counter &historyAnalysisTicks;
+  metrics::Counter &callbackAnalysisTicks;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BufferProcessor)
 };
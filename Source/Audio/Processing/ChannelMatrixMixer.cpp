@@ -0,0 +1,253 @@
+#include "ChannelMatrixMixer.h"
+
+namespace mcam {
+
+namespace {
+// -3 dB, the BS.775 gain for centre and surrounds
+constexpr float MINUS_3_DB = 0.70710678f;
+} // namespace
+
+std::vector<ChannelMatrixMixer::Term> ChannelMatrixMixer::sum(int left,
+                                                              int right) {
+  return {{left, 1.0f}, {right, 1.0f}};
+}
+
+std::vector<ChannelMatrixMixer::Term> ChannelMatrixMixer::mid(int left,
+                                                              int right) {
+  return {{left, 0.5f}, {right, 0.5f}};
+}
+
+std::vector<ChannelMatrixMixer::Term> ChannelMatrixMixer::side(int left,
+                                                               int right) {
+  return {{left, 0.5f}, {right, -0.5f}};
+}
+
+std::vector<ChannelMatrixMixer::Term>
+ChannelMatrixMixer::downmix(BedLayout layout, int firstInput,
+                            DownmixOutput output) {
+  const int l = firstInput, r = firstInput + 1, c = firstInput + 2;
+
+  // Surround inputs on each side; the LFE (firstInput + 3) is not used
+  std::vector<int> leftSurrounds{firstInput + 4};
+  std::vector<int> rightSurrounds{firstInput + 5};
+
+  if (layout == BedLayout::surround71) {
+    leftSurrounds.push_back(firstInput + 6);
+    rightSurrounds.push_back(firstInput + 7);
+  }
+
+  std::vector<Term> terms;
+
+  auto addSide = [&](int front, const std::vector<int> &surrounds,
+                     float scale) {
+    terms.push_back({front, scale});
+    terms.push_back({c, MINUS_3_DB * scale});
+
+    for (int surround : surrounds)
+      terms.push_back({surround, MINUS_3_DB * scale});
+  };
+
+  switch (output) {
+  case DownmixOutput::left:
+    addSide(l, leftSurrounds, 1.0f);
+    break;
+  case DownmixOutput::right:
+    addSide(r, rightSurrounds, 1.0f);
+    break;
+  case DownmixOutput::mono:
+    // The centre appears on both sides and is merged by setOutput()
+    addSide(l, leftSurrounds, 0.5f);
+    addSide(r, rightSurrounds, 0.5f);
+    break;
+  }
+
+  return terms;
+}
+
+std::vector<ChannelMatrixMixer::Term>
+ChannelMatrixMixer::fromGains(const std::vector<float> &gains,
+                              int firstInput) {
+  std::vector<Term> terms;
+
+  for (size_t i = 0; i < gains.size(); ++i)
+    if (gains[i] != 0.0f)
+      terms.push_back({firstInput + (int)i, gains[i]});
+
+  return terms;
+}
+
+juce::String
+ChannelMatrixMixer::termsToString(const std::vector<Term> &terms) {
+  juce::StringArray items;
+
+  for (const auto &term : terms)
+    items.add(juce::String(term.input + 1) + ":" + juce::String(term.gain));
+
+  return items.joinIntoString(",");
+}
+
+bool ChannelMatrixMixer::termsFromString(const juce::String &text,
+                                         std::vector<Term> &terms) {
+  auto items = juce::StringArray::fromTokens(text, ",", "");
+  items.trim();
+  items.removeEmptyStrings();
+
+  std::vector<Term> parsed;
+
+  for (const auto &item : items) {
+    const auto input = item.upToFirstOccurrenceOf(":", false, false).trim();
+    const auto gain = item.fromFirstOccurrenceOf(":", false, false).trim();
+
+    if (input.isEmpty() || !input.containsOnly("0123456789") ||
+        input.getIntValue() < 1)
+      return false;
+
+    if (item.containsChar(':') &&
+        (gain.isEmpty() || !gain.containsOnly("0123456789.-+eE")))
+      return false;
+
+    parsed.push_back({input.getIntValue() - 1,
+                      gain.isEmpty() ? 1.0f : gain.getFloatValue()});
+  }
+
+  terms = std::move(parsed);
+  return true;
+}
+
+ChannelMatrixMixer::ChannelMatrixMixer() = default;
+
+void ChannelMatrixMixer::prepare(int maxBlockSize) {
+  mixBuffer.setSize(MAX_OUTPUTS, juce::jmax(1, maxBlockSize));
+  mixBuffer.clear();
+
+  for (auto &output : outputs) {
+    output.mixedBlock = 0;
+    output.result = nullptr;
+  }
+}
+
+bool ChannelMatrixMixer::setOutput(int output, std::vector<Term> terms) {
+  if (output < 0 || output >= MAX_OUTPUTS)
+    return false;
+
+  for (const auto &term : terms)
+    if (term.input < 0)
+      return false;
+
+  // Sort by input so repeated inputs are adjacent and reads run forwards
+  std::sort(terms.begin(), terms.end(), [](const Term &a, const Term &b) {
+    return a.input < b.input;
+  });
+
+  std::vector<Term> merged;
+  merged.reserve(terms.size());
+
+  for (const auto &term : terms) {
+    if (!merged.empty() && merged.back().input == term.input)
+      merged.back().gain += term.gain;
+    else
+      merged.push_back(term);
+  }
+
+  merged.erase(std::remove_if(merged.begin(), merged.end(),
+                              [](const Term &term) {
+                                return term.gain == 0.0f ||
+                                       !std::isfinite(term.gain);
+                              }),
+               merged.end());
+
+  outputs[(size_t)output].terms = std::move(merged);
+  outputs[(size_t)output].mixedBlock = 0;
+  return true;
+}
+
+bool ChannelMatrixMixer::isOutputDefined(int output) const {
+  return getNumTerms(output) > 0;
+}
+
+int ChannelMatrixMixer::getNumTerms(int output) const {
+  if (output < 0 || output >= MAX_OUTPUTS)
+    return 0;
+
+  return (int)outputs[(size_t)output].terms.size();
+}
+
+std::vector<ChannelMatrixMixer::Term>
+ChannelMatrixMixer::getTerms(int output) const {
+  if (output < 0 || output >= MAX_OUTPUTS)
+    return {};
+
+  return outputs[(size_t)output].terms;
+}
+
+void ChannelMatrixMixer::beginBlock(const float *const *inputChannelData,
+                                    int numInputChannels, int numSamples) {
+  inputs = inputChannelData;
+  numInputs = numInputChannels;
+  blockSize = numSamples;
+  numMixed = 0;
+  ++blockCount;
+
+  // BufferProcessor frames blocks to the prepared size; other callers that
+  // exceed it grow the buffer rather than drop the block
+  if (numSamples > mixBuffer.getNumSamples())
+    mixBuffer.setSize(MAX_OUTPUTS, numSamples, false, false, true);
+}
+
+const float *ChannelMatrixMixer::getOutput(int output) {
+  if (output < 0 || output >= MAX_OUTPUTS)
+    return nullptr;
+
+  auto &state = outputs[(size_t)output];
+
+  if (state.terms.empty())
+    return nullptr;
+
+  if (state.mixedBlock != blockCount) {
+    state.result = mix(state.terms, mixBuffer.getWritePointer(output));
+    state.mixedBlock = blockCount;
+    ++numMixed;
+  }
+
+  return state.result;
+}
+
+int ChannelMatrixMixer::getNumOutputsMixed() const { return numMixed; }
+
+const float *ChannelMatrixMixer::mix(const std::vector<Term> &terms,
+                                     float *dest) {
+  // A lone unity term is the input itself; no copy needed
+  if (terms.size() == 1 && terms[0].gain == 1.0f &&
+      terms[0].input < numInputs)
+    return inputs[terms[0].input];
+
+  bool first = true;
+
+  for (const auto &term : terms) {
+    if (term.input >= numInputs)
+      continue; // Not provided by the current device
+
+    const float *source = inputs[term.input];
+
+    if (first) {
+      if (term.gain == 1.0f)
+        juce::FloatVectorOperations::copy(dest, source, blockSize);
+      else
+        juce::FloatVectorOperations::copyWithMultiply(dest, source, term.gain,
+                                                      blockSize);
+      first = false;
+    } else if (term.gain == 1.0f) {
+      juce::FloatVectorOperations::add(dest, source, blockSize);
+    } else {
+      juce::FloatVectorOperations::addWithMultiply(dest, source, term.gain,
+                                                   blockSize);
+    }
+  }
+
+  if (first)
+    juce::FloatVectorOperations::clear(dest, blockSize);
+
+  return dest;
+}
+
+} // namespace mcam
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * ChannelMatrixMixer computes derived channels (mono sums, M/S, downmixes,
+ * arbitrary weighted mixes) from a block of input channels.
+ *
+ * Each output is a sparse row of the mix matrix: only the inputs with a
+ * non-zero gain are stored, so an output costs one vectorised pass per
+ * contributing input whatever the input count. Outputs are mixed lazily,
+ * at most once per block, the first time they are asked for; outputs that
+ * nobody reads in a block cost nothing, and an output read by several
+ * consumers is shared.
+ *
+ * The mixer does no locking. Definitions must not change while a block is
+ * being mixed; the owner serialises setOutput() against the audio thread.
+ * Mixing never allocates once prepare() has been called.
+ */
+class ChannelMatrixMixer {
+public:
+  /** Number of derived channels that can be defined */
+  static constexpr int MAX_OUTPUTS = 32;
+
+  /** One non-zero matrix coefficient */
+  struct Term {
+    int input;
+    float gain;
+  };
+
+  /** Surround bed layouts, in SMPTE channel order */
+  enum class BedLayout {
+    surround51, // L R C LFE Ls Rs
+    surround71  // L R C LFE Lss Rss Lrs Rrs
+  };
+
+  /** Which fold-down of a bed to produce */
+  enum class DownmixOutput { left, right, mono };
+
+  /** @return Sum of a pair, L + R */
+  static std::vector<Term> sum(int left, int right);
+
+  /** @return Mid signal of a pair, (L + R) / 2 */
+  static std::vector<Term> mid(int left, int right);
+
+  /** @return Side signal of a pair, (L - R) / 2 */
+  static std::vector<Term> side(int left, int right);
+
+  /**
+   * ITU-R BS.775 fold-down of a surround bed. Centre and surrounds are mixed
+   * in at -3 dB and the LFE is dropped; the result is not normalised.
+   * @param layout Layout of the bed
+   * @param firstInput Input channel carrying the bed's left channel
+   * @param output Stereo left, stereo right, or their average
+   */
+  static std::vector<Term> downmix(BedLayout layout, int firstInput,
+                                   DownmixOutput output);
+
+  /**
+   * Converts a dense matrix row to terms
+   * @param gains Gain per input, starting at firstInput
+   * @param firstInput Input channel the first gain applies to
+   */
+  static std::vector<Term> fromGains(const std::vector<float> &gains,
+                                     int firstInput = 0);
+
+  /**
+   * Formats terms as text, e.g. "1:0.5,2:-0.5", for settings files and OSC.
+   * Inputs are 1-based, as in the UI.
+   */
+  static juce::String termsToString(const std::vector<Term> &terms);
+
+  /**
+   * Parses the text written by termsToString(). A term's gain may be left
+   * out for unity, so "1,2" is the sum of inputs 1 and 2.
+   * @param text Comma-separated terms; empty for none
+   * @param terms Receives the terms (0-based inputs)
+   * @return false if the text is malformed; terms is unchanged then
+   */
+  static bool termsFromString(const juce::String &text,
+                              std::vector<Term> &terms);
+
+  /** Constructor */
+  ChannelMatrixMixer();
+
+  /**
+   * Allocates the output buffers
+   * @param maxBlockSize Largest block that will be mixed
+   */
+  void prepare(int maxBlockSize);
+
+  /**
+   * Defines an output. Zero and non-finite gains are dropped and repeated
+   * inputs are merged, so the stored row may be shorter than terms.
+   * @param output Output index (0 to MAX_OUTPUTS - 1)
+   * @param terms Coefficients; none (or all zero) clears the output
+   * @return false if the output index or an input index is invalid
+   */
+  bool setOutput(int output, std::vector<Term> terms);
+
+  /** @return true if the output has at least one non-zero coefficient */
+  bool isOutputDefined(int output) const;
+
+  /** @return Number of stored (non-zero) coefficients of an output */
+  int getNumTerms(int output) const;
+
+  /** @return The stored coefficients of an output, sorted by input */
+  std::vector<Term> getTerms(int output) const;
+
+  /**
+   * Starts a new block. The pointers must stay valid until the last
+   * getOutput() call for the block.
+   * @param inputChannelData Input channel data
+   * @param numInputChannels Number of input channels
+   * @param numSamples Number of samples in the block
+   */
+  void beginBlock(const float *const *inputChannelData, int numInputChannels,
+                  int numSamples);
+
+  /**
+   * Gets an output for the current block, mixing it if this is the first
+   * request since beginBlock(). Inputs the device does not provide count as
+   * silence.
+   * @param output Output index (0 to MAX_OUTPUTS - 1)
+   * @return The mixed samples, or nullptr if the output is not defined
+   */
+  const float *getOutput(int output);
+
+  /** @return Outputs mixed since the last beginBlock() */
+  int getNumOutputsMixed() const;
+
+private:
+  struct Output {
+    std::vector<Term> terms;
+
+    // Block the result belongs to, and where it is
+    juce::uint64 mixedBlock = 0;
+    const float *result = nullptr;
+  };
+
+  /** Mixes an output's terms into dest; returns where the result is */
+  const float *mix(const std::vector<Term> &terms, float *dest);
+
+  std::array<Output, MAX_OUTPUTS> outputs;
+  juce::AudioBuffer<float> mixBuffer;
+
+  // Current block
+  const float *const *inputs = nullptr;
+  int numInputs = 0;
+  int blockSize = 0;
+  juce::uint64 blockCount = 0;
+  int numMixed = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelMatrixMixer)
+};
+
+} // namespace mcam
@@ -0,0 +1,407 @@
+#include "DiskRecorder.h"
+
+namespace mcam {
+
+namespace {
+// Buffered stream size; the writer hands the OS large sequential writes
+constexpr size_t WRITE_BUFFER_BYTES = 1 << 20;
+
+// How long the writer sleeps when the FIFO is empty
+constexpr int WRITER_POLL_MS = 5;
+
+// FLAC streams are limited to 8 channels
+constexpr int MAX_FLAC_CHANNELS = 8;
+} // namespace
+
+DiskRecorder::DiskRecorder()
+    : juce::Thread("MCAM Disk Recorder"),
+      fifoDepth(MetricsRegistry::getInstance().gauge(
+          "mcam_recorder_fifo_depth_samples",
+          "Samples queued between the audio thread and the disk writer")),
+      droppedSamplesTotal(MetricsRegistry::getInstance().counter(
+          "mcam_recorder_dropped_samples_total",
+          "Samples dropped because the recorder FIFO was full")),
+      bytesWrittenTotal(MetricsRegistry::getInstance().counter(
+          "mcam_recorder_bytes_written_total",
+          "Bytes written to recording files")),
+      filesTotal(MetricsRegistry::getInstance().counter(
+          "mcam_recorder_files_total", "Recording files opened")) {
+  LOG_INFO("Initializing DiskRecorder");
+}
+
+DiskRecorder::~DiskRecorder() {
+  LOG_INFO("Shutting down DiskRecorder");
+  stopRecording();
+}
+
+bool DiskRecorder::startRecording(const Settings &newSettings) {
+  stopRecording();
+
+  if (currentSampleRate <= 0.0) {
+    setError("Cannot start recording: audio device is not running");
+    return false;
+  }
+
+  if (newSettings.channels.isEmpty()) {
+    setError("Cannot start recording: no channels selected");
+    return false;
+  }
+
+  if (newSettings.format == Format::Flac &&
+      newSettings.channels.size() > MAX_FLAC_CHANNELS) {
+    setError("FLAC supports at most " + juce::String(MAX_FLAC_CHANNELS) +
+             " channels; use WAV for " +
+             juce::String(newSettings.channels.size()) + " channels");
+    return false;
+  }
+
+  if (!newSettings.directory.createDirectory()) {
+    setError("Cannot create recording directory " +
+             newSettings.directory.getFullPathName());
+    return false;
+  }
+
+  settings = newSettings;
+  recordingSampleRate = currentSampleRate;
+
+  if (settings.format == Format::Flac) {
+    audioFormat = std::make_unique<juce::FlacAudioFormat>();
+  } else {
+    audioFormat = std::make_unique<juce::WavAudioFormat>();
+  }
+
+  // Everything the audio thread touches is allocated before capture starts
+  const int numChannels = settings.channels.size();
+  const int capacity = juce::jmax(
+      juce::roundToInt(settings.fifoSeconds * recordingSampleRate),
+      maxBlockSize * 4, 1024);
+
+  captureChannels.assign(settings.channels.begin(), settings.channels.end());
+  fifoBuffer.setSize(numChannels, capacity, false, true);
+  fifo.setTotalSize(capacity);
+  fifo.reset();
+  writePointers.assign((size_t)numChannels, nullptr);
+
+  samplesWritten = 0;
+  droppedSamples = 0;
+  filesWritten = 0;
+  fileSequence = 0;
+
+  if (!openNextFile())
+    return false;
+
+  LOG_INFO("Recording " + juce::String(numChannels) + " channels at " +
+           juce::String(recordingSampleRate) + " Hz to " +
+           settings.directory.getFullPathName());
+
+  capturing.store(true, std::memory_order_release);
+  startThread(juce::Thread::Priority::high);
+
+  return true;
+}
+
+void DiskRecorder::stopRecording() {
+  if (!capturing.exchange(false) && !isThreadRunning())
+    return;
+
+  LOG_INFO("Stopping recording");
+
+  // The producer may still be inside processAudio for one block
+  waitForAudioThread();
+
+  // Writer drains the FIFO and closes the file on exit
+  stopThread(10000);
+
+  const auto stats = getStats();
+  LOG_INFO("Recording stopped - " + juce::String(stats.filesWritten) +
+           " file(s), " + juce::String(stats.samplesWritten) +
+           " samples, " + juce::String(stats.droppedSamples) + " dropped");
+}
+
+bool DiskRecorder::isRecording() const {
+  return capturing.load(std::memory_order_acquire);
+}
+
+DiskRecorder::Stats DiskRecorder::getStats() const {
+  Stats stats;
+  stats.samplesWritten = samplesWritten.load();
+  stats.droppedSamples = droppedSamples.load();
+  stats.filesWritten = filesWritten.load();
+  stats.fifoFillSamples = fifo.getNumReady();
+  stats.fifoCapacitySamples = fifo.getTotalSize();
+
+  const juce::ScopedLock sl(statusLock);
+  stats.currentFile = currentFile;
+  return stats;
+}
+
+juce::String DiskRecorder::getLastError() const {
+  const juce::ScopedLock sl(statusLock);
+  return lastError;
+}
+
+void DiskRecorder::prepareToPlay(double sampleRate, int bufferSize) {
+  AudioCallback::prepareToPlay(sampleRate, bufferSize);
+  maxBlockSize = bufferSize;
+}
+
+void DiskRecorder::releaseResources() {
+  // The writer cannot follow a sample rate change, so finish the recording
+  if (capturing.exchange(false)) {
+    LOG_WARNING("Audio device stopped while recording - recording finished");
+    signalThreadShouldExit();
+    notify();
+  }
+
+  AudioCallback::releaseResources();
+}
+
+void DiskRecorder::processAudio(const float *const *inputChannelData,
+                                int numInputChannels, int numSamples) {
+  audioThreadPushing.store(true);
+
+  if (capturing.load(std::memory_order_acquire)) {
+    // Free space only grows between this check and the write (single
+    // producer), so a block either fits completely or is dropped as a whole
+    if (fifo.getFreeSpace() < numSamples) {
+      droppedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+      droppedSamplesTotal.add((juce::uint64)numSamples);
+    } else {
+      const auto scope = fifo.write(numSamples);
+
+      for (size_t i = 0; i < captureChannels.size(); ++i) {
+        const int channel = captureChannels[i];
+        const int destChannel = (int)i;
+
+        if (channel >= 0 && channel < numInputChannels &&
+            inputChannelData[channel] != nullptr) {
+          const float *source = inputChannelData[channel];
+
+          if (scope.blockSize1 > 0)
+            fifoBuffer.copyFrom(destChannel, scope.startIndex1, source,
+                                scope.blockSize1);
+          if (scope.blockSize2 > 0)
+            fifoBuffer.copyFrom(destChannel, scope.startIndex2,
+                                source + scope.blockSize1, scope.blockSize2);
+        } else {
+          // Missing channels are recorded as silence to keep files aligned
+          if (scope.blockSize1 > 0)
+            fifoBuffer.clear(destChannel, scope.startIndex1, scope.blockSize1);
+          if (scope.blockSize2 > 0)
+            fifoBuffer.clear(destChannel, scope.startIndex2, scope.blockSize2);
+        }
+      }
+    }
+  }
+
+  audioThreadPushing.store(false);
+}
+
+void DiskRecorder::waitForAudioThread() const {
+  while (audioThreadPushing.load())
+    juce::Thread::yield();
+}
+
+void DiskRecorder::run() {
+  auto &threadTuning = ThreadTuning::getInstance();
+
+  while (!threadShouldExit()) {
+    threadTuning.applyToCurrentThread(ThreadTuning::ThreadClass::disk);
+
+    const int numWritten = writeAvailableSamples();
+
+    // A failed write or rotation leaves no file to write to
+    if (writer == nullptr) {
+      finishAfterWriteError();
+      return;
+    }
+
+    if (numWritten == 0)
+      wait(WRITER_POLL_MS);
+  }
+
+  // Final drain after stop
+  writeAvailableSamples();
+  closeCurrentFile();
+}
+
+void DiskRecorder::finishAfterWriteError() {
+  if (capturing.exchange(false))
+    LOG_WARNING("Recording stopped after a write error: " + getLastError());
+
+  // Nothing is pushed once the audio thread has left, so the queued
+  // samples can be counted as dropped and released
+  waitForAudioThread();
+
+  const int numReady = fifo.getNumReady();
+  fifo.finishedRead(numReady);
+  droppedSamples.fetch_add(numReady, std::memory_order_relaxed);
+  droppedSamplesTotal.add((juce::uint64)numReady);
+  fifoDepth.set(0.0);
+}
+
+int DiskRecorder::writeAvailableSamples() {
+  const int numReady = fifo.getNumReady();
+  fifoDepth.set((double)numReady);
+
+  if (numReady == 0 || writer == nullptr)
+    return 0;
+
+  const auto scope = fifo.read(numReady);
+
+  if (scope.blockSize1 > 0)
+    writeRegion(scope.startIndex1, scope.blockSize1);
+  if (scope.blockSize2 > 0)
+    writeRegion(scope.startIndex2, scope.blockSize2);
+
+  return numReady;
+}
+
+bool DiskRecorder::writeRegion(int startIndex, int numSamples) {
+  const int numChannels = fifoBuffer.getNumChannels();
+
+  while (numSamples > 0 && writer != nullptr) {
+    // Split the region at the rotation point so files have exact lengths
+    int chunk = numSamples;
+
+    if (settings.rotateAfterSeconds > 0.0) {
+      const auto limit = (juce::int64)(settings.rotateAfterSeconds *
+                                       recordingSampleRate);
+      chunk = (int)juce::jmin((juce::int64)chunk,
+                              juce::jmax((juce::int64)1,
+                                         limit - samplesInCurrentFile));
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+      writePointers[(size_t)ch] = fifoBuffer.getReadPointer(ch, startIndex);
+
+    if (!writer->writeFromFloatArrays(writePointers.data(), numChannels,
+                                      chunk)) {
+      setError("Write failed on " + currentFile.getFullPathName());
+      closeCurrentFile();
+      return false;
+    }
+
+    samplesInCurrentFile += chunk;
+    samplesWritten.fetch_add(chunk, std::memory_order_relaxed);
+    countBytesWritten();
+
+    startIndex += chunk;
+    numSamples -= chunk;
+
+    if (shouldRotate()) {
+      closeCurrentFile();
+      openNextFile();
+    }
+  }
+
+  return true;
+}
+
+bool DiskRecorder::shouldRotate() const {
+  if (settings.rotateAfterSeconds > 0.0 &&
+      samplesInCurrentFile >=
+          (juce::int64)(settings.rotateAfterSeconds * recordingSampleRate))
+    return true;
+
+  if (settings.rotateAfterBytes > 0 && currentStream != nullptr &&
+      currentStream->getPosition() >= settings.rotateAfterBytes)
+    return true;
+
+  return false;
+}
+
+bool DiskRecorder::openNextFile() {
+  const auto timestamp =
+      juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S");
+  const auto extension = settings.format == Format::Flac ? ".flac" : ".wav";
+
+  auto file = settings.directory.getChildFile(
+      settings.filePrefix + "_" + timestamp + "_" +
+      juce::String(++fileSequence).paddedLeft('0', 3) + extension);
+
+  auto stream =
+      std::make_unique<juce::FileOutputStream>(file, WRITE_BUFFER_BYTES);
+
+  if (!stream->openedOk()) {
+    setError("Cannot open " + file.getFullPathName() + ": " +
+             stream->getStatus().getErrorMessage());
+    return false;
+  }
+
+  // Recordings always start from an empty file
+  stream->setPosition(0);
+  stream->truncate();
+
+  juce::StringPairArray metadata;
+  auto *streamPtr = stream.get();
+
+  writer.reset(audioFormat->createWriterFor(
+      streamPtr, recordingSampleRate,
+      (unsigned int)fifoBuffer.getNumChannels(), settings.bitsPerSample,
+      metadata, 0));
+
+  if (writer == nullptr) {
+    setError("Cannot create " + audioFormat->getFormatName() + " writer for " +
+             file.getFullPathName());
+    return false;
+  }
+
+  // The writer owns the stream now
+  stream.release();
+  currentStream = streamPtr;
+  samplesInCurrentFile = 0;
+  bytesInCurrentFile = 0;
+  filesWritten.fetch_add(1);
+  filesTotal.add();
+
+  {
+    const juce::ScopedLock sl(statusLock);
+    currentFile = file;
+  }
+
+  LOG_INFO("Recording to " + file.getFullPathName());
+  return true;
+}
+
+void DiskRecorder::closeCurrentFile() {
+  if (writer == nullptr)
+    return;
+
+  // Deleting the writer rewrites the header and flushes the stream; the
+  // final size includes whatever it appended
+  countBytesWritten();
+  writer.reset();
+  currentStream = nullptr;
+
+  const auto fileSize = currentFile.getSize();
+  if (fileSize > bytesInCurrentFile)
+    bytesWrittenTotal.add((juce::uint64)(fileSize - bytesInCurrentFile));
+  bytesInCurrentFile = 0;
+
+  const juce::ScopedLock sl(statusLock);
+  LOG_INFO("Closed recording " + currentFile.getFullPathName());
+  currentFile = juce::File();
+}
+
+void DiskRecorder::countBytesWritten() {
+  if (currentStream == nullptr)
+    return;
+
+  // The encoder's output, which for FLAC is far from the PCM size
+  const auto position = currentStream->getPosition();
+
+  if (position > bytesInCurrentFile) {
+    bytesWrittenTotal.add((juce::uint64)(position - bytesInCurrentFile));
+    bytesInCurrentFile = position;
+  }
+}
+
+void DiskRecorder::setError(const juce::String &message) {
+  LOG_ERROR(message);
+
+  const juce::ScopedLock sl(statusLock);
+  lastError = message;
+}
+
+} // namespace mcam
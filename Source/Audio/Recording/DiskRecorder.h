@@ -0,0 +1,175 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../Core/Metrics.h"
+#include "../../Core/ThreadTuning.h"
+#include "../../JuceHeader.h"
+#include "../AudioCallback.h"
+
+namespace mcam {
+/**
+ * DiskRecorder captures a selectable set of input channels to disk.
+ *
+ * The audio thread only copies the selected channels into a preallocated
+ * lock-free FIFO. A background writer thread drains the FIFO in large
+ * chunks, encodes through a juce::AudioFormatWriter into a 1 MB buffered
+ * file stream, and rotates to a new file by duration and/or size.
+ *
+ * Supported formats are WAV (switches to RF64 beyond 4 GB) and FLAC
+ * (limited by the format to 8 channels).
+ */
+class DiskRecorder : public AudioCallback, private juce::Thread {
+public:
+  /** Output file formats */
+  enum class Format { Wav, Flac };
+
+  /** Recording configuration */
+  struct Settings {
+    /** Directory the files are written to (created if missing) */
+    juce::File directory;
+
+    /** File name prefix; a timestamp and sequence number are appended */
+    juce::String filePrefix = "mcam";
+
+    Format format = Format::Wav;
+
+    /** Bit depth of the encoded files (16 or 24) */
+    int bitsPerSample = 24;
+
+    /** Input channel indices to capture, in file channel order */
+    juce::Array<int> channels;
+
+    /** Start a new file after this many seconds (0 = never) */
+    double rotateAfterSeconds = 3600.0;
+
+    /** Start a new file after this many bytes (0 = never) */
+    juce::int64 rotateAfterBytes = 0;
+
+    /** FIFO capacity between the audio thread and the writer */
+    double fifoSeconds = 2.0;
+  };
+
+  /** Recorder counters */
+  struct Stats {
+    juce::int64 samplesWritten = 0;
+    juce::int64 droppedSamples = 0;
+    int filesWritten = 0;
+    int fifoFillSamples = 0;
+    int fifoCapacitySamples = 0;
+    juce::File currentFile;
+  };
+
+  /** Constructor */
+  DiskRecorder();
+
+  /** Destructor */
+  ~DiskRecorder() override;
+
+  /**
+   * Starts recording. The audio device must be running, since the sample
+   * rate is taken from it.
+   * @param settings Recording configuration
+   * @return true if the first file was opened
+   */
+  bool startRecording(const Settings &settings);
+
+  /**
+   * Stops recording, writes out everything still queued and closes the
+   * current file
+   */
+  void stopRecording();
+
+  /**
+   * @return true while recording; false once a write or rotation has
+   * failed (see getLastError())
+   */
+  bool isRecording() const;
+
+  /** @return Current counters (safe from any thread) */
+  Stats getStats() const;
+
+  /** @return The last error reported by startRecording() or the writer */
+  juce::String getLastError() const;
+
+protected:
+  /** Overridden from AudioCallback */
+  void prepareToPlay(double sampleRate, int bufferSize) override;
+  void releaseResources() override;
+  void processAudio(const float *const *inputChannelData, int numInputChannels,
+                    int numSamples) override;
+
+private:
+  /** Writer thread */
+  void run() override;
+
+  /**
+   * Ends the recording when the writer has failed: capture stops, and what
+   * is still queued is counted as dropped
+   */
+  void finishAfterWriteError();
+
+  /** Writes everything in the FIFO, rotating files as needed */
+  int writeAvailableSamples();
+
+  /** Writes a contiguous FIFO region to the current file(s) */
+  bool writeRegion(int startIndex, int numSamples);
+
+  /** Opens the next file in the sequence */
+  bool openNextFile();
+
+  /** Flushes and closes the current file */
+  void closeCurrentFile();
+
+  /** Adds the bytes the current file has grown by to bytesWrittenTotal */
+  void countBytesWritten();
+
+  /** @return true if the current file has reached a rotation limit */
+  bool shouldRotate() const;
+
+  /** Waits until the audio thread is no longer pushing into the FIFO */
+  void waitForAudioThread() const;
+
+  /** Records an error for getLastError() */
+  void setError(const juce::String &message);
+
+  // Configuration of the active recording (stable while capturing)
+  Settings settings;
+  double recordingSampleRate = 0.0;
+  int maxBlockSize = 0;
+
+  // FIFO shared by the audio thread (producer) and writer (consumer)
+  juce::AbstractFifo fifo{1};
+  juce::AudioBuffer<float> fifoBuffer;
+  std::vector<int> captureChannels;
+
+  // Producer state
+  std::atomic<bool> capturing{false};
+  mutable std::atomic<bool> audioThreadPushing{false};
+
+  // Writer state (writer thread only while recording)
+  std::unique_ptr<juce::AudioFormat> audioFormat;
+  std::unique_ptr<juce::AudioFormatWriter> writer;
+  juce::FileOutputStream *currentStream = nullptr; // owned by writer
+  juce::int64 samplesInCurrentFile = 0;
+  juce::int64 bytesInCurrentFile = 0; // already added to bytesWrittenTotal
+  int fileSequence = 0;
+  std::vector<const float *> writePointers;
+
+  // Counters
+  std::atomic<juce::int64> samplesWritten{0};
+  std::atomic<juce::int64> droppedSamples{0};
+  std::atomic<int> filesWritten{0};
+  juce::File currentFile;
+  juce::String lastError;
+  mutable juce::CriticalSection statusLock;
+
+  // Instrumentation
+  metrics::Gauge &fifoDepth;
+  metrics::Counter &droppedSamplesTotal;
+  metrics::Counter &bytesWrittenTotal;
+  metrics::Counter &filesTotal;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DiskRecorder)
+};
+
+} // namespace mcam
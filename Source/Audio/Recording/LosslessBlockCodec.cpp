@@ -0,0 +1,253 @@
+#include "LosslessBlockCodec.h"
+
+namespace mcam {
+
+namespace {
+// Header bytes marking a block of digital silence and a block of raw
+// floats; integer blocks start with their Rice parameter (0-30)
+constexpr juce::uint8 SILENT_BLOCK = 0xff;
+constexpr juce::uint8 FLOAT_BLOCK = 0xfe;
+
+// Quotients at or above this are written as an escape plus a raw value
+constexpr juce::uint32 ESCAPE_QUOTIENT = 32;
+
+inline juce::uint32 zigzag(juce::int32 value) {
+  return ((juce::uint32)value << 1) ^ (juce::uint32)(value >> 31);
+}
+
+inline juce::int32 unzigzag(juce::uint32 value) {
+  return (juce::int32)(value >> 1) ^ -(juce::int32)(value & 1);
+}
+
+/**
+ * Converts a sample to a 24-bit integer if that is exact
+ * @return false for samples between steps, beyond full scale, -0 or not
+ * finite
+ */
+inline bool toInteger(float sample, juce::int32 &value) {
+  // Scaling by a power of two is exact
+  const float scaled = sample * (float)LosslessBlockCodec::FULL_SCALE;
+
+  if (!(std::abs(scaled) <= (float)LosslessBlockCodec::FULL_SCALE))
+    return false;
+
+  value = (juce::int32)scaled;
+  return (float)value == scaled && !(value == 0 && std::signbit(sample));
+}
+
+/** Second-order fixed prediction residual for sample i */
+inline juce::int32 residual(const juce::int32 *x, int i) {
+  if (i == 0)
+    return x[0];
+  if (i == 1)
+    return x[1] - x[0];
+  return x[i] - 2 * x[i - 1] + x[i - 2];
+}
+
+class BitWriter {
+public:
+  explicit BitWriter(juce::uint8 *destination) : dest(destination) {}
+
+  void write(juce::uint32 value, int numBits) {
+    accumulator = (accumulator << numBits) | (value & mask(numBits));
+    bitCount += numBits;
+
+    while (bitCount >= 8) {
+      bitCount -= 8;
+      dest[bytesWritten++] = (juce::uint8)(accumulator >> bitCount);
+    }
+  }
+
+  size_t flush() {
+    if (bitCount > 0)
+      dest[bytesWritten++] = (juce::uint8)(accumulator << (8 - bitCount));
+    bitCount = 0;
+    return bytesWritten;
+  }
+
+private:
+  static juce::uint64 mask(int numBits) {
+    return numBits >= 32 ? 0xffffffffull : ((1ull << numBits) - 1);
+  }
+
+  juce::uint8 *dest;
+  juce::uint64 accumulator = 0;
+  int bitCount = 0;
+  size_t bytesWritten = 0;
+};
+
+class BitReader {
+public:
+  BitReader(const juce::uint8 *source, size_t size) : src(source), end(size) {}
+
+  bool read(int numBits, juce::uint32 &value) {
+    while (bitCount < numBits) {
+      if (position >= end)
+        return false;
+      accumulator = (accumulator << 8) | src[position++];
+      bitCount += 8;
+    }
+
+    bitCount -= numBits;
+    value = (juce::uint32)((accumulator >> bitCount) &
+                           (numBits >= 32 ? 0xffffffffull
+                                          : ((1ull << numBits) - 1)));
+    return true;
+  }
+
+private:
+  const juce::uint8 *src;
+  size_t end;
+  size_t position = 0;
+  juce::uint64 accumulator = 0;
+  int bitCount = 0;
+};
+
+/** Stores a block as raw little-endian floats */
+void encodeFloats(const float *samples, int numSamples,
+                  juce::MemoryBlock &output) {
+  output.setSize(1 + (size_t)numSamples * sizeof(float), false);
+  auto *dest = static_cast<juce::uint8 *>(output.getData());
+  dest[0] = FLOAT_BLOCK;
+
+  for (int i = 0; i < numSamples; ++i) {
+    juce::uint32 bits;
+    std::memcpy(&bits, samples + i, sizeof(bits));
+    bits = juce::ByteOrder::swapIfBigEndian(bits);
+    std::memcpy(dest + 1 + i * sizeof(bits), &bits, sizeof(bits));
+  }
+}
+} // namespace
+
+void LosslessBlockCodec::encode(const float *samples, int numSamples,
+                                juce::MemoryBlock &output) {
+  juce::HeapBlock<juce::int32> quantised((size_t)numSamples);
+  bool silent = true;
+
+  for (int i = 0; i < numSamples; ++i) {
+    if (!toInteger(samples[i], quantised[i])) {
+      encodeFloats(samples, numSamples, output);
+      return;
+    }
+
+    silent = silent && quantised[i] == 0;
+  }
+
+  if (silent) {
+    output.replaceAll(&SILENT_BLOCK, 1);
+    return;
+  }
+
+  // Pick the Rice parameter from the mean residual magnitude
+  juce::uint64 sum = 0;
+  for (int i = 0; i < numSamples; ++i)
+    sum += zigzag(residual(quantised, i));
+
+  int k = 0;
+  while (k < 30 && ((juce::uint64)numSamples << (k + 1)) < sum)
+    ++k;
+
+  // Worst case: every sample escaped (32 + 32 bits)
+  output.setSize(1 + (size_t)numSamples * 8 + 8, false);
+  auto *dest = static_cast<juce::uint8 *>(output.getData());
+  dest[0] = (juce::uint8)k;
+
+  BitWriter writer(dest + 1);
+
+  for (int i = 0; i < numSamples; ++i) {
+    const auto value = zigzag(residual(quantised, i));
+    const auto quotient = value >> k;
+
+    if (quotient < ESCAPE_QUOTIENT) {
+      // Unary quotient (ones terminated by a zero) then k remainder bits
+      writer.write(((1u << quotient) - 1) << 1, (int)quotient + 1);
+      if (k > 0)
+        writer.write(value, k);
+    } else {
+      writer.write(0xffffffffu, 32);
+      writer.write(value, 32);
+    }
+  }
+
+  const size_t size = 1 + writer.flush();
+
+  // Residuals too large to code (e.g. full-scale square waves at Nyquist)
+  // are stored raw instead
+  if (size > 1 + (size_t)numSamples * sizeof(float))
+    encodeFloats(samples, numSamples, output);
+  else
+    output.setSize(size, false);
+}
+
+bool LosslessBlockCodec::decode(const void *data, size_t numBytes,
+                                float *samples, int numSamples) {
+  if (numBytes == 0)
+    return false;
+
+  const auto *src = static_cast<const juce::uint8 *>(data);
+
+  if (src[0] == SILENT_BLOCK) {
+    juce::FloatVectorOperations::clear(samples, numSamples);
+    return true;
+  }
+
+  if (src[0] == FLOAT_BLOCK) {
+    if (numBytes < 1 + (size_t)numSamples * sizeof(float))
+      return false;
+
+    for (int i = 0; i < numSamples; ++i) {
+      const juce::uint32 bits =
+          juce::ByteOrder::littleEndianInt(src + 1 + i * sizeof(float));
+      std::memcpy(samples + i, &bits, sizeof(bits));
+    }
+
+    return true;
+  }
+
+  const int k = src[0];
+  if (k > 30)
+    return false;
+
+  BitReader reader(src + 1, numBytes - 1);
+  // Exact, as FULL_SCALE is a power of two
+  const float scale = 1.0f / (float)FULL_SCALE;
+  juce::int32 previous1 = 0, previous2 = 0;
+
+  for (int i = 0; i < numSamples; ++i) {
+    juce::uint32 quotient = 0, bit = 0, value = 0;
+
+    do {
+      if (!reader.read(1, bit))
+        return false;
+      quotient += bit;
+    } while (bit == 1 && quotient < ESCAPE_QUOTIENT);
+
+    if (quotient >= ESCAPE_QUOTIENT) {
+      if (!reader.read(32, value))
+        return false;
+    } else {
+      juce::uint32 remainder = 0;
+      if (k > 0 && !reader.read(k, remainder))
+        return false;
+      value = (quotient << k) | remainder;
+    }
+
+    const auto r = unzigzag(value);
+    juce::int32 x;
+
+    if (i == 0)
+      x = r;
+    else if (i == 1)
+      x = r + previous1;
+    else
+      x = r + 2 * previous1 - previous2;
+
+    previous2 = previous1;
+    previous1 = x;
+    samples[i] = (float)x * scale;
+  }
+
+  return true;
+}
+
+} // namespace mcam
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * LosslessBlockCodec compresses one channel of one block of audio.
+ *
+ * Blocks of converter data, whose samples are all multiples of 2^-23 in
+ * [-1, 1] as JUCE's 24-bit converters produce, are coded as 24-bit
+ * integers: predicted with a second-order fixed predictor and the residuals
+ * Rice-coded with a per-block parameter - the same approach FLAC uses for
+ * its fixed subframes. Any other block (float-native sources such as JACK,
+ * or samples beyond full scale) is stored as raw 32-bit floats. Either way
+ * decoding returns the input bit for bit. Blocks are self-contained so any
+ * block can be decoded without its neighbours. Digital silence is stored as
+ * a single byte.
+ */
+class LosslessBlockCodec {
+public:
+  /**
+   * Encodes a block
+   * @param samples Input samples, any values
+   * @param numSamples Number of samples
+   * @param output Receives the encoded block (replaced, not appended)
+   */
+  static void encode(const float *samples, int numSamples,
+                     juce::MemoryBlock &output);
+
+  /**
+   * Decodes a block produced by encode()
+   * @param data Encoded block
+   * @param numBytes Size of the encoded block
+   * @param samples Receives numSamples decoded samples
+   * @param numSamples Number of samples the block was encoded with
+   * @return false if the block is malformed
+   */
+  static bool decode(const void *data, size_t numBytes, float *samples,
+                     int numSamples);
+
+  /**
+   * Full scale of the integer representation, the scale of
+   * juce::AudioData::Int24
+   */
+  static constexpr int FULL_SCALE = 1 << 23;
+};
+
+} // namespace mcam
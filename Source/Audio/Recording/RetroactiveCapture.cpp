@@ -0,0 +1,416 @@
+#include "RetroactiveCapture.h"
+
+namespace mcam {
+
+namespace {
+// How long the collector sleeps while waiting for a full frame
+constexpr int COLLECTOR_POLL_MS = 10;
+
+// Staging FIFO length; covers collector stalls during heavy compression
+constexpr double STAGING_SECONDS = 2.0;
+
+// Dumps are float WAV files, matching the samples the codec restores
+constexpr int DUMP_BITS_PER_SAMPLE = 32;
+
+int chooseNumWorkers() {
+  return juce::jlimit(1, 4, juce::SystemStats::getNumCpus() / 2);
+}
+} // namespace
+
+RetroactiveCapture::RetroactiveCapture()
+    : juce::Thread("MCAM Retroactive Capture"),
+      compressionPool(chooseNumWorkers()),
+      historySecondsGauge(MetricsRegistry::getInstance().gauge(
+          "mcam_retro_history_seconds",
+          "Seconds of audio held in the retroactive capture history")),
+      memoryBytesGauge(MetricsRegistry::getInstance().gauge(
+          "mcam_retro_memory_bytes",
+          "Memory used by the retroactive capture history")),
+      compressionRatioGauge(MetricsRegistry::getInstance().gauge(
+          "mcam_retro_compression_ratio",
+          "Float32 size divided by compressed size of the history")),
+      compressCpuTotal(MetricsRegistry::getInstance().counter(
+          "mcam_retro_compress_cpu_seconds_total",
+          "CPU time spent compressing the retroactive capture history", {},
+          MetricsRegistry::ticksToSeconds(1))),
+      droppedSamplesTotal(MetricsRegistry::getInstance().counter(
+          "mcam_retro_dropped_samples_total",
+          "Samples dropped because the staging FIFO was full")) {
+  LOG_INFO("Initializing RetroactiveCapture with " +
+           juce::String(compressionPool.getNumThreads()) +
+           " compression worker(s)");
+}
+
+RetroactiveCapture::~RetroactiveCapture() {
+  LOG_INFO("Shutting down RetroactiveCapture");
+
+  // Let a running dump finish; it holds its own references to the frames
+  dumpPool.removeAllJobs(false, 30000);
+
+  capturing = false;
+  stopThread(5000);
+}
+
+void RetroactiveCapture::setHistoryLength(double seconds) {
+  historySeconds = juce::jmax(0.0, seconds);
+}
+
+double RetroactiveCapture::getHistoryLength() const { return historySeconds; }
+
+void RetroactiveCapture::audioDeviceAboutToStart(juce::AudioIODevice *device) {
+  if (device != nullptr) {
+    numCaptureChannels =
+        device->getActiveInputChannels().countNumberOfSetBits();
+  }
+
+  AudioCallback::audioDeviceAboutToStart(device);
+}
+
+void RetroactiveCapture::prepareToPlay(double sampleRate, int bufferSize) {
+  AudioCallback::prepareToPlay(sampleRate, bufferSize);
+
+  capturing = false;
+  stopThread(5000);
+
+  if (historySeconds <= 0.0 || numCaptureChannels == 0) {
+    LOG_INFO("Retroactive capture disabled");
+    return;
+  }
+
+  // The history cannot mix formats, so start over if the format changed
+  if (sampleRate != captureSampleRate ||
+      numCaptureChannels != frameBuffer.getNumChannels()) {
+    const juce::ScopedLock sl(historyLock);
+    history.clear();
+    historyCompressedBytes = 0;
+    historySamples = 0;
+    nextFrameStart = 0;
+  }
+
+  captureSampleRate = sampleRate;
+
+  const int capacity =
+      juce::jmax(juce::roundToInt(STAGING_SECONDS * sampleRate),
+                 bufferSize * 4, FRAME_SIZE * 4);
+
+  stagingBuffer.setSize(numCaptureChannels, capacity, false, true);
+  stagingFifo.setTotalSize(capacity);
+  stagingFifo.reset();
+  frameBuffer.setSize(numCaptureChannels, FRAME_SIZE, false, true);
+
+  LOG_INFO("Retroactive capture of " + juce::String(numCaptureChannels) +
+           " channels, " + juce::String(historySeconds.load()) +
+           " s history");
+
+  capturing = true;
+  startThread();
+}
+
+void RetroactiveCapture::releaseResources() {
+  // The collector compresses whatever is still staged before exiting
+  capturing = false;
+  stopThread(5000);
+
+  AudioCallback::releaseResources();
+}
+
+void RetroactiveCapture::processAudio(const float *const *inputChannelData,
+                                      int numInputChannels, int numSamples) {
+  if (!capturing.load(std::memory_order_acquire))
+    return;
+
+  if (stagingFifo.getFreeSpace() < numSamples) {
+    droppedSamples.fetch_add(numSamples, std::memory_order_relaxed);
+    droppedSamplesTotal.add((juce::uint64)numSamples);
+    return;
+  }
+
+  const auto scope = stagingFifo.write(numSamples);
+
+  for (int ch = 0; ch < numCaptureChannels; ++ch) {
+    if (ch < numInputChannels && inputChannelData[ch] != nullptr) {
+      const float *source = inputChannelData[ch];
+
+      if (scope.blockSize1 > 0)
+        stagingBuffer.copyFrom(ch, scope.startIndex1, source,
+                               scope.blockSize1);
+      if (scope.blockSize2 > 0)
+        stagingBuffer.copyFrom(ch, scope.startIndex2,
+                               source + scope.blockSize1, scope.blockSize2);
+    } else {
+      if (scope.blockSize1 > 0)
+        stagingBuffer.clear(ch, scope.startIndex1, scope.blockSize1);
+      if (scope.blockSize2 > 0)
+        stagingBuffer.clear(ch, scope.startIndex2, scope.blockSize2);
+    }
+  }
+}
+
+void RetroactiveCapture::run() {
+  auto &threadTuning = ThreadTuning::getInstance();
+
+  while (!threadShouldExit()) {
+    threadTuning.applyToCurrentThread(ThreadTuning::ThreadClass::analysis);
+
+    if (stagingFifo.getNumReady() >= FRAME_SIZE) {
+      compressNextFrame(FRAME_SIZE);
+    } else {
+      wait(COLLECTOR_POLL_MS);
+    }
+  }
+
+  // Keep the tail of the stream when the device stops
+  while (stagingFifo.getNumReady() > 0)
+    compressNextFrame(juce::jmin(FRAME_SIZE, stagingFifo.getNumReady()));
+}
+
+void RetroactiveCapture::compressNextFrame(int numSamples) {
+  {
+    const auto scope = stagingFifo.read(numSamples);
+
+    for (int ch = 0; ch < numCaptureChannels; ++ch) {
+      if (scope.blockSize1 > 0)
+        frameBuffer.copyFrom(ch, 0, stagingBuffer, ch, scope.startIndex1,
+                             scope.blockSize1);
+      if (scope.blockSize2 > 0)
+        frameBuffer.copyFrom(ch, scope.blockSize1, stagingBuffer, ch,
+                             scope.startIndex2, scope.blockSize2);
+    }
+  }
+
+  auto frame = std::make_shared<Frame>();
+  frame->startSample = nextFrameStart;
+  frame->numSamples = numSamples;
+  frame->channels.resize((size_t)numCaptureChannels);
+
+  // Channels are interleaved across jobs so each job gets a similar mix
+  const int numJobs =
+      juce::jmin(compressionPool.getNumThreads(), numCaptureChannels);
+  std::atomic<int> jobsRemaining{numJobs};
+  std::atomic<juce::int64> jobTicks{0};
+  juce::WaitableEvent allDone;
+
+  for (int job = 0; job < numJobs; ++job) {
+    compressionPool.addJob([&, job] {
+      ThreadTuning::getInstance().applyToCurrentThread(
+          ThreadTuning::ThreadClass::analysis);
+
+      const auto start = juce::Time::getHighResolutionTicks();
+
+      for (int ch = job; ch < numCaptureChannels; ch += numJobs) {
+        LosslessBlockCodec::encode(frameBuffer.getReadPointer(ch), numSamples,
+                                   frame->channels[(size_t)ch]);
+      }
+
+      jobTicks += juce::Time::getHighResolutionTicks() - start;
+
+      if (--jobsRemaining == 0)
+        allDone.signal();
+    });
+  }
+
+  allDone.wait();
+
+  for (const auto &channel : frame->channels)
+    frame->compressedBytes += channel.getSize();
+
+  nextFrameStart += numSamples;
+  capturedSamples += numSamples;
+  compressTicks += jobTicks.load();
+  compressCpuTotal.add((juce::uint64)jobTicks.load());
+
+  {
+    const juce::ScopedLock sl(historyLock);
+    historyCompressedBytes += (juce::int64)frame->compressedBytes;
+    historySamples += numSamples;
+    history.push_back(std::move(frame));
+    trimHistory();
+  }
+
+  updateMetrics();
+}
+
+void RetroactiveCapture::trimHistory() {
+  const auto limit = (juce::int64)(historySeconds * captureSampleRate);
+
+  while (!history.empty() &&
+         historySamples - history.front()->numSamples >= limit) {
+    historySamples -= history.front()->numSamples;
+    historyCompressedBytes -= (juce::int64)history.front()->compressedBytes;
+    history.pop_front();
+  }
+}
+
+void RetroactiveCapture::updateMetrics() {
+  const auto stats = getStats();
+  historySecondsGauge.set(stats.historySeconds);
+  memoryBytesGauge.set((double)stats.memoryBytes);
+  compressionRatioGauge.set(stats.compressionRatio);
+}
+
+RetroactiveCapture::Stats RetroactiveCapture::getStats() const {
+  Stats stats;
+  stats.numChannels = numCaptureChannels;
+  stats.droppedSamples = droppedSamples.load();
+  stats.compressCpuSeconds = MetricsRegistry::ticksToSeconds(compressTicks);
+
+  if (captureSampleRate > 0.0 && capturedSamples > 0) {
+    stats.compressCpuLoad = stats.compressCpuSeconds /
+                            (capturedSamples.load() / captureSampleRate);
+  }
+
+  const juce::ScopedLock sl(historyLock);
+
+  if (captureSampleRate > 0.0)
+    stats.historySeconds = historySamples / captureSampleRate;
+
+  stats.uncompressedBytes =
+      historySamples * numCaptureChannels * (juce::int64)sizeof(float);
+  stats.compressedBytes = historyCompressedBytes;
+
+  if (historyCompressedBytes > 0) {
+    stats.compressionRatio =
+        (double)stats.uncompressedBytes / (double)historyCompressedBytes;
+  }
+
+  const auto frameOverhead =
+      (juce::int64)(sizeof(Frame) +
+                    (size_t)numCaptureChannels * sizeof(juce::MemoryBlock));
+  const auto bufferBytes =
+      (juce::int64)(stagingBuffer.getNumSamples() + FRAME_SIZE) *
+      numCaptureChannels * (juce::int64)sizeof(float);
+
+  stats.memoryBytes = historyCompressedBytes +
+                      (juce::int64)history.size() * frameOverhead +
+                      bufferBytes;
+  return stats;
+}
+
+bool RetroactiveCapture::dumpToFile(const juce::File &file, double secondsBack,
+                                    double lengthSeconds,
+                                    std::function<void(bool)> onComplete) {
+  if (dumping.exchange(true)) {
+    LOG_WARNING("Retroactive dump already in progress");
+    return false;
+  }
+
+  std::vector<FramePtr> frames;
+  juce::int64 rangeStart = 0, rangeEnd = 0;
+  const double sampleRate = captureSampleRate;
+
+  {
+    const juce::ScopedLock sl(historyLock);
+
+    if (!history.empty()) {
+      const auto oldest = history.front()->startSample;
+      const auto newest =
+          history.back()->startSample + history.back()->numSamples;
+
+      rangeStart = juce::jmax(
+          oldest, newest - (juce::int64)std::llround(secondsBack * sampleRate));
+      rangeEnd = juce::jmin(
+          newest,
+          rangeStart + (juce::int64)std::llround(lengthSeconds * sampleRate));
+
+      // Frames hold references, so trimming cannot free them mid-dump
+      for (const auto &frame : history) {
+        if (frame->startSample + frame->numSamples > rangeStart &&
+            frame->startSample < rangeEnd) {
+          frames.push_back(frame);
+        }
+      }
+    }
+  }
+
+  if (frames.empty() || rangeEnd <= rangeStart) {
+    LOG_WARNING("Retroactive dump requested but no history is available");
+    dumping = false;
+    return false;
+  }
+
+  const int numChannels = (int)frames.front()->channels.size();
+
+  LOG_INFO("Dumping " + juce::String((rangeEnd - rangeStart) / sampleRate, 1) +
+           " s of retroactive capture to " + file.getFullPathName());
+
+  dumpPool.addJob([this, file, frames = std::move(frames), rangeStart,
+                   rangeEnd, numChannels, sampleRate, onComplete] {
+    ThreadTuning::getInstance().applyToCurrentThread(
+        ThreadTuning::ThreadClass::disk);
+
+    const bool success = writeFrames(file, frames, rangeStart, rangeEnd,
+                                     numChannels, sampleRate);
+    dumping = false;
+
+    if (onComplete)
+      onComplete(success);
+  });
+
+  return true;
+}
+
+bool RetroactiveCapture::isDumping() const { return dumping; }
+
+bool RetroactiveCapture::writeFrames(const juce::File &file,
+                                     const std::vector<FramePtr> &frames,
+                                     juce::int64 rangeStart,
+                                     juce::int64 rangeEnd, int numChannels,
+                                     double sampleRate) {
+  if (!file.getParentDirectory().createDirectory()) {
+    LOG_ERROR("Cannot create directory for " + file.getFullPathName());
+    return false;
+  }
+
+  file.deleteFile();
+
+  auto stream = std::make_unique<juce::FileOutputStream>(file, 1 << 20);
+
+  if (!stream->openedOk()) {
+    LOG_ERROR("Cannot open " + file.getFullPathName());
+    return false;
+  }
+
+  // JUCE writes 32-bit WAV as IEEE float, so the history goes out bit for
+  // bit
+  juce::WavAudioFormat wav;
+  std::unique_ptr<juce::AudioFormatWriter> writer(
+      wav.createWriterFor(stream.get(), sampleRate, (unsigned int)numChannels,
+                          DUMP_BITS_PER_SAMPLE, {}, 0));
+
+  if (writer == nullptr) {
+    LOG_ERROR("Cannot create WAV writer for " + file.getFullPathName());
+    return false;
+  }
+
+  stream.release(); // owned by the writer
+
+  juce::AudioBuffer<float> decoded(numChannels, FRAME_SIZE);
+
+  for (const auto &frame : frames) {
+    for (int ch = 0; ch < numChannels; ++ch) {
+      const auto &block = frame->channels[(size_t)ch];
+
+      if (!LosslessBlockCodec::decode(block.getData(), block.getSize(),
+                                      decoded.getWritePointer(ch),
+                                      frame->numSamples)) {
+        LOG_ERROR("Corrupt frame in retroactive capture history");
+        return false;
+      }
+    }
+
+    const auto start = juce::jmax(rangeStart, frame->startSample);
+    const auto end =
+        juce::jmin(rangeEnd, frame->startSample + frame->numSamples);
+
+    if (!writer->writeFromAudioSampleBuffer(
+            decoded, (int)(start - frame->startSample), (int)(end - start))) {
+      LOG_ERROR("Write failed on " + file.getFullPathName());
+      return false;
+    }
+  }
+
+  LOG_INFO("Retroactive dump written to " + file.getFullPathName());
+  return true;
+}
+
+} // namespace mcam
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../Core/Metrics.h"
+#include "../../Core/ThreadTuning.h"
+#include "../../JuceHeader.h"
+#include "../AudioCallback.h"
+#include "LosslessBlockCodec.h"
+
+#include <deque>
+
+namespace mcam {
+/**
+ * RetroactiveCapture keeps a rolling, losslessly compressed history of every
+ * input channel in memory so audio from before a fault report can be saved.
+ *
+ * The audio thread only copies samples into a preallocated staging FIFO. A
+ * collector thread cuts the staging data into frames of FRAME_SIZE samples
+ * and compresses the channels of each frame in parallel on a worker pool
+ * with LosslessBlockCodec. Frames older than the history length are
+ * discarded. Dumps decode a range of frames and write a WAV file on a
+ * separate background thread.
+ */
+class RetroactiveCapture : public AudioCallback, private juce::Thread {
+public:
+  /** Samples per compressed frame (per channel) */
+  static constexpr int FRAME_SIZE = 4096;
+
+  /** Default history length */
+  static constexpr double DEFAULT_HISTORY_SECONDS = 600.0;
+
+  /** Memory and CPU usage of the history */
+  struct Stats {
+    int numChannels = 0;
+    double historySeconds = 0.0;
+    juce::int64 uncompressedBytes = 0; // as 32-bit float
+    juce::int64 compressedBytes = 0;
+    double compressionRatio = 0.0;
+    juce::int64 memoryBytes = 0; // compressed frames plus staging buffer
+    double compressCpuSeconds = 0.0;
+    double compressCpuLoad = 0.0; // CPU seconds per second of audio
+    juce::int64 droppedSamples = 0;
+  };
+
+  /** Constructor */
+  RetroactiveCapture();
+
+  /** Destructor */
+  ~RetroactiveCapture() override;
+
+  /**
+   * Sets the history length. Takes effect the next time the device starts.
+   * @param seconds Seconds of audio to keep (0 disables capture)
+   */
+  void setHistoryLength(double seconds);
+
+  /** @return The configured history length in seconds */
+  double getHistoryLength() const;
+
+  /**
+   * Writes part of the history to a 32-bit float WAV file (RF64 beyond
+   * 4 GB) in the background. Samples are written exactly as captured, so
+   * float-native and over-full-scale input is neither quantised nor clipped.
+   * @param file Destination file (overwritten)
+   * @param secondsBack Start of the range, in seconds before the newest
+   *                    captured audio
+   * @param lengthSeconds Length of the range (clipped to what is held)
+   * @param onComplete Called on the dump thread with the result (optional)
+   * @return false if there is no history or another dump is running
+   */
+  bool dumpToFile(const juce::File &file, double secondsBack,
+                  double lengthSeconds,
+                  std::function<void(bool success)> onComplete = {});
+
+  /** @return true while a dump is being written */
+  bool isDumping() const;
+
+  /** @return Current memory and CPU usage (safe from any thread) */
+  Stats getStats() const;
+
+  /** Overridden from juce::AudioIODeviceCallback to size the capture */
+  void audioDeviceAboutToStart(juce::AudioIODevice *device) override;
+
+protected:
+  /** Overridden from AudioCallback */
+  void prepareToPlay(double sampleRate, int bufferSize) override;
+  void releaseResources() override;
+  void processAudio(const float *const *inputChannelData, int numInputChannels,
+                    int numSamples) override;
+
+private:
+  /** One compressed block of all channels */
+  struct Frame {
+    juce::int64 startSample = 0;
+    int numSamples = 0;
+    std::vector<juce::MemoryBlock> channels;
+    size_t compressedBytes = 0;
+  };
+
+  using FramePtr = std::shared_ptr<const Frame>;
+
+  /** Collector thread */
+  void run() override;
+
+  /** Compresses up to FRAME_SIZE staged samples and appends the frame */
+  void compressNextFrame(int numSamples);
+
+  /** Drops frames beyond the history length (historyLock held) */
+  void trimHistory();
+
+  /** Publishes the current stats to the metrics registry */
+  void updateMetrics();
+
+  /** Writes the frames to a WAV file (runs on the dump pool) */
+  bool writeFrames(const juce::File &file, const std::vector<FramePtr> &frames,
+                   juce::int64 rangeStart, juce::int64 rangeEnd,
+                   int numChannels, double sampleRate);
+
+  // Configuration
+  std::atomic<double> historySeconds{DEFAULT_HISTORY_SECONDS};
+  int numCaptureChannels = 0;
+  double captureSampleRate = 0.0;
+
+  // Staging FIFO between the audio thread and the collector
+  juce::AbstractFifo stagingFifo{1};
+  juce::AudioBuffer<float> stagingBuffer;
+  std::atomic<bool> capturing{false};
+
+  // Collector state
+  juce::AudioBuffer<float> frameBuffer;
+  juce::int64 nextFrameStart = 0;
+
+  // Compressed history
+  std::deque<FramePtr> history;
+  juce::int64 historyCompressedBytes = 0;
+  juce::int64 historySamples = 0;
+  mutable juce::CriticalSection historyLock;
+
+  // Workers
+  juce::ThreadPool compressionPool;
+  juce::ThreadPool dumpPool{1};
+  std::atomic<bool> dumping{false};
+
+  // Counters
+  std::atomic<juce::int64> droppedSamples{0};
+  std::atomic<juce::int64> capturedSamples{0};
+  std::atomic<juce::int64> compressTicks{0};
+
+  // Instrumentation
+  metrics::Gauge &historySecondsGauge;
+  metrics::Gauge &memoryBytesGauge;
+  metrics::Gauge &compressionRatioGauge;
+  metrics::Counter &compressCpuTotal;
+  metrics::Counter &droppedSamplesTotal;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RetroactiveCapture)
+};
+
+} // namespace mcam
@@ -0,0 +1,44 @@
+#include "AlarmLogger.h"
+
+namespace mcam {
+
+AlarmLogger::AlarmLogger(const AlarmEngine &engine)
+    : alarmEngine(engine),
+      alarmsActive(MetricsRegistry::getInstance().gauge(
+          "mcam_alarms_active", "Input channel alarms currently raised")),
+      alarmsRaised(MetricsRegistry::getInstance().counter(
+          "mcam_alarms_raised_total", "Input channel alarms raised")) {
+  startTimerHz(POLL_RATE_HZ);
+}
+
+AlarmLogger::~AlarmLogger() { stopTimer(); }
+
+void AlarmLogger::poll() {
+  int numRead = 0;
+
+  do {
+    numRead = alarmEngine.readEvents(cursor, events.data(),
+                                     (int)events.size());
+
+    for (int index = 0; index < numRead; ++index) {
+      const auto &event = events[(size_t)index];
+      const auto description =
+          juce::String(AlarmEngine::getTypeName(event.type)) + " on input " +
+          juce::String(event.channel + 1) + " (value " +
+          juce::String(event.value, 4) + ")";
+
+      if (event.raised) {
+        alarmsRaised.add();
+        LOG_WARNING("Alarm raised: " + description);
+      } else {
+        LOG_INFO("Alarm cleared: " + description);
+      }
+    }
+  } while (numRead == (int)events.size());
+
+  alarmsActive.set((double)alarmEngine.getNumActive());
+}
+
+void AlarmLogger::timerCallback() { poll(); }
+
+} // namespace mcam
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "../Processing/Analysis/AlarmEngine.h"
+#include "Logger.h"
+#include "Metrics.h"
+
+namespace mcam {
+/**
+ * AlarmLogger writes every AlarmEngine state change to the log, raises as
+ * warnings and clears as information, and exports the number of raised
+ * alarms as a gauge.
+ *
+ * It polls the engine's event queue from the message thread with its own
+ * cursor, so it never holds up the audio thread or the other readers.
+ */
+class AlarmLogger : private juce::Timer {
+public:
+  /** Polls per second */
+  static constexpr int POLL_RATE_HZ = 4;
+
+  /**
+   * Constructor. Starts logging from the engine's oldest kept event.
+   * @param engine The engine to report on; it must outlive the logger
+   */
+  explicit AlarmLogger(const AlarmEngine &engine);
+
+  /** Destructor */
+  ~AlarmLogger() override;
+
+  /** Logs the events published since the last call */
+  void poll();
+
+private:
+  void timerCallback() override;
+
+  const AlarmEngine &alarmEngine;
+  juce::int64 cursor = 0;
+
+  // Events read per batch (message thread only)
+  std::array<AlarmEngine::Event, 64> events;
+
+  metrics::Gauge &alarmsActive;
+  metrics::Counter &alarmsRaised;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AlarmLogger)
+};
+
+} // namespace mcam
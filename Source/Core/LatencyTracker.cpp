@@ -0,0 +1,170 @@
+#include "LatencyTracker.h"
+
+namespace mcam {
+
+namespace {
+// Host times further than this from the callback are taken to be on a
+// different clock and ignored
+constexpr juce::int64 MAX_HOST_TIME_OFFSET_NS = 1000000000;
+
+double nsToSeconds(juce::int64 ns) { return (double)ns * 1.0e-9; }
+
+double percentile(const std::vector<double> &sorted, double fraction) {
+  if (sorted.empty())
+    return 0.0;
+
+  const auto index = (size_t)juce::jlimit(
+      0, (int)sorted.size() - 1,
+      (int)std::ceil(fraction * (double)sorted.size()) - 1);
+  return sorted[index];
+}
+} // namespace
+
+LatencyTracker &LatencyTracker::getInstance() {
+  static LatencyTracker instance;
+  return instance;
+}
+
+LatencyTracker::LatencyTracker() {
+  auto &registry = MetricsRegistry::getInstance();
+
+  for (int i = 0; i < NUM_STAGES; ++i) {
+    auto &stage = stages[(size_t)i];
+    stage.samples.resize(HISTORY_SIZE);
+    stage.histogram = &registry.histogram(
+        "mcam_latency_seconds",
+        "Input-to-display latency per pipeline stage (instrumented mode)",
+        {0.0005, 0.001, 0.002, 0.005, 0.01, 0.015, 0.02, 0.03, 0.05, 0.075,
+         0.1, 0.2},
+        "stage=\"" + getStageName((Stage)i) + "\"");
+  }
+}
+
+LatencyTracker::~LatencyTracker() = default;
+
+void LatencyTracker::setEnabled(bool shouldBeEnabled) {
+  enabled.store(shouldBeEnabled, std::memory_order_relaxed);
+}
+
+juce::int64 LatencyTracker::nowNs() noexcept {
+  static const double nsPerTick =
+      1.0e9 / (double)juce::Time::getHighResolutionTicksPerSecond();
+  return (juce::int64)((double)juce::Time::getHighResolutionTicks() *
+                       nsPerTick);
+}
+
+LatencyTracker::Stamp
+LatencyTracker::stampBlock(const juce::AudioIODeviceCallbackContext &context,
+                           int numSamples, double sampleRate) noexcept {
+  Stamp stamp;
+  stamp.callbackNs = nowNs();
+
+  // The block ends at the host time (or on arrival) and starts one block
+  // duration earlier
+  juce::int64 blockEndNs = stamp.callbackNs;
+
+  if (context.hostTimeNs != nullptr) {
+    const auto hostNs = (juce::int64)*context.hostTimeNs;
+
+    if (hostNs <= stamp.callbackNs &&
+        stamp.callbackNs - hostNs < MAX_HOST_TIME_OFFSET_NS)
+      blockEndNs = hostNs;
+  }
+
+  const auto blockNs =
+      sampleRate > 0.0 ? (juce::int64)(numSamples * 1.0e9 / sampleRate) : 0;
+  stamp.captureNs = juce::jmax((juce::int64)1, blockEndNs - blockNs);
+
+  return stamp;
+}
+
+void LatencyTracker::recordPainted(const Stamp &stamp) {
+  if (!stamp.isValid() || stamp.callbackNs == 0 || stamp.analysisNs == 0 ||
+      stamp.publishNs == 0)
+    return;
+
+  const auto paintedNs = nowNs();
+
+  addSample(Stage::Capture, nsToSeconds(stamp.callbackNs - stamp.captureNs));
+  addSample(Stage::Analysis,
+            nsToSeconds(stamp.analysisNs - stamp.callbackNs));
+  addSample(Stage::Publish, nsToSeconds(stamp.publishNs - stamp.analysisNs));
+  addSample(Stage::Paint, nsToSeconds(paintedNs - stamp.publishNs));
+  addSample(Stage::Total, nsToSeconds(paintedNs - stamp.captureNs));
+}
+
+void LatencyTracker::addSample(Stage stage, double seconds) {
+  auto &history = stages[(size_t)stage];
+  history.histogram->observe(seconds);
+
+  const juce::ScopedLock sl(historyLock);
+  history.samples[(size_t)history.writeIndex] = seconds;
+  history.writeIndex = (history.writeIndex + 1) % HISTORY_SIZE;
+  history.count = juce::jmin(history.count + 1, HISTORY_SIZE);
+}
+
+LatencyTracker::StageSummary LatencyTracker::getSummary(Stage stage) const {
+  std::vector<double> sorted;
+
+  {
+    const juce::ScopedLock sl(historyLock);
+    const auto &history = stages[(size_t)stage];
+    sorted.assign(history.samples.begin(),
+                  history.samples.begin() + history.count);
+  }
+
+  std::sort(sorted.begin(), sorted.end());
+
+  StageSummary summary;
+  summary.count = (int)sorted.size();
+  summary.p50 = percentile(sorted, 0.50);
+  summary.p95 = percentile(sorted, 0.95);
+  summary.p99 = percentile(sorted, 0.99);
+  summary.max = sorted.empty() ? 0.0 : sorted.back();
+  return summary;
+}
+
+juce::String LatencyTracker::getReport() const {
+  juce::String report;
+
+  for (int i = 0; i < NUM_STAGES; ++i) {
+    const auto summary = getSummary((Stage)i);
+
+    report << getStageName((Stage)i).paddedRight(' ', 9)
+           << " n=" << summary.count
+           << " p50=" << juce::String(summary.p50 * 1000.0, 2)
+           << " p95=" << juce::String(summary.p95 * 1000.0, 2)
+           << " p99=" << juce::String(summary.p99 * 1000.0, 2)
+           << " max=" << juce::String(summary.max * 1000.0, 2) << " ms\n";
+  }
+
+  return report;
+}
+
+void LatencyTracker::reset() {
+  const juce::ScopedLock sl(historyLock);
+
+  for (auto &history : stages) {
+    history.writeIndex = 0;
+    history.count = 0;
+  }
+}
+
+juce::String LatencyTracker::getStageName(Stage stage) {
+  switch (stage) {
+  case Stage::Capture:
+    return "capture";
+  case Stage::Analysis:
+    return "analysis";
+  case Stage::Publish:
+    return "publish";
+  case Stage::Paint:
+    return "paint";
+  case Stage::Total:
+    return "total";
+  }
+
+  return {};
+}
+
+} // namespace mcam
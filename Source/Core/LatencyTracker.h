@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "Metrics.h"
+
+namespace mcam {
+/**
+ * LatencyTracker measures input-to-display latency when instrumented mode
+ * is enabled.
+ *
+ * Each block is stamped with the time its first sample was captured. The
+ * stamp is extended as the block moves through the pipeline and is
+ * recorded when the meter showing it has painted:
+ *
+ *   capture   first sample captured -> device callback starts
+ *   analysis  callback starts       -> slot levels computed
+ *   publish   levels computed       -> level delivered to the message thread
+ *   paint     delivered             -> meter painted
+ *
+ * All stamps are nanoseconds on the high resolution clock. Distributions are
+ * exported as histograms through the MetricsRegistry and kept as recent
+ * samples for percentile reports. When disabled, no stamps are taken.
+ */
+class LatencyTracker {
+public:
+  /** Pipeline stages, in order */
+  enum class Stage { Capture, Analysis, Publish, Paint, Total };
+
+  /** Number of stages, including Total */
+  static constexpr int NUM_STAGES = 5;
+
+  /** Recent samples kept per stage for percentiles */
+  static constexpr int HISTORY_SIZE = 4096;
+
+  /** Times a block passed each stage (0 = not reached) */
+  struct Stamp {
+    juce::int64 captureNs = 0;
+    juce::int64 callbackNs = 0;
+    juce::int64 analysisNs = 0;
+    juce::int64 publishNs = 0;
+
+    /** @return true if the block was stamped at capture */
+    bool isValid() const noexcept { return captureNs != 0; }
+  };
+
+  /** Percentiles of one stage, in seconds */
+  struct StageSummary {
+    int count = 0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+  };
+
+  /** Get the single instance of the tracker */
+  static LatencyTracker &getInstance();
+
+  /** Turns instrumented mode on or off */
+  void setEnabled(bool shouldBeEnabled);
+
+  /** @return true if blocks should be stamped */
+  bool isEnabled() const noexcept {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /** @return Current time on the stamp clock */
+  static juce::int64 nowNs() noexcept;
+
+  /**
+   * Stamps a block on arrival in a device callback. Uses the device's host
+   * time when it reports one on the same clock; otherwise the block is
+   * assumed to have completed on arrival.
+   * @param context Callback context from the device
+   * @param numSamples Block length
+   * @param sampleRate Device sample rate
+   * @return Stamp with capture and callback times set
+   */
+  static Stamp stampBlock(const juce::AudioIODeviceCallbackContext &context,
+                          int numSamples, double sampleRate) noexcept;
+
+  /**
+   * Records a block that has been painted. Call on the message thread
+   * after the paint.
+   * @param stamp Stamp carried through the pipeline
+   */
+  void recordPainted(const Stamp &stamp);
+
+  /** @return Percentiles of the recent samples of a stage */
+  StageSummary getSummary(Stage stage) const;
+
+  /** @return One line per stage with count and percentiles in ms */
+  juce::String getReport() const;
+
+  /** Discards the recent samples (histograms keep counting) */
+  void reset();
+
+  /** @return Name of a stage as used in reports and metric labels */
+  static juce::String getStageName(Stage stage);
+
+private:
+  LatencyTracker();
+  ~LatencyTracker();
+
+  /** Adds one sample to a stage */
+  void addSample(Stage stage, double seconds);
+
+  struct StageHistory {
+    std::vector<double> samples;
+    int writeIndex = 0;
+    int count = 0;
+    metrics::Histogram *histogram = nullptr;
+  };
+
+  std::atomic<bool> enabled{false};
+  std::array<StageHistory, NUM_STAGES> stages;
+  mutable juce::CriticalSection historyLock;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LatencyTracker)
+};
+
+} // namespace mcam
@@ -1,7 +1,11 @@
 #include "../JuceHeader.h"
+#include "../Processing/Analysis/OfflineAnalyzer.h"
+#include "LatencyTracker.h"
 #include "MainComponent.h"
 #include "Logger.h"
 
+#include <iostream>
+
 // Application properties file name
 const char* APP_PROPERTIES_FILE = "MCAMProperties.xml";
 // Log file location
@@ -36,17 +40,35 @@ public:
     //==============================================================================
     void initialise(const juce::String& commandLine) override
     {
+        // Reference point for the startup timing logged by MainComponent
+        startTicks = juce::Time::getHighResolutionTicks();
+
         // Initialize logger first
         initializeLogger();
 
         // Log application startup
         LOG_INFO("Application starting: " + getApplicationName() + " v" + getApplicationVersion());
 
+        // Offline analysis runs without a device or window
+        if (commandLine.contains("--analyze"))
+        {
+            setApplicationReturnValue(runOfflineAnalysis(commandLine));
+            quit();
+            return;
+        }
+
+        // Instrumented mode: stamp blocks from capture to paint
+        if (commandLine.contains("--measure-latency"))
+        {
+            mcam::LatencyTracker::getInstance().setEnabled(true);
+            LOG_INFO("Latency measurement enabled");
+        }
+
         // Initialize application properties
         initializeAppProperties();
 
         // Initialize the main window
-        mainWindow.reset(new MainWindow(getApplicationName(), appProperties.get()));
+        mainWindow.reset(new MainWindow(getApplicationName(), appProperties.get(), startTicks));
 
         LOG_INFO("Application initialized successfully");
     }
@@ -59,6 +81,10 @@ public:
         mainWindow = nullptr;
         appProperties = nullptr;
 
+        auto& latencyTracker = mcam::LatencyTracker::getInstance();
+        if (latencyTracker.isEnabled())
+            LOG_INFO("Input-to-display latency:\n" + latencyTracker.getReport());
+
         LOG_INFO("Application shutdown complete");
     }
 
@@ -81,6 +107,69 @@ public:
     }
 
 private:
+    /**
+     * Runs the command line analysis mode:
+     *   MCAM --analyze [--json] [--output <file>] [--threads <n>] <files or directories>
+     * @return Process exit code
+     */
+    int runOfflineAnalysis(const juce::String& commandLine)
+    {
+        juce::ArgumentList args("MCAM", commandLine);
+        args.removeOptionIfFound("--analyze");
+
+        const bool asJson = args.removeOptionIfFound("--json");
+        const auto outputPath = args.removeValueForOption("--output|-o");
+        const int numThreads = args.removeValueForOption("--threads").getIntValue();
+
+        // Remaining arguments are files or directories to scan
+        juce::Array<juce::File> files;
+        for (const auto& arg : args.arguments)
+        {
+            const auto file = arg.resolveAsFile();
+
+            if (file.isDirectory())
+                files.addArray(file.findChildFiles(juce::File::findFiles, true, "*.wav;*.flac;*.aif;*.aiff"));
+            else
+                files.add(file);
+        }
+
+        if (files.isEmpty())
+        {
+            std::cerr << "Usage: MCAM --analyze [--json] [--output <file>] [--threads <n>] <files or directories>" << std::endl;
+            return 1;
+        }
+
+        mcam::OfflineAnalyzer analyzer(numThreads);
+        const auto report = analyzer.analyze(files);
+        const auto text = asJson ? report.toJson() : report.toCsv();
+
+        if (outputPath.isNotEmpty())
+        {
+            const juce::File outputFile(juce::File::getCurrentWorkingDirectory().getChildFile(outputPath));
+
+            if (!outputFile.replaceWithText(text))
+            {
+                std::cerr << "Cannot write " << outputFile.getFullPathName() << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            std::cout << text;
+        }
+
+        for (const auto& error : report.errors)
+            std::cerr << "Error: " << error << std::endl;
+
+        std::cerr << "Analysed " << report.numFiles << " file(s), "
+                  << juce::String(report.audioSeconds, 1) << " s of audio ("
+                  << juce::String(report.channelSeconds, 1) << " channel-seconds) in "
+                  << juce::String(report.wallSeconds, 2) << " s: "
+                  << juce::String(report.realtimeMultiple, 1) << "x real time" << std::endl;
+
+        return report.errors.isEmpty() ? 0 : 2;
+    }
+
     void initializeLogger()
     {
         // Create logs directory if it doesn't exist
@@ -116,7 +205,7 @@ private:
     class MainWindow : public juce::DocumentWindow
     {
     public:
-        MainWindow(juce::String name, juce::ApplicationProperties* properties)
+        MainWindow(juce::String name, juce::ApplicationProperties* properties, juce::int64 startTicks)
             : DocumentWindow(name,
                             juce::Desktop::getInstance().getDefaultLookAndFeel()
                                 .findColour(juce::ResizableWindow::backgroundColourId),
@@ -125,13 +214,16 @@ private:
             LOG_INFO("Creating main window");
 
             setUsingNativeTitleBar(true);
-            setContentOwned(new MainComponent(), true);
+
+            // Layout, routing and engine settings from the last session are
+            // applied before audio starts
+            auto* props = properties != nullptr ? properties->getUserSettings() : nullptr;
+            auto* content = new MainComponent(startTicks, props);
+            setContentOwned(content, true);
 
             // Restore window position and size from properties
-            if (properties != nullptr)
+            if (props != nullptr)
             {
-                auto* props = properties->getUserSettings();
-
                 // Set default size first
                 setSize(800, 600);
 
@@ -176,6 +268,10 @@ private:
                 props->setValue("mainWindowY", getY());
                 props->setValue("mainWindowWidth", getWidth());
                 props->setValue("mainWindowHeight", getHeight());
+
+                if (auto* content = dynamic_cast<MainComponent*>(getContentComponent()))
+                    content->saveSettings(props);
+
                 appProperties->saveIfNeeded();
 
                 LOG_INFO("Saved window position: " + juce::String(getX()) + "," + juce::String(getY()) +
@@ -191,6 +287,7 @@ private:
 
     std::unique_ptr<juce::ApplicationProperties> appProperties;
     std::unique_ptr<MainWindow> mainWindow;
+    juce::int64 startTicks = 0;
 };
 
 //==============================================================================
@@ -1,7 +1,12 @@
 #include "MainComponent.h"
 
 //==============================================================================
-MainComponent::MainComponent() {
+MainComponent::MainComponent(juce::int64 startTicks,
+                             juce::PropertiesFile *props)
+    : frameTime(mcam::MetricsRegistry::getInstance().histogram(
+          "mcam_ui_frame_seconds", "Time to paint the main window",
+          {0.001, 0.002, 0.004, 0.008, 0.016, 0.033, 0.05, 0.1, 0.25})),
+      appStartTicks(startTicks) {
   LOG_INFO("Initializing MainComponent");
 
   // Set the initial size
@@ -13,17 +18,44 @@ MainComponent::MainComponent() {
   // Create layout
   createLayout();
 
-  // Initialize audio
+  // Create the audio engine; nothing is opened yet
   initializeAudio();
 
   // Create monitoring slots
   createMonitoringSlots();
 
+  // The engine takes the stored settings before its threads start, so the
+  // first device start already uses them
+  if (props != nullptr) {
+    applySettings(props);
+  } else {
+    // Start OSC endpoint with default ports
+    initializeNetwork();
+  }
+
+  // Start audio in the background
+  startAudio();
+
   LOG_INFO("MainComponent initialized");
 }
 
 MainComponent::~MainComponent() {
   LOG_INFO("MainComponent being destroyed");
+
+  if (audioEngine != nullptr) {
+    audioEngine->getDeviceSwitcher().removeListener(this);
+
+    // The catalog exists once the background start has got far enough
+    if (audioEngine->isAudioInitialized())
+      audioEngine->getAudioDeviceManager().getDeviceCatalog()->removeListener(
+          this);
+  }
+
+  // Stop network access before the audio engine goes away
+  metricsServer = nullptr;
+  oscServer = nullptr;
+  alarmLogger = nullptr;
+
   // Audio engine will be cleaned up automatically
 }
 
@@ -31,6 +63,8 @@ MainComponent::~MainComponent() {
 void MainComponent::paint(juce::Graphics &g) {
   LOG_DEBUG("MainComponent::paint called");
 
+  frameStartTicks = juce::Time::getHighResolutionTicks();
+
   // Fill the background
   g.fillAll(
       getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
@@ -50,6 +84,20 @@ void MainComponent::paint(juce::Graphics &g) {
              juce::Justification::centredRight, true);
 }
 
+void MainComponent::paintOverChildren(juce::Graphics &) {
+  // Children have been painted by now, so this closes the frame
+  if (frameStartTicks != 0) {
+    frameTime.observe(mcam::MetricsRegistry::ticksToSeconds(
+        juce::Time::getHighResolutionTicks() - frameStartTicks));
+    frameStartTicks = 0;
+  }
+
+  if (!firstFrameShown) {
+    firstFrameShown = true;
+    recordStartupMilestone("first_frame");
+  }
+}
+
 void MainComponent::resized() {
   LOG_DEBUG("MainComponent::resized called - new size: " +
             juce::String(getWidth()) + "x" + juce::String(getHeight()));
@@ -67,8 +115,12 @@ void MainComponent::resized() {
   channelCountLabel.setBounds(topSection.removeFromLeft(200).reduced(10));
   verticalLayoutButton.setBounds(topSection.removeFromLeft(120).reduced(10));
 
-  // Place test button in the bottom section
+  // Place the buttons in the bottom section, the alarm banner beside them
   testButton.setBounds(bottomSection.removeFromRight(100).reduced(10));
+  recordButton.setBounds(bottomSection.removeFromRight(100).reduced(10));
+  saveHistoryButton.setBounds(bottomSection.removeFromRight(140).reduced(10));
+  derivedButton.setBounds(bottomSection.removeFromRight(110).reduced(10));
+  alarmBanner.setBounds(bottomSection.reduced(10));
 
   // Position resize corner
   if (resizeCorner != nullptr) {
@@ -118,6 +170,61 @@ void MainComponent::applySettings(juce::PropertiesFile *props) {
   verticalLayoutButton.setToggleState(isVerticalLayout,
                                       juce::dontSendNotification);
 
+  // Load recording location
+  recordingDirectory = juce::File(props->getValue(
+      "recordingDirectory", recordingDirectory.getFullPathName()));
+
+  // Load retroactive capture settings (history applies on next device start)
+  retroDumpSeconds =
+      props->getDoubleValue("retroDumpSeconds", retroDumpSeconds);
+
+  // Restore derived channels first, so slots can select them
+  if (audioEngine != nullptr) {
+    auto &processor = audioEngine->getBufferProcessor();
+
+    for (int i = 0; i < mcam::BufferProcessor::MAX_DERIVED_CHANNELS; ++i) {
+      const juce::String prefix = "derived" + juce::String(i + 1);
+      std::vector<mcam::ChannelMatrixMixer::Term> terms;
+
+      if (!props->containsKey(prefix + "Terms"))
+        continue;
+
+      if (mcam::ChannelMatrixMixer::termsFromString(
+              props->getValue(prefix + "Terms"), terms)) {
+        processor.setDerivedChannel(i, props->getValue(prefix + "Name"),
+                                    std::move(terms));
+      } else {
+        LOG_WARNING("Ignoring malformed " + prefix + "Terms setting");
+      }
+    }
+  }
+
+  // Restore the last session's routing; the processor takes it before the
+  // device has opened
+  for (int i = 0; i < (int)monitoringSlots.size(); ++i) {
+    if (monitoringSlots[(size_t)i] != nullptr)
+      monitoringSlots[(size_t)i]->setChannel(
+          props->getIntValue("slot" + juce::String(i + 1) + "Channel", -1));
+  }
+
+  if (audioEngine != nullptr) {
+    audioEngine->getRetroactiveCapture().setHistoryLength(
+        props->getDoubleValue(
+            "retroHistorySeconds",
+            mcam::RetroactiveCapture::DEFAULT_HISTORY_SECONDS));
+
+    // Analyse fixed hops so readings do not depend on the device block size
+    audioEngine->getBufferProcessor().setAnalysisHopSize(props->getIntValue(
+        "analysisHopSize",
+        mcam::BufferProcessor::DEFAULT_ANALYSIS_HOP_SIZE));
+  }
+
+  // Pin and prioritise the engine threads
+  applyThreadSettings(*props);
+
+  // Restart OSC endpoint with stored ports
+  initializeNetwork(props);
+
   // Update layout
   resized();
 }
@@ -132,6 +239,62 @@ void MainComponent::saveSettings(juce::PropertiesFile *props) {
 
   // Save layout setting
   props->setValue("verticalLayout", isVerticalLayout);
+
+  // Save OSC settings so they can be edited in the settings file
+  props->setValue("oscReceivePort",
+                  props->getIntValue("oscReceivePort",
+                                     mcam::OSCServer::DEFAULT_RECEIVE_PORT));
+  props->setValue("oscTargetHost",
+                  props->getValue("oscTargetHost", "127.0.0.1"));
+  props->setValue("oscTargetPort",
+                  props->getIntValue("oscTargetPort",
+                                     mcam::OSCServer::DEFAULT_SEND_PORT));
+  props->setValue("recordingDirectory", recordingDirectory.getFullPathName());
+  props->setValue("retroDumpSeconds", retroDumpSeconds);
+
+  if (audioEngine != nullptr) {
+    props->setValue("retroHistorySeconds",
+                    audioEngine->getRetroactiveCapture().getHistoryLength());
+
+    auto &processor = audioEngine->getBufferProcessor();
+    for (int i = 0; i < (int)monitoringSlots.size(); ++i)
+      props->setValue("slot" + juce::String(i + 1) + "Channel",
+                      processor.getMonitorChannel(i));
+
+    props->setValue("analysisHopSize", processor.getAnalysisHopSize());
+
+    for (int i = 0; i < mcam::BufferProcessor::MAX_DERIVED_CHANNELS; ++i) {
+      const juce::String prefix = "derived" + juce::String(i + 1);
+      const auto terms = processor.getDerivedChannelTerms(i);
+
+      if (terms.empty()) {
+        props->removeValue(prefix + "Name");
+        props->removeValue(prefix + "Terms");
+      } else {
+        props->setValue(prefix + "Name", processor.getDerivedChannelName(i));
+        props->setValue(prefix + "Terms",
+                        mcam::ChannelMatrixMixer::termsToString(terms));
+      }
+    }
+  }
+  props->setValue("metricsPort",
+                  props->getIntValue("metricsPort",
+                                     mcam::MetricsServer::DEFAULT_PORT));
+
+  // Save thread settings so they can be edited in the settings file
+  props->setValue("lockMemory", props->getBoolValue("lockMemory", false));
+
+  for (int i = 0; i < mcam::ThreadTuning::NUM_THREAD_CLASSES; ++i) {
+    const juce::String prefix = mcam::ThreadTuning::getClassName(
+        (mcam::ThreadTuning::ThreadClass)i);
+
+    props->setValue(prefix + "ThreadCpus",
+                    props->getValue(prefix + "ThreadCpus"));
+    props->setValue(prefix + "ThreadFifoPriority",
+                    props->getIntValue(prefix + "ThreadFifoPriority"));
+    props->setValue(prefix + "ThreadNice",
+                    props->getIntValue(prefix + "ThreadNice"));
+  }
 }
 
 void MainComponent::initializeUI() {
@@ -157,6 +320,33 @@ void MainComponent::initializeUI() {
   };
   addAndMakeVisible(testButton);
 
+  // Setup record button
+  recordingDirectory =
+      juce::File::getSpecialLocation(juce::File::userMusicDirectory)
+          .getChildFile("MCAM Recordings");
+
+  recordButton.setButtonText("Record");
+  recordButton.setClickingTogglesState(true);
+  recordButton.setColour(juce::TextButton::buttonOnColourId,
+                         juce::Colours::darkred);
+  recordButton.onClick = [this]() {
+    setRecording(recordButton.getToggleState());
+  };
+  addAndMakeVisible(recordButton);
+
+  // Setup history button
+  saveHistoryButton.setButtonText("Save History");
+  saveHistoryButton.onClick = [this]() { saveHistory(); };
+  addAndMakeVisible(saveHistoryButton);
+
+  // Setup derived channel button
+  derivedButton.setButtonText("Derived...");
+  derivedButton.onClick = [this]() { editDerivedChannel(); };
+  addAndMakeVisible(derivedButton);
+
+  // Setup alarm banner; the engine is attached with the audio engine
+  addAndMakeVisible(alarmBanner);
+
   // Setup device selector
   deviceLabel.setText("Audio Device:", juce::dontSendNotification);
   deviceLabel.setJustificationType(juce::Justification::right);
@@ -164,16 +354,18 @@ void MainComponent::initializeUI() {
 
   deviceSelector.setTextWhenNothingSelected("Select Audio Device");
   deviceSelector.onChange = [this]() {
-    if (audioEngine != nullptr && deviceSelector.getSelectedItemIndex() >= 0) {
+    if (audioEngine != nullptr && audioEngine->isAudioInitialized() &&
+        deviceSelector.getSelectedItemIndex() >= 0) {
       auto deviceName = deviceSelector.getText();
       LOG_INFO("Device selected: " + deviceName);
 
-      audioEngine->setAudioDevice(deviceName);
-
-      // Update channel count label
-      int channels = audioEngine->getNumInputChannels();
-      channelCountLabel.setText("Input Channels: " + juce::String(channels),
-                                juce::dontSendNotification);
+      // Open the device in the background; the label is updated when the
+      // switch completes
+      if (deviceName != audioEngine->getCurrentDeviceName()) {
+        channelCountLabel.setText("Opening " + deviceName + "...",
+                                  juce::dontSendNotification);
+        audioEngine->setAudioDeviceAsync(deviceName);
+      }
     }
   };
   addAndMakeVisible(deviceSelector);
@@ -218,30 +410,51 @@ void MainComponent::initializeAudio() {
 
   // Create audio engine
   audioEngine = std::make_unique<mcam::AudioEngine>();
+  audioEngine->getDeviceSwitcher().addListener(this);
 
-  // Initialize audio engine
-  if (audioEngine->initialize()) {
-    LOG_INFO("Audio engine initialized successfully");
+  // Alarms are evaluated from the first block on
+  auto &alarmEngine = audioEngine->getBufferProcessor().getAlarmEngine();
+  alarmLogger = std::make_unique<mcam::AlarmLogger>(alarmEngine);
+  alarmBanner.setAlarmEngine(&alarmEngine);
+}
 
-    // Populate device selector
-    auto deviceNames = audioEngine->getAvailableDeviceNames();
+void MainComponent::startAudio() {
+  // Open the device in the background; the selector is filled in when the
+  // engine is ready
+  channelCountLabel.setText("Opening audio device...",
+                            juce::dontSendNotification);
+  deviceSelector.setEnabled(false);
+
+  audioEngine->initializeAsync(
+      [safeThis = juce::Component::SafePointer<MainComponent>(this)](
+          bool success) {
+        if (safeThis != nullptr)
+          safeThis->audioInitialized(success);
+      });
+}
 
-    deviceSelector.clear();
-    for (int i = 0; i < deviceNames.size(); ++i) {
-      deviceSelector.addItem(deviceNames[i], i + 1);
-    }
+void MainComponent::audioInitialized(bool success) {
+  recordStartupMilestone("audio_ready");
+  deviceSelector.setEnabled(true);
 
-    // Select current device if any
-    auto currentDevice = audioEngine->getCurrentDeviceName();
-    if (currentDevice.isNotEmpty()) {
-      deviceSelector.setText(currentDevice, juce::dontSendNotification);
+  if (success) {
+    LOG_INFO("Audio engine initialized successfully");
 
-      // Update channel count label
-      int channels = audioEngine->getNumInputChannels();
-      channelCountLabel.setText("Input Channels: " + juce::String(channels),
-                                juce::dontSendNotification);
-    }
+    // Populate device selector from the cached list; the rest of the
+    // devices are added as the background scan finds them
+    updateDeviceList();
+
+    if (auto *catalog =
+            audioEngine->getAudioDeviceManager().getDeviceCatalog())
+      catalog->addListener(this);
+
+    // Update channel count label
+    int channels = audioEngine->getNumInputChannels();
+    channelCountLabel.setText("Input Channels: " + juce::String(channels),
+                              juce::dontSendNotification);
   } else {
+    channelCountLabel.setText("Input Channels: 0", juce::dontSendNotification);
+
     LOG_ERROR("Failed to initialize audio engine");
 
     juce::AlertWindow::showMessageBoxAsync(
@@ -252,6 +465,87 @@ void MainComponent::initializeAudio() {
   }
 }
 
+void MainComponent::recordStartupMilestone(const juce::String &milestone) {
+  const double seconds = mcam::MetricsRegistry::ticksToSeconds(
+      juce::Time::getHighResolutionTicks() - appStartTicks);
+
+  mcam::MetricsRegistry::getInstance()
+      .gauge("mcam_startup_seconds",
+             "Time from application start to a startup milestone",
+             "milestone=\"" + milestone + "\"")
+      .set(seconds);
+
+  LOG_INFO("Startup: " + milestone + " after " +
+           juce::String(seconds * 1000.0, 0) + " ms");
+}
+
+void MainComponent::updateDeviceList() {
+  auto deviceNames = audioEngine->getAvailableDeviceNames();
+
+  // The device in use is listed even before the scan has found it
+  auto currentDevice = audioEngine->getCurrentDeviceName();
+  if (currentDevice.isNotEmpty() && !deviceNames.contains(currentDevice))
+    deviceNames.insert(0, currentDevice);
+
+  deviceSelector.clear(juce::dontSendNotification);
+  for (int i = 0; i < deviceNames.size(); ++i) {
+    deviceSelector.addItem(deviceNames[i], i + 1);
+  }
+
+  // Select current device if any
+  if (currentDevice.isNotEmpty())
+    deviceSelector.setText(currentDevice, juce::dontSendNotification);
+}
+
+void MainComponent::deviceListChanged() {
+  LOG_INFO("Audio device list changed");
+
+  // Don't disturb the selector while a switch is in flight
+  if (!audioEngine->getDeviceSwitcher().isSwitching())
+    updateDeviceList();
+}
+
+void MainComponent::deviceSwitchStatusChanged(
+    const mcam::DeviceSwitcher::Status &status) {
+  using State = mcam::DeviceSwitcher::State;
+
+  // A newer request supersedes this one; its status will follow
+  if (status.state != State::Switching &&
+      audioEngine->getDeviceSwitcher().isSwitching())
+    return;
+
+  switch (status.state) {
+  case State::Switching:
+    channelCountLabel.setText("Opening " + status.deviceName + "...",
+                              juce::dontSendNotification);
+    break;
+
+  case State::Completed:
+    deviceSelector.setText(status.deviceName, juce::dontSendNotification);
+    channelCountLabel.setText("Input Channels: " +
+                                  juce::String(status.numInputChannels),
+                              juce::dontSendNotification);
+    break;
+
+  case State::Failed: {
+    // Show the device that is still (or no longer) open
+    auto currentDevice = audioEngine->getCurrentDeviceName();
+    deviceSelector.setText(currentDevice, juce::dontSendNotification);
+    channelCountLabel.setText(
+        "Input Channels: " + juce::String(audioEngine->getNumInputChannels()),
+        juce::dontSendNotification);
+
+    juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon,
+                                           "Audio Device Error", status.error,
+                                           "OK");
+    break;
+  }
+
+  case State::Idle:
+    break;
+  }
+}
+
 void MainComponent::createMonitoringSlots() {
   LOG_INFO("Creating monitoring slots");
 
@@ -259,11 +553,28 @@ void MainComponent::createMonitoringSlots() {
   for (int i = 0; i < 4; ++i) {
     monitoringSlots[i] = std::make_unique<mcam::MonitoringSlotComponent>(i);
     monitoringSlots[i]->setTitle("Monitor " + juce::String(i + 1));
+    monitoringSlots[i]->onFirstLevel = [this]() {
+      if (!firstMeterShown) {
+        firstMeterShown = true;
+        recordStartupMilestone("first_meter");
+      }
+    };
 
     // Connect to buffer processor if audio engine is initialized
     if (audioEngine != nullptr) {
       monitoringSlots[i]->connectToBufferProcessor(
           &audioEngine->getBufferProcessor());
+
+      // With the JACK device open, any port of the graph can feed a slot
+      monitoringSlots[i]->getSourcePorts = [this]() {
+        return audioEngine->getJackSourcePorts();
+      };
+      monitoringSlots[i]->onSourcePortSelected =
+          [this, i](const juce::String &port) {
+            if (!audioEngine->connectJackPortToSlot(port, i))
+              LOG_WARNING("Could not connect " + port + " to slot " +
+                          juce::String(i + 1));
+          };
     }
 
     addAndMakeVisible(*monitoringSlots[i]);
@@ -271,3 +582,217 @@ void MainComponent::createMonitoringSlots() {
 
   LOG_INFO("Monitoring slots created");
 }
+
+void MainComponent::initializeNetwork(juce::PropertiesFile *props) {
+  int receivePort = mcam::OSCServer::DEFAULT_RECEIVE_PORT;
+  juce::String targetHost = "127.0.0.1";
+  int targetPort = mcam::OSCServer::DEFAULT_SEND_PORT;
+  int metricsPort = mcam::MetricsServer::DEFAULT_PORT;
+
+  if (props != nullptr) {
+    receivePort = props->getIntValue("oscReceivePort", receivePort);
+    targetHost = props->getValue("oscTargetHost", targetHost);
+    targetPort = props->getIntValue("oscTargetPort", targetPort);
+    metricsPort = props->getIntValue("metricsPort", metricsPort);
+  }
+
+  // Metrics are served even if audio failed, so the failure can be scraped
+  if (metricsServer == nullptr) {
+    metricsServer = std::make_unique<mcam::MetricsServer>();
+  }
+
+  if (!metricsServer->start(metricsPort)) {
+    LOG_WARNING("Metrics endpoint could not be started");
+  }
+
+  if (audioEngine == nullptr) {
+    LOG_WARNING("Audio engine not available - OSC endpoint disabled");
+    return;
+  }
+
+  if (oscServer == nullptr) {
+    oscServer =
+        std::make_unique<mcam::OSCServer>(audioEngine->getBufferProcessor());
+  }
+
+  if (!oscServer->start(receivePort, targetHost, targetPort)) {
+    LOG_WARNING("OSC endpoint could not be started");
+  }
+}
+
+void MainComponent::applyThreadSettings(juce::PropertiesFile &props) {
+  using ThreadTuning = mcam::ThreadTuning;
+  auto &threadTuning = ThreadTuning::getInstance();
+
+  // e.g. audioThreadCpus="2-3", audioThreadFifoPriority=80,
+  // analysisThreadNice=5
+  for (int i = 0; i < ThreadTuning::NUM_THREAD_CLASSES; ++i) {
+    const auto threadClass = (ThreadTuning::ThreadClass)i;
+    const juce::String prefix = ThreadTuning::getClassName(threadClass);
+
+    ThreadTuning::Settings settings;
+    settings.fifoPriority = props.getIntValue(prefix + "ThreadFifoPriority");
+    settings.niceValue = props.getIntValue(prefix + "ThreadNice");
+
+    if (!ThreadTuning::parseCpuList(props.getValue(prefix + "ThreadCpus"),
+                                    settings.cpus) ||
+        !threadTuning.setSettings(threadClass, settings)) {
+      LOG_WARNING("Invalid settings for the " + prefix + " threads ignored");
+      continue;
+    }
+
+    if (!settings.cpus.isZero() || settings.fifoPriority != 0 ||
+        settings.niceValue != 0)
+      LOG_INFO(prefix + " threads: CPUs \"" +
+               props.getValue(prefix + "ThreadCpus") + "\", FIFO priority " +
+               juce::String(settings.fifoPriority) + ", nice " +
+               juce::String(settings.niceValue));
+  }
+
+  threadTuning.setMemoryLocking(props.getBoolValue("lockMemory", false));
+
+  // The message thread is the UI thread; the others apply theirs from
+  // their own loops
+  threadTuning.applyToCurrentThread(ThreadTuning::ThreadClass::ui);
+
+  // A device that is already running has its buffers allocated
+  if (audioEngine != nullptr && audioEngine->isAudioInitialized())
+    threadTuning.lockMemory();
+}
+
+void MainComponent::setRecording(bool shouldRecord) {
+  if (audioEngine == nullptr || !audioEngine->isAudioInitialized()) {
+    recordButton.setToggleState(false, juce::dontSendNotification);
+    return;
+  }
+
+  auto &recorder = audioEngine->getDiskRecorder();
+
+  if (!shouldRecord) {
+    recorder.stopRecording();
+    recordButton.setButtonText("Record");
+    return;
+  }
+
+  mcam::DiskRecorder::Settings settings;
+  settings.directory = recordingDirectory;
+
+  for (int i = 0; i < audioEngine->getNumInputChannels(); ++i) {
+    settings.channels.add(i);
+  }
+
+  if (recorder.startRecording(settings)) {
+    recordButton.setButtonText("Stop");
+  } else {
+    recordButton.setToggleState(false, juce::dontSendNotification);
+
+    juce::AlertWindow::showMessageBoxAsync(
+        juce::AlertWindow::WarningIcon, "Recording Error",
+        recorder.getLastError(), "OK");
+  }
+}
+
+void MainComponent::saveHistory() {
+  if (audioEngine == nullptr || !audioEngine->isAudioInitialized())
+    return;
+
+  auto &capture = audioEngine->getRetroactiveCapture();
+  const auto stats = capture.getStats();
+
+  const auto file = recordingDirectory.getChildFile(
+      "mcam_history_" +
+      juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".wav");
+
+  LOG_INFO("Saving history - " + juce::String(stats.historySeconds, 1) +
+           " s held, compression ratio " +
+           juce::String(stats.compressionRatio, 2) + ", " +
+           juce::String(stats.memoryBytes / (1024 * 1024)) + " MB");
+
+  juce::Component::SafePointer<MainComponent> safeThis(this);
+
+  const bool started = capture.dumpToFile(
+      file, retroDumpSeconds, retroDumpSeconds, [safeThis, file](bool ok) {
+        juce::MessageManager::callAsync([safeThis, file, ok] {
+          if (safeThis == nullptr)
+            return;
+
+          safeThis->saveHistoryButton.setEnabled(true);
+
+          juce::AlertWindow::showMessageBoxAsync(
+              ok ? juce::AlertWindow::InfoIcon
+                 : juce::AlertWindow::WarningIcon,
+              "Save History",
+              ok ? "History saved to " + file.getFullPathName()
+                 : "Failed to save history to " + file.getFullPathName(),
+              "OK");
+        });
+      });
+
+  saveHistoryButton.setEnabled(!started);
+}
+
+void MainComponent::editDerivedChannel() {
+  if (audioEngine == nullptr)
+    return;
+
+  auto &processor = audioEngine->getBufferProcessor();
+
+  juce::StringArray items;
+  for (int i = 0; i < mcam::BufferProcessor::MAX_DERIVED_CHANNELS; ++i) {
+    const auto name = processor.getDerivedChannelName(i);
+    items.add(juce::String(i + 1) + (name.isNotEmpty() ? " - " + name : ""));
+  }
+
+  auto *window = new juce::AlertWindow(
+      "Derived Channel",
+      "Terms are input:gain pairs, e.g. 1:0.5,2:-0.5 for the side signal "
+      "of inputs 1 and 2. Clear the terms to remove the channel.",
+      juce::AlertWindow::NoIcon, this);
+
+  window->addComboBox("index", items, "Derived channel");
+  window->addTextEditor("name", {}, "Name");
+  window->addTextEditor("terms", {}, "Terms");
+  window->addButton("Set", 1, juce::KeyPress(juce::KeyPress::returnKey));
+  window->addButton("Cancel", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+
+  // Show the selected channel's current definition
+  auto *indexBox = window->getComboBoxComponent("index");
+  indexBox->onChange = [window, indexBox, &processor]() {
+    const int index = indexBox->getSelectedItemIndex();
+    window->getTextEditor("name")->setText(
+        processor.getDerivedChannelName(index));
+    window->getTextEditor("terms")->setText(
+        mcam::ChannelMatrixMixer::termsToString(
+            processor.getDerivedChannelTerms(index)));
+  };
+  indexBox->onChange();
+
+  juce::Component::SafePointer<MainComponent> safeThis(this);
+
+  window->enterModalState(
+      true,
+      juce::ModalCallbackFunction::create([safeThis, window](int result) {
+        if (result == 0 || safeThis == nullptr ||
+            safeThis->audioEngine == nullptr)
+          return;
+
+        const int index =
+            window->getComboBoxComponent("index")->getSelectedItemIndex();
+        auto name = window->getTextEditorContents("name").trim();
+        const auto text = window->getTextEditorContents("terms");
+        std::vector<mcam::ChannelMatrixMixer::Term> terms;
+
+        if (name.isEmpty())
+          name = "Derived " + juce::String(index + 1);
+
+        // Slots pick the change up from the processor
+        if (!mcam::ChannelMatrixMixer::termsFromString(text, terms) ||
+            !safeThis->audioEngine->getBufferProcessor().setDerivedChannel(
+                index, name, std::move(terms))) {
+          juce::AlertWindow::showMessageBoxAsync(
+              juce::AlertWindow::WarningIcon, "Derived Channel",
+              "Invalid terms: " + text, "OK");
+        }
+      }),
+      true);
+}
@@ -2,22 +2,38 @@
 
 #include "../Audio/AudioEngine.h"
 #include "../JuceHeader.h"
+#include "../Network/MetricsServer.h"
+#include "../Network/OSCServer.h"
+#include "../UI/Alarms/AlarmBannerComponent.h"
 #include "../UI/MonitoringSlotComponent.h"
+#include "AlarmLogger.h"
 #include "Logger.h"
+#include "ThreadTuning.h"
 
 //==============================================================================
 /**
  * MainComponent is the primary component for the application.
  * It houses the UI elements and manages the audio processing.
  */
-class MainComponent : public juce::Component {
+class MainComponent : public juce::Component,
+                      private mcam::DeviceSwitcher::Listener,
+                      private mcam::DeviceCatalog::Listener {
 public:
   //==============================================================================
-  MainComponent();
+  /**
+   * Constructor. The window is usable straight away; audio starts in the
+   * background.
+   * @param startTicks Application start time, for startup timing
+   * @param props Stored settings, applied before audio starts (optional)
+   */
+  explicit MainComponent(
+      juce::int64 startTicks = juce::Time::getHighResolutionTicks(),
+      juce::PropertiesFile *props = nullptr);
   ~MainComponent() override;
 
   //==============================================================================
   void paint(juce::Graphics &) override;
+  void paintOverChildren(juce::Graphics &) override;
   void resized() override;
 
   /**
@@ -45,24 +61,113 @@ private:
   void createLayout();
 
   /**
-   * Initialize the audio engine
+   * Creates the audio engine without opening a device
    */
   void initializeAudio();
 
+  /**
+   * Initialize the audio engine in the background
+   */
+  void startAudio();
+
+  /**
+   * Attaches the device UI once the audio engine has started
+   * @param success Result of the engine initialization
+   */
+  void audioInitialized(bool success);
+
+  /**
+   * Logs and exports the time from application start to a startup milestone
+   * @param milestone Milestone name, e.g. "first_frame"
+   */
+  void recordStartupMilestone(const juce::String &milestone);
+
+  /**
+   * Fills the device selector from the device catalog
+   */
+  void updateDeviceList();
+
+  /**
+   * Repopulates the device selector when devices appear or disappear
+   */
+  void deviceListChanged() override;
+
+  /**
+   * Shows the progress of a background device switch
+   * @param status Status reported by the device switcher
+   */
+  void deviceSwitchStatusChanged(
+      const mcam::DeviceSwitcher::Status &status) override;
+
   /**
    * Create the monitoring slots
    */
   void createMonitoringSlots();
 
+  /**
+   * Start the OSC control and telemetry endpoint and the metrics endpoint
+   * @param props Optional properties holding port settings
+   */
+  void initializeNetwork(juce::PropertiesFile *props = nullptr);
+
+  /**
+   * Loads the CPU, priority and memory locking settings of the engine
+   * threads and applies them to the message thread
+   * @param props Properties holding the thread settings
+   */
+  void applyThreadSettings(juce::PropertiesFile &props);
+
+  /**
+   * Starts or stops recording all input channels to the recording directory
+   * @param shouldRecord true to start, false to stop
+   */
+  void setRecording(bool shouldRecord);
+
+  /**
+   * Writes the last retroDumpSeconds of the in-memory history to the
+   * recording directory in the background
+   */
+  void saveHistory();
+
+  /**
+   * Asks for a derived channel's name and terms and defines it on the
+   * buffer processor; the slot selectors list it from then on
+   */
+  void editDerivedChannel();
+
   //==============================================================================
   // Audio engine
   std::unique_ptr<mcam::AudioEngine> audioEngine;
 
+  // Alarm log
+  std::unique_ptr<mcam::AlarmLogger> alarmLogger;
+
+  // OSC control and telemetry
+  std::unique_ptr<mcam::OSCServer> oscServer;
+
+  // Prometheus metrics endpoint
+  std::unique_ptr<mcam::MetricsServer> metricsServer;
+
+  // UI frame timing (paint() to paintOverChildren())
+  juce::int64 frameStartTicks = 0;
+  mcam::metrics::Histogram &frameTime;
+
+  // Startup timing
+  const juce::int64 appStartTicks;
+  bool firstFrameShown = false;
+  bool firstMeterShown = false;
+
   // UI Components
   juce::TextButton testButton;
+  juce::TextButton recordButton;
+  juce::TextButton saveHistoryButton;
+  juce::TextButton derivedButton;
+  juce::File recordingDirectory;
+  double retroDumpSeconds = 300.0;
   juce::ComboBox deviceSelector;
   juce::Label deviceLabel;
   juce::Label channelCountLabel;
+  mcam::AlarmBannerComponent alarmBanner;
 
   // Monitoring slots
   std::array<std::unique_ptr<mcam::MonitoringSlotComponent>, 4> monitoringSlots;
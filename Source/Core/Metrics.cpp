@@ -0,0 +1,261 @@
+#include "Metrics.h"
+
+namespace mcam {
+namespace metrics {
+
+int getThreadShardIndex() noexcept {
+  static std::atomic<int> nextShard{0};
+  thread_local const int shardIndex =
+      nextShard.fetch_add(1, std::memory_order_relaxed) % MAX_THREAD_SHARDS;
+  return shardIndex;
+}
+
+//==============================================================================
+juce::uint64 Counter::getValue() const noexcept {
+  juce::uint64 total = 0;
+
+  for (const auto &shard : shards)
+    total += shard.value.load(std::memory_order_relaxed);
+
+  return total;
+}
+
+//==============================================================================
+void Gauge::setProvider(std::function<double()> newProvider) {
+  const juce::ScopedLock sl(providerLock);
+  provider = std::move(newProvider);
+}
+
+double Gauge::getValue() const {
+  {
+    const juce::ScopedLock sl(providerLock);
+
+    if (provider)
+      return provider();
+  }
+
+  return value.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+Histogram::Histogram(std::initializer_list<double> upperBounds) {
+  jassert(upperBounds.size() <= (size_t)MAX_HISTOGRAM_BUCKETS);
+
+  for (auto bound : upperBounds) {
+    if (numBounds == MAX_HISTOGRAM_BUCKETS)
+      break;
+
+    jassert(numBounds == 0 || bound > bounds[(size_t)(numBounds - 1)]);
+    bounds[(size_t)numBounds++] = bound;
+  }
+}
+
+void Histogram::observe(double value) noexcept {
+  // Linear search: bucket counts are small and the bounds stay in cache
+  int bucket = 0;
+  while (bucket < numBounds && value > bounds[(size_t)bucket])
+    ++bucket;
+
+  auto &shard = shards[(size_t)getThreadShardIndex()];
+  shard.counts[(size_t)bucket].fetch_add(1, std::memory_order_relaxed);
+
+  // No fetch_add for doubles in C++17; the shard is normally owned by a
+  // single thread, so this loop does not spin in practice
+  auto sum = shard.sum.load(std::memory_order_relaxed);
+  while (!shard.sum.compare_exchange_weak(sum, sum + value,
+                                          std::memory_order_relaxed)) {
+  }
+}
+
+Histogram::Snapshot Histogram::getSnapshot() const {
+  Snapshot snapshot;
+  snapshot.upperBounds.assign(bounds.begin(), bounds.begin() + numBounds);
+  snapshot.cumulativeCounts.assign((size_t)numBounds + 1, 0);
+
+  for (const auto &shard : shards) {
+    for (int i = 0; i <= numBounds; ++i) {
+      snapshot.cumulativeCounts[(size_t)i] +=
+          shard.counts[(size_t)i].load(std::memory_order_relaxed);
+    }
+
+    snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+  }
+
+  // Convert per-bucket counts to cumulative counts
+  for (size_t i = 1; i < snapshot.cumulativeCounts.size(); ++i)
+    snapshot.cumulativeCounts[i] += snapshot.cumulativeCounts[i - 1];
+
+  snapshot.count = snapshot.cumulativeCounts.back();
+  return snapshot;
+}
+
+} // namespace metrics
+
+//==============================================================================
+MetricsRegistry &MetricsRegistry::getInstance() {
+  static MetricsRegistry instance;
+  return instance;
+}
+
+MetricsRegistry::MetricsRegistry() = default;
+
+MetricsRegistry::~MetricsRegistry() = default;
+
+MetricsRegistry::Entry *MetricsRegistry::findEntry(const juce::String &name,
+                                                   const juce::String &labels) {
+  for (auto &entry : entries) {
+    if (entry.name == name && entry.labels == labels)
+      return &entry;
+  }
+
+  return nullptr;
+}
+
+metrics::Counter &MetricsRegistry::counter(const juce::String &name,
+                                           const juce::String &help,
+                                           const juce::String &labels,
+                                           double scale) {
+  const juce::ScopedLock sl(registryLock);
+
+  if (auto *existing = findEntry(name, labels)) {
+    jassert(existing->type == Type::Counter);
+    return *existing->counter;
+  }
+
+  counters.emplace_back();
+
+  Entry entry{name, help, labels, Type::Counter, scale};
+  entry.counter = &counters.back();
+  entries.push_back(entry);
+
+  return counters.back();
+}
+
+metrics::Gauge &MetricsRegistry::gauge(const juce::String &name,
+                                       const juce::String &help,
+                                       const juce::String &labels) {
+  const juce::ScopedLock sl(registryLock);
+
+  if (auto *existing = findEntry(name, labels)) {
+    jassert(existing->type == Type::Gauge);
+    return *existing->gauge;
+  }
+
+  gauges.emplace_back();
+
+  Entry entry{name, help, labels, Type::Gauge};
+  entry.gauge = &gauges.back();
+  entries.push_back(entry);
+
+  return gauges.back();
+}
+
+metrics::Histogram &
+MetricsRegistry::histogram(const juce::String &name, const juce::String &help,
+                           std::initializer_list<double> upperBounds,
+                           const juce::String &labels) {
+  const juce::ScopedLock sl(registryLock);
+
+  if (auto *existing = findEntry(name, labels)) {
+    jassert(existing->type == Type::Histogram);
+    return *existing->histogram;
+  }
+
+  histograms.push_back(std::make_unique<metrics::Histogram>(upperBounds));
+
+  Entry entry{name, help, labels, Type::Histogram};
+  entry.histogram = histograms.back().get();
+  entries.push_back(entry);
+
+  return *histograms.back();
+}
+
+juce::String MetricsRegistry::renderPrometheusText() const {
+  const juce::ScopedLock sl(registryLock);
+
+  auto formatValue = [](double value) {
+    if (std::isinf(value))
+      return juce::String(value > 0 ? "+Inf" : "-Inf");
+
+    return juce::String(value, 9, false);
+  };
+
+  auto withLabels = [](const juce::String &labels,
+                       const juce::String &extra = {}) -> juce::String {
+    if (labels.isEmpty() && extra.isEmpty())
+      return {};
+
+    if (labels.isEmpty() || extra.isEmpty())
+      return "{" + labels + extra + "}";
+
+    return "{" + labels + "," + extra + "}";
+  };
+
+  juce::MemoryOutputStream out;
+
+  // Families must be contiguous, so group entries by name in first-seen order
+  juce::StringArray familyNames;
+  for (const auto &entry : entries)
+    familyNames.addIfNotAlreadyThere(entry.name);
+
+  for (const auto &familyName : familyNames) {
+    bool described = false;
+
+    for (const auto &entry : entries) {
+      if (entry.name != familyName)
+        continue;
+
+      if (!described) {
+        const char *typeName = entry.type == Type::Counter ? "counter"
+                               : entry.type == Type::Gauge ? "gauge"
+                                                           : "histogram";
+
+        out << "# HELP " << entry.name << " " << entry.help << "\n";
+        out << "# TYPE " << entry.name << " " << typeName << "\n";
+        described = true;
+      }
+
+      switch (entry.type) {
+      case Type::Counter:
+        out << entry.name << withLabels(entry.labels) << " "
+            << formatValue((double)entry.counter->getValue() * entry.scale)
+            << "\n";
+        break;
+
+      case Type::Gauge:
+        out << entry.name << withLabels(entry.labels) << " "
+            << formatValue(entry.gauge->getValue()) << "\n";
+        break;
+
+      case Type::Histogram: {
+        const auto snapshot = entry.histogram->getSnapshot();
+
+        for (size_t i = 0; i < snapshot.cumulativeCounts.size(); ++i) {
+          const auto bound = i < snapshot.upperBounds.size()
+                                 ? formatValue(snapshot.upperBounds[i])
+                                 : juce::String("+Inf");
+
+          out << entry.name << "_bucket"
+              << withLabels(entry.labels, "le=\"" + bound + "\"") << " "
+              << juce::String((juce::int64)snapshot.cumulativeCounts[i])
+              << "\n";
+        }
+
+        out << entry.name << "_sum" << withLabels(entry.labels) << " "
+            << formatValue(snapshot.sum) << "\n";
+        out << entry.name << "_count" << withLabels(entry.labels) << " "
+            << juce::String((juce::int64)snapshot.count) << "\n";
+        break;
+      }
+      }
+    }
+  }
+
+  return out.toString();
+}
+
+double MetricsRegistry::ticksToSeconds(juce::int64 ticks) {
+  return juce::Time::highResolutionTicksToSeconds(ticks);
+}
+
+} // namespace mcam
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+
+namespace mcam {
+namespace metrics {
+
+/** Number of per-thread shards kept by every counter and histogram */
+static constexpr int MAX_THREAD_SHARDS = 32;
+
+/** Assumed cache line size used to pad shards against false sharing */
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+/** Maximum number of finite buckets in a histogram */
+static constexpr int MAX_HISTOGRAM_BUCKETS = 16;
+
+/**
+ * Returns the calling thread's shard index. Assigned round-robin the first
+ * time a thread touches any metric, then cached in a thread_local.
+ */
+int getThreadShardIndex() noexcept;
+
+/**
+ * Monotonic counter. Each thread increments its own cache-line-padded shard,
+ * so hot-path increments never contend; reads sum all shards.
+ */
+class Counter {
+public:
+  Counter() = default;
+
+  /** Adds to the counter (wait-free, safe on the audio thread) */
+  void add(juce::uint64 amount = 1) noexcept {
+    shards[(size_t)getThreadShardIndex()].value.fetch_add(
+        amount, std::memory_order_relaxed);
+  }
+
+  /** @return Sum over all shards */
+  juce::uint64 getValue() const noexcept;
+
+private:
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    std::atomic<juce::uint64> value{0};
+  };
+
+  std::array<Shard, MAX_THREAD_SHARDS> shards;
+
+  JUCE_DECLARE_NON_COPYABLE(Counter)
+};
+
+/**
+ * Gauge holding the last value set, or computed on demand by a provider
+ * function at scrape time (for values owned by other components).
+ */
+class Gauge {
+public:
+  Gauge() = default;
+
+  /** Sets the current value (wait-free) */
+  void set(double newValue) noexcept {
+    value.store(newValue, std::memory_order_relaxed);
+  }
+
+  /**
+   * Makes the gauge report the result of a function instead of the stored
+   * value. The provider is called on the scraping thread.
+   */
+  void setProvider(std::function<double()> newProvider);
+
+  /** @return Current value */
+  double getValue() const;
+
+private:
+  std::atomic<double> value{0.0};
+  std::function<double()> provider;
+  mutable juce::CriticalSection providerLock;
+
+  JUCE_DECLARE_NON_COPYABLE(Gauge)
+};
+
+/**
+ * Fixed-bucket histogram with per-thread, cache-line-padded bucket counts.
+ * Bucket bounds are inclusive upper bounds, as in Prometheus.
+ */
+class Histogram {
+public:
+  /** @param upperBounds Ascending bucket bounds (at most 16) */
+  explicit Histogram(std::initializer_list<double> upperBounds);
+
+  /** Records a value (wait-free, safe on the audio thread) */
+  void observe(double value) noexcept;
+
+  /** Aggregated histogram state */
+  struct Snapshot {
+    std::vector<double> upperBounds;
+    std::vector<juce::uint64> cumulativeCounts; // one per bound, plus +Inf
+    double sum = 0.0;
+    juce::uint64 count = 0;
+  };
+
+  /** @return Counts summed over all shards */
+  Snapshot getSnapshot() const;
+
+private:
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    std::array<std::atomic<juce::uint64>, MAX_HISTOGRAM_BUCKETS + 1> counts{};
+    std::atomic<double> sum{0.0};
+  };
+
+  std::array<double, MAX_HISTOGRAM_BUCKETS> bounds{};
+  int numBounds = 0;
+  std::array<Shard, MAX_THREAD_SHARDS> shards;
+
+  JUCE_DECLARE_NON_COPYABLE(Histogram)
+};
+
+} // namespace metrics
+
+/**
+ * MetricsRegistry owns all named metrics and renders them in the Prometheus
+ * text exposition format. Registration takes a lock and should happen at
+ * setup time; the returned references stay valid for the process lifetime
+ * and can be updated from any thread without locking.
+ */
+class MetricsRegistry {
+public:
+  /** Get the single instance of the registry */
+  static MetricsRegistry &getInstance();
+
+  /**
+   * Gets or creates a counter
+   * @param name Metric family name, e.g. "mcam_audio_callbacks_total"
+   * @param help One-line description
+   * @param labels Label set without braces, e.g. "slot=\"1\"" (optional)
+   * @param scale Factor applied to the raw count when rendering, e.g. to
+   *              report tick counters in seconds
+   */
+  metrics::Counter &counter(const juce::String &name, const juce::String &help,
+                            const juce::String &labels = {},
+                            double scale = 1.0);
+
+  /** Gets or creates a gauge (see counter() for parameters) */
+  metrics::Gauge &gauge(const juce::String &name, const juce::String &help,
+                        const juce::String &labels = {});
+
+  /**
+   * Gets or creates a histogram
+   * @param upperBounds Bucket bounds; ignored if the histogram exists
+   */
+  metrics::Histogram &histogram(const juce::String &name,
+                                const juce::String &help,
+                                std::initializer_list<double> upperBounds,
+                                const juce::String &labels = {});
+
+  /** @return All metrics in Prometheus text format (version 0.0.4) */
+  juce::String renderPrometheusText() const;
+
+  /** Converts high resolution ticks to seconds (for timing metrics) */
+  static double ticksToSeconds(juce::int64 ticks);
+
+private:
+  MetricsRegistry();
+  ~MetricsRegistry();
+
+  enum class Type { Counter, Gauge, Histogram };
+
+  struct Entry {
+    juce::String name;
+    juce::String help;
+    juce::String labels;
+    Type type;
+    double scale = 1.0;
+    metrics::Counter *counter = nullptr;
+    metrics::Gauge *gauge = nullptr;
+    metrics::Histogram *histogram = nullptr;
+  };
+
+  Entry *findEntry(const juce::String &name, const juce::String &labels);
+
+  // Stable storage: deques never move existing elements
+  std::deque<metrics::Counter> counters;
+  std::deque<metrics::Gauge> gauges;
+  std::deque<std::unique_ptr<metrics::Histogram>> histograms;
+  std::vector<Entry> entries;
+
+  mutable juce::CriticalSection registryLock;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetricsRegistry)
+};
+
+} // namespace mcam
@@ -0,0 +1,399 @@
+// The interposers below replace functions that fortified headers define
+// inline, so this file is built without fortification
+#undef _FORTIFY_SOURCE
+
+#include "RealtimeGuard.h"
+#include "Logger.h"
+
+#if MCAM_REALTIME_CHECKS && defined(__GLIBC__)
+#include <cerrno>
+#include <cstdarg>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace mcam {
+
+namespace {
+// Realtime spans the thread is in, and whether it is recording a violation
+// (the recording itself allocates, locks and logs)
+thread_local int realtimeDepth = 0;
+thread_local int reportingDepth = 0;
+
+bool isChecking() noexcept { return realtimeDepth > 0 && reportingDepth == 0; }
+
+// The allow-list: lock addresses, nullptr for a free entry, and their
+// names. The interposer reads it without locking; changes are serialised
+// by a spin lock, which is not a pthread mutex.
+std::array<std::atomic<const void *>, RealtimeGuard::MAX_ALLOWED_LOCKS>
+    allowedLocks{};
+std::array<std::atomic<const char *>, RealtimeGuard::MAX_ALLOWED_LOCKS>
+    allowedLockNames{};
+juce::SpinLock allowListLock;
+
+/** @return The name of an allowed lock, or nullptr if it is not allowed */
+const char *findAllowedLock(const void *lock) noexcept {
+  for (size_t i = 0; i < allowedLocks.size(); ++i)
+    if (allowedLocks[i].load(std::memory_order_acquire) == lock)
+      return allowedLockNames[i].load(std::memory_order_relaxed);
+
+  return nullptr;
+}
+} // namespace
+
+RealtimeGuard::ScopedRealtime::ScopedRealtime() noexcept {
+  if (isEnabled())
+    ++realtimeDepth;
+}
+
+RealtimeGuard::ScopedRealtime::~ScopedRealtime() noexcept {
+  if (isEnabled())
+    --realtimeDepth;
+}
+
+const char *RealtimeGuard::getKindName(Kind kind) {
+  switch (kind) {
+  case Kind::allocation:
+    return "allocation";
+  case Kind::deallocation:
+    return "deallocation";
+  case Kind::lock:
+    return "lock";
+  case Kind::lockWait:
+    return "lock_wait";
+  case Kind::blockingCall:
+    return "blocking_call";
+  }
+
+  return "unknown";
+}
+
+RealtimeGuard &RealtimeGuard::getInstance() {
+  static RealtimeGuard instance;
+  return instance;
+}
+
+bool RealtimeGuard::isRealtimeThread() noexcept { return realtimeDepth > 0; }
+
+bool RealtimeGuard::allowLock(const juce::CriticalSection &lock,
+                              const char *name) noexcept {
+  const juce::SpinLock::ScopedLockType sl(allowListLock);
+
+  for (size_t i = 0; i < allowedLocks.size(); ++i) {
+    if (allowedLocks[i].load(std::memory_order_relaxed) == nullptr) {
+      // The name is in place before the entry can be found
+      allowedLockNames[i].store(name, std::memory_order_relaxed);
+      allowedLocks[i].store(&lock, std::memory_order_release);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void RealtimeGuard::disallowLock(const juce::CriticalSection &lock) noexcept {
+  const juce::SpinLock::ScopedLockType sl(allowListLock);
+
+  for (auto &entry : allowedLocks)
+    if (entry.load(std::memory_order_relaxed) == &lock)
+      entry.store(nullptr, std::memory_order_relaxed);
+}
+
+void RealtimeGuard::check(Kind kind, const char *function) noexcept {
+  if (!isChecking())
+    return;
+
+  ++reportingDepth;
+  getInstance().record(kind, function);
+  --reportingDepth;
+}
+
+void RealtimeGuard::record(Kind kind, const char *function) {
+  if (numViolations.fetch_add(1, std::memory_order_relaxed) >= MAX_REPORTS)
+    return;
+
+  Violation violation{kind, function, juce::SystemStats::getStackBacktrace()};
+
+  LOG_ERROR(juce::String("Realtime violation: ") + getKindName(kind) +
+            " in " + function + "\n" + violation.stackTrace);
+
+  const juce::ScopedLock sl(violationLock);
+  violations.push_back(std::move(violation));
+}
+
+int RealtimeGuard::getNumViolations() const {
+  return numViolations.load(std::memory_order_relaxed);
+}
+
+std::vector<RealtimeGuard::Violation> RealtimeGuard::getViolations() const {
+  const juce::ScopedLock sl(violationLock);
+  return violations;
+}
+
+void RealtimeGuard::clear() {
+  const juce::ScopedLock sl(violationLock);
+  violations.clear();
+  numViolations.store(0, std::memory_order_relaxed);
+}
+
+} // namespace mcam
+
+#if MCAM_REALTIME_CHECKS
+using Kind = mcam::RealtimeGuard::Kind;
+
+#if defined(__GLIBC__)
+//==============================================================================
+// glibc: the allocator is reached through its internal entry points, and
+// every other interposed call through the next definition in link order,
+// looked up once at startup
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *pointer);
+}
+
+namespace {
+template <typename Function>
+Function findNext(std::atomic<Function> &cache, const char *name) noexcept {
+  auto function = cache.load(std::memory_order_acquire);
+
+  if (function == nullptr) {
+    ++mcam::reportingDepth;
+    function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+    --mcam::reportingDepth;
+    cache.store(function, std::memory_order_release);
+  }
+
+  return function;
+}
+
+std::atomic<int (*)(pthread_mutex_t *)> nextMutexLock{nullptr};
+std::atomic<ssize_t (*)(int, void *, size_t)> nextRead{nullptr};
+std::atomic<ssize_t (*)(int, const void *, size_t)> nextWrite{nullptr};
+std::atomic<int (*)(const char *, int, ...)> nextOpen{nullptr};
+std::atomic<decltype(&fsync)> nextFsync{nullptr};
+std::atomic<decltype(&usleep)> nextUsleep{nullptr};
+std::atomic<decltype(&nanosleep)> nextNanosleep{nullptr};
+std::atomic<decltype(&clock_nanosleep)> nextClockNanosleep{nullptr};
+std::atomic<int (*)(struct pollfd *, nfds_t, int)> nextPoll{nullptr};
+std::atomic<decltype(&select)> nextSelect{nullptr};
+std::atomic<decltype(&sendto)> nextSendto{nullptr};
+std::atomic<decltype(&recvfrom)> nextRecvfrom{nullptr};
+
+// Resolved before any thread can be realtime, so the lookups (which
+// allocate) never happen on the audio thread
+const bool nextFunctionsFound = [] {
+  findNext(nextMutexLock, "pthread_mutex_lock");
+  findNext(nextRead, "read");
+  findNext(nextWrite, "write");
+  findNext(nextOpen, "open");
+  findNext(nextFsync, "fsync");
+  findNext(nextUsleep, "usleep");
+  findNext(nextNanosleep, "nanosleep");
+  findNext(nextClockNanosleep, "clock_nanosleep");
+  findNext(nextPoll, "poll");
+  findNext(nextSelect, "select");
+  findNext(nextSendto, "sendto");
+  findNext(nextRecvfrom, "recvfrom");
+  return true;
+}();
+} // namespace
+
+extern "C" {
+void *malloc(size_t size) noexcept {
+  mcam::RealtimeGuard::check(Kind::allocation, "malloc");
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept {
+  mcam::RealtimeGuard::check(Kind::allocation, "calloc");
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size) noexcept {
+  mcam::RealtimeGuard::check(Kind::allocation, "realloc");
+  return __libc_realloc(pointer, size);
+}
+
+void *memalign(size_t alignment, size_t size) noexcept {
+  mcam::RealtimeGuard::check(Kind::allocation, "memalign");
+  return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept {
+  mcam::RealtimeGuard::check(Kind::allocation, "aligned_alloc");
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **pointer, size_t alignment, size_t size) noexcept {
+  mcam::RealtimeGuard::check(Kind::allocation, "posix_memalign");
+
+  if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+
+  *pointer = __libc_memalign(alignment, size);
+  return *pointer != nullptr ? 0 : ENOMEM;
+}
+
+void free(void *pointer) noexcept {
+  if (pointer != nullptr)
+    mcam::RealtimeGuard::check(Kind::deallocation, "free");
+
+  __libc_free(pointer);
+}
+
+// Any lock is reported, except an allowed one that was free. A
+// CriticalSection holds nothing but its mutex, so their addresses match.
+static_assert(sizeof(juce::CriticalSection) == sizeof(pthread_mutex_t),
+              "allowed CriticalSections are found by their mutex");
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) noexcept {
+  if (mcam::isChecking()) {
+    if (const char *allowed = mcam::findAllowedLock(mutex)) {
+      const int result = pthread_mutex_trylock(mutex);
+
+      if (result != EBUSY)
+        return result;
+
+      mcam::RealtimeGuard::check(Kind::lockWait, allowed);
+    } else {
+      mcam::RealtimeGuard::check(Kind::lock, "pthread_mutex_lock");
+    }
+  }
+
+  return findNext(nextMutexLock, "pthread_mutex_lock")(mutex);
+}
+
+ssize_t read(int fd, void *buffer, size_t size) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "read");
+  return findNext(nextRead, "read")(fd, buffer, size);
+}
+
+ssize_t write(int fd, const void *buffer, size_t size) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "write");
+  return findNext(nextWrite, "write")(fd, buffer, size);
+}
+
+int open(const char *path, int flags, ...) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "open");
+
+  mode_t mode = 0;
+
+  if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE) {
+    va_list arguments;
+    va_start(arguments, flags);
+    mode = (mode_t)va_arg(arguments, int);
+    va_end(arguments);
+  }
+
+  return findNext(nextOpen, "open")(path, flags, mode);
+}
+
+int fsync(int fd) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "fsync");
+  return findNext(nextFsync, "fsync")(fd);
+}
+
+int usleep(useconds_t microseconds) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "usleep");
+  return findNext(nextUsleep, "usleep")(microseconds);
+}
+
+int nanosleep(const struct timespec *duration, struct timespec *remaining) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "nanosleep");
+  return findNext(nextNanosleep, "nanosleep")(duration, remaining);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const struct timespec *time,
+                    struct timespec *remaining) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "clock_nanosleep");
+  return findNext(nextClockNanosleep, "clock_nanosleep")(clock, flags, time,
+                                                         remaining);
+}
+
+int poll(struct pollfd *fds, nfds_t numFds, int timeout) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "poll");
+  return findNext(nextPoll, "poll")(fds, numFds, timeout);
+}
+
+int select(int numFds, fd_set *readFds, fd_set *writeFds, fd_set *exceptFds,
+           struct timeval *timeout) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "select");
+  return findNext(nextSelect, "select")(numFds, readFds, writeFds, exceptFds,
+                                        timeout);
+}
+
+ssize_t sendto(int fd, const void *buffer, size_t size, int flags,
+               const struct sockaddr *address, socklen_t addressLength) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "sendto");
+  return findNext(nextSendto, "sendto")(fd, buffer, size, flags, address,
+                                        addressLength);
+}
+
+ssize_t recvfrom(int fd, void *buffer, size_t size, int flags,
+                 struct sockaddr *address, socklen_t *addressLength) {
+  mcam::RealtimeGuard::check(Kind::blockingCall, "recvfrom");
+  return findNext(nextRecvfrom, "recvfrom")(fd, buffer, size, flags, address,
+                                            addressLength);
+}
+}
+
+#else
+//==============================================================================
+// Elsewhere only C++ allocations are checked
+
+void *operator new(std::size_t size) {
+  mcam::RealtimeGuard::check(Kind::allocation, "operator new");
+
+  if (auto *pointer = std::malloc(size != 0 ? size : 1))
+    return pointer;
+
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  mcam::RealtimeGuard::check(Kind::allocation, "operator new");
+  return std::malloc(size != 0 ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+  return ::operator new(size, tag);
+}
+
+void operator delete(void *pointer) noexcept {
+  if (pointer != nullptr)
+    mcam::RealtimeGuard::check(Kind::deallocation, "operator delete");
+
+  std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept { ::operator delete(pointer); }
+
+void operator delete(void *pointer, std::size_t) noexcept {
+  ::operator delete(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept {
+  ::operator delete(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept {
+  ::operator delete(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept {
+  ::operator delete(pointer);
+}
+#endif
+#endif
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "../JuceHeader.h"
+
+#ifndef MCAM_REALTIME_CHECKS
+#define MCAM_REALTIME_CHECKS 0
+#endif
+
+namespace mcam {
+/**
+ * RealtimeGuard reports calls that are not realtime-safe when made from the
+ * audio thread: heap allocations and frees, mutex locks, and blocking
+ * system calls (file and socket I/O, polling and sleeping).
+ *
+ * Code marks the spans that must be realtime-safe with a ScopedRealtime;
+ * the device manager and AudioCallback mark their audio callbacks. When
+ * built with MCAM_REALTIME_CHECKS, the C allocator, pthread_mutex_lock and
+ * the blocking calls are interposed, and every such call inside a marked
+ * span is counted as a violation. The first MAX_REPORTS are kept and
+ * logged with a stack trace. Without MCAM_REALTIME_CHECKS nothing is
+ * interposed and marking a span does nothing.
+ *
+ * Every mutex taken in a span is a violation, whether or not it was free,
+ * unless its owner has put it on the allow-list with allowLock(). An
+ * allowed lock is only reported when it makes the audio thread wait. The
+ * list is kept short on purpose; today it holds BufferProcessor's
+ * bufferLock, which processAudio() holds against configuration changes.
+ *
+ * Interposition needs glibc. On other platforms only C++ allocations
+ * (operator new and delete) are checked. Don't combine it with sanitizers,
+ * which interpose the same functions.
+ */
+class RealtimeGuard {
+public:
+  /** What a violation did */
+  enum class Kind { allocation, deallocation, lock, lockWait, blockingCall };
+
+  /** Violations kept and logged with their stack traces */
+  static constexpr int MAX_REPORTS = 32;
+
+  /** Locks that can be on the allow-list at once */
+  static constexpr int MAX_ALLOWED_LOCKS = 16;
+
+  /** One unsafe call made in a realtime span */
+  struct Violation {
+    Kind kind = Kind::allocation;
+
+    /** The call, e.g. "malloc", or the allowed lock that was waited on */
+    juce::String function;
+
+    /** Stack of the calling thread at the call */
+    juce::String stackTrace;
+  };
+
+  /** Marks the calling thread as realtime while in scope; nestable */
+  class ScopedRealtime {
+  public:
+    ScopedRealtime() noexcept;
+    ~ScopedRealtime() noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedRealtime)
+  };
+
+  /** @return true if this build intercepts unsafe calls */
+  static constexpr bool isEnabled() { return MCAM_REALTIME_CHECKS != 0; }
+
+  /**
+   * @param kind Kind of violation
+   * @return Name for logs, e.g. "lock_wait"
+   */
+  static const char *getKindName(Kind kind);
+
+  /** Get the single instance of the guard */
+  static RealtimeGuard &getInstance();
+
+  /** @return true if the calling thread is in a realtime span */
+  static bool isRealtimeThread() noexcept;
+
+  /**
+   * Puts a lock on the allow-list: taking it in a realtime span is only
+   * reported if the lock was held and the audio thread had to wait. Remove
+   * it with disallowLock() before it is destroyed.
+   * @param lock The lock; a juce::CriticalSection is its pthread mutex
+   * @param name Name reported when the lock is waited on; must outlive the
+   * entry, e.g. a string literal
+   * @return false if the list is full
+   */
+  static bool allowLock(const juce::CriticalSection &lock,
+                        const char *name) noexcept;
+
+  /**
+   * Takes a lock off the allow-list
+   * @param lock A lock passed to allowLock()
+   */
+  static void disallowLock(const juce::CriticalSection &lock) noexcept;
+
+  /**
+   * Records a violation if the calling thread is in a realtime span. Called
+   * by the interposed functions; unsafe calls made while recording are not
+   * reported again.
+   * @param kind Kind of violation
+   * @param function Name of the call
+   */
+  static void check(Kind kind, const char *function) noexcept;
+
+  /** @return Violations since the last clear(), including unkept ones */
+  int getNumViolations() const;
+
+  /** @return The first violations since the last clear() */
+  std::vector<Violation> getViolations() const;
+
+  /** Forgets all violations */
+  void clear();
+
+private:
+  RealtimeGuard() = default;
+
+  void record(Kind kind, const char *function);
+
+  std::atomic<int> numViolations{0};
+  std::vector<Violation> violations;
+  mutable juce::CriticalSection violationLock;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RealtimeGuard)
+};
+
+} // namespace mcam
@@ -0,0 +1,398 @@
+#include "ThreadTuning.h"
+#include "Logger.h"
+
+#if JUCE_LINUX
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mcam {
+
+namespace {
+// Bits per word of the shared CPU sets
+constexpr int CPU_WORD_BITS = 64;
+constexpr int NUM_CPU_WORDS = ThreadTuning::MAX_CPUS / CPU_WORD_BITS;
+
+// CPUs a gauge can show exactly (the mantissa of a double)
+constexpr int MAX_GAUGE_CPUS = 53;
+
+// Stack touched by the audio thread when memory is locked, and the page
+// size it is touched at
+constexpr size_t STACK_PREFAULT_BYTES = 64 * 1024;
+constexpr size_t PAGE_BYTES = 4096;
+
+// Settings generation each thread applied last, per class
+thread_local std::array<juce::uint32, ThreadTuning::NUM_THREAD_CLASSES>
+    appliedGenerations{};
+
+juce::BigInteger toBigInteger(
+    const std::array<std::atomic<juce::uint64>, NUM_CPU_WORDS> &words) {
+  juce::BigInteger cpus;
+
+  for (int word = 0; word < NUM_CPU_WORDS; ++word) {
+    const auto bits = words[(size_t)word].load(std::memory_order_relaxed);
+
+    for (int bit = 0; bit < CPU_WORD_BITS; ++bit)
+      if (((bits >> bit) & 1) != 0)
+        cpus.setBit(word * CPU_WORD_BITS + bit);
+  }
+
+  return cpus;
+}
+
+#if JUCE_LINUX
+// Kept out of line so the array is really on this thread's stack
+__attribute__((noinline)) void prefaultStack() {
+  volatile char stack[STACK_PREFAULT_BYTES];
+
+  for (size_t i = 0; i < STACK_PREFAULT_BYTES; i += PAGE_BYTES)
+    stack[i] = 0;
+
+  juce::ignoreUnused(stack);
+}
+
+/** @return Locked memory of the process in bytes, or -1 if unknown */
+double readLockedBytes() {
+  const auto status =
+      juce::File("/proc/self/status").loadFileAsString().fromFirstOccurrenceOf(
+          "VmLck:", false, false);
+
+  if (status.isEmpty())
+    return -1.0;
+
+  return status.upToFirstOccurrenceOf("\n", false, false).getDoubleValue() *
+         1024.0;
+}
+#endif
+} // namespace
+
+const char *ThreadTuning::getClassName(ThreadClass threadClass) {
+  switch (threadClass) {
+  case ThreadClass::audio:
+    return "audio";
+  case ThreadClass::analysis:
+    return "analysis";
+  case ThreadClass::disk:
+    return "disk";
+  case ThreadClass::network:
+    return "network";
+  case ThreadClass::ui:
+    return "ui";
+  case ThreadClass::background:
+    return "background";
+  }
+
+  return "unknown";
+}
+
+bool ThreadTuning::parseCpuList(const juce::String &text,
+                                juce::BigInteger &cpus) {
+  cpus.clear();
+
+  for (auto item : juce::StringArray::fromTokens(text, ",", "")) {
+    item = item.trim();
+
+    if (item.isEmpty())
+      continue;
+
+    const auto first = item.upToFirstOccurrenceOf("-", false, false).trim();
+    const auto last = item.contains("-")
+                          ? item.fromFirstOccurrenceOf("-", false, false).trim()
+                          : first;
+
+    if (!first.containsOnly("0123456789") || first.isEmpty() ||
+        !last.containsOnly("0123456789") || last.isEmpty())
+      return false;
+
+    const int start = first.getIntValue();
+    const int end = last.getIntValue();
+
+    if (end < start || end >= MAX_CPUS)
+      return false;
+
+    cpus.setRange(start, end - start + 1, true);
+  }
+
+  return true;
+}
+
+ThreadTuning &ThreadTuning::getInstance() {
+  static ThreadTuning instance;
+  return instance;
+}
+
+ThreadTuning::ThreadTuning() {
+  auto &registry = MetricsRegistry::getInstance();
+
+  for (int i = 0; i < NUM_THREAD_CLASSES; ++i) {
+    auto &result = effective[(size_t)i];
+    const juce::String labels =
+        juce::String("thread=\"") + getClassName((ThreadClass)i) + "\"";
+
+    result.cpuMask = &registry.gauge(
+        "mcam_thread_cpu_mask",
+        "CPUs the threads of a class may run on, one bit per CPU (0-52)",
+        labels);
+    result.fifoPriorityGauge = &registry.gauge(
+        "mcam_thread_fifo_priority",
+        "SCHED_FIFO priority of the threads of a class, 0 if not realtime",
+        labels);
+    result.niceGauge = &registry.gauge(
+        "mcam_thread_nice", "Nice value of the threads of a class", labels);
+    result.failures = &registry.counter(
+        "mcam_thread_tuning_failures_total",
+        "Thread settings the system refused to apply", labels);
+  }
+
+  registry.gauge("mcam_memory_locked", "1 if process memory is locked in RAM")
+      .setProvider([this] { return isMemoryLocked() ? 1.0 : 0.0; });
+
+#if JUCE_LINUX
+  registry
+      .gauge("mcam_memory_locked_bytes", "Process memory locked in RAM")
+      .setProvider([] { return readLockedBytes(); });
+#endif
+}
+
+bool ThreadTuning::setSettings(ThreadClass threadClass,
+                               const Settings &newSettings) {
+  if (newSettings.cpus.getHighestBit() >= MAX_CPUS ||
+      newSettings.fifoPriority < 0 || newSettings.fifoPriority > 99 ||
+      newSettings.niceValue < -20 || newSettings.niceValue > 19)
+    return false;
+
+  auto &shared = settings[(size_t)threadClass];
+
+  for (int word = 0; word < NUM_CPU_WORDS; ++word) {
+    shared.cpuWords[(size_t)word].store(
+        (juce::uint64)newSettings.cpus
+                .getBitRangeAsInt(word * CPU_WORD_BITS, 32) |
+            ((juce::uint64)newSettings.cpus.getBitRangeAsInt(
+                 word * CPU_WORD_BITS + 32, 32)
+             << 32),
+        std::memory_order_relaxed);
+  }
+
+  shared.fifoPriority.store(newSettings.fifoPriority,
+                            std::memory_order_relaxed);
+  shared.niceValue.store(newSettings.niceValue, std::memory_order_relaxed);
+
+  shared.generation.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+ThreadTuning::Settings
+ThreadTuning::getSettings(ThreadClass threadClass) const {
+  const auto &shared = settings[(size_t)threadClass];
+
+  Settings result;
+  result.cpus = toBigInteger(shared.cpuWords);
+  result.fifoPriority = shared.fifoPriority.load(std::memory_order_relaxed);
+  result.niceValue = shared.niceValue.load(std::memory_order_relaxed);
+  return result;
+}
+
+bool ThreadTuning::applyToCurrentThread(ThreadClass threadClass) {
+  const auto index = (size_t)threadClass;
+  const auto current =
+      settings[index].generation.load(std::memory_order_acquire);
+
+  if (appliedGenerations[index] == current)
+    return !effective[index].failed.load(std::memory_order_relaxed);
+
+  appliedGenerations[index] = current;
+
+  const bool prefault = threadClass == ThreadClass::audio &&
+                        memoryLocking.load(std::memory_order_relaxed);
+
+  if (apply(settings[index], effective[index], prefault))
+    return true;
+
+  effective[index].failures->add();
+
+  // The log is written synchronously, to file and console, so the audio
+  // thread only counts its failures
+  if (threadClass != ThreadClass::audio)
+    LOG_WARNING(juce::String("Settings of the ") + getClassName(threadClass) +
+                " threads could not be applied in full");
+
+  return false;
+}
+
+bool ThreadTuning::apply(const SharedSettings &shared,
+                         SharedEffective &result, bool prefault) {
+  const int fifoPriority = shared.fifoPriority.load(std::memory_order_relaxed);
+  const int niceValue = shared.niceValue.load(std::memory_order_relaxed);
+  bool success = true;
+
+#if JUCE_LINUX
+  const auto thread = pthread_self();
+  const auto threadId = (id_t)syscall(SYS_gettid);
+
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  bool anyCpu = false;
+
+  for (int word = 0; word < NUM_CPU_WORDS; ++word) {
+    const auto bits = shared.cpuWords[(size_t)word].load(
+        std::memory_order_relaxed);
+
+    for (int bit = 0; bit < CPU_WORD_BITS; ++bit) {
+      if (((bits >> bit) & 1) != 0) {
+        CPU_SET(word * CPU_WORD_BITS + bit, &cpuSet);
+        anyCpu = true;
+      }
+    }
+  }
+
+  if (anyCpu && pthread_setaffinity_np(thread, sizeof(cpuSet), &cpuSet) != 0)
+    success = false;
+
+  if (fifoPriority > 0) {
+    sched_param param{};
+    param.sched_priority = fifoPriority;
+    success = pthread_setschedparam(thread, SCHED_FIFO, &param) == 0 &&
+              success;
+  } else if (niceValue != 0) {
+    // Nice values only apply under the normal scheduler
+    int policy = SCHED_OTHER;
+    sched_param param{};
+
+    if (pthread_getschedparam(thread, &policy, &param) == 0 &&
+        policy != SCHED_OTHER) {
+      param.sched_priority = 0;
+      success = pthread_setschedparam(thread, SCHED_OTHER, &param) == 0 &&
+                success;
+    }
+
+    success = setpriority(PRIO_PROCESS, threadId, niceValue) == 0 && success;
+  }
+
+  if (prefault)
+    prefaultStack();
+
+  // Report what the system actually uses
+  CPU_ZERO(&cpuSet);
+  pthread_getaffinity_np(thread, sizeof(cpuSet), &cpuSet);
+  double mask = 0.0;
+
+  for (int word = 0; word < NUM_CPU_WORDS; ++word) {
+    juce::uint64 bits = 0;
+
+    for (int bit = 0; bit < CPU_WORD_BITS; ++bit) {
+      const int cpu = word * CPU_WORD_BITS + bit;
+
+      if (CPU_ISSET(cpu, &cpuSet)) {
+        bits |= (juce::uint64)1 << bit;
+
+        if (cpu < MAX_GAUGE_CPUS)
+          mask += std::ldexp(1.0, cpu);
+      }
+    }
+
+    result.cpuWords[(size_t)word].store(bits, std::memory_order_relaxed);
+  }
+
+  int policy = SCHED_OTHER;
+  sched_param param{};
+  pthread_getschedparam(thread, &policy, &param);
+  const int actualPriority = policy == SCHED_FIFO ? param.sched_priority : 0;
+
+  errno = 0;
+  const int actualNice = getpriority(PRIO_PROCESS, threadId);
+
+  result.fifoPriority.store(actualPriority, std::memory_order_relaxed);
+  result.niceValue.store(errno == 0 ? actualNice : 0,
+                         std::memory_order_relaxed);
+  result.cpuMask->set(mask);
+  result.fifoPriorityGauge->set(actualPriority);
+  result.niceGauge->set(errno == 0 ? actualNice : 0);
+#else
+  juce::ignoreUnused(prefault);
+
+  // Nothing can be applied here; settings that ask for something fail
+  bool anyCpu = false;
+  for (const auto &word : shared.cpuWords)
+    anyCpu = anyCpu || word.load(std::memory_order_relaxed) != 0;
+
+  success = !anyCpu && fifoPriority == 0 && niceValue == 0;
+#endif
+
+  result.failed.store(!success, std::memory_order_relaxed);
+  result.applied.store(true, std::memory_order_release);
+  return success;
+}
+
+ThreadTuning::Effective
+ThreadTuning::getEffective(ThreadClass threadClass) const {
+  const auto &shared = effective[(size_t)threadClass];
+
+  Effective result;
+  result.applied = shared.applied.load(std::memory_order_acquire);
+  result.failed = shared.failed.load(std::memory_order_relaxed);
+  result.cpus = toBigInteger(shared.cpuWords);
+  result.fifoPriority = shared.fifoPriority.load(std::memory_order_relaxed);
+  result.niceValue = shared.niceValue.load(std::memory_order_relaxed);
+  return result;
+}
+
+void ThreadTuning::setMemoryLocking(bool shouldLock) {
+  const juce::ScopedLock sl(memoryLockLock);
+
+  if (memoryLocking.exchange(shouldLock) == shouldLock)
+    return;
+
+  // The audio thread touches its stack again on its next call
+  settings[(size_t)ThreadClass::audio].generation.fetch_add(
+      1, std::memory_order_release);
+
+#if JUCE_LINUX
+  if (!shouldLock && memoryLocked.exchange(false)) {
+    munlockall();
+    LOG_INFO("Memory unlocked");
+  }
+#endif
+}
+
+bool ThreadTuning::isMemoryLockingEnabled() const {
+  return memoryLocking.load(std::memory_order_relaxed);
+}
+
+bool ThreadTuning::lockMemory() {
+  const juce::ScopedLock sl(memoryLockLock);
+
+  if (!memoryLocking.load(std::memory_order_relaxed))
+    return false;
+
+  if (memoryLocked.load(std::memory_order_relaxed))
+    return true;
+
+#if JUCE_LINUX
+  // Locking faults in every mapped page, and MCL_FUTURE every later one
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+    LOG_WARNING(juce::String("Memory could not be locked (") +
+                std::strerror(errno) +
+                "); raise RLIMIT_MEMLOCK or grant CAP_IPC_LOCK");
+    return false;
+  }
+
+  memoryLocked = true;
+  LOG_INFO("Memory locked");
+  return true;
+#else
+  LOG_WARNING("Memory locking is not supported on this platform");
+  return false;
+#endif
+}
+
+bool ThreadTuning::isMemoryLocked() const {
+  return memoryLocked.load(std::memory_order_relaxed);
+}
+
+} // namespace mcam
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "Metrics.h"
+
+namespace mcam {
+/**
+ * ThreadTuning pins each class of engine thread to a set of CPUs, sets its
+ * scheduling (SCHED_FIFO priority or nice value), and locks the process's
+ * memory so the audio path does not page fault.
+ *
+ * Threads apply their class's settings themselves by calling
+ * applyToCurrentThread() from their loop; the call does nothing unless the
+ * settings changed since that thread last applied them, so it is cheap
+ * enough for the audio callback. Classes left at the defaults keep the
+ * scheduling their threads were started with.
+ *
+ * The effective settings, as read back from the system, are exported
+ * through the MetricsRegistry per class:
+ *   mcam_thread_cpu_mask        CPUs 0-52 the threads may run on, as bits
+ *   mcam_thread_fifo_priority   SCHED_FIFO priority, 0 if not realtime
+ *   mcam_thread_nice            nice value
+ * together with mcam_thread_tuning_failures_total and, for the process,
+ * mcam_memory_locked and mcam_memory_locked_bytes.
+ *
+ * Scheduling, affinity and memory locking need Linux; elsewhere settings
+ * are accepted but applying them fails.
+ */
+class ThreadTuning {
+public:
+  /** Classes of engine thread sharing one set of settings */
+  enum class ThreadClass { audio, analysis, disk, network, ui, background };
+
+  /** Number of thread classes */
+  static constexpr int NUM_THREAD_CLASSES = 6;
+
+  /** Highest CPU index that can be assigned, plus one */
+  static constexpr int MAX_CPUS = 256;
+
+  /** Scheduling of one thread class */
+  struct Settings {
+    /** CPUs the threads may run on; none leaves the affinity alone */
+    juce::BigInteger cpus;
+
+    /** SCHED_FIFO priority, 1-99; 0 leaves the scheduler alone */
+    int fifoPriority = 0;
+
+    /** Nice value, -20 to 19, when not SCHED_FIFO; 0 leaves it alone */
+    int niceValue = 0;
+  };
+
+  /** Scheduling last applied by a thread of a class, as read back */
+  struct Effective {
+    /** true once a thread of the class has applied its settings */
+    bool applied = false;
+
+    /** true if the system refused part of the settings */
+    bool failed = false;
+
+    juce::BigInteger cpus;
+    int fifoPriority = 0;
+    int niceValue = 0;
+  };
+
+  /**
+   * @param threadClass Thread class
+   * @return Name for settings and metrics, e.g. "analysis"
+   */
+  static const char *getClassName(ThreadClass threadClass);
+
+  /**
+   * Parses a CPU list such as "2,3" or "0-1,4"
+   * @param text The list; empty for no CPUs
+   * @param cpus Receives the CPUs
+   * @return false if the list is malformed or names a CPU >= MAX_CPUS
+   */
+  static bool parseCpuList(const juce::String &text, juce::BigInteger &cpus);
+
+  /** Get the single instance of the tuning */
+  static ThreadTuning &getInstance();
+
+  /**
+   * Changes the settings of a thread class; each thread picks them up on
+   * its next applyToCurrentThread()
+   * @param threadClass Thread class
+   * @param settings New settings
+   * @return false if a value is out of range
+   */
+  bool setSettings(ThreadClass threadClass, const Settings &settings);
+
+  /** @return The settings of a thread class */
+  Settings getSettings(ThreadClass threadClass) const;
+
+  /**
+   * Applies the settings of a class to the calling thread if they changed
+   * since it last applied them. Failures are counted; they are logged for
+   * every class but audio, since the log is written on the calling thread.
+   * When memory locking is on, the first call from the audio class also
+   * touches the thread's stack.
+   * @param threadClass Class the calling thread belongs to
+   * @return false if the system refused part of the settings
+   */
+  bool applyToCurrentThread(ThreadClass threadClass);
+
+  /** @return The scheduling last applied by a thread of a class */
+  Effective getEffective(ThreadClass threadClass) const;
+
+  /**
+   * Turns memory locking on or off. When on, lockMemory() locks every
+   * current and future page of the process into RAM.
+   */
+  void setMemoryLocking(bool shouldLock);
+
+  /** @return true if memory locking is on */
+  bool isMemoryLockingEnabled() const;
+
+  /**
+   * Locks memory if memory locking is on and it is not locked yet. Call
+   * after buffers are allocated, e.g. once the audio callbacks have been
+   * prepared; the pages are faulted in here rather than on first use.
+   * @return true if memory is locked
+   */
+  bool lockMemory();
+
+  /** @return true if memory has been locked */
+  bool isMemoryLocked() const;
+
+private:
+  /** Settings readable by any thread while they are changed */
+  struct SharedSettings {
+    std::array<std::atomic<juce::uint64>, MAX_CPUS / 64> cpuWords{};
+    std::atomic<int> fifoPriority{0};
+    std::atomic<int> niceValue{0};
+
+    // Bumped by every change to the class; its threads compare it with the
+    // one they applied
+    std::atomic<juce::uint32> generation{1};
+  };
+
+  /** Scheduling read back after applying, readable by any thread */
+  struct SharedEffective {
+    std::atomic<bool> applied{false};
+    std::atomic<bool> failed{false};
+    std::array<std::atomic<juce::uint64>, MAX_CPUS / 64> cpuWords{};
+    std::atomic<int> fifoPriority{0};
+    std::atomic<int> niceValue{0};
+
+    metrics::Gauge *cpuMask = nullptr;
+    metrics::Gauge *fifoPriorityGauge = nullptr;
+    metrics::Gauge *niceGauge = nullptr;
+    metrics::Counter *failures = nullptr;
+  };
+
+  ThreadTuning();
+
+  /** Applies settings and reads the result back into effective */
+  bool apply(const SharedSettings &settings, SharedEffective &effective,
+             bool prefaultStack);
+
+  std::array<SharedSettings, NUM_THREAD_CLASSES> settings;
+  std::array<SharedEffective, NUM_THREAD_CLASSES> effective;
+
+  std::atomic<bool> memoryLocking{false};
+  std::atomic<bool> memoryLocked{false};
+  juce::CriticalSection memoryLockLock;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ThreadTuning)
+};
+
+} // namespace mcam
@@ -13,6 +13,7 @@
 #include <juce_graphics/juce_graphics.h>
 #include <juce_gui_basics/juce_gui_basics.h>
 #include <juce_gui_extra/juce_gui_extra.h>
+#include <juce_osc/juce_osc.h>
 
 // Project version information
 #ifndef  JUCE_APPLICATION_NAME_STRING
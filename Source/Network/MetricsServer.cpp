@@ -0,0 +1,126 @@
+#include "MetricsServer.h"
+
+namespace mcam {
+
+namespace {
+// Requests larger than this are rejected; a scrape is a single GET line
+constexpr int MAX_REQUEST_BYTES = 4096;
+
+// Time allowed for a client to send its request
+constexpr int REQUEST_TIMEOUT_MS = 2000;
+} // namespace
+
+MetricsServer::MetricsServer() : juce::Thread("MCAM Metrics Server") {
+  LOG_INFO("Creating MetricsServer");
+}
+
+MetricsServer::~MetricsServer() {
+  LOG_INFO("Destroying MetricsServer");
+  stop();
+}
+
+bool MetricsServer::start(int port, const juce::String &bindAddress) {
+  stop();
+
+  if (!listener.createListener(port, bindAddress)) {
+    LOG_ERROR("Failed to open metrics port " + juce::String(port));
+    return false;
+  }
+
+  LOG_INFO("Metrics endpoint listening on port " + juce::String(port));
+
+  startThread(juce::Thread::Priority::low);
+  return true;
+}
+
+void MetricsServer::stop() {
+  if (!isThreadRunning())
+    return;
+
+  LOG_INFO("Stopping metrics endpoint");
+
+  signalThreadShouldExit();
+
+  // Closing the listener wakes waitForNextConnection()
+  listener.close();
+  stopThread(REQUEST_TIMEOUT_MS * 2);
+}
+
+bool MetricsServer::isRunning() const { return isThreadRunning(); }
+
+void MetricsServer::run() {
+  auto &threadTuning = ThreadTuning::getInstance();
+
+  while (!threadShouldExit()) {
+    threadTuning.applyToCurrentThread(ThreadTuning::ThreadClass::network);
+
+    std::unique_ptr<juce::StreamingSocket> client(
+        listener.waitForNextConnection());
+
+    if (client == nullptr)
+      continue;
+
+    handleConnection(*client);
+  }
+}
+
+void MetricsServer::handleConnection(juce::StreamingSocket &client) {
+  juce::MemoryBlock request;
+  char chunk[512];
+
+  // Read until the end of the request headers
+  while (request.getSize() < (size_t)MAX_REQUEST_BYTES) {
+    if (client.waitUntilReady(true, REQUEST_TIMEOUT_MS) != 1)
+      return;
+
+    const int bytesRead = client.read(chunk, (int)sizeof(chunk), false);
+
+    if (bytesRead <= 0)
+      return;
+
+    request.append(chunk, (size_t)bytesRead);
+
+    if (request.toString().contains("\r\n\r\n"))
+      break;
+  }
+
+  const auto requestLine =
+      request.toString().upToFirstOccurrenceOf("\r\n", false, false);
+  const auto tokens = juce::StringArray::fromTokens(requestLine, " ", "");
+
+  if (tokens.size() < 2 || tokens[0] != "GET") {
+    sendResponse(client, 405, "Method Not Allowed", "text/plain",
+                 "Only GET is supported\n");
+    return;
+  }
+
+  const auto path = tokens[1].upToFirstOccurrenceOf("?", false, false);
+
+  if (path != "/metrics") {
+    sendResponse(client, 404, "Not Found", "text/plain",
+                 "Metrics are served at /metrics\n");
+    return;
+  }
+
+  sendResponse(client, 200, "OK", "text/plain; version=0.0.4; charset=utf-8",
+               MetricsRegistry::getInstance().renderPrometheusText());
+}
+
+void MetricsServer::sendResponse(juce::StreamingSocket &client, int statusCode,
+                                 const juce::String &statusText,
+                                 const juce::String &contentType,
+                                 const juce::String &body) {
+  const auto bodyUtf8 = body.toStdString();
+
+  juce::String header;
+  header << "HTTP/1.0 " << statusCode << " " << statusText << "\r\n"
+         << "Content-Type: " << contentType << "\r\n"
+         << "Content-Length: " << (int)bodyUtf8.size() << "\r\n"
+         << "Connection: close\r\n\r\n";
+
+  const auto headerUtf8 = header.toStdString();
+  client.write(headerUtf8.data(), (int)headerUtf8.size());
+  client.write(bodyUtf8.data(), (int)bodyUtf8.size());
+}
+
+} // namespace mcam
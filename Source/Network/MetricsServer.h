@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../Core/Logger.h"
+#include "../Core/Metrics.h"
+#include "../Core/ThreadTuning.h"
+#include "../JuceHeader.h"
+
+namespace mcam {
+/**
+ * MetricsServer is a minimal HTTP endpoint that serves the contents of the
+ * MetricsRegistry in Prometheus text format on GET /metrics.
+ *
+ * Requests are handled one at a time on a dedicated low-priority thread; a
+ * scrape only reads the registry and never touches the audio thread.
+ */
+class MetricsServer : private juce::Thread {
+public:
+  /** Default TCP port for the metrics endpoint */
+  static constexpr int DEFAULT_PORT = 9464;
+
+  /** Constructor */
+  MetricsServer();
+
+  /** Destructor */
+  ~MetricsServer() override;
+
+  /**
+   * Starts listening for scrapes
+   * @param port TCP port to listen on
+   * @param bindAddress Local address to bind to (empty for all interfaces)
+   * @return true if the listening socket was opened
+   */
+  bool start(int port = DEFAULT_PORT, const juce::String &bindAddress = {});
+
+  /** Stops listening and joins the server thread */
+  void stop();
+
+  /** @return true if the server is accepting connections */
+  bool isRunning() const;
+
+private:
+  /** juce::Thread implementation */
+  void run() override;
+
+  /** Reads one request from a client and writes the response */
+  void handleConnection(juce::StreamingSocket &client);
+
+  /** Writes a complete HTTP/1.0 response */
+  static void sendResponse(juce::StreamingSocket &client, int statusCode,
+                           const juce::String &statusText,
+                           const juce::String &contentType,
+                           const juce::String &body);
+
+  juce::StreamingSocket listener;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MetricsServer)
+};
+
+} // namespace mcam
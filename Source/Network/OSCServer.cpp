@@ -0,0 +1,206 @@
+#include "OSCServer.h"
+
+namespace mcam {
+
+OSCServer::OSCServer(BufferProcessor &processor)
+    : bufferProcessor(processor),
+      commandsReceived(MetricsRegistry::getInstance().counter(
+          "mcam_osc_commands_total", "OSC routing commands received")),
+      commandsRejected(MetricsRegistry::getInstance().counter(
+          "mcam_osc_commands_rejected_total",
+          "OSC routing commands that were invalid or could not be queued")),
+      bundlesSent(MetricsRegistry::getInstance().counter(
+          "mcam_osc_bundles_sent_total", "OSC telemetry bundles sent")) {
+  LOG_INFO("Creating OSCServer");
+
+  for (int slot = 0; slot < BufferProcessor::NUM_MONITOR_SLOTS; ++slot) {
+    const auto prefix = "/mcam/slot/" + juce::String(slot + 1);
+    channelAddresses.emplace_back(prefix + "/channel");
+    meterAddresses.emplace_back(prefix + "/meter");
+  }
+}
+
+OSCServer::~OSCServer() {
+  LOG_INFO("Destroying OSCServer");
+  stop();
+}
+
+bool OSCServer::start(int receivePort, const juce::String &targetHost,
+                      int targetPort, int telemetryRateHz) {
+  stop();
+
+  LOG_INFO("Starting OSC server - listening on port " +
+           juce::String(receivePort) + ", telemetry to " + targetHost + ":" +
+           juce::String(targetPort));
+
+  if (!receiver.connect(receivePort)) {
+    LOG_ERROR("Failed to open OSC receive port " + juce::String(receivePort));
+    return false;
+  }
+
+  if (!sender.connect(targetHost, targetPort)) {
+    LOG_ERROR("Failed to open OSC telemetry socket to " + targetHost + ":" +
+              juce::String(targetPort));
+    receiver.disconnect();
+    return false;
+  }
+
+  receiver.addListener(this);
+
+  // Only alarms changing from now on are sent
+  alarmCursor = bufferProcessor.getAlarmEngine().getNumEvents();
+
+  if (telemetryRateHz > 0) {
+    startTimer(juce::jmax(1, 1000 / telemetryRateHz));
+  }
+
+  running = true;
+  return true;
+}
+
+void OSCServer::stop() {
+  if (!running)
+    return;
+
+  LOG_INFO("Stopping OSC server");
+
+  stopTimer();
+  receiver.removeListener(this);
+  receiver.disconnect();
+  sender.disconnect();
+
+  running = false;
+}
+
+bool OSCServer::isRunning() const { return running; }
+
+void OSCServer::oscMessageReceived(const juce::OSCMessage &message) {
+  ThreadTuning::getInstance().applyToCurrentThread(
+      ThreadTuning::ThreadClass::network);
+  handleMessage(message);
+}
+
+void OSCServer::oscBundleReceived(const juce::OSCBundle &bundle) {
+  ThreadTuning::getInstance().applyToCurrentThread(
+      ThreadTuning::ThreadClass::network);
+
+  for (const auto &element : bundle) {
+    if (element.isMessage()) {
+      handleMessage(element.getMessage());
+    } else if (element.isBundle()) {
+      oscBundleReceived(element.getBundle());
+    }
+  }
+}
+
+bool OSCServer::handleMessage(const juce::OSCMessage &message) {
+  // Expected form: /mcam/slot/N/channel or /mcam/derived/N
+  auto tokens = juce::StringArray::fromTokens(
+      message.getAddressPattern().toString(), "/", "");
+  tokens.removeEmptyStrings();
+
+  if (tokens.size() == 3 && tokens[0] == "mcam" && tokens[1] == "derived" &&
+      tokens[2].containsOnly("0123456789")) {
+    return handleDerivedMessage(tokens[2].getIntValue() - 1, message);
+  }
+
+  if (tokens.size() != 4 || tokens[0] != "mcam" || tokens[1] != "slot" ||
+      tokens[3] != "channel" || !tokens[2].containsOnly("0123456789")) {
+    return false;
+  }
+
+  if (message.isEmpty())
+    return false;
+
+  const auto &arg = message[0];
+  int channelNumber = 0;
+
+  // Accept both ints and floats; many control surfaces only send floats
+  if (arg.isInt32()) {
+    channelNumber = arg.getInt32();
+  } else if (arg.isFloat32()) {
+    channelNumber = juce::roundToInt(arg.getFloat32());
+  } else {
+    return false;
+  }
+
+  const int slotIndex = tokens[2].getIntValue() - 1;
+  const int channelIndex = channelNumber - 1; // 0 (none) maps to -1
+
+  commandsReceived.add();
+
+  if (!bufferProcessor.postMonitorChannel(slotIndex, channelIndex)) {
+    commandsRejected.add();
+    return false;
+  }
+
+  return true;
+}
+
+bool OSCServer::handleDerivedMessage(int derivedIndex,
+                                     const juce::OSCMessage &message) {
+  commandsReceived.add();
+
+  // Expected arguments: <string name> <string terms>; no terms clears
+  std::vector<ChannelMatrixMixer::Term> terms;
+
+  if (message.isEmpty() || !message[0].isString() ||
+      (message.size() > 1 &&
+       (!message[1].isString() ||
+        !ChannelMatrixMixer::termsFromString(message[1].getString(),
+                                             terms)))) {
+    commandsRejected.add();
+    return false;
+  }
+
+  // Definitions are rare, so they take the buffer lock rather than a queue
+  if (!bufferProcessor.setDerivedChannel(derivedIndex, message[0].getString(),
+                                         std::move(terms))) {
+    commandsRejected.add();
+    return false;
+  }
+
+  return true;
+}
+
+juce::OSCBundle OSCServer::createTelemetryBundle() {
+  juce::OSCBundle bundle;
+
+  for (int slot = 0; slot < BufferProcessor::NUM_MONITOR_SLOTS; ++slot) {
+    bundle.addElement(juce::OSCMessage(
+        channelAddresses[(size_t)slot],
+        (juce::int32)(bufferProcessor.getMonitorChannel(slot) + 1)));
+
+    bundle.addElement(
+        juce::OSCMessage(meterAddresses[(size_t)slot],
+                         bufferProcessor.getSlotRmsLevel(slot),
+                         bufferProcessor.getSlotPeakLevel(slot)));
+  }
+
+  const int numAlarms = bufferProcessor.getAlarmEngine().readEvents(
+      alarmCursor, alarmEvents.data(), MAX_ALARMS_PER_BUNDLE);
+
+  for (int index = 0; index < numAlarms; ++index) {
+    const auto &event = alarmEvents[(size_t)index];
+    bundle.addElement(juce::OSCMessage(
+        alarmAddress, (juce::int32)(event.channel + 1),
+        juce::String(AlarmEngine::getTypeName(event.type)),
+        (juce::int32)(event.raised ? 1 : 0), event.value));
+  }
+
+  return bundle;
+}
+
+void OSCServer::hiResTimerCallback() {
+  ThreadTuning::getInstance().applyToCurrentThread(
+      ThreadTuning::ThreadClass::network);
+
+  // One datagram per tick carrying every slot
+  if (sender.send(createTelemetryBundle())) {
+    bundlesSent.add();
+  } else {
+    LOG_DEBUG("Failed to send OSC telemetry bundle");
+  }
+}
+
+} // namespace mcam
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "../Audio/Processing/BufferProcessor.h"
+#include "../Core/Logger.h"
+#include "../Core/Metrics.h"
+#include "../Core/ThreadTuning.h"
+#include "../JuceHeader.h"
+
+namespace mcam {
+/**
+ * OSCServer exposes monitor routing and meter telemetry over OSC/UDP.
+ *
+ * Incoming messages (slot and channel numbers are 1-based, as in the UI):
+ *   /mcam/slot/N/channel <int|float>   route channel to slot N, 0 = none
+ *   /mcam/derived/N <string name> <string terms>
+ *                                      define derived channel N, whose
+ *                                      terms are "input:gain,..." (see
+ *                                      ChannelMatrixMixer::termsToString);
+ *                                      no terms clears it
+ *
+ * Outgoing telemetry is batched so that a single bundle (one datagram)
+ * carries every slot per tick:
+ *   /mcam/slot/N/channel <int>
+ *   /mcam/slot/N/meter <float rms> <float peak>
+ *   /mcam/alarm <int channel> <string type> <int raised> <float value>
+ *
+ * Alarm messages carry each AlarmEngine state change once, in order, at
+ * most MAX_ALARMS_PER_BUNDLE per bundle; the rest follow in the next.
+ *
+ * Routing changes are posted to BufferProcessor's non-blocking command
+ * queue from the receiver thread, so they never wait on the UI-thread lock.
+ * Derived channel definitions are rare and are set directly.
+ */
+class OSCServer
+    : private juce::OSCReceiver::Listener<
+          juce::OSCReceiver::RealtimeCallback>,
+      private juce::HighResolutionTimer {
+public:
+  /** Default UDP port for incoming control messages */
+  static constexpr int DEFAULT_RECEIVE_PORT = 9000;
+
+  /** Default UDP port telemetry bundles are sent to */
+  static constexpr int DEFAULT_SEND_PORT = 9001;
+
+  /** Default telemetry rate in bundles per second */
+  static constexpr int DEFAULT_TELEMETRY_RATE_HZ = 30;
+
+  /** Most alarm events sent in one telemetry bundle */
+  static constexpr int MAX_ALARMS_PER_BUNDLE = 32;
+
+  /**
+   * Constructor
+   * @param processor The buffer processor to control and report on
+   */
+  explicit OSCServer(BufferProcessor &processor);
+
+  /** Destructor */
+  ~OSCServer() override;
+
+  /**
+   * Opens the sockets and starts streaming telemetry
+   * @param receivePort Local UDP port to listen on for control messages
+   * @param targetHost Host that telemetry bundles are sent to
+   * @param targetPort UDP port that telemetry bundles are sent to
+   * @param telemetryRateHz Bundles per second (0 disables telemetry)
+   * @return true if both sockets were opened
+   */
+  bool start(int receivePort = DEFAULT_RECEIVE_PORT,
+             const juce::String &targetHost = "127.0.0.1",
+             int targetPort = DEFAULT_SEND_PORT,
+             int telemetryRateHz = DEFAULT_TELEMETRY_RATE_HZ);
+
+  /** Stops telemetry and closes the sockets */
+  void stop();
+
+  /** @return true if the server is currently running */
+  bool isRunning() const;
+
+private:
+  /** OSCReceiver::Listener implementation (called on the receiver thread) */
+  void oscMessageReceived(const juce::OSCMessage &message) override;
+  void oscBundleReceived(const juce::OSCBundle &bundle) override;
+
+  /** HighResolutionTimer implementation (called on the timer thread) */
+  void hiResTimerCallback() override;
+
+  /**
+   * Handles a single control message
+   * @return true if the message was recognised
+   */
+  bool handleMessage(const juce::OSCMessage &message);
+
+  /**
+   * Handles /mcam/derived/N
+   * @param derivedIndex The derived channel (N - 1)
+   * @return true if the derived channel was set
+   */
+  bool handleDerivedMessage(int derivedIndex, const juce::OSCMessage &message);
+
+  /** Builds the telemetry bundle for all slots and new alarm events */
+  juce::OSCBundle createTelemetryBundle();
+
+  BufferProcessor &bufferProcessor;
+
+  juce::OSCReceiver receiver{"MCAM OSC Receiver"};
+  juce::OSCSender sender;
+
+  // Outgoing addresses, built once so the timer does not parse strings
+  std::vector<juce::OSCAddressPattern> channelAddresses;
+  std::vector<juce::OSCAddressPattern> meterAddresses;
+  juce::OSCAddressPattern alarmAddress{"/mcam/alarm"};
+
+  // Alarm events not yet sent (timer thread only)
+  juce::int64 alarmCursor = 0;
+  std::array<AlarmEngine::Event, MAX_ALARMS_PER_BUNDLE> alarmEvents;
+
+  // Counters for diagnostics
+  metrics::Counter &commandsReceived;
+  metrics::Counter &commandsRejected;
+  metrics::Counter &bundlesSent;
+
+  bool running = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OSCServer)
+};
+
+} // namespace mcam
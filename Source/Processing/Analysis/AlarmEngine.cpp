@@ -0,0 +1,353 @@
+#include "AlarmEngine.h"
+
+namespace mcam {
+
+namespace {
+constexpr int NUM_TYPES = AlarmEngine::NUM_TYPES;
+
+// Whether each type raises as its value falls (rather than rises)
+constexpr bool RAISES_BELOW[NUM_TYPES] = {true, false, false, true, true};
+
+// Time constant of the DC and correlation smoothing, in seconds
+constexpr float SMOOTHING_SECONDS = 1.0f;
+
+// Mean square below which a channel is too quiet for its correlation to
+// mean anything (-60 dBFS)
+constexpr float PHASE_FLOOR = 1.0e-6f;
+
+// Longest clipped run counted, so hours of full scale cannot overflow it
+constexpr int MAX_CLIP_RUN = std::numeric_limits<int>::max() / 2;
+
+// Samples of a pair's sum analysed at a time
+constexpr int PAIR_CHUNK_SIZE = 256;
+
+// Slots in the event ring: one more than is readable
+constexpr int EVENT_RING_SIZE = AlarmEngine::EVENT_QUEUE_SIZE + 1;
+
+int toIndex(AlarmEngine::Type type) { return (int)type; }
+} // namespace
+
+const char *AlarmEngine::getTypeName(Type type) {
+  switch (type) {
+  case Type::silence:
+    return "silence";
+  case Type::clipping:
+    return "clipping";
+  case Type::dcOffset:
+    return "dc_offset";
+  case Type::stuck:
+    return "stuck";
+  case Type::phaseInversion:
+    return "phase_inversion";
+  }
+
+  return "unknown";
+}
+
+AlarmEngine::Settings AlarmEngine::getDefaultSettings(Type type) {
+  switch (type) {
+  case Type::silence:
+    return {true, 0.001f, 0.002f, 10.0f, 0.5f};
+  case Type::clipping:
+    return {true, 3.0f, 0.0f, 0.0f, 2.0f};
+  case Type::dcOffset:
+    return {true, 0.01f, 0.005f, 2.0f, 2.0f};
+  case Type::stuck:
+    return {true, 0.0f, 1.0e-6f, 0.05f, 0.0f};
+  case Type::phaseInversion:
+    return {true, -0.5f, -0.3f, 2.0f, 2.0f};
+  }
+
+  return {};
+}
+
+AlarmEngine::AlarmEngine(int maxChannelsToWatch)
+    : analyzerPipelines(AnalyzerPipelineRegistry::getInstance()),
+      maxChannels(juce::jmax(0, maxChannelsToWatch)),
+      statistics((size_t)maxChannels),
+      detectors((size_t)maxChannels * NUM_TYPES),
+      smoothedDcOffsets((size_t)maxChannels, 0.0f),
+      clipRuns((size_t)maxChannels, 0),
+      activeTypes(new std::atomic<juce::uint32>[(size_t)maxChannels]),
+      pairs((size_t)maxChannels / 2), pairSum((size_t)PAIR_CHUNK_SIZE),
+      events(new SharedEvent[(size_t)EVENT_RING_SIZE]) {
+  for (int type = 0; type < NUM_TYPES; ++type)
+    setSettings((Type)type, getDefaultSettings((Type)type));
+
+  reset();
+}
+
+void AlarmEngine::prepare(double newSampleRate) {
+  sampleRate = newSampleRate;
+  reset();
+}
+
+void AlarmEngine::reset() {
+  std::fill(statistics.begin(), statistics.end(), BlockStatistics());
+  std::fill(detectors.begin(), detectors.end(), Detector());
+  std::fill(smoothedDcOffsets.begin(), smoothedDcOffsets.end(), 0.0f);
+  std::fill(clipRuns.begin(), clipRuns.end(), 0);
+  std::fill(pairs.begin(), pairs.end(), PairState());
+
+  for (int channel = 0; channel < maxChannels; ++channel)
+    activeTypes[(size_t)channel].store(0, std::memory_order_relaxed);
+
+  samplesProcessed = 0;
+}
+
+bool AlarmEngine::setSettings(Type type, const Settings &newSettings) {
+  const int index = toIndex(type);
+
+  if (index < 0 || index >= NUM_TYPES || newSettings.raiseSeconds < 0.0f ||
+      newSettings.clearSeconds < 0.0f)
+    return false;
+
+  // The clear level must lie past the raise level, or the alarm would
+  // flap on a value between them
+  const bool hasHysteresis =
+      RAISES_BELOW[index] ? newSettings.clearLevel > newSettings.raiseLevel
+                          : newSettings.clearLevel < newSettings.raiseLevel;
+
+  if (!hasHysteresis)
+    return false;
+
+  auto &shared = settings[(size_t)index];
+  shared.enabled.store(newSettings.enabled, std::memory_order_relaxed);
+  shared.raiseLevel.store(newSettings.raiseLevel, std::memory_order_relaxed);
+  shared.clearLevel.store(newSettings.clearLevel, std::memory_order_relaxed);
+  shared.raiseSeconds.store(newSettings.raiseSeconds,
+                            std::memory_order_relaxed);
+  shared.clearSeconds.store(newSettings.clearSeconds,
+                            std::memory_order_relaxed);
+  return true;
+}
+
+AlarmEngine::Settings AlarmEngine::getSettings(Type type) const {
+  const auto &shared = settings[(size_t)toIndex(type)];
+  return {shared.enabled.load(std::memory_order_relaxed),
+          shared.raiseLevel.load(std::memory_order_relaxed),
+          shared.clearLevel.load(std::memory_order_relaxed),
+          shared.raiseSeconds.load(std::memory_order_relaxed),
+          shared.clearSeconds.load(std::memory_order_relaxed)};
+}
+
+void AlarmEngine::process(const float *const *channels, int numChannels,
+                          int numSamples) {
+  numChannels = juce::jlimit(0, maxChannels, numChannels);
+
+  if (numSamples <= 0)
+    return;
+
+  const float blockSeconds = (float)(numSamples / sampleRate);
+  const float smoothing = std::exp(-blockSeconds / SMOOTHING_SECONDS);
+  const auto analyze = analyzerPipelines.find(AnalyzerStage::all);
+  samplesProcessed += numSamples;
+
+  // One consistent set of thresholds for the whole block
+  std::array<Settings, NUM_TYPES> current;
+  for (int type = 0; type < NUM_TYPES; ++type)
+    current[(size_t)type] = getSettings((Type)type);
+
+  for (int channel = 0; channel < numChannels; ++channel) {
+    auto &clipRun = clipRuns[(size_t)channel];
+
+    if (channels[channel] == nullptr) {
+      clipRun = 0;
+      continue;
+    }
+
+    auto &block = statistics[(size_t)channel];
+    analyze(channels[channel], numSamples, block);
+
+    // A run of clipped samples continues from the last block if this one
+    // starts clipped
+    const int longestClipRun = juce::jmax(
+        block.longestClipRun,
+        block.clipRunAtStart > 0 ? clipRun + block.clipRunAtStart : 0);
+    clipRun = block.clipRunAtStart == numSamples
+                  ? juce::jmin(clipRun, MAX_CLIP_RUN - numSamples) + numSamples
+                  : block.clipRunAtEnd;
+
+    auto &dcOffset = smoothedDcOffsets[(size_t)channel];
+    dcOffset = smoothing * dcOffset + (1.0f - smoothing) * block.dcOffset;
+
+    // Digital silence is not stuck; report it as a moving signal
+    const float spread =
+        block.peak > 0.0f ? block.maximum - block.minimum : 1.0f;
+
+    evaluate(channel, Type::silence, block.rms, current, blockSeconds);
+    evaluate(channel, Type::clipping, (float)longestClipRun, current,
+             blockSeconds);
+    evaluate(channel, Type::dcOffset, std::abs(dcOffset), current,
+             blockSeconds);
+    evaluate(channel, Type::stuck, spread, current, blockSeconds);
+  }
+
+  for (int pair = 0; pair < numChannels / 2; ++pair) {
+    const float *left = channels[2 * pair];
+    const float *right = channels[2 * pair + 1];
+
+    if (left == nullptr || right == nullptr)
+      continue;
+
+    evaluate(2 * pair, Type::phaseInversion,
+             updatePhase(pair, left, right, numSamples, smoothing), current,
+             blockSeconds);
+  }
+}
+
+float AlarmEngine::updatePhase(int pair, const float *left,
+                               const float *right, int numSamples,
+                               float smoothing) {
+  // The cross term comes from the energy of the sum, which the pipeline
+  // measures like any other signal: |L + R|^2 = |L|^2 + |R|^2 + 2 L.R
+  const auto analyzeRms = analyzerPipelines.find(AnalyzerStage::rms);
+  double sumSquares = 0.0;
+
+  for (int pos = 0; pos < numSamples; pos += PAIR_CHUNK_SIZE) {
+    const int count = juce::jmin(PAIR_CHUNK_SIZE, numSamples - pos);
+    juce::FloatVectorOperations::add(pairSum.data(), left + pos, right + pos,
+                                     count);
+
+    BlockStatistics chunk;
+    analyzeRms(pairSum.data(), count, chunk);
+    sumSquares += (double)chunk.rms * chunk.rms * count;
+  }
+
+  const auto &leftBlock = statistics[(size_t)(2 * pair)];
+  const auto &rightBlock = statistics[(size_t)(2 * pair + 1)];
+  auto &state = pairs[(size_t)pair];
+  const float gain = 1.0f - smoothing;
+
+  state.left = smoothing * state.left + gain * leftBlock.rms * leftBlock.rms;
+  state.right =
+      smoothing * state.right + gain * rightBlock.rms * rightBlock.rms;
+  state.sum =
+      smoothing * state.sum + gain * (float)(sumSquares / numSamples);
+
+  if (state.left < PHASE_FLOOR || state.right < PHASE_FLOOR)
+    return 0.0f;
+
+  const float cross = 0.5f * (state.sum - state.left - state.right);
+  return juce::jlimit(-1.0f, 1.0f,
+                      cross / std::sqrt(state.left * state.right));
+}
+
+void AlarmEngine::evaluate(int channel, Type type, float value,
+                           const std::array<Settings, NUM_TYPES> &current,
+                           float blockSeconds) {
+  const int index = toIndex(type);
+  const auto &limits = current[(size_t)index];
+  auto &detector = detectors[(size_t)(channel * NUM_TYPES + index)];
+  bool changes = false;
+
+  if (!limits.enabled) {
+    // A disabled alarm clears at once
+    changes = detector.active;
+  } else {
+    const bool below = RAISES_BELOW[index];
+    const bool conditionMet =
+        below ? value <= limits.raiseLevel : value >= limits.raiseLevel;
+    const bool conditionOver =
+        below ? value >= limits.clearLevel : value <= limits.clearLevel;
+
+    if (detector.active ? conditionOver : conditionMet) {
+      detector.heldSeconds += blockSeconds;
+      changes = detector.heldSeconds >=
+                (detector.active ? limits.clearSeconds : limits.raiseSeconds);
+    } else {
+      detector.heldSeconds = 0.0f;
+    }
+  }
+
+  if (!changes)
+    return;
+
+  detector.active = !detector.active;
+  detector.heldSeconds = 0.0f;
+
+  const auto bit = (juce::uint32)1 << index;
+  auto &active = activeTypes[(size_t)channel];
+
+  if (detector.active)
+    active.fetch_or(bit, std::memory_order_relaxed);
+  else
+    active.fetch_and(~bit, std::memory_order_relaxed);
+
+  publish({type, channel, detector.active, value, samplesProcessed});
+}
+
+void AlarmEngine::publish(const Event &event) {
+  const auto index = numEvents.load(std::memory_order_relaxed);
+
+  // Readers that see any of the writes below also see the count before
+  // them, so they know this slot may be changing
+  std::atomic_thread_fence(std::memory_order_release);
+
+  auto &slot = events[(size_t)(index % EVENT_RING_SIZE)];
+  slot.type.store(toIndex(event.type), std::memory_order_relaxed);
+  slot.channel.store(event.channel, std::memory_order_relaxed);
+  slot.raised.store(event.raised, std::memory_order_relaxed);
+  slot.value.store(event.value, std::memory_order_relaxed);
+  slot.samplePosition.store(event.samplePosition, std::memory_order_relaxed);
+  numEvents.store(index + 1, std::memory_order_release);
+}
+
+const BlockStatistics &AlarmEngine::getStatistics(int channel) const {
+  jassert(channel >= 0 && channel < maxChannels);
+  return statistics[(size_t)channel];
+}
+
+bool AlarmEngine::isActive(int channel, Type type) const {
+  if (channel < 0 || channel >= maxChannels)
+    return false;
+
+  const auto bits =
+      activeTypes[(size_t)channel].load(std::memory_order_relaxed);
+  return (bits & ((juce::uint32)1 << toIndex(type))) != 0;
+}
+
+int AlarmEngine::getNumActive() const {
+  int numActive = 0;
+
+  for (int channel = 0; channel < maxChannels; ++channel)
+    numActive += juce::countNumberOfBits(
+        activeTypes[(size_t)channel].load(std::memory_order_relaxed));
+
+  return numActive;
+}
+
+juce::int64 AlarmEngine::getNumEvents() const {
+  return numEvents.load(std::memory_order_acquire);
+}
+
+int AlarmEngine::readEvents(juce::int64 &cursor, Event *destination,
+                            int maxEvents) const {
+  const auto end = numEvents.load(std::memory_order_acquire);
+  const auto first = juce::jlimit(end - EVENT_QUEUE_SIZE, end, cursor);
+  const auto last = juce::jmin(end, first + juce::jmax(0, maxEvents));
+
+  for (auto index = first; index < last; ++index) {
+    const auto &slot = events[(size_t)(index % EVENT_RING_SIZE)];
+    destination[index - first] = {
+        (Type)slot.type.load(std::memory_order_relaxed),
+        slot.channel.load(std::memory_order_relaxed),
+        slot.raised.load(std::memory_order_relaxed),
+        slot.value.load(std::memory_order_relaxed),
+        slot.samplePosition.load(std::memory_order_relaxed)};
+  }
+
+  // Events whose slots were reused while copying are dropped
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const auto newEnd = numEvents.load(std::memory_order_relaxed);
+  const auto valid = juce::jlimit(first, last, newEnd - EVENT_QUEUE_SIZE);
+
+  if (valid > first)
+    std::copy(destination + (valid - first), destination + (last - first),
+              destination);
+
+  cursor = last;
+  return (int)(last - valid);
+}
+
+} // namespace mcam
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+#include "AnalyzerPipeline.h"
+
+namespace mcam {
+/**
+ * AlarmEngine watches every input channel for faults: silence, clipping,
+ * DC offset, stuck (constant non-zero) samples, and phase inversion
+ * between the channels of each adjacent pair (0/1, 2/3, ...).
+ *
+ * Every block, each channel gets one fused pass of BlockStatistics from
+ * AnalyzerPipelineRegistry, and each pair one more pass over its sum. Each
+ * detector compares a value from those against a raise level and a clear
+ * level (the hysteresis), and changes state only once its condition has
+ * held for the raise or clear time. All detectors are evaluated whatever
+ * the settings, so the cost depends only on the channel count.
+ *
+ * State changes are published as Events into a fixed ring that any number
+ * of readers (UI, log, network) poll without locks, each with its own
+ * cursor. A reader that falls more than EVENT_QUEUE_SIZE events behind
+ * skips the oldest.
+ *
+ * Settings and the active flags may be accessed from any thread; process()
+ * and reset() are for the audio thread, or while it is held off.
+ */
+class AlarmEngine {
+public:
+  /** The faults detected */
+  enum class Type { silence, clipping, dcOffset, stuck, phaseInversion };
+
+  /** Number of alarm types */
+  static constexpr int NUM_TYPES = 5;
+
+  /** Events kept for readers */
+  static constexpr int EVENT_QUEUE_SIZE = 1024;
+
+  /**
+   * Thresholds of one alarm type. Silence, stuck and phase inversion raise
+   * when their value falls to raiseLevel or below and clear at clearLevel
+   * or above; clipping and DC offset the other way round.
+   */
+  struct Settings {
+    bool enabled = true;
+
+    /** Level at which the alarm's condition is met */
+    float raiseLevel = 0.0f;
+
+    /** Level at which it is over; beyond raiseLevel, for hysteresis */
+    float clearLevel = 0.0f;
+
+    /** Time the condition must hold before the alarm is raised */
+    float raiseSeconds = 0.0f;
+
+    /** Time the alarm must be over before it is cleared */
+    float clearSeconds = 0.0f;
+  };
+
+  /** A change of an alarm's state */
+  struct Event {
+    Type type = Type::silence;
+
+    /** Input channel; for phase inversion, the first of the pair */
+    int channel = 0;
+
+    /** true when the alarm was raised, false when it cleared */
+    bool raised = false;
+
+    /** The detector's value at the change (see getDefaultSettings) */
+    float value = 0.0f;
+
+    /** Samples processed since prepare(), at the end of the block */
+    juce::int64 samplePosition = 0;
+  };
+
+  /**
+   * @param type Alarm type
+   * @return Name for logs and network output, e.g. "dc_offset"
+   */
+  static const char *getTypeName(Type type);
+
+  /**
+   * Defaults, with the value each type compares:
+   * - silence: block RMS, below -60 dBFS for 10 s
+   * - clipping: longest run of consecutive full-scale samples in a block,
+   *   a run continued from earlier blocks counted in full, 3 or more
+   * - dcOffset: mean smoothed over about a second, above -40 dBFS for 2 s
+   * - stuck: spread between the largest and smallest sample, zero for
+   *   50 ms (digital silence is left to the silence alarm)
+   * - phaseInversion: correlation of the pair smoothed over about a
+   *   second, -0.5 or lower for 2 s while both channels carry signal
+   * @param type Alarm type
+   */
+  static Settings getDefaultSettings(Type type);
+
+  /**
+   * Constructor. Allocates all state; the defaults are in effect.
+   * @param maxChannels Most input channels evaluated
+   */
+  explicit AlarmEngine(int maxChannels);
+
+  /**
+   * Sets the sample rate and clears every alarm
+   * @param sampleRate Sample rate in Hz
+   */
+  void prepare(double sampleRate);
+
+  /** Clears every alarm without publishing events */
+  void reset();
+
+  /**
+   * Changes the thresholds of one alarm type from the next block on
+   * @param type Alarm type
+   * @param settings New thresholds
+   * @return false if the levels leave no hysteresis or a time is negative
+   */
+  bool setSettings(Type type, const Settings &settings);
+
+  /** @return The thresholds of one alarm type */
+  Settings getSettings(Type type) const;
+
+  /**
+   * Evaluates every alarm over one block
+   * @param channels One pointer per input channel; nullptr is skipped
+   * @param numChannels Number of channels, clamped to maxChannels
+   * @param numSamples Number of samples
+   */
+  void process(const float *const *channels, int numChannels,
+               int numSamples);
+
+  /**
+   * Gets the statistics of a channel's last block, all stages included.
+   * Call from the thread running process().
+   * @param channel Input channel
+   */
+  const BlockStatistics &getStatistics(int channel) const;
+
+  /**
+   * @param channel Input channel
+   * @param type Alarm type
+   * @return true if the alarm is raised
+   */
+  bool isActive(int channel, Type type) const;
+
+  /** @return Number of raised alarms over all channels and types */
+  int getNumActive() const;
+
+  /** @return Events published so far, the cursor of a reader up to date */
+  juce::int64 getNumEvents() const;
+
+  /**
+   * Copies the events published since a reader's cursor
+   * @param cursor The reader's position; start it at getNumEvents() or 0,
+   * it is advanced past the events copied and any skipped
+   * @param events Receives the events, oldest first
+   * @param maxEvents Most events to copy
+   * @return Number of events copied
+   */
+  int readEvents(juce::int64 &cursor, Event *events, int maxEvents) const;
+
+private:
+  /** Thresholds readable by the audio thread while they are changed */
+  struct SharedSettings {
+    std::atomic<bool> enabled{true};
+    std::atomic<float> raiseLevel{0.0f};
+    std::atomic<float> clearLevel{0.0f};
+    std::atomic<float> raiseSeconds{0.0f};
+    std::atomic<float> clearSeconds{0.0f};
+  };
+
+  /** An event whose fields can be read while the writer runs */
+  struct SharedEvent {
+    std::atomic<int> type{0};
+    std::atomic<int> channel{0};
+    std::atomic<bool> raised{false};
+    std::atomic<float> value{0.0f};
+    std::atomic<juce::int64> samplePosition{0};
+  };
+
+  /** State of one alarm of one channel (audio thread only) */
+  struct Detector {
+    bool active = false;
+
+    /** Time the condition to change state has held so far */
+    float heldSeconds = 0.0f;
+  };
+
+  /** Updates one detector with the block's value */
+  void evaluate(int channel, Type type, float value,
+                const std::array<Settings, NUM_TYPES> &settings,
+                float blockSeconds);
+
+  /** Appends an event to the ring */
+  void publish(const Event &event);
+
+  /** @return The correlation of a pair over about the last second */
+  float updatePhase(int pair, const float *left, const float *right,
+                    int numSamples, float smoothing);
+
+  const AnalyzerPipelineRegistry &analyzerPipelines;
+  const int maxChannels;
+  double sampleRate = 48000.0;
+  juce::int64 samplesProcessed = 0;
+
+  std::array<SharedSettings, NUM_TYPES> settings;
+
+  // Per channel (audio thread only), and the raised types per channel as
+  // bits for other threads
+  std::vector<BlockStatistics> statistics;
+  std::vector<Detector> detectors;
+  std::vector<float> smoothedDcOffsets;
+  std::vector<int> clipRuns;
+  std::unique_ptr<std::atomic<juce::uint32>[]> activeTypes;
+
+  // Smoothed energies of each pair and of its sum (audio thread only)
+  struct PairState {
+    float left = 0.0f;
+    float right = 0.0f;
+    float sum = 0.0f;
+  };
+  std::vector<PairState> pairs;
+  std::vector<float> pairSum;
+
+  // Published events; the ring has one slot more than is readable, for
+  // the slot being written
+  std::unique_ptr<SharedEvent[]> events;
+  std::atomic<juce::int64> numEvents{0};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AlarmEngine)
+};
+
+} // namespace mcam
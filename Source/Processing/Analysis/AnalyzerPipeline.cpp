@@ -0,0 +1,49 @@
+#include "AnalyzerPipeline.h"
+
+namespace mcam {
+
+namespace {
+using PipelineTable =
+    std::array<AnalyzerPipelineRegistry::ProcessFunction,
+               (size_t)AnalyzerStage::all + 1>;
+
+/**
+ * Registers a pipeline for every subset of Remaining appended to Chosen:
+ * each stage in turn is either taken or left out.
+ */
+template <typename... Chosen> struct Combinations {
+  template <typename... Remaining> static void add(PipelineTable &table) {
+    if constexpr (sizeof...(Remaining) == 0)
+      table[(size_t)AnalyzerPipeline<Chosen...>::STAGES] =
+          &AnalyzerPipeline<Chosen...>::process;
+    else
+      addNext<Remaining...>(table);
+  }
+
+  template <typename Next, typename... Rest>
+  static void addNext(PipelineTable &table) {
+    Combinations<Chosen..., Next>::template add<Rest...>(table);
+    Combinations<Chosen...>::template add<Rest...>(table);
+  }
+};
+} // namespace
+
+const AnalyzerPipelineRegistry &AnalyzerPipelineRegistry::getInstance() {
+  static AnalyzerPipelineRegistry instance;
+  return instance;
+}
+
+AnalyzerPipelineRegistry::AnalyzerPipelineRegistry() {
+  Combinations<>::add<PeakStage, RmsStage, DcOffsetStage, ClipCountStage,
+                      MinimumStage, MaximumStage>(pipelines);
+
+  for (const auto pipeline : pipelines)
+    jassert(pipeline != nullptr);
+}
+
+AnalyzerPipelineRegistry::ProcessFunction
+AnalyzerPipelineRegistry::find(int stages) const {
+  return pipelines[(size_t)(stages & AnalyzerStage::all)];
+}
+
+} // namespace mcam
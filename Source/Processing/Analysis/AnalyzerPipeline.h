@@ -0,0 +1,445 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+
+/** Statistics of one block, as filled in by the stages of a pipeline */
+struct BlockStatistics {
+  /** Linear sample peak */
+  float peak = 0.0f;
+
+  /** Linear RMS */
+  float rms = 0.0f;
+
+  /** Mean of the samples */
+  float dcOffset = 0.0f;
+
+  /** Samples at or above ClipCountStage::CLIP_LEVEL in magnitude */
+  int clippedSamples = 0;
+
+  /**
+   * Consecutive clipped samples the block starts and ends with (the whole
+   * block if every sample clipped), and its longest run of them
+   */
+  int clipRunAtStart = 0;
+  int clipRunAtEnd = 0;
+  int longestClipRun = 0;
+
+  /** Smallest and largest sample, equal when the signal is stuck */
+  float minimum = 0.0f;
+  float maximum = 0.0f;
+};
+
+/** Stage identifiers; a set of stages is the OR of its identifiers */
+struct AnalyzerStage {
+  static constexpr int peak = 1 << 0;
+  static constexpr int rms = 1 << 1;
+  static constexpr int dcOffset = 1 << 2;
+  static constexpr int clipCount = 1 << 3;
+  static constexpr int minimum = 1 << 4;
+  static constexpr int maximum = 1 << 5;
+
+  /** Every stage the registry has precompiled combinations of */
+  static constexpr int all =
+      peak | rms | dcOffset | clipCount | minimum | maximum;
+};
+
+/** Per-sample values shared by the stages that read them */
+struct Prefilter {
+  static constexpr int magnitude = 1 << 0;
+  static constexpr int square = 1 << 1;
+};
+
+/**
+ * A sample and the prefiltered values derived from it. Only the values
+ * some stage of the pipeline needs are computed.
+ */
+template <typename Value> struct PrefilteredSample {
+  Value sample, magnitude, square;
+};
+
+#if JUCE_USE_SIMD
+using AnalyzerVector = juce::dsp::SIMDRegister<float>;
+#endif
+
+/** Largest sample magnitude */
+struct PeakStage {
+  static constexpr int ID = AnalyzerStage::peak;
+  static constexpr int NEEDS = Prefilter::magnitude;
+  static constexpr float INITIAL = 0.0f;
+
+  static float add(float total, const PrefilteredSample<float> &in) {
+    return juce::jmax(total, in.magnitude);
+  }
+
+  static float join(float a, float b) { return juce::jmax(a, b); }
+
+  static void publish(float total, int, BlockStatistics &statistics) {
+    statistics.peak = total;
+  }
+
+#if JUCE_USE_SIMD
+  static AnalyzerVector add(AnalyzerVector total,
+                            const PrefilteredSample<AnalyzerVector> &in) {
+    return AnalyzerVector::max(total, in.magnitude);
+  }
+#endif
+};
+
+/** Root mean square of the samples */
+struct RmsStage {
+  static constexpr int ID = AnalyzerStage::rms;
+  static constexpr int NEEDS = Prefilter::square;
+  static constexpr float INITIAL = 0.0f;
+
+  static float add(float total, const PrefilteredSample<float> &in) {
+    return total + in.square;
+  }
+
+  static float join(float a, float b) { return a + b; }
+
+  static void publish(float total, int numSamples,
+                      BlockStatistics &statistics) {
+    statistics.rms =
+        numSamples > 0 ? std::sqrt(total / (float)numSamples) : 0.0f;
+  }
+
+#if JUCE_USE_SIMD
+  static AnalyzerVector add(AnalyzerVector total,
+                            const PrefilteredSample<AnalyzerVector> &in) {
+    return total + in.square;
+  }
+#endif
+};
+
+/** Mean of the samples */
+struct DcOffsetStage {
+  static constexpr int ID = AnalyzerStage::dcOffset;
+  static constexpr int NEEDS = 0;
+  static constexpr float INITIAL = 0.0f;
+
+  static float add(float total, const PrefilteredSample<float> &in) {
+    return total + in.sample;
+  }
+
+  static float join(float a, float b) { return a + b; }
+
+  static void publish(float total, int numSamples,
+                      BlockStatistics &statistics) {
+    statistics.dcOffset = numSamples > 0 ? total / (float)numSamples : 0.0f;
+  }
+
+#if JUCE_USE_SIMD
+  static AnalyzerVector add(AnalyzerVector total,
+                            const PrefilteredSample<AnalyzerVector> &in) {
+    return total + in.sample;
+  }
+#endif
+};
+
+/** Clipped samples over a stretch of samples, for ClipCountStage */
+struct ClipRuns {
+  int count = 0;
+
+  /** Runs at the start and end of the stretch, and the longest */
+  int atStart = 0;
+  int atEnd = 0;
+  int longest = 0;
+
+  /** Samples in the stretch */
+  int length = 0;
+};
+
+/** Number of samples at full scale, and the runs they form */
+struct ClipCountStage {
+  using Total = ClipRuns;
+
+  static constexpr int ID = AnalyzerStage::clipCount;
+  static constexpr int NEEDS = Prefilter::magnitude;
+  static constexpr Total INITIAL{};
+
+  /** Largest 16-bit sample, so clipped integer sources count as well */
+  static constexpr float CLIP_LEVEL = 32767.0f / 32768.0f;
+
+  static Total add(const Total &total, const PrefilteredSample<float> &in) {
+    return join(total, stretch(in.magnitude >= CLIP_LEVEL ? 1 : 0, 1));
+  }
+
+  /** Joins a stretch to the stretch that follows it */
+  static Total join(const Total &a, const Total &b) {
+    Total joined;
+    joined.count = a.count + b.count;
+    joined.atStart = a.atStart == a.length ? a.length + b.atStart : a.atStart;
+    joined.atEnd = b.atEnd == b.length ? a.atEnd + b.length : b.atEnd;
+    joined.longest = juce::jmax(a.longest, b.longest, a.atEnd + b.atStart);
+    joined.length = a.length + b.length;
+    return joined;
+  }
+
+  static void publish(const Total &total, int, BlockStatistics &statistics) {
+    statistics.clippedSamples = total.count;
+    statistics.clipRunAtStart = total.atStart;
+    statistics.clipRunAtEnd = total.atEnd;
+    statistics.longestClipRun = total.longest;
+  }
+
+#if JUCE_USE_SIMD
+  static Total add(const Total &total,
+                   const PrefilteredSample<AnalyzerVector> &in) {
+    constexpr int size = (int)AnalyzerVector::SIMDNumElements;
+    const auto clipped = AnalyzerVector::greaterThanOrEqual(
+        in.magnitude, AnalyzerVector::expand(CLIP_LEVEL));
+    const int count =
+        juce::roundToInt((AnalyzerVector::expand(1.0f) & clipped).sum());
+
+    // Nearly every vector is clear or, while clipping, clipped throughout
+    if (count == 0 || count == size)
+      return join(total, stretch(count / size, size));
+
+    Total result = total;
+    for (size_t lane = 0; lane < (size_t)size; ++lane) {
+      const float magnitude = in.magnitude.get(lane);
+      result = add(result, PrefilteredSample<float>{0.0f, magnitude, 0.0f});
+    }
+
+    return result;
+  }
+#endif
+
+private:
+  /** A stretch of samples that all clipped or none of which did */
+  static Total stretch(int clipped, int length) {
+    const int run = clipped * length;
+    return {run, run, run, run, length};
+  }
+};
+
+/** Smallest sample */
+struct MinimumStage {
+  static constexpr int ID = AnalyzerStage::minimum;
+  static constexpr int NEEDS = 0;
+  static constexpr float INITIAL = std::numeric_limits<float>::max();
+
+  static float add(float total, const PrefilteredSample<float> &in) {
+    return juce::jmin(total, in.sample);
+  }
+
+  static float join(float a, float b) { return juce::jmin(a, b); }
+
+  static void publish(float total, int numSamples,
+                      BlockStatistics &statistics) {
+    statistics.minimum = numSamples > 0 ? total : 0.0f;
+  }
+
+#if JUCE_USE_SIMD
+  static AnalyzerVector add(AnalyzerVector total,
+                            const PrefilteredSample<AnalyzerVector> &in) {
+    return AnalyzerVector::min(total, in.sample);
+  }
+#endif
+};
+
+/** Largest sample */
+struct MaximumStage {
+  static constexpr int ID = AnalyzerStage::maximum;
+  static constexpr int NEEDS = 0;
+  static constexpr float INITIAL = std::numeric_limits<float>::lowest();
+
+  static float add(float total, const PrefilteredSample<float> &in) {
+    return juce::jmax(total, in.sample);
+  }
+
+  static float join(float a, float b) { return juce::jmax(a, b); }
+
+  static void publish(float total, int numSamples,
+                      BlockStatistics &statistics) {
+    statistics.maximum = numSamples > 0 ? total : 0.0f;
+  }
+
+#if JUCE_USE_SIMD
+  static AnalyzerVector add(AnalyzerVector total,
+                            const PrefilteredSample<AnalyzerVector> &in) {
+    return AnalyzerVector::max(total, in.sample);
+  }
+#endif
+};
+
+/**
+ * AnalyzerPipeline fuses a fixed set of stages into one pass over a block.
+ * Each sample is loaded once, the prefiltered values the stages need are
+ * computed once, and every stage folds them into its own accumulator; the
+ * calls are resolved at compile time and inline into the one loop.
+ *
+ * Aligned samples are processed a vector at a time with one accumulator
+ * lane per sample, the unaligned ends one sample at a time. A stage whose
+ * accumulator is not a float, because it depends on the order of the
+ * samples, keeps one accumulator and folds each vector in as a whole.
+ * A stage provides:
+ *
+ * - ID: its AnalyzerStage bit
+ * - NEEDS: the Prefilter values it reads
+ * - INITIAL: the value its accumulator starts from, of the accumulator's
+ *   type
+ * - add(): folds a sample, or a vector of samples, into an accumulator
+ * - join(): combines two accumulators, the first of the samples before
+ *   the second, to merge vector lanes and the ends
+ * - publish(): stores the final accumulator in BlockStatistics
+ */
+template <typename... Stages> class AnalyzerPipeline {
+public:
+  /** The stages run, as a set of AnalyzerStage bits */
+  static constexpr int STAGES = (0 | ... | Stages::ID);
+
+  /** The prefiltered values computed per sample */
+  static constexpr int NEEDS = (0 | ... | Stages::NEEDS);
+
+  /**
+   * Runs every stage over a block and publishes their results; fields of
+   * stages not in the pipeline are left untouched
+   * @param samples Input samples
+   * @param numSamples Number of samples
+   * @param statistics Receives the results
+   */
+  static void process(const float *samples, int numSamples,
+                      BlockStatistics &statistics) {
+    constexpr auto indices = std::index_sequence_for<Stages...>();
+    std::tuple<Total<Stages>...> totals{Stages::INITIAL...};
+    int i = 0;
+
+#if JUCE_USE_SIMD
+    constexpr int vectorSize = (int)AnalyzerVector::SIMDNumElements;
+
+    for (; i < numSamples && !AnalyzerVector::isSIMDAligned(samples + i); ++i)
+      addSample(totals, prefilter(samples[i]), indices);
+
+    std::tuple<VectorTotal<Stages>...> vectorTotals{
+        getVectorInitial<Stages>()...};
+
+    for (; i + vectorSize <= numSamples; i += vectorSize)
+      addSample(vectorTotals,
+                prefilter(AnalyzerVector::fromRawArray(samples + i)),
+                indices);
+
+    joinLanes(totals, vectorTotals, indices);
+#endif
+
+    for (; i < numSamples; ++i)
+      addSample(totals, prefilter(samples[i]), indices);
+
+    publish(totals, numSamples, statistics, indices);
+  }
+
+private:
+  /** A stage's accumulator */
+  template <typename Stage>
+  using Total = std::remove_const_t<decltype(Stage::INITIAL)>;
+
+#if JUCE_USE_SIMD
+  /** A stage's accumulator over vectors: one lane per sample for floats */
+  template <typename Stage>
+  using VectorTotal = std::conditional_t<std::is_same_v<Total<Stage>, float>,
+                                         AnalyzerVector, Total<Stage>>;
+
+  template <typename Stage> static VectorTotal<Stage> getVectorInitial() {
+    if constexpr (std::is_same_v<Total<Stage>, float>)
+      return AnalyzerVector::expand(Stage::INITIAL);
+    else
+      return Stage::INITIAL;
+  }
+#endif
+
+  static PrefilteredSample<float> prefilter(float sample) {
+    PrefilteredSample<float> in{sample, 0.0f, 0.0f};
+
+    if constexpr ((NEEDS & Prefilter::magnitude) != 0)
+      in.magnitude = std::abs(sample);
+
+    if constexpr ((NEEDS & Prefilter::square) != 0)
+      in.square = sample * sample;
+
+    return in;
+  }
+
+  template <typename Totals, typename Value, size_t... Index>
+  static void addSample(Totals &totals, const PrefilteredSample<Value> &in,
+                        std::index_sequence<Index...>) {
+    ((std::get<Index>(totals) = Stages::add(std::get<Index>(totals), in)),
+     ...);
+  }
+
+#if JUCE_USE_SIMD
+  static PrefilteredSample<AnalyzerVector> prefilter(AnalyzerVector sample) {
+    PrefilteredSample<AnalyzerVector> in{sample, sample, sample};
+
+    if constexpr ((NEEDS & Prefilter::magnitude) != 0)
+      in.magnitude = AnalyzerVector::abs(sample);
+
+    if constexpr ((NEEDS & Prefilter::square) != 0)
+      in.square = sample * sample;
+
+    return in;
+  }
+
+  template <typename Stage>
+  static Total<Stage> joinVector(const Total<Stage> &total,
+                                 const VectorTotal<Stage> &vectorTotal) {
+    if constexpr (std::is_same_v<Total<Stage>, float>) {
+      float joined = total;
+      for (size_t lane = 0; lane < AnalyzerVector::SIMDNumElements; ++lane)
+        joined = Stage::join(joined, vectorTotal.get(lane));
+      return joined;
+    } else {
+      return Stage::join(total, vectorTotal);
+    }
+  }
+
+  template <size_t... Index>
+  static void joinLanes(std::tuple<Total<Stages>...> &totals,
+                        const std::tuple<VectorTotal<Stages>...> &vectorTotals,
+                        std::index_sequence<Index...>) {
+    ((std::get<Index>(totals) = joinVector<Stages>(
+          std::get<Index>(totals), std::get<Index>(vectorTotals))),
+     ...);
+  }
+#endif
+
+  template <size_t... Index>
+  static void publish(const std::tuple<Total<Stages>...> &totals,
+                      int numSamples, BlockStatistics &statistics,
+                      std::index_sequence<Index...>) {
+    juce::ignoreUnused(numSamples, statistics);
+    (Stages::publish(std::get<Index>(totals), numSamples, statistics), ...);
+  }
+};
+
+/**
+ * AnalyzerPipelineRegistry holds a precompiled AnalyzerPipeline for every
+ * combination of the stages in AnalyzerStage::all, so a set of stages
+ * chosen at run time still runs as one fused loop behind a single function
+ * pointer.
+ */
+class AnalyzerPipelineRegistry {
+public:
+  /** Runs a pipeline over a block; see AnalyzerPipeline::process() */
+  using ProcessFunction = void (*)(const float *samples, int numSamples,
+                                   BlockStatistics &statistics);
+
+  /** @return The shared registry */
+  static const AnalyzerPipelineRegistry &getInstance();
+
+  /**
+   * @param stages A set of AnalyzerStage bits; unknown bits are ignored
+   * @return The pipeline running exactly those stages (never nullptr)
+   */
+  ProcessFunction find(int stages) const;
+
+private:
+  AnalyzerPipelineRegistry();
+
+  std::array<ProcessFunction, (size_t)AnalyzerStage::all + 1> pipelines{};
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AnalyzerPipelineRegistry)
+};
+
+} // namespace mcam
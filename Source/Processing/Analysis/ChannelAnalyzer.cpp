@@ -0,0 +1,200 @@
+#include "ChannelAnalyzer.h"
+
+namespace mcam {
+
+namespace {
+// Input samples decimated at a time
+constexpr int DECIMATION_BLOCK = 4096;
+} // namespace
+
+double ChannelAnalyzer::getOctaveBandCentre(int band) {
+  static constexpr double centres[NUM_OCTAVE_BANDS] = {
+      31.5, 63.0, 125.0, 250.0, 500.0, 1000.0, 2000.0, 4000.0, 8000.0, 16000.0};
+  return centres[juce::jlimit(0, NUM_OCTAVE_BANDS - 1, band)];
+}
+
+ChannelAnalyzer::ChannelAnalyzer() {
+  window.resize(FFT_SIZE);
+  juce::dsp::WindowingFunction<float>::fillWindowingTables(
+      window.data(), FFT_SIZE, juce::dsp::WindowingFunction<float>::hann,
+      false);
+
+  double windowSquares = 0.0;
+  for (auto w : window)
+    windowSquares += (double)w * w;
+
+  // Positive-frequency power of a sine of amplitude A is A^2 * N * sum(w^2)/4
+  windowPowerNorm = FFT_SIZE * windowSquares / 4.0;
+
+  frame.resize(FFT_SIZE);
+  fftBuffer.resize(FFT_SIZE * 2);
+  powerSum.resize(FFT_SIZE / 2 + 1);
+
+  prepare(sampleRate);
+}
+
+void ChannelAnalyzer::prepare(double newSampleRate, bool decimate) {
+  sampleRate = newSampleRate;
+
+  const int factor =
+      decimate ? PolyphaseDecimator::getFactorForSampleRate(sampleRate) : 1;
+  decimator.prepare(sampleRate, factor);
+  analysisRate = decimator.getOutputSampleRate();
+  decimated.resize((size_t)decimator.getMaxOutputSamples(DECIMATION_BLOCK));
+
+  numSamples = 0;
+  peak = 0.0f;
+  sumSquares = 0.0;
+
+  designKWeighting();
+  subBlockLength = juce::jmax(
+      1, juce::roundToInt(analysisRate * LoudnessMeter::SUB_BLOCK_SECONDS));
+  subBlockFill = 0;
+  subBlockPower = 0.0;
+  recentSubBlocks.fill(0.0);
+  numSubBlocks = 0;
+  gatingBlocks.clear();
+
+  std::fill(powerSum.begin(), powerSum.end(), 0.0);
+  frameFill = 0;
+  numFrames = 0;
+}
+
+double ChannelAnalyzer::getAnalysisSampleRate() const { return analysisRate; }
+
+void ChannelAnalyzer::designKWeighting() {
+  const auto sections = KWeightingFilterBank::design(analysisRate);
+
+  auto assign = [](Biquad &biquad,
+                   const KWeightingFilterBank::Coefficients &c) {
+    biquad = {};
+    biquad.b0 = c.b0;
+    biquad.b1 = c.b1;
+    biquad.b2 = c.b2;
+    biquad.a1 = c.a1;
+    biquad.a2 = c.a2;
+  };
+
+  assign(shelf, sections[0]);
+  assign(highPass, sections[1]);
+}
+
+void ChannelAnalyzer::process(const float *samples, int count) {
+  if (count <= 0)
+    return;
+
+  // Level
+  const auto range = juce::FloatVectorOperations::findMinAndMax(samples, count);
+  peak = juce::jmax(peak, std::abs(range.getStart()), std::abs(range.getEnd()));
+
+  for (int i = 0; i < count; ++i)
+    sumSquares += (double)samples[i] * samples[i];
+
+  numSamples += count;
+
+  if (decimator.getFactor() == 1) {
+    processAnalysisRate(samples, count);
+    return;
+  }
+
+  // Decimate in pieces so the buffer never grows on the audio thread
+  for (int pos = 0; pos < count; pos += DECIMATION_BLOCK) {
+    const int numDecimated = decimator.process(
+        samples + pos, juce::jmin(DECIMATION_BLOCK, count - pos),
+        decimated.data());
+    processAnalysisRate(decimated.data(), numDecimated);
+  }
+}
+
+void ChannelAnalyzer::processAnalysisRate(const float *samples, int count) {
+  for (int i = 0; i < count; ++i) {
+    // Loudness
+    const double weighted = highPass.process(shelf.process(samples[i]));
+    subBlockPower += weighted * weighted;
+
+    if (++subBlockFill == subBlockLength) {
+      recentSubBlocks[(size_t)(numSubBlocks % recentSubBlocks.size())] =
+          subBlockPower / subBlockLength;
+      ++numSubBlocks;
+      subBlockFill = 0;
+      subBlockPower = 0.0;
+
+      if (numSubBlocks >= (int)recentSubBlocks.size()) {
+        gatingBlocks.add(std::accumulate(recentSubBlocks.begin(),
+                                         recentSubBlocks.end(), 0.0) /
+                         (double)recentSubBlocks.size());
+      }
+    }
+
+    // Spectrum
+    frame[(size_t)frameFill] = samples[i];
+
+    if (++frameFill == FFT_SIZE) {
+      accumulateSpectrum();
+      frameFill = 0;
+    }
+  }
+}
+
+void ChannelAnalyzer::accumulateSpectrum() {
+  juce::FloatVectorOperations::multiply(fftBuffer.data(), frame.data(),
+                                        window.data(), FFT_SIZE);
+  std::fill(fftBuffer.begin() + FFT_SIZE, fftBuffer.end(), 0.0f);
+
+  fft.performFrequencyOnlyForwardTransform(fftBuffer.data(), true);
+
+  for (size_t bin = 0; bin < powerSum.size(); ++bin)
+    powerSum[bin] += (double)fftBuffer[bin] * fftBuffer[bin];
+
+  ++numFrames;
+}
+
+ChannelAnalyzer::Summary ChannelAnalyzer::getSummary() const {
+  Summary summary;
+  summary.numSamples = numSamples;
+  summary.peak = peak;
+  summary.rms = numSamples > 0 ? std::sqrt(sumSquares / numSamples) : 0.0;
+
+  // Two-stage gating, as for live integrated loudness
+  summary.integratedLoudness =
+      LoudnessMeter::powerToLufs(gatingBlocks.getGatedMeanPower(
+          LoudnessMeter::INTEGRATED_RELATIVE_GATE_LU));
+
+  // Spectral summary
+  const double binWidth = analysisRate / FFT_SIZE;
+  std::array<double, NUM_OCTAVE_BANDS> bandPower{};
+  double totalPower = 0.0, weightedFrequency = 0.0;
+
+  for (size_t bin = 1; bin < powerSum.size(); ++bin) {
+    const double frequency = (double)bin * binWidth;
+    const double power = powerSum[bin];
+
+    totalPower += power;
+    weightedFrequency += power * frequency;
+
+    for (int band = 0; band < NUM_OCTAVE_BANDS; ++band) {
+      const double centre = getOctaveBandCentre(band);
+      if (frequency >= centre / juce::MathConstants<double>::sqrt2 &&
+          frequency < centre * juce::MathConstants<double>::sqrt2) {
+        bandPower[(size_t)band] += power;
+        break;
+      }
+    }
+  }
+
+  summary.spectralCentroid =
+      totalPower > 0.0 ? weightedFrequency / totalPower : 0.0;
+
+  for (int band = 0; band < NUM_OCTAVE_BANDS; ++band) {
+    const double power =
+        numFrames > 0 ? bandPower[(size_t)band] / numFrames / windowPowerNorm
+                      : 0.0;
+    summary.octaveBandLevels[(size_t)band] =
+        power > 0.0 ? 10.0 * std::log10(power)
+                    : -std::numeric_limits<double>::infinity();
+  }
+
+  return summary;
+}
+
+} // namespace mcam
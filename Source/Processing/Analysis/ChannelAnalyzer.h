@@ -0,0 +1,139 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+#include "KWeightingFilterBank.h"
+#include "LoudnessMeter.h"
+#include "PolyphaseDecimator.h"
+
+namespace mcam {
+/**
+ * ChannelAnalyzer accumulates a summary of one channel over an arbitrary
+ * amount of audio: sample peak, RMS, ITU-R BS.1770 integrated loudness and
+ * an averaged spectrum reduced to a centroid and octave band levels.
+ *
+ * Sample peak and RMS are measured at the input rate. At high sample rates
+ * loudness and the spectrum are measured on a copy decimated to 44.1 or
+ * 48 kHz, which keeps the audio band and costs a fraction of the CPU.
+ *
+ * Blocks of any size can be fed; all state needed between blocks is kept,
+ * so the result does not depend on how the audio was split. Not thread
+ * safe - use one analyzer per channel.
+ */
+class ChannelAnalyzer {
+public:
+  /** FFT size used for the spectral summary (2^FFT_ORDER) */
+  static constexpr int FFT_ORDER = 11;
+  static constexpr int FFT_SIZE = 1 << FFT_ORDER;
+
+  /** Octave bands reported, 31.5 Hz to 16 kHz */
+  static constexpr int NUM_OCTAVE_BANDS = 10;
+
+  /** @return Nominal centre frequency of an octave band */
+  static double getOctaveBandCentre(int band);
+
+  /** Result of an analysis */
+  struct Summary {
+    juce::int64 numSamples = 0;
+
+    /** Linear sample peak */
+    double peak = 0.0;
+
+    /** Linear RMS over the whole signal */
+    double rms = 0.0;
+
+    /** Integrated loudness in LUFS (-inf if everything was gated) */
+    double integratedLoudness = -std::numeric_limits<double>::infinity();
+
+    /** Power-weighted mean frequency of the averaged spectrum in Hz */
+    double spectralCentroid = 0.0;
+
+    /** Band levels in dB relative to a full-scale sine in that band */
+    std::array<double, NUM_OCTAVE_BANDS> octaveBandLevels{};
+  };
+
+  /** Constructor */
+  ChannelAnalyzer();
+
+  /**
+   * Resets all state for a new signal
+   * @param sampleRate Sample rate in Hz
+   * @param decimate Measure loudness and the spectrum at a reduced rate
+   * when the sample rate is above 48 kHz
+   */
+  void prepare(double sampleRate, bool decimate = true);
+
+  /** @return Rate loudness and the spectrum are measured at, in Hz */
+  double getAnalysisSampleRate() const;
+
+  /**
+   * Accumulates a block of samples
+   * @param samples Input samples
+   * @param numSamples Number of samples
+   */
+  void process(const float *samples, int numSamples);
+
+  /** @return The summary of everything processed since prepare() */
+  Summary getSummary() const;
+
+private:
+  /** Direct form I biquad in double precision */
+  struct Biquad {
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+
+    double process(double x) {
+      const double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+      x2 = x1;
+      x1 = x;
+      y2 = y1;
+      y1 = y;
+      return y;
+    }
+  };
+
+  /** Computes the BS.1770 K-weighting filters for the analysis rate */
+  void designKWeighting();
+
+  /** Accumulates loudness and spectrum for samples at the analysis rate */
+  void processAnalysisRate(const float *samples, int count);
+
+  /** Runs the FFT on a full frame and accumulates its power spectrum */
+  void accumulateSpectrum();
+
+  double sampleRate = 48000.0;
+  double analysisRate = 48000.0;
+
+  // Band-limited copy for loudness and spectrum at high sample rates
+  PolyphaseDecimator decimator;
+  std::vector<float> decimated;
+
+  // Level
+  juce::int64 numSamples = 0;
+  float peak = 0.0f;
+  double sumSquares = 0.0;
+
+  // Loudness: 100 ms sub-blocks, 400 ms gating blocks with 75% overlap,
+  // gated from a histogram as live loudness is, so memory does not grow
+  // with the length of the signal
+  Biquad shelf, highPass;
+  int subBlockLength = 4800;
+  int subBlockFill = 0;
+  double subBlockPower = 0.0;
+  std::array<double, LoudnessMeter::MOMENTARY_SUB_BLOCKS> recentSubBlocks{};
+  int numSubBlocks = 0;
+  LoudnessHistogram gatingBlocks;
+
+  // Spectrum
+  juce::dsp::FFT fft{FFT_ORDER};
+  std::vector<float> window;
+  std::vector<float> frame;
+  std::vector<float> fftBuffer;
+  std::vector<double> powerSum;
+  int frameFill = 0;
+  int numFrames = 0;
+  double windowPowerNorm = 1.0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelAnalyzer)
+};
+
+} // namespace mcam
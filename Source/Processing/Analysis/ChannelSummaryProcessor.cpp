@@ -0,0 +1,45 @@
+#include "ChannelSummaryProcessor.h"
+
+namespace mcam {
+
+ChannelSummaryProcessor::ChannelSummaryProcessor(int first, int numChannels)
+    : firstChannel(first) {
+  for (int i = 0; i < numChannels; ++i)
+    analyzers.push_back(std::make_unique<ChannelAnalyzer>());
+}
+
+ChannelSummaryProcessor::~ChannelSummaryProcessor() = default;
+
+int ChannelSummaryProcessor::getFirstChannel() const { return firstChannel; }
+
+int ChannelSummaryProcessor::getNumChannels() const {
+  return (int)analyzers.size();
+}
+
+ChannelAnalyzer::Summary ChannelSummaryProcessor::getSummary(int index) const {
+  if (index < 0 || index >= (int)analyzers.size())
+    return {};
+
+  return analyzers[(size_t)index]->getSummary();
+}
+
+void ChannelSummaryProcessor::prepareToPlay(double sampleRate,
+                                            int bufferSize) {
+  AudioCallback::prepareToPlay(sampleRate, bufferSize);
+
+  for (auto &analyzer : analyzers)
+    analyzer->prepare(sampleRate);
+}
+
+void ChannelSummaryProcessor::processAudio(
+    const float *const *inputChannelData, int numInputChannels,
+    int numSamples) {
+  for (size_t i = 0; i < analyzers.size(); ++i) {
+    const int channel = firstChannel + (int)i;
+
+    if (channel < numInputChannels && inputChannelData[channel] != nullptr)
+      analyzers[i]->process(inputChannelData[channel], numSamples);
+  }
+}
+
+} // namespace mcam
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../../Audio/AudioCallback.h"
+#include "../../JuceHeader.h"
+#include "ChannelAnalyzer.h"
+
+namespace mcam {
+/**
+ * ChannelSummaryProcessor is an AudioCallback that runs a ChannelAnalyzer
+ * on each of a contiguous range of input channels. It can be registered with
+ * a device like any other callback, or driven offline through
+ * AudioCallback::prepareOffline()/processOffline().
+ */
+class ChannelSummaryProcessor : public AudioCallback {
+public:
+  /**
+   * Constructor
+   * @param firstChannel First input channel analysed
+   * @param numChannels Number of consecutive channels analysed
+   */
+  ChannelSummaryProcessor(int firstChannel, int numChannels);
+
+  /** Destructor */
+  ~ChannelSummaryProcessor() override;
+
+  /** @return First input channel analysed */
+  int getFirstChannel() const;
+
+  /** @return Number of channels analysed */
+  int getNumChannels() const;
+
+  /**
+   * Gets the summary for one analysed channel. Call when processing has
+   * stopped.
+   * @param index Index within the analysed range (0 = first channel)
+   */
+  ChannelAnalyzer::Summary getSummary(int index) const;
+
+protected:
+  /** Overridden from AudioCallback */
+  void prepareToPlay(double sampleRate, int bufferSize) override;
+  void processAudio(const float *const *inputChannelData, int numInputChannels,
+                    int numSamples) override;
+
+private:
+  const int firstChannel;
+  std::vector<std::unique_ptr<ChannelAnalyzer>> analyzers;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChannelSummaryProcessor)
+};
+
+} // namespace mcam
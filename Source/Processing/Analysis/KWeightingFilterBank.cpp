@@ -0,0 +1,190 @@
+#include "KWeightingFilterBank.h"
+
+namespace mcam {
+
+namespace {
+#if JUCE_USE_SIMD
+using DoubleVector = juce::dsp::SIMDRegister<double>;
+constexpr int VECTOR_SIZE = (int)DoubleVector::SIMDNumElements;
+
+DoubleVector load(const double *source) {
+  return DoubleVector::fromRawArray(source);
+}
+
+void store(const DoubleVector &value, double *dest) {
+  value.copyToRawArray(dest);
+}
+
+DoubleVector broadcast(double value) { return DoubleVector::expand(value); }
+#else
+using DoubleVector = double;
+constexpr int VECTOR_SIZE = 1;
+
+double load(const double *source) { return *source; }
+void store(double value, double *dest) { *dest = value; }
+double broadcast(double value) { return value; }
+#endif
+
+// Samples interleaved and filtered per pass
+constexpr int CHUNK_SIZE = 64;
+
+// Per-lane state arrays: input, shelf output and high-pass output history
+// (two samples each), then the energy
+enum StateArray { X1, X2, Y1, Y2, Z1, Z2, ENERGY, NUM_STATE_ARRAYS };
+} // namespace
+
+std::array<KWeightingFilterBank::Coefficients, 2>
+KWeightingFilterBank::design(double sampleRate) {
+  std::array<Coefficients, 2> result;
+
+  {
+    const double f0 = 1681.974450955533;
+    const double gainDb = 3.999843853973347;
+    const double q = 0.7071752369554196;
+
+    const double k =
+        std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+    const double vh = std::pow(10.0, gainDb / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    const double a0 = 1.0 + k / q + k * k;
+
+    auto &shelf = result[0];
+    shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    shelf.b1 = 2.0 * (k * k - vh) / a0;
+    shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    shelf.a2 = (1.0 - k / q + k * k) / a0;
+  }
+
+  {
+    const double f0 = 38.13547087602444;
+    const double q = 0.5003270373238773;
+
+    const double k =
+        std::tan(juce::MathConstants<double>::pi * f0 / sampleRate);
+    const double a0 = 1.0 + k / q + k * k;
+
+    auto &highPass = result[1];
+    highPass.b0 = 1.0;
+    highPass.b1 = -2.0;
+    highPass.b2 = 1.0;
+    highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+    highPass.a2 = (1.0 - k / q + k * k) / a0;
+  }
+
+  return result;
+}
+
+KWeightingFilterBank::KWeightingFilterBank() = default;
+
+void KWeightingFilterBank::prepare(double sampleRate, int newNumChannels) {
+  sections = design(sampleRate);
+  numChannels = juce::jmax(0, newNumChannels);
+  numLanes = (numChannels + VECTOR_SIZE - 1) / VECTOR_SIZE * VECTOR_SIZE;
+
+  storage.assign(
+      (size_t)((NUM_STATE_ARRAYS + CHUNK_SIZE) * numLanes + VECTOR_SIZE), 0.0);
+#if JUCE_USE_SIMD
+  state = DoubleVector::getNextSIMDAlignedPtr(storage.data());
+#else
+  state = storage.data();
+#endif
+  chunk = state + NUM_STATE_ARRAYS * numLanes;
+}
+
+int KWeightingFilterBank::getNumChannels() const { return numChannels; }
+
+void KWeightingFilterBank::reset() {
+  std::fill(state, state + NUM_STATE_ARRAYS * numLanes, 0.0);
+}
+
+void KWeightingFilterBank::resetChannel(int channel) {
+  if (channel < 0 || channel >= numChannels)
+    return;
+
+  for (int array = 0; array < NUM_STATE_ARRAYS; ++array)
+    state[array * numLanes + channel] = 0.0;
+}
+
+void KWeightingFilterBank::process(const float *const *inputs, int numInputs,
+                                   int startSample, int numSamples) {
+  numInputs = juce::jmin(numInputs, numChannels);
+  const int usedLanes =
+      (numInputs + VECTOR_SIZE - 1) / VECTOR_SIZE * VECTOR_SIZE;
+
+  for (int pos = 0; pos < numSamples; pos += CHUNK_SIZE) {
+    const int count = juce::jmin(CHUNK_SIZE, numSamples - pos);
+
+    // One frame of usedLanes values per sample
+    for (int ch = 0; ch < usedLanes; ++ch) {
+      const float *input = ch < numInputs ? inputs[ch] : nullptr;
+      double *dest = chunk + ch;
+
+      if (input == nullptr) {
+        for (int i = 0; i < count; ++i)
+          dest[i * numLanes] = 0.0;
+      } else {
+        input += startSample + pos;
+
+        for (int i = 0; i < count; ++i)
+          dest[i * numLanes] = input[i];
+      }
+    }
+
+    for (int lane = 0; lane < usedLanes; lane += VECTOR_SIZE)
+      filterLanes(lane, count);
+  }
+}
+
+void KWeightingFilterBank::filterLanes(int firstLane, int numSamples) {
+  const auto &shelf = sections[0];
+  const auto &highPass = sections[1];
+
+  const auto sb0 = broadcast(shelf.b0), sb1 = broadcast(shelf.b1),
+             sb2 = broadcast(shelf.b2), sa1 = broadcast(shelf.a1),
+             sa2 = broadcast(shelf.a2);
+  const auto hb0 = broadcast(highPass.b0), hb1 = broadcast(highPass.b1),
+             hb2 = broadcast(highPass.b2), ha1 = broadcast(highPass.a1),
+             ha2 = broadcast(highPass.a2);
+
+  double *lanes = state + firstLane;
+  auto x1 = load(lanes + X1 * numLanes), x2 = load(lanes + X2 * numLanes);
+  auto y1 = load(lanes + Y1 * numLanes), y2 = load(lanes + Y2 * numLanes);
+  auto z1 = load(lanes + Z1 * numLanes), z2 = load(lanes + Z2 * numLanes);
+  auto energy = load(lanes + ENERGY * numLanes);
+
+  for (int i = 0; i < numSamples; ++i) {
+    const auto x = load(chunk + i * numLanes + firstLane);
+    const auto y = sb0 * x + sb1 * x1 + sb2 * x2 - sa1 * y1 - sa2 * y2;
+    const auto z = hb0 * y + hb1 * y1 + hb2 * y2 - ha1 * z1 - ha2 * z2;
+
+    energy = energy + z * z;
+
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    z2 = z1;
+    z1 = z;
+  }
+
+  store(x1, lanes + X1 * numLanes);
+  store(x2, lanes + X2 * numLanes);
+  store(y1, lanes + Y1 * numLanes);
+  store(y2, lanes + Y2 * numLanes);
+  store(z1, lanes + Z1 * numLanes);
+  store(z2, lanes + Z2 * numLanes);
+  store(energy, lanes + ENERGY * numLanes);
+}
+
+double KWeightingFilterBank::takeEnergy(int channel) {
+  if (channel < 0 || channel >= numChannels)
+    return 0.0;
+
+  auto &energy = state[ENERGY * numLanes + channel];
+  const double result = energy;
+  energy = 0.0;
+  return result;
+}
+
+} // namespace mcam
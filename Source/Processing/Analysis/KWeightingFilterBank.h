@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * KWeightingFilterBank applies the ITU-R BS.1770 K-weighting (a high shelf
+ * followed by a high-pass) to a set of channels and accumulates the energy
+ * of each filtered channel.
+ *
+ * The channels are processed side by side: each vector lane of
+ * juce::dsp::SIMDRegister<double> holds a different channel, so one pass
+ * over a block filters as many channels as the register has lanes. Blocks
+ * are interleaved in short chunks first, which lets every lane's filter
+ * state stay in registers across a chunk.
+ *
+ * Not thread safe; the owner serialises configuration and processing.
+ */
+class KWeightingFilterBank {
+public:
+  /** Coefficients of one biquad section, normalised so a0 = 1 */
+  struct Coefficients {
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+  };
+
+  /**
+   * Designs the two K-weighting sections for any sample rate (BS.1770-4
+   * annex 1)
+   * @param sampleRate Sample rate in Hz
+   * @return The shelf and the high-pass, in processing order
+   */
+  static std::array<Coefficients, 2> design(double sampleRate);
+
+  /** Constructor */
+  KWeightingFilterBank();
+
+  /**
+   * Designs the filters and allocates state, then resets
+   * @param sampleRate Sample rate in Hz
+   * @param numChannels Number of channels filtered side by side
+   */
+  void prepare(double sampleRate, int numChannels);
+
+  /** @return Number of prepared channels */
+  int getNumChannels() const;
+
+  /** Clears the filter state and energy of every channel */
+  void reset();
+
+  /** Clears the filter state and energy of one channel */
+  void resetChannel(int channel);
+
+  /**
+   * Filters a range of each channel and adds the squared output to the
+   * channel's energy
+   * @param inputs One pointer per channel; nullptr is filtered as silence
+   * @param numInputs Channels to process; the rest are left untouched
+   * @param startSample First sample of each input to use
+   * @param numSamples Number of samples
+   */
+  void process(const float *const *inputs, int numInputs, int startSample,
+               int numSamples);
+
+  /**
+   * @return The energy (sum of squares) a channel accumulated since it was
+   * last taken, which is then cleared
+   */
+  double takeEnergy(int channel);
+
+private:
+  /** Filters lanes [firstLane, firstLane + vector size) of a chunk */
+  void filterLanes(int firstLane, int numSamples);
+
+  std::array<Coefficients, 2> sections;
+
+  int numChannels = 0;
+  int numLanes = 0;
+
+  // Per-lane state (x1, x2, y1, y2 of both sections, then energy), each
+  // numLanes long, followed by the interleaved chunk
+  std::vector<double> storage;
+  double *state = nullptr;
+  double *chunk = nullptr;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KWeightingFilterBank)
+};
+
+} // namespace mcam
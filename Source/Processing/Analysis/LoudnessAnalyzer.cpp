@@ -0,0 +1,329 @@
+#include "LoudnessAnalyzer.h"
+
+namespace mcam {
+
+namespace {
+// BS.1770 weight of the surround channels (+1.5 dB)
+constexpr float SURROUND_WEIGHT = 1.41f;
+
+// SMPTE position of the LFE in 5.1 and 7.1 beds
+constexpr int LFE_CHANNEL = 3;
+
+// Input samples decimated at a time; a multiple of every factor
+constexpr int DECIMATION_BLOCK = 4096;
+} // namespace
+
+std::vector<float> LoudnessAnalyzer::getChannelWeights(int numChannels) {
+  std::vector<float> weights((size_t)juce::jmax(0, numChannels), 1.0f);
+
+  if (numChannels == 6 || numChannels == 8) {
+    weights[(size_t)LFE_CHANNEL] = 0.0f;
+
+    for (int ch = LFE_CHANNEL + 1; ch < numChannels; ++ch)
+      weights[(size_t)ch] = SURROUND_WEIGHT;
+  }
+
+  return weights;
+}
+
+LoudnessAnalyzer::LoudnessAnalyzer(int slotCount)
+    : numSlots(juce::jmax(0, slotCount)) {
+  for (int i = 0; i < numSlots; ++i)
+    slots.push_back(std::make_unique<Programme>());
+
+  for (auto &programme : groupProgrammes)
+    programme = std::make_unique<Programme>();
+
+  const size_t numLanes =
+      (size_t)(numSlots + MAX_GROUPS * MAX_GROUP_CHANNELS);
+  lanePointers.resize(numLanes);
+  decimatedPointers.resize(numLanes);
+  pendingPointers.resize(numLanes);
+  decimatedRows.resize(numLanes);
+  pendingRows.resize(numLanes);
+
+  for (size_t lane = 0; lane < numLanes; ++lane)
+    decimators.push_back(std::make_unique<PolyphaseDecimator>());
+
+  prepare(48000.0);
+}
+
+LoudnessAnalyzer::~LoudnessAnalyzer() = default;
+
+void LoudnessAnalyzer::prepare(double sampleRate, bool decimate) {
+  decimationFactor =
+      decimate ? PolyphaseDecimator::getFactorForSampleRate(sampleRate) : 1;
+
+  for (auto &decimator : decimators)
+    decimator->prepare(sampleRate, decimationFactor);
+
+  analysisRate = sampleRate / decimationFactor;
+
+  // Rows are only needed when decimating
+  const size_t numLanes = lanePointers.size();
+  const size_t decimatedSize =
+      decimationFactor > 1 ? (size_t)decimators.front()->getMaxOutputSamples(
+                                 DECIMATION_BLOCK)
+                           : 0;
+  const size_t pendingSize =
+      decimationFactor > 1 ? (size_t)decimationFactor : 0;
+
+  decimatedStorage.assign(decimatedSize * numLanes, 0.0f);
+  pendingStorage.assign(pendingSize * numLanes, 0.0f);
+
+  for (size_t lane = 0; lane < numLanes; ++lane) {
+    decimatedRows[lane] = decimatedStorage.data() + lane * decimatedSize;
+    pendingRows[lane] = pendingStorage.data() + lane * pendingSize;
+  }
+
+  numPending = 0;
+
+  filterBank.prepare(analysisRate, (int)numLanes);
+  subBlockLength = juce::jmax(
+      1, juce::roundToInt(analysisRate * LoudnessMeter::SUB_BLOCK_SECONDS));
+  subBlockFill = 0;
+
+  layoutLanes();
+  resetAll();
+}
+
+bool LoudnessAnalyzer::setGroup(int group, std::vector<int> channels,
+                                std::vector<float> weights) {
+  if (group < 0 || group >= MAX_GROUPS ||
+      (int)channels.size() > MAX_GROUP_CHANNELS)
+    return false;
+
+  if (weights.empty())
+    weights = getChannelWeights((int)channels.size());
+
+  if (weights.size() != channels.size())
+    return false;
+
+  for (size_t i = 0; i < channels.size(); ++i)
+    if (channels[i] < 0 || !(weights[i] >= 0.0f))
+      return false;
+
+  groups[(size_t)group].channels = std::move(channels);
+  groups[(size_t)group].weights = std::move(weights);
+
+  // Groups after this one may move to other lanes; their filters restart
+  // but their measurements carry on
+  std::array<int, MAX_GROUPS> previousLanes;
+  for (int g = 0; g < MAX_GROUPS; ++g)
+    previousLanes[(size_t)g] = groups[(size_t)g].firstLane;
+
+  layoutLanes();
+
+  for (int g = 0; g < MAX_GROUPS; ++g) {
+    const auto &layout = groups[(size_t)g];
+
+    if (g == group || layout.firstLane != previousLanes[(size_t)g])
+      for (size_t c = 0; c < layout.channels.size(); ++c) {
+        filterBank.resetChannel(layout.firstLane + (int)c);
+        decimators[(size_t)layout.firstLane + c]->reset();
+      }
+  }
+
+  auto &programme = *groupProgrammes[(size_t)group];
+  programme.meter.reset();
+  programme.skipSubBlock = subBlockFill > 0;
+  return true;
+}
+
+double LoudnessAnalyzer::getAnalysisRate() const { return analysisRate; }
+
+int LoudnessAnalyzer::getGroupSize(int group) const {
+  if (group < 0 || group >= MAX_GROUPS)
+    return 0;
+
+  return (int)groups[(size_t)group].channels.size();
+}
+
+void LoudnessAnalyzer::layoutLanes() {
+  int lane = numSlots;
+
+  for (auto &group : groups) {
+    group.firstLane = lane;
+    lane += (int)group.channels.size();
+  }
+
+  numActiveLanes = lane;
+}
+
+void LoudnessAnalyzer::resetSlot(int slot) {
+  if (slot < 0 || slot >= numSlots)
+    return;
+
+  auto &programme = *slots[(size_t)slot];
+  programme.meter.reset();
+  programme.skipSubBlock = subBlockFill > 0;
+  filterBank.resetChannel(slot);
+  decimators[(size_t)slot]->reset();
+}
+
+void LoudnessAnalyzer::resetAll() {
+  for (auto &programme : slots) {
+    programme->meter.reset();
+    programme->skipSubBlock = subBlockFill > 0;
+  }
+
+  for (auto &programme : groupProgrammes) {
+    programme->meter.reset();
+    programme->skipSubBlock = subBlockFill > 0;
+  }
+}
+
+void LoudnessAnalyzer::process(const float *const *slotSources,
+                               const float *const *inputChannelData,
+                               int numInputChannels, int numSamples) {
+  for (int slot = 0; slot < numSlots; ++slot) {
+    lanePointers[(size_t)slot] = slotSources[slot];
+
+    if (slotSources[slot] != nullptr)
+      slots[(size_t)slot]->fed = true;
+  }
+
+  for (int g = 0; g < MAX_GROUPS; ++g) {
+    const auto &group = groups[(size_t)g];
+
+    for (size_t c = 0; c < group.channels.size(); ++c) {
+      const int channel = group.channels[c];
+      lanePointers[(size_t)group.firstLane + c] =
+          channel < numInputChannels ? inputChannelData[channel] : nullptr;
+    }
+
+    if (!group.channels.empty())
+      groupProgrammes[(size_t)g]->fed = true;
+  }
+
+  if (decimationFactor == 1) {
+    measure(lanePointers.data(), numSamples);
+    return;
+  }
+
+  int pos = 0;
+
+  // Complete the samples held back from the previous block
+  if (numPending > 0) {
+    pos = juce::jmin(numSamples, decimationFactor - numPending);
+    holdPending(0, pos);
+
+    if (numPending == decimationFactor) {
+      for (int lane = 0; lane < numActiveLanes; ++lane)
+        pendingPointers[(size_t)lane] = pendingRows[(size_t)lane];
+
+      numPending = 0;
+      decimateAndMeasure(pendingPointers.data(), 0, decimationFactor);
+    }
+  }
+
+  const int numWhole =
+      (numSamples - pos) / decimationFactor * decimationFactor;
+
+  for (int done = 0; done < numWhole; done += DECIMATION_BLOCK)
+    decimateAndMeasure(lanePointers.data(), pos + done,
+                       juce::jmin(DECIMATION_BLOCK, numWhole - done));
+
+  pos += numWhole;
+  holdPending(pos, numSamples - pos);
+}
+
+void LoudnessAnalyzer::holdPending(int startSample, int numSamples) {
+  if (numSamples <= 0)
+    return;
+
+  // Lanes without a source hold silence so every lane stays in step
+  for (int lane = 0; lane < numActiveLanes; ++lane) {
+    float *row = pendingRows[(size_t)lane] + numPending;
+
+    if (const float *source = lanePointers[(size_t)lane])
+      juce::FloatVectorOperations::copy(row, source + startSample, numSamples);
+    else
+      juce::FloatVectorOperations::clear(row, numSamples);
+  }
+
+  numPending += numSamples;
+}
+
+void LoudnessAnalyzer::decimateAndMeasure(const float *const *sources,
+                                          int startSample, int numSamples) {
+  jassert(numSamples % decimationFactor == 0 &&
+          numSamples <= DECIMATION_BLOCK);
+  const int numDecimated = numSamples / decimationFactor;
+
+  for (int lane = 0; lane < numActiveLanes; ++lane) {
+    const float *source = sources[lane];
+
+    if (source == nullptr) {
+      decimatedPointers[(size_t)lane] = nullptr;
+      continue;
+    }
+
+    float *row = decimatedRows[(size_t)lane];
+    const int numOutput = decimators[(size_t)lane]->process(
+        source + startSample, numSamples, row);
+    juce::ignoreUnused(numOutput);
+    jassert(numOutput == numDecimated);
+    decimatedPointers[(size_t)lane] = row;
+  }
+
+  measure(decimatedPointers.data(), numDecimated);
+}
+
+void LoudnessAnalyzer::measure(const float *const *sources, int numSamples) {
+  for (int pos = 0; pos < numSamples;) {
+    const int count =
+        juce::jmin(numSamples - pos, subBlockLength - subBlockFill);
+
+    filterBank.process(sources, numActiveLanes, pos, count);
+    pos += count;
+    subBlockFill += count;
+
+    if (subBlockFill == subBlockLength) {
+      finishSubBlock();
+      subBlockFill = 0;
+    }
+  }
+}
+
+void LoudnessAnalyzer::finishSubBlock() {
+  const double length = (double)subBlockLength;
+
+  auto finish = [](Programme &programme, double power) {
+    if (programme.fed && !programme.skipSubBlock)
+      programme.meter.addSubBlock(power);
+
+    programme.fed = false;
+    programme.skipSubBlock = false;
+  };
+
+  for (int slot = 0; slot < numSlots; ++slot)
+    finish(*slots[(size_t)slot], filterBank.takeEnergy(slot) / length);
+
+  for (int g = 0; g < MAX_GROUPS; ++g) {
+    const auto &group = groups[(size_t)g];
+    double power = 0.0;
+
+    for (size_t c = 0; c < group.channels.size(); ++c)
+      power += group.weights[c] *
+               filterBank.takeEnergy(group.firstLane + (int)c) / length;
+
+    finish(*groupProgrammes[(size_t)g], power);
+  }
+}
+
+LoudnessMeter::Reading LoudnessAnalyzer::getSlotReading(int slot) const {
+  if (slot < 0 || slot >= numSlots)
+    return {};
+
+  return slots[(size_t)slot]->meter.getReading();
+}
+
+LoudnessMeter::Reading LoudnessAnalyzer::getGroupReading(int group) const {
+  if (group < 0 || group >= MAX_GROUPS)
+    return {};
+
+  return groupProgrammes[(size_t)group]->meter.getReading();
+}
+
+} // namespace mcam
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+#include "KWeightingFilterBank.h"
+#include "LoudnessMeter.h"
+#include "PolyphaseDecimator.h"
+
+namespace mcam {
+/**
+ * LoudnessAnalyzer measures EBU R128 loudness for each monitoring slot and
+ * for up to MAX_GROUPS multichannel groups (e.g. a 5.1 bed) of input
+ * channels.
+ *
+ * Every measured channel (the slot sources, then the channels of each
+ * group) shares one KWeightingFilterBank, so all of them are filtered in
+ * one vectorised pass per block. Every 100 ms the filtered energies are
+ * handed to one LoudnessMeter per slot and per group; a group's meter gets
+ * the sum of its channels' energies with their BS.1770 weights.
+ *
+ * Above 48 kHz every lane is first brought down to 44.1 or 48 kHz by its
+ * own PolyphaseDecimator, as in ChannelAnalyzer; K-weighting does not need
+ * the content above 20 kHz. Peaks are measured elsewhere at the full rate.
+ *
+ * A new slot source or group definition starts a new measurement at the
+ * next 100 ms boundary. Not thread safe except for the readings; the owner
+ * serialises configuration against process().
+ */
+class LoudnessAnalyzer {
+public:
+  /** Number of multichannel groups */
+  static constexpr int MAX_GROUPS = 4;
+
+  /** Most channels in one group (7.1.4 needs 12) */
+  static constexpr int MAX_GROUP_CHANNELS = 16;
+
+  /**
+   * BS.1770 channel weights for a bed in SMPTE order: 5.1 and 7.1 drop the
+   * LFE and weight the surrounds by +1.5 dB; anything else weights every
+   * channel equally.
+   * @param numChannels Number of channels in the group
+   */
+  static std::vector<float> getChannelWeights(int numChannels);
+
+  /**
+   * Constructor
+   * @param numSlots Number of monitoring slots measured
+   */
+  explicit LoudnessAnalyzer(int numSlots);
+
+  /** Destructor */
+  ~LoudnessAnalyzer();
+
+  /**
+   * Allocates state and starts new measurements everywhere
+   * @param sampleRate Sample rate in Hz
+   * @param decimate Measure at 44.1 or 48 kHz when the rate is higher
+   */
+  void prepare(double sampleRate, bool decimate = true);
+
+  /** @return The rate the K-weighting runs at, in Hz */
+  double getAnalysisRate() const;
+
+  /**
+   * Defines a group. Allocates; call with the audio thread held off.
+   * @param group Group index (0 to MAX_GROUPS - 1)
+   * @param channels Input channels of the group; empty clears it
+   * @param weights Weight per channel, or empty for getChannelWeights()
+   * @return false if the group, a channel or the weights are invalid
+   */
+  bool setGroup(int group, std::vector<int> channels,
+                std::vector<float> weights = {});
+
+  /** @return Number of channels in a group, 0 if it is not defined */
+  int getGroupSize(int group) const;
+
+  /** Starts a new measurement for a slot, e.g. when its source changes */
+  void resetSlot(int slot);
+
+  /** Starts new measurements for every slot and group */
+  void resetAll();
+
+  /**
+   * Measures one block
+   * @param slotSources Source samples per slot, nullptr if a slot is unused
+   * @param inputChannelData Input channel data for the groups
+   * @param numInputChannels Number of input channels
+   * @param numSamples Number of samples in the block
+   */
+  void process(const float *const *slotSources,
+               const float *const *inputChannelData, int numInputChannels,
+               int numSamples);
+
+  /** @return The latest readings of a slot; safe from any thread */
+  LoudnessMeter::Reading getSlotReading(int slot) const;
+
+  /** @return The latest readings of a group; safe from any thread */
+  LoudnessMeter::Reading getGroupReading(int group) const;
+
+private:
+  /** A measured programme: its meter and how its lanes are being fed */
+  struct Programme {
+    LoudnessMeter meter;
+
+    // The current sub-block started before a reset and is discarded
+    bool skipSubBlock = false;
+
+    // Whether a source fed the programme during the current sub-block
+    bool fed = false;
+  };
+
+  struct Group {
+    std::vector<int> channels;
+    std::vector<float> weights;
+    int firstLane = 0;
+  };
+
+  /** Packs the groups' lanes after the slot lanes */
+  void layoutLanes();
+
+  /** Holds samples of every lane until a whole factor's worth is there */
+  void holdPending(int startSample, int numSamples);
+
+  /**
+   * Decimates every lane and measures the result
+   * @param sources Samples per lane, nullptr for silent lanes
+   * @param startSample First sample to use
+   * @param numSamples A multiple of the factor, at most DECIMATION_BLOCK
+   */
+  void decimateAndMeasure(const float *const *sources, int startSample,
+                          int numSamples);
+
+  /** K-weights analysis-rate samples of every lane */
+  void measure(const float *const *sources, int numSamples);
+
+  /** Hands a completed sub-block to the meters */
+  void finishSubBlock();
+
+  const int numSlots;
+  std::vector<std::unique_ptr<Programme>> slots;
+  std::array<std::unique_ptr<Programme>, MAX_GROUPS> groupProgrammes;
+  std::array<Group, MAX_GROUPS> groups;
+
+  KWeightingFilterBank filterBank;
+  std::vector<const float *> lanePointers;
+  int numActiveLanes = 0;
+
+  // Decimators are only ever fed whole multiples of the factor, so every
+  // one of them stays in the same phase whichever lanes are silent or
+  // reset; the rest of a block waits in pendingRows
+  std::vector<std::unique_ptr<PolyphaseDecimator>> decimators;
+  std::vector<float> decimatedStorage, pendingStorage;
+  std::vector<float *> decimatedRows, pendingRows;
+  std::vector<const float *> decimatedPointers, pendingPointers;
+  int decimationFactor = 1;
+  int numPending = 0;
+  double analysisRate = 48000.0;
+
+  // Position in the current 100 ms sub-block
+  int subBlockLength = 4800;
+  int subBlockFill = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessAnalyzer)
+};
+
+} // namespace mcam
@@ -0,0 +1,179 @@
+#include "LoudnessMeter.h"
+
+namespace mcam {
+
+namespace {
+// EBU Tech 3342 relative gate and percentiles for the loudness range
+constexpr double RANGE_RELATIVE_GATE_LU = -20.0;
+constexpr double RANGE_LOW_PERCENTILE = 0.10;
+constexpr double RANGE_HIGH_PERCENTILE = 0.95;
+
+constexpr int NUM_BINS = (int)((LoudnessHistogram::MAX_LUFS -
+                                LoudnessHistogram::MIN_LUFS) /
+                                   LoudnessHistogram::BIN_WIDTH_LU +
+                               0.5);
+
+constexpr double NEGATIVE_INFINITY = -std::numeric_limits<double>::infinity();
+} // namespace
+
+//==============================================================================
+LoudnessHistogram::LoudnessHistogram()
+    : counts((size_t)NUM_BINS), powers((size_t)NUM_BINS) {}
+
+void LoudnessHistogram::clear() {
+  std::fill(counts.begin(), counts.end(), 0u);
+  std::fill(powers.begin(), powers.end(), 0.0);
+  numBlocks = 0;
+  totalPower = 0.0;
+}
+
+int LoudnessHistogram::getBin(double lufs) {
+  return juce::jlimit(0, NUM_BINS - 1,
+                      (int)std::floor((lufs - MIN_LUFS) / BIN_WIDTH_LU));
+}
+
+void LoudnessHistogram::add(double power) {
+  const double lufs = LoudnessMeter::powerToLufs(power);
+
+  if (!(lufs > MIN_LUFS))
+    return; // Absolute gate
+
+  const auto bin = (size_t)getBin(lufs);
+  ++counts[bin];
+  powers[bin] += power;
+  ++numBlocks;
+  totalPower += power;
+}
+
+juce::int64 LoudnessHistogram::getNumBlocks() const { return numBlocks; }
+
+int LoudnessHistogram::getFirstGatedBin(double relativeGateLU) const {
+  const double gate =
+      LoudnessMeter::powerToLufs(totalPower / (double)numBlocks) +
+      relativeGateLU;
+
+  if (gate <= MIN_LUFS)
+    return 0;
+
+  // The bin holding the gate is kept if its blocks are louder on average
+  const int bin = getBin(gate);
+  const auto index = (size_t)bin;
+
+  if (counts[index] > 0 &&
+      LoudnessMeter::powerToLufs(powers[index] / counts[index]) > gate)
+    return bin;
+
+  return bin + 1;
+}
+
+double LoudnessHistogram::getGatedMeanPower(double relativeGateLU) const {
+  if (numBlocks == 0)
+    return 0.0;
+
+  juce::int64 count = 0;
+  double power = 0.0;
+
+  for (int bin = getFirstGatedBin(relativeGateLU); bin < NUM_BINS; ++bin) {
+    count += counts[(size_t)bin];
+    power += powers[(size_t)bin];
+  }
+
+  return count > 0 ? power / (double)count : 0.0;
+}
+
+double LoudnessHistogram::getGatedPercentile(double relativeGateLU,
+                                             double fraction) const {
+  if (numBlocks == 0)
+    return NEGATIVE_INFINITY;
+
+  const int firstBin = getFirstGatedBin(relativeGateLU);
+  juce::int64 gatedCount = 0;
+
+  for (int bin = firstBin; bin < NUM_BINS; ++bin)
+    gatedCount += counts[(size_t)bin];
+
+  if (gatedCount == 0)
+    return NEGATIVE_INFINITY;
+
+  // Index of the value in the sorted gated blocks, as in Tech 3342
+  const auto target = (juce::int64)std::round(
+      juce::jlimit(0.0, 1.0, fraction) * (double)(gatedCount - 1));
+  juce::int64 seen = 0;
+
+  for (int bin = firstBin; bin < NUM_BINS; ++bin) {
+    seen += counts[(size_t)bin];
+
+    if (seen > target)
+      return MIN_LUFS + (bin + 0.5) * BIN_WIDTH_LU;
+  }
+
+  return MAX_LUFS;
+}
+
+//==============================================================================
+double LoudnessMeter::powerToLufs(double power) {
+  return power > 0.0 ? -0.691 + 10.0 * std::log10(power) : NEGATIVE_INFINITY;
+}
+
+LoudnessMeter::LoudnessMeter() { reset(); }
+
+void LoudnessMeter::reset() {
+  recent.fill(0.0);
+  numSubBlocks = 0;
+  blockHistogram.clear();
+  shortTermHistogram.clear();
+
+  momentary.store(NEGATIVE_INFINITY, std::memory_order_relaxed);
+  shortTerm.store(NEGATIVE_INFINITY, std::memory_order_relaxed);
+  integrated.store(NEGATIVE_INFINITY, std::memory_order_relaxed);
+  loudnessRange.store(0.0, std::memory_order_relaxed);
+}
+
+double LoudnessMeter::getRecentPower(int count) const {
+  double sum = 0.0;
+
+  for (int i = 1; i <= count; ++i)
+    sum += recent[(size_t)((numSubBlocks - i) % SHORT_TERM_SUB_BLOCKS)];
+
+  return sum / count;
+}
+
+void LoudnessMeter::addSubBlock(double power) {
+  recent[(size_t)(numSubBlocks % SHORT_TERM_SUB_BLOCKS)] = power;
+  ++numSubBlocks;
+
+  if (numSubBlocks >= MOMENTARY_SUB_BLOCKS) {
+    const double blockPower = getRecentPower(MOMENTARY_SUB_BLOCKS);
+    blockHistogram.add(blockPower);
+
+    momentary.store(powerToLufs(blockPower), std::memory_order_relaxed);
+    integrated.store(powerToLufs(blockHistogram.getGatedMeanPower(
+                         INTEGRATED_RELATIVE_GATE_LU)),
+                     std::memory_order_relaxed);
+  }
+
+  if (numSubBlocks >= SHORT_TERM_SUB_BLOCKS) {
+    const double shortTermPower = getRecentPower(SHORT_TERM_SUB_BLOCKS);
+    shortTermHistogram.add(shortTermPower);
+
+    shortTerm.store(powerToLufs(shortTermPower), std::memory_order_relaxed);
+
+    const double low = shortTermHistogram.getGatedPercentile(
+        RANGE_RELATIVE_GATE_LU, RANGE_LOW_PERCENTILE);
+    const double high = shortTermHistogram.getGatedPercentile(
+        RANGE_RELATIVE_GATE_LU, RANGE_HIGH_PERCENTILE);
+    loudnessRange.store(std::isfinite(low) ? high - low : 0.0,
+                        std::memory_order_relaxed);
+  }
+}
+
+LoudnessMeter::Reading LoudnessMeter::getReading() const {
+  Reading reading;
+  reading.momentary = momentary.load(std::memory_order_relaxed);
+  reading.shortTerm = shortTerm.load(std::memory_order_relaxed);
+  reading.integrated = integrated.load(std::memory_order_relaxed);
+  reading.loudnessRange = loudnessRange.load(std::memory_order_relaxed);
+  return reading;
+}
+
+} // namespace mcam
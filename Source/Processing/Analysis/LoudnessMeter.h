@@ -0,0 +1,145 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * LoudnessHistogram holds a distribution of block loudness values in fixed
+ * bins of BIN_WIDTH_LU, together with the exact power summed in each bin.
+ * Its size does not depend on how many blocks were added, so gated means
+ * and percentiles over a 24-hour programme cost the same as over a minute.
+ *
+ * Blocks at or below the BS.1770 absolute gate of -70 LUFS are not stored.
+ * Gated means are exact except for the blocks in the one bin the relative
+ * gate falls into, which are kept or dropped together.
+ */
+class LoudnessHistogram {
+public:
+  /** Lowest and highest loudness binned; louder blocks go in the top bin */
+  static constexpr double MIN_LUFS = -70.0;
+  static constexpr double MAX_LUFS = 20.0;
+
+  /** Bin width in LU */
+  static constexpr double BIN_WIDTH_LU = 0.02;
+
+  /** Constructor */
+  LoudnessHistogram();
+
+  /** Removes all blocks */
+  void clear();
+
+  /**
+   * Adds a block
+   * @param power Weighted mean square of the block (see powerToLufs)
+   */
+  void add(double power);
+
+  /** @return Number of blocks above the absolute gate */
+  juce::int64 getNumBlocks() const;
+
+  /**
+   * @param relativeGateLU Gate relative to the mean of all blocks, in LU
+   * @return Mean power of the blocks above both gates, or 0 if none
+   */
+  double getGatedMeanPower(double relativeGateLU) const;
+
+  /**
+   * @param relativeGateLU Gate relative to the mean of all blocks, in LU
+   * @param fraction Fraction of the gated blocks below the result (0 to 1)
+   * @return Loudness at that point of the gated distribution in LUFS, or
+   * -inf if no block passes the gates
+   */
+  double getGatedPercentile(double relativeGateLU, double fraction) const;
+
+private:
+  /** @return The bin a loudness value falls into */
+  static int getBin(double lufs);
+
+  /** @return The first bin above the relative gate */
+  int getFirstGatedBin(double relativeGateLU) const;
+
+  std::vector<juce::uint32> counts;
+  std::vector<double> powers;
+  juce::int64 numBlocks = 0;
+  double totalPower = 0.0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessHistogram)
+};
+
+/**
+ * LoudnessMeter derives EBU R128 loudness from the K-weighted power of a
+ * programme (one channel or a weighted group) in 100 ms sub-blocks:
+ *
+ *  - momentary: the last 400 ms
+ *  - short-term: the last 3 s
+ *  - integrated: every 400 ms block since reset, 75% overlapped, with the
+ *    BS.1770 gates (-70 LUFS absolute, -10 LU relative)
+ *  - loudness range: EBU Tech 3342, the spread between the 10th and 95th
+ *    percentiles of short-term values sampled every 100 ms (-20 LU
+ *    relative gate)
+ *
+ * The integrated and range statistics come from LoudnessHistograms, so
+ * memory and CPU stay constant however long the programme runs.
+ *
+ * addSubBlock() is called from one thread; readings can be read from any
+ * thread.
+ */
+class LoudnessMeter {
+public:
+  /** Length of one sub-block in seconds */
+  static constexpr double SUB_BLOCK_SECONDS = 0.1;
+
+  /** Sub-blocks per momentary and short-term window */
+  static constexpr int MOMENTARY_SUB_BLOCKS = 4;
+  static constexpr int SHORT_TERM_SUB_BLOCKS = 30;
+
+  /** BS.1770 relative gate for integrated loudness, in LU */
+  static constexpr double INTEGRATED_RELATIVE_GATE_LU = -10.0;
+
+  /** Loudness values in LUFS (LU for the range); -inf until available */
+  struct Reading {
+    double momentary = -std::numeric_limits<double>::infinity();
+    double shortTerm = -std::numeric_limits<double>::infinity();
+    double integrated = -std::numeric_limits<double>::infinity();
+    double loudnessRange = 0.0;
+  };
+
+  /**
+   * @param power Weighted mean square of the K-weighted signal
+   * @return Loudness in LUFS, -inf for silence
+   */
+  static double powerToLufs(double power);
+
+  /** Constructor */
+  LoudnessMeter();
+
+  /** Starts a new measurement */
+  void reset();
+
+  /**
+   * Adds one sub-block and updates the readings
+   * @param power Mean square of the K-weighted sub-block, summed over
+   * channels with their BS.1770 weights
+   */
+  void addSubBlock(double power);
+
+  /** @return The latest readings */
+  Reading getReading() const;
+
+private:
+  /** @return Mean power of the newest count sub-blocks */
+  double getRecentPower(int count) const;
+
+  // Newest sub-block powers, a ring of SHORT_TERM_SUB_BLOCKS
+  std::array<double, SHORT_TERM_SUB_BLOCKS> recent{};
+  juce::int64 numSubBlocks = 0;
+
+  LoudnessHistogram blockHistogram, shortTermHistogram;
+
+  // Published readings
+  std::atomic<double> momentary, shortTerm, integrated, loudnessRange;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessMeter)
+};
+
+} // namespace mcam
@@ -0,0 +1,319 @@
+#include "OfflineAnalyzer.h"
+#include "ChannelSummaryProcessor.h"
+
+namespace mcam {
+
+namespace {
+// Read-ahead for formats that cannot be memory mapped
+constexpr int STREAM_BUFFER_BYTES = 1 << 18;
+
+double gainToDb(double gain) {
+  return gain > 0.0 ? 20.0 * std::log10(gain)
+                    : -std::numeric_limits<double>::infinity();
+}
+
+juce::String formatNumber(double value, int decimals) {
+  if (std::isinf(value))
+    return value < 0.0 ? "-inf" : "inf";
+  return juce::String(value, decimals);
+}
+
+juce::String bandName(int band) {
+  const double centre = ChannelAnalyzer::getOctaveBandCentre(band);
+  return juce::String(centre, centre == std::floor(centre) ? 0 : 1);
+}
+
+juce::var toVar(double value) {
+  // JSON has no infinities; silence is reported as null
+  return std::isfinite(value) ? juce::var(value) : juce::var();
+}
+
+/**
+ * The decoded block of one file and the channel groups analysing it. Any
+ * thread may claim a group of the current block; the file's job claims
+ * whatever helper jobs have not, so it never waits on a queued job. Helper
+ * jobs that start late find nothing to claim, and share ownership so they
+ * may outlive the file's job.
+ */
+struct SharedBlock {
+  std::vector<std::unique_ptr<ChannelSummaryProcessor>> groups;
+  std::vector<float *> channelPointers;
+  int numSamples = 0;
+  std::atomic<int> nextGroup{0};
+  std::atomic<int> groupsDone{0};
+  juce::WaitableEvent blockDone;
+
+  /** Analyses unclaimed groups of the current block */
+  void analyseGroups() {
+    const int numGroups = (int)groups.size();
+
+    for (int group = nextGroup++; group < numGroups; group = nextGroup++) {
+      groups[(size_t)group]->processOffline(channelPointers.data(),
+                                            (int)channelPointers.size(),
+                                            numSamples);
+
+      if (++groupsDone == numGroups)
+        blockDone.signal();
+    }
+  }
+};
+} // namespace
+
+OfflineAnalyzer::OfflineAnalyzer(int threads)
+    : numThreads(threads > 0 ? threads : juce::SystemStats::getNumCpus()) {
+  formatManager.registerBasicFormats();
+}
+
+OfflineAnalyzer::~OfflineAnalyzer() = default;
+
+std::unique_ptr<juce::AudioFormatReader>
+OfflineAnalyzer::createReader(const juce::File &file) const {
+  for (int i = 0; i < formatManager.getNumKnownFormats(); ++i) {
+    auto *format = formatManager.getKnownFormat(i);
+
+    if (!format->canHandleFile(file))
+      continue;
+
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(
+        format->createMemoryMappedReader(file));
+
+    if (mapped != nullptr && mapped->mapEntireFile())
+      return mapped;
+
+    if (auto stream = file.createInputStream()) {
+      std::unique_ptr<juce::AudioFormatReader> reader(format->createReaderFor(
+          new juce::BufferedInputStream(stream.release(), STREAM_BUFFER_BYTES,
+                                        true),
+          true));
+
+      if (reader != nullptr)
+        return reader;
+    }
+  }
+
+  return nullptr;
+}
+
+OfflineAnalyzer::Report
+OfflineAnalyzer::analyze(const juce::Array<juce::File> &files) {
+  Report report;
+  const auto startTicks = juce::Time::getHighResolutionTicks();
+
+  // Probe the files and split them into channel groups
+  std::vector<Job> jobs;
+  const int numFilesRequested = juce::jmax(1, files.size());
+  const int groupsPerFile =
+      juce::jmax(1, (numThreads + numFilesRequested - 1) / numFilesRequested);
+
+  for (int fileIndex = 0; fileIndex < files.size(); ++fileIndex) {
+    auto reader = createReader(files[fileIndex]);
+
+    if (reader == nullptr || reader->numChannels == 0) {
+      report.errors.add(files[fileIndex].getFullPathName() +
+                        ": unsupported or unreadable file");
+      continue;
+    }
+
+    const int numChannels = (int)reader->numChannels;
+    const double seconds = reader->lengthInSamples / reader->sampleRate;
+
+    ++report.numFiles;
+    report.audioSeconds += seconds;
+    report.channelSeconds += seconds * numChannels;
+
+    Job job;
+    job.fileIndex = fileIndex;
+    job.numGroups = juce::jmin(groupsPerFile, numChannels);
+    jobs.push_back(std::move(job));
+  }
+
+  LOG_INFO("Offline analysis of " + juce::String(report.numFiles) +
+           " file(s) in up to " + juce::String(groupsPerFile) +
+           " channel group(s) each on " + juce::String(numThreads) +
+           " thread(s)");
+
+  // Run every job on the pool
+  {
+    juce::ThreadPool pool(numThreads);
+    std::atomic<int> jobsRemaining{(int)jobs.size()};
+    juce::WaitableEvent allDone;
+
+    for (auto &job : jobs) {
+      pool.addJob([this, &files, &job, &pool, &jobsRemaining, &allDone] {
+        ThreadTuning::getInstance().applyToCurrentThread(
+            ThreadTuning::ThreadClass::analysis);
+        runJob(files[job.fileIndex], job, pool);
+
+        if (--jobsRemaining == 0)
+          allDone.signal();
+      });
+    }
+
+    if (!jobs.empty())
+      allDone.wait();
+  }
+
+  // Collect results in file and channel order
+  for (auto &job : jobs) {
+    if (job.error.isNotEmpty()) {
+      report.errors.add(job.error);
+      continue;
+    }
+
+    for (auto &result : job.results)
+      report.channels.push_back(std::move(result));
+  }
+
+  report.wallSeconds = juce::Time::highResolutionTicksToSeconds(
+      juce::Time::getHighResolutionTicks() - startTicks);
+
+  if (report.wallSeconds > 0.0)
+    report.realtimeMultiple = report.audioSeconds / report.wallSeconds;
+
+  LOG_INFO("Offline analysis finished: " +
+           juce::String(report.audioSeconds, 1) + " s of audio in " +
+           juce::String(report.wallSeconds, 2) + " s (" +
+           juce::String(report.realtimeMultiple, 1) + "x real time)");
+
+  return report;
+}
+
+void OfflineAnalyzer::runJob(const juce::File &file, Job &job,
+                             juce::ThreadPool &pool) const {
+  auto reader = createReader(file);
+
+  if (reader == nullptr) {
+    job.error = file.getFullPathName() + ": could not be reopened";
+    return;
+  }
+
+  // Every channel is decoded once, into one buffer all groups read
+  const int numFileChannels = (int)reader->numChannels;
+  juce::AudioBuffer<float> buffer(numFileChannels, BLOCK_SIZE);
+
+  auto shared = std::make_shared<SharedBlock>();
+  for (int ch = 0; ch < numFileChannels; ++ch)
+    shared->channelPointers.push_back(buffer.getWritePointer(ch));
+
+  const int groupSize = (numFileChannels + job.numGroups - 1) / job.numGroups;
+
+  for (int first = 0; first < numFileChannels; first += groupSize) {
+    shared->groups.push_back(std::make_unique<ChannelSummaryProcessor>(
+        first, juce::jmin(groupSize, numFileChannels - first)));
+    shared->groups.back()->prepareOffline(reader->sampleRate, BLOCK_SIZE);
+  }
+
+  const int numGroups = (int)shared->groups.size();
+
+  for (juce::int64 position = 0; position < reader->lengthInSamples;
+       position += BLOCK_SIZE) {
+    const int numSamples = (int)juce::jmin(
+        (juce::int64)BLOCK_SIZE, reader->lengthInSamples - position);
+
+    if (!reader->read(shared->channelPointers.data(), numFileChannels,
+                      position, numSamples)) {
+      job.error = file.getFullPathName() + ": read error at sample " +
+                  juce::String(position);
+      return;
+    }
+
+    // Open the block for claiming, then let helpers and this job analyse it
+    shared->numSamples = numSamples;
+    shared->groupsDone = 0;
+    shared->nextGroup = 0;
+
+    for (int helper = 1; helper < numGroups; ++helper) {
+      pool.addJob([shared] {
+        ThreadTuning::getInstance().applyToCurrentThread(
+            ThreadTuning::ThreadClass::analysis);
+        shared->analyseGroups();
+      });
+    }
+
+    shared->analyseGroups();
+    shared->blockDone.wait();
+  }
+
+  for (auto &group : shared->groups) {
+    for (int i = 0; i < group->getNumChannels(); ++i) {
+      ChannelResult result;
+      result.file = file;
+      result.channel = group->getFirstChannel() + i;
+      result.sampleRate = reader->sampleRate;
+      result.summary = group->getSummary(i);
+      job.results.push_back(std::move(result));
+    }
+
+    group->releaseOffline();
+  }
+}
+
+juce::String OfflineAnalyzer::Report::toCsv() const {
+  juce::String csv;
+  csv << "file,channel,sample_rate,duration_s,peak_dbfs,rms_dbfs,"
+         "integrated_lufs,spectral_centroid_hz";
+
+  for (int band = 0; band < ChannelAnalyzer::NUM_OCTAVE_BANDS; ++band)
+    csv << ",band_" << bandName(band) << "_db";
+
+  csv << "\n";
+
+  for (const auto &result : channels) {
+    const auto &s = result.summary;
+
+    csv << result.file.getFullPathName().quoted() << "," << result.channel + 1
+        << "," << formatNumber(result.sampleRate, 0) << ","
+        << formatNumber(s.numSamples / result.sampleRate, 3) << ","
+        << formatNumber(gainToDb(s.peak), 2) << ","
+        << formatNumber(gainToDb(s.rms), 2) << ","
+        << formatNumber(s.integratedLoudness, 2) << ","
+        << formatNumber(s.spectralCentroid, 1);
+
+    for (auto level : s.octaveBandLevels)
+      csv << "," << formatNumber(level, 2);
+
+    csv << "\n";
+  }
+
+  return csv;
+}
+
+juce::String OfflineAnalyzer::Report::toJson() const {
+  juce::Array<juce::var> channelList;
+
+  for (const auto &result : channels) {
+    const auto &s = result.summary;
+    auto *object = new juce::DynamicObject();
+
+    object->setProperty("file", result.file.getFullPathName());
+    object->setProperty("channel", result.channel + 1);
+    object->setProperty("sample_rate", result.sampleRate);
+    object->setProperty("duration_s", s.numSamples / result.sampleRate);
+    object->setProperty("peak_dbfs", toVar(gainToDb(s.peak)));
+    object->setProperty("rms_dbfs", toVar(gainToDb(s.rms)));
+    object->setProperty("integrated_lufs", toVar(s.integratedLoudness));
+    object->setProperty("spectral_centroid_hz", s.spectralCentroid);
+
+    auto *bands = new juce::DynamicObject();
+    for (int band = 0; band < ChannelAnalyzer::NUM_OCTAVE_BANDS; ++band) {
+      bands->setProperty(bandName(band),
+                         toVar(s.octaveBandLevels[(size_t)band]));
+    }
+    object->setProperty("octave_bands_db", juce::var(bands));
+
+    channelList.add(juce::var(object));
+  }
+
+  auto *root = new juce::DynamicObject();
+  root->setProperty("files", numFiles);
+  root->setProperty("audio_seconds", audioSeconds);
+  root->setProperty("channel_seconds", channelSeconds);
+  root->setProperty("wall_seconds", wallSeconds);
+  root->setProperty("realtime_multiple", realtimeMultiple);
+  root->setProperty("errors", juce::var(errors));
+  root->setProperty("channels", channelList);
+
+  return juce::JSON::toString(juce::var(root));
+}
+
+} // namespace mcam
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../Core/ThreadTuning.h"
+#include "../../JuceHeader.h"
+#include "ChannelAnalyzer.h"
+
+namespace mcam {
+/**
+ * OfflineAnalyzer runs recordings through the analysis chain faster than
+ * real time, without an audio device.
+ *
+ * Every file is a job on a thread pool that decodes it once, block by
+ * block. When there are more threads than files, each file's channels are
+ * also split into groups, and the groups of every decoded block are
+ * analysed in parallel by helper jobs and the file's own job, so both many
+ * small files and a few wide files use all cores. WAV and AIFF files are
+ * memory mapped; other formats are streamed. Each group drives a
+ * ChannelSummaryProcessor through the same AudioCallback entry points a
+ * device uses.
+ */
+class OfflineAnalyzer {
+public:
+  /** Samples read and processed per block */
+  static constexpr int BLOCK_SIZE = 8192;
+
+  /** Result for one channel of one file */
+  struct ChannelResult {
+    juce::File file;
+    int channel = 0;
+    double sampleRate = 0.0;
+    ChannelAnalyzer::Summary summary;
+  };
+
+  /** Results of a run */
+  struct Report {
+    /** Per-channel results, in file order then channel order */
+    std::vector<ChannelResult> channels;
+
+    /** Files that could not be analysed, with the reason */
+    juce::StringArray errors;
+
+    int numFiles = 0;
+
+    /** Total duration of the analysed files */
+    double audioSeconds = 0.0;
+
+    /** Total duration times channel count */
+    double channelSeconds = 0.0;
+
+    double wallSeconds = 0.0;
+
+    /** audioSeconds / wallSeconds */
+    double realtimeMultiple = 0.0;
+
+    /** @return One CSV row per channel, with a header row */
+    juce::String toCsv() const;
+
+    /** @return The whole report as a JSON document */
+    juce::String toJson() const;
+  };
+
+  /**
+   * Constructor
+   * @param numThreads Worker threads (0 = one per CPU core)
+   */
+  explicit OfflineAnalyzer(int numThreads = 0);
+
+  /** Destructor */
+  ~OfflineAnalyzer();
+
+  /**
+   * Analyses the files. Blocks until all jobs have finished.
+   * @param files Audio files in any format JUCE can read
+   * @return Per-channel results and throughput
+   */
+  Report analyze(const juce::Array<juce::File> &files);
+
+private:
+  /** One file and the number of channel groups it is analysed in */
+  struct Job {
+    int fileIndex = 0;
+    int numGroups = 1;
+    std::vector<ChannelResult> results;
+    juce::String error;
+  };
+
+  /** Opens a reader, memory mapped where the format supports it */
+  std::unique_ptr<juce::AudioFormatReader>
+  createReader(const juce::File &file) const;
+
+  /**
+   * Runs one job on a worker thread
+   * @param pool Pool the job runs on, which also runs its helper jobs
+   */
+  void runJob(const juce::File &file, Job &job, juce::ThreadPool &pool) const;
+
+  const int numThreads;
+  juce::AudioFormatManager formatManager;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OfflineAnalyzer)
+};
+
+} // namespace mcam
@@ -0,0 +1,293 @@
+#include "PolyphaseDecimator.h"
+
+namespace mcam {
+
+namespace {
+#if JUCE_USE_SIMD
+using FloatVector = juce::dsp::SIMDRegister<float>;
+constexpr int VECTOR_SIZE = (int)FloatVector::SIMDNumElements;
+#else
+constexpr int VECTOR_SIZE = 1;
+#endif
+
+/** Zeroth-order modified Bessel function of the first kind */
+double besselI0(double x) {
+  double sum = 1.0, term = 1.0;
+
+  for (int k = 1; k < 100 && term > sum * 1.0e-12; ++k) {
+    const double factor = x / (2.0 * k);
+    term *= factor * factor;
+    sum += term;
+  }
+
+  return sum;
+}
+
+int roundUpToVectorSize(int n) {
+  return (n + VECTOR_SIZE - 1) / VECTOR_SIZE * VECTOR_SIZE;
+}
+
+/** @return The first element of storage that is aligned for vector loads */
+float *getAlignedStart(std::vector<float> &storage) {
+#if JUCE_USE_SIMD
+  return FloatVector::getNextSIMDAlignedPtr(storage.data());
+#else
+  return storage.data();
+#endif
+}
+} // namespace
+
+//==============================================================================
+/**
+ * A half-band filter has a centre tap of 0.5 and zeros at every other tap,
+ * so with x split into its even and odd samples e and o, output n is
+ *
+ *   y[n] = sum_j g[j] * e[n - j] + 0.5 * o[n - K]
+ *
+ * where g holds the 2K non-zero taps either side of the centre. Only the
+ * dot product over e costs anything. The even samples are kept in a linear
+ * buffer positioned so that the same sample always lands on the same vector
+ * lane; each window is then read with aligned loads against one of
+ * VECTOR_SIZE copies of g shifted by 0..VECTOR_SIZE-1, and the sums do not
+ * depend on block boundaries.
+ */
+class PolyphaseDecimator::Stage {
+public:
+  explicit Stage(double sampleRate) {
+    const auto taps = designHalfBand(sampleRate);
+    numTaps = (int)taps.size();
+    halfLength = numTaps / 2;
+
+    paddedTaps = roundUpToVectorSize(numTaps + VECTOR_SIZE - 1);
+    coeffStorage.assign((size_t)((VECTOR_SIZE + 1) * paddedTaps), 0.0f);
+    coeffs = getAlignedStart(coeffStorage);
+
+    // g is symmetric, so it is stored in the order the window is read
+    for (int shift = 0; shift < VECTOR_SIZE; ++shift)
+      for (int j = 0; j < numTaps; ++j)
+        coeffs[shift * paddedTaps + shift + j] = taps[(size_t)j];
+
+    const int maxNewEven = MAX_BLOCK_SIZE / 2 + 1;
+    evenStorage.resize((size_t)(VECTOR_SIZE + numTaps - 1 + maxNewEven +
+                                paddedTaps + VECTOR_SIZE));
+    even = getAlignedStart(evenStorage);
+    odd.resize((size_t)(halfLength + maxNewEven));
+
+    reset();
+  }
+
+  void reset() {
+    std::fill(evenStorage.begin(), evenStorage.end(), 0.0f);
+    std::fill(odd.begin(), odd.end(), 0.0f);
+    evenCount = 0;
+    evenOffset = getEvenOffset();
+    nextIsOdd = false;
+  }
+
+  /** Decimates up to MAX_BLOCK_SIZE samples; returns the output count */
+  int process(const float *input, int numSamples, float *output) {
+    jassert(numSamples <= MAX_BLOCK_SIZE);
+
+    // Split the block after the history of each phase
+    float *newEven = even + evenOffset + numTaps - 1;
+    float *newOdd = odd.data() + halfLength;
+    int numEven = 0, numOdd = 0;
+    bool isOdd = nextIsOdd;
+
+    for (int i = 0; i < numSamples; ++i) {
+      if (isOdd)
+        newOdd[numOdd++] = input[i];
+      else
+        newEven[numEven++] = input[i];
+
+      isOdd = !isOdd;
+    }
+
+    // o[n - K] sits one further along if the block started on an odd sample
+    const int oddStart = nextIsOdd ? 1 : 0;
+
+    for (int k = 0; k < numEven; ++k)
+      output[k] = dotProduct(evenOffset + k) +
+                  0.5f * odd[(size_t)(oddStart + k)];
+
+    // Keep the history, re-positioned for the next block's lane alignment
+    evenCount = (evenCount + numEven) % VECTOR_SIZE;
+    const int newOffset = getEvenOffset();
+    std::memmove(even + newOffset, even + evenOffset + numEven,
+                 sizeof(float) * (size_t)(numTaps - 1));
+    evenOffset = newOffset;
+
+    std::memmove(odd.data(), odd.data() + numOdd,
+                 sizeof(float) * (size_t)halfLength);
+
+    nextIsOdd = isOdd;
+    return numEven;
+  }
+
+private:
+  /** @return Buffer position of the oldest history sample */
+  int getEvenOffset() const {
+    return ((evenCount - (numTaps - 1)) % VECTOR_SIZE + VECTOR_SIZE) %
+           VECTOR_SIZE;
+  }
+
+  /** @return g applied to the numTaps even samples starting at start */
+  float dotProduct(int start) const {
+#if JUCE_USE_SIMD
+    const int shift = start % VECTOR_SIZE;
+    const float *x = even + start - shift;
+    const float *c = coeffs + shift * paddedTaps;
+    auto sum = FloatVector::expand(0.0f);
+
+    for (int i = 0; i < paddedTaps; i += VECTOR_SIZE)
+      sum +=
+          FloatVector::fromRawArray(c + i) * FloatVector::fromRawArray(x + i);
+
+    return sum.sum();
+#else
+    float sum = 0.0f;
+
+    for (int i = 0; i < numTaps; ++i)
+      sum += coeffs[i] * even[start + i];
+
+    return sum;
+#endif
+  }
+
+  int halfLength = 1;
+  int numTaps = 2;
+  int paddedTaps = 2;
+
+  // VECTOR_SIZE shifted copies of the taps, paddedTaps apart
+  std::vector<float> coeffStorage;
+  float *coeffs = nullptr;
+
+  // Even samples: numTaps - 1 of history followed by the current block
+  std::vector<float> evenStorage;
+  float *even = nullptr;
+  int evenOffset = 0;
+  int evenCount = 0;
+
+  // Odd samples: halfLength of history followed by the current block
+  std::vector<float> odd;
+  bool nextIsOdd = false;
+
+  JUCE_DECLARE_NON_COPYABLE(Stage)
+};
+
+//==============================================================================
+std::vector<float> PolyphaseDecimator::designHalfBand(double sampleRate) {
+  // The kept band and the band that aliases into it are mirror images
+  // about a quarter of the input rate
+  const double passEdge = juce::jmin(PASSBAND_EDGE_HZ, sampleRate * 0.22);
+  const double transition = (0.5 * sampleRate - 2.0 * passEdge) / sampleRate;
+
+  // Kaiser's estimate of the length, rounded up to a half-band length
+  const int minLength = (int)std::ceil(
+      (STOPBAND_ATTENUATION_DB - 7.95) / (14.36 * transition) + 1.0);
+  const int halfLength = juce::jmax(1, (minLength + 4) / 4);
+  const int numTaps = 2 * halfLength;
+
+  const int length = 4 * halfLength - 1;
+  const int centre = length / 2;
+  const double beta = 0.1102 * (STOPBAND_ATTENUATION_DB - 8.7);
+  const double pi = juce::MathConstants<double>::pi;
+
+  std::vector<double> taps((size_t)numTaps);
+  double sum = 0.0;
+
+  for (int j = 0; j < numTaps; ++j) {
+    const int n = 2 * j;
+    const double offset = n - centre;
+    const double x = 2.0 * n / (length - 1) - 1.0;
+
+    taps[(size_t)j] = std::sin(pi * offset / 2.0) / (pi * offset) *
+                      besselI0(beta * std::sqrt(1.0 - x * x)) /
+                      besselI0(beta);
+    sum += taps[(size_t)j];
+  }
+
+  // The side taps are scaled so the gain at DC is exactly one
+  std::vector<float> scaled((size_t)numTaps);
+  for (int j = 0; j < numTaps; ++j)
+    scaled[(size_t)j] = (float)(taps[(size_t)j] * 0.5 / sum);
+
+  return scaled;
+}
+
+int PolyphaseDecimator::getFactorForSampleRate(double sampleRate) {
+  int factor = 1;
+
+  while (sampleRate / (factor * 2) >= MIN_OUTPUT_RATE - 1.0)
+    factor *= 2;
+
+  return factor;
+}
+
+PolyphaseDecimator::PolyphaseDecimator() = default;
+
+PolyphaseDecimator::~PolyphaseDecimator() = default;
+
+void PolyphaseDecimator::prepare(double sampleRate, int newFactor) {
+  jassert(newFactor > 0 && juce::isPowerOfTwo(newFactor));
+
+  inputRate = sampleRate;
+  factor = juce::jmax(1, newFactor);
+  stages.clear();
+
+  double stageRate = sampleRate;
+  for (int f = 1; f < factor; f *= 2) {
+    stages.push_back(std::make_unique<Stage>(stageRate));
+    stageRate /= 2.0;
+  }
+
+  scratchA.resize(MAX_BLOCK_SIZE / 2 + 1);
+  scratchB.resize(MAX_BLOCK_SIZE / 2 + 1);
+}
+
+void PolyphaseDecimator::reset() {
+  for (auto &stage : stages)
+    stage->reset();
+}
+
+int PolyphaseDecimator::getFactor() const { return factor; }
+
+double PolyphaseDecimator::getOutputSampleRate() const {
+  return inputRate / factor;
+}
+
+int PolyphaseDecimator::getMaxOutputSamples(int numSamples) const {
+  return numSamples / factor + 1;
+}
+
+int PolyphaseDecimator::process(const float *input, int numSamples,
+                                float *output) {
+  if (numSamples <= 0)
+    return 0;
+
+  if (stages.empty()) {
+    juce::FloatVectorOperations::copy(output, input, numSamples);
+    return numSamples;
+  }
+
+  int numOutput = 0;
+
+  for (int pos = 0; pos < numSamples; pos += MAX_BLOCK_SIZE) {
+    const float *stageInput = input + pos;
+    int count = juce::jmin(MAX_BLOCK_SIZE, numSamples - pos);
+
+    for (size_t i = 0; i < stages.size(); ++i) {
+      float *stageOutput = i + 1 == stages.size() ? output + numOutput
+                           : i % 2 == 0           ? scratchA.data()
+                                                  : scratchB.data();
+      count = stages[i]->process(stageInput, count, stageOutput);
+      stageInput = stageOutput;
+    }
+
+    numOutput += count;
+  }
+
+  return numOutput;
+}
+
+} // namespace mcam
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * PolyphaseDecimator reduces one channel to an analysis rate of 44.1 or
+ * 48 kHz for the measurements that only need the audio band (loudness,
+ * spectrum). It is a cascade of linear-phase half-band FIR stages, each
+ * decimating by two; in polyphase form only every other output is computed
+ * and half of the taps are zero, so a stage costs a quarter of a plain FIR
+ * of the same length per input sample.
+ *
+ * Content up to 20 kHz is kept with negligible ripple. Content above it may
+ * alias, but only into the band between 20 kHz and the new Nyquist
+ * frequency. The inner loop uses juce::dsp::SIMDRegister when available.
+ *
+ * The output depends only on the input stream, not on how it was split
+ * into blocks. Not thread safe - use one decimator per channel.
+ */
+class PolyphaseDecimator {
+public:
+  /** Streams are decimated while the result stays at or above this rate */
+  static constexpr double MIN_OUTPUT_RATE = 44100.0;
+
+  /** Upper edge of the band that is kept, in Hz */
+  static constexpr double PASSBAND_EDGE_HZ = 20000.0;
+
+  /** Attenuation of everything that would alias into the kept band */
+  static constexpr double STOPBAND_ATTENUATION_DB = 90.0;
+
+  /**
+   * @param sampleRate Input sample rate in Hz
+   * @return Power-of-two factor that brings the rate closest to
+   * MIN_OUTPUT_RATE without going below it (1 at 44.1 and 48 kHz)
+   */
+  static int getFactorForSampleRate(double sampleRate);
+
+  /**
+   * Designs the half-band filter of one stage. The full impulse response
+   * has 2 * size() - 1 taps: these at the even positions, 0.5 at the
+   * centre and zeros elsewhere.
+   * @param sampleRate Input sample rate of the stage in Hz
+   * @return The non-zero side taps, in order
+   */
+  static std::vector<float> designHalfBand(double sampleRate);
+
+  /** Constructor; passes audio through until prepared */
+  PolyphaseDecimator();
+
+  /** Destructor */
+  ~PolyphaseDecimator();
+
+  /**
+   * Designs the stages and clears all state
+   * @param sampleRate Input sample rate in Hz
+   * @param factor Decimation factor, a power of two (1 = pass through)
+   */
+  void prepare(double sampleRate, int factor);
+
+  /** Clears the filter state without redesigning the stages */
+  void reset();
+
+  /** @return The decimation factor */
+  int getFactor() const;
+
+  /** @return The output sample rate in Hz */
+  double getOutputSampleRate() const;
+
+  /**
+   * @param numSamples Number of input samples
+   * @return The most output samples process() can produce for them
+   */
+  int getMaxOutputSamples(int numSamples) const;
+
+  /**
+   * Decimates a block of samples
+   * @param input Input samples
+   * @param numSamples Number of input samples
+   * @param output Receives up to getMaxOutputSamples(numSamples) samples
+   * @return Number of output samples written
+   */
+  int process(const float *input, int numSamples, float *output);
+
+private:
+  /** One half-band decimate-by-two stage */
+  class Stage;
+
+  /** Input samples passed through the stages at a time */
+  static constexpr int MAX_BLOCK_SIZE = 1024;
+
+  double inputRate = 48000.0;
+  int factor = 1;
+  std::vector<std::unique_ptr<Stage>> stages;
+
+  // Intermediate results between stages
+  std::vector<float> scratchA, scratchB;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PolyphaseDecimator)
+};
+
+} // namespace mcam
@@ -0,0 +1,29 @@
+#include "SampleFifo.h"
+
+namespace mcam {
+
+// AbstractFifo keeps one slot free to tell full from empty
+SampleFifo::SampleFifo(int capacity)
+    : fifo(juce::jmax(1, capacity) + 1),
+      storage((size_t)(juce::jmax(1, capacity) + 1)) {}
+
+int SampleFifo::getCapacity() const { return fifo.getTotalSize() - 1; }
+
+int SampleFifo::getNumReady() const { return fifo.getNumReady(); }
+
+int SampleFifo::push(const float *samples, int numSamples) {
+  const auto scope = fifo.write(numSamples);
+
+  if (scope.blockSize1 > 0)
+    juce::FloatVectorOperations::copy(storage.data() + scope.startIndex1,
+                                      samples, scope.blockSize1);
+
+  if (scope.blockSize2 > 0)
+    juce::FloatVectorOperations::copy(storage.data() + scope.startIndex2,
+                                      samples + scope.blockSize1,
+                                      scope.blockSize2);
+
+  return scope.blockSize1 + scope.blockSize2;
+}
+
+} // namespace mcam
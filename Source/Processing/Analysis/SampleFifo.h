@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * SampleFifo hands a stream of samples from the audio thread to a reader
+ * on another thread, e.g. a scope display.
+ *
+ * The storage is allocated by the constructor. push() never blocks or
+ * allocates and drops the samples that do not fit, so a reader that falls
+ * behind loses samples rather than stalling the audio thread.
+ *
+ * Single producer, single consumer.
+ */
+class SampleFifo {
+public:
+  /**
+   * Constructor
+   * @param capacity Most samples queued at once
+   */
+  explicit SampleFifo(int capacity);
+
+  /** @return Most samples queued at once */
+  int getCapacity() const;
+
+  /** @return Samples queued and not yet read */
+  int getNumReady() const;
+
+  /**
+   * Appends samples (producer)
+   * @param samples Input samples
+   * @param numSamples Number of samples
+   * @return Number of samples queued; the rest were dropped
+   */
+  int push(const float *samples, int numSamples);
+
+  /**
+   * Hands everything queued to the reader in at most two pieces, oldest
+   * first, and frees it (consumer)
+   * @param onSamples Called as onSamples(const float *samples, int count)
+   */
+  template <typename Reader> void drain(Reader &&onSamples) {
+    const auto scope = fifo.read(fifo.getNumReady());
+
+    if (scope.blockSize1 > 0)
+      onSamples(storage.data() + scope.startIndex1, scope.blockSize1);
+
+    if (scope.blockSize2 > 0)
+      onSamples(storage.data() + scope.startIndex2, scope.blockSize2);
+  }
+
+private:
+  juce::AbstractFifo fifo;
+  std::vector<float> storage;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleFifo)
+};
+
+} // namespace mcam
@@ -0,0 +1,246 @@
+#include "TruePeakMeter.h"
+
+namespace mcam {
+
+namespace {
+#if JUCE_USE_SIMD
+using FloatVector = juce::dsp::SIMDRegister<float>;
+constexpr int VECTOR_SIZE = (int)FloatVector::SIMDNumElements;
+#else
+constexpr int VECTOR_SIZE = 1;
+#endif
+
+// Kaiser window shape of the interpolator; trades passband flatness near
+// 20 kHz against ripple between the phases
+constexpr double KAISER_BETA = 6.0;
+
+// Samples interleaved and measured per pass
+constexpr int CHUNK_SIZE = 64;
+
+constexpr int HISTORY = TruePeakMeter::TAPS_PER_PHASE - 1;
+constexpr int HALF_TAPS = TruePeakMeter::TAPS_PER_PHASE / 2;
+} // namespace
+
+int TruePeakMeter::getOversamplingFactor(double sampleRate) {
+  if (sampleRate <= 48000.0)
+    return 4;
+
+  return sampleRate <= 96000.0 ? 2 : 1;
+}
+
+TruePeakMeter::TruePeakMeter() = default;
+
+void TruePeakMeter::prepare(double sampleRate, int newNumChannels) {
+  factor = getOversamplingFactor(sampleRate);
+  numChannels = juce::jmax(0, newNumChannels);
+  numLanes = (numChannels + VECTOR_SIZE - 1) / VECTOR_SIZE * VECTOR_SIZE;
+
+  // A Nyquist filter of odd length L = factor * taps - 1 centred on tap c:
+  // the taps of c's phase are zero except c itself, so that phase is the
+  // input delayed by (c - (factor - 1)) / factor samples
+  const int length = factor * TAPS_PER_PHASE - 1;
+  const int centre = (length - 1) / 2;
+  passThroughDelay = (centre - (factor - 1)) / factor;
+
+  std::vector<double> window((size_t)length);
+  juce::dsp::WindowingFunction<double>::fillWindowingTables(
+      window.data(), (size_t)length,
+      juce::dsp::WindowingFunction<double>::kaiser, false, KAISER_BETA);
+
+  const auto designPhase = [&](int phase) {
+    std::array<double, TAPS_PER_PHASE> taps{};
+    double sum = 0.0;
+
+    for (int k = 0; k < TAPS_PER_PHASE; ++k) {
+      const int n = phase + factor * k;
+      const double x = juce::MathConstants<double>::pi * (n - centre) / factor;
+      taps[(size_t)k] = std::sin(x) / x * window[(size_t)n];
+      sum += taps[(size_t)k];
+    }
+
+    // Unity gain at DC for every phase, so a constant reads the same
+    // between samples as on them
+    for (auto &tap : taps)
+      tap /= sum;
+
+    return taps;
+  };
+
+  // The filter is symmetric about the centre, so phase p is phase
+  // (factor - 2 - p) with its taps reversed. A phase that is its own mirror
+  // needs only the sums of mirrored inputs; a mirrored pair a, b needs the
+  // sums and differences, as max(|a|, |b|) = (|a + b| + |a - b|) / 2.
+  symmetricTaps.clear();
+  pairSumTaps.clear();
+  pairDifferenceTaps.clear();
+
+  for (int phase = 0; phase < factor - 1; ++phase) {
+    const int mirror = factor - 2 - phase;
+    const auto taps = designPhase(phase);
+
+    for (int k = 0; k < HALF_TAPS; ++k) {
+      const double tap = taps[(size_t)k];
+      const double mirrored = taps[(size_t)(TAPS_PER_PHASE - 1 - k)];
+
+      if (mirror == phase) {
+        symmetricTaps.push_back((float)tap);
+      } else if (phase < mirror) {
+        pairSumTaps.push_back((float)(0.5 * (tap + mirrored)));
+        pairDifferenceTaps.push_back((float)(0.5 * (tap - mirrored)));
+      }
+    }
+  }
+
+  storage.assign((size_t)((1 + HISTORY + CHUNK_SIZE) * numLanes + VECTOR_SIZE),
+                 0.0f);
+#if JUCE_USE_SIMD
+  peaks = FloatVector::getNextSIMDAlignedPtr(storage.data());
+#else
+  peaks = storage.data();
+#endif
+  frames = peaks + numLanes;
+}
+
+int TruePeakMeter::getOversamplingFactor() const { return factor; }
+
+int TruePeakMeter::getNumChannels() const { return numChannels; }
+
+void TruePeakMeter::reset() {
+  std::fill(peaks, peaks + (1 + HISTORY + CHUNK_SIZE) * numLanes, 0.0f);
+}
+
+void TruePeakMeter::resetChannel(int channel) {
+  if (channel < 0 || channel >= numChannels)
+    return;
+
+  peaks[channel] = 0.0f;
+
+  for (int frame = 0; frame < HISTORY; ++frame)
+    frames[frame * numLanes + channel] = 0.0f;
+}
+
+template <int NumSymmetric, int NumPairs>
+void TruePeakMeter::processLanes(int firstLane, int numSamples) {
+#if JUCE_USE_SIMD
+  using Vector = FloatVector;
+  const auto load = [](const float *source) {
+    return Vector::fromRawArray(source);
+  };
+  const auto broadcast = [](float value) { return Vector::expand(value); };
+  const auto magnitude = [](Vector value) { return Vector::abs(value); };
+  const auto larger = [](Vector a, Vector b) { return Vector::max(a, b); };
+  auto peak = load(peaks + firstLane);
+#else
+  using Vector = float;
+  const auto load = [](const float *source) { return *source; };
+  const auto broadcast = [](float value) { return value; };
+  const auto magnitude = [](float value) { return std::abs(value); };
+  const auto larger = [](float a, float b) { return juce::jmax(a, b); };
+  float peak = peaks[firstLane];
+#endif
+
+  // Taps broadcast across the lanes once, not per sample
+  std::array<Vector, NumSymmetric * HALF_TAPS> symmetric;
+  std::array<Vector, NumPairs * HALF_TAPS> pairSums, pairDifferences;
+
+  for (size_t k = 0; k < symmetric.size(); ++k)
+    symmetric[k] = broadcast(symmetricTaps[k]);
+
+  for (size_t k = 0; k < pairSums.size(); ++k) {
+    pairSums[k] = broadcast(pairSumTaps[k]);
+    pairDifferences[k] = broadcast(pairDifferenceTaps[k]);
+  }
+
+  for (int i = 0; i < numSamples; ++i) {
+    const float *newest = frames + (HISTORY + i) * numLanes + firstLane;
+    std::array<Vector, HALF_TAPS> sums, differences;
+
+    for (int k = 0; k < HALF_TAPS; ++k) {
+      const auto a = load(newest - k * numLanes);
+      const auto b = load(newest - (TAPS_PER_PHASE - 1 - k) * numLanes);
+      sums[(size_t)k] = a + b;
+      differences[(size_t)k] = a - b;
+    }
+
+    peak = larger(peak, magnitude(load(newest - passThroughDelay * numLanes)));
+
+    for (int phase = 0; phase < NumSymmetric; ++phase) {
+      const auto *taps = symmetric.data() + phase * HALF_TAPS;
+      Vector y = sums[0] * taps[0];
+
+      for (int k = 1; k < HALF_TAPS; ++k)
+        y = y + sums[(size_t)k] * taps[k];
+
+      peak = larger(peak, magnitude(y));
+    }
+
+    for (int pair = 0; pair < NumPairs; ++pair) {
+      const auto *sumTaps = pairSums.data() + pair * HALF_TAPS;
+      const auto *differenceTaps = pairDifferences.data() + pair * HALF_TAPS;
+      Vector p = sums[0] * sumTaps[0];
+      Vector q = differences[0] * differenceTaps[0];
+
+      for (int k = 1; k < HALF_TAPS; ++k) {
+        p = p + sums[(size_t)k] * sumTaps[k];
+        q = q + differences[(size_t)k] * differenceTaps[k];
+      }
+
+      peak = larger(peak, magnitude(p) + magnitude(q));
+    }
+  }
+
+#if JUCE_USE_SIMD
+  peak.copyToRawArray(peaks + firstLane);
+#else
+  peaks[firstLane] = peak;
+#endif
+}
+
+void TruePeakMeter::process(const float *const *inputs, int numInputs,
+                            int numSamples) {
+  numInputs = juce::jmin(numInputs, numChannels);
+  const int usedLanes =
+      (numInputs + VECTOR_SIZE - 1) / VECTOR_SIZE * VECTOR_SIZE;
+
+  std::fill(peaks, peaks + numLanes, 0.0f);
+
+  for (int pos = 0; pos < numSamples; pos += CHUNK_SIZE) {
+    const int count = juce::jmin(CHUNK_SIZE, numSamples - pos);
+
+    // One frame of usedLanes values per sample, after the history
+    for (int ch = 0; ch < usedLanes; ++ch) {
+      const float *input = ch < numInputs ? inputs[ch] : nullptr;
+      float *dest = frames + HISTORY * numLanes + ch;
+
+      if (input == nullptr) {
+        for (int i = 0; i < count; ++i)
+          dest[i * numLanes] = 0.0f;
+      } else {
+        for (int i = 0; i < count; ++i)
+          dest[i * numLanes] = input[pos + i];
+      }
+    }
+
+    for (int lane = 0; lane < usedLanes; lane += VECTOR_SIZE) {
+      if (factor == 4)
+        processLanes<1, 1>(lane, count);
+      else if (factor == 2)
+        processLanes<1, 0>(lane, count);
+      else
+        processLanes<0, 0>(lane, count);
+    }
+
+    // The newest frames are the next chunk's history
+    std::memmove(frames, frames + count * numLanes,
+                 sizeof(float) * (size_t)(HISTORY * numLanes));
+  }
+}
+
+float TruePeakMeter::getPeak(int channel) const {
+  if (channel < 0 || channel >= numChannels)
+    return 0.0f;
+
+  return peaks[channel];
+}
+
+} // namespace mcam
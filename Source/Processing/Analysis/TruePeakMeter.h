@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * TruePeakMeter measures the ITU-R BS.1770 true peak of a set of channels:
+ * the largest magnitude of the signal oversampled 4x (2x at 88.2/96 kHz),
+ * which catches the inter-sample overs a sample peak misses.
+ *
+ * The interpolator is a Kaiser-windowed Nyquist filter of 12 taps per
+ * phase. One phase of such a filter passes the input through unchanged, so
+ * only the other phases are computed and the sample itself stands in for
+ * the last. The filter's symmetry halves the multiplies of the rest. Each
+ * output is folded into a running maximum as soon as it is computed; the
+ * oversampled signal is never stored.
+ *
+ * As in KWeightingFilterBank, channels are processed side by side, one per
+ * vector lane of juce::dsp::SIMDRegister<float>, from short interleaved
+ * chunks. Readings lag the input by about six samples.
+ *
+ * Not thread safe; the owner serialises configuration and processing.
+ */
+class TruePeakMeter {
+public:
+  /** Taps of each interpolation phase */
+  static constexpr int TAPS_PER_PHASE = 12;
+
+  /**
+   * @param sampleRate Sample rate in Hz
+   * @return Oversampling factor BS.1770 calls for: 4 up to 48 kHz, 2 up to
+   * 96 kHz, 1 (sample peak) above
+   */
+  static int getOversamplingFactor(double sampleRate);
+
+  /** Constructor */
+  TruePeakMeter();
+
+  /**
+   * Designs the interpolator and allocates state, then resets
+   * @param sampleRate Sample rate in Hz
+   * @param numChannels Number of channels measured side by side
+   */
+  void prepare(double sampleRate, int numChannels);
+
+  /** @return The oversampling factor in use */
+  int getOversamplingFactor() const;
+
+  /** @return Number of prepared channels */
+  int getNumChannels() const;
+
+  /** Clears the history and peaks of every channel */
+  void reset();
+
+  /** Clears the history and peak of one channel, e.g. for a new source */
+  void resetChannel(int channel);
+
+  /**
+   * Measures one block; the peaks of the previous block are discarded
+   * @param inputs One pointer per channel; nullptr is measured as silence
+   * @param numInputs Channels to process; the rest read 0
+   * @param numSamples Number of samples
+   */
+  void process(const float *const *inputs, int numInputs, int numSamples);
+
+  /** @return Linear true peak of a channel over the last block */
+  float getPeak(int channel) const;
+
+private:
+  /**
+   * Measures lanes [firstLane, firstLane + vector size) of a chunk, with the
+   * phase counts fixed so the kernel unrolls
+   */
+  template <int NumSymmetric, int NumPairs>
+  void processLanes(int firstLane, int numSamples);
+
+  int factor = 4;
+  int numChannels = 0;
+  int numLanes = 0;
+
+  // Frames the pass-through phase lags the newest input
+  int passThroughDelay = 0;
+
+  // Half the taps of each computed phase, newest input first: phases that
+  // mirror themselves, then the sum and difference taps of mirrored pairs
+  std::vector<float> symmetricTaps;
+  std::vector<float> pairSumTaps, pairDifferenceTaps;
+
+  // Per-lane peaks, then the interleaved chunk after TAPS_PER_PHASE - 1
+  // frames of history
+  std::vector<float> storage;
+  float *peaks = nullptr;
+  float *frames = nullptr;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TruePeakMeter)
+};
+
+} // namespace mcam
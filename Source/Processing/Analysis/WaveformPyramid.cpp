@@ -0,0 +1,194 @@
+#include "WaveformPyramid.h"
+
+namespace mcam {
+
+namespace {
+// Samples appended at a time. Every ring holds at least two chunks, so the
+// buckets a chunk adds to a level are still there when the level above
+// reads them.
+constexpr int CHUNK_SIZE = 1024;
+
+// A window spans fewer than two buckets per column of its level, and a
+// trigger is searched for over one more window before it
+constexpr int BUCKETS_PER_COLUMN = 4;
+
+juce::int64 nextPowerOfTwo(juce::int64 value) {
+  juce::int64 power = 1;
+
+  while (power < value)
+    power <<= 1;
+
+  return power;
+}
+} // namespace
+
+WaveformPyramid::WaveformPyramid() { prepare(sampleRate, 1.0, 1024); }
+
+void WaveformPyramid::prepare(double newSampleRate, double maxWindowSeconds,
+                              int newMaxColumns) {
+  sampleRate = newSampleRate;
+  maxColumns = juce::jmax(1, newMaxColumns);
+  maxWindowSamples =
+      juce::jmax((juce::int64)1,
+                 (juce::int64)std::ceil(maxWindowSeconds * sampleRate));
+
+  // Enough levels that one bucket of the top level covers the longest
+  // window
+  int numLevels = 1;
+  while (((juce::int64)1 << (numLevels - 1)) < maxWindowSamples)
+    ++numLevels;
+
+  levels.resize((size_t)numLevels);
+
+  for (int index = 0; index < numLevels; ++index) {
+    const juce::int64 windowBuckets =
+        2 * ((maxWindowSamples >> index) + 1);
+    const auto capacity = nextPowerOfTwo(juce::jmax(
+        (juce::int64)(2 * CHUNK_SIZE),
+        juce::jmin((juce::int64)BUCKETS_PER_COLUMN * maxColumns,
+                   windowBuckets)));
+
+    auto &level = levels[(size_t)index];
+    level.mins.assign((size_t)capacity, 0.0f);
+    level.maxs.assign((size_t)capacity, 0.0f);
+    level.mask = capacity - 1;
+    level.numBuckets = 0;
+  }
+}
+
+void WaveformPyramid::reset() {
+  for (auto &level : levels) {
+    std::fill(level.mins.begin(), level.mins.end(), 0.0f);
+    std::fill(level.maxs.begin(), level.maxs.end(), 0.0f);
+    level.numBuckets = 0;
+  }
+}
+
+void WaveformPyramid::push(const float *samples, int numSamples) {
+  for (int pos = 0; pos < numSamples; pos += CHUNK_SIZE)
+    pushChunk(samples + pos, juce::jmin(CHUNK_SIZE, numSamples - pos));
+}
+
+void WaveformPyramid::pushChunk(const float *samples, int numSamples) {
+  // Level 0 buckets are single samples, so their min and max are the
+  // sample itself
+  auto &base = levels[0];
+
+  for (int i = 0; i < numSamples;) {
+    const auto offset = (int)((base.numBuckets + i) & base.mask);
+    const int count =
+        juce::jmin(numSamples - i, (int)(base.mask + 1) - offset);
+
+    juce::FloatVectorOperations::copy(base.mins.data() + offset,
+                                      samples + i, count);
+    juce::FloatVectorOperations::copy(base.maxs.data() + offset,
+                                      samples + i, count);
+    i += count;
+  }
+
+  base.numBuckets += numSamples;
+
+  // Each level completes a bucket for every two of the level below
+  for (size_t index = 1; index < levels.size(); ++index) {
+    const auto &below = levels[index - 1];
+    auto &level = levels[index];
+    const juce::int64 complete = below.numBuckets / 2;
+
+    if (complete == level.numBuckets)
+      break;
+
+    for (auto bucket = level.numBuckets; bucket < complete; ++bucket) {
+      const auto first = (size_t)((2 * bucket) & below.mask);
+      const auto second = (size_t)((2 * bucket + 1) & below.mask);
+      const auto slot = (size_t)(bucket & level.mask);
+
+      level.mins[slot] = juce::jmin(below.mins[first], below.mins[second]);
+      level.maxs[slot] = juce::jmax(below.maxs[first], below.maxs[second]);
+    }
+
+    level.numBuckets = complete;
+  }
+}
+
+juce::int64 WaveformPyramid::getNumSamplesPushed() const {
+  return levels[0].numBuckets;
+}
+
+int WaveformPyramid::getNumLevels() const { return (int)levels.size(); }
+
+bool WaveformPyramid::render(double windowSeconds, bool triggered,
+                             float triggerLevel, Column *columns,
+                             int numColumns) const {
+  numColumns = juce::jlimit(0, maxColumns, numColumns);
+
+  if (numColumns == 0)
+    return false;
+
+  const auto windowSamples = juce::jlimit(
+      (juce::int64)1, maxWindowSamples,
+      (juce::int64)juce::roundToInt(windowSeconds * sampleRate));
+
+  // The coarsest level with at least one bucket per column
+  size_t index = 0;
+  while (index + 1 < levels.size() &&
+         ((juce::int64)numColumns << (index + 1)) <= windowSamples)
+    ++index;
+
+  const auto &level = levels[index];
+  const juce::int64 windowBuckets =
+      juce::jmax((juce::int64)1, windowSamples >> index);
+  const juce::int64 oldest =
+      juce::jmax((juce::int64)0, level.numBuckets - (level.mask + 1));
+  juce::int64 start = level.numBuckets - windowBuckets;
+  bool isTriggered = false;
+
+  // The latest rising crossing one window further back; buckets holding a
+  // whole period both arm and fire, which still pins the phase to a bucket
+  if (triggered) {
+    const auto searchEnd = start;
+    bool armed = false;
+
+    for (auto bucket = juce::jmax(oldest, searchEnd - windowBuckets);
+         bucket <= searchEnd; ++bucket) {
+      const auto slot = (size_t)(bucket & level.mask);
+
+      if (armed && level.maxs[slot] >= triggerLevel) {
+        start = bucket;
+        isTriggered = true;
+        armed = false;
+      }
+
+      if (level.mins[slot] < triggerLevel - TRIGGER_HYSTERESIS)
+        armed = true;
+    }
+
+    if (!isTriggered)
+      start = level.numBuckets - windowBuckets;
+  }
+
+  for (int column = 0; column < numColumns; ++column) {
+    const auto first = start + column * windowBuckets / numColumns;
+    const auto last = juce::jmax(
+        first + 1, start + (column + 1) * windowBuckets / numColumns);
+    Column range;
+    bool hasData = false;
+
+    for (auto bucket = juce::jmax(first, oldest); bucket < last; ++bucket) {
+      const auto slot = (size_t)(bucket & level.mask);
+
+      if (!hasData) {
+        range = {level.mins[slot], level.maxs[slot]};
+        hasData = true;
+      } else {
+        range.min = juce::jmin(range.min, level.mins[slot]);
+        range.max = juce::jmax(range.max, level.maxs[slot]);
+      }
+    }
+
+    columns[column] = range;
+  }
+
+  return isTriggered;
+}
+
+} // namespace mcam
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * WaveformPyramid keeps the recent history of one signal as a stack of
+ * min/max levels for drawing: level 0 holds the samples, and each level
+ * above holds the minimum and maximum of pairs of buckets of the level
+ * below. Levels are extended as samples arrive, about two writes per
+ * sample in all.
+ *
+ * A window is drawn from the level whose buckets are the largest that fit
+ * in one column, so it covers between one and two buckets per column and
+ * rendering touches about twice as many values as there are columns,
+ * whatever the window length.
+ *
+ * Each level is a ring holding only as many buckets as the longest window
+ * (and a trigger search before it) can use at that level, so memory is
+ * bounded by the longest window and the widest display.
+ *
+ * Not thread safe; fill and render it from one thread.
+ */
+class WaveformPyramid {
+public:
+  /** Range of the signal under one column */
+  struct Column {
+    float min = 0.0f;
+    float max = 0.0f;
+  };
+
+  /** Margin below the trigger level the signal must fall to re-arm */
+  static constexpr float TRIGGER_HYSTERESIS = 0.01f;
+
+  /** Constructor */
+  WaveformPyramid();
+
+  /**
+   * Sizes the levels and clears the history
+   * @param sampleRate Sample rate in Hz
+   * @param maxWindowSeconds Longest window that will be rendered
+   * @param maxColumns Most columns a window will be rendered to
+   */
+  void prepare(double sampleRate, double maxWindowSeconds, int maxColumns);
+
+  /** Clears the history */
+  void reset();
+
+  /**
+   * Appends samples to the history
+   * @param samples Input samples
+   * @param numSamples Number of samples
+   */
+  void push(const float *samples, int numSamples);
+
+  /** @return Samples pushed since the last reset */
+  juce::int64 getNumSamplesPushed() const;
+
+  /** @return Number of levels, i.e. the coarsest bucket is 2^(n - 1) */
+  int getNumLevels() const;
+
+  /**
+   * Reduces a window of the history to columns. Untriggered, the window
+   * ends at the newest complete bucket. Triggered, it starts at the latest
+   * rising crossing of the trigger level that still leaves a whole window
+   * after it, so periodic signals stand still; without one it runs free.
+   * Columns before the start of the history read 0.
+   * @param windowSeconds Length of the window, clamped to the prepared
+   * maximum
+   * @param triggered Whether to align the window to a trigger
+   * @param triggerLevel Level the signal must rise through
+   * @param columns Receives numColumns columns, oldest first
+   * @param numColumns Number of columns, at most the prepared maximum
+   * @return true if the window was aligned to a trigger
+   */
+  bool render(double windowSeconds, bool triggered, float triggerLevel,
+              Column *columns, int numColumns) const;
+
+private:
+  /** One level: a ring of buckets and the number completed so far */
+  struct Level {
+    std::vector<float> mins, maxs;
+    juce::int64 mask = 0;
+    juce::int64 numBuckets = 0;
+  };
+
+  /** Appends at most CHUNK_SIZE samples and extends the levels above */
+  void pushChunk(const float *samples, int numSamples);
+
+  double sampleRate = 48000.0;
+  juce::int64 maxWindowSamples = 0;
+  int maxColumns = 0;
+  std::vector<Level> levels;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformPyramid)
+};
+
+} // namespace mcam
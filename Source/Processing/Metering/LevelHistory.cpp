@@ -0,0 +1,158 @@
+#include "LevelHistory.h"
+
+namespace mcam {
+
+namespace {
+// Duration of the finest entries, in seconds
+constexpr double BASE_SECONDS = 0.1;
+
+// Entries of the resolution below folded into one entry of each resolution
+constexpr int ROLLUP_FACTORS[LevelHistory::NUM_RESOLUTIONS] = {1, 10, 10, 6};
+
+// Slots per ring: one more than is readable, for the slot being written
+constexpr int RING_SIZE = LevelHistory::CAPACITY + 1;
+} // namespace
+
+double LevelHistory::getResolutionSeconds(int resolution) {
+  jassert(resolution >= 0 && resolution < NUM_RESOLUTIONS);
+
+  double seconds = BASE_SECONDS;
+
+  for (int index = 1; index <= resolution; ++index)
+    seconds *= ROLLUP_FACTORS[index];
+
+  return seconds;
+}
+
+int LevelHistory::findResolution(double secondsPerPixel) {
+  int resolution = 0;
+
+  while (resolution + 1 < NUM_RESOLUTIONS &&
+         getResolutionSeconds(resolution + 1) <= secondsPerPixel)
+    ++resolution;
+
+  return resolution;
+}
+
+void LevelHistory::Accumulator::add(float newMin, float newMax, float mean,
+                                    double newWeight) {
+  if (weight == 0.0) {
+    min = newMin;
+    max = newMax;
+  } else {
+    min = juce::jmin(min, newMin);
+    max = juce::jmax(max, newMax);
+  }
+
+  sum += (double)mean * newWeight;
+  weight += newWeight;
+}
+
+LevelHistory::Entry LevelHistory::Accumulator::getEntry() const {
+  return {min, max, weight > 0.0 ? (float)(sum / weight) : 0.0f};
+}
+
+LevelHistory::LevelHistory() {
+  for (auto &ring : rings)
+    ring.entries.reset(new SharedEntry[(size_t)RING_SIZE]);
+
+  prepare(48000.0);
+}
+
+void LevelHistory::prepare(double sampleRate) {
+  samplesPerEntry = juce::jmax(1.0, sampleRate * BASE_SECONDS);
+  pendingSamples = juce::jmin(pendingSamples, samplesPerEntry - 1.0);
+}
+
+void LevelHistory::reset() {
+  for (auto &ring : rings) {
+    ring.numEntries.store(0, std::memory_order_release);
+    ring.pending = {};
+    ring.numPending = 0;
+  }
+
+  pendingSamples = 0.0;
+}
+
+void LevelHistory::push(float level, int numSamples) {
+  auto &base = rings[0];
+  double remaining = (double)numSamples;
+
+  // A block crossing an entry boundary counts towards both entries
+  while (pendingSamples + remaining >= samplesPerEntry) {
+    const double taken = samplesPerEntry - pendingSamples;
+    base.pending.add(level, level, level, taken);
+    publish(0, base.pending.getEntry());
+
+    base.pending = {};
+    remaining -= taken;
+    pendingSamples = 0.0;
+  }
+
+  if (remaining > 0.0) {
+    base.pending.add(level, level, level, remaining);
+    pendingSamples += remaining;
+  }
+}
+
+void LevelHistory::publish(int resolution, const Entry &entry) {
+  auto &ring = rings[(size_t)resolution];
+  const auto index = ring.numEntries.load(std::memory_order_relaxed);
+
+  // Readers that see any of the writes below also see the count before
+  // them, so they know this slot may be changing
+  std::atomic_thread_fence(std::memory_order_release);
+
+  auto &slot = ring.entries[(size_t)(index % RING_SIZE)];
+  slot.min.store(entry.min, std::memory_order_relaxed);
+  slot.max.store(entry.max, std::memory_order_relaxed);
+  slot.mean.store(entry.mean, std::memory_order_relaxed);
+  ring.numEntries.store(index + 1, std::memory_order_release);
+
+  if (resolution + 1 == NUM_RESOLUTIONS)
+    return;
+
+  auto &next = rings[(size_t)resolution + 1];
+  next.pending.add(entry.min, entry.max, entry.mean, 1.0);
+
+  if (++next.numPending == ROLLUP_FACTORS[resolution + 1]) {
+    const auto rolledUp = next.pending.getEntry();
+    next.pending = {};
+    next.numPending = 0;
+    publish(resolution + 1, rolledUp);
+  }
+}
+
+juce::int64 LevelHistory::getNumEntries(int resolution) const {
+  jassert(resolution >= 0 && resolution < NUM_RESOLUTIONS);
+  return rings[(size_t)resolution].numEntries.load(std::memory_order_acquire);
+}
+
+int LevelHistory::read(int resolution, Entry *entries, int maxEntries) const {
+  jassert(resolution >= 0 && resolution < NUM_RESOLUTIONS);
+
+  const auto &ring = rings[(size_t)resolution];
+  const auto end = ring.numEntries.load(std::memory_order_acquire);
+  const auto first = juce::jmax(
+      (juce::int64)0, end - juce::jlimit(0, CAPACITY, maxEntries));
+
+  for (auto index = first; index < end; ++index) {
+    const auto &slot = ring.entries[(size_t)(index % RING_SIZE)];
+    entries[index - first] = {slot.min.load(std::memory_order_relaxed),
+                              slot.max.load(std::memory_order_relaxed),
+                              slot.mean.load(std::memory_order_relaxed)};
+  }
+
+  // Entries whose slots were reused while copying are dropped; the slot
+  // after the newest may be mid-write
+  std::atomic_thread_fence(std::memory_order_acquire);
+  const auto newEnd = ring.numEntries.load(std::memory_order_relaxed);
+  const auto valid = juce::jmax(first, newEnd - CAPACITY);
+
+  if (valid > first && valid < end)
+    std::copy(entries + (valid - first), entries + (end - first), entries);
+
+  return (int)juce::jmax((juce::int64)0, end - valid);
+}
+
+} // namespace mcam
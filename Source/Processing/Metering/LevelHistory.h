@@ -0,0 +1,125 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * LevelHistory keeps the level of one channel over time at several
+ * resolutions: entries of 100 ms, 1 s, 10 s and 1 min, each holding the
+ * minimum, maximum and mean of the block levels under it. Each resolution
+ * is a fixed ring of CAPACITY entries, so the 1 s ring covers the last
+ * hour and memory is the same for every channel however long it runs.
+ *
+ * Block levels are folded into the current 100 ms entry as they arrive;
+ * a completed entry is folded into the pending entry of the next
+ * resolution, and so on, so each block costs a few comparisons.
+ *
+ * One thread pushes (the audio thread); any thread may read. Entries are
+ * published with an atomic count, and a reader drops any entry the writer
+ * overwrote while it was being copied.
+ */
+class LevelHistory {
+public:
+  /** Range and mean of the block levels under one entry */
+  struct Entry {
+    float min = 0.0f;
+    float max = 0.0f;
+    float mean = 0.0f;
+  };
+
+  /** Number of resolutions; 0 is the finest */
+  static constexpr int NUM_RESOLUTIONS = 4;
+
+  /** Entries kept per resolution */
+  static constexpr int CAPACITY = 3600;
+
+  /**
+   * @param resolution Resolution index (0 to NUM_RESOLUTIONS - 1)
+   * @return Duration of one entry, in seconds
+   */
+  static double getResolutionSeconds(int resolution);
+
+  /**
+   * Finds the coarsest resolution that still gives every pixel at least
+   * one entry
+   * @param secondsPerPixel Time spanned by one pixel
+   * @return Resolution index, 0 if even the finest is coarser
+   */
+  static int findResolution(double secondsPerPixel);
+
+  /** Constructor */
+  LevelHistory();
+
+  /**
+   * Sets the rate of the blocks pushed. The history is kept, so a device
+   * restart does not lose the trend.
+   * @param sampleRate Sample rate in Hz
+   */
+  void prepare(double sampleRate);
+
+  /** Clears every resolution. Not safe while push() runs. */
+  void reset();
+
+  /**
+   * Adds the level of one block
+   * @param level Linear block level, e.g. its RMS
+   * @param numSamples Samples in the block, which weight the mean
+   */
+  void push(float level, int numSamples);
+
+  /**
+   * @param resolution Resolution index (0 to NUM_RESOLUTIONS - 1)
+   * @return Entries completed at that resolution since the last reset
+   */
+  juce::int64 getNumEntries(int resolution) const;
+
+  /**
+   * Copies the newest completed entries of one resolution
+   * @param resolution Resolution index (0 to NUM_RESOLUTIONS - 1)
+   * @param entries Receives the entries, oldest first
+   * @param maxEntries Most entries to copy
+   * @return Number of entries copied, fewer than maxEntries if the history
+   * is shorter
+   */
+  int read(int resolution, Entry *entries, int maxEntries) const;
+
+private:
+  /** An entry whose fields can be read while the writer runs */
+  struct SharedEntry {
+    std::atomic<float> min{0.0f};
+    std::atomic<float> max{0.0f};
+    std::atomic<float> mean{0.0f};
+  };
+
+  /** Running range and weighted sum of the values folded into an entry */
+  struct Accumulator {
+    float min = 0.0f;
+    float max = 0.0f;
+    double sum = 0.0;
+    double weight = 0.0;
+
+    void add(float newMin, float newMax, float mean, double newWeight);
+    Entry getEntry() const;
+  };
+
+  /** One resolution: its ring and the entry being built for it */
+  struct Ring {
+    std::unique_ptr<SharedEntry[]> entries;
+    std::atomic<juce::int64> numEntries{0};
+    Accumulator pending;
+    int numPending = 0;
+  };
+
+  /** Appends an entry to a resolution and folds it into the next */
+  void publish(int resolution, const Entry &entry);
+
+  std::array<Ring, NUM_RESOLUTIONS> rings;
+
+  // Samples per finest entry, and samples folded into the current one
+  double samplesPerEntry = 4800.0;
+  double pendingSamples = 0.0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelHistory)
+};
+
+} // namespace mcam
@@ -0,0 +1,195 @@
+#include "PPMMeterCalculator.h"
+
+namespace mcam {
+
+namespace {
+// Longest stretch advanced in one step; longer blocks are split
+constexpr int BLOCK_SIZE = 1024;
+
+// Reading of an INTEGRATION_SECONDS tone burst relative to the steady tone
+constexpr double BURST_READING_DB = -2.0;
+constexpr double BURST_FREQUENCY = 5000.0;
+
+// A steady sine at this frequency reads its peak amplitude
+constexpr double ALIGNMENT_FREQUENCY = 1000.0;
+
+// Time simulated for a steady reading, and bisection steps for the charge
+// rate
+constexpr double SETTLING_SECONDS = 0.2;
+constexpr int CALIBRATION_STEPS = 40;
+} // namespace
+
+PPMMeterCalculator::PPMMeterCalculator() = default;
+
+void PPMMeterCalculator::prepare(double sampleRate, int newNumChannels) {
+  numChannels = juce::jmax(0, newNumChannels);
+
+  const double decay =
+      std::pow(10.0, -RETURN_DB / 20.0 / (RETURN_SECONDS * sampleRate));
+
+  // Reading of a unit sine played from rest for a number of samples, for
+  // a given charge rate
+  const auto readSine = [&](double charge, double frequency, int length) {
+    const double step =
+        juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    double reading = 0.0;
+
+    for (int n = 0; n < length; ++n)
+      reading = reading * decay +
+                charge * juce::jmax(std::abs(std::sin(step * n)) - reading,
+                                    0.0);
+
+    return reading;
+  };
+
+  // The rectifier only charges near the crests, so the charge rate for
+  // the burst reading is found by bisection rather than in closed form
+  const int burstLength =
+      juce::jmax(1, juce::roundToInt(INTEGRATION_SECONDS * sampleRate));
+  const int steadyLength =
+      juce::roundToInt(SETTLING_SECONDS * sampleRate) + burstLength;
+  const double burstReading =
+      juce::Decibels::decibelsToGain(BURST_READING_DB);
+  double low = 0.0, high = 1.0;
+
+  for (int i = 0; i < CALIBRATION_STEPS; ++i) {
+    const double charge = 0.5 * (low + high);
+    const double ratio =
+        readSine(charge, BURST_FREQUENCY, burstLength) /
+        readSine(charge, BURST_FREQUENCY, steadyLength);
+
+    if (ratio < burstReading)
+      low = charge;
+    else
+      high = charge;
+  }
+
+  release = (float)decay;
+  attack = (float)high;
+  gain = (float)(1.0 / readSine(high, ALIGNMENT_FREQUENCY, steadyLength));
+  holdSamples = juce::roundToInt(PEAK_HOLD_SECONDS * sampleRate);
+
+  releasePowers.resize((size_t)BLOCK_SIZE + 1);
+  chargeThresholdScales.resize((size_t)BLOCK_SIZE);
+
+  for (int n = 0; n <= BLOCK_SIZE; ++n)
+    releasePowers[(size_t)n] = (float)std::pow(decay, n);
+
+  for (int n = 0; n < BLOCK_SIZE; ++n)
+    chargeThresholdScales[(size_t)n] = (float)std::pow(decay, -n);
+
+  scratch.assign((size_t)BLOCK_SIZE, 0.0f);
+  levels.assign((size_t)numChannels, 0.0f);
+  holds.assign((size_t)numChannels, 0.0f);
+  holdAges.assign((size_t)numChannels, 0);
+}
+
+int PPMMeterCalculator::getNumChannels() const { return numChannels; }
+
+void PPMMeterCalculator::reset() {
+  std::fill(levels.begin(), levels.end(), 0.0f);
+  std::fill(holds.begin(), holds.end(), 0.0f);
+  std::fill(holdAges.begin(), holdAges.end(), 0);
+}
+
+void PPMMeterCalculator::resetChannel(int channel) {
+  if (channel < 0 || channel >= numChannels)
+    return;
+
+  levels[(size_t)channel] = 0.0f;
+  holds[(size_t)channel] = 0.0f;
+  holdAges[(size_t)channel] = 0;
+}
+
+void PPMMeterCalculator::process(const float *const *inputs, int numInputs,
+                                 int numSamples) {
+  numInputs = juce::jmin(numInputs, numChannels);
+
+  for (int ch = 0; ch < numInputs; ++ch) {
+    const float *input = inputs[ch];
+
+    for (int pos = 0; pos < numSamples; pos += BLOCK_SIZE)
+      advance(ch, input != nullptr ? input + pos : nullptr,
+              juce::jmin(BLOCK_SIZE, numSamples - pos));
+  }
+}
+
+void PPMMeterCalculator::advance(int channel, const float *input,
+                                 int numSamples) {
+  const auto index = (size_t)channel;
+  float level = levels[index];
+  float highest = 0.0f;
+
+  // Scaled by release^-n, sample n charges the reading if it exceeds the
+  // reading before sample m scaled by release^-m, for any m <= n reached by
+  // free decay. A block that never does just decays.
+  bool charges = false;
+
+  if (input != nullptr && numSamples > 0) {
+    juce::FloatVectorOperations::abs(scratch.data(), input, numSamples);
+    juce::FloatVectorOperations::multiply(
+        scratch.data(), chargeThresholdScales.data(), numSamples);
+    charges = juce::FloatVectorOperations::findMaximum(scratch.data(),
+                                                       numSamples) > level;
+  }
+
+  if (!charges) {
+    if (numSamples > 0)
+      highest = level * release;
+
+    level *= releasePowers[(size_t)numSamples];
+  } else {
+    // Decay in one step to each charging sample, which is then followed
+    // exactly; the highest reading after any sample feeds the hold
+    for (int pos = 0; pos < numSamples;) {
+      const float threshold = level * chargeThresholdScales[(size_t)pos];
+      int next = pos;
+
+      while (next < numSamples && scratch[(size_t)next] <= threshold)
+        ++next;
+
+      if (next > pos) {
+        highest = juce::jmax(highest, level * release);
+        level *= releasePowers[(size_t)(next - pos)];
+      }
+
+      if (next == numSamples)
+        break;
+
+      level = level * release +
+              attack * juce::jmax(std::abs(input[next]) - level, 0.0f);
+      highest = juce::jmax(highest, level);
+      pos = next + 1;
+    }
+  }
+
+  levels[index] = level;
+
+  // Reaching the hold again restarts it, so a steady signal keeps it
+  if (highest >= holds[index]) {
+    holds[index] = highest;
+    holdAges[index] = 0;
+  } else {
+    holdAges[index] = juce::jmin(holdAges[index] + numSamples, holdSamples);
+
+    // An expired hold follows the reading until it is raised again
+    if (holdAges[index] >= holdSamples)
+      holds[index] = level;
+  }
+}
+
+float PPMMeterCalculator::getLevel(int channel) const {
+  if (channel < 0 || channel >= numChannels)
+    return 0.0f;
+
+  return levels[(size_t)channel] * gain;
+}
+
+float PPMMeterCalculator::getPeakHold(int channel) const {
+  if (channel < 0 || channel >= numChannels)
+    return 0.0f;
+
+  return holds[(size_t)channel] * gain;
+}
+
+} // namespace mcam
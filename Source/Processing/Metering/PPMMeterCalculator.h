@@ -0,0 +1,97 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * PPMMeterCalculator applies peak programme meter ballistics (IEC 60268-10
+ * type I) to a set of channels: a rectifier charges the reading so that a
+ * 10 ms burst of 5 kHz tone reads 2 dB below the steady tone, the reading
+ * falls 20 dB in 1.5 s, and a peak hold keeps the highest reading for
+ * PEAK_HOLD_SECONDS. Readings are scaled so a steady 1 kHz sine reads its
+ * peak amplitude.
+ *
+ * Between charges the reading is a pure exponential decay, solved in one
+ * step: a block whose rectified samples all stay under the decaying
+ * reading (one vectorised test) just applies the block's decay. Otherwise
+ * the reading decays in one step to each sample that charges it, and only
+ * those samples are followed exactly, as the 10 ms integration is shorter
+ * than most blocks and the standard's tone-burst readings depend on it.
+ *
+ * State is kept as one array per quantity across all channels. Not thread
+ * safe; the owner serialises configuration and processing.
+ */
+class PPMMeterCalculator {
+public:
+  /** Length of a tone burst that reads 2 dB below the steady tone, in s */
+  static constexpr double INTEGRATION_SECONDS = 0.01;
+
+  /** Time for the reading to fall by RETURN_DB, in seconds */
+  static constexpr double RETURN_SECONDS = 1.5;
+
+  /** Fall of the reading over RETURN_SECONDS, in dB */
+  static constexpr double RETURN_DB = 20.0;
+
+  /** Time the peak hold keeps the highest reading, in seconds */
+  static constexpr double PEAK_HOLD_SECONDS = 2.0;
+
+  /** Constructor */
+  PPMMeterCalculator();
+
+  /**
+   * Derives the ballistics and allocates state, then resets
+   * @param sampleRate Sample rate in Hz
+   * @param numChannels Number of channels metered
+   */
+  void prepare(double sampleRate, int numChannels);
+
+  /** @return Number of prepared channels */
+  int getNumChannels() const;
+
+  /** Returns every channel and its peak hold to rest */
+  void reset();
+
+  /** Returns one channel and its peak hold to rest */
+  void resetChannel(int channel);
+
+  /**
+   * Advances the meters by one block
+   * @param inputs One pointer per channel; nullptr is metered as silence
+   * @param numInputs Channels to process; the rest are left untouched
+   * @param numSamples Number of samples
+   */
+  void process(const float *const *inputs, int numInputs, int numSamples);
+
+  /** @return Linear reading of a channel at the end of the last block */
+  float getLevel(int channel) const;
+
+  /** @return Linear peak hold of a channel */
+  float getPeakHold(int channel) const;
+
+private:
+  /** Advances one channel by at most BLOCK_SIZE samples */
+  void advance(int channel, const float *input, int numSamples);
+
+  int numChannels = 0;
+
+  // Per-sample decay, charge rate from the rectifier, and the gain that
+  // makes a steady sine read its peak
+  float release = 1.0f;
+  float attack = 1.0f;
+  float gain = 1.0f;
+  int holdSamples = 0;
+
+  // release^n for n up to BLOCK_SIZE, and release^-n: a sample n into a
+  // block charges the reading if it exceeds the start reading once scaled
+  std::vector<float> releasePowers, chargeThresholdScales;
+  std::vector<float> scratch;
+
+  // Per-channel unscaled reading, peak hold, and samples since the hold
+  // was last raised
+  std::vector<float> levels, holds;
+  std::vector<int> holdAges;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PPMMeterCalculator)
+};
+
+} // namespace mcam
@@ -0,0 +1,217 @@
+#include "VUMeterCalculator.h"
+
+namespace mcam {
+
+namespace {
+#if JUCE_USE_SIMD
+using FloatVector = juce::dsp::SIMDRegister<float>;
+constexpr int VECTOR_SIZE = (int)FloatVector::SIMDNumElements;
+#else
+constexpr int VECTOR_SIZE = 1;
+#endif
+
+// Longest stretch advanced in one step; longer blocks are split. A
+// multiple of the vector size.
+constexpr int BLOCK_SIZE = 1024;
+
+// Fraction of a step the reading has reached after INTEGRATION_SECONDS
+constexpr double RISE_FRACTION = 0.99;
+
+// Mean of a full-wave rectified sine relative to its peak is 2 / pi
+constexpr float SINE_PEAK_PER_MEAN = juce::MathConstants<float>::halfPi;
+
+/** @return Damping ratio of a second-order response with this overshoot */
+double getDampingRatio(double overshoot) {
+  const double logOvershoot = -std::log(overshoot);
+  return logOvershoot / std::sqrt(juce::MathConstants<double>::pi *
+                                      juce::MathConstants<double>::pi +
+                                  logOvershoot * logOvershoot);
+}
+
+/**
+ * @return Time for an underdamped second-order response to first reach
+ * RISE_FRACTION of a step, in radians of its natural frequency
+ */
+double getRiseTime(double damping) {
+  const double damped = std::sqrt(1.0 - damping * damping);
+
+  const auto response = [&](double t) {
+    return 1.0 - std::exp(-damping * t) * (std::cos(damped * t) +
+                                           damping / damped *
+                                               std::sin(damped * t));
+  };
+
+  // The response rises monotonically up to its peak at pi / damped
+  double low = 0.0, high = juce::MathConstants<double>::pi / damped;
+
+  for (int i = 0; i < 64; ++i) {
+    const double mid = 0.5 * (low + high);
+    (response(mid) < RISE_FRACTION ? low : high) = mid;
+  }
+
+  return low;
+}
+
+/**
+ * Adds the sums of x[i] * a[i] and x[i] * b[i] over [start, BLOCK_SIZE).
+ * The arrays are aligned alike, so the vector part starts at the first
+ * aligned index.
+ */
+void addWeightedSums(const float *x, const float *a, const float *b,
+                     int start, float &sumA, float &sumB) {
+  int i = start;
+
+  for (; i < BLOCK_SIZE && i % VECTOR_SIZE != 0; ++i) {
+    sumA += x[i] * a[i];
+    sumB += x[i] * b[i];
+  }
+
+#if JUCE_USE_SIMD
+  auto vectorA = FloatVector::expand(0.0f);
+  auto vectorB = FloatVector::expand(0.0f);
+
+  for (; i < BLOCK_SIZE; i += VECTOR_SIZE) {
+    const auto value = FloatVector::fromRawArray(x + i);
+    vectorA = vectorA + value * FloatVector::fromRawArray(a + i);
+    vectorB = vectorB + value * FloatVector::fromRawArray(b + i);
+  }
+
+  sumA += vectorA.sum();
+  sumB += vectorB.sum();
+#endif
+
+  for (; i < BLOCK_SIZE; ++i) {
+    sumA += x[i] * a[i];
+    sumB += x[i] * b[i];
+  }
+}
+} // namespace
+
+float VUMeterCalculator::gainToVU(float level) {
+  return juce::Decibels::gainToDecibels(level) - REFERENCE_DBFS;
+}
+
+VUMeterCalculator::VUMeterCalculator() = default;
+
+void VUMeterCalculator::prepare(double sampleRate, int newNumChannels) {
+  numChannels = juce::jmax(0, newNumChannels);
+
+  // The response's poles, p and its conjugate. The output is
+  // |1 - p|^2 * Im(p w) / Im(p), where w is the state of a one-pole at p.
+  const double damping = getDampingRatio(OVERSHOOT);
+  const double naturalFrequency =
+      getRiseTime(damping) / INTEGRATION_SECONDS / sampleRate;
+  const auto pole = std::polar(
+      std::exp(-damping * naturalFrequency),
+      naturalFrequency * std::sqrt(1.0 - damping * damping));
+
+  const double gain = std::norm(1.0 - pole); // Unity at DC
+  realGain = (float)gain;
+  imagGain = (float)(gain * pole.real() / pole.imag());
+
+  storage.assign((size_t)(3 * BLOCK_SIZE + VECTOR_SIZE), 0.0f);
+#if JUCE_USE_SIMD
+  realWeights = FloatVector::getNextSIMDAlignedPtr(storage.data());
+#else
+  realWeights = storage.data();
+#endif
+  imagWeights = realWeights + BLOCK_SIZE;
+  rectified = imagWeights + BLOCK_SIZE;
+
+  // A sample of age k reaches the state as p^k
+  realDecays.resize((size_t)BLOCK_SIZE + 1);
+  imagDecays.resize((size_t)BLOCK_SIZE + 1);
+
+  for (int k = 0; k <= BLOCK_SIZE; ++k) {
+    const auto decay = std::pow(pole, k);
+    realDecays[(size_t)k] = (float)decay.real();
+    imagDecays[(size_t)k] = (float)decay.imag();
+
+    if (k < BLOCK_SIZE) {
+      const auto index = (size_t)(BLOCK_SIZE - 1 - k);
+      realWeights[index] = (float)decay.real();
+      imagWeights[index] = (float)decay.imag();
+    }
+  }
+
+  realStates.assign((size_t)numChannels, 0.0f);
+  imagStates.assign((size_t)numChannels, 0.0f);
+  realSums.assign((size_t)numChannels, 0.0f);
+  imagSums.assign((size_t)numChannels, 0.0f);
+}
+
+int VUMeterCalculator::getNumChannels() const { return numChannels; }
+
+void VUMeterCalculator::reset() {
+  std::fill(realStates.begin(), realStates.end(), 0.0f);
+  std::fill(imagStates.begin(), imagStates.end(), 0.0f);
+}
+
+void VUMeterCalculator::resetChannel(int channel) {
+  if (channel < 0 || channel >= numChannels)
+    return;
+
+  realStates[(size_t)channel] = 0.0f;
+  imagStates[(size_t)channel] = 0.0f;
+}
+
+void VUMeterCalculator::process(const float *const *inputs, int numInputs,
+                                int numSamples) {
+  numInputs = juce::jmin(numInputs, numChannels);
+
+  for (int pos = 0; pos < numSamples; pos += BLOCK_SIZE)
+    advance(inputs, numInputs, pos,
+            juce::jmin(BLOCK_SIZE, numSamples - pos));
+}
+
+void VUMeterCalculator::advance(const float *const *inputs, int numInputs,
+                                int startSample, int numSamples) {
+  if (numInputs <= 0 || numSamples <= 0)
+    return;
+
+  // The block ends with the youngest weights, so it starts this far in
+  const int start = BLOCK_SIZE - numSamples;
+
+  for (int ch = 0; ch < numInputs; ++ch) {
+    float realSum = 0.0f, imagSum = 0.0f;
+
+    if (inputs[ch] != nullptr) {
+      juce::FloatVectorOperations::abs(rectified + start,
+                                       inputs[ch] + startSample, numSamples);
+      addWeightedSums(rectified, realWeights, imagWeights, start, realSum,
+                      imagSum);
+    }
+
+    realSums[(size_t)ch] = realSum;
+    imagSums[(size_t)ch] = imagSum;
+  }
+
+  // Rotate and decay the state by p^n onto the sums, then take them over
+  const float realDecay = realDecays[(size_t)numSamples];
+  const float imagDecay = imagDecays[(size_t)numSamples];
+
+  juce::FloatVectorOperations::addWithMultiply(
+      realSums.data(), realStates.data(), realDecay, numInputs);
+  juce::FloatVectorOperations::addWithMultiply(
+      realSums.data(), imagStates.data(), -imagDecay, numInputs);
+  juce::FloatVectorOperations::addWithMultiply(
+      imagSums.data(), realStates.data(), imagDecay, numInputs);
+  juce::FloatVectorOperations::addWithMultiply(
+      imagSums.data(), imagStates.data(), realDecay, numInputs);
+
+  juce::FloatVectorOperations::copy(realStates.data(), realSums.data(),
+                                    numInputs);
+  juce::FloatVectorOperations::copy(imagStates.data(), imagSums.data(),
+                                    numInputs);
+}
+
+float VUMeterCalculator::getLevel(int channel) const {
+  if (channel < 0 || channel >= numChannels)
+    return 0.0f;
+
+  return (realGain * realStates[(size_t)channel] +
+          imagGain * imagStates[(size_t)channel]) *
+         SINE_PEAK_PER_MEAN;
+}
+
+} // namespace mcam
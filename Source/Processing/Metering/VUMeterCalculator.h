@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../../JuceHeader.h"
+
+namespace mcam {
+/**
+ * VUMeterCalculator applies VU ballistics (IEC 60268-17) to a set of
+ * channels: the full-wave rectified signal drives a slightly underdamped
+ * second-order response, like the needle of a VU meter, that reaches 99%
+ * of a step in 300 ms and overshoots it by 1.25%, scaled so a steady sine
+ * reads its peak amplitude.
+ *
+ * The response is linear, so it is advanced once per block rather than
+ * once per sample. Its state is a complex one-pole whose output's real and
+ * imaginary parts are kept per channel: after n samples it is the rotated,
+ * decayed state plus a weighted sum of the block's rectified samples, with
+ * the weights tabulated by sample age in prepare(). Readings are exact at
+ * block ends.
+ *
+ * State is kept as one array per quantity across all channels, and the
+ * per-block update runs over those arrays, so hundreds of channels cost
+ * little beyond rectifying and summing their samples.
+ *
+ * Not thread safe; the owner serialises configuration and processing.
+ */
+class VUMeterCalculator {
+public:
+  /** Time for the reading to reach 99% of a step, in seconds */
+  static constexpr double INTEGRATION_SECONDS = 0.3;
+
+  /** Overshoot of a step, as a fraction of the final reading (1 to 1.5%) */
+  static constexpr double OVERSHOOT = 0.0125;
+
+  /** Level in dBFS of a sine reading 0 VU */
+  static constexpr float REFERENCE_DBFS = -20.0f;
+
+  /**
+   * @param level Linear reading from getLevel()
+   * @return The reading in VU
+   */
+  static float gainToVU(float level);
+
+  /** Constructor */
+  VUMeterCalculator();
+
+  /**
+   * Tabulates the response and allocates state, then resets
+   * @param sampleRate Sample rate in Hz
+   * @param numChannels Number of channels metered
+   */
+  void prepare(double sampleRate, int numChannels);
+
+  /** @return Number of prepared channels */
+  int getNumChannels() const;
+
+  /** Returns every channel to rest */
+  void reset();
+
+  /** Returns one channel to rest, e.g. when its meter is switched on */
+  void resetChannel(int channel);
+
+  /**
+   * Advances the meters by one block
+   * @param inputs One pointer per channel; nullptr is metered as silence
+   * @param numInputs Channels to process; the rest are left untouched
+   * @param numSamples Number of samples
+   */
+  void process(const float *const *inputs, int numInputs, int numSamples);
+
+  /** @return Linear reading of a channel at the end of the last block */
+  float getLevel(int channel) const;
+
+private:
+  /** Advances the first numInputs channels by at most BLOCK_SIZE samples */
+  void advance(const float *const *inputs, int numInputs, int startSample,
+               int numSamples);
+
+  int numChannels = 0;
+
+  // Contribution of a rectified sample to the real and imaginary parts of
+  // the state by its age at the end of a block (oldest first), and the
+  // rectified block itself
+  std::vector<float> storage;
+  float *realWeights = nullptr;
+  float *imagWeights = nullptr;
+  float *rectified = nullptr;
+
+  // The pole raised to n: how the state rotates and decays over n samples
+  std::vector<float> realDecays, imagDecays;
+
+  // The reading from the state's real and imaginary parts
+  float realGain = 0.0f, imagGain = 0.0f;
+
+  // Per-channel state, and the weighted sums of the block being advanced
+  std::vector<float> realStates, imagStates;
+  std::vector<float> realSums, imagSums;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VUMeterCalculator)
+};
+
+} // namespace mcam
@@ -0,0 +1,84 @@
+#include "AlarmBannerComponent.h"
+
+namespace mcam {
+
+namespace {
+// Polls per second
+constexpr int REFRESH_RATE = 5;
+} // namespace
+
+AlarmBannerComponent::AlarmBannerComponent() {
+  LOG_DEBUG("AlarmBannerComponent constructor");
+  startTimerHz(REFRESH_RATE);
+}
+
+AlarmBannerComponent::~AlarmBannerComponent() {
+  LOG_DEBUG("AlarmBannerComponent destructor");
+  stopTimer();
+}
+
+void AlarmBannerComponent::paint(juce::Graphics &g) {
+  const auto bounds = getLocalBounds().toFloat();
+
+  g.setColour(numActive > 0 ? juce::Colours::darkred : juce::Colours::darkgrey);
+  g.fillRoundedRectangle(bounds, 4.0f);
+
+  g.setColour(juce::Colours::white);
+  g.setFont(14.0f);
+  g.drawText(getText(), getLocalBounds().reduced(8, 0),
+             juce::Justification::centredLeft, true);
+}
+
+void AlarmBannerComponent::setAlarmEngine(const AlarmEngine *engine) {
+  if (engine == alarmEngine)
+    return;
+
+  alarmEngine = engine;
+  cursor = 0;
+  numActive = 0;
+  latestChange.clear();
+
+  timerCallback();
+  repaint();
+}
+
+juce::String AlarmBannerComponent::getText() const {
+  if (alarmEngine == nullptr)
+    return {};
+
+  auto text = numActive == 0   ? juce::String("No alarms")
+              : numActive == 1 ? juce::String("1 alarm")
+                               : juce::String(numActive) + " alarms";
+
+  if (latestChange.isNotEmpty())
+    text << " - " << latestChange;
+
+  return text;
+}
+
+void AlarmBannerComponent::timerCallback() {
+  if (alarmEngine == nullptr)
+    return;
+
+  bool changed = false;
+  int numRead = 0;
+
+  // Only the newest change is shown; older ones are skipped over
+  while ((numRead = alarmEngine->readEvents(cursor, events.data(),
+                                            (int)events.size())) > 0) {
+    const auto &event = events[(size_t)numRead - 1];
+    latestChange = juce::String(event.raised ? "raised: " : "cleared: ") +
+                   AlarmEngine::getTypeName(event.type) + " on input " +
+                   juce::String(event.channel + 1);
+    changed = true;
+  }
+
+  const int newNumActive = alarmEngine->getNumActive();
+  changed = changed || newNumActive != numActive;
+  numActive = newNumActive;
+
+  if (changed)
+    repaint();
+}
+
+} // namespace mcam
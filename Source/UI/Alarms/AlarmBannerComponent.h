@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../JuceHeader.h"
+#include "../../Processing/Analysis/AlarmEngine.h"
+
+namespace mcam {
+/**
+ * A one-line alarm summary: the number of raised alarms and the latest
+ * change, on red while any alarm is raised.
+ *
+ * It reads the engine's active flags and event queue with its own cursor
+ * and repaints only when either has changed.
+ */
+class AlarmBannerComponent : public juce::Component, public juce::Timer {
+public:
+  /** Constructor */
+  AlarmBannerComponent();
+
+  /** Destructor */
+  ~AlarmBannerComponent() override;
+
+  /** Paint the component */
+  void paint(juce::Graphics &g) override;
+
+  /**
+   * Sets the engine shown
+   * @param engine An engine that outlives this component, or nullptr to
+   * show nothing
+   */
+  void setAlarmEngine(const AlarmEngine *engine);
+
+  /** @return The text shown, e.g. "2 alarms - raised: silence on input 3" */
+  juce::String getText() const;
+
+  /** Timer callback that picks up new events */
+  void timerCallback() override;
+
+private:
+  const AlarmEngine *alarmEngine = nullptr;
+  juce::int64 cursor = 0;
+
+  int numActive = 0;
+  juce::String latestChange;
+
+  // Events read per poll (message thread only)
+  std::array<AlarmEngine::Event, 16> events;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AlarmBannerComponent)
+};
+
+} // namespace mcam
@@ -35,7 +35,8 @@ void MeterComponent::paint(juce::Graphics &g) {
   g.setColour(juce::Colours::black);
   g.fillRect(meterBounds);
 
-  // Calculate level height
+  // Calculate level height (meterBounds shrinks to the unlit part)
+  const auto scaleBounds = meterBounds;
   int levelHeight = static_cast<int>(currentLevel * meterBounds.getHeight());
   auto levelBounds = meterBounds.removeFromBottom(levelHeight);
 
@@ -49,6 +50,14 @@ void MeterComponent::paint(juce::Graphics &g) {
   g.setGradientFill(gradient);
   g.fillRect(levelBounds);
 
+  // Draw peak hold mark
+  if (peakHoldLevel > 0.0f) {
+    int holdY = scaleBounds.getBottom() -
+                static_cast<int>(peakHoldLevel * scaleBounds.getHeight());
+    g.setColour(juce::Colours::white);
+    g.fillRect(scaleBounds.getX(), holdY - 1, scaleBounds.getWidth(), 2);
+  }
+
   // Draw scale marks
   g.setColour(juce::Colours::grey);
   float dbMarks[] = {0.0f,   -3.0f,  -6.0f,  -12.0f,
@@ -63,6 +72,12 @@ void MeterComponent::paint(juce::Graphics &g) {
     g.drawText(juce::String(static_cast<int>(db)), meterBounds.getRight() + 2,
                y - 5, 20, 10, juce::Justification::left, false);
   }
+
+  // The level is on screen: close the latency measurement
+  if (pendingStamp.isValid()) {
+    LatencyTracker::getInstance().recordPainted(pendingStamp);
+    pendingStamp = {};
+  }
 }
 
 void MeterComponent::resized() {
@@ -75,6 +90,15 @@ void MeterComponent::setLevel(float level) {
   repaint();
 }
 
+void MeterComponent::setPeakHold(float level) {
+  peakHoldLevel = juce::jlimit(0.0f, 1.0f, level);
+  repaint();
+}
+
+void MeterComponent::setLatencyStamp(const LatencyTracker::Stamp &stamp) {
+  pendingStamp = stamp;
+}
+
 void MeterComponent::setTitle(const juce::String &title) {
   meterTitle = title;
   repaint();
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../../Core/LatencyTracker.h"
 #include "../../Core/Logger.h"
 #include "../../JuceHeader.h"
 
@@ -28,11 +29,26 @@ public:
    */
   void setLevel(float level);
 
+  /**
+   * Update the peak hold mark; 0 hides it
+   * @param level Hold level on the same scale as setLevel (0.0 to 1.0)
+   */
+  void setPeakHold(float level);
+
+  /**
+   * Attaches the latency stamp of the level just set. It is recorded with
+   * the LatencyTracker once the new level has been painted.
+   * @param stamp Stamp carried from the audio thread
+   */
+  void setLatencyStamp(const LatencyTracker::Stamp &stamp);
+
   /** Set the meter title */
   void setTitle(const juce::String &title);
 
 private:
   float currentLevel = 0.0f;
+  float peakHoldLevel = 0.0f;
+  LatencyTracker::Stamp pendingStamp;
   juce::String meterTitle;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterComponent)
@@ -0,0 +1,197 @@
+#include "TrendComponent.h"
+
+namespace mcam {
+
+namespace {
+// Display refresh rate in Hz; the finest entries are 100 ms apart
+constexpr int REFRESH_RATE = 5;
+
+// Lowest level shown, in dB, as on the slot meter
+constexpr float FLOOR_DB = -60.0f;
+
+// Selectable spans in seconds (item ID is index + 1)
+constexpr double SPAN_CHOICES[] = {60.0, 600.0, 3600.0};
+
+juce::String spanLabel(double seconds) {
+  return seconds < 3600.0 ? juce::String(juce::roundToInt(seconds / 60.0)) +
+                                " min"
+                          : juce::String(juce::roundToInt(seconds / 3600.0)) +
+                                " h";
+}
+
+/** @return The level as a fraction of the height, 0 at FLOOR_DB */
+float toScale(float level) {
+  return juce::jlimit(0.0f, 1.0f,
+                      juce::jmap(juce::Decibels::gainToDecibels(level),
+                                 FLOOR_DB, 0.0f, 0.0f, 1.0f));
+}
+} // namespace
+
+TrendComponent::TrendComponent() {
+  LOG_DEBUG("TrendComponent constructor");
+
+  // Set default title
+  trendTitle = "Trend";
+
+  entries.resize((size_t)LevelHistory::CAPACITY);
+
+  for (size_t i = 0; i < std::size(SPAN_CHOICES); ++i)
+    spanSelector.addItem(spanLabel(SPAN_CHOICES[i]), (int)i + 1);
+
+  spanSelector.onChange = [this]() {
+    const int index = spanSelector.getSelectedId() - 1;
+
+    if (index >= 0 && index < (int)std::size(SPAN_CHOICES))
+      setSpanSeconds(SPAN_CHOICES[index]);
+  };
+  spanSelector.setSelectedId((int)std::size(SPAN_CHOICES),
+                             juce::dontSendNotification);
+  addAndMakeVisible(spanSelector);
+
+  startTimerHz(REFRESH_RATE);
+}
+
+TrendComponent::~TrendComponent() {
+  LOG_DEBUG("TrendComponent destructor");
+  stopTimer();
+}
+
+void TrendComponent::paint(juce::Graphics &g) {
+  auto bounds = getLocalBounds();
+
+  // Draw background
+  g.setColour(juce::Colours::darkgrey);
+  g.fillRoundedRectangle(bounds.toFloat(), 4.0f);
+
+  // Draw border
+  g.setColour(juce::Colours::grey);
+  g.drawRoundedRectangle(bounds.toFloat().reduced(0.5f), 4.0f, 1.0f);
+
+  // Draw title
+  g.setColour(juce::Colours::white);
+  g.setFont(14.0f);
+  g.drawText(trendTitle, bounds.removeFromTop(20),
+             juce::Justification::centred, true);
+
+  // Draw trend
+  const auto trendBounds = bounds.reduced(4).toFloat();
+
+  // Background
+  g.setColour(juce::Colours::black);
+  g.fillRect(trendBounds);
+
+  // Scale marks
+  g.setColour(juce::Colours::grey.withAlpha(0.5f));
+  for (float db : {-12.0f, -24.0f, -36.0f, -48.0f}) {
+    const float y = trendBounds.getBottom() -
+                    toScale(juce::Decibels::decibelsToGain(db)) *
+                        trendBounds.getHeight();
+    g.drawHorizontalLine(juce::roundToInt(y), trendBounds.getX(),
+                         trendBounds.getRight());
+  }
+
+  const int numColumns = juce::jmax(1, (int)trendBounds.getWidth());
+
+  if (history == nullptr)
+    return;
+
+  // The coarsest resolution with an entry per pixel, unless it is too
+  // short to cover the span
+  int resolution = LevelHistory::findResolution(spanSeconds / numColumns);
+  while (resolution + 1 < LevelHistory::NUM_RESOLUTIONS &&
+         LevelHistory::getResolutionSeconds(resolution) *
+                 LevelHistory::CAPACITY <
+             spanSeconds)
+    ++resolution;
+
+  const int numWanted = juce::jlimit(
+      1, LevelHistory::CAPACITY,
+      (int)std::ceil(spanSeconds /
+                     LevelHistory::getResolutionSeconds(resolution)));
+  const int numRead = history->read(resolution, entries.data(), numWanted);
+
+  // The newest entry is at the right edge
+  const int missing = numWanted - numRead;
+  const float columnWidth = trendBounds.getWidth() / (float)numColumns;
+  const float bottom = trendBounds.getBottom();
+  const float height = trendBounds.getHeight();
+
+  juce::RectangleList<float> band;
+  band.ensureStorageAllocated(numColumns);
+  juce::Path meanLine;
+
+  for (int column = 0; column < numColumns; ++column) {
+    // A column covers at least one entry; on short spans, where entries
+    // are wider than a pixel, neighbouring columns share one
+    const int start = (int)((juce::int64)column * numWanted / numColumns);
+    const int last = juce::jmax(
+        start + 1, (int)((juce::int64)(column + 1) * numWanted / numColumns));
+
+    // Columns before the history stay empty
+    if (last <= missing)
+      continue;
+
+    const int first = juce::jmax(start, missing);
+
+    float low = entries[(size_t)(first - missing)].min, high = 0.0f;
+    float meanSum = 0.0f;
+
+    for (int index = first; index < last; ++index) {
+      const auto &entry = entries[(size_t)(index - missing)];
+      low = juce::jmin(low, entry.min);
+      high = juce::jmax(high, entry.max);
+      meanSum += entry.mean;
+    }
+
+    const float x = trendBounds.getX() + column * columnWidth;
+    const float top = bottom - toScale(high) * height;
+    band.addWithoutMerging(
+        {x, top, columnWidth,
+         juce::jmax(1.0f, toScale(high) * height - toScale(low) * height)});
+
+    const float meanY = bottom - toScale(meanSum / (last - first)) * height;
+    if (meanLine.isEmpty())
+      meanLine.startNewSubPath(x, meanY);
+    else
+      meanLine.lineTo(x, meanY);
+  }
+
+  g.setColour(juce::Colours::green.withAlpha(0.6f));
+  g.fillRectList(band);
+
+  g.setColour(juce::Colours::yellow);
+  g.strokePath(meanLine, juce::PathStrokeType(1.0f));
+}
+
+void TrendComponent::resized() {
+  // The span control shares the title row, on the right
+  auto controls = getLocalBounds().removeFromTop(20).reduced(2, 1);
+  spanSelector.setBounds(controls.removeFromRight(70));
+}
+
+void TrendComponent::setTitle(const juce::String &title) {
+  trendTitle = title;
+  repaint();
+}
+
+void TrendComponent::setHistory(const LevelHistory *newHistory) {
+  if (newHistory == history)
+    return;
+
+  history = newHistory;
+  repaint();
+}
+
+void TrendComponent::setSpanSeconds(double seconds) {
+  spanSeconds = juce::jmax(1.0, seconds);
+  repaint();
+}
+
+double TrendComponent::getSpanSeconds() const { return spanSeconds; }
+
+void TrendComponent::timerCallback() {
+  if (history != nullptr && isShowing())
+    repaint();
+}
+
+} // namespace mcam
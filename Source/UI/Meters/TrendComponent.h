@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../JuceHeader.h"
+#include "../../Processing/Metering/LevelHistory.h"
+
+namespace mcam {
+/**
+ * A level trend over the last minute to hour of one channel, drawn from a
+ * LevelHistory: the range of each pixel's entries as a band, with their
+ * mean as a line, on the meter's -60 to 0 dB scale.
+ *
+ * Each paint reads the coarsest resolution that still gives every pixel
+ * at least one entry, so the cost depends on the width rather than on the
+ * span shown.
+ */
+class TrendComponent : public juce::Component, public juce::Timer {
+public:
+  /** Constructor */
+  TrendComponent();
+
+  /** Destructor */
+  ~TrendComponent() override;
+
+  /** Paint the component */
+  void paint(juce::Graphics &g) override;
+
+  /** Handle resize events */
+  void resized() override;
+
+  /** Set the trend title */
+  void setTitle(const juce::String &title);
+
+  /**
+   * Sets the history shown
+   * @param history A history that outlives this component, or nullptr to
+   * show nothing
+   */
+  void setHistory(const LevelHistory *history);
+
+  /**
+   * Sets the length of time shown
+   * @param seconds Span in seconds, ending now
+   */
+  void setSpanSeconds(double seconds);
+
+  /** @return The length of time shown, in seconds */
+  double getSpanSeconds() const;
+
+  /** Timer callback that repaints while the trend is showing */
+  void timerCallback() override;
+
+private:
+  juce::String trendTitle;
+
+  // Span selection
+  juce::ComboBox spanSelector;
+
+  const LevelHistory *history = nullptr;
+  double spanSeconds = 3600.0;
+
+  // Entries read for one paint (message thread only)
+  std::vector<LevelHistory::Entry> entries;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrendComponent)
+};
+
+} // namespace mcam
@@ -3,7 +3,19 @@
 namespace mcam {
 
 MonitoringSlotComponent::MonitoringSlotComponent(int slotIndex)
-    : slotIndex(slotIndex), bufferProcessor(nullptr) {
+    : slotIndex(slotIndex), bufferProcessor(nullptr),
+      metricLabels("slot=\"" + juce::String(slotIndex) + "\""),
+      handoffPosted(MetricsRegistry::getInstance().counter(
+          "mcam_ui_handoff_posted_total",
+          "Level updates posted from the audio thread to the UI",
+          metricLabels)),
+      handoffDelivered(MetricsRegistry::getInstance().counter(
+          "mcam_ui_handoff_delivered_total",
+          "Level updates applied on the message thread", metricLabels)),
+      handoffCoalesced(MetricsRegistry::getInstance().counter(
+          "mcam_ui_handoff_dropped_total",
+          "Level updates superseded before the UI consumed them",
+          metricLabels)) {
   LOG_DEBUG("MonitoringSlotComponent constructor - slot: " +
             juce::String(slotIndex));
 
@@ -17,10 +29,8 @@ MonitoringSlotComponent::MonitoringSlotComponent(int slotIndex)
 
   channelSelector.setTextWhenNothingSelected("None");
   channelSelector.onChange = [this, slot = this->slotIndex]() {
-    if (bufferProcessor != nullptr &&
-        channelSelector.getSelectedItemIndex() >= 0) {
-      int channelIndex =
-          channelSelector.getSelectedItemIndex() - 1; // -1 = None
+    if (bufferProcessor != nullptr && channelSelector.getSelectedId() > 0) {
+      int channelIndex = channelSelector.getSelectedId() - 2; // -1 = None
       LOG_INFO("Channel selected for slot " + juce::String(slot) + ": " +
                juce::String(channelIndex));
 
@@ -30,22 +40,80 @@ MonitoringSlotComponent::MonitoringSlotComponent(int slotIndex)
   };
   addAndMakeVisible(channelSelector);
 
+  // Setup port picker, which rewires the slot's input in the audio graph
+  portButton.setButtonText("Port");
+  portButton.setTooltip("Connect a port of the JACK graph to this slot");
+  portButton.onClick = [this]() { showPortMenu(); };
+  addAndMakeVisible(portButton);
+
+  // Setup meter type selector
+  meterTypeSelector.addItem("VU", 1);
+  meterTypeSelector.addItem("PPM", 2);
+  meterTypeSelector.setSelectedId(1, juce::dontSendNotification);
+  meterTypeSelector.onChange = [this, slot = this->slotIndex]() {
+    const auto type = meterTypeSelector.getSelectedId() == 2
+                          ? BufferProcessor::MeterType::ppm
+                          : BufferProcessor::MeterType::vu;
+    meter.setTitle(meterTypeSelector.getText());
+
+    if (bufferProcessor != nullptr)
+      bufferProcessor->setSlotMeterType(slot, type);
+  };
+  addAndMakeVisible(meterTypeSelector);
+
   // Setup meter
-  meter.setTitle("Level");
+  meter.setTitle("VU");
   addAndMakeVisible(meter);
 
   // Setup RTA
   rta.setTitle("Spectrum");
   addAndMakeVisible(rta);
 
-  // Random test level for now
-  startTimerHz(15); // Update at 15 Hz
+  // Setup scope and level trend, shown in place of the RTA
+  scope.setTitle("Scope");
+  addChildComponent(scope);
+
+  trend.setTitle("Trend");
+  addChildComponent(trend);
+
+  viewSelector.addItem("Spectrum", 1);
+  viewSelector.addItem("Scope", 2);
+  viewSelector.addItem("Trend", 3);
+  viewSelector.setSelectedId(1, juce::dontSendNotification);
+  viewSelector.onChange = [this]() {
+    const int view = viewSelector.getSelectedId();
+    const bool showScope = view == 2;
+    rta.setVisible(view == 1);
+    scope.setVisible(showScope);
+    trend.setVisible(view == 3);
+
+    // The processor only queues the slot's samples while the scope shows
+    if (bufferProcessor != nullptr)
+      bufferProcessor->setSlotSamplesTapped(slotIndex, showScope);
+  };
+  addAndMakeVisible(viewSelector);
+
+  // Queue depth between the audio thread and the UI, one series per slot
+  MetricsRegistry::getInstance()
+      .gauge("mcam_ui_handoff_queue_depth",
+             "Level updates waiting for the message thread", metricLabels)
+      .setProvider([&posted = handoffPosted, &delivered = handoffDelivered] {
+        return (double)(posted.getValue() - delivered.getValue());
+      });
+
+  // Also polls the levels the audio thread hands over
+  startTimerHz(30); // Update at 30 Hz
 }
 
 MonitoringSlotComponent::~MonitoringSlotComponent() {
   LOG_DEBUG("MonitoringSlotComponent destructor - slot: " +
             juce::String(slotIndex));
   stopTimer();
+
+  // Detach the scrape-time provider registered for this slot
+  MetricsRegistry::getInstance()
+      .gauge("mcam_ui_handoff_queue_depth", {}, metricLabels)
+      .setProvider(nullptr);
 }
 
 void MonitoringSlotComponent::paint(juce::Graphics &g) {
@@ -75,12 +143,17 @@ void MonitoringSlotComponent::resized() {
   // Channel selector area
   auto controlsArea = bounds.removeFromTop(30);
   channelLabel.setBounds(controlsArea.removeFromLeft(80).reduced(5, 0));
+  meterTypeSelector.setBounds(controlsArea.removeFromRight(80).reduced(5, 0));
+  portButton.setBounds(controlsArea.removeFromRight(60).reduced(5, 0));
+  viewSelector.setBounds(controlsArea.removeFromRight(100).reduced(5, 0));
   channelSelector.setBounds(controlsArea.reduced(5, 0));
 
   // Equal space for meter and RTA
   auto meterWidth = getWidth() / 4;
   meter.setBounds(bounds.removeFromLeft(meterWidth).reduced(10));
   rta.setBounds(bounds.reduced(10));
+  scope.setBounds(bounds.reduced(10));
+  trend.setBounds(bounds.reduced(10));
 }
 
 void MonitoringSlotComponent::setTitle(const juce::String &title) {
@@ -96,53 +169,165 @@ void MonitoringSlotComponent::connectToBufferProcessor(
 
   if (bufferProcessor != nullptr) {
     // Populate channel selector
-    channelSelector.clear();
-
-    // Add "None" option
-    channelSelector.addItem("None", 1);
+    updateChannelItems();
 
-    // Add all possible channels (up to 32)
-    for (int i = 0; i < 32; ++i) {
-      channelSelector.addItem("Channel " + juce::String(i + 1), i + 2);
-    }
+    // Show the slot's meter type
+    const bool isPpm = bufferProcessor->getSlotMeterType(slotIndex) ==
+                       BufferProcessor::MeterType::ppm;
+    meterTypeSelector.setSelectedId(isPpm ? 2 : 1, juce::dontSendNotification);
+    meter.setTitle(meterTypeSelector.getText());
 
-    // Select current channel for this slot
-    int currentChannel = bufferProcessor->getMonitorChannel(slotIndex);
-
-    if (currentChannel >= 0) {
-      channelSelector.setSelectedItemIndex(currentChannel + 1);
-    } else {
-      channelSelector.setSelectedItemIndex(0); // None
-    }
+    // The scope reads the slot's samples from the processor's tap
+    scope.setSource(bufferProcessor->getSlotSamples(slotIndex));
+    bufferProcessor->setSlotSamplesTapped(slotIndex,
+                                          viewSelector.getSelectedId() == 2);
 
     // Register for buffer updates
     bufferProcessor->addBufferCallback(
         [this](int slot, const juce::AudioBuffer<float> &buffer) {
           if (slot == slotIndex && buffer.getNumSamples() > 0) {
-            // Calculate RMS level for meter
-            float sum = 0.0f;
-
-            auto *data = buffer.getReadPointer(0);
-            for (int i = 0; i < buffer.getNumSamples(); ++i) {
-              sum += data[i] * data[i];
+            // The processor has already applied the slot's ballistics
+            // to this block; map -60 dB to 0 dB to the 0.0-1.0 range
+            auto toMeterScale = [](float gain) {
+              return juce::jmap(juce::Decibels::gainToDecibels(gain), -60.0f,
+                                0.0f, 0.0f, 1.0f);
+            };
+
+            float level =
+                toMeterScale(bufferProcessor->getSlotMeterLevel(slot));
+            pendingPeakHold.store(
+                toMeterScale(bufferProcessor->getSlotMeterPeakHold(slot)),
+                std::memory_order_relaxed);
+
+            pendingLevel.store(level, std::memory_order_relaxed);
+
+            const auto stamp = bufferProcessor->getSlotStamp(slot);
+            if (stamp.isValid()) {
+              const juce::SpinLock::ScopedTryLockType tryLock(stampLock);
+              if (tryLock.isLocked())
+                pendingStamp = stamp;
             }
 
-            float rms = std::sqrt(sum / buffer.getNumSamples());
-
-            // Convert to dB for more musical display
-            float db = juce::Decibels::gainToDecibels(rms);
-            // Map -60dB to 0dB to 0.0-1.0 range
-            float level = juce::jmap(db, -60.0f, 0.0f, 0.0f, 1.0f);
-
-            // Update on message thread
-            juce::MessageManager::callAsync(
-                [this, level]() { this->setLevel(level); });
+            // The timer picks the level up; posting a message from here
+            // would allocate
+            if (levelUpdatePending.exchange(true))
+              handoffCoalesced.add();
+            else
+              handoffPosted.add();
           }
         });
   }
 }
 
+void MonitoringSlotComponent::updateChannelItems() {
+  shownDerivedRevision = bufferProcessor->getDerivedChannelsRevision();
+  channelSelector.clear(juce::dontSendNotification);
+
+  // Add "None" option
+  channelSelector.addItem("None", 1);
+
+  // Add all possible channels (up to 32)
+  for (int i = 0; i < 32; ++i) {
+    channelSelector.addItem("Channel " + juce::String(i + 1), i + 2);
+  }
+
+  // Add the derived channels that are defined
+  for (int i = 0; i < BufferProcessor::MAX_DERIVED_CHANNELS; ++i) {
+    const auto name = bufferProcessor->getDerivedChannelName(i);
+    if (name.isNotEmpty())
+      channelSelector.addItem(name,
+                              BufferProcessor::getDerivedChannelIndex(i) + 2);
+  }
+
+  // Select current channel for this slot (item ID is channel + 2)
+  int currentChannel = bufferProcessor->getMonitorChannel(slotIndex);
+  channelSelector.setSelectedId(juce::jmax(1, currentChannel + 2),
+                                juce::dontSendNotification);
+}
+
+void MonitoringSlotComponent::setChannel(int channelIndex) {
+  // Item ID 1 is "None"
+  channelSelector.setSelectedId(juce::jmax(1, channelIndex + 2),
+                                juce::sendNotificationSync);
+}
+
+void MonitoringSlotComponent::showPendingLevel() {
+  if (!levelUpdatePending.exchange(false))
+    return;
+
+  handoffDelivered.add();
+
+  LatencyTracker::Stamp stamp;
+  {
+    const juce::SpinLock::ScopedLockType sl(stampLock);
+    std::swap(stamp, pendingStamp);
+  }
+
+  if (stamp.isValid()) {
+    stamp.publishNs = LatencyTracker::nowNs();
+    meter.setLatencyStamp(stamp);
+  }
+
+  setLevel(pendingLevel.load());
+  meter.setPeakHold(pendingPeakHold.load());
+
+  if (!firstLevelShown) {
+    firstLevelShown = true;
+
+    if (onFirstLevel != nullptr)
+      onFirstLevel();
+  }
+}
+
+void MonitoringSlotComponent::showPortMenu() {
+  const auto ports =
+      getSourcePorts != nullptr ? getSourcePorts() : juce::StringArray();
+
+  juce::PopupMenu menu;
+
+  if (ports.isEmpty())
+    menu.addItem(1, "No ports (needs the JACK device)", false);
+
+  // Item IDs are port index + 1
+  for (int i = 0; i < ports.size(); ++i)
+    menu.addItem(i + 1, ports[i]);
+
+  menu.showMenuAsync(
+      juce::PopupMenu::Options().withTargetComponent(&portButton),
+      [safeThis = juce::Component::SafePointer<MonitoringSlotComponent>(this),
+       ports](int result) {
+        if (safeThis == nullptr || result <= 0 || result > ports.size() ||
+            safeThis->onSourcePortSelected == nullptr)
+          return;
+
+        LOG_INFO("Port selected for slot " + juce::String(safeThis->slotIndex) +
+                 ": " + ports[result - 1]);
+        safeThis->onSourcePortSelected(ports[result - 1]);
+      });
+}
+
 void MonitoringSlotComponent::timerCallback() {
+  showPendingLevel();
+
+  if (bufferProcessor != nullptr) {
+    scope.setSampleRate(bufferProcessor->getSampleRate());
+
+    // Derived channels may be defined or renamed from elsewhere, e.g. OSC
+    if (bufferProcessor->getDerivedChannelsRevision() != shownDerivedRevision)
+      updateChannelItems();
+
+    // So may the routing, e.g. by OSC or when a port is picked
+    const int channelId =
+        juce::jmax(1, bufferProcessor->getMonitorChannel(slotIndex) + 2);
+    if (channelSelector.getSelectedId() != channelId &&
+        !channelSelector.isPopupActive())
+      channelSelector.setSelectedId(channelId, juce::dontSendNotification);
+
+    // Derived channels have no history, so the trend goes blank
+    trend.setHistory(bufferProcessor->getChannelHistory(
+        bufferProcessor->getMonitorChannel(slotIndex)));
+  }
+
   // For testing, generate random levels
   if (bufferProcessor == nullptr) {
     float testLevel = static_cast<float>(rand()) / RAND_MAX;
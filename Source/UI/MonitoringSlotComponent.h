@@ -2,14 +2,18 @@
 
 #include "../Audio/Processing/BufferProcessor.h"
 #include "../Core/Logger.h"
+#include "../Core/Metrics.h"
 #include "../JuceHeader.h"
 #include "Meters/MeterComponent.h"
+#include "Meters/TrendComponent.h"
 #include "RTA/RTAComponent.h"
+#include "Scope/ScopeComponent.h"
 
 namespace mcam {
 /**
  * A component that represents a single monitoring slot.
- * Contains a meter and RTA display for one audio channel.
+ * Contains a meter and an RTA, scope or level trend display for one audio
+ * channel.
  */
 class MonitoringSlotComponent : public juce::Component, public juce::Timer {
 public:
@@ -43,10 +47,37 @@ public:
    */
   void connectToBufferProcessor(BufferProcessor *processor);
 
+  /**
+   * Selects the channel shown in this slot, as if chosen in the selector
+   * @param channelIndex Input channel index, or -1 for none
+   */
+  void setChannel(int channelIndex);
+
+  /** Called on the message thread when the first audio level is shown */
+  std::function<void()> onFirstLevel;
+
+  /**
+   * Lists the ports that can be connected to this slot, e.g. the JACK
+   * graph's sources; offered by the port button when set
+   */
+  std::function<juce::StringArray()> getSourcePorts;
+
+  /** Called with the full name of the port picked for this slot */
+  std::function<void(const juce::String &)> onSourcePortSelected;
+
   /** Timer callback for animations and updates */
   void timerCallback() override;
 
 private:
+  /** Lists the inputs and the defined derived channels in the selector */
+  void updateChannelItems();
+
+  /** Shows the level the audio thread left, if it left a new one */
+  void showPendingLevel();
+
+  /** Offers the source ports in a menu and connects the one picked */
+  void showPortMenu();
+
   int slotIndex;
   juce::String slotTitle;
 
@@ -54,13 +85,45 @@ private:
   juce::ComboBox channelSelector;
   juce::Label channelLabel;
 
+  // Derived channel revision the selector items were built from
+  int shownDerivedRevision = -1;
+
+  // Connects a port of the audio graph to the slot (JACK only)
+  juce::TextButton portButton;
+
+  // Meter ballistics selection (item ID 1 = VU, 2 = PPM)
+  juce::ComboBox meterTypeSelector;
+
+  // Display selection (item ID 1 = spectrum, 2 = scope, 3 = trend)
+  juce::ComboBox viewSelector;
+
   // UI Components
   MeterComponent meter;
   RTAComponent rta;
+  ScopeComponent scope;
+  TrendComponent trend;
 
   // Pointer to the buffer processor (may be nullptr)
   BufferProcessor *bufferProcessor;
 
+  // Audio-to-UI level handoff: the audio thread only stores the latest
+  // level and the timer polls it, so newer levels overwrite a pending one
+  std::atomic<float> pendingLevel{0.0f};
+  std::atomic<float> pendingPeakHold{0.0f};
+  std::atomic<bool> levelUpdatePending{false};
+  bool firstLevelShown = false;
+
+  // Latency stamp travelling with pendingLevel (instrumented mode only).
+  // The audio thread only try-locks, so it never waits for the UI.
+  LatencyTracker::Stamp pendingStamp;
+  juce::SpinLock stampLock;
+
+  // Handoff instrumentation, one series per slot
+  juce::String metricLabels;
+  metrics::Counter &handoffPosted;
+  metrics::Counter &handoffDelivered;
+  metrics::Counter &handoffCoalesced;
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MonitoringSlotComponent)
 };
 
@@ -0,0 +1,187 @@
+#include "ScopeComponent.h"
+
+namespace mcam {
+
+namespace {
+// Samples queued between the audio thread and the UI timer: over half a
+// second at 192 kHz, far more than one timer period
+constexpr int FIFO_SIZE = 1 << 17;
+
+// Display refresh rate in Hz
+constexpr int REFRESH_RATE = 30;
+
+// Selectable window lengths in seconds (item ID is index + 1)
+constexpr double WINDOW_CHOICES[] = {0.01, 0.02, 0.05, 0.1, 0.2, 0.5,
+                                     1.0,  2.0,  5.0,  10.0, 20.0, 60.0};
+
+juce::String windowLabel(double seconds) {
+  return seconds < 1.0 ? juce::String(juce::roundToInt(seconds * 1000.0)) +
+                             " ms"
+                       : juce::String(juce::roundToInt(seconds)) + " s";
+}
+} // namespace
+
+ScopeComponent::ScopeComponent() : ownSamples(FIFO_SIZE) {
+  LOG_DEBUG("ScopeComponent constructor");
+
+  // Set default title
+  scopeTitle = "Scope";
+
+  columns.resize((size_t)MAX_COLUMNS);
+  pyramid.prepare(sampleRate, MAX_WINDOW_SECONDS, MAX_COLUMNS);
+
+  for (size_t i = 0; i < std::size(WINDOW_CHOICES); ++i)
+    windowSelector.addItem(windowLabel(WINDOW_CHOICES[i]), (int)i + 1);
+
+  windowSelector.onChange = [this]() {
+    const int index = windowSelector.getSelectedId() - 1;
+
+    if (index >= 0 && index < (int)std::size(WINDOW_CHOICES))
+      setWindowSeconds(WINDOW_CHOICES[index]);
+  };
+  windowSelector.setSelectedId(2, juce::dontSendNotification);
+  addAndMakeVisible(windowSelector);
+
+  triggerButton.onClick = [this]() {
+    setTriggered(triggerButton.getToggleState());
+  };
+  addAndMakeVisible(triggerButton);
+
+  startTimerHz(REFRESH_RATE);
+}
+
+ScopeComponent::~ScopeComponent() {
+  LOG_DEBUG("ScopeComponent destructor");
+  stopTimer();
+}
+
+void ScopeComponent::paint(juce::Graphics &g) {
+  auto bounds = getLocalBounds();
+
+  // Draw background
+  g.setColour(juce::Colours::darkgrey);
+  g.fillRoundedRectangle(bounds.toFloat(), 4.0f);
+
+  // Draw border
+  g.setColour(juce::Colours::grey);
+  g.drawRoundedRectangle(bounds.toFloat().reduced(0.5f), 4.0f, 1.0f);
+
+  // Draw title
+  g.setColour(juce::Colours::white);
+  g.setFont(14.0f);
+  g.drawText(scopeTitle, bounds.removeFromTop(20),
+             juce::Justification::centred, true);
+
+  // Draw scope
+  const auto scopeBounds = bounds.reduced(4).toFloat();
+
+  // Background
+  g.setColour(juce::Colours::black);
+  g.fillRect(scopeBounds);
+
+  // Zero line and half-scale lines
+  const float centreY = scopeBounds.getCentreY();
+  const float halfHeight = scopeBounds.getHeight() * 0.5f;
+
+  g.setColour(juce::Colours::grey.withAlpha(0.5f));
+  for (float level : {-0.5f, 0.0f, 0.5f})
+    g.drawHorizontalLine(juce::roundToInt(centreY - level * halfHeight),
+                         scopeBounds.getX(), scopeBounds.getRight());
+
+  // One min/max bar per column; the column count never depends on the
+  // window length
+  const int numColumns =
+      juce::jlimit(1, MAX_COLUMNS, (int)scopeBounds.getWidth());
+  lastRenderTriggered = pyramid.render(windowSeconds, triggered, 0.0f,
+                                       columns.data(), numColumns);
+
+  const float columnWidth = scopeBounds.getWidth() / (float)numColumns;
+  juce::RectangleList<float> trace;
+  trace.ensureStorageAllocated(numColumns);
+
+  for (int column = 0; column < numColumns; ++column) {
+    const auto &range = columns[(size_t)column];
+    const float top =
+        centreY - juce::jlimit(-1.0f, 1.0f, range.max) * halfHeight;
+    const float bottom =
+        centreY - juce::jlimit(-1.0f, 1.0f, range.min) * halfHeight;
+
+    trace.addWithoutMerging({scopeBounds.getX() + column * columnWidth, top,
+                             columnWidth, juce::jmax(1.0f, bottom - top)});
+  }
+
+  g.setColour(juce::Colours::limegreen);
+  g.fillRectList(trace);
+
+  // Without a trigger point the trace runs free, as in a scope's auto mode
+  if (triggered) {
+    g.setColour(juce::Colours::white);
+    g.setFont(10.0f);
+    g.drawText(lastRenderTriggered ? "Trig'd" : "Auto",
+               scopeBounds.reduced(4.0f), juce::Justification::topLeft,
+               false);
+  }
+}
+
+void ScopeComponent::resized() {
+  // The controls share the title row, on the right
+  auto controls = getLocalBounds().removeFromTop(20).reduced(2, 1);
+  triggerButton.setBounds(controls.removeFromRight(50));
+  windowSelector.setBounds(controls.removeFromRight(70));
+}
+
+void ScopeComponent::setTitle(const juce::String &title) {
+  scopeTitle = title;
+  repaint();
+}
+
+void ScopeComponent::setSampleRate(double newSampleRate) {
+  if (newSampleRate <= 0.0 || newSampleRate == sampleRate)
+    return;
+
+  sampleRate = newSampleRate;
+
+  // Samples queued at the old rate go with the history
+  drainFifo();
+  pyramid.prepare(sampleRate, MAX_WINDOW_SECONDS, MAX_COLUMNS);
+  repaint();
+}
+
+void ScopeComponent::setWindowSeconds(double seconds) {
+  windowSeconds =
+      juce::jlimit(MIN_WINDOW_SECONDS, MAX_WINDOW_SECONDS, seconds);
+  repaint();
+}
+
+double ScopeComponent::getWindowSeconds() const { return windowSeconds; }
+
+void ScopeComponent::setTriggered(bool shouldTrigger) {
+  triggered = shouldTrigger;
+  triggerButton.setToggleState(triggered, juce::dontSendNotification);
+  repaint();
+}
+
+void ScopeComponent::pushSamples(const float *samples, int numSamples) {
+  ownSamples.push(samples, numSamples);
+}
+
+void ScopeComponent::setSource(SampleFifo *source) {
+  // What the old source queued still belongs to the history
+  drainFifo();
+  samples = source != nullptr ? source : &ownSamples;
+}
+
+void ScopeComponent::drainFifo() {
+  samples->drain([this](const float *data, int count) {
+    pyramid.push(data, count);
+  });
+}
+
+void ScopeComponent::timerCallback() {
+  drainFifo();
+
+  if (isShowing())
+    repaint();
+}
+
+} // namespace mcam
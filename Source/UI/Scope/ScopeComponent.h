@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../../Core/Logger.h"
+#include "../../JuceHeader.h"
+#include "../../Processing/Analysis/SampleFifo.h"
+#include "../../Processing/Analysis/WaveformPyramid.h"
+
+namespace mcam {
+/**
+ * A waveform display showing the last MIN_WINDOW_SECONDS to
+ * MAX_WINDOW_SECONDS of one signal, with an optional rising-edge trigger
+ * at 0 that holds periodic signals still.
+ *
+ * Samples arrive through a lock-free FIFO: the scope's own, filled by
+ * pushSamples(), or one the audio engine fills, such as a slot's sample
+ * tap in BufferProcessor. The message thread drains it into a
+ * WaveformPyramid on a timer and paints one min/max column per pixel, so
+ * painting costs the same at any window length.
+ */
+class ScopeComponent : public juce::Component, public juce::Timer {
+public:
+  /** Shortest and longest selectable windows, in seconds */
+  static constexpr double MIN_WINDOW_SECONDS = 0.01;
+  static constexpr double MAX_WINDOW_SECONDS = 60.0;
+
+  /** Widest trace drawn; wider displays stretch it */
+  static constexpr int MAX_COLUMNS = 2048;
+
+  /** Constructor */
+  ScopeComponent();
+
+  /** Destructor */
+  ~ScopeComponent() override;
+
+  /** Paint the component */
+  void paint(juce::Graphics &g) override;
+
+  /** Handle resize events */
+  void resized() override;
+
+  /** Set the scope title */
+  void setTitle(const juce::String &title);
+
+  /**
+   * Sets the rate of the pushed samples. A new rate clears the history.
+   * Call on the message thread.
+   * @param sampleRate Sample rate in Hz
+   */
+  void setSampleRate(double sampleRate);
+
+  /**
+   * Sets the length of signal shown
+   * @param seconds Window length, clamped to the selectable range
+   */
+  void setWindowSeconds(double seconds);
+
+  /** @return The length of signal shown, in seconds */
+  double getWindowSeconds() const;
+
+  /** Turns the trigger on or off */
+  void setTriggered(bool shouldTrigger);
+
+  /**
+   * Queues samples for display. Safe to call from the audio thread; it
+   * never blocks, and samples that do not fit are dropped.
+   * @param samples Input samples
+   * @param numSamples Number of samples
+   */
+  void pushSamples(const float *samples, int numSamples);
+
+  /**
+   * Reads samples from a FIFO filled elsewhere instead of pushSamples().
+   * Call on the message thread.
+   * @param source The FIFO to drain (must outlive the scope), or nullptr
+   * to go back to pushSamples()
+   */
+  void setSource(SampleFifo *source);
+
+  /** Timer callback that takes in the queued samples and repaints */
+  void timerCallback() override;
+
+private:
+  /** Moves everything queued in the FIFO into the pyramid */
+  void drainFifo();
+
+  juce::String scopeTitle;
+
+  // Window and trigger controls
+  juce::ComboBox windowSelector;
+  juce::ToggleButton triggerButton{"Trig"};
+
+  // Audio-to-UI sample handoff (single producer, single consumer): the
+  // scope's own FIFO, or the one set with setSource()
+  SampleFifo ownSamples;
+  SampleFifo *samples = &ownSamples;
+
+  // History and display state (message thread only)
+  WaveformPyramid pyramid;
+  double sampleRate = 48000.0;
+  double windowSeconds = 0.02;
+  bool triggered = false;
+  bool lastRenderTriggered = false;
+  std::vector<WaveformPyramid::Column> columns;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ScopeComponent)
+};
+
+} // namespace mcam
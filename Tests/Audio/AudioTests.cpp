@@ -1,138 +1,1355 @@
 #include "../../Source/Audio/AudioCallback.h"
 #include "../../Source/Audio/AudioEngine.h"
+#include "../../Source/Audio/Devices/AggregateAudioIODeviceType.h"
+#include "../../Source/Audio/Devices/ClockDriftEstimator.h"
+#include "../../Source/Audio/Devices/DeviceCatalog.h"
+#include "../../Source/Audio/Devices/DeviceSwitcher.h"
+#include "../../Source/Audio/Devices/JackAudioIODeviceType.h"
+#include "../../Source/Audio/Devices/VirtualAudioIODeviceType.h"
+#include "../../Source/Audio/Processing/BufferProcessor.h"
+#include "../../Source/Audio/Processing/ChannelMatrixMixer.h"
 #include "../../Source/JuceHeader.h"
+#include "../Utilities/MockAudioDevice.h"
+#include "../Utilities/RealtimeSafetyFixture.h"
 #include "../Utilities/TestUtils.h"
 #include <catch2/catch_test_macros.hpp>
+#include <thread>
 
-// Mock audio device for testing
-class MockAudioDevice : public juce::AudioIODevice {
-public:
-  MockAudioDevice() : juce::AudioIODevice("Mock Audio Device", "Mock") {}
-  ~MockAudioDevice() override = default;
+TEST_CASE("Audio device detection", "[audio]") {
+  SECTION("Mock audio device properties") {
+    MockAudioDevice mockDevice;
+    REQUIRE(mockDevice.getInputChannelNames().size() == 4);
+    REQUIRE(mockDevice.getOutputChannelNames().size() == 2);
+    REQUIRE(mockDevice.getAvailableSampleRates().contains(44100.0));
+    REQUIRE(mockDevice.getAvailableSampleRates().contains(48000.0));
+  }
+}
 
-  // AudioIODevice interface implementation
-  juce::StringArray getOutputChannelNames() override {
-    return {"Out 1", "Out 2"};
+TEST_CASE("Audio engine initialization", "[audio]") {
+  SECTION("Audio engine creation") {
+    // Test basic construction of AudioEngine
+    mcam::AudioEngine audioEngine;
+    REQUIRE_FALSE(audioEngine.isAudioInitialized());
   }
-  juce::StringArray getInputChannelNames() override {
-    return {"In 1", "In 2", "In 3", "In 4"};
+}
+
+TEST_CASE("Audio device simulation", "[audio]") {
+  SECTION("Sine wave generation") {
+    juce::AudioBuffer<float> buffer(2, 1000);
+    TestUtils::generateSineWave(buffer, 1000.0f, 44100.0f);
+
+    float peak = TestUtils::calculatePeak(buffer, 0);
+    float rms = TestUtils::calculateRMS(buffer, 0);
+
+    // Sine wave should have peak of 1.0 and RMS of 1/sqrt(2)
+    REQUIRE(peak == Catch::Approx(1.0f).margin(0.001f));
+    REQUIRE(rms == Catch::Approx(1.0f / std::sqrt(2.0f)).margin(0.001f));
   }
-  juce::Array<double> getAvailableSampleRates() override {
-    return {44100.0, 48000.0};
+}
+
+TEST_CASE("Non-blocking routing commands", "[audio][routing]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 4, true);
+  outputs.setRange(0, 2, true);
+  mockDevice.open(inputs, outputs, 48000.0, 256);
+
+  mcam::BufferProcessor processor;
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  SECTION("Posted routing is applied on the next block") {
+    REQUIRE(processor.postMonitorChannel(1, 2));
+    REQUIRE(processor.getMonitorChannel(1) == -1);
+
+    mockDevice.simulateCallback(256);
+
+    REQUIRE(processor.getMonitorChannel(1) == 2);
+    REQUIRE(processor.getSlotPeakLevel(1) > 0.0f);
+    REQUIRE(processor.getSlotRmsLevel(1) > 0.0f);
   }
-  juce::Array<int> getAvailableBufferSizes() override {
-    return {128, 256, 512, 1024};
+
+  SECTION("Invalid commands are rejected") {
+    REQUIRE_FALSE(processor.postMonitorChannel(-1, 0));
+    REQUIRE_FALSE(processor.postMonitorChannel(
+        mcam::BufferProcessor::NUM_MONITOR_SLOTS, 0));
+    REQUIRE_FALSE(
+        processor.postMonitorChannel(0, mcam::BufferProcessor::MAX_CHANNELS));
+  }
+
+  SECTION("Full queue reports failure instead of blocking") {
+    int accepted = 0;
+    while (processor.postMonitorChannel(0, 1))
+      ++accepted;
+
+    REQUIRE(accepted == mcam::BufferProcessor::ROUTING_QUEUE_SIZE - 1);
+
+    mockDevice.simulateCallback(256);
+    REQUIRE(processor.postMonitorChannel(0, 3));
+  }
+
+  SECTION("Several threads may post") {
+    // e.g. the OSC receiver and the message thread; together they fill the
+    // queue exactly
+    std::atomic<int> accepted{0};
+    auto post = [&](int channel) {
+      for (int i = 0; i < mcam::BufferProcessor::ROUTING_QUEUE_SIZE; ++i)
+        if (processor.postMonitorChannel(0, channel))
+          ++accepted;
+    };
+
+    std::thread first(post, 1), second(post, 2);
+    first.join();
+    second.join();
+
+    REQUIRE(accepted == mcam::BufferProcessor::ROUTING_QUEUE_SIZE - 1);
+
+    mockDevice.simulateCallback(256);
+    const int channel = processor.getMonitorChannel(0);
+    REQUIRE((channel == 1 || channel == 2));
   }
-  int getDefaultBufferSize() override { return 512; }
 
-  juce::String open(const juce::BigInteger &inputs,
-                    const juce::BigInteger &outputs, double sampleRate,
-                    int bufferSize) override {
-    isOpen = true;
-    activeInputChannels = inputs;
-    activeOutputChannels = outputs;
-    currentSampleRate = sampleRate;
-    currentBufferSize = bufferSize;
-    return {};
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("Derived channels from the matrix mixer", "[audio][routing]") {
+  using Mixer = mcam::ChannelMatrixMixer;
+
+  // Eight inputs, each a constant so mixes can be checked exactly
+  juce::AudioBuffer<float> input(8, 256);
+  for (int ch = 0; ch < input.getNumChannels(); ++ch)
+    juce::FloatVectorOperations::fill(input.getWritePointer(ch),
+                                      0.01f * (float)(ch + 1), 256);
+
+  SECTION("Zero coefficients are skipped and repeated inputs merged") {
+    Mixer mixer;
+    REQUIRE(mixer.setOutput(0, Mixer::fromGains({0.5f, 0.0f, 0.0f, 0.25f})));
+    REQUIRE(mixer.getNumTerms(0) == 2);
+
+    REQUIRE(mixer.setOutput(1, {{2, 0.5f}, {2, 0.5f}, {3, 0.0f}}));
+    REQUIRE(mixer.getNumTerms(1) == 1);
+
+    REQUIRE(mixer.setOutput(2, {{1, 1.0f}, {1, -1.0f}}));
+    REQUIRE_FALSE(mixer.isOutputDefined(2));
+
+    REQUIRE_FALSE(mixer.setOutput(Mixer::MAX_OUTPUTS, Mixer::sum(0, 1)));
+    REQUIRE_FALSE(mixer.setOutput(0, {{-1, 1.0f}}));
   }
 
-  void close() override { isOpen = false; }
-  bool isOpen() override { return isOpen; }
-  bool isPlaying() override { return isPlaying_; }
+  SECTION("Presets and weighted rows") {
+    Mixer mixer;
+    mixer.prepare(256);
+    mixer.setOutput(0, Mixer::sum(0, 1));
+    mixer.setOutput(1, Mixer::side(0, 1));
+    mixer.setOutput(2, Mixer::downmix(Mixer::BedLayout::surround51, 0,
+                                      Mixer::DownmixOutput::left));
+    mixer.setOutput(3, Mixer::downmix(Mixer::BedLayout::surround71, 0,
+                                      Mixer::DownmixOutput::mono));
+    mixer.setOutput(4, {{6, 1.0f}});
+    mixer.setOutput(5, {{7, 2.0f}, {12, 1.0f}}); // Input 12 is missing
+
+    mixer.beginBlock(input.getArrayOfReadPointers(), 8, 256);
 
-  void start(juce::AudioIODeviceCallback *callback) override {
-    if (!isOpen)
-      return;
+    const float g = 0.70710678f;
+    REQUIRE(mixer.getOutput(0)[100] == Catch::Approx(0.03f));
+    REQUIRE(mixer.getOutput(1)[100] == Catch::Approx(-0.005f));
+    REQUIRE(mixer.getOutput(2)[100] ==
+            Catch::Approx(0.01f + g * (0.03f + 0.05f)));
+    REQUIRE(mixer.getOutput(3)[100] ==
+            Catch::Approx(0.5f * (0.01f + 0.02f) +
+                          g * (0.03f + 0.5f * (0.05f + 0.06f + 0.07f +
+                                               0.08f))));
 
-    audioCallback = callback;
-    isPlaying_ = true;
+    // A lone unity term is the input itself
+    REQUIRE(mixer.getOutput(4) == input.getReadPointer(6));
+    REQUIRE(mixer.getOutput(5)[0] == Catch::Approx(0.16f));
+    REQUIRE(mixer.getOutput(6) == nullptr);
   }
 
-  void stop() override {
-    isPlaying_ = false;
-    audioCallback = nullptr;
+  SECTION("Outputs are mixed once per block and only when used") {
+    Mixer mixer;
+    mixer.prepare(256);
+    mixer.setOutput(0, Mixer::mid(0, 1));
+    mixer.setOutput(1, Mixer::side(0, 1));
+
+    mixer.beginBlock(input.getArrayOfReadPointers(), 8, 256);
+    const float *first = mixer.getOutput(0);
+    REQUIRE(mixer.getOutput(0) == first);
+    REQUIRE(mixer.getNumOutputsMixed() == 1);
+
+    mixer.beginBlock(input.getArrayOfReadPointers(), 8, 256);
+    REQUIRE(mixer.getNumOutputsMixed() == 0);
   }
 
-  juce::String getLastError() override { return {}; }
-  int getCurrentBufferSizeSamples() override { return currentBufferSize; }
-  double getCurrentSampleRate() override { return currentSampleRate; }
-  int getCurrentBitDepth() override { return 24; }
-  juce::BigInteger getActiveOutputChannels() const override {
-    return activeOutputChannels;
+  SECTION("Terms round-trip through their text form") {
+    std::vector<Mixer::Term> terms;
+    REQUIRE(Mixer::termsFromString(Mixer::termsToString(Mixer::side(0, 1)),
+                                   terms));
+    REQUIRE(terms.size() == 2);
+    REQUIRE(terms[0].input == 0);
+    REQUIRE(terms[1].gain == Catch::Approx(-0.5f));
+
+    // Gains default to unity; inputs are 1-based
+    REQUIRE(Mixer::termsFromString(" 3, 4:2 ", terms));
+    REQUIRE(terms.size() == 2);
+    REQUIRE(terms[0].input == 2);
+    REQUIRE(terms[0].gain == 1.0f);
+    REQUIRE(terms[1].gain == 2.0f);
+
+    REQUIRE(Mixer::termsFromString("", terms));
+    REQUIRE(terms.empty());
+
+    REQUIRE_FALSE(Mixer::termsFromString("0:1", terms));
+    REQUIRE_FALSE(Mixer::termsFromString("1:", terms));
+    REQUIRE_FALSE(Mixer::termsFromString("L:1", terms));
   }
-  juce::BigInteger getActiveInputChannels() const override {
-    return activeInputChannels;
+
+  SECTION("Slots select derived channels like inputs") {
+    MockAudioDevice mockDevice;
+    juce::BigInteger inputs, outputs;
+    inputs.setRange(0, 8, true);
+    mockDevice.open(inputs, outputs, 48000.0, 256);
+
+    mcam::BufferProcessor processor;
+    const int mid = mcam::BufferProcessor::getDerivedChannelIndex(0);
+    const int side = mcam::BufferProcessor::getDerivedChannelIndex(1);
+
+    // Undefined derived channels cannot be selected
+    REQUIRE_FALSE(processor.setMonitorChannel(0, mid));
+    REQUIRE_FALSE(processor.postMonitorChannel(0, mid));
+
+    REQUIRE(processor.setDerivedChannel(0, "Mid 1/2", Mixer::mid(0, 1)));
+    REQUIRE(processor.setDerivedChannel(1, "Side 1/2", Mixer::side(0, 1)));
+    REQUIRE_FALSE(processor.setDerivedChannel(
+        2, "Bad", {{mcam::BufferProcessor::MAX_CHANNELS, 1.0f}}));
+    REQUIRE(processor.getDerivedChannelName(0) == "Mid 1/2");
+    REQUIRE(processor.getDerivedChannelTerms(1).size() == 2);
+
+    // Views rebuild their channel lists when the revision moves
+    const int revision = processor.getDerivedChannelsRevision();
+
+    REQUIRE(processor.setMonitorChannel(0, mid));
+    REQUIRE(processor.postMonitorChannel(1, side));
+    REQUIRE(processor.setMonitorChannel(2, mid));
+
+    processor.audioDeviceAboutToStart(&mockDevice);
+    mockDevice.start(&processor);
+    mockDevice.simulateCallback(input);
+
+    REQUIRE(processor.getSlotPeakLevel(0) == Catch::Approx(0.015f));
+    REQUIRE(processor.getSlotPeakLevel(1) == Catch::Approx(0.005f));
+    REQUIRE(processor.getSlotPeakLevel(2) == Catch::Approx(0.015f));
+
+    // Clearing a derived channel silences its slots but keeps the selection
+    REQUIRE(processor.setDerivedChannel(0, {}, {}));
+    REQUIRE(processor.getDerivedChannelName(0).isEmpty());
+    REQUIRE(processor.getDerivedChannelTerms(0).empty());
+    REQUIRE(processor.getDerivedChannelsRevision() != revision);
+    mockDevice.simulateCallback(input);
+    REQUIRE(processor.getMonitorChannel(0) == mid);
+
+    mockDevice.stop();
+    processor.audioDeviceStopped();
   }
-  int getOutputLatencyInSamples() override { return 0; }
-  int getInputLatencyInSamples() override { return 0; }
+}
+
+TEST_CASE("Loudness is measured per slot and per group",
+          "[audio][loudness]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 4, true);
+  mockDevice.open(inputs, outputs, 48000.0, 480);
+
+  mcam::BufferProcessor processor;
+  REQUIRE(processor.setMonitorChannel(0, 1));
+  REQUIRE(processor.setLoudnessGroup(0, {0, 1}));
+  REQUIRE_FALSE(processor.setLoudnessGroup(
+      mcam::BufferProcessor::NUM_LOUDNESS_GROUPS, {0, 1}));
+  REQUIRE_FALSE(
+      processor.setLoudnessGroup(1, {mcam::BufferProcessor::MAX_CHANNELS}));
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  // One second of a full-scale 1 kHz sine on every input
+  for (int i = 0; i < 100; ++i)
+    mockDevice.simulateCallback(480);
+
+  const auto slot = processor.getSlotLoudness(0);
+  const auto group = processor.getGroupLoudness(0);
+  REQUIRE(slot.momentary == Catch::Approx(-3.0).margin(0.1));
+  REQUIRE(group.momentary == Catch::Approx(0.0).margin(0.1));
+  REQUIRE(group.integrated == Catch::Approx(0.0).margin(0.1));
+
+  processor.resetLoudness();
+  REQUIRE(std::isinf(processor.getGroupLoudness(0).integrated));
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("True peak is measured per input channel and per slot",
+          "[audio][truepeak]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 4, true);
+  mockDevice.open(inputs, outputs, 48000.0, 480);
+
+  mcam::BufferProcessor processor;
+  REQUIRE(processor.setMonitorChannel(0, 2));
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  for (int i = 0; i < 4; ++i)
+    mockDevice.simulateCallback(480);
+
+  // A full-scale 1 kHz sine peaks at 0 dBTP
+  REQUIRE(processor.getChannelTruePeak(0) == Catch::Approx(1.0f).margin(0.02f));
+  REQUIRE(processor.getChannelTruePeak(3) == Catch::Approx(1.0f).margin(0.02f));
+  REQUIRE(processor.getChannelTruePeak(4) == 0.0f);
+  REQUIRE(processor.getChannelTruePeak(-1) == 0.0f);
+  REQUIRE(processor.getSlotTruePeakLevel(0) >=
+          processor.getSlotPeakLevel(0) - 0.001f);
+  REQUIRE(processor.getSlotTruePeakLevel(1) == 0.0f);
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("Slot block statistics follow the selected analyzer stages",
+          "[audio][analysis]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 2, true);
+  mockDevice.open(inputs, outputs, 48000.0, 480);
+
+  mcam::BufferProcessor processor;
+  REQUIRE(processor.setMonitorChannel(0, 0));
+
+  using mcam::AnalyzerStage;
+  REQUIRE(processor.getSlotAnalyzerStages(0) ==
+          (AnalyzerStage::peak | AnalyzerStage::rms));
 
-  // Simulate audio callback with test data
-  void simulateCallback(int numSamples, bool useSineWave = true) {
-    if (!isPlaying_ || audioCallback == nullptr)
-      return;
+  // Peak and RMS stay selected whatever is asked for
+  REQUIRE(processor.setSlotAnalyzerStages(0, AnalyzerStage::clipCount));
+  REQUIRE(processor.getSlotAnalyzerStages(0) ==
+          (AnalyzerStage::peak | AnalyzerStage::rms |
+           AnalyzerStage::clipCount));
+  REQUIRE_FALSE(processor.setSlotAnalyzerStages(4, AnalyzerStage::all));
+  REQUIRE(processor.getSlotAnalyzerStages(4) == 0);
 
-    // Create test buffers
-    juce::AudioBuffer<float> inputBuffer(
-        activeInputChannels.countNumberOfSetBits(), numSamples);
-    juce::AudioBuffer<float> outputBuffer(
-        activeOutputChannels.countNumberOfSetBits(), numSamples);
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+  mockDevice.simulateCallback(480);
 
-    // Fill input buffer with test data
-    if (useSineWave) {
-      TestUtils::generateSineWave(inputBuffer, 1000.0f, currentSampleRate);
-    } else {
-      TestUtils::generateSquareWave(inputBuffer, 1000.0f, currentSampleRate);
+  // Ten periods of a full-scale sine: two samples per period sit on a crest
+  REQUIRE(processor.getSlotPeakLevel(0) == Catch::Approx(1.0f).margin(0.001f));
+  REQUIRE(processor.getSlotRmsLevel(0) ==
+          Catch::Approx(1.0f / std::sqrt(2.0f)).margin(0.001f));
+  REQUIRE(processor.getSlotClippedSamples(0) == 20);
+  REQUIRE(processor.getSlotDcOffset(0) == 0.0f);
+
+  REQUIRE(processor.setSlotAnalyzerStages(0, AnalyzerStage::dcOffset));
+  mockDevice.simulateCallback(480);
+  REQUIRE(processor.getSlotClippedSamples(0) == 0);
+  REQUIRE(processor.getSlotDcOffset(0) == Catch::Approx(0.0f).margin(1e-4));
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("Slot sample taps queue a slot's samples while tapped",
+          "[audio][scope]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 2, true);
+  mockDevice.open(inputs, outputs, 48000.0, 480);
+
+  mcam::BufferProcessor processor;
+  REQUIRE(processor.setMonitorChannel(0, 0));
+  REQUIRE(processor.setMonitorChannel(1, 1));
+  REQUIRE_FALSE(processor.setSlotSamplesTapped(4, true));
+  REQUIRE(processor.getSlotSamples(4) == nullptr);
+
+  auto *samples = processor.getSlotSamples(0);
+  REQUIRE(samples != nullptr);
+  REQUIRE(samples->getCapacity() ==
+          mcam::BufferProcessor::SLOT_SAMPLES_CAPACITY);
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  // Nothing is queued until the slot is tapped
+  mockDevice.simulateCallback(480);
+  REQUIRE(samples->getNumReady() == 0);
+
+  REQUIRE(processor.setSlotSamplesTapped(0, true));
+  mockDevice.simulateCallback(480);
+  mockDevice.simulateCallback(480);
+  REQUIRE(samples->getNumReady() == 960);
+  REQUIRE(processor.getSlotSamples(1)->getNumReady() == 0);
+
+  // The samples are the slot's, whose peak the processor measured
+  float peak = 0.0f;
+  samples->drain([&peak](const float *data, int numSamples) {
+    peak = juce::jmax(peak, juce::FloatVectorOperations::findMaximum(
+                                data, numSamples));
+  });
+  REQUIRE(samples->getNumReady() == 0);
+  REQUIRE(peak == processor.getSlotPeakLevel(0));
+
+  REQUIRE(processor.setSlotSamplesTapped(0, false));
+  mockDevice.simulateCallback(480);
+  REQUIRE(samples->getNumReady() == 0);
+
+  // A tapped scope keeps its FIFO and its samples across a device restart
+  REQUIRE(processor.setSlotSamplesTapped(0, true));
+  mockDevice.simulateCallback(480);
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+
+  REQUIRE(processor.getSlotSamples(0) == samples);
+  REQUIRE(samples->getNumReady() == 480);
+  samples->drain([](const float *, int) {});
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+  mockDevice.simulateCallback(480);
+  REQUIRE(processor.getSlotSamples(0) == samples);
+  REQUIRE(samples->getNumReady() == 480);
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("Slot meters follow their selected ballistics", "[audio][metering]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 2, true);
+  mockDevice.open(inputs, outputs, 48000.0, 480);
+
+  mcam::BufferProcessor processor;
+  REQUIRE(processor.setMonitorChannel(0, 0));
+  REQUIRE(processor.setMonitorChannel(1, 1));
+
+  using MeterType = mcam::BufferProcessor::MeterType;
+  REQUIRE(processor.getSlotMeterType(0) == MeterType::vu);
+  REQUIRE(processor.setSlotMeterType(1, MeterType::ppm));
+  REQUIRE(processor.getSlotMeterType(1) == MeterType::ppm);
+  REQUIRE_FALSE(processor.setSlotMeterType(4, MeterType::ppm));
+  REQUIRE(processor.getSlotMeterType(4) == MeterType::vu);
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  // Two seconds of a full-scale 1 kHz sine: both meters read its peak,
+  // which the VU scale puts 20 VU over the alignment level
+  for (int i = 0; i < 200; ++i)
+    mockDevice.simulateCallback(480);
+
+  REQUIRE(processor.getSlotMeterLevel(0) == Catch::Approx(1.0f).margin(0.01f));
+  REQUIRE(mcam::VUMeterCalculator::gainToVU(processor.getSlotMeterLevel(0)) ==
+          Catch::Approx(20.0f).margin(0.1f));
+  REQUIRE(processor.getSlotMeterPeakHold(0) ==
+          processor.getSlotMeterLevel(0));
+  REQUIRE(processor.getSlotMeterLevel(1) == Catch::Approx(1.0f).margin(0.02f));
+  REQUIRE(processor.getSlotMeterPeakHold(1) >=
+          processor.getSlotMeterLevel(1));
+  REQUIRE(processor.getSlotMeterLevel(2) == 0.0f);
+  REQUIRE(processor.getSlotMeterLevel(-1) == 0.0f);
+
+  // A switched meter starts again from rest
+  REQUIRE(processor.setSlotMeterType(0, MeterType::ppm));
+  mockDevice.simulateCallback(48);
+  REQUIRE(processor.getSlotMeterLevel(0) < 0.9f);
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("Input channels keep a level history", "[audio][metering]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 2, true);
+  mockDevice.open(inputs, outputs, 48000.0, 480);
+
+  mcam::BufferProcessor processor;
+  REQUIRE(processor.getChannelHistory(-1) == nullptr);
+  REQUIRE(processor.getChannelHistory(mcam::BufferProcessor::MAX_CHANNELS) ==
+          nullptr);
+
+  const auto *history = processor.getChannelHistory(1);
+  REQUIRE(history != nullptr);
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  // One second of a full-scale sine, whether or not a slot selects it
+  for (int i = 0; i < 100; ++i)
+    mockDevice.simulateCallback(480);
+
+  REQUIRE(history->getNumEntries(0) == 10);
+  REQUIRE(history->getNumEntries(1) == 1);
+
+  mcam::LevelHistory::Entry entry;
+  REQUIRE(history->read(1, &entry, 1) == 1);
+  REQUIRE(entry.mean == Catch::Approx(1.0f / std::sqrt(2.0f)).margin(0.001f));
+  REQUIRE(entry.max - entry.min < 0.001f);
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("Input channels are watched for alarms", "[audio][alarms]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 2, true);
+  mockDevice.open(inputs, outputs, 48000.0, 480);
+
+  mcam::BufferProcessor processor;
+  const auto &alarms = processor.getAlarmEngine();
+  juce::int64 cursor = alarms.getNumEvents();
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  // The full-scale sine touches full scale for single samples, which is not
+  // clipping
+  for (int i = 0; i < 100; ++i)
+    mockDevice.simulateCallback(480);
+
+  using Type = mcam::AlarmEngine::Type;
+  REQUIRE(alarms.getNumActive() == 0);
+
+  // A full-scale square wave clips throughout on both channels, which are
+  // in phase
+  for (int i = 0; i < 100; ++i)
+    mockDevice.simulateCallback(480, false);
+
+  REQUIRE(alarms.isActive(0, Type::clipping));
+  REQUIRE(alarms.isActive(1, Type::clipping));
+  REQUIRE_FALSE(alarms.isActive(0, Type::phaseInversion));
+  REQUIRE(alarms.getNumActive() == 2);
+
+  std::array<mcam::AlarmEngine::Event, 4> events;
+  REQUIRE(alarms.readEvents(cursor, events.data(), 4) == 2);
+  REQUIRE(events[0].raised);
+  REQUIRE(events[1].raised);
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("Analysis does not depend on the device block size",
+          "[audio][framing]") {
+  constexpr int numChannels = 4, hopSize = 256, length = 2048 * 12;
+
+  // Sines of different frequencies under noise, with a clipped stretch on
+  // channel 2 and channel 3 the inverse of channel 0
+  juce::AudioBuffer<float> signal(numChannels, length);
+  juce::Random random(42);
+
+  for (int n = 0; n < length; ++n) {
+    for (int channel = 0; channel < 3; ++channel) {
+      const double phase = juce::MathConstants<double>::twoPi *
+                           (220.0 * (channel + 1)) * n / 48000.0;
+      signal.setSample(channel, n,
+                       (float)(0.5 * std::sin(phase)) +
+                           0.1f * (random.nextFloat() - 0.5f));
     }
 
-    // Call the audio callback
-    juce::MidiBuffer midiBuffer;
-    audioCallback->audioDeviceIOCallback(
-        inputBuffer.getArrayOfReadPointers(), inputBuffer.getNumChannels(),
-        outputBuffer.getArrayOfWritePointers(), outputBuffer.getNumChannels(),
-        numSamples);
-  }
-
-private:
-  bool isOpen = false;
-  bool isPlaying_ = false;
-  juce::BigInteger activeInputChannels;
-  juce::BigInteger activeOutputChannels;
-  double currentSampleRate = 44100.0;
-  int currentBufferSize = 512;
-  juce::AudioIODeviceCallback *audioCallback = nullptr;
-};
+    if (n >= 10000 && n < 10100)
+      signal.setSample(2, n, 1.0f);
 
-TEST_CASE("Audio device detection", "[audio]") {
-  SECTION("Mock audio device properties") {
+    signal.setSample(3, n, -signal.getSample(0, n));
+  }
+
+  // Runs the signal through a processor in device blocks of the sizes
+  // nextBlockSize returns
+  struct Run {
+    std::unique_ptr<mcam::BufferProcessor> processor;
+    std::vector<int> callbackSizes;
+  };
+
+  const auto run = [&](int deviceBlockSize,
+                       const std::function<int()> &nextBlockSize) {
     MockAudioDevice mockDevice;
-    REQUIRE(mockDevice.getInputChannelNames().size() == 4);
-    REQUIRE(mockDevice.getOutputChannelNames().size() == 2);
-    REQUIRE(mockDevice.getAvailableSampleRates().contains(44100.0));
-    REQUIRE(mockDevice.getAvailableSampleRates().contains(48000.0));
+    juce::BigInteger inputs, outputs;
+    inputs.setRange(0, numChannels, true);
+    mockDevice.open(inputs, outputs, 48000.0, deviceBlockSize);
+
+    Run result;
+    result.processor = std::make_unique<mcam::BufferProcessor>();
+    auto &processor = *result.processor;
+    REQUIRE(processor.setAnalysisHopSize(hopSize));
+    REQUIRE(processor.setDerivedChannel(
+        0, "Mid", mcam::ChannelMatrixMixer::mid(0, 1)));
+    REQUIRE(processor.setMonitorChannel(0, 0));
+    REQUIRE(processor.setMonitorChannel(
+        1, mcam::BufferProcessor::getDerivedChannelIndex(0)));
+    REQUIRE(processor.setMonitorChannel(2, 2));
+    REQUIRE(
+        processor.setSlotMeterType(2, mcam::BufferProcessor::MeterType::ppm));
+    REQUIRE(processor.setSlotAnalyzerStages(2, mcam::AnalyzerStage::all));
+    REQUIRE(processor.setLoudnessGroup(0, {0, 1}));
+
+    // Reserved so the callback does not allocate on the audio thread
+    auto &callbackSizes = result.callbackSizes;
+    callbackSizes.reserve(
+        (size_t)(length / hopSize * mcam::BufferProcessor::NUM_MONITOR_SLOTS));
+    processor.addBufferCallback(
+        [&callbackSizes](int, const juce::AudioBuffer<float> &buffer) {
+          callbackSizes.push_back(buffer.getNumSamples());
+        });
+
+    processor.audioDeviceAboutToStart(&mockDevice);
+    mockDevice.start(&processor);
+
+    for (int start = 0; start < length;) {
+      const int numSamples = juce::jmin(nextBlockSize(), length - start);
+      mockDevice.simulateCallback(juce::AudioBuffer<float>(
+          signal.getArrayOfWritePointers(), numChannels, start, numSamples));
+      start += numSamples;
+    }
+
+    mockDevice.stop();
+    processor.audioDeviceStopped();
+    return result;
+  };
+
+  const auto small = run(32, [] { return 32; });
+  const auto large = run(2048, [] { return 2048; });
+
+  // A device whose block size changes from callback to callback
+  juce::Random blockSizes(7);
+  const auto variable =
+      run(512, [&blockSizes] { return 1 + blockSizes.nextInt(700); });
+
+  using Type = mcam::AlarmEngine::Type;
+
+  for (const auto *other : {&large, &variable}) {
+    const auto &a = *small.processor;
+    const auto &b = *other->processor;
+
+    REQUIRE(other->callbackSizes == small.callbackSizes);
+
+    for (int slot = 0; slot < 3; ++slot) {
+      CHECK(a.getSlotPeakLevel(slot) == b.getSlotPeakLevel(slot));
+      CHECK(a.getSlotRmsLevel(slot) == b.getSlotRmsLevel(slot));
+      CHECK(a.getSlotDcOffset(slot) == b.getSlotDcOffset(slot));
+      CHECK(a.getSlotClippedSamples(slot) == b.getSlotClippedSamples(slot));
+      CHECK(a.getSlotTruePeakLevel(slot) == b.getSlotTruePeakLevel(slot));
+      CHECK(a.getSlotMeterLevel(slot) == b.getSlotMeterLevel(slot));
+      CHECK(a.getSlotMeterPeakHold(slot) == b.getSlotMeterPeakHold(slot));
+      CHECK(a.getSlotLoudness(slot).momentary ==
+            b.getSlotLoudness(slot).momentary);
+    }
+
+    CHECK(a.getGroupLoudness(0).momentary == b.getGroupLoudness(0).momentary);
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+      CHECK(a.getChannelTruePeak(channel) == b.getChannelTruePeak(channel));
+
+      const auto *historyA = a.getChannelHistory(channel);
+      const auto *historyB = b.getChannelHistory(channel);
+      REQUIRE(historyA->getNumEntries(0) == historyB->getNumEntries(0));
+
+      mcam::LevelHistory::Entry entryA, entryB;
+      REQUIRE(historyA->read(0, &entryA, 1) == 1);
+      REQUIRE(historyB->read(0, &entryB, 1) == 1);
+      CHECK(entryA.mean == entryB.mean);
+      CHECK(entryA.max == entryB.max);
+
+      for (int type = 0; type < mcam::AlarmEngine::NUM_TYPES; ++type)
+        CHECK(a.getAlarmEngine().isActive(channel, (Type)type) ==
+              b.getAlarmEngine().isActive(channel, (Type)type));
+    }
+
+    CHECK(a.getAlarmEngine().getNumEvents() ==
+          b.getAlarmEngine().getNumEvents());
   }
+
+  // Every analysis block is one hop
+  REQUIRE_FALSE(small.callbackSizes.empty());
+  for (int size : small.callbackSizes)
+    REQUIRE(size == hopSize);
+
+  // Invalid hop sizes are rejected
+  REQUIRE_FALSE(small.processor->setAnalysisHopSize(1));
+  REQUIRE_FALSE(small.processor->setAnalysisHopSize(
+      mcam::AnalysisFramer::MAX_HOP_SIZE + 1));
+  REQUIRE(small.processor->getAnalysisHopSize() == hopSize);
 }
 
-TEST_CASE("Audio engine initialization", "[audio]") {
-  SECTION("Audio engine creation") {
-    // Test basic construction of AudioEngine
-    AudioEngine audioEngine;
-    REQUIRE_FALSE(audioEngine.isAudioInitialized());
+TEST_CASE_METHOD(RealtimeSafetyFixture,
+                 "Simulated device runs are realtime-safe",
+                 "[audio][realtime]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 4, true);
+  mockDevice.open(inputs, outputs, 48000.0, 480);
+
+  // Every analysis path in use: inputs, a derived channel, PPM and VU
+  // meters, all block statistics and a loudness group
+  mcam::BufferProcessor processor;
+  REQUIRE(processor.setDerivedChannel(
+      0, "Mid", mcam::ChannelMatrixMixer::mid(0, 1)));
+  REQUIRE(processor.setMonitorChannel(0, 0));
+  REQUIRE(processor.setMonitorChannel(1, 3));
+  REQUIRE(processor.setMonitorChannel(
+      2, mcam::BufferProcessor::MAX_CHANNELS));
+  REQUIRE(processor.setSlotMeterType(1, mcam::BufferProcessor::MeterType::ppm));
+  REQUIRE(processor.setSlotAnalyzerStages(2, mcam::AnalyzerStage::all));
+  REQUIRE(processor.setLoudnessGroup(0, {0, 1}));
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  for (int i = 0; i < 200; ++i) {
+    // Routing changes queued from a control thread are applied in the
+    // callback
+    if (i == 100)
+      REQUIRE(processor.postMonitorChannel(3, 2));
+
+    mockDevice.simulateCallback(480);
   }
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+
+  REQUIRE(processor.getMonitorChannel(3) == 2);
 }
 
-TEST_CASE("Audio device simulation", "[audio]") {
-  SECTION("Sine wave generation") {
-    juce::AudioBuffer<float> buffer(2, 1000);
-    TestUtils::generateSineWave(buffer, 1000.0f, 44100.0f);
+TEST_CASE_METHOD(RealtimeSafetyFixture,
+                 "UI buffer callbacks are realtime-safe",
+                 "[audio][realtime][ui]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 2, true);
+  mockDevice.open(inputs, outputs, 48000.0, 480);
 
-    float peak = TestUtils::calculatePeak(buffer, 0);
-    float rms = TestUtils::calculateRMS(buffer, 0);
+  mcam::BufferProcessor processor;
+  REQUIRE(processor.setMonitorChannel(0, 0));
+  REQUIRE(processor.setMonitorChannel(1, 1));
 
-    // Sine wave should have peak of 1.0 and RMS of 1/sqrt(2)
-    REQUIRE(peak == Catch::Approx(1.0f).margin(0.001f));
-    REQUIRE(rms == Catch::Approx(1.0f / std::sqrt(2.0f)).margin(0.001f));
+  // The handoff of a monitoring slot: the audio thread stores the latest
+  // level and stamp and marks them pending; a message-thread timer polls
+  std::atomic<float> pendingLevel{0.0f};
+  std::atomic<float> pendingPeakHold{0.0f};
+  std::atomic<bool> levelUpdatePending{false};
+  mcam::LatencyTracker::Stamp pendingStamp;
+  juce::SpinLock stampLock;
+  int numCoalesced = 0;
+
+  REQUIRE(processor.addBufferCallback(
+      [&](int slot, const juce::AudioBuffer<float> &buffer) {
+        if (slot != 0 || buffer.getNumSamples() == 0)
+          return;
+
+        pendingLevel.store(juce::Decibels::gainToDecibels(
+                               processor.getSlotMeterLevel(slot)),
+                           std::memory_order_relaxed);
+        pendingPeakHold.store(processor.getSlotMeterPeakHold(slot),
+                              std::memory_order_relaxed);
+
+        const auto stamp = processor.getSlotStamp(slot);
+        if (stamp.isValid()) {
+          const juce::SpinLock::ScopedTryLockType tryLock(stampLock);
+          if (tryLock.isLocked())
+            pendingStamp = stamp;
+        }
+
+        if (levelUpdatePending.exchange(true))
+          ++numCoalesced;
+      }));
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  auto &tracker = mcam::LatencyTracker::getInstance();
+  tracker.setEnabled(true);
+
+  for (int i = 0; i < 20; ++i) {
+    mockDevice.simulateCallback(480);
+
+    // The timer runs between some callbacks
+    if (i % 4 == 3) {
+      REQUIRE(levelUpdatePending.exchange(false));
+      const juce::SpinLock::ScopedLockType sl(stampLock);
+      REQUIRE(pendingStamp.isValid());
+    }
+  }
+
+  tracker.setEnabled(false);
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+
+  REQUIRE(numCoalesced == 15);
+  REQUIRE(pendingLevel.load() > -60.0f);
+}
+
+TEST_CASE_METHOD(RealtimeSafetyFixture,
+                 "Variable device block sizes are realtime-safe",
+                 "[audio][realtime][framing]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 4, true);
+  mockDevice.open(inputs, outputs, 48000.0, 256);
+
+  mcam::BufferProcessor processor;
+  REQUIRE(processor.setDerivedChannel(
+      0, "Mid", mcam::ChannelMatrixMixer::mid(0, 1)));
+  REQUIRE(processor.setMonitorChannel(0, 0));
+  REQUIRE(processor.setMonitorChannel(
+      1, mcam::BufferProcessor::MAX_CHANNELS));
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  // Blocks shorter and longer than the prepared size, device blocks as
+  // they come and then fixed hops
+  for (int hopSize : {0, 128}) {
+    REQUIRE(processor.setAnalysisHopSize(hopSize));
+
+    for (int numSamples : {1, 37, 256, 700, 2048, 255})
+      mockDevice.simulateCallback(numSamples);
+
+    const auto *buffer = processor.getMonitorBuffer(0);
+    REQUIRE(buffer != nullptr);
+    REQUIRE(buffer->getNumSamples() <= 256);
+    REQUIRE(processor.getSlotPeakLevel(1) > 0.0f);
+  }
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("Latency stamps follow blocks through the processor",
+          "[audio][latency]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 4, true);
+  mockDevice.open(inputs, outputs, 48000.0, 256);
+
+  mcam::BufferProcessor processor;
+  processor.setMonitorChannel(0, 1);
+
+  mcam::LatencyTracker::Stamp received;
+  processor.addBufferCallback(
+      [&](int slot, const juce::AudioBuffer<float> &) {
+        received = processor.getSlotStamp(slot);
+      });
+
+  processor.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&processor);
+
+  auto &tracker = mcam::LatencyTracker::getInstance();
+
+  SECTION("Instrumented mode stamps every stage up to analysis") {
+    tracker.setEnabled(true);
+    mockDevice.simulateCallback(256);
+    tracker.setEnabled(false);
+
+    REQUIRE(received.isValid());
+    REQUIRE(received.captureNs < received.callbackNs);
+    REQUIRE(received.callbackNs <= received.analysisNs);
+    REQUIRE(received.publishNs == 0);
+  }
+
+  SECTION("No stamps when disabled") {
+    mockDevice.simulateCallback(256);
+    REQUIRE_FALSE(received.isValid());
+  }
+
+  SECTION("Hops are stamped with the capture time of their first sample") {
+    REQUIRE(processor.setAnalysisHopSize(256));
+
+    // The hop completes in the third device block, from samples held since
+    // the start of the first
+    tracker.setEnabled(true);
+    mockDevice.simulateCallback(100);
+    mockDevice.simulateCallback(100);
+    REQUIRE_FALSE(received.isValid());
+    mockDevice.simulateCallback(100);
+    tracker.setEnabled(false);
+
+    const auto blockNs = (juce::int64)(100 * 1.0e9 / 48000.0);
+    const auto heldNs = (juce::int64)(200 * 1.0e9 / 48000.0);
+
+    REQUIRE(received.isValid());
+    REQUIRE(received.callbackNs - received.captureNs == blockNs + heldNs);
+  }
+
+  mockDevice.stop();
+  processor.audioDeviceStopped();
+}
+
+TEST_CASE("Virtual audio devices", "[audio][virtual]") {
+  mcam::VirtualAudioIODeviceType type;
+  const auto names = type.getDeviceNames(true);
+
+  REQUIRE(names.contains("Virtual Noise 128ch (free run)"));
+  REQUIRE(type.createDevice({}, "No such device") == nullptr);
+
+  SECTION("Free-running device delivers every active channel") {
+    std::unique_ptr<juce::AudioIODevice> device(
+        type.createDevice({}, "Virtual Noise 128ch (free run)"));
+    REQUIRE(device != nullptr);
+    REQUIRE(device->getInputChannelNames().size() == 128);
+    REQUIRE(device->getOutputChannelNames().isEmpty());
+
+    juce::BigInteger inputs;
+    inputs.setRange(0, 128, true);
+    REQUIRE(device->open(inputs, {}, 96000.0, 64).isEmpty());
+    REQUIRE(device->getActiveInputChannels().countNumberOfSetBits() == 128);
+
+    mcam::BufferProcessor processor;
+    device->start(&processor);
+
+    // 2000 blocks of 64 at 96 kHz is 1.3 s of audio; free run is faster
+    auto *virtualDevice =
+        dynamic_cast<mcam::VirtualAudioIODevice *>(device.get());
+    REQUIRE(virtualDevice != nullptr);
+
+    const auto startMs = juce::Time::getMillisecondCounter();
+    while (virtualDevice->getBlocksDelivered() < 2000 &&
+           juce::Time::getMillisecondCounter() - startMs < 5000)
+      juce::Thread::sleep(1);
+
+    REQUIRE(virtualDevice->getBlocksDelivered() >= 2000);
+    REQUIRE(processor.postMonitorChannel(0, 127));
+    juce::Thread::sleep(10);
+    REQUIRE(processor.getSlotPeakLevel(0) > 0.0f);
+
+    device->stop();
+    REQUIRE_FALSE(device->isPlaying());
+    device->close();
+  }
+
+  SECTION("File device plays the file's channels") {
+    auto file = juce::File::createTempFile(".wav");
+    {
+      juce::AudioBuffer<float> buffer(3, 4800);
+      TestUtils::generateSineWave(buffer, 440.0f, 48000.0f);
+
+      juce::WavAudioFormat wav;
+      std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(
+          file.createOutputStream().release(), 48000.0, 3, 24, {}, 0));
+      REQUIRE(writer != nullptr);
+      writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+    }
+
+    const auto name = type.addFileDevice(file);
+    REQUIRE(type.getDeviceNames(true).contains(name));
+
+    std::unique_ptr<juce::AudioIODevice> device(type.createDevice({}, name));
+    REQUIRE(device != nullptr);
+    REQUIRE(device->getInputChannelNames().size() == 3);
+
+    juce::BigInteger inputs;
+    inputs.setBit(2);
+    REQUIRE(device->open(inputs, {}, 48000.0, 256).isEmpty());
+    REQUIRE(device->getActiveInputChannels().countNumberOfSetBits() == 1);
+    device->close();
+
+    REQUIRE(type.addFileDevice(file.getSiblingFile("missing.wav")).isEmpty());
+    file.deleteFile();
   }
 }
 
 // Additional tests will be implemented once the audio components are more
 // developed
+
+namespace {
+// Records when it is prepared and whether it was fed after that
+class PrepareCounter : public mcam::AudioCallback {
+public:
+  std::atomic<int> numPrepares{0};
+  std::atomic<int> blocksProcessed{0};
+  double preparedRate = 0.0;
+  int preparedBufferSize = 0;
+
+protected:
+  void prepareToPlay(double sampleRate, int bufferSize) override {
+    AudioCallback::prepareToPlay(sampleRate, bufferSize);
+    preparedRate = sampleRate;
+    preparedBufferSize = bufferSize;
+    ++numPrepares;
+  }
+
+  void processAudio(const float *const *, int, int) override {
+    ++blocksProcessed;
+  }
+};
+} // namespace
+
+TEST_CASE("Asynchronous device switching", "[audio][switch]") {
+  mcam::AudioDeviceManager deviceManager;
+  deviceManager.setDeviceCacheFile({});
+  REQUIRE(deviceManager.initialize());
+
+  mcam::BufferProcessor processor;
+  processor.setMonitorChannel(0, 1);
+  deviceManager.addAudioCallback(&processor);
+
+  mcam::DeviceSwitcher switcher(deviceManager);
+  REQUIRE(switcher.getStatus().state == mcam::DeviceSwitcher::State::Idle);
+
+  SECTION("Switch completes in the background") {
+    switcher.requestSwitch("Virtual Sine 32ch", 48000.0, 256);
+    REQUIRE(switcher.waitUntilIdle(5000));
+
+    const auto status = switcher.getStatus();
+    REQUIRE(status.state == mcam::DeviceSwitcher::State::Completed);
+    REQUIRE(status.deviceName == "Virtual Sine 32ch");
+    REQUIRE(status.numInputChannels == 32);
+    REQUIRE(deviceManager.getNumInputChannels() == 32);
+
+    // Routing survives the switch and the new device feeds the processor
+    juce::Thread::sleep(50);
+    REQUIRE(processor.getMonitorChannel(0) == 1);
+    REQUIRE(processor.getSlotPeakLevel(0) > 0.0f);
+  }
+
+  SECTION("Callbacks are prepared before the new device starts") {
+    PrepareCounter counter;
+    deviceManager.addAudioCallback(&counter);
+    const int preparesBefore = counter.numPrepares;
+
+    switcher.requestSwitch("Virtual Sine 32ch", 44100.0, 128);
+    REQUIRE(switcher.waitUntilIdle(5000));
+    REQUIRE(switcher.getStatus().state ==
+            mcam::DeviceSwitcher::State::Completed);
+
+    // One preparation for the new format, done by the control thread
+    // before the device opened; the device start kept it
+    REQUIRE(counter.numPrepares == preparesBefore + 1);
+    REQUIRE(counter.preparedRate == 44100.0);
+    REQUIRE(counter.preparedBufferSize == 128);
+
+    const int blocksBefore = counter.blocksProcessed;
+    juce::Thread::sleep(50);
+    REQUIRE(counter.blocksProcessed > blocksBefore);
+
+    // Once removed, the audio thread no longer runs the callback
+    deviceManager.removeAudioCallback(&counter);
+    const int blocksAfterRemoval = counter.blocksProcessed;
+    juce::Thread::sleep(20);
+    REQUIRE(counter.blocksProcessed == blocksAfterRemoval);
+  }
+
+  SECTION("Unknown device fails") {
+    switcher.requestSwitch("No such device");
+    REQUIRE(switcher.waitUntilIdle(5000));
+    REQUIRE(switcher.getStatus().state ==
+            mcam::DeviceSwitcher::State::Failed);
+  }
+
+  SECTION("Latest request wins") {
+    switcher.requestSwitch("Virtual Sine 32ch");
+    switcher.requestSwitch("Virtual Noise 64ch");
+    switcher.requestSwitch("Virtual Sine 2ch");
+    REQUIRE(switcher.waitUntilIdle(5000));
+
+    REQUIRE(switcher.getStatus().state ==
+            mcam::DeviceSwitcher::State::Completed);
+    REQUIRE(deviceManager.getCurrentDeviceName() == "Virtual Sine 2ch");
+  }
+
+  deviceManager.removeAudioCallback(&processor);
+}
+
+TEST_CASE("Device catalog", "[audio][catalog]") {
+  juce::AudioDeviceManager deviceManager;
+  auto *virtualType = new mcam::VirtualAudioIODeviceType();
+  deviceManager.addAudioDeviceType(
+      std::unique_ptr<juce::AudioIODeviceType>(virtualType));
+
+  juce::CriticalSection driverLock;
+  auto cacheFile = juce::File::createTempFile(".json");
+
+  {
+    mcam::DeviceCatalog catalog(deviceManager, driverLock, cacheFile);
+    REQUIRE(catalog.getDeviceNames().isEmpty());
+
+    catalog.scanNow();
+    REQUIRE(catalog.getScanCount() == 1);
+    REQUIRE(catalog.getDeviceNames().contains("Virtual Sine 32ch"));
+
+    mcam::DeviceCatalog::DeviceInfo info;
+    REQUIRE(catalog.getDeviceInfo("Virtual Sine 32ch", info));
+    REQUIRE(info.typeName == mcam::VirtualAudioIODeviceType::TYPE_NAME);
+    REQUIRE(info.numInputChannels == 32);
+    REQUIRE(info.sampleRates.contains(48000.0));
+    REQUIRE(info.bufferSizes.contains(256));
+    REQUIRE(info.isPresent);
+    REQUIRE(cacheFile.existsAsFile());
+
+    SECTION("New devices are added by a rescan") {
+      virtualType->addDevice({"Virtual Test 4ch",
+                              mcam::VirtualAudioIODeviceType::Source::Sine,
+                              4});
+      catalog.scanNow();
+
+      REQUIRE(catalog.getDeviceInfo("Virtual Test 4ch", info));
+      REQUIRE(info.numInputChannels == 4);
+    }
+  }
+
+  SECTION("Cache is available before the first scan") {
+    mcam::DeviceCatalog catalog(deviceManager, driverLock, cacheFile);
+    REQUIRE(catalog.getScanCount() == 0);
+
+    mcam::DeviceCatalog::DeviceInfo info;
+    REQUIRE(catalog.getDeviceInfo("Virtual Sine 32ch", info));
+    REQUIRE(info.numInputChannels == 32);
+    REQUIRE(info.sampleRates.contains(48000.0));
+    REQUIRE_FALSE(info.isPresent);
+  }
+
+  SECTION("Aged entries are probed again") {
+    auto root = juce::JSON::parse(cacheFile);
+    auto *entries = root["devices"].getArray();
+    REQUIRE(entries != nullptr);
+
+    // A stale entry for a device whose driver now reports other inputs
+    const auto old = juce::Time::getCurrentTime() -
+                     juce::RelativeTime::days(
+                         mcam::DeviceCatalog::CACHE_MAX_AGE_DAYS + 1);
+    for (auto &entry : *entries) {
+      if (entry["name"].toString() == "Virtual Sine 32ch") {
+        entry.getDynamicObject()->setProperty("inputs", 99);
+        entry.getDynamicObject()->setProperty("probeTime",
+                                              old.toMilliseconds());
+      }
+    }
+    REQUIRE(cacheFile.replaceWithText(juce::JSON::toString(root)));
+
+    mcam::DeviceCatalog catalog(deviceManager, driverLock, cacheFile);
+    mcam::DeviceCatalog::DeviceInfo info;
+    REQUIRE(catalog.getDeviceInfo("Virtual Sine 32ch", info));
+    REQUIRE(info.numInputChannels == 99);
+
+    catalog.scanNow();
+    REQUIRE(catalog.getDeviceInfo("Virtual Sine 32ch", info));
+    REQUIRE(info.numInputChannels == 32);
+  }
+
+  SECTION("A cache from another system is ignored") {
+    auto root = juce::JSON::parse(cacheFile);
+    root.getDynamicObject()->setProperty("system", "Another OS 1.0");
+    REQUIRE(cacheFile.replaceWithText(juce::JSON::toString(root)));
+
+    mcam::DeviceCatalog catalog(deviceManager, driverLock, cacheFile);
+    REQUIRE(catalog.getDeviceNames().isEmpty());
+  }
+
+  cacheFile.deleteFile();
+}
+
+TEST_CASE("Asynchronous engine initialization", "[audio][startup]") {
+  mcam::AudioEngine audioEngine;
+  audioEngine.getAudioDeviceManager().setDeviceCacheFile({});
+
+  // Routing set before the device opens is kept
+  REQUIRE(audioEngine.getBufferProcessor().setMonitorChannel(0, 1));
+
+  audioEngine.initializeAsync(nullptr);
+
+  const auto startMs = juce::Time::getMillisecondCounter();
+  while (!audioEngine.isAudioInitialized() &&
+         juce::Time::getMillisecondCounter() - startMs < 10000)
+    juce::Thread::sleep(5);
+
+  REQUIRE(audioEngine.isAudioInitialized());
+  REQUIRE(audioEngine.getCurrentDeviceName().isNotEmpty());
+  REQUIRE(audioEngine.getBufferProcessor().getMonitorChannel(0) == 1);
+
+  audioEngine.shutdown();
+}
+
+TEST_CASE("JACK ports map to the channels the engine sees",
+          "[audio][jack]") {
+  using Device = mcam::JackAudioIODevice;
+
+  // Only active ports are passed on, renumbered from 0
+  juce::BigInteger active;
+  active.setBit(0);
+  active.setBit(2);
+  active.setBit(5);
+  active.setBit(Device::NUM_INPUT_PORTS - 1);
+
+  REQUIRE(Device::inputToChannel(active, 0) == 0);
+  REQUIRE(Device::inputToChannel(active, 2) == 1);
+  REQUIRE(Device::inputToChannel(active, 5) == 2);
+  REQUIRE(Device::inputToChannel(active, Device::NUM_INPUT_PORTS - 1) == 3);
+  REQUIRE(Device::inputToChannel(active, 3) == -1);
+  REQUIRE(Device::inputToChannel(active, -1) == -1);
+  REQUIRE(Device::inputToChannel(active, Device::NUM_INPUT_PORTS) == -1);
+
+  for (int channel = 0; channel < 4; ++channel)
+    REQUIRE(Device::inputToChannel(
+                active, Device::channelToInput(active, channel)) == channel);
+
+  REQUIRE(Device::channelToInput(active, 4) == -1);
+  REQUIRE(Device::channelToInput(active, -1) == -1);
+
+  // Derived channels have no port
+  REQUIRE(Device::channelToInput(active, mcam::BufferProcessor::MAX_CHANNELS) ==
+          -1);
+}
+
+TEST_CASE("JACK device type", "[audio][jack]") {
+  mcam::JackAudioIODeviceType type;
+  REQUIRE(type.createDevice({}, "No such device") == nullptr);
+
+  type.scanForDevices();
+  const auto names = type.getDeviceNames(true);
+
+  // Start a server to run this, e.g. "jackd -d dummy -r 48000 -p 256"
+  if (names.isEmpty())
+    SKIP("No JACK server running");
+
+  std::unique_ptr<juce::AudioIODevice> device(
+      type.createDevice({}, names[0]));
+  REQUIRE(device != nullptr);
+
+  juce::BigInteger inputs;
+  inputs.setRange(0, 8, true);
+  REQUIRE(device->open(inputs, {}, 0.0, 0).isEmpty());
+  REQUIRE(device->getCurrentSampleRate() > 0.0);
+  REQUIRE(device->getActiveInputChannels().countNumberOfSetBits() == 8);
+
+  // Processing runs in the JACK callback at the server's period
+  mcam::BufferProcessor processor;
+  processor.setMonitorChannel(0, 0);
+  std::atomic<int> blocks{0};
+  processor.addBufferCallback(
+      [&blocks](int, const juce::AudioBuffer<float> &) { ++blocks; });
+
+  device->start(&processor);
+
+  const auto startMs = juce::Time::getMillisecondCounter();
+  while (blocks < 10 && juce::Time::getMillisecondCounter() - startMs < 5000)
+    juce::Thread::sleep(5);
+
+  REQUIRE(blocks >= 10);
+
+  // Ports can be rewired while running
+  auto *jackDevice = dynamic_cast<mcam::JackAudioIODevice *>(device.get());
+  REQUIRE(jackDevice != nullptr);
+
+  const auto sources = jackDevice->getSourcePorts();
+  if (!sources.isEmpty()) {
+    REQUIRE(jackDevice->connectInput(sources[0], 5));
+    REQUIRE(jackDevice->getInputConnections(5).contains(sources[0]));
+
+    jackDevice->disconnectInput(5);
+    REQUIRE(jackDevice->getInputConnections(5).isEmpty());
+  }
+
+  REQUIRE(device->isPlaying());
+  device->stop();
+  device->close();
+}
+
+TEST_CASE("Aggregate devices", "[audio][aggregate]") {
+  SECTION("Clock drift is estimated from jittery callback times") {
+    // 48 kHz nominal, running 100 ppm fast, callbacks up to 1 ms late
+    constexpr double trueRate = 48000.0 * (1.0 + 100.0e-6);
+    constexpr int blockSize = 256;
+    juce::Random random(7);
+
+    mcam::ClockDriftEstimator clock;
+    clock.reset(48000.0);
+
+    for (int block = 0; block * blockSize < trueRate * 60.0; ++block)
+      clock.update(1000.0 + block * blockSize / trueRate +
+                       0.001 * random.nextDouble(),
+                   blockSize);
+
+    const double driftPpm = (clock.getSampleRate() / 48000.0 - 1.0) * 1.0e6;
+    REQUIRE(driftPpm == Catch::Approx(100.0).margin(25.0));
+  }
+
+  juce::AudioDeviceManager deviceManager;
+  auto *virtualType = new mcam::VirtualAudioIODeviceType();
+  deviceManager.addAudioDeviceType(
+      std::unique_ptr<juce::AudioIODeviceType>(virtualType));
+  auto *aggregateType = new mcam::AggregateAudioIODeviceType(deviceManager);
+  deviceManager.addAudioDeviceType(
+      std::unique_ptr<juce::AudioIODeviceType>(aggregateType));
+
+  // A follower whose crystal runs 300 ppm fast
+  mcam::VirtualAudioIODeviceType::DeviceConfig follower;
+  follower.name = "Virtual Drifting 4ch";
+  follower.numChannels = 4;
+  follower.clockDriftPpm = 300.0;
+  virtualType->addDevice(follower);
+
+  REQUIRE(aggregateType->addAggregate({"Virtual Sine 2ch"}).isEmpty());
+  const auto name =
+      aggregateType->addAggregate({"Virtual Sine 2ch", follower.name});
+  REQUIRE(aggregateType->getDeviceNames(true).contains(name));
+  REQUIRE(aggregateType->getMemberNames(name).size() == 2);
+
+  SECTION("Members are merged into one channel space") {
+    std::unique_ptr<juce::AudioIODevice> device(
+        aggregateType->createDevice({}, name));
+    REQUIRE(device != nullptr);
+
+    const auto channelNames = device->getInputChannelNames();
+    REQUIRE(channelNames.size() == 6);
+    REQUIRE(channelNames[2].startsWith(follower.name));
+
+    juce::BigInteger inputs;
+    inputs.setRange(0, 6, true);
+    REQUIRE(device->open(inputs, {}, 48000.0, 256).isEmpty());
+    REQUIRE(device->getActiveInputChannels().countNumberOfSetBits() == 6);
+
+    // Monitor the follower's last channel through the master's callback
+    mcam::BufferProcessor processor;
+    processor.setMonitorChannel(0, 5);
+    std::atomic<int> blocks{0};
+    processor.addBufferCallback(
+        [&blocks](int, const juce::AudioBuffer<float> &) { ++blocks; });
+
+    device->start(&processor);
+
+    const auto startMs = juce::Time::getMillisecondCounter();
+    while (processor.getSlotPeakLevel(0) <= 0.0f &&
+           juce::Time::getMillisecondCounter() - startMs < 5000)
+      juce::Thread::sleep(10);
+
+    REQUIRE(processor.getSlotPeakLevel(0) > 0.0f);
+    REQUIRE(blocks > 0);
+
+    auto *aggregate =
+        dynamic_cast<mcam::AggregateAudioIODevice *>(device.get());
+    REQUIRE(aggregate != nullptr);
+
+    const auto status = aggregate->getMemberStatus();
+    REQUIRE(status.size() == 2);
+    REQUIRE(status[0].isClockMaster);
+    REQUIRE(status[0].numChannels == 2);
+    REQUIRE(status[1].firstChannel == 2);
+    REQUIRE(status[1].numChannels == 4);
+    REQUIRE(status[1].delaySeconds > 0.0);
+    REQUIRE(status[1].delaySeconds < 0.1);
+
+    device->stop();
+    REQUIRE_FALSE(device->isPlaying());
+    device->close();
+  }
+
+  SECTION("Missing members fail to create") {
+    const auto missing =
+        aggregateType->addAggregate({"Virtual Sine 2ch", "No such device"});
+    REQUIRE(aggregateType->createDevice({}, missing) == nullptr);
+
+    aggregateType->removeAggregate(missing);
+    REQUIRE_FALSE(aggregateType->getDeviceNames(true).contains(missing));
+  }
+}
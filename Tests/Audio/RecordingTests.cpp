@@ -0,0 +1,498 @@
+#include "../../Source/Audio/Recording/DiskRecorder.h"
+#include "../../Source/Audio/Recording/LosslessBlockCodec.h"
+#include "../../Source/Audio/Recording/RetroactiveCapture.h"
+#include "../../Source/JuceHeader.h"
+#include "../Utilities/MockAudioDevice.h"
+#include "../Utilities/TestUtils.h"
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+// Fills each channel with a ramp offset by channel so files can be checked
+void fillRamp(juce::AudioBuffer<float> &buffer, juce::int64 startSample) {
+  for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+    auto *data = buffer.getWritePointer(ch);
+    for (int i = 0; i < buffer.getNumSamples(); ++i) {
+      const auto position = (startSample + i) % 1000;
+      data[i] = 0.1f * (float)(ch + 1) + 0.0001f * (float)position;
+    }
+  }
+}
+
+juce::Array<juce::File> findRecordings(const juce::File &directory) {
+  auto files = directory.findChildFiles(juce::File::findFiles, false, "*.wav");
+  files.sort();
+  return files;
+}
+} // namespace
+
+TEST_CASE("Disk recorder", "[audio][recording]") {
+  juce::TemporaryFile tempDir;
+  const auto directory = tempDir.getFile();
+  REQUIRE(directory.createDirectory());
+
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 256;
+
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 4, true);
+  mockDevice.open(inputs, outputs, sampleRate, blockSize);
+
+  mcam::DiskRecorder recorder;
+  recorder.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&recorder);
+
+  SECTION("Selected channels are written in order and rotated by duration") {
+    mcam::DiskRecorder::Settings settings;
+    settings.directory = directory;
+    settings.channels = {2, 0, 7}; // channel 7 does not exist
+    settings.rotateAfterSeconds = 0.5;
+
+    REQUIRE(recorder.startRecording(settings));
+    REQUIRE(recorder.isRecording());
+
+    // 1.2 seconds in device-sized blocks
+    juce::AudioBuffer<float> input(4, blockSize);
+    const int numBlocks = juce::roundToInt(1.2 * sampleRate / blockSize);
+
+    for (int block = 0; block < numBlocks; ++block) {
+      fillRamp(input, (juce::int64)block * blockSize);
+      mockDevice.simulateCallback(input);
+    }
+
+    recorder.stopRecording();
+    REQUIRE_FALSE(recorder.isRecording());
+
+    const auto stats = recorder.getStats();
+    REQUIRE(stats.droppedSamples == 0);
+    REQUIRE(stats.samplesWritten == (juce::int64)numBlocks * blockSize);
+    REQUIRE(stats.filesWritten == 3);
+
+    const auto files = findRecordings(directory);
+    REQUIRE(files.size() == 3);
+
+    juce::WavAudioFormat wav;
+    juce::int64 position = 0;
+    const juce::int64 expectedLengths[] = {24000, 24000, 9600};
+
+    for (int f = 0; f < files.size(); ++f) {
+      std::unique_ptr<juce::AudioFormatReader> reader(
+          wav.createReaderFor(files[f].createInputStream().release(), true));
+      REQUIRE(reader != nullptr);
+      REQUIRE(reader->numChannels == 3);
+      REQUIRE(reader->sampleRate == sampleRate);
+      REQUIRE(reader->lengthInSamples == expectedLengths[f]);
+
+      juce::AudioBuffer<float> contents(3, (int)reader->lengthInSamples);
+      reader->read(&contents, 0, contents.getNumSamples(), 0, true, true);
+
+      juce::AudioBuffer<float> expected(4, contents.getNumSamples());
+      fillRamp(expected, position);
+
+      for (int i = 0; i < contents.getNumSamples(); i += 97) {
+        REQUIRE(contents.getSample(0, i) ==
+                Catch::Approx(expected.getSample(2, i)).margin(1.0e-4));
+        REQUIRE(contents.getSample(1, i) ==
+                Catch::Approx(expected.getSample(0, i)).margin(1.0e-4));
+        REQUIRE(contents.getSample(2, i) == 0.0f);
+      }
+
+      position += reader->lengthInSamples;
+    }
+  }
+
+  SECTION("Bytes written are the encoded file sizes") {
+    auto &bytesWritten = mcam::MetricsRegistry::getInstance().counter(
+        "mcam_recorder_bytes_written_total",
+        "Bytes written to recording files");
+    const auto before = bytesWritten.getValue();
+
+    mcam::DiskRecorder::Settings settings;
+    settings.directory = directory;
+    settings.channels = {0, 1};
+    settings.format = mcam::DiskRecorder::Format::Flac;
+
+    REQUIRE(recorder.startRecording(settings));
+
+    // A ramp compresses far below its 24-bit PCM size
+    juce::AudioBuffer<float> input(4, blockSize);
+    for (int block = 0; block < 100; ++block) {
+      fillRamp(input, (juce::int64)block * blockSize);
+      mockDevice.simulateCallback(input);
+    }
+
+    recorder.stopRecording();
+
+    const auto files =
+        directory.findChildFiles(juce::File::findFiles, false, "*.flac");
+    REQUIRE(files.size() == 1);
+    REQUIRE(bytesWritten.getValue() - before ==
+            (juce::uint64)files[0].getSize());
+    REQUIRE(files[0].getSize() < 100 * blockSize * 2 * 3);
+  }
+
+  SECTION("A failed rotation ends the recording") {
+    mcam::DiskRecorder::Settings settings;
+    settings.directory = directory.getChildFile("removed");
+    settings.channels = {0};
+    settings.rotateAfterSeconds = 0.1;
+
+    REQUIRE(recorder.startRecording(settings));
+
+    // The next file cannot be opened once its directory is gone
+    REQUIRE(settings.directory.deleteRecursively());
+
+    juce::AudioBuffer<float> input(4, blockSize);
+    for (int block = 0; block < 100 && recorder.isRecording(); ++block) {
+      fillRamp(input, (juce::int64)block * blockSize);
+      mockDevice.simulateCallback(input);
+      juce::Thread::sleep(1);
+    }
+
+    // The writer gives up rather than leaving a stalled recording running
+    for (int i = 0; i < 200 && recorder.isRecording(); ++i)
+      juce::Thread::sleep(10);
+
+    REQUIRE_FALSE(recorder.isRecording());
+    REQUIRE(recorder.getLastError().isNotEmpty());
+
+    // Once the writer has exited, nothing is queued or counted any more
+    recorder.stopRecording();
+    REQUIRE(recorder.getStats().fifoFillSamples == 0);
+
+    const auto dropped = recorder.getStats().droppedSamples;
+    mockDevice.simulateCallback(input);
+    REQUIRE(recorder.getStats().droppedSamples == dropped);
+  }
+
+  SECTION("Invalid settings are rejected") {
+    mcam::DiskRecorder::Settings settings;
+    settings.directory = directory;
+
+    REQUIRE_FALSE(recorder.startRecording(settings));
+    REQUIRE(recorder.getLastError().isNotEmpty());
+
+    settings.format = mcam::DiskRecorder::Format::Flac;
+    for (int ch = 0; ch < 16; ++ch)
+      settings.channels.add(ch);
+
+    REQUIRE_FALSE(recorder.startRecording(settings));
+    REQUIRE_FALSE(recorder.isRecording());
+  }
+
+  mockDevice.stop();
+  recorder.audioDeviceStopped();
+  directory.deleteRecursively();
+}
+
+TEST_CASE("Lossless block codec", "[audio][recording]") {
+  constexpr int numSamples = mcam::RetroactiveCapture::FRAME_SIZE;
+  juce::AudioBuffer<float> input(1, numSamples);
+  juce::AudioBuffer<float> output(1, numSamples);
+  juce::MemoryBlock encoded;
+
+  // Decoding must give back the input bit for bit
+  auto roundTrip = [&] {
+    mcam::LosslessBlockCodec::encode(input.getReadPointer(0), numSamples,
+                                     encoded);
+    REQUIRE(mcam::LosslessBlockCodec::decode(encoded.getData(),
+                                             encoded.getSize(),
+                                             output.getWritePointer(0),
+                                             numSamples));
+    REQUIRE(std::memcmp(output.getReadPointer(0), input.getReadPointer(0),
+                        sizeof(float) * numSamples) == 0);
+  };
+
+  // Fills the input from 24-bit integers through JUCE's converter, as a
+  // device or file reader delivers them
+  auto fromInt24 = [&](const std::function<juce::int32(int)> &value) {
+    std::vector<char> packed((size_t)numSamples * 3);
+    for (int i = 0; i < numSamples; ++i)
+      juce::ByteOrder::littleEndian24BitToChars(value(i),
+                                                packed.data() + i * 3);
+
+    using namespace juce::AudioData;
+    using Source = Pointer<Int24, LittleEndian, Interleaved, Const>;
+    using Dest = Pointer<Float32, NativeEndian, NonInterleaved, NonConst>;
+    Dest(input.getWritePointer(0))
+        .convertSamples(Source(packed.data(), 1), numSamples);
+  };
+
+  SECTION("Tonal converter data compresses well") {
+    fromInt24([](int i) {
+      return (juce::int32)std::lround(
+          0.5 * 8388607.0 * std::sin(0.0576 * i));
+    });
+    roundTrip();
+    REQUIRE(encoded.getSize() < (size_t)numSamples * 2);
+  }
+
+  SECTION("Converter data round trips up to full scale") {
+    // Alternating extremes, and a sweep over values above 2^22
+    fromInt24([](int i) {
+      return i % 2 == 0 ? -8388608 : 8388607;
+    });
+    roundTrip();
+    REQUIRE(encoded.getSize() <= 1 + (size_t)numSamples * 4);
+
+    fromInt24([](int i) { return 4194304 + i * 1021 % 4194303; });
+    roundTrip();
+  }
+
+  SECTION("Arbitrary floats round trip") {
+    TestUtils::generateWhiteNoise(input, 1.0f);
+    roundTrip();
+
+    // Beyond full scale, negative zero, tiny and non-finite values
+    auto *data = input.getWritePointer(0);
+    data[0] = 1.5f;
+    data[1] = -0.0f;
+    data[2] = 1.0e-30f;
+    data[3] = std::numeric_limits<float>::infinity();
+    roundTrip();
+
+    TestUtils::generateSquareWave(input, 12000.0f, 48000.0f, 1.0f);
+    roundTrip();
+  }
+
+  SECTION("Silence is stored in a single byte") {
+    input.clear();
+    roundTrip();
+    REQUIRE(encoded.getSize() == 1);
+  }
+
+  SECTION("Truncated blocks are rejected") {
+    TestUtils::generateWhiteNoise(input, 0.5f);
+    mcam::LosslessBlockCodec::encode(input.getReadPointer(0), numSamples,
+                                     encoded);
+    REQUIRE_FALSE(mcam::LosslessBlockCodec::decode(
+        encoded.getData(), encoded.getSize() / 2, output.getWritePointer(0),
+        numSamples));
+
+    fromInt24([](int i) { return i * 997 % 65536; });
+    mcam::LosslessBlockCodec::encode(input.getReadPointer(0), numSamples,
+                                     encoded);
+    REQUIRE_FALSE(mcam::LosslessBlockCodec::decode(
+        encoded.getData(), encoded.getSize() / 2, output.getWritePointer(0),
+        numSamples));
+  }
+}
+
+TEST_CASE("Retroactive capture", "[audio][recording]") {
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 256;
+  constexpr int numBlocks = 280; // ~1.5 s
+
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 4, true);
+  mockDevice.open(inputs, outputs, sampleRate, blockSize);
+
+  mcam::RetroactiveCapture capture;
+  capture.setHistoryLength(1.0);
+  capture.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&capture);
+
+  juce::AudioBuffer<float> input(4, blockSize);
+  for (int block = 0; block < numBlocks; ++block) {
+    fillRamp(input, (juce::int64)block * blockSize);
+    mockDevice.simulateCallback(input);
+  }
+
+  // Stopping the device compresses the staged tail
+  mockDevice.stop();
+  capture.audioDeviceStopped();
+
+  const auto stats = capture.getStats();
+  REQUIRE(stats.numChannels == 4);
+  REQUIRE(stats.droppedSamples == 0);
+  REQUIRE(stats.historySeconds >= 1.0);
+  REQUIRE(stats.historySeconds <
+          1.0 + mcam::RetroactiveCapture::FRAME_SIZE / sampleRate);
+  REQUIRE(stats.compressionRatio > 1.0);
+  REQUIRE(stats.compressCpuSeconds > 0.0);
+
+  SECTION("Dump writes the requested range") {
+    juce::TemporaryFile tempFile(".wav");
+    juce::WaitableEvent finished;
+    std::atomic<bool> succeeded{false};
+
+    REQUIRE(capture.dumpToFile(tempFile.getFile(), 0.5, 0.5, [&](bool ok) {
+      succeeded = ok;
+      finished.signal();
+    }));
+    REQUIRE(finished.wait(10000));
+    REQUIRE(succeeded);
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(
+        tempFile.getFile().createInputStream().release(), true));
+    REQUIRE(reader != nullptr);
+    REQUIRE(reader->numChannels == 4);
+    REQUIRE(reader->lengthInSamples == 24000);
+
+    // Float samples, so the history comes back exactly as captured
+    REQUIRE(reader->usesFloatingPointData);
+    REQUIRE(reader->bitsPerSample == 32);
+
+    juce::AudioBuffer<float> contents(4, 24000);
+    reader->read(&contents, 0, 24000, 0, true, true);
+
+    juce::AudioBuffer<float> expected(4, 24000);
+    fillRamp(expected, (juce::int64)numBlocks * blockSize - 24000);
+
+    for (int ch = 0; ch < 4; ++ch) {
+      for (int i = 0; i < 24000; i += 101) {
+        REQUIRE(contents.getSample(ch, i) == expected.getSample(ch, i));
+      }
+    }
+  }
+
+  SECTION("Ranges beyond the history are clipped") {
+    juce::TemporaryFile tempFile(".wav");
+    juce::WaitableEvent finished;
+
+    REQUIRE(capture.dumpToFile(tempFile.getFile(), 60.0, 60.0,
+                               [&](bool) { finished.signal(); }));
+    REQUIRE(finished.wait(10000));
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(
+        tempFile.getFile().createInputStream().release(), true));
+    REQUIRE(reader != nullptr);
+    REQUIRE(reader->lengthInSamples ==
+            juce::roundToInt(stats.historySeconds * sampleRate));
+  }
+}
+
+TEST_CASE("Retroactive dumps keep samples beyond full scale",
+          "[audio][recording]") {
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, 1, true);
+  mockDevice.open(inputs, outputs, 48000.0, 256);
+
+  mcam::RetroactiveCapture capture;
+  capture.setHistoryLength(1.0);
+  capture.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&capture);
+
+  // Float-native input, as JACK delivers it, with peaks a 24-bit file
+  // would clip
+  juce::AudioBuffer<float> input(1, 256);
+  for (int i = 0; i < 256; ++i)
+    input.setSample(0, i, i % 2 == 0 ? 1.5f : -2.0f + 1.0e-7f * (float)i);
+
+  for (int block = 0; block < 20; ++block)
+    mockDevice.simulateCallback(input);
+
+  mockDevice.stop();
+  capture.audioDeviceStopped();
+
+  juce::TemporaryFile tempFile(".wav");
+  juce::WaitableEvent finished;
+  REQUIRE(capture.dumpToFile(tempFile.getFile(), 0.1, 256 / 48000.0,
+                             [&](bool) { finished.signal(); }));
+  REQUIRE(finished.wait(10000));
+
+  juce::WavAudioFormat wav;
+  std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(
+      tempFile.getFile().createInputStream().release(), true));
+  REQUIRE(reader != nullptr);
+  REQUIRE(reader->lengthInSamples == 256);
+
+  // 0.1 s before the newest of 5120 samples
+  constexpr int rangeStart = 5120 - 4800;
+
+  juce::AudioBuffer<float> contents(1, 256);
+  reader->read(&contents, 0, 256, 0, true, true);
+
+  for (int i = 0; i < 256; ++i)
+    REQUIRE(contents.getSample(0, i) ==
+            input.getSample(0, (rangeStart + i) % 256));
+}
+
+// Sustained 128 channel / 96 kHz recording paced at real time. Hidden by
+// default; run with: MCAMTests "[benchmark][recording]"
+// MCAM_BENCH_DIR selects the target disk, MCAM_BENCH_SECONDS the duration.
+TEST_CASE("Disk recorder sustained throughput", "[.][benchmark][recording]") {
+  constexpr double sampleRate = 96000.0;
+  constexpr int blockSize = 512;
+  constexpr int numChannels = 128;
+
+  const auto benchDir = juce::SystemStats::getEnvironmentVariable(
+      "MCAM_BENCH_DIR",
+      juce::File::getSpecialLocation(juce::File::tempDirectory)
+          .getFullPathName());
+  const double seconds =
+      juce::SystemStats::getEnvironmentVariable("MCAM_BENCH_SECONDS", "10")
+          .getDoubleValue();
+
+  const auto directory =
+      juce::File(benchDir).getNonexistentChildFile("mcam_bench", "");
+  REQUIRE(directory.createDirectory());
+
+  MockAudioDevice mockDevice;
+  juce::BigInteger inputs, outputs;
+  inputs.setRange(0, numChannels, true);
+  mockDevice.open(inputs, outputs, sampleRate, blockSize);
+
+  mcam::DiskRecorder recorder;
+  recorder.audioDeviceAboutToStart(&mockDevice);
+  mockDevice.start(&recorder);
+
+  mcam::DiskRecorder::Settings settings;
+  settings.directory = directory;
+  settings.rotateAfterSeconds = 60.0;
+  for (int ch = 0; ch < numChannels; ++ch)
+    settings.channels.add(ch);
+
+  REQUIRE(recorder.startRecording(settings));
+
+  juce::AudioBuffer<float> input(numChannels, blockSize);
+  TestUtils::generateWhiteNoise(input, 0.5f);
+
+  const int numBlocks = juce::roundToInt(seconds * sampleRate / blockSize);
+  const double blockSeconds = blockSize / sampleRate;
+  const auto startTicks = juce::Time::getHighResolutionTicks();
+  int maxFifoFill = 0;
+
+  for (int block = 0; block < numBlocks; ++block) {
+    // Deliver blocks on the device schedule
+    const auto dueTicks =
+        startTicks + juce::Time::secondsToHighResolutionTicks(block *
+                                                              blockSeconds);
+    while (juce::Time::getHighResolutionTicks() < dueTicks)
+      juce::Thread::sleep(1);
+
+    mockDevice.simulateCallback(input);
+    maxFifoFill = juce::jmax(maxFifoFill, recorder.getStats().fifoFillSamples);
+  }
+
+  const auto drainStart = juce::Time::getHighResolutionTicks();
+  recorder.stopRecording();
+  const double drainSeconds = juce::Time::highResolutionTicksToSeconds(
+      juce::Time::getHighResolutionTicks() - drainStart);
+
+  const auto stats = recorder.getStats();
+  const double megabytes =
+      stats.samplesWritten * numChannels * 3.0 / (1024.0 * 1024.0);
+
+  UNSCOPED_INFO("Recorded " << seconds << " s of " << numChannels
+                            << " channels at " << sampleRate << " Hz ("
+                            << megabytes << " MB)");
+  UNSCOPED_INFO("Peak FIFO fill " << maxFifoFill << " of "
+                                  << stats.fifoCapacitySamples
+                                  << " samples, final drain " << drainSeconds
+                                  << " s");
+  WARN("Required write rate "
+       << (numChannels * sampleRate * 3.0 / (1024.0 * 1024.0)) << " MB/s");
+
+  mockDevice.stop();
+  recorder.audioDeviceStopped();
+  directory.deleteRecursively();
+
+  REQUIRE(stats.droppedSamples == 0);
+  REQUIRE(stats.samplesWritten == (juce::int64)numBlocks * blockSize);
+}
@@ -1,6 +1,19 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
 #include "../../Source/JuceHeader.h"
 #include "../../Source/Core/Logger.h"
+#include "../../Source/Core/LatencyTracker.h"
+#include "../../Source/Core/Metrics.h"
+#include "../../Source/Core/RealtimeGuard.h"
+#include "../../Source/Core/ThreadTuning.h"
+#include <mutex>
+#include <thread>
+
+#if JUCE_LINUX
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 // Mock main application component for testing
 class MockMainComponent : public juce::Component
@@ -126,4 +139,377 @@ TEST_CASE("Core functionality tests", "[core]")
     }
 }
 
+TEST_CASE("Metrics registry tests", "[metrics]")
+{
+    auto& registry = mcam::MetricsRegistry::getInstance();
+
+    SECTION("Counters sum increments from all threads")
+    {
+        auto& counter = registry.counter("mcam_test_events_total", "Test events");
+        const auto before = counter.getValue();
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&counter]
+            {
+                for (int i = 0; i < 1000; ++i)
+                    counter.add();
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(counter.getValue() - before == 4000);
+    }
+
+    SECTION("Same name and labels return the same metric")
+    {
+        auto& a = registry.gauge("mcam_test_gauge", "Test gauge", "slot=\"1\"");
+        auto& b = registry.gauge("mcam_test_gauge", "Test gauge", "slot=\"1\"");
+        auto& c = registry.gauge("mcam_test_gauge", "Test gauge", "slot=\"2\"");
+
+        REQUIRE(&a == &b);
+        REQUIRE(&a != &c);
+    }
+
+    SECTION("Histogram buckets are cumulative")
+    {
+        auto& histogram = registry.histogram("mcam_test_seconds", "Test histogram", {0.1, 1.0});
+        histogram.observe(0.05);
+        histogram.observe(0.5);
+        histogram.observe(5.0);
+
+        const auto snapshot = histogram.getSnapshot();
+        REQUIRE(snapshot.cumulativeCounts.size() == 3);
+        REQUIRE(snapshot.cumulativeCounts[0] >= 1);
+        REQUIRE(snapshot.cumulativeCounts[2] == snapshot.count);
+        REQUIRE(snapshot.cumulativeCounts[0] <= snapshot.cumulativeCounts[1]);
+    }
+
+    SECTION("Prometheus text output")
+    {
+        // Registered here too, so the section passes on its own or filtered
+        registry.counter("mcam_test_events_total", "Test events");
+        registry.histogram("mcam_test_seconds", "Test histogram", {0.1, 1.0});
+        registry.gauge("mcam_test_gauge", "Test gauge", "slot=\"1\"");
+        registry.gauge("mcam_test_gauge", "Test gauge", "slot=\"2\"");
+        registry.gauge("mcam_test_provider", "Provider gauge").setProvider([] { return 42.0; });
+
+        const auto text = registry.renderPrometheusText();
+        REQUIRE(text.contains("# TYPE mcam_test_events_total counter"));
+        REQUIRE(text.contains("# TYPE mcam_test_seconds histogram"));
+        REQUIRE(text.contains("mcam_test_seconds_bucket{le=\"+Inf\"}"));
+        REQUIRE(text.contains("mcam_test_provider 42"));
+
+        // HELP/TYPE appear once per family even with several label sets
+        REQUIRE(text.indexOf("# TYPE mcam_test_gauge") == text.lastIndexOf("# TYPE mcam_test_gauge"));
+    }
+}
+
+TEST_CASE("Latency tracker tests", "[latency]")
+{
+    auto& tracker = mcam::LatencyTracker::getInstance();
+    tracker.reset();
+
+    using Stage = mcam::LatencyTracker::Stage;
+    constexpr juce::int64 ms = 1000000;
+
+    SECTION("Painted stamps are split into stages")
+    {
+        const auto now = mcam::LatencyTracker::nowNs();
+
+        mcam::LatencyTracker::Stamp stamp;
+        stamp.captureNs = now - 20 * ms;
+        stamp.callbackNs = now - 15 * ms;
+        stamp.analysisNs = now - 14 * ms;
+        stamp.publishNs = now - 4 * ms;
+        tracker.recordPainted(stamp);
+
+        const auto capture = tracker.getSummary(Stage::Capture);
+        REQUIRE(capture.count == 1);
+        REQUIRE(capture.p50 == Catch::Approx(0.005).margin(1.0e-6));
+        REQUIRE(tracker.getSummary(Stage::Analysis).p50 == Catch::Approx(0.001).margin(1.0e-6));
+        REQUIRE(tracker.getSummary(Stage::Publish).p50 == Catch::Approx(0.010).margin(1.0e-6));
+
+        // Paint and total end at the time of recording
+        REQUIRE(tracker.getSummary(Stage::Paint).p50 >= 0.004);
+        REQUIRE(tracker.getSummary(Stage::Total).p50 >= 0.020);
+
+        REQUIRE(tracker.getReport().contains("publish"));
+    }
+
+    SECTION("Incomplete stamps are ignored")
+    {
+        mcam::LatencyTracker::Stamp stamp;
+        stamp.captureNs = mcam::LatencyTracker::nowNs();
+        tracker.recordPainted(stamp);
+
+        REQUIRE(tracker.getSummary(Stage::Total).count == 0);
+    }
+
+    SECTION("Percentiles over many samples")
+    {
+        const auto now = mcam::LatencyTracker::nowNs();
+
+        for (int i = 1; i <= 100; ++i)
+        {
+            mcam::LatencyTracker::Stamp stamp;
+            stamp.publishNs = now;
+            stamp.analysisNs = now - i * ms;
+            stamp.callbackNs = stamp.analysisNs;
+            stamp.captureNs = stamp.analysisNs;
+            tracker.recordPainted(stamp);
+        }
+
+        const auto publish = tracker.getSummary(Stage::Publish);
+        REQUIRE(publish.count == 100);
+        REQUIRE(publish.p50 == Catch::Approx(0.050).margin(1.0e-6));
+        REQUIRE(publish.p95 == Catch::Approx(0.095).margin(1.0e-6));
+        REQUIRE(publish.max == Catch::Approx(0.100).margin(1.0e-6));
+    }
+
+    SECTION("Blocks are stamped from the callback context")
+    {
+        juce::AudioIODeviceCallbackContext context;
+        const auto stamp = mcam::LatencyTracker::stampBlock(context, 480, 48000.0);
+
+        REQUIRE(stamp.isValid());
+        REQUIRE(stamp.callbackNs - stamp.captureNs == 10 * ms);
+    }
+
+    tracker.reset();
+}
+
 // Add more test cases as needed
+
+TEST_CASE("Realtime guard tests", "[realtime]")
+{
+    using Guard = mcam::RealtimeGuard;
+    auto& guard = Guard::getInstance();
+    guard.clear();
+
+    REQUIRE(Guard::isEnabled());
+
+    SECTION("Only calls inside realtime spans are reported")
+    {
+        std::vector<int> outside(100, 1);
+        REQUIRE_FALSE(Guard::isRealtimeThread());
+
+        {
+            const Guard::ScopedRealtime realtime;
+            REQUIRE(Guard::isRealtimeThread());
+
+            int sum = 0;
+            for (int value : outside)
+                sum += value;
+            REQUIRE(sum == 100);
+        }
+
+        REQUIRE(guard.getNumViolations() == 0);
+    }
+
+    SECTION("Allocations and frees are reported with a stack trace")
+    {
+        {
+            const Guard::ScopedRealtime realtime;
+            std::vector<int> inside(100, 1);
+        }
+
+        const auto violations = guard.getViolations();
+        REQUIRE(violations.size() == 2);
+        REQUIRE(violations[0].kind == Guard::Kind::allocation);
+        REQUIRE(violations[1].kind == Guard::Kind::deallocation);
+        REQUIRE(violations[0].stackTrace.isNotEmpty());
+
+        guard.clear();
+        REQUIRE(guard.getNumViolations() == 0);
+    }
+
+#if defined(__GLIBC__)
+    SECTION("Every lock is reported, allowed locks only when they wait")
+    {
+        juce::CriticalSection lock;
+        std::mutex mutex;
+
+        {
+            const Guard::ScopedRealtime realtime;
+            const juce::ScopedLock sl(lock);
+            mutex.lock();
+            mutex.unlock();
+        }
+
+        REQUIRE(guard.getNumViolations() == 2);
+        REQUIRE(guard.getViolations()[0].kind == Guard::Kind::lock);
+        REQUIRE(guard.getViolations()[1].kind == Guard::Kind::lock);
+        guard.clear();
+
+        REQUIRE(Guard::allowLock(lock, "test lock"));
+
+        {
+            const Guard::ScopedRealtime realtime;
+            const juce::ScopedLock sl(lock);
+        }
+
+        REQUIRE(guard.getNumViolations() == 0);
+
+        std::atomic<bool> held { false };
+
+        std::thread holder([&] {
+            const juce::ScopedLock sl(lock);
+            held = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+
+        while (!held)
+            std::this_thread::yield();
+
+        {
+            const Guard::ScopedRealtime realtime;
+            const juce::ScopedLock sl(lock);
+        }
+
+        holder.join();
+        Guard::disallowLock(lock);
+
+        REQUIRE(guard.getNumViolations() == 1);
+        REQUIRE(guard.getViolations()[0].kind == Guard::Kind::lockWait);
+        REQUIRE(guard.getViolations()[0].function == "test lock");
+        guard.clear();
+
+        {
+            const Guard::ScopedRealtime realtime;
+            const juce::ScopedLock sl(lock);
+        }
+
+        REQUIRE(guard.getNumViolations() == 1);
+        REQUIRE(guard.getViolations()[0].kind == Guard::Kind::lock);
+    }
+
+    SECTION("Blocking calls are reported")
+    {
+        {
+            const Guard::ScopedRealtime realtime;
+            juce::Thread::sleep(1);
+        }
+
+        REQUIRE(guard.getNumViolations() == 1);
+        REQUIRE(guard.getViolations()[0].kind == Guard::Kind::blockingCall);
+    }
+#endif
+
+    SECTION("Only the first violations are kept")
+    {
+        {
+            const Guard::ScopedRealtime realtime;
+
+            for (int i = 0; i < Guard::MAX_REPORTS; ++i)
+                std::make_unique<int>(i);
+        }
+
+        REQUIRE(guard.getNumViolations() == 2 * Guard::MAX_REPORTS);
+        REQUIRE(guard.getViolations().size() == (size_t)Guard::MAX_REPORTS);
+    }
+
+    guard.clear();
+}
+
+TEST_CASE("Thread tuning tests", "[threads]")
+{
+    using Tuning = mcam::ThreadTuning;
+    using ThreadClass = Tuning::ThreadClass;
+    auto& tuning = Tuning::getInstance();
+
+    SECTION("CPU lists")
+    {
+        juce::BigInteger cpus;
+
+        REQUIRE(Tuning::parseCpuList("0-1, 4", cpus));
+        REQUIRE(cpus.countNumberOfSetBits() == 3);
+        REQUIRE(cpus[0]);
+        REQUIRE(cpus[1]);
+        REQUIRE(cpus[4]);
+
+        REQUIRE(Tuning::parseCpuList("", cpus));
+        REQUIRE(cpus.isZero());
+
+        REQUIRE_FALSE(Tuning::parseCpuList("3-1", cpus));
+        REQUIRE_FALSE(Tuning::parseCpuList("two", cpus));
+        REQUIRE_FALSE(Tuning::parseCpuList(juce::String(Tuning::MAX_CPUS), cpus));
+    }
+
+    SECTION("Out of range settings are rejected")
+    {
+        Tuning::Settings settings;
+        settings.fifoPriority = 100;
+        REQUIRE_FALSE(tuning.setSettings(ThreadClass::analysis, settings));
+
+        settings.fifoPriority = 0;
+        settings.niceValue = 20;
+        REQUIRE_FALSE(tuning.setSettings(ThreadClass::analysis, settings));
+
+        REQUIRE(tuning.getSettings(ThreadClass::analysis).niceValue == 0);
+    }
+
+#if JUCE_LINUX
+    SECTION("Threads apply their class's settings and report the result")
+    {
+        // Find a CPU this process may use
+        REQUIRE(tuning.setSettings(ThreadClass::analysis, {}));
+        std::thread([&] { tuning.applyToCurrentThread(ThreadClass::analysis); }).join();
+
+        const auto allowed = tuning.getEffective(ThreadClass::analysis).cpus;
+        const int cpu = allowed.findNextSetBit(0);
+        REQUIRE(cpu >= 0);
+
+        // Raising the nice value needs no privileges
+        Tuning::Settings settings;
+        settings.cpus.setBit(cpu);
+        settings.niceValue = 5;
+        REQUIRE(tuning.setSettings(ThreadClass::analysis, settings));
+
+        bool applied = false;
+        std::thread([&] { applied = tuning.applyToCurrentThread(ThreadClass::analysis); }).join();
+
+        const auto effective = tuning.getEffective(ThreadClass::analysis);
+        REQUIRE(applied);
+        REQUIRE(effective.applied);
+        REQUIRE_FALSE(effective.failed);
+        REQUIRE(effective.cpus.countNumberOfSetBits() == 1);
+        REQUIRE(effective.cpus[cpu]);
+        REQUIRE(effective.niceValue == 5);
+        REQUIRE(effective.fifoPriority == 0);
+    }
+
+    SECTION("Threads only reapply when their own class changes")
+    {
+        Tuning::Settings settings;
+        settings.niceValue = 5;
+        REQUIRE(tuning.setSettings(ThreadClass::analysis, settings));
+
+        bool applied = false;
+        bool moved = false;
+        int niceAfterOtherClassChanged = 0;
+
+        std::thread([&]
+        {
+            applied = tuning.applyToCurrentThread(ThreadClass::analysis);
+
+            // Move the thread away from its settings behind the tuning's back
+            const auto threadId = (id_t)syscall(SYS_gettid);
+            moved = setpriority(PRIO_PROCESS, threadId, 7) == 0;
+
+            tuning.setSettings(ThreadClass::disk, {});
+            tuning.applyToCurrentThread(ThreadClass::analysis);
+            niceAfterOtherClassChanged = getpriority(PRIO_PROCESS, threadId);
+        }).join();
+
+        REQUIRE(applied);
+        REQUIRE(moved);
+        REQUIRE(niceAfterOtherClassChanged == 7);
+    }
+#endif
+
+    tuning.setSettings(ThreadClass::analysis, {});
+}
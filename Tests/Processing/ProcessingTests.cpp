@@ -1,11 +1,21 @@
 #include "../../Source/JuceHeader.h"
+#include "../../Source/Processing/Analysis/AlarmEngine.h"
+#include "../../Source/Processing/Analysis/AnalyzerPipeline.h"
+#include "../../Source/Processing/Analysis/ChannelAnalyzer.h"
+#include "../../Source/Processing/Analysis/LoudnessAnalyzer.h"
+#include "../../Source/Processing/Analysis/OfflineAnalyzer.h"
+#include "../../Source/Processing/Analysis/PolyphaseDecimator.h"
+#include "../../Source/Processing/Analysis/SampleFifo.h"
+#include "../../Source/Processing/Analysis/TruePeakMeter.h"
+#include "../../Source/Processing/Analysis/WaveformPyramid.h"
+#include "../../Source/Processing/Metering/LevelHistory.h"
+#include "../../Source/Processing/Metering/PPMMeterCalculator.h"
+#include "../../Source/Processing/Metering/VUMeterCalculator.h"
 #include "../Utilities/TestUtils.h"
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
-
-// These imports will need to be adjusted as Processing components are
-// implemented #include "../../Source/Processing/Metering/VUMeterCalculator.h"
-// #include "../../Source/Processing/Metering/PPMMeterCalculator.h"
+#include <numeric>
+#include <thread>
 
 // These test cases will be filled in as the processing components are
 // implemented
@@ -24,11 +34,13 @@ TEST_CASE("RMS calculation for VU meter", "[processing][metering]") {
     // Check that calculated RMS matches expected value
     REQUIRE(calculatedRMS == Catch::Approx(expectedRMS).margin(0.001f));
 
-    // Once VUMeterCalculator is implemented:
-    // VUMeterCalculator vuMeter;
-    // vuMeter.processBlock(buffer);
-    // REQUIRE(vuMeter.getMeterLevel() ==
-    // Catch::Approx(expectedRMS).margin(0.001f));
+    // The VU meter averages the rectified signal, scaled so a sine reads
+    // its peak
+    mcam::VUMeterCalculator vuMeter;
+    vuMeter.prepare(44100.0, 1);
+    vuMeter.process(buffer.getArrayOfReadPointers(), 1,
+                    buffer.getNumSamples());
+    REQUIRE(vuMeter.getLevel(0) == Catch::Approx(1.0f).margin(0.001f));
   }
 
   SECTION("RMS calculation of square wave") {
@@ -44,10 +56,13 @@ TEST_CASE("RMS calculation for VU meter", "[processing][metering]") {
     // Check that calculated RMS matches expected value
     REQUIRE(calculatedRMS == Catch::Approx(1.0f).margin(0.001f));
 
-    // Once VUMeterCalculator is implemented:
-    // VUMeterCalculator vuMeter;
-    // vuMeter.processBlock(buffer);
-    // REQUIRE(vuMeter.getMeterLevel() == Catch::Approx(1.0f).margin(0.001f));
+    // A square wave's mean equals its peak, so it reads pi / 2 of it
+    mcam::VUMeterCalculator vuMeter;
+    vuMeter.prepare(44100.0, 1);
+    vuMeter.process(buffer.getArrayOfReadPointers(), 1,
+                    buffer.getNumSamples());
+    REQUIRE(vuMeter.getLevel(0) ==
+            Catch::Approx(juce::MathConstants<float>::halfPi).margin(0.01f));
   }
 }
 
@@ -65,10 +80,11 @@ TEST_CASE("Peak detection for PPM meter", "[processing][metering]") {
     // Check that peak is approximately 1.0
     REQUIRE(peak == Catch::Approx(1.0f).margin(0.001f));
 
-    // Once PPMMeterCalculator is implemented:
-    // PPMMeterCalculator ppmMeter;
-    // ppmMeter.processBlock(buffer);
-    // REQUIRE(ppmMeter.getMeterLevel() == Catch::Approx(1.0f).margin(0.001f));
+    mcam::PPMMeterCalculator ppmMeter;
+    ppmMeter.prepare(44100.0, 1);
+    ppmMeter.process(buffer.getArrayOfReadPointers(), 1,
+                     buffer.getNumSamples());
+    REQUIRE(ppmMeter.getLevel(0) == Catch::Approx(1.0f).margin(0.001f));
   }
 
   SECTION("Peak detection of impulse") {
@@ -84,11 +100,20 @@ TEST_CASE("Peak detection for PPM meter", "[processing][metering]") {
     // Check that peak is 1.0
     REQUIRE(peak == 1.0f);
 
-    // Once PPMMeterCalculator is implemented, test attack time response:
-    // PPMMeterCalculator ppmMeter;
-    // ppmMeter.processBlock(buffer);
-    // float meterLevel = ppmMeter.getMeterLevel();
-    // Test according to PPM specs (should have fast attack)
+    // The 10 ms integration reads a lone sample far below its peak, but
+    // the hold keeps what it did read
+    mcam::PPMMeterCalculator ppmMeter;
+    ppmMeter.prepare(44100.0, 1);
+    ppmMeter.process(buffer.getArrayOfReadPointers(), 1, 1);
+    const float meterLevel = ppmMeter.getLevel(0);
+    REQUIRE(meterLevel > 0.0f);
+    REQUIRE(meterLevel < 0.1f);
+
+    buffer.clear();
+    ppmMeter.process(buffer.getArrayOfReadPointers(), 1,
+                     buffer.getNumSamples());
+    REQUIRE(ppmMeter.getLevel(0) < meterLevel);
+    REQUIRE(ppmMeter.getPeakHold(0) == Catch::Approx(meterLevel));
   }
 }
 
@@ -114,5 +139,1376 @@ TEST_CASE("Crest factor calculations", "[processing][analysis]") {
   }
 }
 
+TEST_CASE("Fused analyzer pipelines", "[processing][analysis]") {
+  using mcam::AnalyzerStage;
+  using mcam::BlockStatistics;
+
+  const auto &registry = mcam::AnalyzerPipelineRegistry::getInstance();
+
+  juce::AudioBuffer<float> buffer(1, 4801);
+  TestUtils::generateSineWave(buffer, 997.0f, 48000.0f, 0.5f);
+  buffer.applyGain(0, 0, 100, 2.5f);
+  buffer.addFrom(0, 0, std::vector<float>(4801, 0.125f).data(), 4801);
+  const float *samples = buffer.getReadPointer(0);
+
+  // Reference statistics of a block, in double precision
+  const auto reference = [&](int start, int numSamples) {
+    double peak = 0.0, sumSquares = 0.0, sum = 0.0;
+    float minimum = numSamples > 0 ? samples[start] : 0.0f;
+    float maximum = minimum;
+    int clipped = 0, run = 0, firstRun = -1, longestRun = 0;
+
+    for (int i = start; i < start + numSamples; ++i) {
+      const double sample = samples[i];
+      peak = juce::jmax(peak, std::abs(sample));
+      minimum = juce::jmin(minimum, samples[i]);
+      maximum = juce::jmax(maximum, samples[i]);
+      sumSquares += sample * sample;
+      sum += sample;
+
+      if (std::abs(samples[i]) >= mcam::ClipCountStage::CLIP_LEVEL) {
+        ++clipped;
+        longestRun = juce::jmax(longestRun, ++run);
+      } else {
+        if (firstRun < 0)
+          firstRun = run;
+        run = 0;
+      }
+    }
+
+    BlockStatistics statistics;
+    statistics.peak = (float)peak;
+    statistics.rms = numSamples > 0 ? (float)std::sqrt(sumSquares / numSamples)
+                                    : 0.0f;
+    statistics.dcOffset = numSamples > 0 ? (float)(sum / numSamples) : 0.0f;
+    statistics.clippedSamples = clipped;
+    statistics.clipRunAtStart = firstRun < 0 ? run : firstRun;
+    statistics.clipRunAtEnd = run;
+    statistics.longestClipRun = longestRun;
+    statistics.minimum = minimum;
+    statistics.maximum = maximum;
+    return statistics;
+  };
+
+  SECTION("Every stage matches its reference at any alignment and length") {
+    for (int start : {0, 1, 2, 3, 10}) {
+      for (int numSamples : {0, 1, 5, 480, 4790}) {
+        const auto expected = reference(start, numSamples);
+        BlockStatistics statistics;
+        registry.find(AnalyzerStage::all)(samples + start, numSamples,
+                                          statistics);
+
+        REQUIRE(statistics.peak == expected.peak);
+        REQUIRE(statistics.rms == Catch::Approx(expected.rms).epsilon(1e-5));
+        REQUIRE(statistics.dcOffset ==
+                Catch::Approx(expected.dcOffset).margin(1e-6));
+        REQUIRE(statistics.clippedSamples == expected.clippedSamples);
+        REQUIRE(statistics.clipRunAtStart == expected.clipRunAtStart);
+        REQUIRE(statistics.clipRunAtEnd == expected.clipRunAtEnd);
+        REQUIRE(statistics.longestClipRun == expected.longestClipRun);
+        REQUIRE(statistics.minimum == expected.minimum);
+        REQUIRE(statistics.maximum == expected.maximum);
+      }
+    }
+
+    // The first 100 samples were driven past full scale in runs, so blocks
+    // starting and ending inside a run are among those checked
+    REQUIRE(reference(0, 4801).longestClipRun > 1);
+    REQUIRE(reference(10, 480).clipRunAtStart > 0);
+    REQUIRE(reference(3, 5).clipRunAtEnd > 0);
+  }
+
+  SECTION("Each combination runs exactly its own stages") {
+    BlockStatistics all;
+    registry.find(AnalyzerStage::all)(samples, 4801, all);
+
+    for (int stages = 0; stages <= AnalyzerStage::all; ++stages) {
+      BlockStatistics statistics;
+      statistics.peak = statistics.rms = statistics.dcOffset = -1.0f;
+      statistics.clippedSamples = statistics.longestClipRun = -1;
+      statistics.minimum = statistics.maximum = -2.0f;
+      registry.find(stages)(samples, 4801, statistics);
+
+      const auto has = [&](int stage) { return (stages & stage) != 0; };
+      REQUIRE(statistics.peak == (has(AnalyzerStage::peak) ? all.peak : -1.0f));
+      REQUIRE(statistics.rms == (has(AnalyzerStage::rms) ? all.rms : -1.0f));
+      REQUIRE(statistics.dcOffset ==
+              (has(AnalyzerStage::dcOffset) ? all.dcOffset : -1.0f));
+      REQUIRE(statistics.clippedSamples ==
+              (has(AnalyzerStage::clipCount) ? all.clippedSamples : -1));
+      REQUIRE(statistics.longestClipRun ==
+              (has(AnalyzerStage::clipCount) ? all.longestClipRun : -1));
+      REQUIRE(statistics.minimum ==
+              (has(AnalyzerStage::minimum) ? all.minimum : -2.0f));
+      REQUIRE(statistics.maximum ==
+              (has(AnalyzerStage::maximum) ? all.maximum : -2.0f));
+    }
+  }
+
+  SECTION("A pipeline composed at compile time is the registered one") {
+    using Levels = mcam::AnalyzerPipeline<mcam::PeakStage, mcam::RmsStage>;
+    static_assert(Levels::STAGES == (AnalyzerStage::peak | AnalyzerStage::rms),
+                  "Stage bits combine");
+    static_assert(Levels::NEEDS ==
+                      (mcam::Prefilter::magnitude | mcam::Prefilter::square),
+                  "Prefilters are shared");
+
+    REQUIRE(registry.find(Levels::STAGES) == &Levels::process);
+    REQUIRE(registry.find(-1) == registry.find(AnalyzerStage::all));
+  }
+}
+
+TEST_CASE("Alarm engine", "[processing][alarms]") {
+  using mcam::AlarmEngine;
+  using Type = AlarmEngine::Type;
+
+  constexpr double sampleRate = 48000.0;
+  constexpr int blockSize = 480;
+
+  // Four channels, each filled per sample by its own signal
+  juce::AudioBuffer<float> buffer(4, blockSize);
+  juce::int64 position = 0;
+
+  auto run = [&](AlarmEngine &engine, double seconds, auto signal) {
+    const int numBlocks = juce::roundToInt(seconds * sampleRate / blockSize);
+
+    for (int block = 0; block < numBlocks; ++block) {
+      for (int channel = 0; channel < 4; ++channel)
+        for (int sample = 0; sample < blockSize; ++sample)
+          buffer.setSample(channel, sample,
+                           signal(channel, (double)(position + sample) /
+                                               sampleRate));
+
+      engine.process(buffer.getArrayOfReadPointers(), 4, blockSize);
+      position += blockSize;
+    }
+  };
+
+  auto tone = [](double time, double frequency) {
+    return 0.5f * (float)std::sin(juce::MathConstants<double>::twoPi *
+                                  frequency * time);
+  };
+
+  // A different tone on each channel raises nothing
+  auto healthy = [&](int channel, double time) {
+    return tone(time, 300.0 + 200.0 * channel);
+  };
+
+  SECTION("Settings need hysteresis and non-negative times") {
+    AlarmEngine engine(4);
+    auto settings = AlarmEngine::getDefaultSettings(Type::silence);
+    REQUIRE(engine.getSettings(Type::silence).raiseLevel ==
+            settings.raiseLevel);
+
+    settings.clearLevel = settings.raiseLevel;
+    REQUIRE_FALSE(engine.setSettings(Type::silence, settings));
+
+    settings = AlarmEngine::getDefaultSettings(Type::clipping);
+    settings.clearLevel = settings.raiseLevel + 1.0f;
+    REQUIRE_FALSE(engine.setSettings(Type::clipping, settings));
+
+    settings = AlarmEngine::getDefaultSettings(Type::dcOffset);
+    settings.raiseSeconds = -1.0f;
+    REQUIRE_FALSE(engine.setSettings(Type::dcOffset, settings));
+
+    settings.raiseSeconds = 0.5f;
+    REQUIRE(engine.setSettings(Type::dcOffset, settings));
+    REQUIRE(engine.getSettings(Type::dcOffset).raiseSeconds == 0.5f);
+  }
+
+  SECTION("Faults raise after their hold time and clear past hysteresis") {
+    AlarmEngine engine(4);
+    engine.prepare(sampleRate);
+
+    // 0: silent, 1: clipped, 2: DC offset, 3: stuck at a constant value
+    auto faulty = [&](int channel, double time) {
+      switch (channel) {
+      case 0:
+        return 0.0f;
+      case 1:
+        return juce::jlimit(-1.0f, 1.0f, 4.0f * tone(time, 500.0));
+      case 2:
+        return 0.1f + tone(time, 700.0);
+      default:
+        return 0.25f;
+      }
+    };
+
+    run(engine, 1.0, faulty);
+    REQUIRE(engine.isActive(1, Type::clipping));
+    REQUIRE(engine.isActive(3, Type::stuck));
+    REQUIRE_FALSE(engine.isActive(0, Type::silence));
+    REQUIRE_FALSE(engine.isActive(0, Type::stuck));
+
+    run(engine, 10.0, faulty);
+    REQUIRE(engine.isActive(0, Type::silence));
+    REQUIRE(engine.isActive(2, Type::dcOffset));
+    REQUIRE_FALSE(engine.isActive(1, Type::silence));
+
+    // A constant 0.25 is also a DC offset
+    REQUIRE(engine.getNumActive() == 5);
+
+    // Each clears once its value has been past the clear level long
+    // enough; the smoothed DC offset takes longest
+    run(engine, 1.0, healthy);
+    REQUIRE_FALSE(engine.isActive(0, Type::silence));
+    REQUIRE(engine.isActive(1, Type::clipping));
+
+    run(engine, 8.0, healthy);
+    REQUIRE(engine.getNumActive() == 0);
+  }
+
+  SECTION("Clipping is a run of full-scale samples, across blocks") {
+    AlarmEngine engine(4);
+    engine.prepare(sampleRate);
+
+    // Every other sample at full scale never clips for three in a row
+    auto alternate = [&](int channel, double time) {
+      const auto sample = std::llround(time * sampleRate);
+      return channel == 0 && sample % 2 == 0 ? 1.0f : healthy(channel, time);
+    };
+
+    run(engine, 0.1, alternate);
+    REQUIRE(engine.getStatistics(0).clippedSamples > 3);
+    REQUIRE_FALSE(engine.isActive(0, Type::clipping));
+
+    // Two full-scale samples end one block and one starts the next
+    auto straddle = [&](int channel, double time) {
+      const auto sample = std::llround(time * sampleRate) % blockSize;
+      const bool atEdge = sample == 0 || sample >= blockSize - 2;
+      return channel == 0 && atEdge ? -1.0f : healthy(channel, time);
+    };
+
+    run(engine, 1.0 * blockSize / sampleRate, straddle);
+    REQUIRE(engine.getStatistics(0).longestClipRun == 2);
+    REQUIRE_FALSE(engine.isActive(0, Type::clipping));
+
+    run(engine, 1.0 * blockSize / sampleRate, straddle);
+    REQUIRE(engine.getStatistics(0).clipRunAtStart == 1);
+    REQUIRE(engine.isActive(0, Type::clipping));
+  }
+
+  SECTION("Pairs in opposite polarity raise phase inversion") {
+    AlarmEngine engine(4);
+    engine.prepare(sampleRate);
+
+    // Channels 0/1 inverted, 2/3 identical
+    auto inverted = [&](int channel, double time) {
+      const float sample = tone(time, 1000.0);
+      return channel == 1 ? -sample : sample;
+    };
+
+    run(engine, 4.0, inverted);
+    REQUIRE(engine.isActive(0, Type::phaseInversion));
+    REQUIRE_FALSE(engine.isActive(2, Type::phaseInversion));
+    REQUIRE(engine.getNumActive() == 1);
+
+    // Silence on one side says nothing about the phase
+    auto oneSided = [&](int channel, double time) {
+      return channel == 1 ? 0.0f : tone(time, 1000.0);
+    };
+
+    run(engine, 6.0, oneSided);
+    REQUIRE_FALSE(engine.isActive(0, Type::phaseInversion));
+  }
+
+  SECTION("Readers get every change in order with their own cursors") {
+    AlarmEngine engine(4);
+    engine.prepare(sampleRate);
+
+    auto clipped = [&](int channel, double time) {
+      return channel == 2 ? juce::jlimit(-1.0f, 1.0f, 4.0f * tone(time, 500.0))
+                          : healthy(channel, time);
+    };
+
+    run(engine, 0.1, clipped);
+    REQUIRE(engine.getNumEvents() == 1);
+
+    // A disabled alarm clears at once
+    auto settings = engine.getSettings(Type::clipping);
+    settings.enabled = false;
+    REQUIRE(engine.setSettings(Type::clipping, settings));
+    run(engine, 0.01, clipped);
+    REQUIRE_FALSE(engine.isActive(2, Type::clipping));
+
+    std::array<AlarmEngine::Event, 4> events;
+    juce::int64 logCursor = 0, uiCursor = 0;
+
+    REQUIRE(engine.readEvents(logCursor, events.data(), 4) == 2);
+    REQUIRE(events[0].type == Type::clipping);
+    REQUIRE(events[0].channel == 2);
+    REQUIRE(events[0].raised);
+    REQUIRE(events[0].value >= 3.0f);
+    REQUIRE(events[0].samplePosition == blockSize);
+    REQUIRE_FALSE(events[1].raised);
+    REQUIRE(logCursor == 2);
+    REQUIRE(engine.readEvents(logCursor, events.data(), 4) == 0);
+
+    // Another reader still sees them, a few at a time
+    REQUIRE(engine.readEvents(uiCursor, events.data(), 1) == 1);
+    REQUIRE(events[0].raised);
+    REQUIRE(engine.readEvents(uiCursor, events.data(), 1) == 1);
+    REQUIRE_FALSE(events[0].raised);
+  }
+
+  SECTION("A reader that falls behind skips the oldest events") {
+    AlarmEngine engine(4);
+    engine.prepare(sampleRate);
+
+    auto settings = engine.getSettings(Type::clipping);
+    settings.clearSeconds = 0.0f;
+    REQUIRE(engine.setSettings(Type::clipping, settings));
+
+    // Clipping on channel 0 that comes and goes every block
+    const int numBlocks = AlarmEngine::EVENT_QUEUE_SIZE + 100;
+    run(engine, numBlocks * blockSize / sampleRate,
+        [&](int channel, double time) {
+          const auto sample = (juce::int64)std::llround(time * sampleRate);
+          const float level = sample / blockSize % 2 == 0 ? 1.0f : 0.5f;
+
+          if (channel != 0)
+            return healthy(channel, time);
+
+          return sample % 2 == 0 ? level : -level;
+        });
+
+    std::vector<AlarmEngine::Event> events(
+        (size_t)AlarmEngine::EVENT_QUEUE_SIZE * 2);
+    juce::int64 cursor = 0;
+    REQUIRE(engine.readEvents(cursor, events.data(), (int)events.size()) ==
+            AlarmEngine::EVENT_QUEUE_SIZE);
+    REQUIRE(cursor == engine.getNumEvents());
+
+    // The oldest kept event is followed by the rest in order
+    for (int i = 1; i < AlarmEngine::EVENT_QUEUE_SIZE; ++i)
+      REQUIRE(events[(size_t)i].raised != events[(size_t)i - 1].raised);
+  }
+}
+
+TEST_CASE("Channel analyzer summaries", "[processing][analysis]") {
+  constexpr double sampleRate = 48000.0;
+
+  // 5 s of a 1 kHz sine at -20 dBFS peak
+  juce::AudioBuffer<float> buffer(1, (int)sampleRate * 5);
+  TestUtils::generateSineWave(buffer, 1000.0f, (float)sampleRate, 0.1f);
+
+  SECTION("Level, loudness and spectrum of a sine") {
+    mcam::ChannelAnalyzer analyzer;
+    analyzer.prepare(sampleRate);
+    analyzer.process(buffer.getReadPointer(0), buffer.getNumSamples());
+
+    const auto summary = analyzer.getSummary();
+    REQUIRE(summary.numSamples == buffer.getNumSamples());
+    REQUIRE(summary.peak == Catch::Approx(0.1).margin(1.0e-4));
+    REQUIRE(summary.rms == Catch::Approx(0.1 / std::sqrt(2.0)).margin(1.0e-4));
+
+    // BS.1770: a 0 dBFS 1 kHz sine reads -3.01 LUFS
+    REQUIRE(summary.integratedLoudness == Catch::Approx(-23.01).margin(0.1));
+
+    REQUIRE(summary.spectralCentroid == Catch::Approx(1000.0).margin(50.0));
+    REQUIRE(summary.octaveBandLevels[5] == Catch::Approx(-20.0).margin(0.5));
+    REQUIRE(summary.octaveBandLevels[0] < -100.0);
+  }
+
+  SECTION("Results do not depend on block size") {
+    mcam::ChannelAnalyzer small, large;
+    small.prepare(sampleRate);
+    large.prepare(sampleRate);
+
+    for (int i = 0; i < buffer.getNumSamples(); i += 32)
+      small.process(buffer.getReadPointer(0, i),
+                    juce::jmin(32, buffer.getNumSamples() - i));
+    for (int i = 0; i < buffer.getNumSamples(); i += 4096)
+      large.process(buffer.getReadPointer(0, i),
+                    juce::jmin(4096, buffer.getNumSamples() - i));
+
+    const auto a = small.getSummary();
+    const auto b = large.getSummary();
+    REQUIRE(a.peak == b.peak);
+    REQUIRE(a.rms == b.rms);
+    REQUIRE(a.integratedLoudness == b.integratedLoudness);
+    REQUIRE(a.octaveBandLevels == b.octaveBandLevels);
+  }
+
+  SECTION("Silence is gated out") {
+    buffer.clear();
+
+    mcam::ChannelAnalyzer analyzer;
+    analyzer.prepare(sampleRate);
+    analyzer.process(buffer.getReadPointer(0), buffer.getNumSamples());
+
+    REQUIRE(std::isinf(analyzer.getSummary().integratedLoudness));
+  }
+}
+
+TEST_CASE("Polyphase decimation", "[processing][analysis]") {
+  using mcam::PolyphaseDecimator;
+
+  // Level in dB of the second half of the output, relative to the input
+  const auto decimatedLevel = [](double sampleRate, float frequency) {
+    juce::AudioBuffer<float> buffer(1, (int)sampleRate);
+    TestUtils::generateSineWave(buffer, frequency, (float)sampleRate, 0.5f);
+
+    PolyphaseDecimator decimator;
+    decimator.prepare(sampleRate,
+                      PolyphaseDecimator::getFactorForSampleRate(sampleRate));
+
+    std::vector<float> output(
+        (size_t)decimator.getMaxOutputSamples(buffer.getNumSamples()));
+    const int count = decimator.process(
+        buffer.getReadPointer(0), buffer.getNumSamples(), output.data());
+
+    double sum = 0.0;
+    for (int i = count / 2; i < count; ++i)
+      sum += (double)output[(size_t)i] * output[(size_t)i];
+
+    return juce::Decibels::gainToDecibels(
+        std::sqrt(sum / (count - count / 2)) / (0.5 / std::sqrt(2.0)), -300.0);
+  };
+
+  SECTION("Factor brings the rate down to 44.1 or 48 kHz") {
+    REQUIRE(PolyphaseDecimator::getFactorForSampleRate(44100.0) == 1);
+    REQUIRE(PolyphaseDecimator::getFactorForSampleRate(48000.0) == 1);
+    REQUIRE(PolyphaseDecimator::getFactorForSampleRate(88200.0) == 2);
+    REQUIRE(PolyphaseDecimator::getFactorForSampleRate(96000.0) == 2);
+    REQUIRE(PolyphaseDecimator::getFactorForSampleRate(176400.0) == 4);
+    REQUIRE(PolyphaseDecimator::getFactorForSampleRate(192000.0) == 4);
+  }
+
+  SECTION("The audio band passes unchanged") {
+    for (double sampleRate : {88200.0, 96000.0, 192000.0})
+      for (float frequency : {100.0f, 1000.0f, 10000.0f, 19000.0f})
+        REQUIRE(decimatedLevel(sampleRate, frequency) ==
+                Catch::Approx(0.0).margin(0.01));
+  }
+
+  SECTION("Nothing aliases into the audio band") {
+    // Each of these would fold to below 20 kHz
+    REQUIRE(decimatedLevel(96000.0, 30000.0f) < -85.0);
+    REQUIRE(decimatedLevel(88200.0, 26000.0f) < -85.0);
+    REQUIRE(decimatedLevel(192000.0, 30000.0f) < -85.0);
+    REQUIRE(decimatedLevel(192000.0, 80000.0f) < -85.0);
+  }
+
+  SECTION("Output does not depend on block size") {
+    constexpr double sampleRate = 192000.0;
+    juce::AudioBuffer<float> buffer(1, (int)sampleRate / 4);
+    TestUtils::generateSineWave(buffer, 3000.0f, (float)sampleRate, 0.5f);
+
+    const auto decimateInBlocks = [&](int blockSize) {
+      PolyphaseDecimator decimator;
+      decimator.prepare(sampleRate, 4);
+
+      std::vector<float> output(
+          (size_t)decimator.getMaxOutputSamples(buffer.getNumSamples()));
+      int count = 0;
+
+      for (int i = 0; i < buffer.getNumSamples(); i += blockSize)
+        count += decimator.process(
+            buffer.getReadPointer(0, i),
+            juce::jmin(blockSize, buffer.getNumSamples() - i),
+            output.data() + count);
+
+      output.resize((size_t)count);
+      return output;
+    };
+
+    const auto reference = decimateInBlocks(buffer.getNumSamples());
+    REQUIRE(reference.size() == (size_t)buffer.getNumSamples() / 4);
+    REQUIRE(decimateInBlocks(1) == reference);
+    REQUIRE(decimateInBlocks(37) == reference);
+    REQUIRE(decimateInBlocks(4096) == reference);
+  }
+
+  SECTION("Decimated analysis matches full-rate analysis") {
+    for (double sampleRate : {96000.0, 192000.0}) {
+      juce::AudioBuffer<float> buffer(1, (int)sampleRate * 5);
+      TestUtils::generateSineWave(buffer, 1000.0f, (float)sampleRate, 0.1f);
+
+      mcam::ChannelAnalyzer decimated, fullRate;
+      decimated.prepare(sampleRate);
+      fullRate.prepare(sampleRate, false);
+      REQUIRE(decimated.getAnalysisSampleRate() == 48000.0);
+      REQUIRE(fullRate.getAnalysisSampleRate() == sampleRate);
+
+      decimated.process(buffer.getReadPointer(0), buffer.getNumSamples());
+      fullRate.process(buffer.getReadPointer(0), buffer.getNumSamples());
+
+      const auto a = decimated.getSummary();
+      const auto b = fullRate.getSummary();
+      REQUIRE(a.numSamples == b.numSamples);
+      REQUIRE(a.peak == b.peak);
+      REQUIRE(a.rms == b.rms);
+      REQUIRE(a.integratedLoudness == Catch::Approx(-23.01).margin(0.1));
+      REQUIRE(a.integratedLoudness ==
+              Catch::Approx(b.integratedLoudness).margin(0.01));
+      REQUIRE(a.spectralCentroid == Catch::Approx(1000.0).margin(50.0));
+      REQUIRE(a.octaveBandLevels[5] ==
+              Catch::Approx(b.octaveBandLevels[5]).margin(0.1));
+    }
+  }
+}
+
+TEST_CASE("EBU R128 loudness", "[processing][loudness]") {
+  using mcam::LoudnessAnalyzer;
+  using mcam::LoudnessMeter;
+
+  constexpr double sampleRate = 48000.0;
+
+  // One part of a test signal: a 1 kHz sine at a level in dBFS
+  struct Segment {
+    double dbfs;
+    double seconds;
+  };
+
+  // Plays segments on every channel of a group, with a level offset per
+  // channel, and returns the group's readings at the end
+  const auto measure = [&](const std::vector<Segment> &segments,
+                           const std::vector<double> &channelOffsets,
+                           int blockSize, double rate = sampleRate) {
+    const int numChannels = (int)channelOffsets.size();
+
+    LoudnessAnalyzer analyzer(1);
+    analyzer.prepare(rate);
+
+    std::vector<int> channels;
+    for (int ch = 0; ch < numChannels; ++ch)
+      channels.push_back(ch);
+    REQUIRE(analyzer.setGroup(0, channels));
+
+    juce::AudioBuffer<float> block(numChannels, blockSize);
+    const float *slotSources[1] = {nullptr};
+    juce::int64 position = 0;
+
+    for (const auto &segment : segments) {
+      const auto length = (juce::int64)std::llround(segment.seconds * rate);
+
+      for (juce::int64 done = 0; done < length;) {
+        const int count =
+            (int)juce::jmin((juce::int64)blockSize, length - done);
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+          const double amplitude = juce::Decibels::decibelsToGain(
+              segment.dbfs + channelOffsets[(size_t)ch], -300.0);
+          auto *data = block.getWritePointer(ch);
+
+          for (int i = 0; i < count; ++i)
+            data[i] = (float)(amplitude *
+                              std::sin(juce::MathConstants<double>::twoPi *
+                                       1000.0 * (double)(position + i) /
+                                       rate));
+        }
+
+        analyzer.process(slotSources, block.getArrayOfReadPointers(),
+                         numChannels, count);
+        position += count;
+        done += count;
+      }
+    }
+
+    return analyzer.getGroupReading(0);
+  };
+
+  const std::vector<double> stereo{0.0, 0.0};
+
+  // EBU Tech 3341 minimum requirements: +/-0.1 LU
+  SECTION("Tech 3341 cases 1 and 2: steady stereo sines") {
+    for (double level : {-23.0, -33.0}) {
+      const auto reading = measure({{level, 20.0}}, stereo, 512);
+      REQUIRE(reading.momentary == Catch::Approx(level).margin(0.1));
+      REQUIRE(reading.shortTerm == Catch::Approx(level).margin(0.1));
+      REQUIRE(reading.integrated == Catch::Approx(level).margin(0.1));
+    }
+  }
+
+  SECTION("Tech 3341 cases 3 to 5: gating") {
+    REQUIRE(measure({{-36.0, 10.0}, {-23.0, 60.0}, {-36.0, 10.0}}, stereo,
+                    512)
+                .integrated == Catch::Approx(-23.0).margin(0.1));
+    REQUIRE(measure({{-72.0, 10.0},
+                     {-36.0, 10.0},
+                     {-23.0, 60.0},
+                     {-36.0, 10.0},
+                     {-72.0, 10.0}},
+                    stereo, 511)
+                .integrated == Catch::Approx(-23.0).margin(0.1));
+    REQUIRE(measure({{-26.0, 20.0}, {-20.0, 20.1}, {-26.0, 20.0}}, stereo, 32)
+                .integrated == Catch::Approx(-23.0).margin(0.1));
+  }
+
+  SECTION("Tech 3341 case 6: 5.0 channel weighting") {
+    // L, R, C, (no LFE), Ls, Rs
+    const auto reading =
+        measure({{0.0, 20.0}}, {-28.0, -28.0, -24.0, -300.0, -30.0, -30.0},
+                1000);
+    REQUIRE(reading.integrated == Catch::Approx(-23.0).margin(0.1));
+  }
+
+  SECTION("Tech 3341 case 9: short-term of a 3 s periodic signal") {
+    std::vector<Segment> segments;
+
+    for (int i = 0; i < 20; ++i) {
+      segments.push_back({-20.0, 1.34});
+      segments.push_back({-30.0, 1.66});
+    }
+
+    REQUIRE(measure(segments, stereo, 256).shortTerm ==
+            Catch::Approx(-23.0).margin(0.1));
+  }
+
+  // EBU Tech 3342 minimum requirements: +/-1 LU
+  SECTION("Tech 3342 cases 1 to 4: loudness range") {
+    REQUIRE(measure({{-20.0, 20.0}, {-30.0, 20.0}}, stereo, 2048)
+                .loudnessRange == Catch::Approx(10.0).margin(1.0));
+    REQUIRE(measure({{-20.0, 20.0}, {-15.0, 20.0}}, stereo, 2048)
+                .loudnessRange == Catch::Approx(5.0).margin(1.0));
+    REQUIRE(measure({{-40.0, 20.0}, {-20.0, 20.0}}, stereo, 2048)
+                .loudnessRange == Catch::Approx(20.0).margin(1.0));
+    REQUIRE(measure({{-50.0, 20.0},
+                     {-35.0, 20.0},
+                     {-20.0, 20.0},
+                     {-35.0, 20.0},
+                     {-50.0, 20.0}},
+                    stereo, 2048)
+                .loudnessRange == Catch::Approx(15.0).margin(1.0));
+  }
+
+  SECTION("Gating histogram") {
+    mcam::LoudnessHistogram histogram;
+
+    // Blocks at the absolute gate are not kept
+    histogram.add(0.0);
+    histogram.add(std::pow(10.0, (-75.0 + 0.691) / 10.0));
+    REQUIRE(histogram.getNumBlocks() == 0);
+    REQUIRE(histogram.getGatedMeanPower(-10.0) == 0.0);
+
+    // 1000 blocks at -20 LUFS and 10 at -40 LUFS; the quiet ones fall
+    // below the relative gate but count towards it
+    const double loud = std::pow(10.0, (-20.0 + 0.691) / 10.0);
+    const double quiet = std::pow(10.0, (-40.0 + 0.691) / 10.0);
+
+    for (int i = 0; i < 1000; ++i)
+      histogram.add(loud);
+    for (int i = 0; i < 10; ++i)
+      histogram.add(quiet);
+
+    REQUIRE(histogram.getNumBlocks() == 1010);
+    REQUIRE(LoudnessMeter::powerToLufs(histogram.getGatedMeanPower(-10.0)) ==
+            Catch::Approx(-20.0).margin(0.001));
+    REQUIRE(histogram.getGatedPercentile(-30.0, 0.0) ==
+            Catch::Approx(-40.0).margin(mcam::LoudnessHistogram::BIN_WIDTH_LU));
+    REQUIRE(histogram.getGatedPercentile(-30.0, 0.5) ==
+            Catch::Approx(-20.0).margin(mcam::LoudnessHistogram::BIN_WIDTH_LU));
+  }
+
+  SECTION("BS.1770 channel weights") {
+    REQUIRE(LoudnessAnalyzer::getChannelWeights(2) ==
+            std::vector<float>{1.0f, 1.0f});
+    REQUIRE(LoudnessAnalyzer::getChannelWeights(6) ==
+            std::vector<float>{1.0f, 1.0f, 1.0f, 0.0f, 1.41f, 1.41f});
+    REQUIRE(LoudnessAnalyzer::getChannelWeights(8)[3] == 0.0f);
+  }
+
+  SECTION("Slots are measured alongside groups") {
+    LoudnessAnalyzer analyzer(2);
+    analyzer.prepare(sampleRate);
+
+    juce::AudioBuffer<float> block(1, 480);
+    const float *slotSources[2] = {block.getReadPointer(0), nullptr};
+
+    for (int i = 0; i < 100; ++i) {
+      TestUtils::generateSineWave(block, 1000.0f, (float)sampleRate,
+                                  (float)juce::Decibels::decibelsToGain(-20.0));
+      analyzer.process(slotSources, slotSources, 1, block.getNumSamples());
+    }
+
+    // A mono -20 dBFS sine is 3 LU below the same sine in stereo
+    REQUIRE(analyzer.getSlotReading(0).momentary ==
+            Catch::Approx(-23.0).margin(0.1));
+    REQUIRE(std::isinf(analyzer.getSlotReading(1).momentary));
+
+    analyzer.resetSlot(0);
+    REQUIRE(std::isinf(analyzer.getSlotReading(0).integrated));
+  }
+
+  SECTION("High rates are measured on the decimated stream") {
+    for (double rate : {88200.0, 96000.0, 192000.0}) {
+      LoudnessAnalyzer analyzer(1);
+      analyzer.prepare(rate);
+      REQUIRE(analyzer.getAnalysisRate() <= 48000.0);
+
+      analyzer.prepare(rate, false);
+      REQUIRE(analyzer.getAnalysisRate() == rate);
+
+      // Block sizes that are not multiples of the decimation factor
+      for (int blockSize : {37, 4101}) {
+        const auto reading = measure({{-23.0, 5.0}}, stereo, blockSize, rate);
+        REQUIRE(reading.momentary == Catch::Approx(-23.0).margin(0.1));
+        REQUIRE(reading.integrated == Catch::Approx(-23.0).margin(0.1));
+      }
+    }
+  }
+}
+
+TEST_CASE("BS.1770 true peak", "[processing][truepeak]") {
+  using mcam::TruePeakMeter;
+
+  constexpr double sampleRate = 48000.0;
+
+  // Plays a sine of a period in samples and a phase in degrees at -6 dBFS
+  // and returns the largest reading, skipping the interpolator's warm-up
+  const auto measureSine = [&](double period, double phaseDegrees,
+                               int blockSize) {
+    TruePeakMeter meter;
+    meter.prepare(sampleRate, 1);
+
+    const double amplitude = juce::Decibels::decibelsToGain(-6.0);
+    const double phase = juce::degreesToRadians(phaseDegrees);
+    std::vector<float> block((size_t)blockSize);
+    const float *inputs[1] = {block.data()};
+    float truePeak = 0.0f, samplePeak = 0.0f;
+    int position = 0;
+
+    while (position < 4800) {
+      for (int i = 0; i < blockSize; ++i)
+        block[(size_t)i] = (float)(amplitude *
+                                   std::sin(juce::MathConstants<double>::twoPi *
+                                                (position + i) / period +
+                                            phase));
+
+      meter.process(inputs, 1, blockSize);
+      position += blockSize;
+
+      if (position > 64) {
+        truePeak = juce::jmax(truePeak, meter.getPeak(0));
+
+        for (float sample : block)
+          samplePeak = juce::jmax(samplePeak, std::abs(sample));
+      }
+    }
+
+    return std::make_pair(juce::Decibels::gainToDecibels(truePeak),
+                          juce::Decibels::gainToDecibels(samplePeak));
+  };
+
+  SECTION("Oversampling factor follows the sample rate") {
+    REQUIRE(TruePeakMeter::getOversamplingFactor(44100.0) == 4);
+    REQUIRE(TruePeakMeter::getOversamplingFactor(48000.0) == 4);
+    REQUIRE(TruePeakMeter::getOversamplingFactor(96000.0) == 2);
+    REQUIRE(TruePeakMeter::getOversamplingFactor(192000.0) == 1);
+  }
+
+  SECTION("Inter-sample peaks of the Tech 3341 signals") {
+    // Sines whose samples straddle the crests, within +0.2/-0.4 dB
+    const std::array<std::pair<double, double>, 3> signals = {
+        {{4.0, 45.0}, {6.0, 60.0}, {8.0, 67.5}}};
+
+    for (const auto &signal : signals) {
+      const auto [truePeak, samplePeak] =
+          measureSine(signal.first, signal.second, 256);
+      REQUIRE(truePeak <= -6.0f + 0.2f);
+      REQUIRE(truePeak >= -6.0f - 0.4f);
+      REQUIRE(samplePeak < truePeak - 0.5f);
+    }
+
+    // fs/4 at 45 degrees: every sample is 3 dB below the crest
+    REQUIRE(measureSine(4.0, 45.0, 256).second ==
+            Catch::Approx(-9.0).margin(0.05));
+  }
+
+  SECTION("Readings do not depend on the block size") {
+    juce::Random random(42);
+    std::vector<float> noise(9600);
+    for (auto &sample : noise)
+      sample = random.nextFloat() * 2.0f - 1.0f;
+
+    const auto runPeak = [&](int blockSize) {
+      TruePeakMeter meter;
+      meter.prepare(sampleRate, 2);
+      float peak = 0.0f;
+
+      for (int pos = 0; pos < (int)noise.size(); pos += blockSize) {
+        const float *inputs[2] = {noise.data() + pos, nullptr};
+        meter.process(inputs, 2, blockSize);
+        peak = juce::jmax(peak, meter.getPeak(0));
+        REQUIRE(meter.getPeak(1) == 0.0f);
+      }
+
+      return peak;
+    };
+
+    REQUIRE(runPeak(32) == runPeak(2400));
+    REQUIRE(measureSine(6.0, 60.0, 37).first ==
+            Catch::Approx(measureSine(6.0, 60.0, 1000).first).margin(0.001));
+  }
+
+  SECTION("Channels are measured independently and reset alone") {
+    TruePeakMeter meter;
+    meter.prepare(sampleRate, 6);
+    REQUIRE(meter.getNumChannels() == 6);
+
+    std::vector<float> loud(64, 0.5f), quiet(64, 0.25f);
+    const float *inputs[6] = {loud.data(),  quiet.data(), nullptr,
+                              loud.data(),  quiet.data(), loud.data()};
+
+    // The second block is past the step from silence and its ringing
+    meter.process(inputs, 6, 64);
+    meter.process(inputs, 6, 64);
+    REQUIRE(meter.getPeak(0) == Catch::Approx(0.5f).margin(0.01f));
+    REQUIRE(meter.getPeak(1) == Catch::Approx(0.25f).margin(0.01f));
+    REQUIRE(meter.getPeak(2) == 0.0f);
+    REQUIRE(meter.getPeak(5) == Catch::Approx(0.5f).margin(0.01f));
+    REQUIRE(meter.getPeak(6) == 0.0f);
+
+    // A reset channel's history is silence again; the others keep theirs
+    meter.resetChannel(0);
+    const float *silent[6] = {};
+    meter.process(silent, 6, 2);
+    REQUIRE(meter.getPeak(0) == 0.0f);
+    REQUIRE(meter.getPeak(3) > 0.0f);
+  }
+}
+
+TEST_CASE("VU ballistics", "[processing][metering]") {
+  using mcam::VUMeterCalculator;
+
+  constexpr double sampleRate = 48000.0;
+
+  // Plays a signal from rest in blocks and returns the final reading
+  const auto play = [&](VUMeterCalculator &meter,
+                        const std::vector<float> &signal, int blockSize) {
+    for (int pos = 0; pos < (int)signal.size(); pos += blockSize) {
+      const float *inputs[1] = {signal.data() + pos};
+      meter.process(inputs, 1,
+                    juce::jmin(blockSize, (int)signal.size() - pos));
+    }
+
+    return meter.getLevel(0);
+  };
+
+  SECTION("A -20 dBFS sine reads 0 VU") {
+    const float amplitude = juce::Decibels::decibelsToGain(-20.0f);
+    std::vector<float> sine((size_t)sampleRate * 2);
+    for (size_t i = 0; i < sine.size(); ++i)
+      sine[i] = amplitude * (float)std::sin(juce::MathConstants<double>::twoPi *
+                                            1000.0 * (double)i / sampleRate);
+
+    VUMeterCalculator meter;
+    meter.prepare(sampleRate, 1);
+    const float level = play(meter, sine, 480);
+    REQUIRE(VUMeterCalculator::gainToVU(level) ==
+            Catch::Approx(0.0f).margin(0.1f));
+  }
+
+  SECTION("A step reaches 99% in 300 ms and overshoots by 1 to 1.5%") {
+    const auto steps = (size_t)(VUMeterCalculator::INTEGRATION_SECONDS *
+                                sampleRate);
+    std::vector<float> step(steps, 1.0f);
+    const float finalReading = juce::MathConstants<float>::halfPi;
+
+    VUMeterCalculator meter;
+    meter.prepare(sampleRate, 1);
+    REQUIRE(play(meter, step, 256) / finalReading ==
+            Catch::Approx(0.99f).margin(0.005f));
+
+    // IEC 60268-17: the needle swings past the final value once, then
+    // settles on it
+    float highest = 0.0f;
+    for (int block = 0; block < 200; ++block)
+      highest = juce::jmax(
+          highest, play(meter, std::vector<float>(48, 1.0f), 48));
+
+    REQUIRE(highest / finalReading ==
+            Catch::Approx(1.0 + VUMeterCalculator::OVERSHOOT).margin(0.001));
+    REQUIRE(highest / finalReading >= 1.01f);
+    REQUIRE(highest / finalReading <= 1.015f);
+
+    play(meter, std::vector<float>((size_t)sampleRate, 1.0f), 480);
+    REQUIRE(meter.getLevel(0) / finalReading ==
+            Catch::Approx(1.0f).margin(0.0005f));
+  }
+
+  SECTION("Readings do not depend on the block size") {
+    std::vector<float> signal(24000);
+    for (size_t i = 0; i < signal.size(); ++i)
+      signal[i] = (float)std::sin(0.01 * (double)i) *
+                  (i % 7000 < 3500 ? 0.8f : 0.1f);
+
+    const auto run = [&](int blockSize) {
+      VUMeterCalculator meter;
+      meter.prepare(sampleRate, 1);
+      return play(meter, signal, blockSize);
+    };
+
+    const float reference = run(480);
+    REQUIRE(run(32) == Catch::Approx(reference).epsilon(1.0e-4));
+    REQUIRE(run(5000) == Catch::Approx(reference).epsilon(1.0e-4));
+  }
+
+  SECTION("Missing inputs decay and channels reset alone") {
+    std::vector<float> ones(4800, 1.0f);
+    const float *inputs[2] = {ones.data(), ones.data()};
+
+    VUMeterCalculator meter;
+    meter.prepare(sampleRate, 2);
+    REQUIRE(meter.getNumChannels() == 2);
+    meter.process(inputs, 2, 4800);
+    const float level = meter.getLevel(0);
+    REQUIRE(level > 0.0f);
+
+    const float *silent[2] = {nullptr, nullptr};
+    meter.process(silent, 2, 4800);
+    REQUIRE(meter.getLevel(0) < level);
+
+    meter.resetChannel(0);
+    REQUIRE(meter.getLevel(0) == 0.0f);
+    REQUIRE(meter.getLevel(1) > 0.0f);
+    REQUIRE(meter.getLevel(2) == 0.0f);
+  }
+}
+
+TEST_CASE("PPM ballistics", "[processing][metering]") {
+  using mcam::PPMMeterCalculator;
+
+  constexpr double sampleRate = 48000.0;
+
+  // Unit sine of a frequency and length, starting at a zero crossing
+  const auto makeSine = [&](double frequency, double seconds) {
+    std::vector<float> sine((size_t)juce::roundToInt(seconds * sampleRate));
+    for (size_t i = 0; i < sine.size(); ++i)
+      sine[i] = (float)std::sin(juce::MathConstants<double>::twoPi *
+                                frequency * (double)i / sampleRate);
+    return sine;
+  };
+
+  const auto play = [&](PPMMeterCalculator &meter,
+                        const std::vector<float> &signal, int blockSize) {
+    for (int pos = 0; pos < (int)signal.size(); pos += blockSize) {
+      const float *inputs[1] = {signal.data() + pos};
+      meter.process(inputs, 1,
+                    juce::jmin(blockSize, (int)signal.size() - pos));
+    }
+  };
+
+  const auto toDecibels = [](float level) {
+    return juce::Decibels::gainToDecibels(level);
+  };
+
+  SECTION("A steady sine reads its peak") {
+    for (double frequency : {100.0, 1000.0, 10000.0}) {
+      auto sine = makeSine(frequency, 1.0);
+      juce::FloatVectorOperations::multiply(
+          sine.data(), juce::Decibels::decibelsToGain(-10.0f),
+          (int)sine.size());
+
+      PPMMeterCalculator meter;
+      meter.prepare(sampleRate, 1);
+      play(meter, sine, 512);
+      REQUIRE(toDecibels(meter.getLevel(0)) ==
+              Catch::Approx(-10.0f).margin(0.2f));
+    }
+  }
+
+  SECTION("A 10 ms tone burst reads 2 dB low and the reading returns") {
+    PPMMeterCalculator meter;
+    meter.prepare(sampleRate, 1);
+    play(meter, makeSine(5000.0, PPMMeterCalculator::INTEGRATION_SECONDS),
+         64);
+    const float burst = meter.getLevel(0);
+    REQUIRE(toDecibels(burst) == Catch::Approx(-2.0f).margin(0.2f));
+
+    // 20 dB down after 1.5 s, while the peak hold keeps the burst
+    play(meter, std::vector<float>((size_t)(1.5 * sampleRate), 0.0f), 480);
+    REQUIRE(toDecibels(meter.getLevel(0)) - toDecibels(burst) ==
+            Catch::Approx(-20.0f).margin(0.2f));
+    REQUIRE(meter.getPeakHold(0) == Catch::Approx(burst).margin(0.01f));
+
+    // Past PEAK_HOLD_SECONDS the hold follows the reading
+    play(meter, std::vector<float>((size_t)sampleRate, 0.0f), 480);
+    REQUIRE(meter.getPeakHold(0) == meter.getLevel(0));
+  }
+
+  SECTION("Readings do not depend on the block size") {
+    auto signal = makeSine(3000.0, 0.5);
+    for (size_t i = 0; i < signal.size(); ++i)
+      signal[i] *= i % 4000 < 400 ? 1.0f : 0.05f;
+
+    const auto run = [&](int blockSize) {
+      PPMMeterCalculator meter;
+      meter.prepare(sampleRate, 1);
+      play(meter, signal, blockSize);
+      return std::make_pair(meter.getLevel(0), meter.getPeakHold(0));
+    };
+
+    const auto reference = run(480);
+    for (int blockSize : {32, 2048}) {
+      const auto [level, hold] = run(blockSize);
+      REQUIRE(level == Catch::Approx(reference.first).epsilon(1.0e-4));
+      REQUIRE(hold == Catch::Approx(reference.second).epsilon(1.0e-4));
+    }
+  }
+
+  SECTION("Missing inputs decay and channels reset alone") {
+    const auto sine = makeSine(1000.0, 0.1);
+    const float *inputs[2] = {sine.data(), sine.data()};
+
+    PPMMeterCalculator meter;
+    meter.prepare(sampleRate, 2);
+    meter.process(inputs, 2, (int)sine.size());
+    const float level = meter.getLevel(0);
+
+    const float *silent[2] = {nullptr, nullptr};
+    meter.process(silent, 2, 480);
+    REQUIRE(meter.getLevel(0) < level);
+    REQUIRE(meter.getPeakHold(0) == Catch::Approx(level).margin(0.01f));
+
+    meter.resetChannel(0);
+    REQUIRE(meter.getLevel(0) == 0.0f);
+    REQUIRE(meter.getPeakHold(0) == 0.0f);
+    REQUIRE(meter.getLevel(1) > 0.0f);
+  }
+}
+
+TEST_CASE("Level history", "[processing][metering]") {
+  using mcam::LevelHistory;
+  using Entries = std::vector<LevelHistory::Entry>;
+
+  SECTION("Resolutions roll up from 100 ms to 1 min") {
+    REQUIRE(LevelHistory::getResolutionSeconds(0) == Catch::Approx(0.1));
+    REQUIRE(LevelHistory::getResolutionSeconds(1) == Catch::Approx(1.0));
+    REQUIRE(LevelHistory::getResolutionSeconds(2) == Catch::Approx(10.0));
+    REQUIRE(LevelHistory::getResolutionSeconds(3) == Catch::Approx(60.0));
+
+    // The coarsest resolution with at least one entry per pixel
+    REQUIRE(LevelHistory::findResolution(0.05) == 0);
+    REQUIRE(LevelHistory::findResolution(6.0) == 1);
+    REQUIRE(LevelHistory::findResolution(10.0) == 2);
+    REQUIRE(LevelHistory::findResolution(1000.0) == 3);
+  }
+
+  SECTION("Entries weight block levels by their samples") {
+    LevelHistory history;
+    history.prepare(1000.0); // 100 samples per entry
+
+    // The second block straddles the first entry boundary
+    history.push(1.0f, 30);
+    history.push(0.0f, 90);
+    history.push(2.0f, 80);
+
+    Entries entries(4);
+    REQUIRE(history.read(0, entries.data(), 4) == 2);
+    REQUIRE(entries[0].min == 0.0f);
+    REQUIRE(entries[0].max == 1.0f);
+    REQUIRE(entries[0].mean == Catch::Approx(0.3f));
+    REQUIRE(entries[1].min == 0.0f);
+    REQUIRE(entries[1].max == 2.0f);
+    REQUIRE(entries[1].mean == Catch::Approx(1.6f));
+
+    // One long block completes several entries
+    history.push(5.0f, 350);
+    REQUIRE(history.getNumEntries(0) == 5);
+    REQUIRE(history.read(0, entries.data(), 4) == 4);
+    REQUIRE(entries[0].mean == Catch::Approx(1.6f));
+    REQUIRE(entries[3].mean == 5.0f);
+  }
+
+  SECTION("Every resolution keeps a fixed number of entries") {
+    LevelHistory history;
+    history.prepare(48000.0);
+
+    // Two hours of a level switching between 0 and 1 every minute
+    for (int block = 0; block < 2 * 3600 * 100; ++block)
+      history.push((float)(block / 6000 % 2), 480);
+
+    REQUIRE(history.getNumEntries(0) == 72000);
+    REQUIRE(history.getNumEntries(1) == 7200);
+    REQUIRE(history.getNumEntries(2) == 720);
+    REQUIRE(history.getNumEntries(3) == 120);
+
+    Entries entries(5000);
+    REQUIRE(history.read(0, entries.data(), 5000) == LevelHistory::CAPACITY);
+    REQUIRE(history.read(1, entries.data(), 5000) == LevelHistory::CAPACITY);
+
+    REQUIRE(history.read(2, entries.data(), 5000) == 720);
+    REQUIRE(entries[0].max == 0.0f);
+    REQUIRE(entries[6].min == 1.0f);
+
+    REQUIRE(history.read(3, entries.data(), 5000) == 120);
+    REQUIRE(entries[0].mean == 0.0f);
+    REQUIRE(entries[1].mean == 1.0f);
+
+    history.reset();
+    REQUIRE(history.read(3, entries.data(), 5000) == 0);
+  }
+
+  SECTION("Readers never see a torn or reordered history") {
+    LevelHistory history;
+    history.prepare(1000.0);
+
+    // Each entry's level is one more than the last, so a consistent read
+    // is a run of consecutive values
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+      for (int entry = 0; entry < 2000000; ++entry)
+        history.push((float)(entry % 1000000), 100);
+      done = true;
+    });
+
+    Entries entries((size_t)LevelHistory::CAPACITY);
+    bool consistent = true;
+
+    while (!done) {
+      const int numRead =
+          history.read(0, entries.data(), LevelHistory::CAPACITY);
+
+      for (int i = 1; i < numRead; ++i)
+        if (entries[(size_t)i].mean != entries[(size_t)i - 1].mean + 1.0f &&
+            entries[(size_t)i].mean != 0.0f)
+          consistent = false;
+    }
+
+    writer.join();
+    REQUIRE(consistent);
+  }
+}
+
+TEST_CASE("Waveform pyramid", "[processing][scope]") {
+  using mcam::WaveformPyramid;
+  using Columns = std::vector<WaveformPyramid::Column>;
+
+  constexpr double sampleRate = 48000.0;
+
+  juce::Random random(7);
+  std::vector<float> noise(150000);
+  for (auto &sample : noise)
+    sample = random.nextFloat() * 2.0f - 1.0f;
+
+  SECTION("Columns hold the exact range of the samples under them") {
+    WaveformPyramid pyramid;
+    pyramid.prepare(sampleRate, 1.0, 500);
+    pyramid.push(noise.data(), 100000);
+
+    // Eight samples per column is level 3 exactly
+    Columns columns(500);
+    pyramid.render(4000 / sampleRate, false, 0.0f, columns.data(), 500);
+
+    for (int column = 0; column < 500; ++column) {
+      const auto *first = noise.data() + 96000 + column * 8;
+      const auto range = std::minmax_element(first, first + 8);
+      REQUIRE(columns[(size_t)column].min == *range.first);
+      REQUIRE(columns[(size_t)column].max == *range.second);
+    }
+
+    // Otherwise columns straddle buckets, but the window's range is kept
+    pyramid.render(6000 / sampleRate, false, 0.0f, columns.data(), 500);
+    const auto range =
+        std::minmax_element(noise.data() + 94000, noise.data() + 100000);
+    float low = 1.0f, high = -1.0f;
+    for (const auto &column : columns) {
+      low = juce::jmin(low, column.min);
+      high = juce::jmax(high, column.max);
+    }
+    REQUIRE(low == *range.first);
+    REQUIRE(high == *range.second);
+  }
+
+  SECTION("Rendering does not depend on how samples were pushed") {
+    WaveformPyramid whole, pieces;
+    whole.prepare(sampleRate, 2.0, 300);
+    pieces.prepare(sampleRate, 2.0, 300);
+    whole.push(noise.data(), (int)noise.size());
+
+    for (int pos = 0; pos < (int)noise.size(); pos += 7)
+      pieces.push(noise.data() + pos, juce::jmin(7, (int)noise.size() - pos));
+
+    REQUIRE(pieces.getNumSamplesPushed() == (juce::int64)noise.size());
+
+    Columns a(300), b(300);
+    for (double window : {0.01, 0.1, 1.0, 2.0}) {
+      whole.render(window, true, 0.0f, a.data(), 300);
+      pieces.render(window, true, 0.0f, b.data(), 300);
+
+      for (size_t column = 0; column < a.size(); ++column) {
+        REQUIRE(a[column].min == b[column].min);
+        REQUIRE(a[column].max == b[column].max);
+      }
+    }
+  }
+
+  SECTION("The trigger holds a periodic signal still") {
+    std::vector<float> sine(48000);
+    for (size_t i = 0; i < sine.size(); ++i)
+      sine[i] = 0.8f * (float)std::sin(juce::MathConstants<double>::twoPi *
+                                           (double)i / 48.0 +
+                                       0.3);
+
+    WaveformPyramid pyramid;
+    pyramid.prepare(sampleRate, 60.0, 1000);
+    Columns before(480), after(480);
+
+    pyramid.push(sine.data(), 10000);
+    REQUIRE(pyramid.render(0.01, true, 0.0f, before.data(), 480));
+    pyramid.push(sine.data() + 10000, 1013);
+    REQUIRE(pyramid.render(0.01, true, 0.0f, after.data(), 480));
+
+    // The trace starts at the rising zero crossing, at the same phase
+    REQUIRE(before[0].max >= 0.0f);
+    REQUIRE(before[1].max > before[0].max);
+    for (size_t column = 0; column < before.size(); ++column)
+      REQUIRE(after[column].max == Catch::Approx(before[column].max));
+
+    // Free running, the same push moves the trace
+    pyramid.render(0.01, false, 0.0f, before.data(), 480);
+    pyramid.push(sine.data(), 13);
+    pyramid.render(0.01, false, 0.0f, after.data(), 480);
+    float largestChange = 0.0f;
+    for (size_t column = 0; column < before.size(); ++column)
+      largestChange = juce::jmax(
+          largestChange, std::abs(after[column].max - before[column].max));
+    REQUIRE(largestChange > 0.1f);
+
+    // A signal that never crosses the level runs free
+    std::vector<float> dc(48000, 0.5f);
+    pyramid.push(dc.data(), (int)dc.size());
+    REQUIRE_FALSE(pyramid.render(0.2, true, 0.0f, before.data(), 480));
+  }
+
+  SECTION("The longest window keeps its history and no more") {
+    WaveformPyramid pyramid;
+    pyramid.prepare(sampleRate, 60.0, 1000);
+
+    std::vector<float> second((size_t)sampleRate, 0.0f);
+    second[5] = 1.0f;
+    pyramid.push(second.data(), (int)second.size());
+    second[5] = 0.0f;
+    for (int i = 0; i < 59; ++i)
+      pyramid.push(second.data(), (int)second.size());
+
+    const auto highest = [&](double window) {
+      Columns columns(1000);
+      pyramid.render(window, false, 0.0f, columns.data(), 1000);
+      float peak = 0.0f;
+      for (const auto &column : columns)
+        peak = juce::jmax(peak, column.max);
+      return peak;
+    };
+
+    REQUIRE(highest(60.0) == 1.0f);
+    REQUIRE(highest(10.0) == 0.0f);
+
+    pyramid.push(second.data(), (int)second.size());
+    REQUIRE(highest(60.0) == 0.0f);
+  }
+
+  SECTION("Columns before the history read zero") {
+    WaveformPyramid pyramid;
+    pyramid.prepare(sampleRate, 10.0, 100);
+    std::vector<float> level(1000, 0.5f);
+    pyramid.push(level.data(), (int)level.size());
+
+    Columns columns(100);
+    pyramid.render(1.0, false, 0.0f, columns.data(), 100);
+    REQUIRE(columns.front().max == 0.0f);
+    REQUIRE(columns.back().max == 0.5f);
+  }
+}
+
+TEST_CASE("Sample FIFO", "[processing][scope]") {
+  mcam::SampleFifo fifo(100);
+  REQUIRE(fifo.getCapacity() == 100);
+
+  std::vector<float> ramp(150);
+  std::iota(ramp.begin(), ramp.end(), 0.0f);
+
+  SECTION("Overflow is dropped and the rest read in order") {
+    REQUIRE(fifo.push(ramp.data(), 150) == 100);
+    REQUIRE(fifo.getNumReady() == 100);
+
+    std::vector<float> read;
+    fifo.drain([&read](const float *data, int numSamples) {
+      read.insert(read.end(), data, data + numSamples);
+    });
+    REQUIRE(read == std::vector<float>(ramp.begin(), ramp.begin() + 100));
+    REQUIRE(fifo.getNumReady() == 0);
+  }
+
+  SECTION("Reads wrap around the end of the storage") {
+    fifo.push(ramp.data(), 70);
+    fifo.drain([](const float *, int) {});
+    REQUIRE(fifo.push(ramp.data() + 70, 60) == 60);
+
+    std::vector<float> read;
+    int pieces = 0;
+    fifo.drain([&](const float *data, int numSamples) {
+      read.insert(read.end(), data, data + numSamples);
+      ++pieces;
+    });
+    REQUIRE(pieces == 2);
+    REQUIRE(read == std::vector<float>(ramp.begin() + 70, ramp.begin() + 130));
+  }
+}
+
+TEST_CASE("Offline analysis of files", "[processing][analysis]") {
+  constexpr double sampleRate = 48000.0;
+  juce::TemporaryFile first(".wav"), second(".wav");
+
+  // Two stereo files; the right channel is 6 dB below the left
+  for (auto *temp : {&first, &second}) {
+    juce::AudioBuffer<float> buffer(2, (int)sampleRate);
+    TestUtils::generateSineWave(buffer, 1000.0f, (float)sampleRate, 0.5f);
+    buffer.applyGain(1, 0, buffer.getNumSamples(), 0.5f);
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(
+        temp->getFile().createOutputStream().release(), sampleRate, 2, 24, {},
+        0));
+    REQUIRE(writer != nullptr);
+    writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+  }
+
+  // More threads than files splits each file into channel groups
+  mcam::OfflineAnalyzer analyzer(4);
+  const auto report =
+      analyzer.analyze({first.getFile(), second.getFile(),
+                        juce::File::getCurrentWorkingDirectory().getChildFile(
+                            "does_not_exist.wav")});
+
+  REQUIRE(report.numFiles == 2);
+  REQUIRE(report.errors.size() == 1);
+  REQUIRE(report.channels.size() == 4);
+  REQUIRE(report.audioSeconds == Catch::Approx(2.0));
+  REQUIRE(report.realtimeMultiple > 1.0);
+
+  REQUIRE(report.channels[0].file == first.getFile());
+  REQUIRE(report.channels[1].channel == 1);
+  REQUIRE(report.channels[2].file == second.getFile());
+
+  const auto left = report.channels[0].summary;
+  const auto right = report.channels[1].summary;
+  REQUIRE(left.peak == Catch::Approx(0.5).margin(1.0e-3));
+  REQUIRE(right.integratedLoudness ==
+          Catch::Approx(left.integratedLoudness - 6.02).margin(0.05));
+
+  // Groups fed from one decode match a single group
+  const auto serial = mcam::OfflineAnalyzer(1).analyze({first.getFile()});
+  REQUIRE(serial.channels.size() == 2);
+  REQUIRE(serial.channels[0].summary.peak == left.peak);
+  REQUIRE(serial.channels[1].summary.integratedLoudness ==
+          right.integratedLoudness);
+
+  SECTION("CSV has a header and one row per channel") {
+    const auto lines =
+        juce::StringArray::fromLines(report.toCsv().trimEnd());
+    REQUIRE(lines.size() == 5);
+    REQUIRE(lines[0].startsWith("file,channel,sample_rate"));
+  }
+
+  SECTION("JSON parses back") {
+    const auto parsed = juce::JSON::parse(report.toJson());
+    REQUIRE(parsed["files"] == juce::var(2));
+    REQUIRE(parsed["channels"].size() == 4);
+  }
+}
+
 // Additional test cases for VU and PPM meter integration, ballistics, and
 // scaling will be added as the processing components are implemented
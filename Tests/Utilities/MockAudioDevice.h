@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../../Source/JuceHeader.h"
+#include "TestUtils.h"
+
+// Mock audio device for testing
+class MockAudioDevice : public juce::AudioIODevice {
+public:
+  MockAudioDevice() : juce::AudioIODevice("Mock Audio Device", "Mock") {}
+  ~MockAudioDevice() override = default;
+
+  // AudioIODevice interface implementation
+  juce::StringArray getOutputChannelNames() override {
+    return {"Out 1", "Out 2"};
+  }
+  juce::StringArray getInputChannelNames() override {
+    return {"In 1", "In 2", "In 3", "In 4"};
+  }
+  juce::Array<double> getAvailableSampleRates() override {
+    return {44100.0, 48000.0};
+  }
+  juce::Array<int> getAvailableBufferSizes() override {
+    return {128, 256, 512, 1024};
+  }
+  int getDefaultBufferSize() override { return 512; }
+
+  juce::String open(const juce::BigInteger &inputs,
+                    const juce::BigInteger &outputs, double sampleRate,
+                    int bufferSize) override {
+    isOpen_ = true;
+    activeInputChannels = inputs;
+    activeOutputChannels = outputs;
+    currentSampleRate = sampleRate;
+    currentBufferSize = bufferSize;
+    return {};
+  }
+
+  void close() override { isOpen_ = false; }
+  bool isOpen() override { return isOpen_; }
+  bool isPlaying() override { return isPlaying_; }
+
+  void start(juce::AudioIODeviceCallback *callback) override {
+    if (!isOpen_)
+      return;
+
+    audioCallback = callback;
+    isPlaying_ = true;
+  }
+
+  void stop() override {
+    isPlaying_ = false;
+    audioCallback = nullptr;
+  }
+
+  juce::String getLastError() override { return {}; }
+  int getCurrentBufferSizeSamples() override { return currentBufferSize; }
+  double getCurrentSampleRate() override { return currentSampleRate; }
+  int getCurrentBitDepth() override { return 24; }
+  juce::BigInteger getActiveOutputChannels() const override {
+    return activeOutputChannels;
+  }
+  juce::BigInteger getActiveInputChannels() const override {
+    return activeInputChannels;
+  }
+  int getOutputLatencyInSamples() override { return 0; }
+  int getInputLatencyInSamples() override { return 0; }
+
+  // Simulate audio callback with test data
+  void simulateCallback(int numSamples, bool useSineWave = true) {
+    if (!isPlaying_ || audioCallback == nullptr)
+      return;
+
+    // Create test buffers
+    juce::AudioBuffer<float> inputBuffer(
+        activeInputChannels.countNumberOfSetBits(), numSamples);
+    juce::AudioBuffer<float> outputBuffer(
+        activeOutputChannels.countNumberOfSetBits(), numSamples);
+
+    // Fill input buffer with test data
+    if (useSineWave) {
+      TestUtils::generateSineWave(inputBuffer, 1000.0f, currentSampleRate);
+    } else {
+      TestUtils::generateSquareWave(inputBuffer, 1000.0f, currentSampleRate);
+    }
+
+    // Call the audio callback
+    juce::AudioIODeviceCallbackContext context;
+    audioCallback->audioDeviceIOCallbackWithContext(
+        inputBuffer.getArrayOfReadPointers(), inputBuffer.getNumChannels(),
+        outputBuffer.getArrayOfWritePointers(), outputBuffer.getNumChannels(),
+        numSamples, context);
+  }
+
+  // Simulate audio callback with caller-provided input data
+  void simulateCallback(const juce::AudioBuffer<float> &inputBuffer) {
+    if (!isPlaying_ || audioCallback == nullptr)
+      return;
+
+    juce::AudioIODeviceCallbackContext context;
+    audioCallback->audioDeviceIOCallbackWithContext(
+        inputBuffer.getArrayOfReadPointers(), inputBuffer.getNumChannels(),
+        nullptr, 0, inputBuffer.getNumSamples(), context);
+  }
+
+private:
+  bool isOpen_ = false;
+  bool isPlaying_ = false;
+  juce::BigInteger activeInputChannels;
+  juce::BigInteger activeOutputChannels;
+  double currentSampleRate = 44100.0;
+  int currentBufferSize = 512;
+  juce::AudioIODeviceCallback *audioCallback = nullptr;
+};
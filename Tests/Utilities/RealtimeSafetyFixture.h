@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../../Source/Core/RealtimeGuard.h"
+#include <catch2/catch_test_macros.hpp>
+
+// Fixture for tests that drive the audio callback: the test fails if
+// anything inside a realtime span allocated, took a lock (or waited on an
+// allowed one) or made a blocking call, and each such call is listed with
+// its stack trace
+class RealtimeSafetyFixture {
+public:
+  RealtimeSafetyFixture() { mcam::RealtimeGuard::getInstance().clear(); }
+
+  ~RealtimeSafetyFixture() {
+    // A test that already failed is not reported twice
+    if (std::uncaught_exceptions() == 0)
+      checkRealtimeSafe();
+  }
+
+  void checkRealtimeSafe() const {
+    const auto &guard = mcam::RealtimeGuard::getInstance();
+
+    for (const auto &violation : guard.getViolations())
+      UNSCOPED_INFO(mcam::RealtimeGuard::getKindName(violation.kind)
+                    << " in " << violation.function << "\n"
+                    << violation.stackTrace);
+
+    CHECK(guard.getNumViolations() == 0);
+  }
+};